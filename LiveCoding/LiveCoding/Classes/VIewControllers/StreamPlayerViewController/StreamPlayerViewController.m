@@ -24,6 +24,8 @@
     media_height = 240;
     GstPlayerVideoRenderer *renderer = gst_player_video_overlay_video_renderer_new ((__bridge gpointer)([self video_view]));
     player = gst_player_new_full (renderer, NULL);
+    /* Live coding streams are mostly static editor screens */
+    gst_player_set_skip_static_frames (player, TRUE);
     g_object_set (player, "uri", [[self uri] UTF8String], NULL);
     
     gst_debug_set_threshold_for_name("gst-player", GST_LEVEL_TRACE);
@@ -105,6 +107,15 @@
     }
 }
 
+- (void)didReceiveMemoryWarning
+{
+    [super didReceiveMemoryWarning];
+    if (player)
+    {
+        gst_player_trim_memory (player, GST_PLAYER_MEMORY_TRIM_CRITICAL);
+    }
+}
+
 - (void)viewDidDisappear:(BOOL)animated
 {
     if (player)
@@ -1,18 +1,24 @@
 #import "VideoViewController.h"
 #import <gst/player/gstplayer.h>
+#import <gst/video/video.h>
+#import <pango/pango.h>
 #import <UIKit/UIKit.h>
 
 @interface VideoViewController () {
     GstPlayer *player;
+    GstPlayerVideoRenderer *renderer; /* Owned by the player */
+    UIImageView *scrub_view;        /* Shows the preview frames while dragging */
     int media_width;                /* Width of the clip */
     int media_height;               /* height ofthe clip */
     Boolean dragging_slider;        /* Whether the time slider is being dragged or not */
-    Boolean is_local_media;         /* Whether this clip is stored locally or is being streamed */
     Boolean is_playing_desired;     /* Whether the user asked to go to PLAYING */
 }
 
 @end
 
+static GstVideoOverlayRectangle * rasterize_cue (GstPlayer * unused, const gchar * text, gboolean markup,
+    gint width, gint height, gpointer user_data);
+
 @implementation VideoViewController
 
 @synthesize uri;
@@ -63,7 +69,14 @@
     media_width = 320;
     media_height = 240;
 
-    player = gst_player_new_full (gst_player_video_overlay_video_renderer_new ((__bridge gpointer)(video_view)), NULL);
+    renderer = gst_player_video_overlay_video_renderer_new ((__bridge gpointer)(video_view));
+    player = gst_player_new_full (renderer, NULL);
+    /* Live coding streams are mostly static editor screens */
+    gst_player_set_skip_static_frames (player, TRUE);
+    /* Rather lower the quality than stutter on slow devices */
+    gst_player_set_degradation_enabled (player, TRUE);
+    /* Subtitles are drawn once per cue with UIKit, not for every frame */
+    gst_player_set_subtitle_rasterizer (player, rasterize_cue, NULL, NULL);
     g_object_set (player, "uri", [uri UTF8String], NULL);
     
     gst_debug_set_threshold_for_name("gst-player", GST_LEVEL_TRACE);
@@ -72,7 +85,13 @@
     g_signal_connect (player, "duration-changed", G_CALLBACK (duration_changed), (__bridge gpointer) self);
     g_signal_connect (player, "video-dimensions-changed", G_CALLBACK (video_dimensions_changed), (__bridge gpointer) self);
     
-    is_local_media = [uri hasPrefix:@"file://"];
+    /* Preview frames are shown on top of the video while the slider is dragged */
+    scrub_view = [[UIImageView alloc] initWithFrame:video_view.bounds];
+    scrub_view.autoresizingMask = UIViewAutoresizingFlexibleWidth | UIViewAutoresizingFlexibleHeight;
+    scrub_view.contentMode = UIViewContentModeScaleAspectFit;
+    scrub_view.hidden = YES;
+    [video_view addSubview:scrub_view];
+
     is_playing_desired = NO;
 }
 
@@ -81,6 +100,8 @@
     if (player)
     {
         gst_object_unref (player);
+        player = NULL;
+        renderer = NULL;
     }
     [UIApplication sharedApplication].idleTimerDisabled = NO;
 }
@@ -89,6 +110,8 @@
 {
     [super didReceiveMemoryWarning];
     // Dispose of any resources that can be recreated.
+    if (player)
+        gst_player_trim_memory (player, GST_PLAYER_MEMORY_TRIM_CRITICAL);
 }
 
 /* Called when the Play button is pressed */
@@ -111,25 +134,31 @@
  * we programmatically changed its position. dragging_slider tells us which one happened */
 - (IBAction)sliderValueChanged:(id)sender {
     if (!dragging_slider) return;
-    // If this is a local file, allow scrub seeking, this is, seek as soon as the slider is moved.
-    if (is_local_media)
-        gst_player_seek (player, time_slider.value * 1000000);
+    // Only a preview of the nearest keyframe is shown while dragging, local and remote files alike.
+    // The playing media is seeked once the slider is released.
+    gst_player_scrub (player, time_slider.value * 1000000);
     [self updateTimeWidget];
 }
 
 /* Called when the user starts to drag the time slider */
 - (IBAction)sliderTouchDown:(id)sender {
+    CGFloat scale = video_container_view.contentScaleFactor;
+    gint width = video_width_constraint.constant * scale;
+    gint height = video_height_constraint.constant * scale;
+
     gst_player_pause (player);
     dragging_slider = YES;
+    if (width > 0 && height > 0)
+        gst_player_scrub_begin (player, width, height, (GstPlayerScrubFunc) scrub_frame,
+            (__bridge gpointer) self, NULL);
 }
 
 /* Called when the user stops dragging the time slider */
 - (IBAction)sliderTouchUp:(id)sender {
     dragging_slider = NO;
-    // If this is a remote file, scrub seeking is probably not going to work smoothly enough.
-    // Therefore, perform only the seek when the slider is released.
-    if (!is_local_media)
-        gst_player_seek (player, ((long)time_slider.value) * 1000000);
+    gst_player_scrub_end (player, TRUE);
+    scrub_view.hidden = YES;
+    scrub_view.image = nil;
     if (is_playing_desired)
         gst_player_play (player);
 }
@@ -152,6 +181,13 @@
         video_height_constraint.constant = view_height;
     }
 
+    /* Frames larger than the view are scaled down before they are uploaded */
+    if (renderer) {
+        CGFloat scale = video_container_view.contentScaleFactor;
+        gst_player_video_overlay_video_renderer_set_target_size (GST_PLAYER_VIDEO_OVERLAY_VIDEO_RENDERER (renderer),
+            video_width_constraint.constant * scale, video_height_constraint.constant * scale);
+    }
+
     time_slider.frame = CGRectMake(time_slider.frame.origin.x, time_slider.frame.origin.y, toolbar.frame.size.width - time_slider.frame.origin.x - 8, time_slider.frame.size.height);
 }
 
@@ -173,6 +209,111 @@ static void video_dimensions_changed (GstPlayer * unused, gint width, gint heigh
     [video_view layoutIfNeeded];
 }
 
+/* Called from a streaming thread with an RGBA frame of the size passed to gst_player_scrub_begin() */
+static void scrub_frame (GstPlayer * unused, GstSample * sample, GstClockTime position, VideoViewController *self)
+{
+    GstBuffer *buffer = gst_sample_get_buffer (sample);
+    GstVideoInfo info;
+    GstMapInfo map;
+
+    if (!buffer || !gst_video_info_from_caps (&info, gst_sample_get_caps (sample)))
+        return;
+    if (!gst_buffer_map (buffer, &map, GST_MAP_READ))
+        return;
+
+    NSData *data = [NSData dataWithBytes:map.data length:map.size];
+    gst_buffer_unmap (buffer, &map);
+
+    CGDataProviderRef provider = CGDataProviderCreateWithCFData ((__bridge CFDataRef) data);
+    CGColorSpaceRef color_space = CGColorSpaceCreateDeviceRGB ();
+    CGImageRef cg_image = CGImageCreate (GST_VIDEO_INFO_WIDTH (&info), GST_VIDEO_INFO_HEIGHT (&info),
+        8, 32, GST_VIDEO_INFO_PLANE_STRIDE (&info, 0), color_space,
+        kCGBitmapByteOrderDefault | kCGImageAlphaNoneSkipLast, provider, NULL, false,
+        kCGRenderingIntentDefault);
+    UIImage *image = [UIImage imageWithCGImage:cg_image];
+    CGImageRelease (cg_image);
+    CGColorSpaceRelease (color_space);
+    CGDataProviderRelease (provider);
+
+    dispatch_async(dispatch_get_main_queue(), ^{
+        [self scrubFrame:image];
+    });
+}
+
+-(void) scrubFrame:(UIImage *)image
+{
+    /* A late frame after the slider was released */
+    if (!dragging_slider) return;
+
+    scrub_view.image = image;
+    scrub_view.hidden = NO;
+}
+
+/* Called from a streaming thread once per cue and frame size. Draws the cue in white with a shadow,
+ * centered over the bottom of the frame, into premultiplied BGRA */
+static GstVideoOverlayRectangle * rasterize_cue (GstPlayer * unused, const gchar * text, gboolean markup,
+    gint width, gint height, gpointer user_data)
+{
+    gchar *plain = NULL;
+
+    if (!markup || !pango_parse_markup (text, -1, 0, NULL, &plain, NULL, NULL))
+        plain = g_strdup (text);
+
+    NSShadow *shadow = [[NSShadow alloc] init];
+    shadow.shadowColor = [UIColor blackColor];
+    shadow.shadowOffset = CGSizeMake (0, height / 360.0 + 1);
+    shadow.shadowBlurRadius = height / 180.0 + 1;
+
+    NSMutableParagraphStyle *style = [[NSMutableParagraphStyle alloc] init];
+    style.alignment = NSTextAlignmentCenter;
+
+    NSAttributedString *string = [[NSAttributedString alloc]
+        initWithString:[NSString stringWithUTF8String:plain]
+        attributes:@{ NSFontAttributeName: [UIFont boldSystemFontOfSize:height / 18.0],
+                      NSForegroundColorAttributeName: [UIColor whiteColor],
+                      NSShadowAttributeName: shadow,
+                      NSParagraphStyleAttributeName: style }];
+    g_free (plain);
+
+    CGRect bounds = [string boundingRectWithSize:CGSizeMake (width * 0.9, height / 2)
+                                         options:NSStringDrawingUsesLineFragmentOrigin context:nil];
+    gint margin = (gint) (shadow.shadowBlurRadius * 2);
+    gint w = MIN ((gint) ceil (bounds.size.width) + 2 * margin, width);
+    gint h = MIN ((gint) ceil (bounds.size.height) + 2 * margin, height);
+    if (w <= 2 * margin || h <= 2 * margin)
+        return NULL;
+
+    GstBuffer *buffer = gst_buffer_new_allocate (NULL, w * h * 4, NULL);
+    GstMapInfo map;
+    if (!gst_buffer_map (buffer, &map, GST_MAP_WRITE)) {
+        gst_buffer_unref (buffer);
+        return NULL;
+    }
+    memset (map.data, 0, map.size);
+
+    CGColorSpaceRef color_space = CGColorSpaceCreateDeviceRGB ();
+    CGContextRef context = CGBitmapContextCreate (map.data, w, h, 8, w * 4, color_space,
+        kCGBitmapByteOrder32Little | kCGImageAlphaPremultipliedFirst);
+    CGColorSpaceRelease (color_space);
+    /* UIKit draws top down */
+    CGContextTranslateCTM (context, 0, h);
+    CGContextScaleCTM (context, 1, -1);
+    UIGraphicsPushContext (context);
+    [string drawWithRect:CGRectMake (margin, margin, w - 2 * margin, h - 2 * margin)
+                 options:NSStringDrawingUsesLineFragmentOrigin context:nil];
+    UIGraphicsPopContext ();
+    CGContextRelease (context);
+    gst_buffer_unmap (buffer, &map);
+
+    gst_buffer_add_video_meta (buffer, GST_VIDEO_FRAME_FLAG_NONE, GST_VIDEO_FORMAT_BGRA, w, h);
+    GstVideoOverlayRectangle *rectangle = gst_video_overlay_rectangle_new_raw (buffer,
+        (width - w) / 2, height - h - height / 20, w, h,
+        GST_VIDEO_OVERLAY_FORMAT_FLAG_PREMULTIPLIED_ALPHA);
+    gst_buffer_unref (buffer);
+
+    return rectangle;
+}
+
 static void position_updated (GstPlayer * unused, GstClockTime position, VideoViewController *self)
 {
     dispatch_async(dispatch_get_main_queue(), ^{
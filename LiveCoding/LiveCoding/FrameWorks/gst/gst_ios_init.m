@@ -1,4 +1,5 @@
 #include "gst_ios_init.h"
+#include <gst/player/gstplayer-plugin-loader.h>
 
 #if defined(GST_IOS_PLUGIN_COREELEMENTS) || defined(GST_IOS_PLUGINS_CORE)
 GST_PLUGIN_STATIC_DECLARE(coreelements);
@@ -219,6 +220,9 @@ GST_PLUGIN_STATIC_DECLARE(videocrop);
 #if defined(GST_IOS_PLUGIN_VIDEOMIXER) || defined(GST_IOS_PLUGINS_EFFECTS)
 GST_PLUGIN_STATIC_DECLARE(videomixer);
 #endif
+#if defined(GST_IOS_PLUGIN_COMPOSITOR) || defined(GST_IOS_PLUGINS_EFFECTS)
+GST_PLUGIN_STATIC_DECLARE(compositor);
+#endif
 #if defined(GST_IOS_PLUGIN_ACCURIP) || defined(GST_IOS_PLUGINS_EFFECTS)
 GST_PLUGIN_STATIC_DECLARE(accurip);
 #endif
@@ -474,8 +478,8 @@ GST_PLUGIN_STATIC_DECLARE(gnonlin);
 void
 gst_ios_init (void)
 {
-  GstPluginFeature *plugin;
-  GstRegistry *reg;
+  gchar *plugin_index;
+  GError *err = NULL;
   NSString *resources = [[NSBundle mainBundle] resourcePath];
   NSString *tmp = NSTemporaryDirectory();
   NSString *cache = [NSHomeDirectory() stringByAppendingPathComponent:@"Library/Caches"];
@@ -506,470 +510,477 @@ gst_ios_init (void)
     
   gst_init (NULL, NULL);
 
+  /* Plugins are only made known to the loader here. If an index from a
+   * previous run is available they are registered on demand, otherwise
+   * everything is registered now and the index is written for the next
+   * start. */
   #if defined(GST_IOS_PLUGIN_COREELEMENTS) || defined(GST_IOS_PLUGINS_CORE)
-    GST_PLUGIN_STATIC_REGISTER(coreelements);
+    GST_PLAYER_PLUGIN_LOADER_ADD(coreelements);
 #endif
 #if defined(GST_IOS_PLUGIN_ADDER) || defined(GST_IOS_PLUGINS_CORE)
-    GST_PLUGIN_STATIC_REGISTER(adder);
+    GST_PLAYER_PLUGIN_LOADER_ADD(adder);
 #endif
 #if defined(GST_IOS_PLUGIN_APP) || defined(GST_IOS_PLUGINS_CORE)
-    GST_PLUGIN_STATIC_REGISTER(app);
+    GST_PLAYER_PLUGIN_LOADER_ADD(app);
 #endif
 #if defined(GST_IOS_PLUGIN_AUDIOCONVERT) || defined(GST_IOS_PLUGINS_CORE)
-    GST_PLUGIN_STATIC_REGISTER(audioconvert);
+    GST_PLAYER_PLUGIN_LOADER_ADD(audioconvert);
 #endif
 #if defined(GST_IOS_PLUGIN_AUDIORATE) || defined(GST_IOS_PLUGINS_CORE)
-    GST_PLUGIN_STATIC_REGISTER(audiorate);
+    GST_PLAYER_PLUGIN_LOADER_ADD(audiorate);
 #endif
 #if defined(GST_IOS_PLUGIN_AUDIORESAMPLE) || defined(GST_IOS_PLUGINS_CORE)
-    GST_PLUGIN_STATIC_REGISTER(audioresample);
+    GST_PLAYER_PLUGIN_LOADER_ADD(audioresample);
 #endif
 #if defined(GST_IOS_PLUGIN_AUDIOTESTSRC) || defined(GST_IOS_PLUGINS_CORE)
-    GST_PLUGIN_STATIC_REGISTER(audiotestsrc);
+    GST_PLAYER_PLUGIN_LOADER_ADD(audiotestsrc);
 #endif
 #if defined(GST_IOS_PLUGIN_GIO) || defined(GST_IOS_PLUGINS_CORE)
-    GST_PLUGIN_STATIC_REGISTER(gio);
+    GST_PLAYER_PLUGIN_LOADER_ADD(gio);
 #endif
 #if defined(GST_IOS_PLUGIN_PANGO) || defined(GST_IOS_PLUGINS_CORE)
-    GST_PLUGIN_STATIC_REGISTER(pango);
+    GST_PLAYER_PLUGIN_LOADER_ADD(pango);
 #endif
 #if defined(GST_IOS_PLUGIN_TYPEFINDFUNCTIONS) || defined(GST_IOS_PLUGINS_CORE)
-    GST_PLUGIN_STATIC_REGISTER(typefindfunctions);
+    GST_PLAYER_PLUGIN_LOADER_ADD(typefindfunctions);
 #endif
 #if defined(GST_IOS_PLUGIN_VIDEOCONVERT) || defined(GST_IOS_PLUGINS_CORE)
-    GST_PLUGIN_STATIC_REGISTER(videoconvert);
+    GST_PLAYER_PLUGIN_LOADER_ADD(videoconvert);
 #endif
 #if defined(GST_IOS_PLUGIN_VIDEORATE) || defined(GST_IOS_PLUGINS_CORE)
-    GST_PLUGIN_STATIC_REGISTER(videorate);
+    GST_PLAYER_PLUGIN_LOADER_ADD(videorate);
 #endif
 #if defined(GST_IOS_PLUGIN_VIDEOSCALE) || defined(GST_IOS_PLUGINS_CORE)
-    GST_PLUGIN_STATIC_REGISTER(videoscale);
+    GST_PLAYER_PLUGIN_LOADER_ADD(videoscale);
 #endif
 #if defined(GST_IOS_PLUGIN_VIDEOTESTSRC) || defined(GST_IOS_PLUGINS_CORE)
-    GST_PLUGIN_STATIC_REGISTER(videotestsrc);
+    GST_PLAYER_PLUGIN_LOADER_ADD(videotestsrc);
 #endif
 #if defined(GST_IOS_PLUGIN_VOLUME) || defined(GST_IOS_PLUGINS_CORE)
-    GST_PLUGIN_STATIC_REGISTER(volume);
+    GST_PLAYER_PLUGIN_LOADER_ADD(volume);
 #endif
 #if defined(GST_IOS_PLUGIN_AUTODETECT) || defined(GST_IOS_PLUGINS_CORE)
-    GST_PLUGIN_STATIC_REGISTER(autodetect);
+    GST_PLAYER_PLUGIN_LOADER_ADD(autodetect);
 #endif
 #if defined(GST_IOS_PLUGIN_VIDEOFILTER) || defined(GST_IOS_PLUGINS_CORE)
-    GST_PLUGIN_STATIC_REGISTER(videofilter);
+    GST_PLAYER_PLUGIN_LOADER_ADD(videofilter);
 #endif
 #if defined(GST_IOS_PLUGIN_CAMERABIN) || defined(GST_IOS_PLUGINS_CAPTURE)
-    GST_PLUGIN_STATIC_REGISTER(camerabin);
+    GST_PLAYER_PLUGIN_LOADER_ADD(camerabin);
 #endif
 #if defined(GST_IOS_PLUGIN_ASFMUX) || defined(GST_IOS_PLUGINS_CODECS_RESTRICTED)
-    GST_PLUGIN_STATIC_REGISTER(asfmux);
+    GST_PLAYER_PLUGIN_LOADER_ADD(asfmux);
 #endif
 #if defined(GST_IOS_PLUGIN_DTSDEC) || defined(GST_IOS_PLUGINS_CODECS_RESTRICTED)
-    GST_PLUGIN_STATIC_REGISTER(dtsdec);
+    GST_PLAYER_PLUGIN_LOADER_ADD(dtsdec);
 #endif
 #if defined(GST_IOS_PLUGIN_FAAD) || defined(GST_IOS_PLUGINS_CODECS_RESTRICTED)
-    GST_PLUGIN_STATIC_REGISTER(faad);
+    GST_PLAYER_PLUGIN_LOADER_ADD(faad);
 #endif
 #if defined(GST_IOS_PLUGIN_MPEGPSDEMUX) || defined(GST_IOS_PLUGINS_CODECS_RESTRICTED)
-    GST_PLUGIN_STATIC_REGISTER(mpegpsdemux);
+    GST_PLAYER_PLUGIN_LOADER_ADD(mpegpsdemux);
 #endif
 #if defined(GST_IOS_PLUGIN_MPEGPSMUX) || defined(GST_IOS_PLUGINS_CODECS_RESTRICTED)
-    GST_PLUGIN_STATIC_REGISTER(mpegpsmux);
+    GST_PLAYER_PLUGIN_LOADER_ADD(mpegpsmux);
 #endif
 #if defined(GST_IOS_PLUGIN_MPEGTSDEMUX) || defined(GST_IOS_PLUGINS_CODECS_RESTRICTED)
-    GST_PLUGIN_STATIC_REGISTER(mpegtsdemux);
+    GST_PLAYER_PLUGIN_LOADER_ADD(mpegtsdemux);
 #endif
 #if defined(GST_IOS_PLUGIN_MPEGTSMUX) || defined(GST_IOS_PLUGINS_CODECS_RESTRICTED)
-    GST_PLUGIN_STATIC_REGISTER(mpegtsmux);
+    GST_PLAYER_PLUGIN_LOADER_ADD(mpegtsmux);
 #endif
 #if defined(GST_IOS_PLUGIN_VOAACENC) || defined(GST_IOS_PLUGINS_CODECS_RESTRICTED)
-    GST_PLUGIN_STATIC_REGISTER(voaacenc);
+    GST_PLAYER_PLUGIN_LOADER_ADD(voaacenc);
 #endif
 #if defined(GST_IOS_PLUGIN_A52DEC) || defined(GST_IOS_PLUGINS_CODECS_RESTRICTED)
-    GST_PLUGIN_STATIC_REGISTER(a52dec);
+    GST_PLAYER_PLUGIN_LOADER_ADD(a52dec);
 #endif
 #if defined(GST_IOS_PLUGIN_AMRNB) || defined(GST_IOS_PLUGINS_CODECS_RESTRICTED)
-    GST_PLUGIN_STATIC_REGISTER(amrnb);
+    GST_PLAYER_PLUGIN_LOADER_ADD(amrnb);
 #endif
 #if defined(GST_IOS_PLUGIN_AMRWBDEC) || defined(GST_IOS_PLUGINS_CODECS_RESTRICTED)
-    GST_PLUGIN_STATIC_REGISTER(amrwbdec);
+    GST_PLAYER_PLUGIN_LOADER_ADD(amrwbdec);
 #endif
 #if defined(GST_IOS_PLUGIN_ASF) || defined(GST_IOS_PLUGINS_CODECS_RESTRICTED)
-    GST_PLUGIN_STATIC_REGISTER(asf);
+    GST_PLAYER_PLUGIN_LOADER_ADD(asf);
 #endif
 #if defined(GST_IOS_PLUGIN_DVDSUB) || defined(GST_IOS_PLUGINS_CODECS_RESTRICTED)
-    GST_PLUGIN_STATIC_REGISTER(dvdsub);
+    GST_PLAYER_PLUGIN_LOADER_ADD(dvdsub);
 #endif
 #if defined(GST_IOS_PLUGIN_DVDLPCMDEC) || defined(GST_IOS_PLUGINS_CODECS_RESTRICTED)
-    GST_PLUGIN_STATIC_REGISTER(dvdlpcmdec);
+    GST_PLAYER_PLUGIN_LOADER_ADD(dvdlpcmdec);
 #endif
 #if defined(GST_IOS_PLUGIN_MAD) || defined(GST_IOS_PLUGINS_CODECS_RESTRICTED)
-    GST_PLUGIN_STATIC_REGISTER(mad);
+    GST_PLAYER_PLUGIN_LOADER_ADD(mad);
 #endif
 #if defined(GST_IOS_PLUGIN_MPEG2DEC) || defined(GST_IOS_PLUGINS_CODECS_RESTRICTED)
-    GST_PLUGIN_STATIC_REGISTER(mpeg2dec);
+    GST_PLAYER_PLUGIN_LOADER_ADD(mpeg2dec);
 #endif
 #if defined(GST_IOS_PLUGIN_XINGMUX) || defined(GST_IOS_PLUGINS_CODECS_RESTRICTED)
-    GST_PLUGIN_STATIC_REGISTER(xingmux);
+    GST_PLAYER_PLUGIN_LOADER_ADD(xingmux);
 #endif
 #if defined(GST_IOS_PLUGIN_REALMEDIA) || defined(GST_IOS_PLUGINS_CODECS_RESTRICTED)
-    GST_PLUGIN_STATIC_REGISTER(realmedia);
+    GST_PLAYER_PLUGIN_LOADER_ADD(realmedia);
 #endif
 #if defined(GST_IOS_PLUGIN_X264) || defined(GST_IOS_PLUGINS_CODECS_RESTRICTED)
-    GST_PLUGIN_STATIC_REGISTER(x264);
+    GST_PLAYER_PLUGIN_LOADER_ADD(x264);
 #endif
 #if defined(GST_IOS_PLUGIN_LIBAV) || defined(GST_IOS_PLUGINS_CODECS_RESTRICTED)
-    GST_PLUGIN_STATIC_REGISTER(libav);
+    GST_PLAYER_PLUGIN_LOADER_ADD(libav);
 #endif
 #if defined(GST_IOS_PLUGIN_ENCODING) || defined(GST_IOS_PLUGINS_ENCODING)
-    GST_PLUGIN_STATIC_REGISTER(encoding);
+    GST_PLAYER_PLUGIN_LOADER_ADD(encoding);
 #endif
 #if defined(GST_IOS_PLUGIN_ASSRENDER) || defined(GST_IOS_PLUGINS_CODECS_GPL)
-    GST_PLUGIN_STATIC_REGISTER(assrender);
+    GST_PLAYER_PLUGIN_LOADER_ADD(assrender);
 #endif
 #if defined(GST_IOS_PLUGIN_MMS) || defined(GST_IOS_PLUGINS_NET_RESTRICTED)
-    GST_PLUGIN_STATIC_REGISTER(mms);
+    GST_PLAYER_PLUGIN_LOADER_ADD(mms);
 #endif
 #if defined(GST_IOS_PLUGIN_RTMP) || defined(GST_IOS_PLUGINS_NET_RESTRICTED)
-    GST_PLUGIN_STATIC_REGISTER(rtmp);
+    GST_PLAYER_PLUGIN_LOADER_ADD(rtmp);
 #endif
 #if defined(GST_IOS_PLUGIN_OSXAUDIO) || defined(GST_IOS_PLUGINS_SYS)
-    GST_PLUGIN_STATIC_REGISTER(osxaudio);
+    GST_PLAYER_PLUGIN_LOADER_ADD(osxaudio);
 #endif
 #if defined(GST_IOS_PLUGIN_APPLEMEDIA) || defined(GST_IOS_PLUGINS_SYS)
-    GST_PLUGIN_STATIC_REGISTER(applemedia);
+    GST_PLAYER_PLUGIN_LOADER_ADD(applemedia);
 #endif
 #if defined(GST_IOS_PLUGIN_SHM) || defined(GST_IOS_PLUGINS_SYS)
-    GST_PLUGIN_STATIC_REGISTER(shm);
+    GST_PLAYER_PLUGIN_LOADER_ADD(shm);
 #endif
 #if defined(GST_IOS_PLUGIN_OPENGL) || defined(GST_IOS_PLUGINS_SYS)
-    GST_PLUGIN_STATIC_REGISTER(opengl);
+    GST_PLAYER_PLUGIN_LOADER_ADD(opengl);
 #endif
 #if defined(GST_IOS_PLUGIN_LIBVISUAL) || defined(GST_IOS_PLUGINS_VIS)
-    GST_PLUGIN_STATIC_REGISTER(libvisual);
+    GST_PLAYER_PLUGIN_LOADER_ADD(libvisual);
 #endif
 #if defined(GST_IOS_PLUGIN_GOOM) || defined(GST_IOS_PLUGINS_VIS)
-    GST_PLUGIN_STATIC_REGISTER(goom);
+    GST_PLAYER_PLUGIN_LOADER_ADD(goom);
 #endif
 #if defined(GST_IOS_PLUGIN_GOOM2K1) || defined(GST_IOS_PLUGINS_VIS)
-    GST_PLUGIN_STATIC_REGISTER(goom2k1);
+    GST_PLAYER_PLUGIN_LOADER_ADD(goom2k1);
 #endif
 #if defined(GST_IOS_PLUGIN_AUDIOVISUALIZERS) || defined(GST_IOS_PLUGINS_VIS)
-    GST_PLUGIN_STATIC_REGISTER(audiovisualizers);
+    GST_PLAYER_PLUGIN_LOADER_ADD(audiovisualizers);
 #endif
 #if defined(GST_IOS_PLUGIN_PLAYBACK) || defined(GST_IOS_PLUGINS_PLAYBACK)
-    GST_PLUGIN_STATIC_REGISTER(playback);
+    GST_PLAYER_PLUGIN_LOADER_ADD(playback);
 #endif
 #if defined(GST_IOS_PLUGIN_ALPHA) || defined(GST_IOS_PLUGINS_EFFECTS)
-    GST_PLUGIN_STATIC_REGISTER(alpha);
+    GST_PLAYER_PLUGIN_LOADER_ADD(alpha);
 #endif
 #if defined(GST_IOS_PLUGIN_ALPHACOLOR) || defined(GST_IOS_PLUGINS_EFFECTS)
-    GST_PLUGIN_STATIC_REGISTER(alphacolor);
+    GST_PLAYER_PLUGIN_LOADER_ADD(alphacolor);
 #endif
 #if defined(GST_IOS_PLUGIN_AUDIOFX) || defined(GST_IOS_PLUGINS_EFFECTS)
-    GST_PLUGIN_STATIC_REGISTER(audiofx);
+    GST_PLAYER_PLUGIN_LOADER_ADD(audiofx);
 #endif
 #if defined(GST_IOS_PLUGIN_CAIRO) || defined(GST_IOS_PLUGINS_EFFECTS)
-    GST_PLUGIN_STATIC_REGISTER(cairo);
+    GST_PLAYER_PLUGIN_LOADER_ADD(cairo);
 #endif
 #if defined(GST_IOS_PLUGIN_CUTTER) || defined(GST_IOS_PLUGINS_EFFECTS)
-    GST_PLUGIN_STATIC_REGISTER(cutter);
+    GST_PLAYER_PLUGIN_LOADER_ADD(cutter);
 #endif
 #if defined(GST_IOS_PLUGIN_DEBUG) || defined(GST_IOS_PLUGINS_EFFECTS)
-    GST_PLUGIN_STATIC_REGISTER(debug);
+    GST_PLAYER_PLUGIN_LOADER_ADD(debug);
 #endif
 #if defined(GST_IOS_PLUGIN_DEINTERLACE) || defined(GST_IOS_PLUGINS_EFFECTS)
-    GST_PLUGIN_STATIC_REGISTER(deinterlace);
+    GST_PLAYER_PLUGIN_LOADER_ADD(deinterlace);
 #endif
 #if defined(GST_IOS_PLUGIN_DTMF) || defined(GST_IOS_PLUGINS_EFFECTS)
-    GST_PLUGIN_STATIC_REGISTER(dtmf);
+    GST_PLAYER_PLUGIN_LOADER_ADD(dtmf);
 #endif
 #if defined(GST_IOS_PLUGIN_EFFECTV) || defined(GST_IOS_PLUGINS_EFFECTS)
-    GST_PLUGIN_STATIC_REGISTER(effectv);
+    GST_PLAYER_PLUGIN_LOADER_ADD(effectv);
 #endif
 #if defined(GST_IOS_PLUGIN_EQUALIZER) || defined(GST_IOS_PLUGINS_EFFECTS)
-    GST_PLUGIN_STATIC_REGISTER(equalizer);
+    GST_PLAYER_PLUGIN_LOADER_ADD(equalizer);
 #endif
 #if defined(GST_IOS_PLUGIN_GDKPIXBUF) || defined(GST_IOS_PLUGINS_EFFECTS)
-    GST_PLUGIN_STATIC_REGISTER(gdkpixbuf);
+    GST_PLAYER_PLUGIN_LOADER_ADD(gdkpixbuf);
 #endif
 #if defined(GST_IOS_PLUGIN_IMAGEFREEZE) || defined(GST_IOS_PLUGINS_EFFECTS)
-    GST_PLUGIN_STATIC_REGISTER(imagefreeze);
+    GST_PLAYER_PLUGIN_LOADER_ADD(imagefreeze);
 #endif
 #if defined(GST_IOS_PLUGIN_INTERLEAVE) || defined(GST_IOS_PLUGINS_EFFECTS)
-    GST_PLUGIN_STATIC_REGISTER(interleave);
+    GST_PLAYER_PLUGIN_LOADER_ADD(interleave);
 #endif
 #if defined(GST_IOS_PLUGIN_LEVEL) || defined(GST_IOS_PLUGINS_EFFECTS)
-    GST_PLUGIN_STATIC_REGISTER(level);
+    GST_PLAYER_PLUGIN_LOADER_ADD(level);
 #endif
 #if defined(GST_IOS_PLUGIN_MULTIFILE) || defined(GST_IOS_PLUGINS_EFFECTS)
-    GST_PLUGIN_STATIC_REGISTER(multifile);
+    GST_PLAYER_PLUGIN_LOADER_ADD(multifile);
 #endif
 #if defined(GST_IOS_PLUGIN_REPLAYGAIN) || defined(GST_IOS_PLUGINS_EFFECTS)
-    GST_PLUGIN_STATIC_REGISTER(replaygain);
+    GST_PLAYER_PLUGIN_LOADER_ADD(replaygain);
 #endif
 #if defined(GST_IOS_PLUGIN_SHAPEWIPE) || defined(GST_IOS_PLUGINS_EFFECTS)
-    GST_PLUGIN_STATIC_REGISTER(shapewipe);
+    GST_PLAYER_PLUGIN_LOADER_ADD(shapewipe);
 #endif
 #if defined(GST_IOS_PLUGIN_SMPTE) || defined(GST_IOS_PLUGINS_EFFECTS)
-    GST_PLUGIN_STATIC_REGISTER(smpte);
+    GST_PLAYER_PLUGIN_LOADER_ADD(smpte);
 #endif
 #if defined(GST_IOS_PLUGIN_SPECTRUM) || defined(GST_IOS_PLUGINS_EFFECTS)
-    GST_PLUGIN_STATIC_REGISTER(spectrum);
+    GST_PLAYER_PLUGIN_LOADER_ADD(spectrum);
 #endif
 #if defined(GST_IOS_PLUGIN_VIDEOBOX) || defined(GST_IOS_PLUGINS_EFFECTS)
-    GST_PLUGIN_STATIC_REGISTER(videobox);
+    GST_PLAYER_PLUGIN_LOADER_ADD(videobox);
 #endif
 #if defined(GST_IOS_PLUGIN_VIDEOCROP) || defined(GST_IOS_PLUGINS_EFFECTS)
-    GST_PLUGIN_STATIC_REGISTER(videocrop);
+    GST_PLAYER_PLUGIN_LOADER_ADD(videocrop);
 #endif
 #if defined(GST_IOS_PLUGIN_VIDEOMIXER) || defined(GST_IOS_PLUGINS_EFFECTS)
-    GST_PLUGIN_STATIC_REGISTER(videomixer);
+    GST_PLAYER_PLUGIN_LOADER_ADD(videomixer);
+#endif
+#if defined(GST_IOS_PLUGIN_COMPOSITOR) || defined(GST_IOS_PLUGINS_EFFECTS)
+    GST_PLAYER_PLUGIN_LOADER_ADD(compositor);
 #endif
 #if defined(GST_IOS_PLUGIN_ACCURIP) || defined(GST_IOS_PLUGINS_EFFECTS)
-    GST_PLUGIN_STATIC_REGISTER(accurip);
+    GST_PLAYER_PLUGIN_LOADER_ADD(accurip);
 #endif
 #if defined(GST_IOS_PLUGIN_AIFF) || defined(GST_IOS_PLUGINS_EFFECTS)
-    GST_PLUGIN_STATIC_REGISTER(aiff);
+    GST_PLAYER_PLUGIN_LOADER_ADD(aiff);
 #endif
 #if defined(GST_IOS_PLUGIN_AUDIOFXBAD) || defined(GST_IOS_PLUGINS_EFFECTS)
-    GST_PLUGIN_STATIC_REGISTER(audiofxbad);
+    GST_PLAYER_PLUGIN_LOADER_ADD(audiofxbad);
 #endif
 #if defined(GST_IOS_PLUGIN_AUTOCONVERT) || defined(GST_IOS_PLUGINS_EFFECTS)
-    GST_PLUGIN_STATIC_REGISTER(autoconvert);
+    GST_PLAYER_PLUGIN_LOADER_ADD(autoconvert);
 #endif
 #if defined(GST_IOS_PLUGIN_BAYER) || defined(GST_IOS_PLUGINS_EFFECTS)
-    GST_PLUGIN_STATIC_REGISTER(bayer);
+    GST_PLAYER_PLUGIN_LOADER_ADD(bayer);
 #endif
 #if defined(GST_IOS_PLUGIN_COLOREFFECTS) || defined(GST_IOS_PLUGINS_EFFECTS)
-    GST_PLUGIN_STATIC_REGISTER(coloreffects);
+    GST_PLAYER_PLUGIN_LOADER_ADD(coloreffects);
 #endif
 #if defined(GST_IOS_PLUGIN_DEBUGUTILSBAD) || defined(GST_IOS_PLUGINS_EFFECTS)
-    GST_PLUGIN_STATIC_REGISTER(debugutilsbad);
+    GST_PLAYER_PLUGIN_LOADER_ADD(debugutilsbad);
 #endif
 #if defined(GST_IOS_PLUGIN_FIELDANALYSIS) || defined(GST_IOS_PLUGINS_EFFECTS)
-    GST_PLUGIN_STATIC_REGISTER(fieldanalysis);
+    GST_PLAYER_PLUGIN_LOADER_ADD(fieldanalysis);
 #endif
 #if defined(GST_IOS_PLUGIN_FREEVERB) || defined(GST_IOS_PLUGINS_EFFECTS)
-    GST_PLUGIN_STATIC_REGISTER(freeverb);
+    GST_PLAYER_PLUGIN_LOADER_ADD(freeverb);
 #endif
 #if defined(GST_IOS_PLUGIN_FREI0R) || defined(GST_IOS_PLUGINS_EFFECTS)
-    GST_PLUGIN_STATIC_REGISTER(frei0r);
+    GST_PLAYER_PLUGIN_LOADER_ADD(frei0r);
 #endif
 #if defined(GST_IOS_PLUGIN_GAUDIEFFECTS) || defined(GST_IOS_PLUGINS_EFFECTS)
-    GST_PLUGIN_STATIC_REGISTER(gaudieffects);
+    GST_PLAYER_PLUGIN_LOADER_ADD(gaudieffects);
 #endif
 #if defined(GST_IOS_PLUGIN_GEOMETRICTRANSFORM) || defined(GST_IOS_PLUGINS_EFFECTS)
-    GST_PLUGIN_STATIC_REGISTER(geometrictransform);
+    GST_PLAYER_PLUGIN_LOADER_ADD(geometrictransform);
 #endif
 #if defined(GST_IOS_PLUGIN_INTERLACE) || defined(GST_IOS_PLUGINS_EFFECTS)
-    GST_PLUGIN_STATIC_REGISTER(interlace);
+    GST_PLAYER_PLUGIN_LOADER_ADD(interlace);
 #endif
 #if defined(GST_IOS_PLUGIN_IVTC) || defined(GST_IOS_PLUGINS_EFFECTS)
-    GST_PLUGIN_STATIC_REGISTER(ivtc);
+    GST_PLAYER_PLUGIN_LOADER_ADD(ivtc);
 #endif
 #if defined(GST_IOS_PLUGIN_LIVEADDER) || defined(GST_IOS_PLUGINS_EFFECTS)
-    GST_PLUGIN_STATIC_REGISTER(liveadder);
+    GST_PLAYER_PLUGIN_LOADER_ADD(liveadder);
 #endif
 #if defined(GST_IOS_PLUGIN_RAWPARSE) || defined(GST_IOS_PLUGINS_EFFECTS)
-    GST_PLUGIN_STATIC_REGISTER(rawparse);
+    GST_PLAYER_PLUGIN_LOADER_ADD(rawparse);
 #endif
 #if defined(GST_IOS_PLUGIN_REMOVESILENCE) || defined(GST_IOS_PLUGINS_EFFECTS)
-    GST_PLUGIN_STATIC_REGISTER(removesilence);
+    GST_PLAYER_PLUGIN_LOADER_ADD(removesilence);
 #endif
 #if defined(GST_IOS_PLUGIN_SEGMENTCLIP) || defined(GST_IOS_PLUGINS_EFFECTS)
-    GST_PLUGIN_STATIC_REGISTER(segmentclip);
+    GST_PLAYER_PLUGIN_LOADER_ADD(segmentclip);
 #endif
 #if defined(GST_IOS_PLUGIN_SMOOTH) || defined(GST_IOS_PLUGINS_EFFECTS)
-    GST_PLUGIN_STATIC_REGISTER(smooth);
+    GST_PLAYER_PLUGIN_LOADER_ADD(smooth);
 #endif
 #if defined(GST_IOS_PLUGIN_SPEED) || defined(GST_IOS_PLUGINS_EFFECTS)
-    GST_PLUGIN_STATIC_REGISTER(speed);
+    GST_PLAYER_PLUGIN_LOADER_ADD(speed);
 #endif
 #if defined(GST_IOS_PLUGIN_VIDEOFILTERSBAD) || defined(GST_IOS_PLUGINS_EFFECTS)
-    GST_PLUGIN_STATIC_REGISTER(videofiltersbad);
+    GST_PLAYER_PLUGIN_LOADER_ADD(videofiltersbad);
 #endif
 #if defined(GST_IOS_PLUGIN_SUBPARSE) || defined(GST_IOS_PLUGINS_CODECS)
-    GST_PLUGIN_STATIC_REGISTER(subparse);
+    GST_PLAYER_PLUGIN_LOADER_ADD(subparse);
 #endif
 #if defined(GST_IOS_PLUGIN_OGG) || defined(GST_IOS_PLUGINS_CODECS)
-    GST_PLUGIN_STATIC_REGISTER(ogg);
+    GST_PLAYER_PLUGIN_LOADER_ADD(ogg);
 #endif
 #if defined(GST_IOS_PLUGIN_THEORA) || defined(GST_IOS_PLUGINS_CODECS)
-    GST_PLUGIN_STATIC_REGISTER(theora);
+    GST_PLAYER_PLUGIN_LOADER_ADD(theora);
 #endif
 #if defined(GST_IOS_PLUGIN_VORBIS) || defined(GST_IOS_PLUGINS_CODECS)
-    GST_PLUGIN_STATIC_REGISTER(vorbis);
+    GST_PLAYER_PLUGIN_LOADER_ADD(vorbis);
 #endif
 #if defined(GST_IOS_PLUGIN_IVORBISDEC) || defined(GST_IOS_PLUGINS_CODECS)
-    GST_PLUGIN_STATIC_REGISTER(ivorbisdec);
+    GST_PLAYER_PLUGIN_LOADER_ADD(ivorbisdec);
 #endif
 #if defined(GST_IOS_PLUGIN_ALAW) || defined(GST_IOS_PLUGINS_CODECS)
-    GST_PLUGIN_STATIC_REGISTER(alaw);
+    GST_PLAYER_PLUGIN_LOADER_ADD(alaw);
 #endif
 #if defined(GST_IOS_PLUGIN_APETAG) || defined(GST_IOS_PLUGINS_CODECS)
-    GST_PLUGIN_STATIC_REGISTER(apetag);
+    GST_PLAYER_PLUGIN_LOADER_ADD(apetag);
 #endif
 #if defined(GST_IOS_PLUGIN_AUDIOPARSERS) || defined(GST_IOS_PLUGINS_CODECS)
-    GST_PLUGIN_STATIC_REGISTER(audioparsers);
+    GST_PLAYER_PLUGIN_LOADER_ADD(audioparsers);
 #endif
 #if defined(GST_IOS_PLUGIN_AUPARSE) || defined(GST_IOS_PLUGINS_CODECS)
-    GST_PLUGIN_STATIC_REGISTER(auparse);
+    GST_PLAYER_PLUGIN_LOADER_ADD(auparse);
 #endif
 #if defined(GST_IOS_PLUGIN_AVI) || defined(GST_IOS_PLUGINS_CODECS)
-    GST_PLUGIN_STATIC_REGISTER(avi);
+    GST_PLAYER_PLUGIN_LOADER_ADD(avi);
 #endif
 #if defined(GST_IOS_PLUGIN_DV) || defined(GST_IOS_PLUGINS_CODECS)
-    GST_PLUGIN_STATIC_REGISTER(dv);
+    GST_PLAYER_PLUGIN_LOADER_ADD(dv);
 #endif
 #if defined(GST_IOS_PLUGIN_FLAC) || defined(GST_IOS_PLUGINS_CODECS)
-    GST_PLUGIN_STATIC_REGISTER(flac);
+    GST_PLAYER_PLUGIN_LOADER_ADD(flac);
 #endif
 #if defined(GST_IOS_PLUGIN_FLV) || defined(GST_IOS_PLUGINS_CODECS)
-    GST_PLUGIN_STATIC_REGISTER(flv);
+    GST_PLAYER_PLUGIN_LOADER_ADD(flv);
 #endif
 #if defined(GST_IOS_PLUGIN_FLXDEC) || defined(GST_IOS_PLUGINS_CODECS)
-    GST_PLUGIN_STATIC_REGISTER(flxdec);
+    GST_PLAYER_PLUGIN_LOADER_ADD(flxdec);
 #endif
 #if defined(GST_IOS_PLUGIN_ICYDEMUX) || defined(GST_IOS_PLUGINS_CODECS)
-    GST_PLUGIN_STATIC_REGISTER(icydemux);
+    GST_PLAYER_PLUGIN_LOADER_ADD(icydemux);
 #endif
 #if defined(GST_IOS_PLUGIN_ID3DEMUX) || defined(GST_IOS_PLUGINS_CODECS)
-    GST_PLUGIN_STATIC_REGISTER(id3demux);
+    GST_PLAYER_PLUGIN_LOADER_ADD(id3demux);
 #endif
 #if defined(GST_IOS_PLUGIN_ISOMP4) || defined(GST_IOS_PLUGINS_CODECS)
-    GST_PLUGIN_STATIC_REGISTER(isomp4);
+    GST_PLAYER_PLUGIN_LOADER_ADD(isomp4);
 #endif
 #if defined(GST_IOS_PLUGIN_JPEG) || defined(GST_IOS_PLUGINS_CODECS)
-    GST_PLUGIN_STATIC_REGISTER(jpeg);
+    GST_PLAYER_PLUGIN_LOADER_ADD(jpeg);
 #endif
 #if defined(GST_IOS_PLUGIN_MATROSKA) || defined(GST_IOS_PLUGINS_CODECS)
-    GST_PLUGIN_STATIC_REGISTER(matroska);
+    GST_PLAYER_PLUGIN_LOADER_ADD(matroska);
 #endif
 #if defined(GST_IOS_PLUGIN_MULAW) || defined(GST_IOS_PLUGINS_CODECS)
-    GST_PLUGIN_STATIC_REGISTER(mulaw);
+    GST_PLAYER_PLUGIN_LOADER_ADD(mulaw);
 #endif
 #if defined(GST_IOS_PLUGIN_MULTIPART) || defined(GST_IOS_PLUGINS_CODECS)
-    GST_PLUGIN_STATIC_REGISTER(multipart);
+    GST_PLAYER_PLUGIN_LOADER_ADD(multipart);
 #endif
 #if defined(GST_IOS_PLUGIN_PNG) || defined(GST_IOS_PLUGINS_CODECS)
-    GST_PLUGIN_STATIC_REGISTER(png);
+    GST_PLAYER_PLUGIN_LOADER_ADD(png);
 #endif
 #if defined(GST_IOS_PLUGIN_SPEEX) || defined(GST_IOS_PLUGINS_CODECS)
-    GST_PLUGIN_STATIC_REGISTER(speex);
+    GST_PLAYER_PLUGIN_LOADER_ADD(speex);
 #endif
 #if defined(GST_IOS_PLUGIN_TAGLIB) || defined(GST_IOS_PLUGINS_CODECS)
-    GST_PLUGIN_STATIC_REGISTER(taglib);
+    GST_PLAYER_PLUGIN_LOADER_ADD(taglib);
 #endif
 #if defined(GST_IOS_PLUGIN_VPX) || defined(GST_IOS_PLUGINS_CODECS)
-    GST_PLUGIN_STATIC_REGISTER(vpx);
+    GST_PLAYER_PLUGIN_LOADER_ADD(vpx);
 #endif
 #if defined(GST_IOS_PLUGIN_WAVENC) || defined(GST_IOS_PLUGINS_CODECS)
-    GST_PLUGIN_STATIC_REGISTER(wavenc);
+    GST_PLAYER_PLUGIN_LOADER_ADD(wavenc);
 #endif
 #if defined(GST_IOS_PLUGIN_WAVPACK) || defined(GST_IOS_PLUGINS_CODECS)
-    GST_PLUGIN_STATIC_REGISTER(wavpack);
+    GST_PLAYER_PLUGIN_LOADER_ADD(wavpack);
 #endif
 #if defined(GST_IOS_PLUGIN_WAVPARSE) || defined(GST_IOS_PLUGINS_CODECS)
-    GST_PLUGIN_STATIC_REGISTER(wavparse);
+    GST_PLAYER_PLUGIN_LOADER_ADD(wavparse);
 #endif
 #if defined(GST_IOS_PLUGIN_Y4MENC) || defined(GST_IOS_PLUGINS_CODECS)
-    GST_PLUGIN_STATIC_REGISTER(y4menc);
+    GST_PLAYER_PLUGIN_LOADER_ADD(y4menc);
 #endif
 #if defined(GST_IOS_PLUGIN_ADPCMDEC) || defined(GST_IOS_PLUGINS_CODECS)
-    GST_PLUGIN_STATIC_REGISTER(adpcmdec);
+    GST_PLAYER_PLUGIN_LOADER_ADD(adpcmdec);
 #endif
 #if defined(GST_IOS_PLUGIN_ADPCMENC) || defined(GST_IOS_PLUGINS_CODECS)
-    GST_PLUGIN_STATIC_REGISTER(adpcmenc);
+    GST_PLAYER_PLUGIN_LOADER_ADD(adpcmenc);
 #endif
 #if defined(GST_IOS_PLUGIN_DASHDEMUX) || defined(GST_IOS_PLUGINS_CODECS)
-    GST_PLUGIN_STATIC_REGISTER(dashdemux);
+    GST_PLAYER_PLUGIN_LOADER_ADD(dashdemux);
 #endif
 #if defined(GST_IOS_PLUGIN_DVBSUBOVERLAY) || defined(GST_IOS_PLUGINS_CODECS)
-    GST_PLUGIN_STATIC_REGISTER(dvbsuboverlay);
+    GST_PLAYER_PLUGIN_LOADER_ADD(dvbsuboverlay);
 #endif
 #if defined(GST_IOS_PLUGIN_DVDSPU) || defined(GST_IOS_PLUGINS_CODECS)
-    GST_PLUGIN_STATIC_REGISTER(dvdspu);
+    GST_PLAYER_PLUGIN_LOADER_ADD(dvdspu);
 #endif
 #if defined(GST_IOS_PLUGIN_FRAGMENTED) || defined(GST_IOS_PLUGINS_CODECS)
-    GST_PLUGIN_STATIC_REGISTER(fragmented);
+    GST_PLAYER_PLUGIN_LOADER_ADD(fragmented);
 #endif
 #if defined(GST_IOS_PLUGIN_ID3TAG) || defined(GST_IOS_PLUGINS_CODECS)
-    GST_PLUGIN_STATIC_REGISTER(id3tag);
+    GST_PLAYER_PLUGIN_LOADER_ADD(id3tag);
 #endif
 #if defined(GST_IOS_PLUGIN_KATE) || defined(GST_IOS_PLUGINS_CODECS)
-    GST_PLUGIN_STATIC_REGISTER(kate);
+    GST_PLAYER_PLUGIN_LOADER_ADD(kate);
 #endif
 #if defined(GST_IOS_PLUGIN_MIDI) || defined(GST_IOS_PLUGINS_CODECS)
-    GST_PLUGIN_STATIC_REGISTER(midi);
+    GST_PLAYER_PLUGIN_LOADER_ADD(midi);
 #endif
 #if defined(GST_IOS_PLUGIN_MXF) || defined(GST_IOS_PLUGINS_CODECS)
-    GST_PLUGIN_STATIC_REGISTER(mxf);
+    GST_PLAYER_PLUGIN_LOADER_ADD(mxf);
 #endif
 #if defined(GST_IOS_PLUGIN_OPUS) || defined(GST_IOS_PLUGINS_CODECS)
-    GST_PLUGIN_STATIC_REGISTER(opus);
+    GST_PLAYER_PLUGIN_LOADER_ADD(opus);
 #endif
 #if defined(GST_IOS_PLUGIN_PCAPPARSE) || defined(GST_IOS_PLUGINS_CODECS)
-    GST_PLUGIN_STATIC_REGISTER(pcapparse);
+    GST_PLAYER_PLUGIN_LOADER_ADD(pcapparse);
 #endif
 #if defined(GST_IOS_PLUGIN_PNM) || defined(GST_IOS_PLUGINS_CODECS)
-    GST_PLUGIN_STATIC_REGISTER(pnm);
+    GST_PLAYER_PLUGIN_LOADER_ADD(pnm);
 #endif
 #if defined(GST_IOS_PLUGIN_RFBSRC) || defined(GST_IOS_PLUGINS_CODECS)
-    GST_PLUGIN_STATIC_REGISTER(rfbsrc);
+    GST_PLAYER_PLUGIN_LOADER_ADD(rfbsrc);
 #endif
 #if defined(GST_IOS_PLUGIN_SCHRO) || defined(GST_IOS_PLUGINS_CODECS)
-    GST_PLUGIN_STATIC_REGISTER(schro);
+    GST_PLAYER_PLUGIN_LOADER_ADD(schro);
 #endif
 #if defined(GST_IOS_PLUGIN_GSTSIREN) || defined(GST_IOS_PLUGINS_CODECS)
-    GST_PLUGIN_STATIC_REGISTER(gstsiren);
+    GST_PLAYER_PLUGIN_LOADER_ADD(gstsiren);
 #endif
 #if defined(GST_IOS_PLUGIN_SMOOTHSTREAMING) || defined(GST_IOS_PLUGINS_CODECS)
-    GST_PLUGIN_STATIC_REGISTER(smoothstreaming);
+    GST_PLAYER_PLUGIN_LOADER_ADD(smoothstreaming);
 #endif
 #if defined(GST_IOS_PLUGIN_SUBENC) || defined(GST_IOS_PLUGINS_CODECS)
-    GST_PLUGIN_STATIC_REGISTER(subenc);
+    GST_PLAYER_PLUGIN_LOADER_ADD(subenc);
 #endif
 #if defined(GST_IOS_PLUGIN_VIDEOPARSERSBAD) || defined(GST_IOS_PLUGINS_CODECS)
-    GST_PLUGIN_STATIC_REGISTER(videoparsersbad);
+    GST_PLAYER_PLUGIN_LOADER_ADD(videoparsersbad);
 #endif
 #if defined(GST_IOS_PLUGIN_Y4MDEC) || defined(GST_IOS_PLUGINS_CODECS)
-    GST_PLUGIN_STATIC_REGISTER(y4mdec);
+    GST_PLAYER_PLUGIN_LOADER_ADD(y4mdec);
 #endif
 #if defined(GST_IOS_PLUGIN_JPEGFORMAT) || defined(GST_IOS_PLUGINS_CODECS)
-    GST_PLUGIN_STATIC_REGISTER(jpegformat);
+    GST_PLAYER_PLUGIN_LOADER_ADD(jpegformat);
 #endif
 #if defined(GST_IOS_PLUGIN_GDP) || defined(GST_IOS_PLUGINS_CODECS)
-    GST_PLUGIN_STATIC_REGISTER(gdp);
+    GST_PLAYER_PLUGIN_LOADER_ADD(gdp);
 #endif
 #if defined(GST_IOS_PLUGIN_RSVG) || defined(GST_IOS_PLUGINS_CODECS)
-    GST_PLUGIN_STATIC_REGISTER(rsvg);
+    GST_PLAYER_PLUGIN_LOADER_ADD(rsvg);
 #endif
 #if defined(GST_IOS_PLUGIN_TCP) || defined(GST_IOS_PLUGINS_NET)
-    GST_PLUGIN_STATIC_REGISTER(tcp);
+    GST_PLAYER_PLUGIN_LOADER_ADD(tcp);
 #endif
 #if defined(GST_IOS_PLUGIN_RTSP) || defined(GST_IOS_PLUGINS_NET)
-    GST_PLUGIN_STATIC_REGISTER(rtsp);
+    GST_PLAYER_PLUGIN_LOADER_ADD(rtsp);
 #endif
 #if defined(GST_IOS_PLUGIN_RTP) || defined(GST_IOS_PLUGINS_NET)
-    GST_PLUGIN_STATIC_REGISTER(rtp);
+    GST_PLAYER_PLUGIN_LOADER_ADD(rtp);
 #endif
 #if defined(GST_IOS_PLUGIN_RTPMANAGER) || defined(GST_IOS_PLUGINS_NET)
-    GST_PLUGIN_STATIC_REGISTER(rtpmanager);
+    GST_PLAYER_PLUGIN_LOADER_ADD(rtpmanager);
 #endif
 #if defined(GST_IOS_PLUGIN_SOUP) || defined(GST_IOS_PLUGINS_NET)
-    GST_PLUGIN_STATIC_REGISTER(soup);
+    GST_PLAYER_PLUGIN_LOADER_ADD(soup);
 #endif
 #if defined(GST_IOS_PLUGIN_UDP) || defined(GST_IOS_PLUGINS_NET)
-    GST_PLUGIN_STATIC_REGISTER(udp);
+    GST_PLAYER_PLUGIN_LOADER_ADD(udp);
 #endif
 #if defined(GST_IOS_PLUGIN_DATAURISRC) || defined(GST_IOS_PLUGINS_NET)
-    GST_PLUGIN_STATIC_REGISTER(dataurisrc);
+    GST_PLAYER_PLUGIN_LOADER_ADD(dataurisrc);
 #endif
 #if defined(GST_IOS_PLUGIN_SDP) || defined(GST_IOS_PLUGINS_NET)
-    GST_PLUGIN_STATIC_REGISTER(sdp);
+    GST_PLAYER_PLUGIN_LOADER_ADD(sdp);
 #endif
 #if defined(GST_IOS_PLUGIN_GNONLIN) || defined(GST_IOS_PLUGINS_EDITING)
-    GST_PLUGIN_STATIC_REGISTER(gnonlin);
+    GST_PLAYER_PLUGIN_LOADER_ADD(gnonlin);
 #endif
 
 #if defined(GST_IOS_GIO_MODULE_GNUTLS)
@@ -977,12 +988,18 @@ gst_ios_init (void)
 #endif
 
   /* Lower the ranks of filesrc and giosrc so iosavassetsrc is
-   * tried first in gst_element_make_from_uri() for file:// */
-  reg = gst_registry_get();
-  plugin = gst_registry_lookup_feature(reg, "filesrc");
-  if (plugin)
-    gst_plugin_feature_set_rank(plugin, GST_RANK_SECONDARY);
-  plugin = gst_registry_lookup_feature(reg, "giosrc");
-  if (plugin)
-    gst_plugin_feature_set_rank(plugin, GST_RANK_SECONDARY-1);
+   * tried first in gst_element_make_from_uri() for file://. The ranks
+   * are applied whenever the plugins get registered. */
+  gst_player_plugin_loader_set_rank("filesrc", GST_RANK_SECONDARY);
+  gst_player_plugin_loader_set_rank("giosrc", GST_RANK_SECONDARY-1);
+
+  plugin_index = g_build_filename (cache_dir, "gst-plugin-index.ini", NULL);
+  if (!gst_player_plugin_loader_load_index (plugin_index)) {
+    gst_player_plugin_loader_register_all ();
+    if (!gst_player_plugin_loader_save_index (plugin_index, &err)) {
+      GST_WARNING ("Failed to write plugin index: %s", err->message);
+      g_clear_error (&err);
+    }
+  }
+  g_free (plugin_index);
 }
@@ -0,0 +1,61 @@
+//
+//  GstPlayerTestCase.h
+//  LiveCodingTests
+//
+//  Base class of the GstPlayer tests and benchmarks. The tests run inside
+//  the app, so GStreamer and its static plugins are already initialized by
+//  gst_ios_init().
+//
+
+#import <XCTest/XCTest.h>
+#import <gst/player/gstplayer.h>
+
+@interface GstPlayerTestCase : XCTestCase
+
+/* file:// URI of an FLV clip with H.264 video (640x360, 30 fps, a keyframe
+ * every second) and AAC audio, created once per run in the temporary
+ * directory. Static clips show the same picture in every frame. */
++ (NSString *)mediaURIWithDuration:(guint)seconds;
++ (NSString *)staticMediaURIWithDuration:(guint)seconds;
+
+/* The same at another video size */
++ (NSString *)mediaURIWithDuration:(guint)seconds width:(guint)width height:(guint)height;
+
+/* file:// URI of a Matroska clip with the same video and several AAC
+ * audio tracks */
++ (NSString *)multiAudioMediaURIWithDuration:(guint)seconds tracks:(guint)tracks;
+
+/* http:// URI serving the file behind a file:// URI, with byte range
+ * requests, from a server that runs while the default main context is
+ * iterated. The query part of the URI is ignored by the server. */
++ (NSString *)httpURIForFileURI:(NSString *)uri;
+
+/* file:// URI of an SRT file with one cue per second */
++ (NSString *)subtitleURIWithCues:(guint)cues;
+
+/* Resident memory and CPU time (user + system) of the process */
++ (guint64)residentSize;
++ (GstClockTime)cpuTime;
+
+/* A player without video renderer whose signals are emitted from the
+ * default main context, i.e. while -runUntil:timeout: iterates it */
+- (GstPlayer *)newPlayer;
+
+/* The same with a renderer, which only provides the target size as the
+ * video sink is replaced */
+- (GstPlayer *)newPlayerWithRenderer:(GstPlayerVideoRenderer *)renderer;
+
+/* Iterates the default main context until condition returns YES */
+- (BOOL)runUntil:(BOOL (^)(void))condition timeout:(NSTimeInterval)timeout;
+
+/* Starts playing and waits until the player is PLAYING */
+- (BOOL)playUntilPlaying:(GstPlayer *)player;
+
+/* Starts playing and returns the time until the first video frame reached
+ * the sink, GST_CLOCK_TIME_NONE if none did */
+- (GstClockTime)timeToFirstFrame:(GstPlayer *)player;
+
+/* Plays for the given time and returns the CPU time used meanwhile */
+- (GstClockTime)cpuTimeWhilePlaying:(GstPlayer *)player seconds:(NSTimeInterval)seconds;
+
+@end
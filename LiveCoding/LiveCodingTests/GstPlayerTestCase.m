@@ -0,0 +1,343 @@
+//
+//  GstPlayerTestCase.m
+//  LiveCodingTests
+//
+
+#import "GstPlayerTestCase.h"
+
+#include <gio/gio.h>
+#include <string.h>
+#include <mach/mach.h>
+#include <sys/resource.h>
+
+static GstPadProbeReturn
+first_frame_probe_cb (GstPad * pad, GstPadProbeInfo * info, gpointer user_data)
+{
+    g_atomic_int_set ((gint *) user_data, 1);
+
+    return GST_PAD_PROBE_REMOVE;
+}
+
+/* Minimal HTTP/1.1 server for one GET request per connection, with
+ * "Range: bytes=N-" support so that the client can seek */
+static gboolean
+http_run_cb (GThreadedSocketService * service, GSocketConnection * connection,
+    GObject * source_object, gpointer user_data)
+{
+    GOutputStream *out = g_io_stream_get_output_stream (G_IO_STREAM (connection));
+    GDataInputStream *in = g_data_input_stream_new (
+        g_io_stream_get_input_stream (G_IO_STREAM (connection)));
+    GMappedFile *file = NULL;
+    gchar *line, *header, *range, *filename = NULL, **request;
+    guint64 offset = 0, size;
+
+    g_filter_input_stream_set_close_base_stream (G_FILTER_INPUT_STREAM (in), FALSE);
+    line = g_data_input_stream_read_line (in, NULL, NULL, NULL);
+    if (line) {
+        request = g_strsplit (line, " ", 3);
+        if (request[0] && request[1]) {
+            g_strdelimit (request[1], "?", '\0');
+            filename = g_uri_unescape_string (request[1], NULL);
+        }
+        g_strfreev (request);
+        g_free (line);
+    }
+    while ((line = g_data_input_stream_read_line (in, NULL, NULL, NULL))) {
+        gboolean end = *g_strchomp (line) == '\0';
+
+        if (g_ascii_strncasecmp (line, "Range: bytes=", 13) == 0)
+            offset = g_ascii_strtoull (line + 13, NULL, 10);
+        g_free (line);
+        if (end)
+            break;
+    }
+
+    if (filename)
+        file = g_mapped_file_new (filename, FALSE, NULL);
+    if (!file) {
+        header = g_strdup ("HTTP/1.1 404 Not Found\r\nContent-Length: 0\r\n"
+            "Connection: close\r\n\r\n");
+        g_output_stream_write_all (out, header, strlen (header), NULL, NULL, NULL);
+    } else {
+        size = g_mapped_file_get_length (file);
+        offset = MIN (offset, size);
+        range = offset ? g_strdup_printf ("206 Partial Content\r\n"
+            "Content-Range: bytes %" G_GUINT64_FORMAT "-%" G_GUINT64_FORMAT
+            "/%" G_GUINT64_FORMAT, offset, size - 1, size) : g_strdup ("200 OK");
+        header = g_strdup_printf ("HTTP/1.1 %s\r\nContent-Type: video/x-flv\r\n"
+            "Content-Length: %" G_GUINT64_FORMAT "\r\nAccept-Ranges: bytes\r\n"
+            "Connection: close\r\n\r\n", range, size - offset);
+        g_free (range);
+        /* Fails when the client closes the connection to seek */
+        if (g_output_stream_write_all (out, header, strlen (header), NULL, NULL,
+                NULL))
+            g_output_stream_write_all (out, g_mapped_file_get_contents (file) + offset,
+                size - offset, NULL, NULL, NULL);
+        g_mapped_file_unref (file);
+    }
+
+    g_free (header);
+    g_free (filename);
+    g_object_unref (in);
+
+    return TRUE;
+}
+
+@implementation GstPlayerTestCase
+
+/* Runs a gst-launch style pipeline until EOS */
++ (BOOL)runPipeline:(NSString *)description
+{
+    GstElement *pipeline;
+    GstMessage *msg;
+    GError *err = NULL;
+    BOOL ret;
+
+    pipeline = gst_parse_launch ([description UTF8String], &err);
+    if (!pipeline) {
+        NSLog(@"Can't create pipeline: %s", err->message);
+        g_clear_error (&err);
+        return NO;
+    }
+
+    gst_element_set_state (pipeline, GST_STATE_PLAYING);
+    msg = gst_bus_timed_pop_filtered (GST_ELEMENT_BUS (pipeline), 60 * GST_SECOND,
+        GST_MESSAGE_EOS | GST_MESSAGE_ERROR);
+    ret = msg && GST_MESSAGE_TYPE (msg) == GST_MESSAGE_EOS;
+    if (msg)
+        gst_message_unref (msg);
+    gst_element_set_state (pipeline, GST_STATE_NULL);
+    gst_object_unref (pipeline);
+
+    return ret;
+}
+
++ (NSString *)mediaURIWithDuration:(guint)seconds pattern:(NSString *)pattern
+                             width:(guint)width height:(guint)height
+{
+    NSString *path = [NSTemporaryDirectory() stringByAppendingPathComponent:
+                      [NSString stringWithFormat:@"gstplayer-test-%@-%ux%u-%u.flv",
+                       pattern, width, height, seconds]];
+
+    if (![[NSFileManager defaultManager] fileExistsAtPath:path]) {
+        NSString *description = [NSString stringWithFormat:
+            @"videotestsrc num-buffers=%u pattern=%@ "
+            "! video/x-raw,width=%u,height=%u,framerate=30/1 "
+            "! x264enc key-int-max=30 speed-preset=ultrafast ! h264parse "
+            "! flvmux name=mux ! filesink location=\"%@.part\" "
+            "audiotestsrc num-buffers=%u samplesperbuffer=1024 "
+            "! audio/x-raw,rate=44100,channels=2 ! voaacenc ! aacparse ! mux.",
+            seconds * 30, pattern, width, height, path, seconds * 44100 / 1024 + 1];
+
+        if (![self runPipeline:description])
+            return nil;
+        [[NSFileManager defaultManager] moveItemAtPath:[path stringByAppendingString:@".part"]
+                                                toPath:path error:nil];
+    }
+
+    return [[NSURL fileURLWithPath:path] absoluteString];
+}
+
++ (NSString *)mediaURIWithDuration:(guint)seconds
+{
+    return [self mediaURIWithDuration:seconds pattern:@"ball" width:640 height:360];
+}
+
++ (NSString *)mediaURIWithDuration:(guint)seconds width:(guint)width height:(guint)height
+{
+    return [self mediaURIWithDuration:seconds pattern:@"ball" width:width height:height];
+}
+
++ (NSString *)staticMediaURIWithDuration:(guint)seconds
+{
+    return [self mediaURIWithDuration:seconds pattern:@"smpte" width:640 height:360];
+}
+
++ (NSString *)multiAudioMediaURIWithDuration:(guint)seconds tracks:(guint)tracks
+{
+    NSString *path = [NSTemporaryDirectory() stringByAppendingPathComponent:
+                      [NSString stringWithFormat:@"gstplayer-test-%u-%u.mkv", tracks, seconds]];
+    NSMutableString *description;
+    guint i;
+
+    if ([[NSFileManager defaultManager] fileExistsAtPath:path])
+        return [[NSURL fileURLWithPath:path] absoluteString];
+
+    description = [NSMutableString stringWithFormat:
+        @"videotestsrc num-buffers=%u pattern=ball "
+        "! video/x-raw,width=640,height=360,framerate=30/1 "
+        "! x264enc key-int-max=30 speed-preset=ultrafast ! h264parse "
+        "! matroskamux name=mux ! filesink location=\"%@.part\" ",
+        seconds * 30, path];
+    /* A different tone per track, like one language each */
+    for (i = 0; i < tracks; i++) {
+        [description appendFormat:
+            @"audiotestsrc num-buffers=%u samplesperbuffer=1024 freq=%u "
+            "! audio/x-raw,rate=44100,channels=2 ! voaacenc ! aacparse ! mux. ",
+            seconds * 44100 / 1024 + 1, 440 + 110 * i];
+    }
+
+    if (![self runPipeline:description])
+        return nil;
+    [[NSFileManager defaultManager] moveItemAtPath:[path stringByAppendingString:@".part"]
+                                            toPath:path error:nil];
+
+    return [[NSURL fileURLWithPath:path] absoluteString];
+}
+
++ (NSString *)httpURIForFileURI:(NSString *)uri
+{
+    static GSocketService *service;
+    static guint16 port;
+    gchar *filename, *path;
+    NSString *ret;
+
+    if (!service) {
+        service = g_threaded_socket_service_new (4);
+        port = g_socket_listener_add_any_inet_port (G_SOCKET_LISTENER (service),
+                                                    NULL, NULL);
+        g_signal_connect (service, "run", G_CALLBACK (http_run_cb), NULL);
+        g_socket_service_start (service);
+    }
+
+    filename = g_filename_from_uri ([uri UTF8String], NULL, NULL);
+    path = g_uri_escape_string (filename, G_URI_RESERVED_CHARS_ALLOWED_IN_PATH, FALSE);
+    ret = [NSString stringWithFormat:@"http://127.0.0.1:%u%s", port, path];
+    g_free (path);
+    g_free (filename);
+
+    return ret;
+}
+
++ (NSString *)subtitleURIWithCues:(guint)cues
+{
+    NSString *path = [NSTemporaryDirectory() stringByAppendingPathComponent:
+                      [NSString stringWithFormat:@"gstplayer-test-%u.srt", cues]];
+    NSMutableString *srt = [NSMutableString string];
+    guint i;
+
+    for (i = 0; i < cues; i++) {
+        [srt appendFormat:@"%u\n00:%02u:%02u,000 --> 00:%02u:%02u,900\nCue number %u\n\n",
+         i + 1, i / 60, i % 60, i / 60, i % 60, i + 1];
+    }
+    [srt writeToFile:path atomically:YES encoding:NSUTF8StringEncoding error:nil];
+
+    return [[NSURL fileURLWithPath:path] absoluteString];
+}
+
++ (guint64)residentSize
+{
+    struct mach_task_basic_info info;
+    mach_msg_type_number_t count = MACH_TASK_BASIC_INFO_COUNT;
+
+    if (task_info (mach_task_self (), MACH_TASK_BASIC_INFO, (task_info_t) &info,
+                   &count) != KERN_SUCCESS)
+        return 0;
+
+    return info.resident_size;
+}
+
++ (GstClockTime)cpuTime
+{
+    struct rusage usage;
+
+    getrusage (RUSAGE_SELF, &usage);
+
+    return GST_TIMEVAL_TO_TIME (usage.ru_utime) + GST_TIMEVAL_TO_TIME (usage.ru_stime);
+}
+
+- (GstPlayer *)newPlayer
+{
+    return [self newPlayerWithRenderer:NULL];
+}
+
+- (GstPlayer *)newPlayerWithRenderer:(GstPlayerVideoRenderer *)renderer
+{
+    GstPlayer *player;
+    GstElement *pipeline;
+
+    player = gst_player_new_full (renderer,
+        gst_player_g_main_context_signal_dispatcher_new (NULL));
+
+    /* Nothing is shown, but buffers are still synchronized to the clock */
+    pipeline = gst_player_get_pipeline (player);
+    g_object_set (pipeline,
+        "video-sink", gst_element_factory_make ("fakesink", "test-video-sink"),
+        "audio-sink", gst_element_factory_make ("fakesink", "test-audio-sink"),
+        NULL);
+    gst_object_unref (pipeline);
+
+    return player;
+}
+
+- (BOOL)runUntil:(BOOL (^)(void))condition timeout:(NSTimeInterval)timeout
+{
+    NSDate *deadline = [NSDate dateWithTimeIntervalSinceNow:timeout];
+
+    while (!condition ()) {
+        if ([deadline timeIntervalSinceNow] < 0)
+            return NO;
+        if (!g_main_context_iteration (NULL, FALSE))
+            g_usleep (1000);
+    }
+
+    return YES;
+}
+
+- (BOOL)playUntilPlaying:(GstPlayer *)player
+{
+    GstElement *pipeline = gst_player_get_pipeline (player);
+    BOOL ret;
+
+    gst_player_play (player);
+    ret = [self runUntil:^BOOL {
+        return GST_STATE (pipeline) == GST_STATE_PLAYING;
+    } timeout:10];
+    gst_object_unref (pipeline);
+
+    return ret;
+}
+
+- (GstClockTime)timeToFirstFrame:(GstPlayer *)player
+{
+    GstElement *pipeline = gst_player_get_pipeline (player);
+    GstElement *sink = gst_bin_get_by_name (GST_BIN (pipeline), "test-video-sink");
+    GstPad *pad = gst_element_get_static_pad (sink, "sink");
+    volatile gint done = 0;
+    volatile gint *done_p = &done;
+    GstClockTime start;
+    BOOL ret;
+
+    gst_pad_add_probe (pad, GST_PAD_PROBE_TYPE_BUFFER, first_frame_probe_cb,
+        (gpointer) done_p, NULL);
+
+    start = gst_util_get_timestamp ();
+    gst_player_play (player);
+    ret = [self runUntil:^BOOL {
+        return g_atomic_int_get (done_p) != 0;
+    } timeout:10];
+
+    gst_object_unref (pad);
+    gst_object_unref (sink);
+    gst_object_unref (pipeline);
+
+    return ret ? gst_util_get_timestamp () - start : GST_CLOCK_TIME_NONE;
+}
+
+- (GstClockTime)cpuTimeWhilePlaying:(GstPlayer *)player seconds:(NSTimeInterval)seconds
+{
+    NSDate *end;
+    GstClockTime start;
+
+    XCTAssertTrue ([self playUntilPlaying:player]);
+
+    start = [GstPlayerTestCase cpuTime];
+    end = [NSDate dateWithTimeIntervalSinceNow:seconds];
+    [self runUntil:^BOOL {
+        return [end timeIntervalSinceNow] < 0;
+    } timeout:seconds + 1];
+
+    return [GstPlayerTestCase cpuTime] - start;
+}
+
+@end
@@ -0,0 +1,454 @@
+//
+//  GstPlayerTests.m
+//  LiveCodingTests
+//
+//  Functional tests of the player library against clips created with the
+//  bundled encoders.
+//
+
+#import "GstPlayerTestCase.h"
+#import <gst/player/gstplayer-plugin-loader.h>
+#import <gst/player/gstplayer-flight-recorder-private.h>
+
+@interface GstPlayerTests : GstPlayerTestCase
+
+@end
+
+static GstPadProbeReturn
+count_flushes_cb (GstPad * pad, GstPadProbeInfo * info, gpointer user_data)
+{
+    if (GST_EVENT_TYPE (GST_PAD_PROBE_INFO_EVENT (info)) == GST_EVENT_FLUSH_START)
+        g_atomic_int_inc ((gint *) user_data);
+
+    return GST_PAD_PROBE_OK;
+}
+
+static guint
+get_loop_iterations (GstPlayer * player)
+{
+    GstStructure *stats = gst_player_get_stats (player);
+    guint n_loops = 0;
+
+    gst_structure_get_uint (stats, "loop-iterations", &n_loops);
+    gst_structure_free (stats);
+
+    return n_loops;
+}
+
+static gboolean
+get_video_conversion (GstPlayer * player)
+{
+    GstStructure *stats = gst_player_get_stats (player);
+    gboolean conversion = TRUE;
+
+    gst_structure_get_boolean (stats, "video-conversion", &conversion);
+    gst_structure_free (stats);
+
+    return conversion;
+}
+
+static guint
+get_tag_updates_suppressed (GstPlayer * player)
+{
+    GstStructure *stats = gst_player_get_stats (player);
+    guint n_suppressed = 0;
+
+    gst_structure_get_uint (stats, "tag-updates-suppressed", &n_suppressed);
+    gst_structure_free (stats);
+
+    return n_suppressed;
+}
+
+/* Posts a global tag list with the given title, like a live stream
+ * updating its metadata */
+static void
+post_global_title (GstElement * pipeline, const gchar * title)
+{
+    GstTagList *tags = gst_tag_list_new (GST_TAG_TITLE, title, NULL);
+
+    gst_tag_list_set_scope (tags, GST_TAG_SCOPE_GLOBAL);
+    gst_element_post_message (pipeline,
+        gst_message_new_tag (GST_OBJECT (pipeline), tags));
+}
+
+static void
+count_media_info_updated_cb (GstPlayer * player, GstPlayerMediaInfo * info,
+    gpointer user_data)
+{
+    (*(guint *) user_data)++;
+}
+
+/* Spins for 10 ms for every frame */
+static void
+busy_handoff_cb (GstElement * identity, GstBuffer * buffer, gpointer user_data)
+{
+    gint64 end = g_get_monotonic_time () + 10000;
+    volatile guint n = 0;
+
+    while (g_get_monotonic_time () < end)
+        n++;
+}
+
+#define N_RECORDER_THREADS 4
+#define N_THREAD_RECORDS 1000
+
+typedef struct
+{
+    GstPlayerFlightRecorder *recorder;
+    guint thread;
+} RecorderThreadData;
+
+/* Records seeks whose target encodes the record's index and thread and
+ * whose rate is the thread, so torn records can be told apart */
+static gpointer
+record_seeks_thread (gpointer user_data)
+{
+    RecorderThreadData *data = user_data;
+    guint i;
+
+    for (i = 0; i < N_THREAD_RECORDS; i++)
+        gst_player_flight_recorder_record (data->recorder, FLIGHT_EVENT_SEEK,
+            data->thread * 100, 0, i * 16 + data->thread);
+
+    return NULL;
+}
+
+static void
+store_error_events_cb (GstPlayer * player, GError * err, gpointer user_data)
+{
+    *(gchar **) user_data = gst_player_get_error_events (player);
+}
+
+@implementation GstPlayerTests
+
+/* Unchanged frames are dropped, but pausing a static screen must still
+ * complete because the sink prerolls again */
+- (void)testSkipStaticFramesPrerollsWhenPaused
+{
+    GstPlayer *player = [self newPlayer];
+    GstElement *pipeline = gst_player_get_pipeline (player);
+
+    gst_player_set_skip_static_frames (player, TRUE);
+    gst_player_set_uri (player, [[GstPlayerTestCase staticMediaURIWithDuration:10] UTF8String]);
+    XCTAssertTrue ([self playUntilPlaying:player]);
+
+    /* Long enough for the static frames to be skipped */
+    [self runUntil:^BOOL { return NO; } timeout:1];
+
+    gst_player_pause (player);
+    XCTAssertTrue ([self runUntil:^BOOL {
+        return GST_STATE (pipeline) == GST_STATE_PAUSED
+            && GST_STATE_PENDING (pipeline) == GST_STATE_VOID_PENDING;
+    } timeout:5]);
+
+    gst_player_stop (player);
+    gst_object_unref (pipeline);
+    g_object_unref (player);
+}
+
+/* Only entering the loop range flushes, the iterations themselves are
+ * queued behind each other */
+- (void)testLoopRangeDoesNotFlush
+{
+    GstPlayer *player = [self newPlayer];
+    GstElement *pipeline = gst_player_get_pipeline (player);
+    GstElement *sink;
+    GstPad *pad;
+    volatile gint n_flushes = 0;
+
+    gst_player_set_uri (player, [[GstPlayerTestCase mediaURIWithDuration:10] UTF8String]);
+    XCTAssertTrue ([self playUntilPlaying:player]);
+
+    sink = gst_bin_get_by_name (GST_BIN (pipeline), "test-video-sink");
+    pad = gst_element_get_static_pad (sink, "sink");
+    gst_pad_add_probe (pad, GST_PAD_PROBE_TYPE_EVENT_FLUSH, count_flushes_cb,
+        (gpointer) &n_flushes, NULL);
+
+    gst_player_set_loop_range (player, 0, 250 * GST_MSECOND);
+    XCTAssertEqual (get_loop_iterations (player), 0u);
+    XCTAssertTrue ([self runUntil:^BOOL {
+        return get_loop_iterations (player) >= 1;
+    } timeout:10]);
+
+    g_atomic_int_set (&n_flushes, 0);
+    XCTAssertTrue ([self runUntil:^BOOL {
+        return get_loop_iterations (player) >= 101;
+    } timeout:60]);
+    XCTAssertEqual (g_atomic_int_get (&n_flushes), 0);
+
+    /* A new range counts from zero again */
+    gst_player_set_loop_range (player, 0, 500 * GST_MSECOND);
+    XCTAssertEqual (get_loop_iterations (player), 0u);
+
+    gst_player_stop (player);
+    gst_object_unref (pad);
+    gst_object_unref (sink);
+    gst_object_unref (pipeline);
+    g_object_unref (player);
+}
+
+/* Plays with an appsink that only takes the given format and returns the
+ * format the sink got */
+- (gchar *)negotiatedFormatWithSinkFormat:(const gchar *)format
+                                  decoder:(const gchar *)decoder
+{
+    GstPlayer *player = [self newPlayer];
+    GstElement *pipeline = gst_player_get_pipeline (player);
+    GstElement *sink = gst_element_factory_make ("appsink", "test-video-sink");
+    GstCaps *caps = gst_caps_new_simple ("video/x-raw", "format", G_TYPE_STRING,
+        format, NULL);
+    const gchar *decoders[] = { decoder, NULL };
+    gchar *negotiated = NULL;
+    GstPad *pad;
+
+    g_object_set (sink, "caps", caps, "max-buffers", 1, "drop", TRUE, NULL);
+    gst_caps_unref (caps);
+    g_object_set (pipeline, "video-sink", sink, NULL);
+    if (decoder)
+        gst_player_set_decoder_allowlist (player, decoders);
+
+    gst_player_set_uri (player, [[GstPlayerTestCase mediaURIWithDuration:10] UTF8String]);
+    XCTAssertTrue ([self playUntilPlaying:player]);
+
+    pad = gst_element_get_static_pad (sink, "sink");
+    caps = gst_pad_get_current_caps (pad);
+    XCTAssertTrue (caps != NULL);
+    if (caps) {
+        negotiated = g_strdup (gst_structure_get_string (
+            gst_caps_get_structure (caps, 0), "format"));
+        gst_caps_unref (caps);
+    }
+    XCTAssertFalse (get_video_conversion (player));
+
+    gst_player_stop (player);
+    gst_object_unref (pad);
+    gst_object_unref (pipeline);
+    g_object_unref (player);
+
+    return negotiated;
+}
+
+/* A sink that takes the decoder's format gets it without conversion */
+- (void)testNativeFormatPassthrough
+{
+    gchar *format = [self negotiatedFormatWithSinkFormat:"I420" decoder:NULL];
+
+    XCTAssertEqual (g_strcmp0 (format, "I420"), 0);
+    g_free (format);
+}
+
+/* A sink that wants another format than the decoder's default still gets
+ * it without conversion if the decoder can output it. VideoToolbox decodes
+ * to NV12, the libav decoders only to the stream's own format. */
+- (void)testNativeFormatPassthroughNV12
+{
+    const gchar *names[] = { "vtdec_hw", "vtdec" };
+    const gchar *decoder = NULL;
+    gchar *format;
+    guint i;
+
+    for (i = 0; i < G_N_ELEMENTS (names) && !decoder; i++) {
+        gst_player_plugin_loader_ensure_feature (names[i]);
+        if (gst_registry_check_feature_version (gst_registry_get (), names[i],
+                0, 0, 0))
+            decoder = names[i];
+    }
+    if (!decoder) {
+        NSLog(@"No VideoToolbox decoder, nothing to test");
+        return;
+    }
+
+    format = [self negotiatedFormatWithSinkFormat:"NV12" decoder:decoder];
+    XCTAssertEqual (g_strcmp0 (format, "NV12"), 0);
+    g_free (format);
+}
+
+/* An element burning CPU time for every frame is charged that time, and
+ * not the elements it pushes to or gets buffers from */
+- (void)testElementStatsChargesBusyElement
+{
+    GstPlayer *player = [self newPlayer];
+    GstElement *pipeline = gst_player_get_pipeline (player);
+    GstElement *busy = gst_element_factory_make ("identity", "busy-filter");
+    GstStructure *stats;
+    const GValue *elements;
+    const GstStructure *top;
+    guint64 cpu_time = 0;
+
+    g_object_set (busy, "signal-handoffs", TRUE, NULL);
+    g_signal_connect (busy, "handoff", G_CALLBACK (busy_handoff_cb), NULL);
+    g_object_set (pipeline, "video-filter", busy, NULL);
+
+    gst_player_set_element_stats_enabled (player, TRUE);
+    gst_player_set_uri (player, [[GstPlayerTestCase mediaURIWithDuration:10] UTF8String]);
+    XCTAssertTrue ([self playUntilPlaying:player]);
+    [self runUntil:^BOOL { return NO; } timeout:3];
+
+    stats = gst_player_get_element_stats (player);
+    elements = gst_structure_get_value (stats, "elements");
+    XCTAssertGreaterThan (gst_value_array_get_size (elements), 1u);
+    top = gst_value_get_structure (gst_value_array_get_value (elements, 0));
+    gst_structure_get_uint64 (top, "cpu-time", &cpu_time);
+    XCTAssertEqual (g_strcmp0 (gst_structure_get_string (top, "name"), "busy-filter"), 0);
+    /* 30 frames per second for about 3 s */
+    XCTAssertGreaterThan (cpu_time, 500 * GST_MSECOND);
+    gst_structure_free (stats);
+
+    gst_player_stop (player);
+    gst_object_unref (pipeline);
+    g_object_unref (player);
+}
+
+/* Checks that every seek in the dump is intact and that each thread's seeks
+ * come in the order they were recorded. Returns the number of seeks. */
+- (guint)checkSeeksDump:(const gchar *)dump
+{
+    gint last[N_RECORDER_THREADS] = { -1, -1, -1, -1 };
+    gchar **lines = g_strsplit (dump, "\n", -1);
+    guint n = 0, i, h, m, s, ns, th, tm, ts, tns;
+    gdouble rate;
+    gint thread, index;
+
+    for (i = 0; lines[i]; i++) {
+        if (!*lines[i])
+            continue;
+        if (sscanf (lines[i], "%u:%u:%u.%u seek %u:%u:%u.%u rate %lf",
+                &h, &m, &s, &ns, &th, &tm, &ts, &tns, &rate) != 9) {
+            XCTFail (@"Malformed record: %s", lines[i]);
+            continue;
+        }
+        thread = tns % 16;
+        index = tns / 16;
+        if (th || tm || ts || thread >= N_RECORDER_THREADS
+                || (gint) (rate + 0.5) != thread) {
+            XCTFail (@"Torn record: %s", lines[i]);
+            continue;
+        }
+        if (index <= last[thread])
+            XCTFail (@"Record out of order: %s", lines[i]);
+        last[thread] = index;
+        n++;
+    }
+    g_strfreev (lines);
+
+    return n;
+}
+
+/* Dumping while several threads record only returns complete records, in
+ * the order each thread recorded them */
+- (void)testFlightRecorderConcurrentDump
+{
+    GstPlayerFlightRecorder *recorder = gst_player_flight_recorder_new ();
+    RecorderThreadData data[N_RECORDER_THREADS];
+    GThread *threads[N_RECORDER_THREADS];
+    guint i;
+    gchar *dump;
+
+    for (i = 0; i < N_RECORDER_THREADS; i++) {
+        data[i].recorder = recorder;
+        data[i].thread = i;
+        threads[i] = g_thread_new ("recorder", record_seeks_thread, &data[i]);
+    }
+
+    /* Dump while the threads are still running */
+    for (i = 0; i < 100; i++) {
+        dump = gst_player_flight_recorder_dump (recorder);
+        [self checkSeeksDump:dump];
+        g_free (dump);
+    }
+
+    for (i = 0; i < N_RECORDER_THREADS; i++)
+        g_thread_join (threads[i]);
+
+    /* All records fit into the ring */
+    dump = gst_player_flight_recorder_dump (recorder);
+    XCTAssertEqual ([self checkSeeksDump:dump],
+        (guint) (N_RECORDER_THREADS * N_THREAD_RECORDS));
+    g_free (dump);
+
+    gst_player_flight_recorder_free (recorder);
+}
+
+/* The events leading up to an error are available from the error handler,
+ * whatever the debug threshold */
+- (void)testErrorEventsInErrorHandler
+{
+    GstPlayer *player = [self newPlayer];
+    gchar *events = NULL;
+    gchar **events_p = &events;
+
+    XCTAssertTrue (gst_player_get_error_events (player) == NULL);
+
+    g_signal_connect (player, "error", G_CALLBACK (store_error_events_cb),
+        events_p);
+    gst_player_set_uri (player, "file:///nonexistent/clip.mp4");
+    gst_player_play (player);
+    XCTAssertTrue ([self runUntil:^BOOL {
+        return *events_p != NULL;
+    } timeout:10]);
+    XCTAssertTrue (events && strstr (events, "error ") != NULL);
+    g_free (events);
+
+    gst_player_stop (player);
+    g_object_unref (player);
+}
+
+/* Repeated global tags are ignored and bursts of changed ones are merged,
+ * so each only updates the media info once per interval */
+- (void)testGlobalTagUpdatesSuppressed
+{
+    GstPlayer *player = [self newPlayer];
+    GstElement *pipeline = gst_player_get_pipeline (player);
+    GstPlayerMediaInfo *info;
+    guint n_updates = 0, n_suppressed;
+    guint *n_updates_p = &n_updates;
+    gchar *title;
+    guint i;
+
+    gst_player_set_tag_update_interval (player, 250);
+    g_signal_connect (player, "media-info-updated",
+        G_CALLBACK (count_media_info_updated_cb), n_updates_p);
+    gst_player_set_uri (player, [[GstPlayerTestCase mediaURIWithDuration:30] UTF8String]);
+    XCTAssertTrue ([self playUntilPlaying:player]);
+
+    /* Let the clip's own tags and their update interval pass */
+    [self runUntil:^BOOL { return NO; } timeout:1];
+    n_updates = 0;
+    n_suppressed = get_tag_updates_suppressed (player);
+
+    /* The first tags are applied immediately, the repetitions ignored */
+    for (i = 0; i < 10; i++)
+        post_global_title (pipeline, "repeated");
+    XCTAssertTrue ([self runUntil:^BOOL {
+        return *n_updates_p >= 1;
+    } timeout:5]);
+    [self runUntil:^BOOL { return NO; } timeout:1];
+    XCTAssertEqual (n_updates, 1u);
+    XCTAssertEqual (get_tag_updates_suppressed (player) - n_suppressed, 9u);
+
+    /* The first tags of a burst are applied immediately, the last one after
+     * the interval and the ones in between are dropped */
+    n_updates = 0;
+    n_suppressed = get_tag_updates_suppressed (player);
+    for (i = 0; i < 10; i++) {
+        title = g_strdup_printf ("burst %u", i);
+        post_global_title (pipeline, title);
+        g_free (title);
+    }
+    XCTAssertTrue ([self runUntil:^BOOL {
+        return *n_updates_p >= 2;
+    } timeout:5]);
+    [self runUntil:^BOOL { return NO; } timeout:1];
+    XCTAssertEqual (n_updates, 2u);
+    XCTAssertEqual (get_tag_updates_suppressed (player) - n_suppressed, 8u);
+
+    info = gst_player_get_media_info (player);
+    XCTAssertEqual (g_strcmp0 (gst_player_media_info_get_title (info), "burst 9"), 0);
+    g_object_unref (info);
+
+    gst_player_stop (player);
+    gst_object_unref (pipeline);
+    g_object_unref (player);
+}
+
+@end
@@ -0,0 +1,42 @@
+/* GStreamer
+ *
+ * Copyright (C) 2015 Kim DaeHyun <jabiers87@gmail.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __GST_PLAYER_AUDIO_METER_PRIVATE_H__
+#define __GST_PLAYER_AUDIO_METER_PRIVATE_H__
+
+#include <gst/gst.h>
+#include <gst/audio/audio.h>
+
+typedef struct _GstPlayerAudioMeter GstPlayerAudioMeter;
+
+G_GNUC_INTERNAL GstPlayerAudioMeter * gst_player_audio_meter_new (void);
+G_GNUC_INTERNAL void gst_player_audio_meter_free (GstPlayerAudioMeter * meter);
+G_GNUC_INTERNAL gboolean gst_player_audio_meter_set_format (GstPlayerAudioMeter
+    * meter, const GstAudioInfo * info);
+G_GNUC_INTERNAL void gst_player_audio_meter_reset (GstPlayerAudioMeter *
+    meter);
+G_GNUC_INTERNAL void gst_player_audio_meter_process (GstPlayerAudioMeter *
+    meter, GstBuffer * buffer);
+G_GNUC_INTERNAL GstStructure *
+gst_player_audio_meter_take_levels (GstPlayerAudioMeter * meter);
+G_GNUC_INTERNAL GstClockTime
+gst_player_audio_meter_get_time (GstPlayerAudioMeter * meter);
+
+#endif
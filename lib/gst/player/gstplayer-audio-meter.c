@@ -0,0 +1,521 @@
+/* GStreamer
+ *
+ * Copyright (C) 2015 Kim DaeHyun <jabiers87@gmail.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/* Audio levels and loudness of decoded audio.
+ *
+ * Per channel the RMS and peak level over the interval since the levels
+ * were last taken are measured, plus a peak that holds for PEAK_TTL and
+ * then falls off by PEAK_FALLOFF dB per second, as VU meters show it.
+ * The short-term loudness follows EBU R128: the audio is K-weighted, its
+ * mean square is taken over blocks of 100 ms, and the loudness is that of
+ * the last 3 seconds of blocks, with surround channels weighted higher
+ * and LFE channels left out.
+ *
+ * Integer and double samples are converted to float first. RMS and peak
+ * are measured with SIMD on interleaved float samples if the channels
+ * evenly fill a vector, each lane then always holds the same channel. The
+ * K-weighting filters are recursive and run per sample.
+ */
+
+#include "gstplayer-audio-meter-private.h"
+
+#include <math.h>
+#include <string.h>
+
+#if defined(__ARM_NEON__) || defined(__ARM_NEON)
+#include <arm_neon.h>
+#define HAVE_NEON 1
+#elif defined(__SSE__)
+#include <xmmintrin.h>
+#define HAVE_SSE 1
+#endif
+
+/* Reported for silence */
+#define MIN_DB -120.0
+#define PEAK_TTL (300 * GST_MSECOND)
+#define PEAK_FALLOFF 20.0
+/* Loudness blocks, 30 of 100 ms make up the 3 s short-term window */
+#define BLOCKS_PER_SECOND 10
+#define N_BLOCKS 30
+/* Samples per lane summed in float before adding to the double sums */
+#define CHUNK_SIZE 1024
+#define MAX_CHANNELS 64
+
+typedef struct
+{
+  /* Current interval */
+  gdouble sumsq;
+  gfloat peak;
+
+  gdouble decay_db;
+  GstClockTime decay_age;
+
+  /* K-weighting filter state, two biquads in transposed direct form II */
+  gdouble weight;
+  gdouble z[4];
+  gdouble block_sumsq;
+} Channel;
+
+struct _GstPlayerAudioMeter
+{
+  GMutex lock;
+
+  GstAudioFormat format;
+  gint channels, rate, bpf;
+  gboolean supported;
+  Channel *channel;
+  gfloat *scratch;
+  gsize scratch_size;
+
+  guint64 n_frames;
+  GstClockTime last_take;
+
+  /* K-weighting: high shelf followed by a high pass */
+  gdouble shelf_b[3], shelf_a[3];
+  gdouble hp_b[3], hp_a[3];
+
+  guint block_frames, block_pos;
+  gdouble blocks[N_BLOCKS];
+  guint n_blocks, block_index;
+
+  GstClockTime process_time;
+};
+
+/* Adds the squares and the maximum of the absolute values of @n interleaved
+ * samples of @channels channels to @sumsq and @peak */
+static void
+measure (const gfloat * data, guint n, gint channels, gdouble * sumsq,
+    gfloat * peak)
+{
+  guint i = 0;
+  gint c;
+
+#if defined(HAVE_NEON) || defined(HAVE_SSE)
+  if (channels == 1 || channels == 2 || channels == 4) {
+    gfloat lane_sumsq[4], lane_peak[4];
+    gint l;
+
+    while (i + 4 <= n) {
+      guint end = MIN (n - (n - i) % 4, i + 4 * CHUNK_SIZE);
+#if defined(HAVE_NEON)
+      float32x4_t acc = vdupq_n_f32 (0.0f), max = vdupq_n_f32 (0.0f);
+
+      for (; i < end; i += 4) {
+        float32x4_t v = vld1q_f32 (data + i);
+
+        acc = vmlaq_f32 (acc, v, v);
+        max = vmaxq_f32 (max, vabsq_f32 (v));
+      }
+      vst1q_f32 (lane_sumsq, acc);
+      vst1q_f32 (lane_peak, max);
+#else
+      const __m128 sign = _mm_set1_ps (-0.0f);
+      __m128 acc = _mm_setzero_ps (), max = _mm_setzero_ps ();
+
+      for (; i < end; i += 4) {
+        __m128 v = _mm_loadu_ps (data + i);
+
+        acc = _mm_add_ps (acc, _mm_mul_ps (v, v));
+        max = _mm_max_ps (max, _mm_andnot_ps (sign, v));
+      }
+      _mm_storeu_ps (lane_sumsq, acc);
+      _mm_storeu_ps (lane_peak, max);
+#endif
+      for (l = 0; l < 4; l++) {
+        sumsq[l % channels] += lane_sumsq[l];
+        peak[l % channels] = MAX (peak[l % channels], lane_peak[l]);
+      }
+    }
+  }
+#endif
+
+  /* Vectors end on a frame boundary, so @i is at channel 0 here */
+  for (c = 0; i < n; i++) {
+    gfloat v = data[i];
+
+    sumsq[c] += v * v;
+    peak[c] = MAX (peak[c], fabsf (v));
+    if (++c == channels)
+      c = 0;
+  }
+}
+
+static inline gdouble
+biquad (const gdouble * b, const gdouble * a, gdouble * z, gdouble x)
+{
+  gdouble y = b[0] * x + z[0];
+
+  z[0] = b[1] * x - a[1] * y + z[1];
+  z[1] = b[2] * x - a[2] * y;
+
+  return y;
+}
+
+static void
+k_weight (GstPlayerAudioMeter * meter, const gfloat * data, guint n_frames)
+{
+  guint f, remaining;
+  gint c;
+
+  while (n_frames > 0) {
+    remaining = MIN (n_frames, meter->block_frames - meter->block_pos);
+
+    for (c = 0; c < meter->channels; c++) {
+      Channel *ch = &meter->channel[c];
+      const gfloat *s = data + c;
+      gdouble sum = 0.0, y;
+
+      if (ch->weight == 0.0)
+        continue;
+
+      for (f = 0; f < remaining; f++, s += meter->channels) {
+        y = biquad (meter->shelf_b, meter->shelf_a, ch->z, *s);
+        y = biquad (meter->hp_b, meter->hp_a, ch->z + 2, y);
+        sum += y * y;
+      }
+      ch->block_sumsq += sum;
+    }
+
+    data += remaining * meter->channels;
+    n_frames -= remaining;
+    meter->block_pos += remaining;
+
+    if (meter->block_pos == meter->block_frames) {
+      gdouble power = 0.0;
+
+      for (c = 0; c < meter->channels; c++) {
+        Channel *ch = &meter->channel[c];
+
+        power += ch->weight * ch->block_sumsq / meter->block_frames;
+        ch->block_sumsq = 0.0;
+      }
+      meter->blocks[meter->block_index] = power;
+      meter->block_index = (meter->block_index + 1) % N_BLOCKS;
+      meter->n_blocks = MIN (meter->n_blocks + 1, N_BLOCKS);
+      meter->block_pos = 0;
+    }
+  }
+}
+
+/* Filter coefficients of ITU-R BS.1770 for any sample rate */
+static void
+set_k_weighting (GstPlayerAudioMeter * meter)
+{
+  gdouble f0, q, k, vh, vb, a0;
+
+  f0 = 1681.974450955533;
+  q = 0.7071752369554196;
+  k = tan (G_PI * f0 / meter->rate);
+  vh = pow (10.0, 3.999843853973347 / 20.0);
+  vb = pow (vh, 0.4996667741545416);
+  a0 = 1.0 + k / q + k * k;
+  meter->shelf_b[0] = (vh + vb * k / q + k * k) / a0;
+  meter->shelf_b[1] = 2.0 * (k * k - vh) / a0;
+  meter->shelf_b[2] = (vh - vb * k / q + k * k) / a0;
+  meter->shelf_a[0] = 1.0;
+  meter->shelf_a[1] = 2.0 * (k * k - 1.0) / a0;
+  meter->shelf_a[2] = (1.0 - k / q + k * k) / a0;
+
+  f0 = 38.13547087602444;
+  q = 0.5003270373238773;
+  k = tan (G_PI * f0 / meter->rate);
+  a0 = 1.0 + k / q + k * k;
+  meter->hp_b[0] = 1.0;
+  meter->hp_b[1] = -2.0;
+  meter->hp_b[2] = 1.0;
+  meter->hp_a[0] = 1.0;
+  meter->hp_a[1] = 2.0 * (k * k - 1.0) / a0;
+  meter->hp_a[2] = (1.0 - k / q + k * k) / a0;
+}
+
+static gdouble
+channel_weight (const GstAudioInfo * info, gint channel)
+{
+  if (GST_AUDIO_INFO_IS_UNPOSITIONED (info))
+    return 1.0;
+
+  switch (GST_AUDIO_INFO_POSITION (info, channel)) {
+    case GST_AUDIO_CHANNEL_POSITION_LFE1:
+    case GST_AUDIO_CHANNEL_POSITION_LFE2:
+      return 0.0;
+    case GST_AUDIO_CHANNEL_POSITION_REAR_LEFT:
+    case GST_AUDIO_CHANNEL_POSITION_REAR_RIGHT:
+    case GST_AUDIO_CHANNEL_POSITION_SIDE_LEFT:
+    case GST_AUDIO_CHANNEL_POSITION_SIDE_RIGHT:
+      return 1.41;
+    default:
+      return 1.0;
+  }
+}
+
+static void
+reset_locked (GstPlayerAudioMeter * meter)
+{
+  gint c;
+
+  for (c = 0; c < meter->channels; c++) {
+    Channel *ch = &meter->channel[c];
+
+    ch->sumsq = 0.0;
+    ch->peak = 0.0f;
+    ch->decay_db = MIN_DB;
+    ch->decay_age = 0;
+    memset (ch->z, 0, sizeof (ch->z));
+    ch->block_sumsq = 0.0;
+  }
+  meter->n_frames = 0;
+  meter->last_take = GST_CLOCK_TIME_NONE;
+  meter->block_pos = 0;
+  meter->n_blocks = 0;
+  meter->block_index = 0;
+}
+
+static gdouble
+to_db (gdouble power)
+{
+  return power > 0.0 ? MAX (10.0 * log10 (power), MIN_DB) : MIN_DB;
+}
+
+static void
+append_double (GValue * array, gdouble value)
+{
+  GValue v = G_VALUE_INIT;
+
+  g_value_init (&v, G_TYPE_DOUBLE);
+  g_value_set_double (&v, value);
+  gst_value_array_append_value (array, &v);
+  g_value_unset (&v);
+}
+
+GstPlayerAudioMeter *
+gst_player_audio_meter_new (void)
+{
+  GstPlayerAudioMeter *meter = g_new0 (GstPlayerAudioMeter, 1);
+
+  g_mutex_init (&meter->lock);
+  meter->last_take = GST_CLOCK_TIME_NONE;
+
+  return meter;
+}
+
+void
+gst_player_audio_meter_free (GstPlayerAudioMeter * meter)
+{
+  g_mutex_clear (&meter->lock);
+  g_free (meter->channel);
+  g_free (meter->scratch);
+  g_free (meter);
+}
+
+/* Returns FALSE if the format can't be measured, buffers are ignored then */
+gboolean
+gst_player_audio_meter_set_format (GstPlayerAudioMeter * meter,
+    const GstAudioInfo * info)
+{
+  gboolean supported;
+  gint c;
+
+  g_mutex_lock (&meter->lock);
+  meter->format = GST_AUDIO_INFO_FORMAT (info);
+  meter->supported = (meter->format == GST_AUDIO_FORMAT_S16
+      || meter->format == GST_AUDIO_FORMAT_S32
+      || meter->format == GST_AUDIO_FORMAT_F32
+      || meter->format == GST_AUDIO_FORMAT_F64)
+      && GST_AUDIO_INFO_CHANNELS (info) > 0
+      && GST_AUDIO_INFO_CHANNELS (info) <= MAX_CHANNELS
+      && GST_AUDIO_INFO_RATE (info) > 0;
+
+  if (meter->supported) {
+    meter->channels = GST_AUDIO_INFO_CHANNELS (info);
+    meter->rate = GST_AUDIO_INFO_RATE (info);
+    meter->bpf = GST_AUDIO_INFO_BPF (info);
+    meter->block_frames = MAX (meter->rate / BLOCKS_PER_SECOND, 1);
+    g_free (meter->channel);
+    meter->channel = g_new0 (Channel, meter->channels);
+    for (c = 0; c < meter->channels; c++)
+      meter->channel[c].weight = channel_weight (info, c);
+    set_k_weighting (meter);
+  } else {
+    meter->channels = 0;
+  }
+  supported = meter->supported;
+  reset_locked (meter);
+  g_mutex_unlock (&meter->lock);
+
+  return supported;
+}
+
+/* Forgets the audio so far, e.g. after a flush */
+void
+gst_player_audio_meter_reset (GstPlayerAudioMeter * meter)
+{
+  g_mutex_lock (&meter->lock);
+  reset_locked (meter);
+  g_mutex_unlock (&meter->lock);
+}
+
+void
+gst_player_audio_meter_process (GstPlayerAudioMeter * meter,
+    GstBuffer * buffer)
+{
+  GstClockTime start = gst_util_get_timestamp ();
+  gdouble sumsq[MAX_CHANNELS];
+  gfloat peak[MAX_CHANNELS];
+  const gfloat *data;
+  GstMapInfo map;
+  guint n_frames, n, i;
+  gint c;
+
+  if (!gst_buffer_map (buffer, &map, GST_MAP_READ))
+    return;
+
+  g_mutex_lock (&meter->lock);
+  if (!meter->supported)
+    goto done;
+
+  n_frames = map.size / meter->bpf;
+  n = n_frames * meter->channels;
+  if (n == 0)
+    goto done;
+
+  if (meter->format == GST_AUDIO_FORMAT_F32) {
+    data = (const gfloat *) map.data;
+  } else {
+    if (meter->scratch_size < n) {
+      g_free (meter->scratch);
+      meter->scratch = g_new (gfloat, n);
+      meter->scratch_size = n;
+    }
+    if (meter->format == GST_AUDIO_FORMAT_S16) {
+      const gint16 *s = (const gint16 *) map.data;
+
+      for (i = 0; i < n; i++)
+        meter->scratch[i] = s[i] * (1.0f / 32768.0f);
+    } else if (meter->format == GST_AUDIO_FORMAT_S32) {
+      const gint32 *s = (const gint32 *) map.data;
+
+      for (i = 0; i < n; i++)
+        meter->scratch[i] = s[i] * (1.0f / 2147483648.0f);
+    } else {
+      const gdouble *s = (const gdouble *) map.data;
+
+      for (i = 0; i < n; i++)
+        meter->scratch[i] = s[i];
+    }
+    data = meter->scratch;
+  }
+
+  for (c = 0; c < meter->channels; c++) {
+    sumsq[c] = meter->channel[c].sumsq;
+    peak[c] = meter->channel[c].peak;
+  }
+  measure (data, n, meter->channels, sumsq, peak);
+  for (c = 0; c < meter->channels; c++) {
+    meter->channel[c].sumsq = sumsq[c];
+    meter->channel[c].peak = peak[c];
+  }
+  meter->n_frames += n_frames;
+
+  k_weight (meter, data, n_frames);
+
+  meter->process_time += gst_util_get_timestamp () - start;
+
+done:
+  g_mutex_unlock (&meter->lock);
+  gst_buffer_unmap (buffer, &map);
+}
+
+/* Returns the levels since the last call, or NULL if there was no audio */
+GstStructure *
+gst_player_audio_meter_take_levels (GstPlayerAudioMeter * meter)
+{
+  GValue rms = G_VALUE_INIT, peak = G_VALUE_INIT, decay = G_VALUE_INIT;
+  GstStructure *levels;
+  GstClockTime now, elapsed;
+  gdouble power = 0.0;
+  guint i;
+  gint c;
+
+  g_mutex_lock (&meter->lock);
+  if (meter->n_frames == 0) {
+    g_mutex_unlock (&meter->lock);
+    return NULL;
+  }
+
+  now = gst_util_get_timestamp ();
+  elapsed = GST_CLOCK_TIME_IS_VALID (meter->last_take) ?
+      now - meter->last_take : 0;
+  meter->last_take = now;
+
+  g_value_init (&rms, GST_TYPE_ARRAY);
+  g_value_init (&peak, GST_TYPE_ARRAY);
+  g_value_init (&decay, GST_TYPE_ARRAY);
+
+  for (c = 0; c < meter->channels; c++) {
+    Channel *ch = &meter->channel[c];
+    gdouble peak_db = to_db ((gdouble) ch->peak * ch->peak);
+
+    if (peak_db >= ch->decay_db) {
+      ch->decay_db = peak_db;
+      ch->decay_age = 0;
+    } else {
+      ch->decay_age += elapsed;
+      if (ch->decay_age > PEAK_TTL)
+        ch->decay_db = MAX (ch->decay_db -
+            PEAK_FALLOFF * elapsed / (gdouble) GST_SECOND, peak_db);
+    }
+
+    append_double (&rms, to_db (ch->sumsq / meter->n_frames));
+    append_double (&peak, peak_db);
+    append_double (&decay, ch->decay_db);
+
+    ch->sumsq = 0.0;
+    ch->peak = 0.0f;
+  }
+  meter->n_frames = 0;
+
+  for (i = 0; i < meter->n_blocks; i++)
+    power += meter->blocks[i];
+
+  levels = gst_structure_new ("audio-level",
+      "channels", G_TYPE_INT, meter->channels,
+      "loudness", G_TYPE_DOUBLE, meter->n_blocks > 0 && power > 0.0 ?
+      MAX (-0.691 + 10.0 * log10 (power / meter->n_blocks), MIN_DB) : MIN_DB,
+      NULL);
+  gst_structure_take_value (levels, "rms", &rms);
+  gst_structure_take_value (levels, "peak", &peak);
+  gst_structure_take_value (levels, "decay", &decay);
+  g_mutex_unlock (&meter->lock);
+
+  return levels;
+}
+
+/* Total time spent measuring */
+GstClockTime
+gst_player_audio_meter_get_time (GstPlayerAudioMeter * meter)
+{
+  GstClockTime time;
+
+  g_mutex_lock (&meter->lock);
+  time = meter->process_time;
+  g_mutex_unlock (&meter->lock);
+
+  return time;
+}
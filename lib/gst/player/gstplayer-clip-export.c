@@ -0,0 +1,1250 @@
+/* GStreamer
+ *
+ * Copyright (C) 2015 Kim DaeHyun <jabiers87@gmail.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/**
+ * SECTION:gstplayer-clip-export
+ * @short_description: GStreamer Player Clip Export API
+ *
+ * A #GstPlayerClipExport saves a time range of a stream to a file without
+ * decoding and encoding it, on a pipeline of its own that does not affect
+ * playback.
+ *
+ * H.264 video can only be cut at keyframes when it is copied. By default
+ * the clip then starts at the keyframe before the requested start. When
+ * writing MPEG-TS the frames between the requested start and the next
+ * keyframe are re-encoded instead and everything after that is copied
+ * (smart cut). Other containers can't switch to the parameter sets of the
+ * encoder within the stream, so they always start at a keyframe.
+ */
+
+#include "gstplayer-clip-export.h"
+#include "gstplayer.h"
+#include "gstplayer-plugin-loader.h"
+
+#include <glib/gstdio.h>
+
+#include <string.h>
+
+GST_DEBUG_CATEGORY_STATIC (gst_player_clip_export_debug);
+#define GST_CAT_DEFAULT gst_player_clip_export_debug
+
+#define DEFAULT_SMART_CUT TRUE
+#define DEFAULT_AUDIO TRUE
+
+/* A start this close after a keyframe counts as aligned to it */
+#define KEYFRAME_TOLERANCE (20 * GST_MSECOND)
+#define PROGRESS_INTERVAL_MS 250
+
+/* Encoded formats that are copied, decodebin plugs parsers until the
+ * streams match them */
+#define EXPORT_CAPS "video/x-h264, parsed = (boolean) true; " \
+    "audio/mpeg, framed = (boolean) true; " \
+    "audio/mpeg, parsed = (boolean) true"
+
+enum
+{
+  PROP_0,
+  PROP_URI,
+  PROP_DEST,
+  PROP_START,
+  PROP_STOP,
+  PROP_OPTIONS,
+  PROP_PROGRESS,
+  PROP_LAST
+};
+
+enum
+{
+  SIGNAL_PROGRESS,
+  SIGNAL_DONE,
+  SIGNAL_ERROR,
+  SIGNAL_LAST
+};
+
+typedef struct
+{
+  GstPad *pad;
+  gulong probe_id;
+} BlockedPad;
+
+typedef enum
+{
+  CUT_UNKNOWN,
+  CUT_COPY,
+  CUT_ENCODE,
+} CutState;
+
+struct _GstPlayerClipExport
+{
+  GstObject parent;
+
+  gchar *uri;
+  gchar *dest;
+  GstClockTime start, stop;
+  gboolean smart_cut_allowed;
+  gboolean audio;
+
+  /* Signals are emitted here */
+  GMainContext *application_context;
+
+  GThread *thread;
+  GMutex lock;
+  GCond cond;
+  GMainContext *context;
+  GMainLoop *loop;
+
+  GstElement *pipeline;
+  GstElement *source;
+  GstElement *mux;
+  gboolean smart_cut_possible;
+  /* Only used from export thread */
+  GSource *progress_source;
+  gboolean started;
+
+  /* Protected by lock */
+  GList *blocked_pads;
+  gboolean cancelled, finished;
+  gdouble progress;
+  GstClockTime position;
+  GstClockTime clip_start;
+  gboolean smart_cut;
+
+  /* Video cut, protected by lock */
+  CutState cut_state;
+  GstClockTime keyframe;
+  GstPad *encode_pad;           /* Sink pad of the encoding branch */
+  gboolean encoder_eos_sent;
+  BlockedPad copy_blocked;      /* Copied frames wait for the encoder */
+};
+
+struct _GstPlayerClipExportClass
+{
+  GstObjectClass parent_class;
+};
+
+#define parent_class gst_player_clip_export_parent_class
+G_DEFINE_TYPE (GstPlayerClipExport, gst_player_clip_export, GST_TYPE_OBJECT);
+
+static GParamSpec *param_specs[PROP_LAST] = { NULL, };
+static guint signals[SIGNAL_LAST] = { 0, };
+
+static void gst_player_clip_export_dispose (GObject * object);
+static void gst_player_clip_export_finalize (GObject * object);
+static void gst_player_clip_export_set_property (GObject * object,
+    guint prop_id, const GValue * value, GParamSpec * pspec);
+static void gst_player_clip_export_get_property (GObject * object,
+    guint prop_id, GValue * value, GParamSpec * pspec);
+static void gst_player_clip_export_constructed (GObject * object);
+
+static gpointer gst_player_clip_export_main (gpointer data);
+
+static void
+gst_player_clip_export_init (GstPlayerClipExport * self)
+{
+  g_mutex_init (&self->lock);
+  g_cond_init (&self->cond);
+
+  self->context = g_main_context_new ();
+  self->loop = g_main_loop_new (self->context, FALSE);
+  self->application_context = g_main_context_ref_thread_default ();
+
+  self->start = 0;
+  self->stop = GST_CLOCK_TIME_NONE;
+  self->smart_cut_allowed = DEFAULT_SMART_CUT;
+  self->audio = DEFAULT_AUDIO;
+  self->position = GST_CLOCK_TIME_NONE;
+  self->clip_start = GST_CLOCK_TIME_NONE;
+  self->keyframe = GST_CLOCK_TIME_NONE;
+}
+
+static void
+gst_player_clip_export_class_init (GstPlayerClipExportClass * klass)
+{
+  GObjectClass *gobject_class = (GObjectClass *) klass;
+
+  gobject_class->set_property = gst_player_clip_export_set_property;
+  gobject_class->get_property = gst_player_clip_export_get_property;
+  gobject_class->dispose = gst_player_clip_export_dispose;
+  gobject_class->finalize = gst_player_clip_export_finalize;
+  gobject_class->constructed = gst_player_clip_export_constructed;
+
+  param_specs[PROP_URI] =
+      g_param_spec_string ("uri", "URI", "URI of the exported stream",
+      NULL, G_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY |
+      G_PARAM_STATIC_STRINGS);
+
+  param_specs[PROP_DEST] =
+      g_param_spec_string ("dest", "Destination",
+      "File the clip is written to, the extension selects the container",
+      NULL, G_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY |
+      G_PARAM_STATIC_STRINGS);
+
+  param_specs[PROP_START] =
+      g_param_spec_uint64 ("start", "Start", "Start of the clip",
+      0, G_MAXUINT64, 0, G_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY |
+      G_PARAM_STATIC_STRINGS);
+
+  param_specs[PROP_STOP] =
+      g_param_spec_uint64 ("stop", "Stop",
+      "End of the clip, GST_CLOCK_TIME_NONE for the end of the stream",
+      0, G_MAXUINT64, GST_CLOCK_TIME_NONE,
+      G_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY | G_PARAM_STATIC_STRINGS);
+
+  param_specs[PROP_OPTIONS] =
+      g_param_spec_boxed ("options", "Options", "Export options",
+      GST_TYPE_STRUCTURE, G_PARAM_WRITABLE | G_PARAM_CONSTRUCT_ONLY |
+      G_PARAM_STATIC_STRINGS);
+
+  param_specs[PROP_PROGRESS] =
+      g_param_spec_double ("progress", "Progress",
+      "Exported part of the clip", 0.0, 1.0, 0.0,
+      G_PARAM_READABLE | G_PARAM_STATIC_STRINGS);
+
+  g_object_class_install_properties (gobject_class, PROP_LAST, param_specs);
+
+  signals[SIGNAL_PROGRESS] =
+      g_signal_new ("progress", G_TYPE_FROM_CLASS (klass),
+      G_SIGNAL_RUN_LAST | G_SIGNAL_NO_RECURSE | G_SIGNAL_NO_HOOKS, 0, NULL,
+      NULL, NULL, G_TYPE_NONE, 1, G_TYPE_DOUBLE);
+
+  signals[SIGNAL_DONE] =
+      g_signal_new ("done", G_TYPE_FROM_CLASS (klass),
+      G_SIGNAL_RUN_LAST | G_SIGNAL_NO_RECURSE | G_SIGNAL_NO_HOOKS, 0, NULL,
+      NULL, NULL, G_TYPE_NONE, 0, G_TYPE_INVALID);
+
+  signals[SIGNAL_ERROR] =
+      g_signal_new ("error", G_TYPE_FROM_CLASS (klass),
+      G_SIGNAL_RUN_LAST | G_SIGNAL_NO_RECURSE | G_SIGNAL_NO_HOOKS, 0, NULL,
+      NULL, NULL, G_TYPE_NONE, 1, G_TYPE_ERROR);
+}
+
+static void
+gst_player_clip_export_dispose (GObject * object)
+{
+  GstPlayerClipExport *self = GST_PLAYER_CLIP_EXPORT (object);
+
+  if (self->loop) {
+    g_mutex_lock (&self->lock);
+    if (!self->finished)
+      self->cancelled = TRUE;
+    g_cond_broadcast (&self->cond);
+    g_mutex_unlock (&self->lock);
+
+    g_main_loop_quit (self->loop);
+
+    g_thread_join (self->thread);
+    self->thread = NULL;
+
+    g_main_loop_unref (self->loop);
+    self->loop = NULL;
+
+    g_main_context_unref (self->context);
+    self->context = NULL;
+  }
+
+  G_OBJECT_CLASS (parent_class)->dispose (object);
+}
+
+static void
+blocked_pad_free (BlockedPad * blocked)
+{
+  gst_object_unref (blocked->pad);
+  g_free (blocked);
+}
+
+static void
+gst_player_clip_export_finalize (GObject * object)
+{
+  GstPlayerClipExport *self = GST_PLAYER_CLIP_EXPORT (object);
+
+  g_free (self->uri);
+  g_free (self->dest);
+  g_list_free_full (self->blocked_pads, (GDestroyNotify) blocked_pad_free);
+  if (self->encode_pad)
+    gst_object_unref (self->encode_pad);
+  if (self->copy_blocked.pad)
+    gst_object_unref (self->copy_blocked.pad);
+  if (self->pipeline)
+    gst_object_unref (self->pipeline);
+  g_main_context_unref (self->application_context);
+  g_mutex_clear (&self->lock);
+  g_cond_clear (&self->cond);
+
+  G_OBJECT_CLASS (parent_class)->finalize (object);
+}
+
+typedef struct
+{
+  GstPlayerClipExport *clip_export;
+  guint signal;
+  gdouble progress;
+  GError *err;
+} ExportSignalData;
+
+static gboolean
+emit_signal_cb (gpointer user_data)
+{
+  ExportSignalData *data = user_data;
+  gboolean cancelled;
+
+  g_mutex_lock (&data->clip_export->lock);
+  cancelled = data->clip_export->cancelled;
+  g_mutex_unlock (&data->clip_export->lock);
+
+  if (cancelled)
+    return G_SOURCE_REMOVE;
+
+  if (data->signal == SIGNAL_PROGRESS) {
+    g_signal_emit (data->clip_export, signals[SIGNAL_PROGRESS], 0,
+        data->progress);
+    g_object_notify_by_pspec (G_OBJECT (data->clip_export),
+        param_specs[PROP_PROGRESS]);
+  } else if (data->signal == SIGNAL_DONE) {
+    g_signal_emit (data->clip_export, signals[SIGNAL_DONE], 0);
+  } else {
+    g_signal_emit (data->clip_export, signals[SIGNAL_ERROR], 0, data->err);
+  }
+
+  return G_SOURCE_REMOVE;
+}
+
+static void
+export_signal_data_free (ExportSignalData * data)
+{
+  g_object_unref (data->clip_export);
+  if (data->err)
+    g_error_free (data->err);
+  g_free (data);
+}
+
+/* Signals always go through the application context, also when that is
+ * free to be acquired from here, so that handlers can still be connected
+ * after gst_player_export_clip() returned */
+static void
+emit_signal (GstPlayerClipExport * self, guint signal, gdouble progress,
+    GError * err)
+{
+  ExportSignalData *data = g_new0 (ExportSignalData, 1);
+  GSource *source;
+
+  data->clip_export = g_object_ref (self);
+  data->signal = signal;
+  data->progress = progress;
+  data->err = err;
+
+  source = g_idle_source_new ();
+  g_source_set_priority (source, G_PRIORITY_DEFAULT);
+  g_source_set_callback (source, emit_signal_cb, data,
+      (GDestroyNotify) export_signal_data_free);
+  g_source_attach (source, self->application_context);
+  g_source_unref (source);
+}
+
+static const gchar *
+mux_factory_for_dest (const gchar * dest, gboolean * smart_cut_possible)
+{
+  gchar *lower = g_ascii_strdown (dest, -1);
+  const gchar *factory = "mp4mux";
+
+  *smart_cut_possible = FALSE;
+  if (g_str_has_suffix (lower, ".ts") || g_str_has_suffix (lower, ".m2ts")
+      || g_str_has_suffix (lower, ".mts")) {
+    /* Takes H.264 with the parameter sets in the stream, so the encoded
+     * frames can use different ones than the copied frames */
+    factory = "mpegtsmux";
+    *smart_cut_possible = TRUE;
+  } else if (g_str_has_suffix (lower, ".flv")) {
+    factory = "flvmux";
+  } else if (g_str_has_suffix (lower, ".mov")) {
+    factory = "qtmux";
+  }
+  g_free (lower);
+
+  return factory;
+}
+
+static void
+update_position (GstPlayerClipExport * self, GstBuffer * buffer)
+{
+  GstClockTime pts = GST_BUFFER_PTS (buffer);
+
+  if (!GST_CLOCK_TIME_IS_VALID (pts))
+    return;
+
+  g_mutex_lock (&self->lock);
+  if (!GST_CLOCK_TIME_IS_VALID (self->position) || pts > self->position)
+    self->position = pts;
+  g_mutex_unlock (&self->lock);
+}
+
+/* Called with lock, with the first video buffer after the seek. Smart cut
+ * is only possible if the encoding branch could be created */
+static void
+decide_cut_locked (GstPlayerClipExport * self, GstBuffer * buffer)
+{
+  GstClockTime pts = GST_BUFFER_PTS (buffer);
+
+  self->keyframe = pts;
+  if (self->encode_pad && GST_CLOCK_TIME_IS_VALID (pts)
+      && pts + KEYFRAME_TOLERANCE < self->start) {
+    GST_DEBUG_OBJECT (self, "Keyframe at %" GST_TIME_FORMAT
+        " before start, re-encoding until the next one", GST_TIME_ARGS (pts));
+    self->cut_state = CUT_ENCODE;
+    self->clip_start = self->start;
+    self->smart_cut = TRUE;
+  } else {
+    GST_DEBUG_OBJECT (self, "Copying from keyframe at %" GST_TIME_FORMAT,
+        GST_TIME_ARGS (pts));
+    self->cut_state = CUT_COPY;
+    self->clip_start = pts;
+  }
+}
+
+static gboolean
+is_next_keyframe_locked (GstPlayerClipExport * self, GstBuffer * buffer)
+{
+  return !GST_BUFFER_FLAG_IS_SET (buffer, GST_BUFFER_FLAG_DELTA_UNIT)
+      && GST_BUFFER_PTS_IS_VALID (buffer)
+      && GST_BUFFER_PTS (buffer) > self->keyframe;
+}
+
+/* Ends the encoded part. The copied frames stay blocked behind the copy
+ * queue until the EOS passed the encoder, so this thread never waits and
+ * the muxer keeps getting data */
+static void
+drain_encoder (GstPlayerClipExport * self, GstPad * encode_pad)
+{
+  GST_DEBUG_OBJECT (self, "Draining encoder");
+  gst_pad_send_event (encode_pad, gst_event_new_eos ());
+}
+
+static GstPadProbeReturn
+copy_probe_cb (GstPad * pad, GstPadProbeInfo * info, gpointer user_data)
+{
+  GstPlayerClipExport *self = GST_PLAYER_CLIP_EXPORT (user_data);
+  GstBuffer *buffer = GST_PAD_PROBE_INFO_BUFFER (info);
+  GstPad *encode_pad = NULL;
+  gboolean drop = FALSE;
+
+  g_mutex_lock (&self->lock);
+  if (self->cut_state == CUT_UNKNOWN)
+    decide_cut_locked (self, buffer);
+  if (self->cut_state == CUT_ENCODE) {
+    if (is_next_keyframe_locked (self, buffer))
+      self->cut_state = CUT_COPY;
+    else
+      drop = TRUE;
+  }
+  if (self->cut_state == CUT_COPY && self->encode_pad
+      && !self->encoder_eos_sent) {
+    self->encoder_eos_sent = TRUE;
+    encode_pad = gst_object_ref (self->encode_pad);
+  }
+  g_mutex_unlock (&self->lock);
+
+  if (encode_pad) {
+    drain_encoder (self, encode_pad);
+    gst_object_unref (encode_pad);
+  }
+
+  if (drop)
+    return GST_PAD_PROBE_DROP;
+
+  update_position (self, buffer);
+
+  return GST_PAD_PROBE_OK;
+}
+
+static GstPadProbeReturn
+encode_probe_cb (GstPad * pad, GstPadProbeInfo * info, gpointer user_data)
+{
+  GstPlayerClipExport *self = GST_PLAYER_CLIP_EXPORT (user_data);
+  GstBuffer *buffer = GST_PAD_PROBE_INFO_BUFFER (info);
+  gboolean pass;
+
+  /* tee might push here first, decide the same way as for the copy */
+  g_mutex_lock (&self->lock);
+  if (self->cut_state == CUT_UNKNOWN)
+    decide_cut_locked (self, buffer);
+  pass = self->cut_state == CUT_ENCODE
+      && !is_next_keyframe_locked (self, buffer);
+  g_mutex_unlock (&self->lock);
+
+  return pass ? GST_PAD_PROBE_OK : GST_PAD_PROBE_DROP;
+}
+
+/* Decoding has to start at the keyframe, encoding at the requested start */
+static GstPadProbeReturn
+encoder_clip_probe_cb (GstPad * pad, GstPadProbeInfo * info,
+    gpointer user_data)
+{
+  GstPlayerClipExport *self = GST_PLAYER_CLIP_EXPORT (user_data);
+  GstBuffer *buffer = GST_PAD_PROBE_INFO_BUFFER (info);
+
+  if (GST_BUFFER_PTS_IS_VALID (buffer)
+      && GST_BUFFER_PTS (buffer) < self->start)
+    return GST_PAD_PROBE_DROP;
+
+  update_position (self, buffer);
+
+  return GST_PAD_PROBE_OK;
+}
+
+static GstPadProbeReturn
+encoder_eos_probe_cb (GstPad * pad, GstPadProbeInfo * info,
+    gpointer user_data)
+{
+  GstPlayerClipExport *self = GST_PLAYER_CLIP_EXPORT (user_data);
+  GstEvent *event = GST_PAD_PROBE_INFO_EVENT (info);
+
+  if (GST_EVENT_TYPE (event) != GST_EVENT_EOS)
+    return GST_PAD_PROBE_OK;
+
+  GST_DEBUG_OBJECT (self, "Encoder drained, copying");
+  g_mutex_lock (&self->lock);
+  if (self->copy_blocked.probe_id) {
+    gst_pad_remove_probe (self->copy_blocked.pad, self->copy_blocked.probe_id);
+    self->copy_blocked.probe_id = 0;
+  }
+  g_mutex_unlock (&self->lock);
+
+  /* funnel only forwards EOS once the copied frames ended too */
+  return GST_PAD_PROBE_OK;
+}
+
+static GstPadProbeReturn
+audio_probe_cb (GstPad * pad, GstPadProbeInfo * info, gpointer user_data)
+{
+  GstPlayerClipExport *self = GST_PLAYER_CLIP_EXPORT (user_data);
+  GstBuffer *buffer = GST_PAD_PROBE_INFO_BUFFER (info);
+  GstClockTime end;
+
+  /* With smart cut the clip starts exactly at the requested start,
+   * otherwise at the keyframe the demuxer seeked to */
+  if (self->smart_cut_possible && GST_BUFFER_PTS_IS_VALID (buffer)) {
+    end = GST_BUFFER_PTS (buffer);
+    if (GST_BUFFER_DURATION_IS_VALID (buffer))
+      end += GST_BUFFER_DURATION (buffer);
+    if (end <= self->start)
+      return GST_PAD_PROBE_DROP;
+  }
+
+  update_position (self, buffer);
+
+  return GST_PAD_PROBE_OK;
+}
+
+static GstElement *
+make_encoder (void)
+{
+  GstElement *encoder;
+
+  encoder = gst_element_factory_make ("x264enc", NULL);
+  if (encoder) {
+    /* Without B-frames the encoded frames end before the copied ones.
+     * Without lookahead the encoder drains right after the last frame */
+    gst_util_set_object_arg (G_OBJECT (encoder), "speed-preset", "veryfast");
+    gst_util_set_object_arg (G_OBJECT (encoder), "tune", "zerolatency");
+    gst_util_set_object_arg (G_OBJECT (encoder), "pass", "qual");
+    g_object_set (encoder, "quantizer", 21, "bframes", 0, NULL);
+    return encoder;
+  }
+
+  encoder = gst_element_factory_make ("vtenc_h264", NULL);
+  if (encoder && g_object_class_find_property (G_OBJECT_GET_CLASS (encoder),
+          "allow-frame-reordering"))
+    g_object_set (encoder, "allow-frame-reordering", FALSE, NULL);
+
+  return encoder;
+}
+
+static GstPadProbeReturn
+block_probe_cb (GstPad * pad, GstPadProbeInfo * info, gpointer user_data)
+{
+  /* Stays blocked until the probe is removed */
+  return GST_PAD_PROBE_OK;
+}
+
+/* queue ! tee ! queue --------------------------------------! funnel ! h264parse
+ *             \ queue ! avdec_h264 ! videoconvert ! encoder ! h264parse ^
+ */
+static GstElement *
+create_smart_cut_branch (GstPlayerClipExport * self)
+{
+  GstElement *bin, *tee, *copy_queue, *encode_queue, *decoder, *convert,
+      *encoder, *encode_parse, *funnel, *parse;
+  GstPad *pad, *funnel_pad;
+
+  bin = gst_bin_new (NULL);
+  tee = gst_element_factory_make ("tee", NULL);
+  copy_queue = gst_element_factory_make ("queue", NULL);
+  encode_queue = gst_element_factory_make ("queue", NULL);
+  decoder = gst_element_factory_make ("avdec_h264", NULL);
+  convert = gst_element_factory_make ("videoconvert", NULL);
+  encoder = make_encoder ();
+  encode_parse = gst_element_factory_make ("h264parse", NULL);
+  funnel = gst_element_factory_make ("funnel", NULL);
+  parse = gst_element_factory_make ("h264parse", NULL);
+
+  if (!tee || !copy_queue || !encode_queue || !decoder || !convert
+      || !encoder || !encode_parse || !funnel || !parse) {
+    GST_WARNING_OBJECT (self, "Missing elements for smart cut");
+    if (tee)
+      gst_object_unref (tee);
+    if (copy_queue)
+      gst_object_unref (copy_queue);
+    if (encode_queue)
+      gst_object_unref (encode_queue);
+    if (decoder)
+      gst_object_unref (decoder);
+    if (convert)
+      gst_object_unref (convert);
+    if (encoder)
+      gst_object_unref (encoder);
+    if (encode_parse)
+      gst_object_unref (encode_parse);
+    if (funnel)
+      gst_object_unref (funnel);
+    if (parse)
+      gst_object_unref (parse);
+    gst_object_unref (bin);
+    return NULL;
+  }
+
+  /* Parameter sets with every keyframe, the decoder has to pick up the
+   * ones of the copied frames after the encoded ones */
+  g_object_set (parse, "config-interval", 1, NULL);
+  /* Holds at most the frames up to the first copied keyframe. It must not
+   * block the tee while the copied frames wait for the encoder */
+  g_object_set (encode_queue, "max-size-buffers", 0, "max-size-bytes", 0,
+      "max-size-time", (guint64) 0, NULL);
+
+  gst_bin_add_many (GST_BIN (bin), tee, copy_queue, encode_queue, decoder,
+      convert, encoder, encode_parse, funnel, parse, NULL);
+  gst_element_link_many (encode_queue, decoder, convert, encoder,
+      encode_parse, NULL);
+  gst_element_link (funnel, parse);
+
+  pad = gst_element_get_request_pad (tee, "src_%u");
+  gst_pad_add_probe (pad, GST_PAD_PROBE_TYPE_BUFFER, copy_probe_cb, self,
+      NULL);
+  gst_element_link_pads (tee, GST_OBJECT_NAME (pad), copy_queue, "sink");
+  gst_object_unref (pad);
+  gst_element_link (copy_queue, funnel);
+
+  /* Released by encoder_eos_probe_cb() */
+  pad = gst_element_get_static_pad (copy_queue, "src");
+  g_mutex_lock (&self->lock);
+  self->copy_blocked.pad = pad;
+  self->copy_blocked.probe_id = gst_pad_add_probe (pad,
+      GST_PAD_PROBE_TYPE_BLOCK | GST_PAD_PROBE_TYPE_BUFFER, block_probe_cb,
+      NULL, NULL);
+  g_mutex_unlock (&self->lock);
+
+  pad = gst_element_get_request_pad (tee, "src_%u");
+  gst_pad_add_probe (pad, GST_PAD_PROBE_TYPE_BUFFER, encode_probe_cb, self,
+      NULL);
+  gst_element_link_pads (tee, GST_OBJECT_NAME (pad), encode_queue, "sink");
+  gst_object_unref (pad);
+  g_mutex_lock (&self->lock);
+  self->encode_pad = gst_element_get_static_pad (encode_queue, "sink");
+  g_mutex_unlock (&self->lock);
+
+  pad = gst_element_get_static_pad (encoder, "sink");
+  gst_pad_add_probe (pad, GST_PAD_PROBE_TYPE_BUFFER, encoder_clip_probe_cb,
+      self, NULL);
+  gst_object_unref (pad);
+
+  pad = gst_element_get_static_pad (encode_parse, "src");
+  funnel_pad = gst_pad_get_peer (pad);
+  gst_pad_add_probe (funnel_pad, GST_PAD_PROBE_TYPE_EVENT_DOWNSTREAM,
+      encoder_eos_probe_cb, self, NULL);
+  gst_object_unref (funnel_pad);
+  gst_object_unref (pad);
+
+  pad = gst_element_get_static_pad (tee, "sink");
+  gst_element_add_pad (bin, gst_ghost_pad_new ("sink", pad));
+  gst_object_unref (pad);
+  pad = gst_element_get_static_pad (parse, "src");
+  gst_element_add_pad (bin, gst_ghost_pad_new ("src", pad));
+  gst_object_unref (pad);
+
+  return bin;
+}
+
+static void
+pad_added_cb (GstElement * source, GstPad * pad, gpointer user_data)
+{
+  GstPlayerClipExport *self = GST_PLAYER_CLIP_EXPORT (user_data);
+  GstElement *branch = NULL, *queue;
+  BlockedPad *blocked;
+  GstPad *sinkpad;
+  GstCaps *caps;
+  const gchar *name;
+  gboolean video, audio;
+
+  /* Nothing flows before the seek to the clip start */
+  blocked = g_new0 (BlockedPad, 1);
+  blocked->pad = gst_object_ref (pad);
+  blocked->probe_id = gst_pad_add_probe (pad,
+      GST_PAD_PROBE_TYPE_BLOCK_DOWNSTREAM, block_probe_cb, NULL, NULL);
+  g_mutex_lock (&self->lock);
+  self->blocked_pads = g_list_prepend (self->blocked_pads, blocked);
+  g_mutex_unlock (&self->lock);
+
+  caps = gst_pad_get_current_caps (pad);
+  if (!caps)
+    caps = gst_pad_query_caps (pad, NULL);
+  name = gst_structure_get_name (gst_caps_get_structure (caps, 0));
+  video = g_str_has_prefix (name, "video/x-h264");
+  audio = self->audio && g_str_has_prefix (name, "audio/mpeg");
+  GST_DEBUG_OBJECT (self, "New pad with caps %" GST_PTR_FORMAT, caps);
+  gst_caps_unref (caps);
+
+  queue = gst_element_factory_make ("queue", NULL);
+  gst_bin_add (GST_BIN (self->pipeline), queue);
+  sinkpad = gst_element_get_static_pad (queue, "sink");
+
+  if (video) {
+    if (self->smart_cut_possible && !self->encode_pad)
+      branch = create_smart_cut_branch (self);
+
+    if (branch) {
+      gst_bin_add (GST_BIN (self->pipeline), branch);
+      gst_element_link (queue, branch);
+      if (!gst_element_link (branch, self->mux)) {
+        gst_bin_remove (GST_BIN (self->pipeline), branch);
+        branch = NULL;
+      }
+    } else if (gst_element_link (queue, self->mux)) {
+      gst_pad_add_probe (sinkpad, GST_PAD_PROBE_TYPE_BUFFER, copy_probe_cb,
+          self, NULL);
+      branch = queue;
+    }
+  } else if (audio && gst_element_link (queue, self->mux)) {
+    gst_pad_add_probe (sinkpad, GST_PAD_PROBE_TYPE_BUFFER, audio_probe_cb,
+        self, NULL);
+    branch = queue;
+  }
+
+  if (!branch) {
+    GstElement *fakesink = gst_element_factory_make ("fakesink", NULL);
+
+    GST_DEBUG_OBJECT (self, "Not exporting stream %s", name);
+    gst_bin_add (GST_BIN (self->pipeline), fakesink);
+    gst_element_link (queue, fakesink);
+    gst_element_sync_state_with_parent (fakesink);
+  } else if (branch != queue) {
+    gst_element_sync_state_with_parent (branch);
+  }
+  gst_element_sync_state_with_parent (queue);
+
+  gst_pad_link (pad, sinkpad);
+  gst_object_unref (sinkpad);
+}
+
+static void
+finish (GstPlayerClipExport * self)
+{
+  if (self->progress_source) {
+    g_source_destroy (self->progress_source);
+    g_source_unref (self->progress_source);
+    self->progress_source = NULL;
+  }
+
+  gst_element_set_state (self->pipeline, GST_STATE_NULL);
+}
+
+/* Removes what was written so far */
+static void
+fail (GstPlayerClipExport * self, GError * err)
+{
+  finish (self);
+  if (self->started)
+    g_unlink (self->dest);
+
+  g_mutex_lock (&self->lock);
+  self->finished = TRUE;
+  g_mutex_unlock (&self->lock);
+
+  emit_signal (self, SIGNAL_ERROR, 0.0, err);
+}
+
+static gboolean
+seek_cb (gpointer user_data)
+{
+  GstPlayerClipExport *self = GST_PLAYER_CLIP_EXPORT (user_data);
+  GstEvent *seek;
+  GList *pads, *l;
+
+  g_mutex_lock (&self->lock);
+  pads = self->blocked_pads;
+  self->blocked_pads = NULL;
+  g_mutex_unlock (&self->lock);
+
+  if (!pads) {
+    fail (self, g_error_new (GST_PLAYER_ERROR, GST_PLAYER_ERROR_FAILED,
+            "No stream to export"));
+    return G_SOURCE_REMOVE;
+  }
+
+  /* Copying has to start at a keyframe, the demuxer snaps to the one
+   * before the start */
+  GST_DEBUG_OBJECT (self, "Seeking to %" GST_TIME_FORMAT " - %"
+      GST_TIME_FORMAT, GST_TIME_ARGS (self->start),
+      GST_TIME_ARGS (self->stop));
+  seek = gst_event_new_seek (1.0, GST_FORMAT_TIME,
+      GST_SEEK_FLAG_FLUSH | GST_SEEK_FLAG_KEY_UNIT |
+      GST_SEEK_FLAG_SNAP_BEFORE, GST_SEEK_TYPE_SET, self->start,
+      GST_CLOCK_TIME_IS_VALID (self->stop) ? GST_SEEK_TYPE_SET :
+      GST_SEEK_TYPE_NONE, self->stop);
+  if (!gst_pad_send_event (((BlockedPad *) pads->data)->pad, seek))
+    GST_WARNING_OBJECT (self, "Seek failed, exporting from the beginning");
+
+  for (l = pads; l; l = l->next) {
+    BlockedPad *blocked = l->data;
+
+    gst_pad_remove_probe (blocked->pad, blocked->probe_id);
+  }
+  g_list_free_full (pads, (GDestroyNotify) blocked_pad_free);
+
+  return G_SOURCE_REMOVE;
+}
+
+static void
+no_more_pads_cb (GstElement * source, gpointer user_data)
+{
+  GstPlayerClipExport *self = GST_PLAYER_CLIP_EXPORT (user_data);
+
+  g_main_context_invoke_full (self->context, G_PRIORITY_DEFAULT, seek_cb,
+      self, NULL);
+}
+
+static gboolean
+progress_cb (gpointer user_data)
+{
+  GstPlayerClipExport *self = GST_PLAYER_CLIP_EXPORT (user_data);
+  GstClockTime stop = self->stop;
+  gint64 duration;
+  gdouble progress = 0.0;
+  gboolean changed;
+
+  if (!GST_CLOCK_TIME_IS_VALID (stop)
+      && gst_element_query_duration (self->source, GST_FORMAT_TIME,
+          &duration))
+    stop = duration;
+
+  g_mutex_lock (&self->lock);
+  if (GST_CLOCK_TIME_IS_VALID (stop)
+      && GST_CLOCK_TIME_IS_VALID (self->clip_start)
+      && GST_CLOCK_TIME_IS_VALID (self->position) && stop > self->clip_start
+      && self->position > self->clip_start)
+    progress = MIN ((gdouble) (self->position - self->clip_start) /
+        (stop - self->clip_start), 1.0);
+  changed = progress > self->progress;
+  if (changed)
+    self->progress = progress;
+  g_mutex_unlock (&self->lock);
+
+  if (changed)
+    emit_signal (self, SIGNAL_PROGRESS, progress, NULL);
+
+  return G_SOURCE_CONTINUE;
+}
+
+static void
+eos_cb (GstBus * bus, GstMessage * msg, gpointer user_data)
+{
+  GstPlayerClipExport *self = GST_PLAYER_CLIP_EXPORT (user_data);
+
+  GST_DEBUG_OBJECT (self, "Clip exported to %s", self->dest);
+  finish (self);
+
+  g_mutex_lock (&self->lock);
+  self->finished = TRUE;
+  self->progress = 1.0;
+  g_mutex_unlock (&self->lock);
+
+  emit_signal (self, SIGNAL_PROGRESS, 1.0, NULL);
+  emit_signal (self, SIGNAL_DONE, 0.0, NULL);
+}
+
+static void
+error_cb (GstBus * bus, GstMessage * msg, gpointer user_data)
+{
+  GstPlayerClipExport *self = GST_PLAYER_CLIP_EXPORT (user_data);
+  GError *err;
+  gchar *debug = NULL;
+
+  gst_message_parse_error (msg, &err, &debug);
+  GST_ERROR_OBJECT (self, "Error from %s: %s (%s)",
+      GST_OBJECT_NAME (GST_MESSAGE_SRC (msg)), err->message,
+      GST_STR_NULL (debug));
+  g_free (debug);
+
+  fail (self, g_error_new (GST_PLAYER_ERROR, GST_PLAYER_ERROR_FAILED,
+          "Failed to export clip: %s", err->message));
+  g_error_free (err);
+}
+
+static const gchar *export_features[] = {
+  "uridecodebin", "decodebin", "typefind", "queue", "tee", "funnel",
+  "h264parse", "aacparse", "mpegaudioparse", "avdec_h264", "videoconvert",
+  "x264enc", "vtenc_h264", "mp4mux", "qtmux", "flvmux", "mpegtsmux",
+  "filesink", "fakesink", NULL
+};
+
+static void
+gst_player_clip_export_constructed (GObject * object)
+{
+  GstPlayerClipExport *self = GST_PLAYER_CLIP_EXPORT (object);
+  GstElement *sink;
+  GstCaps *caps;
+  guint i;
+
+  if (gst_player_plugin_loader_is_lazy ()) {
+    for (i = 0; export_features[i]; i++)
+      gst_player_plugin_loader_ensure_feature (export_features[i]);
+    if (self->uri)
+      gst_player_plugin_loader_ensure_uri (self->uri);
+  }
+
+  self->pipeline = gst_pipeline_new ("clip-export");
+  gst_object_ref_sink (self->pipeline);
+
+  self->source = gst_element_factory_make ("uridecodebin", NULL);
+  self->mux = gst_element_factory_make (mux_factory_for_dest (self->dest ?
+          self->dest : "", &self->smart_cut_possible), NULL);
+  sink = gst_element_factory_make ("filesink", NULL);
+  self->smart_cut_possible &= self->smart_cut_allowed;
+
+  if (!self->source || !self->mux || !sink) {
+    GST_ERROR_OBJECT (self, "Missing elements for the export pipeline");
+    if (self->source)
+      gst_object_unref (self->source);
+    if (self->mux)
+      gst_object_unref (self->mux);
+    if (sink)
+      gst_object_unref (sink);
+    self->source = self->mux = NULL;
+  } else {
+    caps = gst_caps_from_string (EXPORT_CAPS);
+    g_object_set (self->source, "uri", self->uri, "caps", caps, NULL);
+    gst_caps_unref (caps);
+    g_object_set (sink, "location", self->dest, NULL);
+
+    gst_bin_add_many (GST_BIN (self->pipeline), self->source, self->mux, sink,
+        NULL);
+    gst_element_link (self->mux, sink);
+
+    g_signal_connect (self->source, "pad-added", G_CALLBACK (pad_added_cb),
+        self);
+    g_signal_connect (self->source, "no-more-pads",
+        G_CALLBACK (no_more_pads_cb), self);
+  }
+
+  g_mutex_lock (&self->lock);
+  self->thread = g_thread_new ("GstPlayerClipExport",
+      gst_player_clip_export_main, self);
+  while (!self->loop || !g_main_loop_is_running (self->loop))
+    g_cond_wait (&self->cond, &self->lock);
+  g_mutex_unlock (&self->lock);
+
+  G_OBJECT_CLASS (parent_class)->constructed (object);
+}
+
+static gboolean
+start_cb (gpointer user_data)
+{
+  GstPlayerClipExport *self = GST_PLAYER_CLIP_EXPORT (user_data);
+
+  g_mutex_lock (&self->lock);
+  g_cond_broadcast (&self->cond);
+  g_mutex_unlock (&self->lock);
+
+  if (!self->source || !self->uri || !self->dest) {
+    fail (self, g_error_new (GST_PLAYER_ERROR, GST_PLAYER_ERROR_FAILED,
+            "Missing elements for the export pipeline"));
+    return G_SOURCE_REMOVE;
+  }
+
+  GST_DEBUG_OBJECT (self, "Exporting %s to %s", self->uri, self->dest);
+
+  /* Runs as fast as possible, filesink doesn't sync */
+  self->progress_source = g_timeout_source_new (PROGRESS_INTERVAL_MS);
+  g_source_set_callback (self->progress_source, progress_cb, self, NULL);
+  g_source_attach (self->progress_source, self->context);
+
+  self->started = TRUE;
+  if (gst_element_set_state (self->pipeline,
+          GST_STATE_PLAYING) == GST_STATE_CHANGE_FAILURE)
+    fail (self, g_error_new (GST_PLAYER_ERROR, GST_PLAYER_ERROR_FAILED,
+            "Failed to start export"));
+
+  return G_SOURCE_REMOVE;
+}
+
+static gpointer
+gst_player_clip_export_main (gpointer data)
+{
+  GstPlayerClipExport *self = GST_PLAYER_CLIP_EXPORT (data);
+  GstBus *bus;
+  GSource *source;
+  GSource *bus_source;
+  gboolean cancelled;
+
+  g_main_context_push_thread_default (self->context);
+
+  source = g_idle_source_new ();
+  g_source_set_callback (source, start_cb, self, NULL);
+  g_source_attach (source, self->context);
+  g_source_unref (source);
+
+  bus = gst_element_get_bus (self->pipeline);
+  bus_source = gst_bus_create_watch (bus);
+  g_source_set_callback (bus_source, (GSourceFunc) gst_bus_async_signal_func,
+      NULL, NULL);
+  g_source_attach (bus_source, self->context);
+
+  g_signal_connect (G_OBJECT (bus), "message::eos", G_CALLBACK (eos_cb),
+      self);
+  g_signal_connect (G_OBJECT (bus), "message::error", G_CALLBACK (error_cb),
+      self);
+
+  g_main_loop_run (self->loop);
+
+  g_signal_handlers_disconnect_by_data (bus, self);
+  g_source_destroy (bus_source);
+  g_source_unref (bus_source);
+  gst_object_unref (bus);
+
+  finish (self);
+
+  g_main_context_pop_thread_default (self->context);
+
+  g_mutex_lock (&self->lock);
+  cancelled = self->cancelled;
+  g_mutex_unlock (&self->lock);
+
+  if (cancelled && self->started)
+    g_unlink (self->dest);
+
+  return NULL;
+}
+
+static void
+gst_player_clip_export_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec)
+{
+  GstPlayerClipExport *self = GST_PLAYER_CLIP_EXPORT (object);
+
+  switch (prop_id) {
+    case PROP_URI:
+      self->uri = g_value_dup_string (value);
+      break;
+    case PROP_DEST:
+      self->dest = g_value_dup_string (value);
+      break;
+    case PROP_START:
+      self->start = g_value_get_uint64 (value);
+      break;
+    case PROP_STOP:
+      self->stop = g_value_get_uint64 (value);
+      break;
+    case PROP_OPTIONS:{
+      const GstStructure *options = g_value_get_boxed (value);
+
+      if (options) {
+        gst_structure_get_boolean (options, "smart-cut",
+            &self->smart_cut_allowed);
+        gst_structure_get_boolean (options, "audio", &self->audio);
+      }
+      break;
+    }
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+static void
+gst_player_clip_export_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec)
+{
+  GstPlayerClipExport *self = GST_PLAYER_CLIP_EXPORT (object);
+
+  switch (prop_id) {
+    case PROP_URI:
+      g_value_set_string (value, self->uri);
+      break;
+    case PROP_DEST:
+      g_value_set_string (value, self->dest);
+      break;
+    case PROP_START:
+      g_value_set_uint64 (value, self->start);
+      break;
+    case PROP_STOP:
+      g_value_set_uint64 (value, self->stop);
+      break;
+    case PROP_PROGRESS:
+      g_mutex_lock (&self->lock);
+      g_value_set_double (value, self->progress);
+      g_mutex_unlock (&self->lock);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+static gpointer
+gst_player_clip_export_init_once (gpointer user_data)
+{
+  gst_init (NULL, NULL);
+
+  GST_DEBUG_CATEGORY_INIT (gst_player_clip_export_debug,
+      "gst-player-clip-export", 0, "GstPlayer Clip Export");
+
+  return NULL;
+}
+
+/**
+ * gst_player_export_clip:
+ * @uri: URI of the stream
+ * @start: start of the clip
+ * @stop: end of the clip, or %GST_CLOCK_TIME_NONE for the end of the stream
+ * @dest: file to write the clip to
+ * @options: (allow-none): export options
+ *
+ * Starts exporting the part of @uri from @start to @stop into the file
+ * @dest. Its extension selects the container: ".ts", ".m2ts" and ".mts"
+ * for MPEG-TS, ".flv" for FLV, ".mov" for QuickTime and MP4 otherwise.
+ * Only H.264 video and MPEG audio, including AAC, are exported.
+ *
+ * @options may contain the following fields:
+ *
+ * "smart-cut" (gboolean): re-encode the frames between @start and the next
+ * keyframe instead of starting the clip at the keyframe before @start. Only
+ * used for MPEG-TS, %TRUE by default.
+ *
+ * "audio" (gboolean): export audio, %TRUE by default.
+ *
+ * The #GstPlayerClipExport::progress, #GstPlayerClipExport::done and
+ * #GstPlayerClipExport::error signals are emitted from the thread-default
+ * main context of the calling thread, they are never emitted before this
+ * function returned.
+ *
+ * Returns: (transfer full): a new #GstPlayerClipExport, unreffing it
+ *   cancels the export
+ */
+GstPlayerClipExport *
+gst_player_export_clip (const gchar * uri, GstClockTime start,
+    GstClockTime stop, const gchar * dest, const GstStructure * options)
+{
+  static GOnce once = G_ONCE_INIT;
+
+  g_return_val_if_fail (uri != NULL, NULL);
+  g_return_val_if_fail (dest != NULL, NULL);
+  g_return_val_if_fail (GST_CLOCK_TIME_IS_VALID (start), NULL);
+  g_return_val_if_fail (!GST_CLOCK_TIME_IS_VALID (stop) || stop > start,
+      NULL);
+
+  g_once (&once, gst_player_clip_export_init_once, NULL);
+
+  return g_object_new (GST_TYPE_PLAYER_CLIP_EXPORT, "uri", uri, "dest", dest,
+      "start", start, "stop", stop, "options", options, NULL);
+}
+
+static gboolean
+cancel_cb (gpointer user_data)
+{
+  GstPlayerClipExport *self = GST_PLAYER_CLIP_EXPORT (user_data);
+
+  finish (self);
+  g_main_loop_quit (self->loop);
+
+  return G_SOURCE_REMOVE;
+}
+
+/**
+ * gst_player_clip_export_cancel:
+ * @clip_export: #GstPlayerClipExport instance
+ *
+ * Stops the export and removes the partially written file. No signals are
+ * emitted afterwards. Does nothing if the export already finished.
+ */
+void
+gst_player_clip_export_cancel (GstPlayerClipExport * self)
+{
+  g_return_if_fail (GST_IS_PLAYER_CLIP_EXPORT (self));
+
+  g_mutex_lock (&self->lock);
+  if (self->finished || self->cancelled) {
+    g_mutex_unlock (&self->lock);
+    return;
+  }
+  self->cancelled = TRUE;
+  /* Wakes up the video streaming thread if it waits for the encoder */
+  g_cond_broadcast (&self->cond);
+  g_mutex_unlock (&self->lock);
+
+  GST_DEBUG_OBJECT (self, "Cancelling export");
+  g_main_context_invoke_full (self->context, G_PRIORITY_HIGH, cancel_cb,
+      self, NULL);
+}
+
+/**
+ * gst_player_clip_export_get_progress:
+ * @clip_export: #GstPlayerClipExport instance
+ *
+ * Returns: the exported part of the clip, between 0.0 and 1.0
+ */
+gdouble
+gst_player_clip_export_get_progress (GstPlayerClipExport * self)
+{
+  gdouble progress;
+
+  g_return_val_if_fail (GST_IS_PLAYER_CLIP_EXPORT (self), 0.0);
+
+  g_object_get (self, "progress", &progress, NULL);
+
+  return progress;
+}
+
+/**
+ * gst_player_clip_export_get_smart_cut:
+ * @clip_export: #GstPlayerClipExport instance
+ *
+ * Returns: %TRUE if the start of the clip was re-encoded because it was not
+ *   at a keyframe
+ */
+gboolean
+gst_player_clip_export_get_smart_cut (GstPlayerClipExport * self)
+{
+  gboolean smart_cut;
+
+  g_return_val_if_fail (GST_IS_PLAYER_CLIP_EXPORT (self), FALSE);
+
+  g_mutex_lock (&self->lock);
+  smart_cut = self->smart_cut;
+  g_mutex_unlock (&self->lock);
+
+  return smart_cut;
+}
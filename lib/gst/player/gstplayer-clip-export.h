@@ -0,0 +1,53 @@
+/* GStreamer
+ *
+ * Copyright (C) 2015 Kim DaeHyun <jabiers87@gmail.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __GST_PLAYER_CLIP_EXPORT_H__
+#define __GST_PLAYER_CLIP_EXPORT_H__
+
+#include <gst/gst.h>
+
+G_BEGIN_DECLS
+
+typedef struct _GstPlayerClipExport GstPlayerClipExport;
+typedef struct _GstPlayerClipExportClass GstPlayerClipExportClass;
+
+#define GST_TYPE_PLAYER_CLIP_EXPORT             (gst_player_clip_export_get_type ())
+#define GST_IS_PLAYER_CLIP_EXPORT(obj)          (G_TYPE_CHECK_INSTANCE_TYPE ((obj), GST_TYPE_PLAYER_CLIP_EXPORT))
+#define GST_IS_PLAYER_CLIP_EXPORT_CLASS(klass)  (G_TYPE_CHECK_CLASS_TYPE ((klass), GST_TYPE_PLAYER_CLIP_EXPORT))
+#define GST_PLAYER_CLIP_EXPORT_GET_CLASS(obj)   (G_TYPE_INSTANCE_GET_CLASS ((obj), GST_TYPE_PLAYER_CLIP_EXPORT, GstPlayerClipExportClass))
+#define GST_PLAYER_CLIP_EXPORT(obj)             (G_TYPE_CHECK_INSTANCE_CAST ((obj), GST_TYPE_PLAYER_CLIP_EXPORT, GstPlayerClipExport))
+#define GST_PLAYER_CLIP_EXPORT_CLASS(klass)     (G_TYPE_CHECK_CLASS_CAST ((klass), GST_TYPE_PLAYER_CLIP_EXPORT, GstPlayerClipExportClass))
+#define GST_PLAYER_CLIP_EXPORT_CAST(obj)        ((GstPlayerClipExport*)(obj))
+
+GType        gst_player_clip_export_get_type           (void);
+
+GstPlayerClipExport * gst_player_export_clip           (const gchar * uri,
+                                                        GstClockTime start,
+                                                        GstClockTime stop,
+                                                        const gchar * dest,
+                                                        const GstStructure * options);
+
+void         gst_player_clip_export_cancel             (GstPlayerClipExport * clip_export);
+gdouble      gst_player_clip_export_get_progress       (GstPlayerClipExport * clip_export);
+gboolean     gst_player_clip_export_get_smart_cut      (GstPlayerClipExport * clip_export);
+
+G_END_DECLS
+
+#endif /* __GST_PLAYER_CLIP_EXPORT_H__ */
@@ -0,0 +1,507 @@
+/* GStreamer
+ *
+ * Copyright (C) 2015 Kim DaeHyun <jabiers87@gmail.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/**
+ * SECTION:gstplayer-decoder-probe
+ * @short_description: Per-codec decoder benchmark
+ *
+ * Several decoders are usually available for the same codec and the one
+ * with the highest rank is not necessarily the fastest on a given device.
+ *
+ * gst_player_decoder_probe_run() encodes short test clips for a few codecs
+ * and resolutions, decodes each of them with every available decoder and
+ * remembers the fastest decoder per codec and resolution. The results are
+ * written to a file that can be loaded on later starts with
+ * gst_player_decoder_probe_load(), so probing only has to happen once.
+ *
+ * #GstPlayer prefers the probed decoders when autoplugging, unless the
+ * application configured a decoder policy that says otherwise.
+ */
+
+#include "gstplayer-decoder-probe.h"
+#include "gstplayer-plugin-loader.h"
+
+#include <stdio.h>
+#include <string.h>
+
+GST_DEBUG_CATEGORY_STATIC (gst_player_decoder_probe_debug);
+#define GST_CAT_DEFAULT gst_player_decoder_probe_debug
+
+#define PROBE_GROUP "decoder-probe"
+#define PROBE_VERSION 1
+#define PROBE_N_FRAMES 60
+#define PROBE_TIMEOUT (30 * GST_SECOND)
+
+typedef struct
+{
+  const gchar *media_type;
+  const gchar *encoder;
+  const gchar *encoder_props;
+} ProbeCodec;
+
+/* The first available encoder per media type is used */
+static const ProbeCodec probe_codecs[] = {
+  {"video/x-h264", "x264enc", "speed-preset=ultrafast key-int-max=30"},
+  {"video/x-h264", "openh264enc", ""},
+  {"video/x-vp8", "vp8enc", "deadline=1"},
+  {"video/x-vp9", "vp9enc", "deadline=1"},
+  {NULL, NULL, NULL}
+};
+
+static const struct
+{
+  gint width, height;
+} probe_sizes[] = {
+  {640, 360}, {1280, 720}, {1920, 1080}
+};
+
+typedef struct
+{
+  gchar *media_type;
+  gint width, height;
+  gchar *decoder;
+  GstClockTime time;
+} ProbeResult;
+
+static GMutex probe_lock;
+static GPtrArray *probe_results;
+
+static void
+probe_result_free (ProbeResult * result)
+{
+  g_free (result->media_type);
+  g_free (result->decoder);
+  g_free (result);
+}
+
+static void
+ensure_debug_category (void)
+{
+  static gsize done = 0;
+
+  if (g_once_init_enter (&done)) {
+    GST_DEBUG_CATEGORY_INIT (gst_player_decoder_probe_debug,
+        "gst-player-decoder-probe", 0, "GstPlayer decoder probe");
+    g_once_init_leave (&done, 1);
+  }
+}
+
+static GstMessage *
+run_until_eos (GstElement * pipeline)
+{
+  GstBus *bus;
+  GstMessage *msg;
+
+  bus = gst_element_get_bus (pipeline);
+  msg = gst_bus_timed_pop_filtered (bus, PROBE_TIMEOUT,
+      GST_MESSAGE_EOS | GST_MESSAGE_ERROR);
+  gst_object_unref (bus);
+
+  return msg;
+}
+
+static void
+collect_buffer_cb (GstElement * sink, GstBuffer * buffer, GstPad * pad,
+    gpointer user_data)
+{
+  GPtrArray *buffers = user_data;
+
+  g_ptr_array_add (buffers, gst_buffer_ref (buffer));
+}
+
+/* Encodes a test clip and returns its buffers, or NULL on failure */
+static GPtrArray *
+encode_clip (const ProbeCodec * codec, gint width, gint height,
+    GstCaps ** caps)
+{
+  GstElement *pipeline, *sink;
+  GstPad *pad;
+  GPtrArray *buffers;
+  GstMessage *msg;
+  gchar *desc;
+
+  desc = g_strdup_printf ("videotestsrc num-buffers=%d pattern=ball ! "
+      "video/x-raw, format=I420, width=%d, height=%d, framerate=30/1 ! "
+      "%s %s ! fakesink name=sink sync=false signal-handoffs=true",
+      PROBE_N_FRAMES, width, height, codec->encoder, codec->encoder_props);
+  pipeline = gst_parse_launch (desc, NULL);
+  g_free (desc);
+  if (!pipeline)
+    return NULL;
+
+  buffers = g_ptr_array_new_with_free_func ((GDestroyNotify) gst_buffer_unref);
+  sink = gst_bin_get_by_name (GST_BIN (pipeline), "sink");
+  g_signal_connect (sink, "handoff", G_CALLBACK (collect_buffer_cb), buffers);
+
+  gst_element_set_state (pipeline, GST_STATE_PLAYING);
+  msg = run_until_eos (pipeline);
+
+  pad = gst_element_get_static_pad (sink, "sink");
+  *caps = gst_pad_get_current_caps (pad);
+  gst_object_unref (pad);
+
+  gst_element_set_state (pipeline, GST_STATE_NULL);
+  gst_object_unref (sink);
+  gst_object_unref (pipeline);
+
+  if (!msg || GST_MESSAGE_TYPE (msg) != GST_MESSAGE_EOS || !*caps
+      || buffers->len == 0) {
+    GST_WARNING ("Failed to encode %dx%d test clip with %s", width, height,
+        codec->encoder);
+    if (msg)
+      gst_message_unref (msg);
+    if (*caps)
+      gst_caps_unref (*caps);
+    *caps = NULL;
+    g_ptr_array_unref (buffers);
+    return NULL;
+  }
+
+  gst_message_unref (msg);
+
+  return buffers;
+}
+
+/* Returns the time @decoder needs for the clip, or GST_CLOCK_TIME_NONE */
+static GstClockTime
+time_decoder (GstElementFactory * decoder, GstElementFactory * parser,
+    GPtrArray * buffers, GstCaps * caps)
+{
+  GstElement *pipeline, *src, *parse = NULL, *dec, *sink;
+  GstFlowReturn flow;
+  GstClockTime start, time = GST_CLOCK_TIME_NONE;
+  GstMessage *msg;
+  gboolean linked;
+  guint i;
+
+  pipeline = gst_pipeline_new ("decoder-probe");
+  src = gst_element_factory_make ("appsrc", NULL);
+  dec = gst_element_factory_create (decoder, NULL);
+  sink = gst_element_factory_make ("fakesink", NULL);
+  if (parser)
+    parse = gst_element_factory_create (parser, NULL);
+
+  if (!src || !dec || !sink || (parser && !parse)) {
+    if (src)
+      gst_object_unref (src);
+    if (dec)
+      gst_object_unref (dec);
+    if (sink)
+      gst_object_unref (sink);
+    if (parse)
+      gst_object_unref (parse);
+    gst_object_unref (pipeline);
+    return GST_CLOCK_TIME_NONE;
+  }
+
+  g_object_set (src, "caps", caps, "format", GST_FORMAT_TIME, NULL);
+  g_object_set (sink, "sync", FALSE, NULL);
+
+  gst_bin_add_many (GST_BIN (pipeline), src, dec, sink, NULL);
+  if (parse) {
+    gst_bin_add (GST_BIN (pipeline), parse);
+    linked = gst_element_link_many (src, parse, dec, sink, NULL);
+  } else {
+    linked = gst_element_link_many (src, dec, sink, NULL);
+  }
+
+  if (linked && gst_element_set_state (pipeline,
+          GST_STATE_PAUSED) != GST_STATE_CHANGE_FAILURE) {
+    start = gst_util_get_timestamp ();
+    for (i = 0; i < buffers->len; i++)
+      g_signal_emit_by_name (src, "push-buffer", g_ptr_array_index (buffers,
+              i), &flow);
+    g_signal_emit_by_name (src, "end-of-stream", &flow);
+
+    gst_element_set_state (pipeline, GST_STATE_PLAYING);
+    msg = run_until_eos (pipeline);
+    if (msg && GST_MESSAGE_TYPE (msg) == GST_MESSAGE_EOS)
+      time = gst_util_get_timestamp () - start;
+    if (msg)
+      gst_message_unref (msg);
+  }
+
+  gst_element_set_state (pipeline, GST_STATE_NULL);
+  gst_object_unref (pipeline);
+
+  return time;
+}
+
+static void
+probe_codec (const ProbeCodec * codec, gint width, gint height,
+    GPtrArray * results)
+{
+  GPtrArray *buffers;
+  GstCaps *caps = NULL;
+  GList *decoders, *parsers, *all, *l;
+  GstElementFactory *best = NULL;
+  GstClockTime best_time = GST_CLOCK_TIME_NONE, time;
+  ProbeResult *result;
+
+  buffers = encode_clip (codec, width, height, &caps);
+  if (!buffers)
+    return;
+
+  gst_player_plugin_loader_ensure_caps (caps);
+
+  all = gst_element_factory_list_get_elements (GST_ELEMENT_FACTORY_TYPE_PARSER,
+      GST_RANK_MARGINAL);
+  parsers = gst_element_factory_list_filter (all, caps, GST_PAD_SINK, FALSE);
+  parsers = g_list_sort (parsers, gst_plugin_feature_rank_compare_func);
+  gst_plugin_feature_list_free (all);
+
+  all = gst_element_factory_list_get_elements (GST_ELEMENT_FACTORY_TYPE_DECODER,
+      GST_RANK_MARGINAL);
+  decoders = gst_element_factory_list_filter (all, caps, GST_PAD_SINK, FALSE);
+  gst_plugin_feature_list_free (all);
+
+  for (l = decoders; l; l = l->next) {
+    time = time_decoder (l->data, parsers ? parsers->data : NULL, buffers,
+        caps);
+
+    GST_INFO ("%s %dx%d: %s took %" GST_TIME_FORMAT, codec->media_type,
+        width, height, GST_OBJECT_NAME (l->data), GST_TIME_ARGS (time));
+
+    if (GST_CLOCK_TIME_IS_VALID (time) && (!best || time < best_time)) {
+      best = l->data;
+      best_time = time;
+    }
+  }
+
+  if (best) {
+    result = g_new0 (ProbeResult, 1);
+    result->media_type = g_strdup (codec->media_type);
+    result->width = width;
+    result->height = height;
+    result->decoder = g_strdup (GST_OBJECT_NAME (best));
+    result->time = best_time;
+    g_ptr_array_add (results, result);
+  }
+
+  gst_plugin_feature_list_free (decoders);
+  gst_plugin_feature_list_free (parsers);
+  gst_caps_unref (caps);
+  g_ptr_array_unref (buffers);
+}
+
+static gboolean
+save_results (const gchar * filename, GPtrArray * results, GError ** error)
+{
+  GKeyFile *key_file;
+  gchar *group, *data;
+  gsize length;
+  gboolean ret;
+  guint i;
+
+  key_file = g_key_file_new ();
+  g_key_file_set_integer (key_file, PROBE_GROUP, "version", PROBE_VERSION);
+
+  for (i = 0; i < results->len; i++) {
+    ProbeResult *result = g_ptr_array_index (results, i);
+
+    group = g_strdup_printf ("%s %dx%d", result->media_type, result->width,
+        result->height);
+    g_key_file_set_string (key_file, group, "decoder", result->decoder);
+    g_key_file_set_uint64 (key_file, group, "time", result->time);
+    g_free (group);
+  }
+
+  data = g_key_file_to_data (key_file, &length, NULL);
+  ret = g_file_set_contents (filename, data, length, error);
+  g_free (data);
+  g_key_file_free (key_file);
+
+  return ret;
+}
+
+/**
+ * gst_player_decoder_probe_load:
+ * @filename: file written by gst_player_decoder_probe_run()
+ *
+ * Loads the results of an earlier decoder probe.
+ *
+ * Returns: %TRUE if the results were loaded, %FALSE if the file does not
+ * exist or has an unknown format.
+ */
+gboolean
+gst_player_decoder_probe_load (const gchar * filename)
+{
+  GKeyFile *key_file;
+  GPtrArray *results;
+  gchar **groups;
+  gchar media_type[64];
+  gint width, height;
+  guint i;
+
+  g_return_val_if_fail (filename != NULL, FALSE);
+
+  ensure_debug_category ();
+
+  key_file = g_key_file_new ();
+  if (!g_key_file_load_from_file (key_file, filename, G_KEY_FILE_NONE, NULL)
+      || g_key_file_get_integer (key_file, PROBE_GROUP, "version",
+          NULL) != PROBE_VERSION) {
+    g_key_file_free (key_file);
+    return FALSE;
+  }
+
+  results = g_ptr_array_new_with_free_func ((GDestroyNotify) probe_result_free);
+  groups = g_key_file_get_groups (key_file, NULL);
+  for (i = 0; groups[i]; i++) {
+    ProbeResult *result;
+    gchar *decoder;
+
+    if (sscanf (groups[i], "%63s %dx%d", media_type, &width, &height) != 3)
+      continue;
+
+    decoder = g_key_file_get_string (key_file, groups[i], "decoder", NULL);
+    if (!decoder)
+      continue;
+
+    result = g_new0 (ProbeResult, 1);
+    result->media_type = g_strdup (media_type);
+    result->width = width;
+    result->height = height;
+    result->decoder = decoder;
+    result->time = g_key_file_get_uint64 (key_file, groups[i], "time", NULL);
+    g_ptr_array_add (results, result);
+  }
+  g_strfreev (groups);
+  g_key_file_free (key_file);
+
+  GST_DEBUG ("Loaded %u decoder probe results from %s", results->len,
+      filename);
+
+  g_mutex_lock (&probe_lock);
+  if (probe_results)
+    g_ptr_array_unref (probe_results);
+  probe_results = results;
+  g_mutex_unlock (&probe_lock);
+
+  return TRUE;
+}
+
+/**
+ * gst_player_decoder_probe_run:
+ * @filename: (allow-none): file to store the results in
+ * @error: return location for a #GError, or %NULL
+ *
+ * Decodes generated test clips with all available decoders and remembers
+ * the fastest decoder per codec and resolution. This blocks for several
+ * seconds and should be called once from a background thread, e.g. when
+ * gst_player_decoder_probe_load() failed.
+ *
+ * Returns: %TRUE if probing finished and the results could be stored.
+ */
+gboolean
+gst_player_decoder_probe_run (const gchar * filename, GError ** error)
+{
+  GPtrArray *results;
+  GstElementFactory *factory;
+  const gchar *last_media_type = NULL;
+  gboolean ret = TRUE;
+  guint i, j;
+
+  ensure_debug_category ();
+
+  gst_player_plugin_loader_ensure_feature ("videotestsrc");
+  gst_player_plugin_loader_ensure_feature ("appsrc");
+  gst_player_plugin_loader_ensure_feature ("fakesink");
+
+  results = g_ptr_array_new_with_free_func ((GDestroyNotify) probe_result_free);
+
+  for (i = 0; probe_codecs[i].media_type; i++) {
+    const ProbeCodec *codec = &probe_codecs[i];
+
+    if (last_media_type && strcmp (last_media_type, codec->media_type) == 0)
+      continue;
+
+    gst_player_plugin_loader_ensure_feature (codec->encoder);
+    factory = gst_element_factory_find (codec->encoder);
+    if (!factory)
+      continue;
+    gst_object_unref (factory);
+    last_media_type = codec->media_type;
+
+    for (j = 0; j < G_N_ELEMENTS (probe_sizes); j++)
+      probe_codec (codec, probe_sizes[j].width, probe_sizes[j].height,
+          results);
+  }
+
+  if (filename)
+    ret = save_results (filename, results, error);
+
+  g_mutex_lock (&probe_lock);
+  if (probe_results)
+    g_ptr_array_unref (probe_results);
+  probe_results = results;
+  g_mutex_unlock (&probe_lock);
+
+  return ret;
+}
+
+/**
+ * gst_player_decoder_probe_get_preferred:
+ * @media_type: media type of the encoded stream, e.g. "video/x-h264"
+ * @width: width of the stream, or 0 if unknown
+ * @height: height of the stream, or 0 if unknown
+ *
+ * Looks up the fastest decoder for @media_type, using the probed
+ * resolution closest to @width x @height.
+ *
+ * Returns: (transfer full): name of the decoder factory, or %NULL if
+ * nothing was probed for @media_type
+ */
+gchar *
+gst_player_decoder_probe_get_preferred (const gchar * media_type, gint width,
+    gint height)
+{
+  ProbeResult *best = NULL;
+  gint64 pixels, diff, best_diff = G_MAXINT64;
+  gchar *decoder = NULL;
+  guint i;
+
+  g_return_val_if_fail (media_type != NULL, NULL);
+
+  if (width <= 0 || height <= 0) {
+    width = 1280;
+    height = 720;
+  }
+  pixels = (gint64) width * height;
+
+  g_mutex_lock (&probe_lock);
+  for (i = 0; probe_results && i < probe_results->len; i++) {
+    ProbeResult *result = g_ptr_array_index (probe_results, i);
+
+    if (strcmp (result->media_type, media_type) != 0)
+      continue;
+
+    diff = ABS ((gint64) result->width * result->height - pixels);
+    if (diff < best_diff) {
+      best = result;
+      best_diff = diff;
+    }
+  }
+  if (best)
+    decoder = g_strdup (best->decoder);
+  g_mutex_unlock (&probe_lock);
+
+  return decoder;
+}
@@ -0,0 +1,38 @@
+/* GStreamer
+ *
+ * Copyright (C) 2015 Kim DaeHyun <jabiers87@gmail.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __GST_PLAYER_DECODER_PROBE_H__
+#define __GST_PLAYER_DECODER_PROBE_H__
+
+#include <gst/gst.h>
+
+G_BEGIN_DECLS
+
+gboolean     gst_player_decoder_probe_load            (const gchar * filename);
+gboolean     gst_player_decoder_probe_run             (const gchar * filename,
+                                                       GError ** error);
+
+gchar *      gst_player_decoder_probe_get_preferred   (const gchar * media_type,
+                                                       gint width,
+                                                       gint height);
+
+G_END_DECLS
+
+#endif /* __GST_PLAYER_DECODER_PROBE_H__ */
@@ -0,0 +1,43 @@
+/* GStreamer
+ *
+ * Copyright (C) 2015 Kim DaeHyun <jabiers87@gmail.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __GST_PLAYER_ELEMENT_STATS_PRIVATE_H__
+#define __GST_PLAYER_ELEMENT_STATS_PRIVATE_H__
+
+#include <gst/gst.h>
+
+typedef struct _GstPlayerElementStats GstPlayerElementStats;
+
+G_GNUC_INTERNAL GstPlayerElementStats * gst_player_element_stats_new (void);
+G_GNUC_INTERNAL void gst_player_element_stats_free (GstPlayerElementStats *
+    stats);
+G_GNUC_INTERNAL void gst_player_element_stats_set_enabled
+    (GstPlayerElementStats * stats, gboolean enabled);
+G_GNUC_INTERNAL gboolean gst_player_element_stats_get_enabled
+    (GstPlayerElementStats * stats);
+G_GNUC_INTERNAL void gst_player_element_stats_watch (GstPlayerElementStats *
+    stats, GstBin * bin);
+G_GNUC_INTERNAL GstStructure *
+gst_player_element_stats_get (GstPlayerElementStats * stats);
+G_GNUC_INTERNAL gchar *
+gst_player_element_stats_annotate_dot (GstPlayerElementStats * stats,
+    const gchar * dot);
+
+#endif
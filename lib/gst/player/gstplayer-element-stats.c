@@ -0,0 +1,548 @@
+/* GStreamer
+ *
+ * Copyright (C) 2015 Kim DaeHyun <jabiers87@gmail.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/* Per-element CPU time and latency.
+ *
+ * Every element of the pipeline gets buffer probes on all its pads. Each
+ * probe reads the CPU clock of the calling thread. An element is charged
+ * the CPU time from a buffer arriving on one of its sink pads until it
+ * pushes a buffer on one of its source pads in the same thread, which is
+ * the work it did on the buffer it got. Probes don't tell when a push
+ * returns, so what an element does after pushing, and all the work of
+ * sources and sinks, is not charged to any element. It is still part of
+ * the CPU time of the thread.
+ *
+ * The latency of an element is the wall clock time from a buffer arriving
+ * on a sink pad until a buffer with the same timestamp leaves a source
+ * pad, also across threads, e.g. for queues.
+ */
+
+#include "gstplayer-element-stats-private.h"
+
+#include <string.h>
+#include <time.h>
+
+/* Buffers per element whose arrival is remembered to measure latency */
+#define N_PENDING 16
+
+typedef struct
+{
+  GstClockTime pts;
+  GstClockTime time;
+} Pending;
+
+typedef struct
+{
+  GstPlayerElementStats *stats;
+  GstElement *element;          /* Not owned, NULL once finalized */
+  gchar *name, *factory;
+  gulong pad_added_id;
+
+  GstClockTime cpu_time;
+  guint64 n_buffers;
+  GstClockTime latency, max_latency;
+  guint64 n_latency;
+  Pending pending[N_PENDING];
+  guint pending_index;
+} ElementData;
+
+typedef struct
+{
+  gchar *name;
+  GstClockTime cpu_start, cpu_time;
+} ThreadData;
+
+/* Thread local, only valid while @generation matches the stats' */
+typedef struct
+{
+  GstPlayerElementStats *stats;
+  guint generation;
+  ThreadData *thread;
+  /* Element that got a buffer last and didn't push one yet */
+  ElementData *entered;
+  GstClockTime entered_cpu;
+} ThreadState;
+
+struct _GstPlayerElementStats
+{
+  GMutex lock;
+  gint enabled;                 /* Atomic */
+
+  guint generation;
+  GstClockTime start;
+  GPtrArray *elements;
+  GPtrArray *threads;
+};
+
+static GPrivate thread_state = G_PRIVATE_INIT (g_free);
+static gint next_generation = 1;
+
+G_DEFINE_QUARK (gst-player-element-stats, element_stats);
+
+static GstClockTime
+thread_cpu_time (void)
+{
+#ifdef CLOCK_THREAD_CPUTIME_ID
+  struct timespec ts;
+
+  if (clock_gettime (CLOCK_THREAD_CPUTIME_ID, &ts) == 0)
+    return GST_TIMESPEC_TO_TIME (ts);
+#endif
+
+  /* Without a thread CPU clock waiting is charged as well */
+  return gst_util_get_timestamp ();
+}
+
+static void
+element_data_free (ElementData * data)
+{
+  g_free (data->name);
+  g_free (data->factory);
+  g_free (data);
+}
+
+static void
+thread_data_free (ThreadData * thread)
+{
+  g_free (thread->name);
+  g_free (thread);
+}
+
+static void
+element_data_reset (ElementData * data)
+{
+  guint i;
+
+  data->cpu_time = 0;
+  data->n_buffers = 0;
+  data->latency = 0;
+  data->max_latency = 0;
+  data->n_latency = 0;
+  for (i = 0; i < N_PENDING; i++)
+    data->pending[i].pts = GST_CLOCK_TIME_NONE;
+}
+
+/* Called with lock */
+static ThreadState *
+get_thread_state (GstPlayerElementStats * stats, GstPad * pad,
+    GstClockTime cpu)
+{
+  ThreadState *state = g_private_get (&thread_state);
+
+  if (!state) {
+    state = g_new0 (ThreadState, 1);
+    g_private_set (&thread_state, state);
+  }
+
+  if (state->stats != stats || state->generation != stats->generation) {
+    /* Streaming threads start by pushing from the pad of their element */
+    state->thread = g_new0 (ThreadData, 1);
+    state->thread->name = g_strdup_printf ("%s:%s", GST_DEBUG_PAD_NAME (pad));
+    state->thread->cpu_start = cpu;
+    g_ptr_array_add (stats->threads, state->thread);
+
+    state->stats = stats;
+    state->generation = stats->generation;
+    state->entered = NULL;
+  }
+
+  return state;
+}
+
+static GstPadProbeReturn
+buffer_probe_cb (GstPad * pad, GstPadProbeInfo * info, gpointer user_data)
+{
+  ElementData *data = user_data;
+  GstPlayerElementStats *stats = data->stats;
+  GstClockTime cpu, now, pts, latency;
+  ThreadState *state;
+  GstBuffer *buffer;
+  guint i;
+
+  if (!g_atomic_int_get (&stats->enabled))
+    return GST_PAD_PROBE_OK;
+
+  cpu = thread_cpu_time ();
+  now = gst_util_get_timestamp ();
+  if (info->type & GST_PAD_PROBE_TYPE_BUFFER_LIST)
+    buffer = gst_buffer_list_get (GST_PAD_PROBE_INFO_BUFFER_LIST (info), 0);
+  else
+    buffer = GST_PAD_PROBE_INFO_BUFFER (info);
+  pts = buffer ? GST_BUFFER_PTS (buffer) : GST_CLOCK_TIME_NONE;
+
+  g_mutex_lock (&stats->lock);
+  state = get_thread_state (stats, pad, cpu);
+  state->thread->cpu_time = cpu - state->thread->cpu_start;
+
+  if (GST_PAD_IS_SINK (pad)) {
+    state->entered = data;
+    state->entered_cpu = cpu;
+
+    if (GST_CLOCK_TIME_IS_VALID (pts)) {
+      data->pending[data->pending_index].pts = pts;
+      data->pending[data->pending_index].time = now;
+      data->pending_index = (data->pending_index + 1) % N_PENDING;
+    }
+  } else {
+    /* If another element got a buffer since, a push further downstream
+     * returned in between and the time can't be split */
+    if (state->entered == data && cpu > state->entered_cpu)
+      data->cpu_time += cpu - state->entered_cpu;
+    state->entered = NULL;
+
+    data->n_buffers++;
+    for (i = 0; GST_CLOCK_TIME_IS_VALID (pts) && i < N_PENDING; i++) {
+      if (data->pending[i].pts != pts)
+        continue;
+
+      latency = now - data->pending[i].time;
+      data->latency += latency;
+      data->max_latency = MAX (data->max_latency, latency);
+      data->n_latency++;
+      data->pending[i].pts = GST_CLOCK_TIME_NONE;
+      break;
+    }
+  }
+  g_mutex_unlock (&stats->lock);
+
+  return GST_PAD_PROBE_OK;
+}
+
+static void
+watch_pad (ElementData * data, GstPad * pad)
+{
+  GstPlayerElementStats *stats = data->stats;
+  gboolean watched;
+
+  g_mutex_lock (&stats->lock);
+  watched = g_object_get_qdata (G_OBJECT (pad), element_stats_quark ()) !=
+      NULL;
+  if (!watched)
+    g_object_set_qdata (G_OBJECT (pad), element_stats_quark (), data);
+  g_mutex_unlock (&stats->lock);
+
+  if (!watched)
+    gst_pad_add_probe (pad,
+        GST_PAD_PROBE_TYPE_BUFFER | GST_PAD_PROBE_TYPE_BUFFER_LIST,
+        buffer_probe_cb, data, NULL);
+}
+
+static void
+pad_added_cb (GstElement * element, GstPad * pad, gpointer user_data)
+{
+  watch_pad (user_data, pad);
+}
+
+static void
+element_finalized_cb (gpointer user_data, GObject * object)
+{
+  ElementData *data = user_data;
+
+  g_mutex_lock (&data->stats->lock);
+  data->element = NULL;
+  g_mutex_unlock (&data->stats->lock);
+}
+
+static void
+watch_element (GstPlayerElementStats * stats, GstElement * element)
+{
+  GstElementFactory *factory;
+  ElementData *data;
+  GstIterator *it;
+  GValue item = G_VALUE_INIT;
+  gboolean done = FALSE;
+
+  /* Their children are watched, ghost pads would count buffers twice */
+  if (GST_IS_BIN (element))
+    return;
+
+  g_mutex_lock (&stats->lock);
+  if (g_object_get_qdata (G_OBJECT (element), element_stats_quark ())) {
+    g_mutex_unlock (&stats->lock);
+    return;
+  }
+
+  factory = gst_element_get_factory (element);
+  data = g_new0 (ElementData, 1);
+  data->stats = stats;
+  data->element = element;
+  data->name = gst_element_get_name (element);
+  data->factory = g_strdup (factory ?
+      gst_plugin_feature_get_name (factory) : G_OBJECT_TYPE_NAME (element));
+  element_data_reset (data);
+  g_ptr_array_add (stats->elements, data);
+  g_object_set_qdata (G_OBJECT (element), element_stats_quark (), data);
+  g_object_weak_ref (G_OBJECT (element), element_finalized_cb, data);
+  g_mutex_unlock (&stats->lock);
+
+  data->pad_added_id = g_signal_connect (element, "pad-added",
+      G_CALLBACK (pad_added_cb), data);
+
+  it = gst_element_iterate_pads (element);
+  while (!done) {
+    switch (gst_iterator_next (it, &item)) {
+      case GST_ITERATOR_OK:
+        watch_pad (data, g_value_get_object (&item));
+        g_value_reset (&item);
+        break;
+      case GST_ITERATOR_RESYNC:
+        gst_iterator_resync (it);
+        break;
+      default:
+        done = TRUE;
+        break;
+    }
+  }
+  g_value_unset (&item);
+  gst_iterator_free (it);
+}
+
+GstPlayerElementStats *
+gst_player_element_stats_new (void)
+{
+  GstPlayerElementStats *stats = g_new0 (GstPlayerElementStats, 1);
+
+  g_mutex_init (&stats->lock);
+  stats->elements = g_ptr_array_new ();
+  stats->threads =
+      g_ptr_array_new_with_free_func ((GDestroyNotify) thread_data_free);
+  stats->generation = g_atomic_int_add (&next_generation, 1);
+  stats->start = gst_util_get_timestamp ();
+
+  return stats;
+}
+
+/* Must be called after the pipeline is gone, the probes stay on elements
+ * that are still alive */
+void
+gst_player_element_stats_free (GstPlayerElementStats * stats)
+{
+  ElementData *data;
+  guint i;
+
+  for (i = 0; i < stats->elements->len; i++) {
+    data = g_ptr_array_index (stats->elements, i);
+    if (data->element) {
+      g_signal_handler_disconnect (data->element, data->pad_added_id);
+      g_object_weak_unref (G_OBJECT (data->element), element_finalized_cb,
+          data);
+      g_object_set_qdata (G_OBJECT (data->element), element_stats_quark (),
+          NULL);
+    }
+    element_data_free (data);
+  }
+  g_ptr_array_unref (stats->elements);
+  g_ptr_array_unref (stats->threads);
+  g_mutex_clear (&stats->lock);
+  g_free (stats);
+}
+
+/* Enabling starts a new measurement */
+void
+gst_player_element_stats_set_enabled (GstPlayerElementStats * stats,
+    gboolean enabled)
+{
+  ElementData *data;
+  guint i;
+
+  g_mutex_lock (&stats->lock);
+  if (enabled && !g_atomic_int_get (&stats->enabled)) {
+    for (i = stats->elements->len; i > 0; i--) {
+      data = g_ptr_array_index (stats->elements, i - 1);
+      if (data->element) {
+        element_data_reset (data);
+      } else {
+        element_data_free (data);
+        g_ptr_array_remove_index (stats->elements, i - 1);
+      }
+    }
+    /* Threads start over with their next buffer */
+    g_ptr_array_set_size (stats->threads, 0);
+    stats->generation = g_atomic_int_add (&next_generation, 1);
+    stats->start = gst_util_get_timestamp ();
+  }
+  g_atomic_int_set (&stats->enabled, enabled);
+  g_mutex_unlock (&stats->lock);
+}
+
+gboolean
+gst_player_element_stats_get_enabled (GstPlayerElementStats * stats)
+{
+  return g_atomic_int_get (&stats->enabled);
+}
+
+/* Adds elements of @bin that are not measured yet */
+void
+gst_player_element_stats_watch (GstPlayerElementStats * stats, GstBin * bin)
+{
+  GstIterator *it;
+  GValue item = G_VALUE_INIT;
+  gboolean done = FALSE;
+
+  if (!g_atomic_int_get (&stats->enabled))
+    return;
+
+  it = gst_bin_iterate_recurse (bin);
+  while (!done) {
+    switch (gst_iterator_next (it, &item)) {
+      case GST_ITERATOR_OK:
+        watch_element (stats, g_value_get_object (&item));
+        g_value_reset (&item);
+        break;
+      case GST_ITERATOR_RESYNC:
+        gst_iterator_resync (it);
+        break;
+      default:
+        done = TRUE;
+        break;
+    }
+  }
+  g_value_unset (&item);
+  gst_iterator_free (it);
+}
+
+static gint
+compare_cpu_time (gconstpointer a, gconstpointer b)
+{
+  const ElementData *da = *(const ElementData **) a;
+  const ElementData *db = *(const ElementData **) b;
+
+  if (da->cpu_time == db->cpu_time)
+    return 0;
+
+  return da->cpu_time > db->cpu_time ? -1 : 1;
+}
+
+static void
+append_structure (GValue * array, GstStructure * s)
+{
+  GValue v = G_VALUE_INIT;
+
+  g_value_init (&v, GST_TYPE_STRUCTURE);
+  g_value_take_boxed (&v, s);
+  gst_value_array_append_value (array, &v);
+  g_value_unset (&v);
+}
+
+static gdouble
+cpu_load (GstClockTime cpu_time, GstClockTime elapsed)
+{
+  return elapsed > 0 ? 100.0 * cpu_time / elapsed : 0.0;
+}
+
+/* Returns the table of elements by CPU time and of streaming threads */
+GstStructure *
+gst_player_element_stats_get (GstPlayerElementStats * stats)
+{
+  GValue elements = G_VALUE_INIT, threads = G_VALUE_INIT;
+  GstStructure *result;
+  GstClockTime elapsed;
+  ElementData *data;
+  ThreadData *thread;
+  GPtrArray *sorted;
+  guint i;
+
+  g_value_init (&elements, GST_TYPE_ARRAY);
+  g_value_init (&threads, GST_TYPE_ARRAY);
+
+  g_mutex_lock (&stats->lock);
+  elapsed = gst_util_get_timestamp () - stats->start;
+
+  sorted = g_ptr_array_sized_new (stats->elements->len);
+  for (i = 0; i < stats->elements->len; i++)
+    g_ptr_array_add (sorted, g_ptr_array_index (stats->elements, i));
+  g_ptr_array_sort (sorted, compare_cpu_time);
+
+  for (i = 0; i < sorted->len; i++) {
+    data = g_ptr_array_index (sorted, i);
+    append_structure (&elements, gst_structure_new ("element",
+            "name", G_TYPE_STRING, data->name,
+            "factory", G_TYPE_STRING, data->factory,
+            "cpu-time", G_TYPE_UINT64, data->cpu_time,
+            "cpu-load", G_TYPE_DOUBLE, cpu_load (data->cpu_time, elapsed),
+            "buffers", G_TYPE_UINT64, data->n_buffers,
+            "latency", G_TYPE_UINT64, data->n_latency ?
+            data->latency / data->n_latency : 0,
+            "max-latency", G_TYPE_UINT64, data->max_latency,
+            "removed", G_TYPE_BOOLEAN, data->element == NULL, NULL));
+  }
+  g_ptr_array_unref (sorted);
+
+  for (i = 0; i < stats->threads->len; i++) {
+    thread = g_ptr_array_index (stats->threads, i);
+    append_structure (&threads, gst_structure_new ("thread",
+            "name", G_TYPE_STRING, thread->name,
+            "cpu-time", G_TYPE_UINT64, thread->cpu_time,
+            "cpu-load", G_TYPE_DOUBLE, cpu_load (thread->cpu_time, elapsed),
+            NULL));
+  }
+  g_mutex_unlock (&stats->lock);
+
+  result = gst_structure_new ("application/x-gst-player-element-stats",
+      "time", G_TYPE_UINT64, elapsed, NULL);
+  gst_structure_take_value (result, "elements", &elements);
+  gst_structure_take_value (result, "threads", &threads);
+
+  return result;
+}
+
+/* Returns @dot, as written by gst_debug_bin_to_dot_data(), with the CPU
+ * load and latency added to the label of every measured element */
+gchar *
+gst_player_element_stats_annotate_dot (GstPlayerElementStats * stats,
+    const gchar * dot)
+{
+  GString *str = g_string_new (dot);
+  GstClockTime elapsed;
+  ElementData *data;
+  gchar *name, *cluster, *annotation;
+  const gchar *pos, *end;
+  guint i;
+
+  g_mutex_lock (&stats->lock);
+  elapsed = gst_util_get_timestamp () - stats->start;
+
+  for (i = 0; i < stats->elements->len; i++) {
+    data = g_ptr_array_index (stats->elements, i);
+    if (!data->element)
+      continue;
+
+    /* Named like gstdebugutils does */
+    name = g_strcanon (g_strdup_printf ("%s_%p", data->name, data->element),
+        G_CSET_A_2_Z G_CSET_a_2_z G_CSET_DIGITS "_", '_');
+    cluster = g_strdup_printf ("subgraph cluster_%s {", name);
+    pos = strstr (str->str, cluster);
+    if (pos)
+      pos = strstr (pos, "label=\"");
+    end = pos ? strstr (pos, "\";\n") : NULL;
+    if (end) {
+      annotation = g_strdup_printf ("\\ncpu %.1f%%, latency %.2f ms",
+          cpu_load (data->cpu_time, elapsed), data->n_latency ?
+          (gdouble) data->latency / data->n_latency / GST_MSECOND : 0.0);
+      g_string_insert (str, end - str->str, annotation);
+      g_free (annotation);
+    }
+    g_free (cluster);
+    g_free (name);
+  }
+  g_mutex_unlock (&stats->lock);
+
+  return g_string_free (str, FALSE);
+}
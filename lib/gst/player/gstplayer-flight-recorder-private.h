@@ -0,0 +1,51 @@
+/* GStreamer
+ *
+ * Copyright (C) 2015 Kim DaeHyun <jabiers87@gmail.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __GST_PLAYER_FLIGHT_RECORDER_PRIVATE_H__
+#define __GST_PLAYER_FLIGHT_RECORDER_PRIVATE_H__
+
+#include <gst/gst.h>
+
+typedef struct _GstPlayerFlightRecorder GstPlayerFlightRecorder;
+
+typedef enum
+{
+  FLIGHT_EVENT_STATE_CHANGED,   /* a: old GstState, b: new GstState */
+  FLIGHT_EVENT_PLAYER_STATE,    /* a: GstPlayerState */
+  FLIGHT_EVENT_BUFFERING,       /* a: percent */
+  FLIGHT_EVENT_POSITION,        /* position */
+  FLIGHT_EVENT_SEEK,            /* position: target, a: rate * 100 */
+  FLIGHT_EVENT_SEEK_DONE,       /* a: latency in ms */
+  FLIGHT_EVENT_EOS,
+  FLIGHT_EVENT_WARNING,         /* a: GError domain, b: code */
+  FLIGHT_EVENT_ERROR            /* a: GError domain, b: code */
+} GstPlayerFlightEvent;
+
+G_GNUC_INTERNAL GstPlayerFlightRecorder *
+gst_player_flight_recorder_new (void);
+G_GNUC_INTERNAL void gst_player_flight_recorder_free (GstPlayerFlightRecorder
+    * recorder);
+G_GNUC_INTERNAL void gst_player_flight_recorder_record (GstPlayerFlightRecorder
+    * recorder, GstPlayerFlightEvent event, gint a, gint b,
+    GstClockTime position);
+G_GNUC_INTERNAL gchar *
+gst_player_flight_recorder_dump (GstPlayerFlightRecorder * recorder);
+
+#endif
@@ -0,0 +1,171 @@
+/* GStreamer
+ *
+ * Copyright (C) 2015 Kim DaeHyun <jabiers87@gmail.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/* Flight recorder of player events.
+ *
+ * Events are written as fixed-size binary records into a ring that holds
+ * the last N_RECORDS of them, without locking, allocating or formatting,
+ * so recording can always stay enabled. A writer claims a slot by
+ * atomically incrementing the head and marks it complete by storing the
+ * sequence number of the event in it last. A reader only decodes slots
+ * whose sequence number is the expected one before and after copying, so
+ * slots that are overwritten meanwhile are skipped.
+ */
+
+#include "gstplayer-flight-recorder-private.h"
+#include "gstplayer.h"
+
+#include <string.h>
+
+/* Power of two */
+#define N_RECORDS 4096
+
+/* g_atomic_int_set() and g_atomic_int_get() only place a barrier before
+ * the access, the record data also must not move across the other side */
+#ifdef __GNUC__
+#define full_barrier() __sync_synchronize ()
+#else
+static gint barrier_dummy;
+#define full_barrier() g_atomic_int_add (&barrier_dummy, 0)
+#endif
+
+typedef struct
+{
+  gint seq;                     /* Atomic, 0 while written */
+  guint16 event;
+  gint a, b;
+  GstClockTime time;
+  GstClockTime position;
+} Record;
+
+struct _GstPlayerFlightRecorder
+{
+  gint head;                    /* Atomic */
+  GstClockTime start;
+  Record records[N_RECORDS];
+};
+
+GstPlayerFlightRecorder *
+gst_player_flight_recorder_new (void)
+{
+  GstPlayerFlightRecorder *recorder = g_new0 (GstPlayerFlightRecorder, 1);
+
+  recorder->start = gst_util_get_timestamp ();
+
+  return recorder;
+}
+
+void
+gst_player_flight_recorder_free (GstPlayerFlightRecorder * recorder)
+{
+  g_free (recorder);
+}
+
+/* Can be called from any thread */
+void
+gst_player_flight_recorder_record (GstPlayerFlightRecorder * recorder,
+    GstPlayerFlightEvent event, gint a, gint b, GstClockTime position)
+{
+  guint seq = (guint) g_atomic_int_add (&recorder->head, 1) + 1;
+  Record *record = &recorder->records[(seq - 1) & (N_RECORDS - 1)];
+
+  g_atomic_int_set (&record->seq, 0);
+  full_barrier ();
+  record->event = event;
+  record->a = a;
+  record->b = b;
+  record->time = gst_util_get_timestamp ();
+  record->position = position;
+  g_atomic_int_set (&record->seq, seq);
+}
+
+static void
+append_record (GString * str, const Record * record, GstClockTime start)
+{
+  GstClockTime time = record->time > start ? record->time - start : 0;
+
+  g_string_append_printf (str, "%" GST_TIME_FORMAT " ", GST_TIME_ARGS (time));
+
+  switch (record->event) {
+    case FLIGHT_EVENT_STATE_CHANGED:
+      g_string_append_printf (str, "state-changed %s -> %s",
+          gst_element_state_get_name (record->a),
+          gst_element_state_get_name (record->b));
+      break;
+    case FLIGHT_EVENT_PLAYER_STATE:
+      g_string_append_printf (str, "player-state %s",
+          gst_player_state_get_name (record->a));
+      break;
+    case FLIGHT_EVENT_BUFFERING:
+      g_string_append_printf (str, "buffering %d%%", record->a);
+      break;
+    case FLIGHT_EVENT_POSITION:
+      g_string_append_printf (str, "position %" GST_TIME_FORMAT,
+          GST_TIME_ARGS (record->position));
+      break;
+    case FLIGHT_EVENT_SEEK:
+      g_string_append_printf (str, "seek %" GST_TIME_FORMAT " rate %.2f",
+          GST_TIME_ARGS (record->position), record->a / 100.0);
+      break;
+    case FLIGHT_EVENT_SEEK_DONE:
+      g_string_append_printf (str, "seek-done after %d ms", record->a);
+      break;
+    case FLIGHT_EVENT_EOS:
+      g_string_append (str, "eos");
+      break;
+    case FLIGHT_EVENT_WARNING:
+    case FLIGHT_EVENT_ERROR:
+      g_string_append_printf (str, "%s %s %d",
+          record->event == FLIGHT_EVENT_ERROR ? "error" : "warning",
+          g_quark_to_string ((GQuark) record->a), record->b);
+      break;
+    default:
+      g_string_append_printf (str, "unknown %u", record->event);
+      break;
+  }
+
+  g_string_append_c (str, '\n');
+}
+
+/* Returns the recorded events decoded, one per line and oldest first */
+gchar *
+gst_player_flight_recorder_dump (GstPlayerFlightRecorder * recorder)
+{
+  GString *str = g_string_new (NULL);
+  guint head, seq, n;
+  Record *slot, record;
+
+  head = (guint) g_atomic_int_get (&recorder->head);
+  n = MIN (head, N_RECORDS);
+
+  for (seq = head - n + 1; seq != head + 1; seq++) {
+    slot = &recorder->records[(seq - 1) & (N_RECORDS - 1)];
+    if ((guint) g_atomic_int_get (&slot->seq) != seq)
+      continue;
+    full_barrier ();
+    memcpy (&record, slot, sizeof (Record));
+    if ((guint) g_atomic_int_get (&slot->seq) != seq)
+      continue;
+
+    append_record (str, &record, recorder->start);
+  }
+
+  return g_string_free (str, FALSE);
+}
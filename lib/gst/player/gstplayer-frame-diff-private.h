@@ -0,0 +1,41 @@
+/* GStreamer
+ *
+ * Copyright (C) 2015 Kim DaeHyun <jabiers87@gmail.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __GST_PLAYER_FRAME_DIFF_PRIVATE_H__
+#define __GST_PLAYER_FRAME_DIFF_PRIVATE_H__
+
+#include <gst/gst.h>
+#include <gst/video/video.h>
+
+/* Region of interest type of the dirty rectangles attached to changed
+ * frames */
+#define GST_PLAYER_FRAME_DIFF_DIRTY_ROI "dirty"
+
+typedef struct _GstPlayerFrameDiff GstPlayerFrameDiff;
+
+G_GNUC_INTERNAL GstPlayerFrameDiff * gst_player_frame_diff_new (void);
+G_GNUC_INTERNAL void gst_player_frame_diff_free (GstPlayerFrameDiff * diff);
+G_GNUC_INTERNAL void gst_player_frame_diff_reset (GstPlayerFrameDiff * diff);
+G_GNUC_INTERNAL gboolean gst_player_frame_diff_supports (const GstVideoInfo *
+    info);
+G_GNUC_INTERNAL gboolean gst_player_frame_diff_process (GstPlayerFrameDiff *
+    diff, const GstVideoInfo * info, GstBuffer * buffer, GArray * dirty);
+
+#endif
@@ -0,0 +1,264 @@
+/* GStreamer
+ *
+ * Copyright (C) 2015 Kim DaeHyun <jabiers87@gmail.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/* Detection of unchanged video frames, used to skip conversion and
+ * rendering of static screens.
+ *
+ * The first plane (luma for YUV formats) of each frame is compared in
+ * blocks of BLOCK_SIZE x BLOCK_SIZE pixels against the last frame that
+ * was let through, using the sum of absolute differences. Blocks whose
+ * SAD stays below a small threshold count as unchanged, so encoder noise
+ * on static content does not defeat detection. As the reference is only
+ * updated for frames that are let through, skipped frames can never drift
+ * further than the threshold from what is displayed.
+ */
+
+#include "gstplayer-frame-diff-private.h"
+
+#include <string.h>
+
+#if defined(__ARM_NEON__) || defined(__ARM_NEON)
+#include <arm_neon.h>
+#define HAVE_NEON 1
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define HAVE_SSE2 1
+#endif
+
+#define BLOCK_SIZE 16
+/* Average difference per byte of 1/16 */
+#define BLOCK_THRESHOLD_SHIFT 4
+/* Above this many rectangles only the bounding box is reported */
+#define MAX_DIRTY_RECTS 32
+
+struct _GstPlayerFrameDiff
+{
+  guint8 *reference;
+  gsize reference_size;
+  gint row_bytes, height;
+  gboolean valid;
+};
+
+static guint32
+sad_row (const guint8 * a, const guint8 * b, gint n)
+{
+  guint32 sad = 0;
+  gint i = 0;
+
+#if defined(HAVE_NEON)
+  uint16x8_t acc = vdupq_n_u16 (0);
+  uint32x4_t acc32;
+
+  for (; i + 16 <= n; i += 16)
+    acc = vpadalq_u8 (acc, vabdq_u8 (vld1q_u8 (a + i), vld1q_u8 (b + i)));
+
+  acc32 = vpaddlq_u16 (acc);
+  sad = vgetq_lane_u32 (acc32, 0) + vgetq_lane_u32 (acc32, 1) +
+      vgetq_lane_u32 (acc32, 2) + vgetq_lane_u32 (acc32, 3);
+#elif defined(HAVE_SSE2)
+  __m128i acc = _mm_setzero_si128 ();
+
+  for (; i + 16 <= n; i += 16)
+    acc = _mm_add_epi64 (acc,
+        _mm_sad_epu8 (_mm_loadu_si128 ((const __m128i *) (a + i)),
+            _mm_loadu_si128 ((const __m128i *) (b + i))));
+
+  sad = _mm_cvtsi128_si32 (acc) + _mm_cvtsi128_si32 (_mm_srli_si128 (acc, 8));
+#endif
+
+  for (; i < n; i++)
+    sad += ABS (a[i] - b[i]);
+
+  return sad;
+}
+
+static guint32
+sad_block (const guint8 * a, gint stride_a, const guint8 * b, gint stride_b,
+    gint width, gint height)
+{
+  guint32 sad = 0;
+  gint y;
+
+  for (y = 0; y < height; y++)
+    sad += sad_row (a + y * stride_a, b + y * stride_b, width);
+
+  return sad;
+}
+
+static void
+add_dirty_rect (GArray * dirty, gint x, gint y, gint w, gint h)
+{
+  GstVideoRectangle *last;
+  GstVideoRectangle rect;
+  guint i;
+
+  /* Extend a rectangle of the previous block row with the same horizontal
+   * extent, so that e.g. a changed column is one rectangle */
+  for (i = dirty->len; i > 0; i--) {
+    last = &g_array_index (dirty, GstVideoRectangle, i - 1);
+    if (last->y + last->h < y)
+      break;
+    if (last->x == x && last->w == w && last->y + last->h == y) {
+      last->h += h;
+      return;
+    }
+  }
+
+  rect.x = x;
+  rect.y = y;
+  rect.w = w;
+  rect.h = h;
+  g_array_append_val (dirty, rect);
+}
+
+static void
+collapse_dirty_rects (GArray * dirty)
+{
+  GstVideoRectangle bbox;
+  gint x2 = 0, y2 = 0;
+  guint i;
+
+  bbox = g_array_index (dirty, GstVideoRectangle, 0);
+  for (i = 0; i < dirty->len; i++) {
+    GstVideoRectangle *r = &g_array_index (dirty, GstVideoRectangle, i);
+
+    bbox.x = MIN (bbox.x, r->x);
+    bbox.y = MIN (bbox.y, r->y);
+    x2 = MAX (x2, r->x + r->w);
+    y2 = MAX (y2, r->y + r->h);
+  }
+  bbox.w = x2 - bbox.x;
+  bbox.h = y2 - bbox.y;
+
+  g_array_set_size (dirty, 0);
+  g_array_append_val (dirty, bbox);
+}
+
+GstPlayerFrameDiff *
+gst_player_frame_diff_new (void)
+{
+  return g_new0 (GstPlayerFrameDiff, 1);
+}
+
+void
+gst_player_frame_diff_free (GstPlayerFrameDiff * diff)
+{
+  g_free (diff->reference);
+  g_free (diff);
+}
+
+/* Forget the reference frame, the next frame always counts as changed */
+void
+gst_player_frame_diff_reset (GstPlayerFrameDiff * diff)
+{
+  diff->valid = FALSE;
+}
+
+gboolean
+gst_player_frame_diff_supports (const GstVideoInfo * info)
+{
+  return GST_VIDEO_INFO_FORMAT (info) != GST_VIDEO_FORMAT_UNKNOWN
+      && GST_VIDEO_INFO_FORMAT (info) != GST_VIDEO_FORMAT_ENCODED
+      && !GST_VIDEO_FORMAT_INFO_IS_COMPLEX (info->finfo)
+      && GST_VIDEO_INFO_COMP_PLANE (info, 0) == 0
+      && GST_VIDEO_INFO_COMP_PSTRIDE (info, 0) > 0;
+}
+
+/* Returns TRUE if @buffer differs from the last frame that was let through,
+ * and in that case fills @dirty with the changed rectangles in pixels. The
+ * buffer becomes the new reference then. */
+gboolean
+gst_player_frame_diff_process (GstPlayerFrameDiff * diff,
+    const GstVideoInfo * info, GstBuffer * buffer, GArray * dirty)
+{
+  GstVideoFrame frame;
+  const guint8 *data;
+  gint stride, pstride, row_bytes, width, height;
+  gint bx, by, bw, bh, run_start;
+  guint32 threshold;
+  gboolean changed = FALSE;
+  gint y;
+
+  g_array_set_size (dirty, 0);
+
+  if (!gst_video_frame_map (&frame, (GstVideoInfo *) info, buffer,
+          GST_MAP_READ))
+    return TRUE;
+
+  data = GST_VIDEO_FRAME_PLANE_DATA (&frame, 0);
+  stride = GST_VIDEO_FRAME_PLANE_STRIDE (&frame, 0);
+  pstride = GST_VIDEO_FRAME_COMP_PSTRIDE (&frame, 0);
+  width = GST_VIDEO_FRAME_COMP_WIDTH (&frame, 0);
+  height = GST_VIDEO_FRAME_COMP_HEIGHT (&frame, 0);
+  row_bytes = width * pstride;
+
+  if (!diff->valid || diff->row_bytes != row_bytes || diff->height != height) {
+    changed = TRUE;
+    add_dirty_rect (dirty, 0, 0, GST_VIDEO_INFO_WIDTH (info),
+        GST_VIDEO_INFO_HEIGHT (info));
+  } else {
+    for (by = 0; by < height; by += BLOCK_SIZE) {
+      bh = MIN (BLOCK_SIZE, height - by);
+      run_start = -1;
+
+      for (bx = 0; bx < width; bx += BLOCK_SIZE) {
+        gboolean block_changed;
+
+        bw = MIN (BLOCK_SIZE, width - bx);
+        threshold = (bw * pstride * bh) >> BLOCK_THRESHOLD_SHIFT;
+        block_changed =
+            sad_block (data + by * stride + bx * pstride, stride,
+            diff->reference + by * row_bytes + bx * pstride, row_bytes,
+            bw * pstride, bh) > threshold;
+
+        /* Consecutive changed blocks of a row form one rectangle */
+        if (block_changed && run_start < 0) {
+          run_start = bx;
+        } else if (!block_changed && run_start >= 0) {
+          add_dirty_rect (dirty, run_start, by, bx - run_start, bh);
+          run_start = -1;
+        }
+      }
+      if (run_start >= 0)
+        add_dirty_rect (dirty, run_start, by, width - run_start, bh);
+    }
+    changed = dirty->len > 0;
+  }
+
+  if (changed) {
+    if (diff->reference_size < (gsize) row_bytes * height) {
+      g_free (diff->reference);
+      diff->reference_size = (gsize) row_bytes * height;
+      diff->reference = g_malloc (diff->reference_size);
+    }
+    for (y = 0; y < height; y++)
+      memcpy (diff->reference + y * row_bytes, data + y * stride, row_bytes);
+    diff->row_bytes = row_bytes;
+    diff->height = height;
+    diff->valid = TRUE;
+
+    if (dirty->len > MAX_DIRTY_RECTS)
+      collapse_dirty_rects (dirty);
+  }
+
+  gst_video_frame_unmap (&frame);
+
+  return changed;
+}
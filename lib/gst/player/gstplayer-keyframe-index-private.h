@@ -0,0 +1,41 @@
+/* GStreamer
+ *
+ * Copyright (C) 2015 Kim DaeHyun <jabiers87@gmail.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __GST_PLAYER_KEYFRAME_INDEX_PRIVATE_H__
+#define __GST_PLAYER_KEYFRAME_INDEX_PRIVATE_H__
+
+#include <gst/gst.h>
+
+typedef struct _GstPlayerKeyframeIndex GstPlayerKeyframeIndex;
+
+G_GNUC_INTERNAL GstPlayerKeyframeIndex * gst_player_keyframe_index_new (const
+    gchar * uri);
+G_GNUC_INTERNAL GstPlayerKeyframeIndex *
+gst_player_keyframe_index_ref (GstPlayerKeyframeIndex * index);
+G_GNUC_INTERNAL void gst_player_keyframe_index_unref (GstPlayerKeyframeIndex *
+    index);
+G_GNUC_INTERNAL void gst_player_keyframe_index_attach (GstPlayerKeyframeIndex *
+    index, GstElement * flvdemux);
+G_GNUC_INTERNAL gboolean gst_player_keyframe_index_save (GstPlayerKeyframeIndex
+    * index);
+G_GNUC_INTERNAL void gst_player_keyframe_index_get_stats (GstPlayerKeyframeIndex
+    * index, guint * n_entries, gboolean * loaded);
+
+#endif
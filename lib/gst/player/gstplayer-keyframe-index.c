@@ -0,0 +1,541 @@
+/* GStreamer
+ *
+ * Copyright (C) 2015 Kim DaeHyun <jabiers87@gmail.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/* Keyframe index for FLV files without a keyframe table in their
+ * onMetaData.
+ *
+ * While playing, the FLV tag headers arriving at flvdemux are parsed and
+ * the timestamp and byte offset of every video keyframe is recorded. The
+ * index is stored in the user cache directory, keyed by a hash of the URI.
+ *
+ * When the URI is opened again, a script tag with an onMetaData
+ * "keyframes" object built from the stored index is inserted right after
+ * the FLV header. flvdemux takes its seek table from it, so seeks become a
+ * binary search in that table followed by a single byte range request,
+ * instead of scanning the file. The inserted tag shifts the byte positions
+ * flvdemux counts internally until the next seek, but the positions in the
+ * table are those of the original file and are the ones used for seeking.
+ *
+ * This only works when flvdemux is driven in push mode, which is the case
+ * for network streams. Local files are read in pull mode, where flvdemux
+ * builds its own index quickly.
+ *
+ * File format, little endian: "GPKI", version, number of entries, then for
+ * every entry the time in milliseconds and the byte offset, both as 32 bit
+ * deltas to the previous entry.
+ */
+
+#include "gstplayer-keyframe-index-private.h"
+
+#include <gst/base/gstbytereader.h>
+#include <gst/base/gstbytewriter.h>
+
+#include <string.h>
+
+GST_DEBUG_CATEGORY_STATIC (gst_player_keyframe_index_debug);
+#define GST_CAT_DEFAULT gst_player_keyframe_index_debug
+
+#define INDEX_MAGIC "GPKI"
+#define INDEX_VERSION 1
+
+#define FLV_HEADER_SIZE 9
+#define FLV_TAG_HEADER_SIZE 11
+#define FLV_TAG_AUDIO 8
+#define FLV_TAG_VIDEO 9
+#define FLV_TAG_SCRIPT 18
+
+typedef struct
+{
+  guint64 time;                 /* milliseconds */
+  guint64 offset;
+} IndexEntry;
+
+struct _GstPlayerKeyframeIndex
+{
+  volatile gint ref_count;
+  GMutex lock;
+
+  gchar *filename;
+  GArray *entries;              /* Sorted by time and offset */
+  gboolean loaded, dirty;
+
+  /* Tag parser state, only used from the streaming thread */
+  gboolean synced;
+  guint64 pos, next_tag;
+  guint8 header[FLV_TAG_HEADER_SIZE + 1];
+  guint header_fill;
+};
+
+static void
+ensure_debug_category (void)
+{
+  static gsize done = 0;
+
+  if (g_once_init_enter (&done)) {
+    GST_DEBUG_CATEGORY_INIT (gst_player_keyframe_index_debug,
+        "gst-player-keyframe-index", 0, "GstPlayer FLV keyframe index");
+    g_once_init_leave (&done, 1);
+  }
+}
+
+/* Returns the position of the first entry with a time >= @time */
+static guint
+find_entry (GArray * entries, guint64 time)
+{
+  guint lo = 0, hi = entries->len, mid;
+
+  while (lo < hi) {
+    mid = (lo + hi) / 2;
+    if (g_array_index (entries, IndexEntry, mid).time < time)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+
+  return lo;
+}
+
+static gboolean
+has_offset (GArray * entries, guint64 offset)
+{
+  guint lo = 0, hi = entries->len, mid;
+  guint64 o;
+
+  /* Offsets are sorted as well */
+  while (lo < hi) {
+    mid = (lo + hi) / 2;
+    o = g_array_index (entries, IndexEntry, mid).offset;
+    if (o == offset)
+      return TRUE;
+    else if (o < offset)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+
+  return FALSE;
+}
+
+static void
+load (GstPlayerKeyframeIndex * self)
+{
+  gchar *contents = NULL;
+  gsize length;
+  GstByteReader reader;
+  const guint8 *magic;
+  guint32 version, n_entries, dtime, doffset, i;
+  IndexEntry entry = { 0, 0 };
+
+  if (!g_file_get_contents (self->filename, &contents, &length, NULL))
+    return;
+
+  gst_byte_reader_init (&reader, (const guint8 *) contents, length);
+  if (!gst_byte_reader_get_data (&reader, 4, &magic)
+      || memcmp (magic, INDEX_MAGIC, 4) != 0
+      || !gst_byte_reader_get_uint32_le (&reader, &version)
+      || version != INDEX_VERSION
+      || !gst_byte_reader_get_uint32_le (&reader, &n_entries)
+      || gst_byte_reader_get_remaining (&reader) != n_entries * 8) {
+    GST_WARNING ("Invalid keyframe index %s", self->filename);
+    g_free (contents);
+    return;
+  }
+
+  g_array_set_size (self->entries, 0);
+  for (i = 0; i < n_entries; i++) {
+    gst_byte_reader_get_uint32_le (&reader, &dtime);
+    gst_byte_reader_get_uint32_le (&reader, &doffset);
+    if (i > 0 && (dtime == 0 || doffset == 0)) {
+      GST_WARNING ("Invalid keyframe index %s", self->filename);
+      g_array_set_size (self->entries, 0);
+      g_free (contents);
+      return;
+    }
+    entry.time += dtime;
+    entry.offset += doffset;
+    g_array_append_val (self->entries, entry);
+  }
+  g_free (contents);
+
+  self->loaded = self->entries->len > 0;
+  GST_DEBUG ("Loaded %u keyframes from %s", self->entries->len,
+      self->filename);
+}
+
+GstPlayerKeyframeIndex *
+gst_player_keyframe_index_new (const gchar * uri)
+{
+  GstPlayerKeyframeIndex *self;
+  gchar *checksum, *basename;
+
+  g_return_val_if_fail (uri != NULL, NULL);
+
+  ensure_debug_category ();
+
+  self = g_new0 (GstPlayerKeyframeIndex, 1);
+  self->ref_count = 1;
+  g_mutex_init (&self->lock);
+  self->entries = g_array_new (FALSE, FALSE, sizeof (IndexEntry));
+
+  checksum = g_compute_checksum_for_string (G_CHECKSUM_SHA1, uri, -1);
+  basename = g_strconcat (checksum, ".idx", NULL);
+  self->filename = g_build_filename (g_get_user_cache_dir (), "gst-player",
+      "keyframes", basename, NULL);
+  g_free (basename);
+  g_free (checksum);
+
+  load (self);
+
+  return self;
+}
+
+GstPlayerKeyframeIndex *
+gst_player_keyframe_index_ref (GstPlayerKeyframeIndex * self)
+{
+  g_atomic_int_inc (&self->ref_count);
+
+  return self;
+}
+
+void
+gst_player_keyframe_index_unref (GstPlayerKeyframeIndex * self)
+{
+  if (!g_atomic_int_dec_and_test (&self->ref_count))
+    return;
+
+  g_array_unref (self->entries);
+  g_free (self->filename);
+  g_mutex_clear (&self->lock);
+  g_free (self);
+}
+
+/* Must be called with lock */
+static void
+add_entry_locked (GstPlayerKeyframeIndex * self, guint64 time, guint64 offset)
+{
+  IndexEntry entry = { time, offset }, *e;
+  guint i = find_entry (self->entries, time);
+
+  if (i < self->entries->len) {
+    e = &g_array_index (self->entries, IndexEntry, i);
+    if (e->time == time && e->offset == offset)
+      return;
+  }
+
+  /* Both times and offsets must be increasing, otherwise the stored index
+   * is for an older version of the file */
+  if ((i < self->entries->len
+          && (g_array_index (self->entries, IndexEntry, i).time == time
+              || g_array_index (self->entries, IndexEntry, i).offset <= offset))
+      || (i > 0 && g_array_index (self->entries, IndexEntry, i - 1).offset
+          >= offset)) {
+    GST_WARNING ("Keyframe at %" G_GUINT64_FORMAT " ms, offset %"
+        G_GUINT64_FORMAT " does not match the index, discarding it", time,
+        offset);
+    g_array_set_size (self->entries, 0);
+    self->loaded = FALSE;
+    i = 0;
+  }
+
+  g_array_insert_val (self->entries, i, entry);
+  self->dirty = TRUE;
+}
+
+/* Script tag with an onMetaData "keyframes" object in the format flvdemux
+ * reads its seek table from */
+static GstBuffer *
+create_script_tag_locked (GstPlayerKeyframeIndex * self)
+{
+  GstByteWriter data, tag;
+  guint8 *payload;
+  guint i, size;
+
+  gst_byte_writer_init_with_size (&data, 64 + self->entries->len * 18, FALSE);
+
+  gst_byte_writer_put_uint8 (&data, 2);
+  gst_byte_writer_put_uint16_be (&data, 10);
+  gst_byte_writer_put_data (&data, (const guint8 *) "onMetaData", 10);
+
+  /* ECMA array with a single item */
+  gst_byte_writer_put_uint8 (&data, 8);
+  gst_byte_writer_put_uint32_be (&data, 1);
+  gst_byte_writer_put_uint16_be (&data, 9);
+  gst_byte_writer_put_data (&data, (const guint8 *) "keyframes", 9);
+
+  gst_byte_writer_put_uint8 (&data, 3);
+  gst_byte_writer_put_uint16_be (&data, 5);
+  gst_byte_writer_put_data (&data, (const guint8 *) "times", 5);
+  gst_byte_writer_put_uint8 (&data, 10);
+  gst_byte_writer_put_uint32_be (&data, self->entries->len);
+  for (i = 0; i < self->entries->len; i++) {
+    gst_byte_writer_put_uint8 (&data, 0);
+    gst_byte_writer_put_float64_be (&data,
+        g_array_index (self->entries, IndexEntry, i).time / 1000.0);
+  }
+
+  gst_byte_writer_put_uint16_be (&data, 13);
+  gst_byte_writer_put_data (&data, (const guint8 *) "filepositions", 13);
+  gst_byte_writer_put_uint8 (&data, 10);
+  gst_byte_writer_put_uint32_be (&data, self->entries->len);
+  for (i = 0; i < self->entries->len; i++) {
+    gst_byte_writer_put_uint8 (&data, 0);
+    gst_byte_writer_put_float64_be (&data,
+        g_array_index (self->entries, IndexEntry, i).offset);
+  }
+
+  /* End of the keyframes object and of the array */
+  gst_byte_writer_put_uint24_be (&data, 9);
+  gst_byte_writer_put_uint24_be (&data, 9);
+
+  size = gst_byte_writer_get_size (&data);
+  payload = gst_byte_writer_reset_and_get_data (&data);
+
+  gst_byte_writer_init_with_size (&tag, FLV_TAG_HEADER_SIZE + size + 4,
+      FALSE);
+  gst_byte_writer_put_uint8 (&tag, FLV_TAG_SCRIPT);
+  gst_byte_writer_put_uint24_be (&tag, size);
+  gst_byte_writer_put_uint32_be (&tag, 0);
+  gst_byte_writer_put_uint24_be (&tag, 0);
+  gst_byte_writer_put_data (&tag, payload, size);
+  gst_byte_writer_put_uint32_be (&tag, FLV_TAG_HEADER_SIZE + size);
+  g_free (payload);
+
+  return gst_byte_writer_reset_and_get_buffer (&tag);
+}
+
+/* Must be called with lock */
+static void
+parse_tag_header_locked (GstPlayerKeyframeIndex * self)
+{
+  const guint8 *h = self->header;
+  guint type = h[0] & 0x1f;
+  guint32 size = GST_READ_UINT24_BE (h + 1);
+  guint64 time = GST_READ_UINT24_BE (h + 4) | ((guint32) h[7] << 24);
+
+  if (type != FLV_TAG_AUDIO && type != FLV_TAG_VIDEO
+      && type != FLV_TAG_SCRIPT) {
+    GST_DEBUG ("Lost sync at offset %" G_GUINT64_FORMAT, self->next_tag);
+    self->synced = FALSE;
+    return;
+  }
+
+  /* Frame type 1 is a keyframe */
+  if (type == FLV_TAG_VIDEO && size > 0 && (h[FLV_TAG_HEADER_SIZE] >> 4) == 1)
+    add_entry_locked (self, time, self->next_tag);
+
+  self->next_tag += FLV_TAG_HEADER_SIZE + size + 4;
+}
+
+/* Must be called with lock */
+static void
+parse_buffer_locked (GstPlayerKeyframeIndex * self, GstBuffer * buffer)
+{
+  GstMapInfo map;
+  guint64 end, at;
+  guint n;
+
+  if (GST_BUFFER_OFFSET_IS_VALID (buffer)
+      && GST_BUFFER_OFFSET (buffer) != self->pos) {
+    self->pos = GST_BUFFER_OFFSET (buffer);
+    self->header_fill = 0;
+    /* After seeks to a known keyframe we're at a tag again */
+    self->synced = has_offset (self->entries, self->pos);
+    self->next_tag = self->pos;
+  } else if (self->pos == GST_BUFFER_OFFSET_NONE) {
+    return;
+  }
+
+  if (!gst_buffer_map (buffer, &map, GST_MAP_READ))
+    return;
+
+  if (self->pos == 0 && map.size >= FLV_HEADER_SIZE
+      && memcmp (map.data, "FLV", 3) == 0) {
+    self->synced = TRUE;
+    self->header_fill = 0;
+    /* Skip the header and the first previous tag size */
+    self->next_tag = GST_READ_UINT32_BE (map.data + 5) + 4;
+  }
+
+  end = self->pos + map.size;
+  while (self->synced) {
+    at = self->next_tag + self->header_fill;
+    if (at < self->pos) {
+      self->synced = FALSE;
+      break;
+    }
+    if (at >= end)
+      break;
+
+    n = MIN (sizeof (self->header) - self->header_fill, end - at);
+    memcpy (self->header + self->header_fill, map.data + (at - self->pos), n);
+    self->header_fill += n;
+    if (self->header_fill < sizeof (self->header))
+      break;
+
+    self->header_fill = 0;
+    parse_tag_header_locked (self);
+  }
+  self->pos = end;
+
+  gst_buffer_unmap (buffer, &map);
+}
+
+static GstPadProbeReturn
+flvdemux_sink_probe_cb (GstPad * pad, GstPadProbeInfo * info,
+    gpointer user_data)
+{
+  GstPlayerKeyframeIndex *self = user_data;
+  GstBuffer *buffer, *injected;
+  GstEvent *event;
+  gsize size;
+
+  g_mutex_lock (&self->lock);
+  if (!(GST_PAD_PROBE_INFO_TYPE (info) & GST_PAD_PROBE_TYPE_BUFFER)) {
+    event = GST_PAD_PROBE_INFO_EVENT (info);
+    if (GST_EVENT_TYPE (event) == GST_EVENT_FLUSH_STOP) {
+      self->synced = FALSE;
+      self->pos = GST_BUFFER_OFFSET_NONE;
+    }
+    g_mutex_unlock (&self->lock);
+    return GST_PAD_PROBE_OK;
+  }
+
+  buffer = GST_PAD_PROBE_INFO_BUFFER (info);
+  parse_buffer_locked (self, buffer);
+
+  /* Insert the seek table after the header and the first previous tag
+   * size */
+  size = gst_buffer_get_size (buffer);
+  if (self->loaded && GST_BUFFER_OFFSET (buffer) == 0
+      && size > FLV_HEADER_SIZE + 4
+      && gst_buffer_memcmp (buffer, 0, "FLV", 3) == 0) {
+    guint8 header[FLV_HEADER_SIZE];
+    guint32 header_size;
+
+    gst_buffer_extract (buffer, 0, header, FLV_HEADER_SIZE);
+    header_size = GST_READ_UINT32_BE (header + 5);
+
+    if (header_size + 4 < size) {
+      GST_DEBUG ("Inserting %u keyframes into the stream",
+          self->entries->len);
+
+      injected = gst_buffer_copy_region (buffer, GST_BUFFER_COPY_ALL, 0,
+          header_size + 4);
+      injected = gst_buffer_append (injected,
+          create_script_tag_locked (self));
+      injected = gst_buffer_append (injected,
+          gst_buffer_copy_region (buffer, GST_BUFFER_COPY_MEMORY,
+              header_size + 4, size - header_size - 4));
+      GST_BUFFER_OFFSET (injected) = 0;
+      GST_BUFFER_OFFSET_END (injected) = GST_BUFFER_OFFSET_NONE;
+
+      gst_buffer_unref (buffer);
+      GST_PAD_PROBE_INFO_DATA (info) = injected;
+    }
+  }
+  g_mutex_unlock (&self->lock);
+
+  return GST_PAD_PROBE_OK;
+}
+
+void
+gst_player_keyframe_index_attach (GstPlayerKeyframeIndex * self,
+    GstElement * flvdemux)
+{
+  GstPad *pad = gst_element_get_static_pad (flvdemux, "sink");
+
+  if (!pad)
+    return;
+
+  g_mutex_lock (&self->lock);
+  self->synced = FALSE;
+  self->pos = GST_BUFFER_OFFSET_NONE;
+  g_mutex_unlock (&self->lock);
+
+  gst_pad_add_probe (pad,
+      GST_PAD_PROBE_TYPE_PUSH | GST_PAD_PROBE_TYPE_BUFFER |
+      GST_PAD_PROBE_TYPE_EVENT_FLUSH, flvdemux_sink_probe_cb,
+      gst_player_keyframe_index_ref (self),
+      (GDestroyNotify) gst_player_keyframe_index_unref);
+  gst_object_unref (pad);
+}
+
+gboolean
+gst_player_keyframe_index_save (GstPlayerKeyframeIndex * self)
+{
+  GstByteWriter writer;
+  IndexEntry prev = { 0, 0 }, *e;
+  GError *err = NULL;
+  gchar *dirname;
+  guint8 *contents;
+  gboolean ret;
+  guint i, size;
+
+  g_mutex_lock (&self->lock);
+  if (!self->dirty || self->entries->len == 0) {
+    g_mutex_unlock (&self->lock);
+    return TRUE;
+  }
+
+  gst_byte_writer_init_with_size (&writer, 12 + self->entries->len * 8,
+      FALSE);
+  gst_byte_writer_put_data (&writer, (const guint8 *) INDEX_MAGIC, 4);
+  gst_byte_writer_put_uint32_le (&writer, INDEX_VERSION);
+  gst_byte_writer_put_uint32_le (&writer, self->entries->len);
+  for (i = 0; i < self->entries->len; i++) {
+    e = &g_array_index (self->entries, IndexEntry, i);
+    /* Keyframes are never 49 days or 4 GB apart */
+    gst_byte_writer_put_uint32_le (&writer, e->time - prev.time);
+    gst_byte_writer_put_uint32_le (&writer, e->offset - prev.offset);
+    prev = *e;
+  }
+  self->dirty = FALSE;
+  g_mutex_unlock (&self->lock);
+
+  size = gst_byte_writer_get_size (&writer);
+  contents = gst_byte_writer_reset_and_get_data (&writer);
+
+  dirname = g_path_get_dirname (self->filename);
+  g_mkdir_with_parents (dirname, 0700);
+  g_free (dirname);
+
+  ret = g_file_set_contents (self->filename, (const gchar *) contents, size,
+      &err);
+  if (!ret) {
+    GST_WARNING ("Failed to save keyframe index %s: %s", self->filename,
+        err->message);
+    g_clear_error (&err);
+  } else {
+    GST_DEBUG ("Saved %u keyframes to %s", (size - 12) / 8, self->filename);
+  }
+  g_free (contents);
+
+  return ret;
+}
+
+void
+gst_player_keyframe_index_get_stats (GstPlayerKeyframeIndex * self,
+    guint * n_entries, gboolean * loaded)
+{
+  g_mutex_lock (&self->lock);
+  *n_entries = self->entries->len;
+  *loaded = self->loaded;
+  g_mutex_unlock (&self->lock);
+}
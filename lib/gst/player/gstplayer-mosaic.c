@@ -0,0 +1,1139 @@
+/* GStreamer
+ *
+ * Copyright (C) 2015 Kim DaeHyun <jabiers87@gmail.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/**
+ * SECTION:gstplayer-mosaic
+ * @short_description: GStreamer Player Mosaic API
+ *
+ * A #GstPlayerMosaic shows many streams at once in a grid of tiles. All
+ * tiles are decoded in one pipeline and composited into one video sink,
+ * running on one clock. Audio is not decoded.
+ *
+ * Tiles are decoded at the stream resolution and scaled to the tile size
+ * right after the decoder, so only tile sized frames are queued and
+ * composited. Decoder threads and the total number of frames per second
+ * are limited by a budget, from which the focused tile gets the largest
+ * share.
+ */
+
+#include "gstplayer-mosaic.h"
+#include "gstplayer-plugin-loader.h"
+
+#include <gst/video/video.h>
+#include <gst/video/videooverlay.h>
+
+#include <string.h>
+
+GST_DEBUG_CATEGORY_STATIC (gst_player_mosaic_debug);
+#define GST_CAT_DEFAULT gst_player_mosaic_debug
+
+#define DEFAULT_WIDTH 1280
+#define DEFAULT_HEIGHT 720
+#define DEFAULT_FOCUS 0
+#define DEFAULT_FRAMERATE_BUDGET 120
+
+/* Part of the framerate budget reserved for the focused tile, which is not
+ * limited otherwise */
+#define FOCUS_FRAMERATE 30
+/* Tiles limited below this framerate don't decode non-reference frames */
+#define SKIP_NON_REFERENCE_FRAMERATE 15
+/* Decoded frames queued per tile before old ones are dropped */
+#define TILE_QUEUE_SIZE 3
+
+enum
+{
+  PROP_0,
+  PROP_WINDOW_HANDLE,
+  PROP_WIDTH,
+  PROP_HEIGHT,
+  PROP_FOCUS,
+  PROP_THREAD_BUDGET,
+  PROP_FRAMERATE_BUDGET,
+  PROP_PIPELINE,
+  PROP_LAST
+};
+
+typedef struct
+{
+  GstPlayerMosaic *mosaic;
+  guint id;
+
+  GstElement *bin;
+  GstElement *rate, *filter;
+  GstPad *mixer_pad;
+
+  /* Protected by the mosaic lock */
+  GstElement *decoder;
+  gint x, y, width, height;
+  gint max_rate;
+  guint n_threads;
+} MosaicTile;
+
+struct _GstPlayerMosaic
+{
+  GstObject parent;
+
+  gpointer window_handle;
+
+  GThread *thread;
+  GMutex lock;
+  GCond cond;
+  GMainContext *context;
+  GMainLoop *loop;
+
+  GstElement *pipeline;
+  GstElement *mixer;
+  GstElement *output_filter;
+
+  /* Protected by lock */
+  GList *tiles;
+  /* Tiles waiting to be removed from the pipeline */
+  GList *released_tiles;
+  guint next_tile_id;
+  guint focus;
+  gint width, height;
+  guint thread_budget;
+  guint framerate_budget;
+};
+
+struct _GstPlayerMosaicClass
+{
+  GstObjectClass parent_class;
+};
+
+#define parent_class gst_player_mosaic_parent_class
+G_DEFINE_TYPE (GstPlayerMosaic, gst_player_mosaic, GST_TYPE_OBJECT);
+
+static GParamSpec *param_specs[PROP_LAST] = { NULL, };
+
+static void gst_player_mosaic_dispose (GObject * object);
+static void gst_player_mosaic_finalize (GObject * object);
+static void gst_player_mosaic_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec);
+static void gst_player_mosaic_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec);
+static void gst_player_mosaic_constructed (GObject * object);
+
+static gpointer gst_player_mosaic_main (gpointer data);
+static void gst_player_mosaic_update_tiles_locked (GstPlayerMosaic * self);
+
+static void
+gst_player_mosaic_init (GstPlayerMosaic * self)
+{
+  g_mutex_init (&self->lock);
+  g_cond_init (&self->cond);
+
+  self->context = g_main_context_new ();
+  self->loop = g_main_loop_new (self->context, FALSE);
+
+  self->next_tile_id = 1;
+  self->focus = DEFAULT_FOCUS;
+  self->width = DEFAULT_WIDTH;
+  self->height = DEFAULT_HEIGHT;
+  self->thread_budget = g_get_num_processors ();
+  self->framerate_budget = DEFAULT_FRAMERATE_BUDGET;
+}
+
+static void
+gst_player_mosaic_class_init (GstPlayerMosaicClass * klass)
+{
+  GObjectClass *gobject_class = (GObjectClass *) klass;
+
+  gobject_class->set_property = gst_player_mosaic_set_property;
+  gobject_class->get_property = gst_player_mosaic_get_property;
+  gobject_class->dispose = gst_player_mosaic_dispose;
+  gobject_class->finalize = gst_player_mosaic_finalize;
+  gobject_class->constructed = gst_player_mosaic_constructed;
+
+  param_specs[PROP_WINDOW_HANDLE] =
+      g_param_spec_pointer ("window-handle", "Window Handle",
+      "Window handle to render the mosaic into",
+      G_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY | G_PARAM_STATIC_STRINGS);
+
+  param_specs[PROP_WIDTH] =
+      g_param_spec_int ("width", "Width", "Width of the whole mosaic",
+      16, G_MAXINT, DEFAULT_WIDTH, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS);
+
+  param_specs[PROP_HEIGHT] =
+      g_param_spec_int ("height", "Height", "Height of the whole mosaic",
+      16, G_MAXINT, DEFAULT_HEIGHT, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS);
+
+  param_specs[PROP_FOCUS] =
+      g_param_spec_uint ("focus", "Focus",
+      "Tile that gets the largest share of the budgets, 0 for none",
+      0, G_MAXUINT, DEFAULT_FOCUS, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS);
+
+  param_specs[PROP_THREAD_BUDGET] =
+      g_param_spec_uint ("thread-budget", "Thread budget",
+      "Number of decoder threads of all tiles together, every tile gets "
+      "at least one", 1, G_MAXUINT, g_get_num_processors (),
+      G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS);
+
+  param_specs[PROP_FRAMERATE_BUDGET] =
+      g_param_spec_uint ("framerate-budget", "Framerate budget",
+      "Frames per second of all tiles together, 0 for unlimited",
+      0, G_MAXUINT, DEFAULT_FRAMERATE_BUDGET,
+      G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS);
+
+  param_specs[PROP_PIPELINE] =
+      g_param_spec_object ("pipeline", "Pipeline",
+      "GStreamer pipeline that is used",
+      GST_TYPE_ELEMENT, G_PARAM_READABLE | G_PARAM_STATIC_STRINGS);
+
+  g_object_class_install_properties (gobject_class, PROP_LAST, param_specs);
+}
+
+static void
+gst_player_mosaic_dispose (GObject * object)
+{
+  GstPlayerMosaic *self = GST_PLAYER_MOSAIC (object);
+
+  if (self->loop) {
+    g_main_loop_quit (self->loop);
+
+    g_thread_join (self->thread);
+    self->thread = NULL;
+
+    g_main_loop_unref (self->loop);
+    self->loop = NULL;
+
+    g_main_context_unref (self->context);
+    self->context = NULL;
+  }
+
+  G_OBJECT_CLASS (parent_class)->dispose (object);
+}
+
+static void
+tile_free (MosaicTile * tile)
+{
+  if (tile->decoder)
+    gst_object_unref (tile->decoder);
+  gst_object_unref (tile->mixer_pad);
+  gst_object_unref (tile->bin);
+  g_free (tile);
+}
+
+static void
+gst_player_mosaic_finalize (GObject * object)
+{
+  GstPlayerMosaic *self = GST_PLAYER_MOSAIC (object);
+
+  g_list_free_full (self->tiles, (GDestroyNotify) tile_free);
+  g_list_free_full (self->released_tiles, (GDestroyNotify) tile_free);
+  if (self->pipeline)
+    gst_object_unref (self->pipeline);
+  g_mutex_clear (&self->lock);
+  g_cond_clear (&self->cond);
+
+  G_OBJECT_CLASS (parent_class)->finalize (object);
+}
+
+static GstBusSyncReply
+bus_sync_handler (GstBus * bus, GstMessage * msg, gpointer user_data)
+{
+  GstPlayerMosaic *self = GST_PLAYER_MOSAIC (user_data);
+
+  if (!gst_is_video_overlay_prepare_window_handle_message (msg))
+    return GST_BUS_PASS;
+
+  if (self->window_handle)
+    gst_video_overlay_set_window_handle (GST_VIDEO_OVERLAY (GST_MESSAGE_SRC
+            (msg)), (guintptr) self->window_handle);
+
+  gst_message_unref (msg);
+
+  return GST_BUS_DROP;
+}
+
+static const gchar *mosaic_features[] = {
+  "uridecodebin", "decodebin", "typefind", "queue", "videorate",
+  "videoscale", "capsfilter", "videoconvert", "fakesink", "autovideosink",
+  "compositor", "videomixer", NULL
+};
+
+static void
+gst_player_mosaic_constructed (GObject * object)
+{
+  GstPlayerMosaic *self = GST_PLAYER_MOSAIC (object);
+  GstElement *convert, *sink;
+  GstBus *bus;
+  guint i;
+
+  if (gst_player_plugin_loader_is_lazy ()) {
+    for (i = 0; mosaic_features[i]; i++)
+      gst_player_plugin_loader_ensure_feature (mosaic_features[i]);
+    gst_player_plugin_loader_ensure_klass ("Sink/Video");
+  }
+
+  self->pipeline = gst_pipeline_new ("mosaic");
+  gst_object_ref_sink (self->pipeline);
+
+  self->mixer = gst_element_factory_make ("compositor", "mixer");
+  if (!self->mixer)
+    self->mixer = gst_element_factory_make ("videomixer", "mixer");
+  self->output_filter = gst_element_factory_make ("capsfilter", NULL);
+  convert = gst_element_factory_make ("videoconvert", NULL);
+  sink = gst_element_factory_make ("autovideosink", NULL);
+
+  if (!self->mixer || !self->output_filter || !convert || !sink) {
+    GST_ERROR_OBJECT (self, "Missing elements for the mosaic pipeline");
+    if (self->mixer)
+      gst_object_unref (self->mixer);
+    if (self->output_filter)
+      gst_object_unref (self->output_filter);
+    if (convert)
+      gst_object_unref (convert);
+    if (sink)
+      gst_object_unref (sink);
+    self->mixer = self->output_filter = NULL;
+  } else {
+    /* Black instead of the checker pattern where no tile is */
+    g_object_set (self->mixer, "background", 1, NULL);
+    gst_bin_add_many (GST_BIN (self->pipeline), self->mixer,
+        self->output_filter, convert, sink, NULL);
+    gst_element_link_many (self->mixer, self->output_filter, convert, sink,
+        NULL);
+    g_mutex_lock (&self->lock);
+    gst_player_mosaic_update_tiles_locked (self);
+    g_mutex_unlock (&self->lock);
+  }
+
+  bus = gst_element_get_bus (self->pipeline);
+  gst_bus_set_sync_handler (bus, bus_sync_handler, self, NULL);
+  gst_object_unref (bus);
+
+  g_mutex_lock (&self->lock);
+  self->thread = g_thread_new ("GstPlayerMosaic", gst_player_mosaic_main, self);
+  while (!self->loop || !g_main_loop_is_running (self->loop))
+    g_cond_wait (&self->cond, &self->lock);
+  g_mutex_unlock (&self->lock);
+
+  G_OBJECT_CLASS (parent_class)->constructed (object);
+}
+
+static void
+set_decoder_property (GstElement * decoder, const gchar * name, gint value)
+{
+  GParamSpec *pspec;
+
+  pspec = g_object_class_find_property (G_OBJECT_GET_CLASS (decoder), name);
+  if (!pspec || !(pspec->flags & G_PARAM_WRITABLE))
+    return;
+
+  if (G_PARAM_SPEC_VALUE_TYPE (pspec) == G_TYPE_INT
+      || G_PARAM_SPEC_VALUE_TYPE (pspec) == G_TYPE_UINT
+      || G_IS_PARAM_SPEC_ENUM (pspec))
+    g_object_set (decoder, name, value, NULL);
+}
+
+/* Must be called with lock */
+static void
+tile_configure_skip_frame_locked (MosaicTile * tile)
+{
+  /* 1 is "Skip B-frames" for the libav decoders */
+  set_decoder_property (tile->decoder, "skip-frame",
+      tile->max_rate < SKIP_NON_REFERENCE_FRAMERATE ? 1 : 0);
+}
+
+/* Must be called with lock, before the decoder is opened. The libav
+ * decoders ignore changes of the thread count once they are open, so a
+ * tile keeps its thread count until it gets a new decoder */
+static void
+tile_configure_decoder_locked (MosaicTile * tile)
+{
+  /* libav calls it max-threads, vpx just threads */
+  set_decoder_property (tile->decoder, "max-threads", tile->n_threads);
+  set_decoder_property (tile->decoder, "threads", tile->n_threads);
+  tile_configure_skip_frame_locked (tile);
+}
+
+/* Must be called with lock */
+static void
+gst_player_mosaic_update_tiles_locked (GstPlayerMosaic * self)
+{
+  guint n_tiles, n_others, budget;
+  guint focus_threads, other_threads;
+  gint cols, rows, width, height, others_rate, i;
+  gboolean has_focus = FALSE;
+  GstCaps *caps;
+  GList *l;
+
+  caps = gst_caps_new_simple ("video/x-raw", "width", G_TYPE_INT, self->width,
+      "height", G_TYPE_INT, self->height, NULL);
+  g_object_set (self->output_filter, "caps", caps, NULL);
+  gst_caps_unref (caps);
+
+  n_tiles = g_list_length (self->tiles);
+  if (n_tiles == 0)
+    return;
+
+  for (l = self->tiles; l; l = l->next)
+    if (((MosaicTile *) l->data)->id == self->focus)
+      has_focus = TRUE;
+
+  /* Smallest square grid that fits all tiles */
+  cols = 1;
+  while (cols * cols < n_tiles)
+    cols++;
+  rows = (n_tiles + cols - 1) / cols;
+  width = MAX ((self->width / cols) & ~1, 2);
+  height = MAX ((self->height / rows) & ~1, 2);
+
+  n_others = has_focus ? n_tiles - 1 : n_tiles;
+
+  others_rate = G_MAXINT;
+  if (self->framerate_budget > 0 && n_others > 0) {
+    budget = self->framerate_budget;
+    if (has_focus)
+      budget = budget > FOCUS_FRAMERATE ? budget - FOCUS_FRAMERATE : 0;
+    others_rate = MAX (budget / n_others, 1);
+  }
+
+  if (has_focus) {
+    other_threads = 1;
+    focus_threads = self->thread_budget > n_others ?
+        self->thread_budget - n_others : 1;
+  } else {
+    other_threads = MAX (self->thread_budget / n_tiles, 1);
+    focus_threads = other_threads;
+  }
+
+  GST_DEBUG_OBJECT (self, "%u tiles of %dx%d, focus %u with %u threads, "
+      "others %d fps and %u threads", n_tiles, width, height, self->focus,
+      focus_threads, others_rate, other_threads);
+
+  caps = gst_caps_new_simple ("video/x-raw", "width", G_TYPE_INT, width,
+      "height", G_TYPE_INT, height, "pixel-aspect-ratio", GST_TYPE_FRACTION,
+      1, 1, NULL);
+
+  for (l = self->tiles, i = 0; l; l = l->next, i++) {
+    MosaicTile *tile = l->data;
+    gboolean focused = has_focus && tile->id == self->focus;
+
+    tile->x = (i % cols) * width;
+    tile->y = (i / cols) * height;
+    tile->width = width;
+    tile->height = height;
+    tile->max_rate = focused ? G_MAXINT : others_rate;
+    tile->n_threads = focused ? focus_threads : other_threads;
+
+    g_object_set (tile->filter, "caps", caps, NULL);
+    g_object_set (tile->rate, "max-rate", tile->max_rate, NULL);
+    g_object_set (tile->mixer_pad, "xpos", tile->x, "ypos", tile->y, NULL);
+    if (tile->decoder)
+      tile_configure_skip_frame_locked (tile);
+  }
+
+  gst_caps_unref (caps);
+}
+
+static void
+decodebin_element_added_cb (GstBin * bin, GstElement * element,
+    gpointer user_data)
+{
+  MosaicTile *tile = user_data;
+  GstElementFactory *factory = gst_element_get_factory (element);
+  const gchar *klass;
+
+  if (!factory)
+    return;
+
+  klass = gst_element_factory_get_metadata (factory,
+      GST_ELEMENT_METADATA_KLASS);
+  if (!klass || !strstr (klass, "Decoder") || !strstr (klass, "Video"))
+    return;
+
+  g_mutex_lock (&tile->mosaic->lock);
+  if (tile->decoder)
+    gst_object_unref (tile->decoder);
+  tile->decoder = gst_object_ref (element);
+  tile_configure_decoder_locked (tile);
+  g_mutex_unlock (&tile->mosaic->lock);
+}
+
+static void
+uridecodebin_element_added_cb (GstBin * bin, GstElement * element,
+    gpointer user_data)
+{
+  GstElementFactory *factory = gst_element_get_factory (element);
+
+  if (factory && !strcmp (GST_OBJECT_NAME (factory), "decodebin"))
+    g_signal_connect (element, "element-added",
+        G_CALLBACK (decodebin_element_added_cb), user_data);
+}
+
+/* Audio is exposed undecoded and discarded */
+static gboolean
+autoplug_continue_cb (GstElement * uridecodebin, GstPad * pad, GstCaps * caps,
+    gpointer user_data)
+{
+  GstStructure *s = gst_caps_get_structure (caps, 0);
+
+  return !g_str_has_prefix (gst_structure_get_name (s), "audio/");
+}
+
+static void
+uridecodebin_pad_added_cb (GstElement * uridecodebin, GstPad * pad,
+    gpointer user_data)
+{
+  MosaicTile *tile = user_data;
+  GstPad *sinkpad = NULL;
+  GstElement *fakesink;
+  GstCaps *caps;
+  gboolean is_video;
+
+  caps = gst_pad_get_current_caps (pad);
+  if (!caps)
+    caps = gst_pad_query_caps (pad, NULL);
+  is_video = !gst_caps_is_empty (caps)
+      && g_str_has_prefix (gst_structure_get_name (gst_caps_get_structure
+          (caps, 0)), "video/x-raw");
+  gst_caps_unref (caps);
+
+  if (is_video) {
+    sinkpad = gst_element_get_static_pad (tile->rate, "sink");
+    if (gst_pad_is_linked (sinkpad)) {
+      gst_object_unref (sinkpad);
+      sinkpad = NULL;
+    }
+  }
+
+  /* Only the first video stream is shown */
+  if (!sinkpad) {
+    fakesink = gst_element_factory_make ("fakesink", NULL);
+    g_object_set (fakesink, "sync", FALSE, "async", FALSE, NULL);
+    gst_bin_add (GST_BIN (tile->bin), fakesink);
+    gst_element_sync_state_with_parent (fakesink);
+    sinkpad = gst_element_get_static_pad (fakesink, "sink");
+  }
+
+  if (gst_pad_link (pad, sinkpad) != GST_PAD_LINK_OK)
+    GST_WARNING_OBJECT (tile->mosaic, "Tile %u: failed to link %s:%s",
+        tile->id, GST_DEBUG_PAD_NAME (pad));
+  gst_object_unref (sinkpad);
+}
+
+static MosaicTile *
+tile_new (GstPlayerMosaic * self, guint id, const gchar * uri)
+{
+  MosaicTile *tile;
+  GstElement *source, *queue, *rate, *scale, *filter;
+  GstPad *pad;
+  gchar *name;
+
+  gst_player_plugin_loader_ensure_uri (uri);
+  source = gst_element_factory_make ("uridecodebin", NULL);
+  queue = gst_element_factory_make ("queue", NULL);
+  rate = gst_element_factory_make ("videorate", NULL);
+  scale = gst_element_factory_make ("videoscale", NULL);
+  filter = gst_element_factory_make ("capsfilter", NULL);
+
+  if (!source || !queue || !rate || !scale || !filter) {
+    GST_ERROR_OBJECT (self, "Missing elements for a tile");
+    if (source)
+      gst_object_unref (source);
+    if (queue)
+      gst_object_unref (queue);
+    if (rate)
+      gst_object_unref (rate);
+    if (scale)
+      gst_object_unref (scale);
+    if (filter)
+      gst_object_unref (filter);
+    return NULL;
+  }
+
+  tile = g_new0 (MosaicTile, 1);
+  tile->mosaic = self;
+  tile->id = id;
+
+  name = g_strdup_printf ("tile%u", id);
+  tile->bin = gst_bin_new (name);
+  g_free (name);
+  gst_object_ref_sink (tile->bin);
+  tile->rate = rate;
+  tile->filter = filter;
+
+  g_object_set (source, "uri", uri, NULL);
+  /* Show the newest frames if compositing falls behind */
+  g_object_set (queue, "max-size-buffers", TILE_QUEUE_SIZE,
+      "max-size-bytes", 0, "max-size-time", (guint64) 0, "leaky", 2, NULL);
+  g_object_set (tile->rate, "drop-only", TRUE, NULL);
+
+  /* Frames are dropped and scaled down in the decoder thread already, so
+   * the queue only ever holds tile sized frames */
+  gst_bin_add_many (GST_BIN (tile->bin), source, tile->rate, scale,
+      tile->filter, queue, NULL);
+  gst_element_link_many (tile->rate, scale, tile->filter, queue, NULL);
+
+  pad = gst_element_get_static_pad (queue, "src");
+  gst_element_add_pad (tile->bin, gst_ghost_pad_new ("src", pad));
+  gst_object_unref (pad);
+
+  g_signal_connect (source, "autoplug-continue",
+      G_CALLBACK (autoplug_continue_cb), tile);
+  g_signal_connect (source, "element-added",
+      G_CALLBACK (uridecodebin_element_added_cb), tile);
+  g_signal_connect (source, "pad-added",
+      G_CALLBACK (uridecodebin_pad_added_cb), tile);
+
+  return tile;
+}
+
+static gboolean
+tile_remove_cb (gpointer user_data)
+{
+  MosaicTile *tile = user_data;
+  GstPlayerMosaic *self = tile->mosaic;
+
+  GST_DEBUG_OBJECT (self, "Removing tile %u", tile->id);
+
+  g_mutex_lock (&self->lock);
+  self->released_tiles = g_list_remove (self->released_tiles, tile);
+  g_mutex_unlock (&self->lock);
+
+  gst_element_set_state (tile->bin, GST_STATE_NULL);
+  gst_bin_remove (GST_BIN (self->pipeline), tile->bin);
+  gst_element_release_request_pad (self->mixer, tile->mixer_pad);
+
+  tile_free (tile);
+
+  return G_SOURCE_REMOVE;
+}
+
+/* Called once the tile is not pushing a frame into the mixer, possibly
+ * from its streaming thread. The tile can't be shut down from there. */
+static GstPadProbeReturn
+tile_idle_probe_cb (GstPad * pad, GstPadProbeInfo * info, gpointer user_data)
+{
+  MosaicTile *tile = user_data;
+
+  gst_pad_unlink (pad, tile->mixer_pad);
+  g_main_context_invoke (tile->mosaic->context, tile_remove_cb, tile);
+
+  return GST_PAD_PROBE_REMOVE;
+}
+
+/* Unlinks the tile from the mixer while it is idle and removes it from the
+ * pipeline in the mosaic thread */
+static void
+tile_release (GstPlayerMosaic * self, MosaicTile * tile)
+{
+  GstPad *pad;
+
+  GST_DEBUG_OBJECT (self, "Releasing tile %u", tile->id);
+
+  g_mutex_lock (&self->lock);
+  self->released_tiles = g_list_prepend (self->released_tiles, tile);
+  g_mutex_unlock (&self->lock);
+
+  pad = gst_element_get_static_pad (tile->bin, "src");
+  gst_pad_add_probe (pad, GST_PAD_PROBE_TYPE_IDLE, tile_idle_probe_cb, tile,
+      NULL);
+  gst_object_unref (pad);
+}
+
+static void
+error_cb (GstBus * bus, GstMessage * msg, gpointer user_data)
+{
+  GstPlayerMosaic *self = GST_PLAYER_MOSAIC (user_data);
+  MosaicTile *tile = NULL;
+  GError *err;
+  GList *l;
+
+  gst_message_parse_error (msg, &err, NULL);
+
+  /* A failing stream only takes down its own tile */
+  g_mutex_lock (&self->lock);
+  for (l = self->tiles; l; l = l->next) {
+    if (gst_object_has_ancestor (GST_MESSAGE_SRC (msg),
+            GST_OBJECT (((MosaicTile *) l->data)->bin))) {
+      tile = l->data;
+      self->tiles = g_list_delete_link (self->tiles, l);
+      gst_player_mosaic_update_tiles_locked (self);
+      break;
+    }
+  }
+  g_mutex_unlock (&self->lock);
+
+  if (tile) {
+    GST_WARNING_OBJECT (self, "Tile %u failed: %s", tile->id, err->message);
+    tile_release (self, tile);
+  } else {
+    GST_ERROR_OBJECT (self, "Error from %s: %s",
+        GST_OBJECT_NAME (GST_MESSAGE_SRC (msg)), err->message);
+  }
+
+  g_error_free (err);
+}
+
+static gboolean
+main_loop_running_cb (gpointer user_data)
+{
+  GstPlayerMosaic *self = GST_PLAYER_MOSAIC (user_data);
+
+  g_mutex_lock (&self->lock);
+  g_cond_signal (&self->cond);
+  g_mutex_unlock (&self->lock);
+
+  return G_SOURCE_REMOVE;
+}
+
+static gpointer
+gst_player_mosaic_main (gpointer data)
+{
+  GstPlayerMosaic *self = GST_PLAYER_MOSAIC (data);
+  GstBus *bus;
+  GSource *source;
+  GSource *bus_source;
+
+  g_main_context_push_thread_default (self->context);
+
+  source = g_idle_source_new ();
+  g_source_set_callback (source, (GSourceFunc) main_loop_running_cb, self,
+      NULL);
+  g_source_attach (source, self->context);
+  g_source_unref (source);
+
+  bus = gst_element_get_bus (self->pipeline);
+  bus_source = gst_bus_create_watch (bus);
+  g_source_set_callback (bus_source, (GSourceFunc) gst_bus_async_signal_func,
+      NULL, NULL);
+  g_source_attach (bus_source, self->context);
+
+  g_signal_connect (G_OBJECT (bus), "message::error", G_CALLBACK (error_cb),
+      self);
+
+  g_main_loop_run (self->loop);
+
+  g_signal_handlers_disconnect_by_data (bus, self);
+  g_source_destroy (bus_source);
+  g_source_unref (bus_source);
+  gst_object_unref (bus);
+
+  g_main_context_pop_thread_default (self->context);
+
+  gst_element_set_state (self->pipeline, GST_STATE_NULL);
+
+  return NULL;
+}
+
+static void
+gst_player_mosaic_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec)
+{
+  GstPlayerMosaic *self = GST_PLAYER_MOSAIC (object);
+
+  switch (prop_id) {
+    case PROP_WINDOW_HANDLE:
+      self->window_handle = g_value_get_pointer (value);
+      break;
+    case PROP_WIDTH:
+      g_mutex_lock (&self->lock);
+      self->width = g_value_get_int (value);
+      if (self->mixer)
+        gst_player_mosaic_update_tiles_locked (self);
+      g_mutex_unlock (&self->lock);
+      break;
+    case PROP_HEIGHT:
+      g_mutex_lock (&self->lock);
+      self->height = g_value_get_int (value);
+      if (self->mixer)
+        gst_player_mosaic_update_tiles_locked (self);
+      g_mutex_unlock (&self->lock);
+      break;
+    case PROP_FOCUS:
+      g_mutex_lock (&self->lock);
+      self->focus = g_value_get_uint (value);
+      GST_DEBUG_OBJECT (self, "Set focus=%u", self->focus);
+      if (self->mixer)
+        gst_player_mosaic_update_tiles_locked (self);
+      g_mutex_unlock (&self->lock);
+      break;
+    case PROP_THREAD_BUDGET:
+      g_mutex_lock (&self->lock);
+      self->thread_budget = g_value_get_uint (value);
+      if (self->mixer)
+        gst_player_mosaic_update_tiles_locked (self);
+      g_mutex_unlock (&self->lock);
+      break;
+    case PROP_FRAMERATE_BUDGET:
+      g_mutex_lock (&self->lock);
+      self->framerate_budget = g_value_get_uint (value);
+      if (self->mixer)
+        gst_player_mosaic_update_tiles_locked (self);
+      g_mutex_unlock (&self->lock);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+static void
+gst_player_mosaic_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec)
+{
+  GstPlayerMosaic *self = GST_PLAYER_MOSAIC (object);
+
+  switch (prop_id) {
+    case PROP_WINDOW_HANDLE:
+      g_value_set_pointer (value, self->window_handle);
+      break;
+    case PROP_WIDTH:
+      g_mutex_lock (&self->lock);
+      g_value_set_int (value, self->width);
+      g_mutex_unlock (&self->lock);
+      break;
+    case PROP_HEIGHT:
+      g_mutex_lock (&self->lock);
+      g_value_set_int (value, self->height);
+      g_mutex_unlock (&self->lock);
+      break;
+    case PROP_FOCUS:
+      g_mutex_lock (&self->lock);
+      g_value_set_uint (value, self->focus);
+      g_mutex_unlock (&self->lock);
+      break;
+    case PROP_THREAD_BUDGET:
+      g_mutex_lock (&self->lock);
+      g_value_set_uint (value, self->thread_budget);
+      g_mutex_unlock (&self->lock);
+      break;
+    case PROP_FRAMERATE_BUDGET:
+      g_mutex_lock (&self->lock);
+      g_value_set_uint (value, self->framerate_budget);
+      g_mutex_unlock (&self->lock);
+      break;
+    case PROP_PIPELINE:
+      g_value_set_object (value, self->pipeline);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+static gpointer
+gst_player_mosaic_init_once (gpointer user_data)
+{
+  gst_init (NULL, NULL);
+
+  GST_DEBUG_CATEGORY_INIT (gst_player_mosaic_debug, "gst-player-mosaic", 0,
+      "GstPlayer Mosaic");
+
+  return NULL;
+}
+
+/**
+ * gst_player_mosaic_new:
+ * @window_handle: (allow-none): window handle to render into
+ *
+ * Returns: a new #GstPlayerMosaic instance
+ */
+GstPlayerMosaic *
+gst_player_mosaic_new (gpointer window_handle)
+{
+  static GOnce once = G_ONCE_INIT;
+
+  g_once (&once, gst_player_mosaic_init_once, NULL);
+
+  return g_object_new (GST_TYPE_PLAYER_MOSAIC, "window-handle", window_handle,
+      NULL);
+}
+
+/**
+ * gst_player_mosaic_play:
+ * @mosaic: #GstPlayerMosaic instance
+ *
+ * Starts playing all tiles.
+ */
+void
+gst_player_mosaic_play (GstPlayerMosaic * self)
+{
+  g_return_if_fail (GST_IS_PLAYER_MOSAIC (self));
+
+  if (gst_element_set_state (self->pipeline,
+          GST_STATE_PLAYING) == GST_STATE_CHANGE_FAILURE)
+    GST_ERROR_OBJECT (self, "Failed to play");
+}
+
+/**
+ * gst_player_mosaic_stop:
+ * @mosaic: #GstPlayerMosaic instance
+ *
+ * Stops playing all tiles.
+ */
+void
+gst_player_mosaic_stop (GstPlayerMosaic * self)
+{
+  g_return_if_fail (GST_IS_PLAYER_MOSAIC (self));
+
+  gst_element_set_state (self->pipeline, GST_STATE_READY);
+}
+
+/**
+ * gst_player_mosaic_add_tile:
+ * @mosaic: #GstPlayerMosaic instance
+ * @uri: URI of the stream
+ *
+ * Adds a tile showing @uri. The tiles are rearranged to make room for it.
+ *
+ * Returns: an identifier of the new tile, or 0 on failure
+ */
+guint
+gst_player_mosaic_add_tile (GstPlayerMosaic * self, const gchar * uri)
+{
+  MosaicTile *tile;
+  GstPad *pad;
+  guint id;
+
+  g_return_val_if_fail (GST_IS_PLAYER_MOSAIC (self), 0);
+  g_return_val_if_fail (uri != NULL, 0);
+
+  if (!self->mixer)
+    return 0;
+
+  g_mutex_lock (&self->lock);
+  id = self->next_tile_id++;
+  g_mutex_unlock (&self->lock);
+
+  tile = tile_new (self, id, uri);
+  if (!tile)
+    return 0;
+
+  tile->mixer_pad = gst_element_get_request_pad (self->mixer, "sink_%u");
+
+  gst_bin_add (GST_BIN (self->pipeline), tile->bin);
+  pad = gst_element_get_static_pad (tile->bin, "src");
+  gst_pad_link (pad, tile->mixer_pad);
+  gst_object_unref (pad);
+
+  g_mutex_lock (&self->lock);
+  self->tiles = g_list_append (self->tiles, tile);
+  gst_player_mosaic_update_tiles_locked (self);
+  g_mutex_unlock (&self->lock);
+
+  GST_DEBUG_OBJECT (self, "Added tile %u for '%s'", id, uri);
+
+  gst_element_sync_state_with_parent (tile->bin);
+
+  return id;
+}
+
+/**
+ * gst_player_mosaic_remove_tile:
+ * @mosaic: #GstPlayerMosaic instance
+ * @tile: identifier of the tile
+ *
+ * Removes @tile and rearranges the remaining ones. The tile is taken out
+ * of the pipeline as soon as it is not pushing a frame.
+ *
+ * Returns: %TRUE if the tile was removed
+ */
+gboolean
+gst_player_mosaic_remove_tile (GstPlayerMosaic * self, guint id)
+{
+  MosaicTile *tile = NULL;
+  GList *l;
+
+  g_return_val_if_fail (GST_IS_PLAYER_MOSAIC (self), FALSE);
+
+  g_mutex_lock (&self->lock);
+  for (l = self->tiles; l; l = l->next) {
+    if (((MosaicTile *) l->data)->id == id) {
+      tile = l->data;
+      self->tiles = g_list_delete_link (self->tiles, l);
+      gst_player_mosaic_update_tiles_locked (self);
+      break;
+    }
+  }
+  g_mutex_unlock (&self->lock);
+
+  if (!tile)
+    return FALSE;
+
+  tile_release (self, tile);
+
+  return TRUE;
+}
+
+/**
+ * gst_player_mosaic_get_n_tiles:
+ * @mosaic: #GstPlayerMosaic instance
+ *
+ * Returns: the number of tiles
+ */
+guint
+gst_player_mosaic_get_n_tiles (GstPlayerMosaic * self)
+{
+  guint n_tiles;
+
+  g_return_val_if_fail (GST_IS_PLAYER_MOSAIC (self), 0);
+
+  g_mutex_lock (&self->lock);
+  n_tiles = g_list_length (self->tiles);
+  g_mutex_unlock (&self->lock);
+
+  return n_tiles;
+}
+
+/**
+ * gst_player_mosaic_set_focus:
+ * @mosaic: #GstPlayerMosaic instance
+ * @tile: identifier of the tile, or 0 for none
+ *
+ * Sets the tile the user is looking at. It is not limited by the
+ * framerate budget and gets all decoder threads the other tiles don't
+ * need.
+ */
+void
+gst_player_mosaic_set_focus (GstPlayerMosaic * self, guint tile)
+{
+  g_return_if_fail (GST_IS_PLAYER_MOSAIC (self));
+
+  g_object_set (self, "focus", tile, NULL);
+}
+
+/**
+ * gst_player_mosaic_get_focus:
+ * @mosaic: #GstPlayerMosaic instance
+ *
+ * Returns: the identifier of the focused tile, or 0 for none
+ */
+guint
+gst_player_mosaic_get_focus (GstPlayerMosaic * self)
+{
+  guint tile;
+
+  g_return_val_if_fail (GST_IS_PLAYER_MOSAIC (self), DEFAULT_FOCUS);
+
+  g_object_get (self, "focus", &tile, NULL);
+
+  return tile;
+}
+
+/**
+ * gst_player_mosaic_set_size:
+ * @mosaic: #GstPlayerMosaic instance
+ * @width: width of the whole mosaic
+ * @height: height of the whole mosaic
+ *
+ * Sets the output size. Tiles are scaled to fit this size, so it
+ * should match the size of the window.
+ */
+void
+gst_player_mosaic_set_size (GstPlayerMosaic * self, gint width, gint height)
+{
+  g_return_if_fail (GST_IS_PLAYER_MOSAIC (self));
+
+  g_object_set (self, "width", width, "height", height, NULL);
+}
+
+/**
+ * gst_player_mosaic_set_thread_budget:
+ * @mosaic: #GstPlayerMosaic instance
+ * @n_threads: number of decoder threads
+ *
+ * Sets the number of decoder threads of all tiles together. Every tile
+ * gets one thread, the focused one all that remain. Defaults to the
+ * number of processors.
+ */
+void
+gst_player_mosaic_set_thread_budget (GstPlayerMosaic * self, guint n_threads)
+{
+  g_return_if_fail (GST_IS_PLAYER_MOSAIC (self));
+
+  g_object_set (self, "thread-budget", n_threads, NULL);
+}
+
+/**
+ * gst_player_mosaic_get_thread_budget:
+ * @mosaic: #GstPlayerMosaic instance
+ *
+ * Returns: the number of decoder threads of all tiles together
+ */
+guint
+gst_player_mosaic_get_thread_budget (GstPlayerMosaic * self)
+{
+  guint n_threads;
+
+  g_return_val_if_fail (GST_IS_PLAYER_MOSAIC (self), 1);
+
+  g_object_get (self, "thread-budget", &n_threads, NULL);
+
+  return n_threads;
+}
+
+/**
+ * gst_player_mosaic_set_framerate_budget:
+ * @mosaic: #GstPlayerMosaic instance
+ * @fps: frames per second, 0 for unlimited
+ *
+ * Sets the number of frames per second all tiles together may show. The
+ * budget is shared evenly by the tiles that don't have the focus, after
+ * reserving 30 fps for the focused one. Tiles limited to less than 15 fps
+ * also skip decoding of non-reference frames if the decoder supports it.
+ */
+void
+gst_player_mosaic_set_framerate_budget (GstPlayerMosaic * self, guint fps)
+{
+  g_return_if_fail (GST_IS_PLAYER_MOSAIC (self));
+
+  g_object_set (self, "framerate-budget", fps, NULL);
+}
+
+/**
+ * gst_player_mosaic_get_framerate_budget:
+ * @mosaic: #GstPlayerMosaic instance
+ *
+ * Returns: the frames per second of all tiles together, 0 if unlimited
+ */
+guint
+gst_player_mosaic_get_framerate_budget (GstPlayerMosaic * self)
+{
+  guint fps;
+
+  g_return_val_if_fail (GST_IS_PLAYER_MOSAIC (self),
+      DEFAULT_FRAMERATE_BUDGET);
+
+  g_object_get (self, "framerate-budget", &fps, NULL);
+
+  return fps;
+}
+
+/**
+ * gst_player_mosaic_get_pipeline:
+ * @mosaic: #GstPlayerMosaic instance
+ *
+ * Returns: (transfer full): The internal pipeline
+ */
+GstElement *
+gst_player_mosaic_get_pipeline (GstPlayerMosaic * self)
+{
+  GstElement *val;
+
+  g_return_val_if_fail (GST_IS_PLAYER_MOSAIC (self), NULL);
+
+  g_object_get (self, "pipeline", &val, NULL);
+
+  return val;
+}
@@ -0,0 +1,72 @@
+/* GStreamer
+ *
+ * Copyright (C) 2015 Kim DaeHyun <jabiers87@gmail.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __GST_PLAYER_MOSAIC_H__
+#define __GST_PLAYER_MOSAIC_H__
+
+#include <gst/gst.h>
+
+G_BEGIN_DECLS
+
+typedef struct _GstPlayerMosaic GstPlayerMosaic;
+typedef struct _GstPlayerMosaicClass GstPlayerMosaicClass;
+
+#define GST_TYPE_PLAYER_MOSAIC             (gst_player_mosaic_get_type ())
+#define GST_IS_PLAYER_MOSAIC(obj)          (G_TYPE_CHECK_INSTANCE_TYPE ((obj), GST_TYPE_PLAYER_MOSAIC))
+#define GST_IS_PLAYER_MOSAIC_CLASS(klass)  (G_TYPE_CHECK_CLASS_TYPE ((klass), GST_TYPE_PLAYER_MOSAIC))
+#define GST_PLAYER_MOSAIC_GET_CLASS(obj)   (G_TYPE_INSTANCE_GET_CLASS ((obj), GST_TYPE_PLAYER_MOSAIC, GstPlayerMosaicClass))
+#define GST_PLAYER_MOSAIC(obj)             (G_TYPE_CHECK_INSTANCE_CAST ((obj), GST_TYPE_PLAYER_MOSAIC, GstPlayerMosaic))
+#define GST_PLAYER_MOSAIC_CLASS(klass)     (G_TYPE_CHECK_CLASS_CAST ((klass), GST_TYPE_PLAYER_MOSAIC, GstPlayerMosaicClass))
+#define GST_PLAYER_MOSAIC_CAST(obj)        ((GstPlayerMosaic*)(obj))
+
+GType        gst_player_mosaic_get_type                (void);
+
+GstPlayerMosaic * gst_player_mosaic_new                (gpointer window_handle);
+
+void         gst_player_mosaic_play                    (GstPlayerMosaic * mosaic);
+void         gst_player_mosaic_stop                    (GstPlayerMosaic * mosaic);
+
+guint        gst_player_mosaic_add_tile                (GstPlayerMosaic * mosaic,
+                                                        const gchar * uri);
+gboolean     gst_player_mosaic_remove_tile             (GstPlayerMosaic * mosaic,
+                                                        guint tile);
+guint        gst_player_mosaic_get_n_tiles             (GstPlayerMosaic * mosaic);
+
+void         gst_player_mosaic_set_focus               (GstPlayerMosaic * mosaic,
+                                                        guint tile);
+guint        gst_player_mosaic_get_focus               (GstPlayerMosaic * mosaic);
+
+void         gst_player_mosaic_set_size                (GstPlayerMosaic * mosaic,
+                                                        gint width,
+                                                        gint height);
+
+void         gst_player_mosaic_set_thread_budget       (GstPlayerMosaic * mosaic,
+                                                        guint n_threads);
+guint        gst_player_mosaic_get_thread_budget       (GstPlayerMosaic * mosaic);
+
+void         gst_player_mosaic_set_framerate_budget    (GstPlayerMosaic * mosaic,
+                                                        guint fps);
+guint        gst_player_mosaic_get_framerate_budget    (GstPlayerMosaic * mosaic);
+
+GstElement * gst_player_mosaic_get_pipeline            (GstPlayerMosaic * mosaic);
+
+G_END_DECLS
+
+#endif /* __GST_PLAYER_MOSAIC_H__ */
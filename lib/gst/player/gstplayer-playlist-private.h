@@ -0,0 +1,35 @@
+/* GStreamer
+ *
+ * Copyright (C) 2015 Kim DaeHyun <jabiers87@gmail.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __GST_PLAYER_PLAYLIST_PRIVATE_H__
+#define __GST_PLAYER_PLAYLIST_PRIVATE_H__
+
+#include "gstplayer-playlist.h"
+
+G_GNUC_INTERNAL gchar * gst_player_playlist_get_adjacent (GstPlayerPlaylist *
+    playlist, gint direction, gboolean automatic, gint * index);
+G_GNUC_INTERNAL void gst_player_playlist_set_current_index (GstPlayerPlaylist *
+    playlist, gint index);
+G_GNUC_INTERNAL void gst_player_playlist_set_pending_index (GstPlayerPlaylist *
+    playlist, gint index);
+G_GNUC_INTERNAL gint gst_player_playlist_make_pending_current (GstPlayerPlaylist
+    * playlist);
+
+#endif
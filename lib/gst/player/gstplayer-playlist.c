@@ -0,0 +1,398 @@
+/* GStreamer
+ *
+ * Copyright (C) 2015 Kim DaeHyun <jabiers87@gmail.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/**
+ * SECTION:gstplayer-playlist
+ * @short_description: GStreamer Player Playlist API
+ *
+ * A #GstPlayerPlaylist is set on a #GstPlayer with
+ * gst_player_set_playlist(). The player then plays its items one after
+ * another, preparing the next item while the current one is still playing
+ * so there is no gap between them. The playlist can be modified at any
+ * time, also while it is being played.
+ */
+
+#include "gstplayer-playlist.h"
+#include "gstplayer-playlist-private.h"
+
+struct _GstPlayerPlaylist
+{
+  GObject parent;
+
+  GMutex lock;
+  GPtrArray *uris;
+  gint current;
+  gint pending;                 /* Prepared to play next, -1 if none */
+  GstPlayerPlaylistRepeat repeat;
+};
+
+struct _GstPlayerPlaylistClass
+{
+  GObjectClass parent_class;
+};
+
+G_DEFINE_TYPE (GstPlayerPlaylist, gst_player_playlist, G_TYPE_OBJECT);
+
+static void
+gst_player_playlist_init (GstPlayerPlaylist * playlist)
+{
+  g_mutex_init (&playlist->lock);
+  playlist->uris = g_ptr_array_new_with_free_func (g_free);
+  playlist->current = -1;
+  playlist->pending = -1;
+  playlist->repeat = GST_PLAYER_PLAYLIST_REPEAT_NONE;
+}
+
+static void
+gst_player_playlist_finalize (GObject * object)
+{
+  GstPlayerPlaylist *playlist = GST_PLAYER_PLAYLIST (object);
+
+  g_ptr_array_unref (playlist->uris);
+  g_mutex_clear (&playlist->lock);
+
+  G_OBJECT_CLASS (gst_player_playlist_parent_class)->finalize (object);
+}
+
+static void
+gst_player_playlist_class_init (GstPlayerPlaylistClass * klass)
+{
+  GObjectClass *gobject_class = (GObjectClass *) klass;
+
+  gobject_class->finalize = gst_player_playlist_finalize;
+}
+
+/**
+ * gst_player_playlist_new:
+ *
+ * Returns: a new, empty #GstPlayerPlaylist
+ */
+GstPlayerPlaylist *
+gst_player_playlist_new (void)
+{
+  return g_object_new (GST_TYPE_PLAYER_PLAYLIST, NULL);
+}
+
+/**
+ * gst_player_playlist_append:
+ * @playlist: a #GstPlayerPlaylist
+ * @uri: URI to queue
+ *
+ * Queues @uri at the end of @playlist.
+ */
+void
+gst_player_playlist_append (GstPlayerPlaylist * playlist, const gchar * uri)
+{
+  gst_player_playlist_insert (playlist, -1, uri);
+}
+
+/**
+ * gst_player_playlist_insert:
+ * @playlist: a #GstPlayerPlaylist
+ * @index: position to insert at, -1 to append
+ * @uri: URI to queue
+ *
+ * Inserts @uri at @index in @playlist.
+ */
+void
+gst_player_playlist_insert (GstPlayerPlaylist * playlist, gint index,
+    const gchar * uri)
+{
+  g_return_if_fail (GST_IS_PLAYER_PLAYLIST (playlist));
+  g_return_if_fail (uri != NULL);
+
+  g_mutex_lock (&playlist->lock);
+  if (index < 0 || index > (gint) playlist->uris->len)
+    index = playlist->uris->len;
+  g_ptr_array_insert (playlist->uris, index, g_strdup (uri));
+  if (index <= playlist->current)
+    playlist->current++;
+  if (playlist->pending >= 0 && index <= playlist->pending)
+    playlist->pending++;
+  g_mutex_unlock (&playlist->lock);
+}
+
+/**
+ * gst_player_playlist_remove:
+ * @playlist: a #GstPlayerPlaylist
+ * @index: position of the item to remove
+ *
+ * Removes the item at @index from @playlist. Removing the current item
+ * does not stop its playback, the item after it is played next.
+ *
+ * Returns: %TRUE if an item was removed.
+ */
+gboolean
+gst_player_playlist_remove (GstPlayerPlaylist * playlist, guint index)
+{
+  g_return_val_if_fail (GST_IS_PLAYER_PLAYLIST (playlist), FALSE);
+
+  g_mutex_lock (&playlist->lock);
+  if (index >= playlist->uris->len) {
+    g_mutex_unlock (&playlist->lock);
+    return FALSE;
+  }
+
+  g_ptr_array_remove_index (playlist->uris, index);
+  if ((gint) index <= playlist->current)
+    playlist->current--;
+  /* Like the current item a removed pending item still plays, the item
+   * after it follows */
+  if (playlist->pending >= 0 && (gint) index <= playlist->pending)
+    playlist->pending--;
+  g_mutex_unlock (&playlist->lock);
+
+  return TRUE;
+}
+
+/**
+ * gst_player_playlist_clear:
+ * @playlist: a #GstPlayerPlaylist
+ *
+ * Removes all items from @playlist.
+ */
+void
+gst_player_playlist_clear (GstPlayerPlaylist * playlist)
+{
+  g_return_if_fail (GST_IS_PLAYER_PLAYLIST (playlist));
+
+  g_mutex_lock (&playlist->lock);
+  g_ptr_array_set_size (playlist->uris, 0);
+  playlist->current = -1;
+  playlist->pending = -1;
+  g_mutex_unlock (&playlist->lock);
+}
+
+/**
+ * gst_player_playlist_get_n_items:
+ * @playlist: a #GstPlayerPlaylist
+ *
+ * Returns: the number of items in @playlist.
+ */
+guint
+gst_player_playlist_get_n_items (GstPlayerPlaylist * playlist)
+{
+  guint n_items;
+
+  g_return_val_if_fail (GST_IS_PLAYER_PLAYLIST (playlist), 0);
+
+  g_mutex_lock (&playlist->lock);
+  n_items = playlist->uris->len;
+  g_mutex_unlock (&playlist->lock);
+
+  return n_items;
+}
+
+/**
+ * gst_player_playlist_get_uri:
+ * @playlist: a #GstPlayerPlaylist
+ * @index: position of the item
+ *
+ * Returns: (transfer full): the URI of the item at @index, or %NULL.
+ *   g_free() after usage.
+ */
+gchar *
+gst_player_playlist_get_uri (GstPlayerPlaylist * playlist, guint index)
+{
+  gchar *uri = NULL;
+
+  g_return_val_if_fail (GST_IS_PLAYER_PLAYLIST (playlist), NULL);
+
+  g_mutex_lock (&playlist->lock);
+  if (index < playlist->uris->len)
+    uri = g_strdup (g_ptr_array_index (playlist->uris, index));
+  g_mutex_unlock (&playlist->lock);
+
+  return uri;
+}
+
+/**
+ * gst_player_playlist_get_current_index:
+ * @playlist: a #GstPlayerPlaylist
+ *
+ * Returns: the position of the item that is currently played, or -1.
+ */
+gint
+gst_player_playlist_get_current_index (GstPlayerPlaylist * playlist)
+{
+  gint current;
+
+  g_return_val_if_fail (GST_IS_PLAYER_PLAYLIST (playlist), -1);
+
+  g_mutex_lock (&playlist->lock);
+  current = playlist->current;
+  g_mutex_unlock (&playlist->lock);
+
+  return current;
+}
+
+/**
+ * gst_player_playlist_set_repeat:
+ * @playlist: a #GstPlayerPlaylist
+ * @repeat: the repeat mode
+ *
+ * Sets what happens when an item finishes.
+ */
+void
+gst_player_playlist_set_repeat (GstPlayerPlaylist * playlist,
+    GstPlayerPlaylistRepeat repeat)
+{
+  g_return_if_fail (GST_IS_PLAYER_PLAYLIST (playlist));
+
+  g_mutex_lock (&playlist->lock);
+  playlist->repeat = repeat;
+  g_mutex_unlock (&playlist->lock);
+}
+
+/**
+ * gst_player_playlist_get_repeat:
+ * @playlist: a #GstPlayerPlaylist
+ *
+ * Returns: the repeat mode of @playlist.
+ */
+GstPlayerPlaylistRepeat
+gst_player_playlist_get_repeat (GstPlayerPlaylist * playlist)
+{
+  GstPlayerPlaylistRepeat repeat;
+
+  g_return_val_if_fail (GST_IS_PLAYER_PLAYLIST (playlist),
+      GST_PLAYER_PLAYLIST_REPEAT_NONE);
+
+  g_mutex_lock (&playlist->lock);
+  repeat = playlist->repeat;
+  g_mutex_unlock (&playlist->lock);
+
+  return repeat;
+}
+
+/* Returns the URI of the item before (@direction < 0) or after the current
+ * one, and its position in @index. @automatic is set when the current item
+ * finished on its own, only then #GST_PLAYER_PLAYLIST_REPEAT_ONE applies. */
+gchar *
+gst_player_playlist_get_adjacent (GstPlayerPlaylist * playlist,
+    gint direction, gboolean automatic, gint * index)
+{
+  gchar *uri = NULL;
+  gint n_items, next;
+
+  g_mutex_lock (&playlist->lock);
+  n_items = playlist->uris->len;
+
+  if (automatic && playlist->repeat == GST_PLAYER_PLAYLIST_REPEAT_ONE
+      && playlist->current >= 0)
+    next = playlist->current;
+  else
+    next = playlist->current + (direction < 0 ? -1 : 1);
+
+  if (playlist->repeat == GST_PLAYER_PLAYLIST_REPEAT_ALL && n_items > 0)
+    next = (next + n_items) % n_items;
+
+  if (next >= 0 && next < n_items) {
+    uri = g_strdup (g_ptr_array_index (playlist->uris, next));
+    *index = next;
+  }
+  g_mutex_unlock (&playlist->lock);
+
+  return uri;
+}
+
+void
+gst_player_playlist_set_current_index (GstPlayerPlaylist * playlist,
+    gint index)
+{
+  g_mutex_lock (&playlist->lock);
+  playlist->current = index;
+  playlist->pending = -1;
+  g_mutex_unlock (&playlist->lock);
+}
+
+/* Remembers the item that was prepared to play next. Its position is
+ * updated like the current one when the playlist is edited until it
+ * becomes current. */
+void
+gst_player_playlist_set_pending_index (GstPlayerPlaylist * playlist,
+    gint index)
+{
+  g_mutex_lock (&playlist->lock);
+  playlist->pending = index;
+  g_mutex_unlock (&playlist->lock);
+}
+
+/* Makes the pending item the current one and returns its position */
+gint
+gst_player_playlist_make_pending_current (GstPlayerPlaylist * playlist)
+{
+  gint index;
+
+  g_mutex_lock (&playlist->lock);
+  index = playlist->current = playlist->pending;
+  playlist->pending = -1;
+  g_mutex_unlock (&playlist->lock);
+
+  return index;
+}
+
+#define C_ENUM(v) ((gint) v)
+
+GType
+gst_player_playlist_repeat_get_type (void)
+{
+  static gsize id = 0;
+  static const GEnumValue values[] = {
+    {C_ENUM (GST_PLAYER_PLAYLIST_REPEAT_NONE),
+        "GST_PLAYER_PLAYLIST_REPEAT_NONE", "none"},
+    {C_ENUM (GST_PLAYER_PLAYLIST_REPEAT_ONE), "GST_PLAYER_PLAYLIST_REPEAT_ONE",
+        "one"},
+    {C_ENUM (GST_PLAYER_PLAYLIST_REPEAT_ALL), "GST_PLAYER_PLAYLIST_REPEAT_ALL",
+        "all"},
+    {0, NULL, NULL}
+  };
+
+  if (g_once_init_enter (&id)) {
+    GType tmp = g_enum_register_static ("GstPlayerPlaylistRepeat", values);
+    g_once_init_leave (&id, tmp);
+  }
+
+  return (GType) id;
+}
+
+/**
+ * gst_player_playlist_repeat_get_name:
+ * @repeat: a #GstPlayerPlaylistRepeat
+ *
+ * Gets a string representing the given repeat mode.
+ *
+ * Returns: (transfer none): a string with the name of the repeat mode.
+ */
+const gchar *
+gst_player_playlist_repeat_get_name (GstPlayerPlaylistRepeat repeat)
+{
+  switch (repeat) {
+    case GST_PLAYER_PLAYLIST_REPEAT_NONE:
+      return "none";
+    case GST_PLAYER_PLAYLIST_REPEAT_ONE:
+      return "one";
+    case GST_PLAYER_PLAYLIST_REPEAT_ALL:
+      return "all";
+  }
+
+  g_assert_not_reached ();
+  return NULL;
+}
@@ -0,0 +1,90 @@
+/* GStreamer
+ *
+ * Copyright (C) 2015 Kim DaeHyun <jabiers87@gmail.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __GST_PLAYER_PLAYLIST_H__
+#define __GST_PLAYER_PLAYLIST_H__
+
+#include <gst/gst.h>
+
+G_BEGIN_DECLS
+
+GType        gst_player_playlist_repeat_get_type      (void);
+#define      GST_TYPE_PLAYER_PLAYLIST_REPEAT          (gst_player_playlist_repeat_get_type ())
+
+/**
+ * GstPlayerPlaylistRepeat:
+ * @GST_PLAYER_PLAYLIST_REPEAT_NONE: stop after the last item.
+ * @GST_PLAYER_PLAYLIST_REPEAT_ONE: play the current item again when it
+ * finishes.
+ * @GST_PLAYER_PLAYLIST_REPEAT_ALL: continue with the first item after the
+ * last one.
+ */
+typedef enum
+{
+  GST_PLAYER_PLAYLIST_REPEAT_NONE,
+  GST_PLAYER_PLAYLIST_REPEAT_ONE,
+  GST_PLAYER_PLAYLIST_REPEAT_ALL
+} GstPlayerPlaylistRepeat;
+
+const gchar *gst_player_playlist_repeat_get_name      (GstPlayerPlaylistRepeat repeat);
+
+#define GST_TYPE_PLAYER_PLAYLIST \
+  (gst_player_playlist_get_type ())
+#define GST_PLAYER_PLAYLIST(obj) \
+  (G_TYPE_CHECK_INSTANCE_CAST((obj),GST_TYPE_PLAYER_PLAYLIST,GstPlayerPlaylist))
+#define GST_PLAYER_PLAYLIST_CLASS(klass) \
+  (G_TYPE_CHECK_CLASS_CAST((klass),GST_TYPE_PLAYER_PLAYLIST,GstPlayerPlaylistClass))
+#define GST_IS_PLAYER_PLAYLIST(obj) \
+  (G_TYPE_CHECK_INSTANCE_TYPE((obj),GST_TYPE_PLAYER_PLAYLIST))
+#define GST_IS_PLAYER_PLAYLIST_CLASS(klass) \
+  (G_TYPE_CHECK_CLASS_TYPE((klass),GST_TYPE_PLAYER_PLAYLIST))
+
+/**
+ * GstPlayerPlaylist:
+ *
+ * An ordered list of URIs played one after another by a #GstPlayer.
+ */
+typedef struct _GstPlayerPlaylist GstPlayerPlaylist;
+typedef struct _GstPlayerPlaylistClass GstPlayerPlaylistClass;
+GType gst_player_playlist_get_type (void);
+
+GstPlayerPlaylist *      gst_player_playlist_new                (void);
+
+void                     gst_player_playlist_append             (GstPlayerPlaylist * playlist,
+                                                                 const gchar * uri);
+void                     gst_player_playlist_insert             (GstPlayerPlaylist * playlist,
+                                                                 gint index,
+                                                                 const gchar * uri);
+gboolean                 gst_player_playlist_remove             (GstPlayerPlaylist * playlist,
+                                                                 guint index);
+void                     gst_player_playlist_clear              (GstPlayerPlaylist * playlist);
+
+guint                    gst_player_playlist_get_n_items        (GstPlayerPlaylist * playlist);
+gchar *                  gst_player_playlist_get_uri            (GstPlayerPlaylist * playlist,
+                                                                 guint index);
+gint                     gst_player_playlist_get_current_index  (GstPlayerPlaylist * playlist);
+
+void                     gst_player_playlist_set_repeat         (GstPlayerPlaylist * playlist,
+                                                                 GstPlayerPlaylistRepeat repeat);
+GstPlayerPlaylistRepeat  gst_player_playlist_get_repeat         (GstPlayerPlaylist * playlist);
+
+G_END_DECLS
+
+#endif /* __GST_PLAYER_PLAYLIST_H__ */
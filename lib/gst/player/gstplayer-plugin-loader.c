@@ -0,0 +1,849 @@
+/* GStreamer
+ *
+ * Copyright (C) 2015 Kim DaeHyun <jabiers87@gmail.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/**
+ * SECTION:gstplayer-plugin-loader
+ * @short_description: On-demand registration of static plugins
+ *
+ * Statically linked builds (e.g. iOS) have to register every plugin with
+ * GST_PLUGIN_STATIC_REGISTER() before it can be used, which makes startup
+ * time grow with the number of linked plugins even if only a handful of
+ * them is ever needed.
+ *
+ * The plugin loader keeps a list of the available registration functions
+ * together with an index of the element factories each plugin provides
+ * (name, klass, sink caps and URI protocols). Once an index is loaded the
+ * loader is in lazy mode and plugins are only registered when a lookup
+ * for one of their features happens, e.g. when decodebin needs a decoder
+ * for some caps or when a source for a URI protocol is needed.
+ *
+ * The index is created from the registry itself: register all plugins
+ * once with gst_player_plugin_loader_register_all(), then store the
+ * result with gst_player_plugin_loader_save_index(). An index is only
+ * accepted by gst_player_plugin_loader_load_index() if it was created for
+ * exactly the same set of plugins, linked into the same binaries (same size
+ * and modification time) of the same GStreamer version, and if the plugins
+ * registered while loading it still have the versions recorded in it.
+ */
+
+/* For dladdr() with glibc */
+#define _GNU_SOURCE
+
+#include "gstplayer-plugin-loader.h"
+
+#include <string.h>
+#include <glib/gstdio.h>
+#ifdef G_OS_UNIX
+#include <dlfcn.h>
+#endif
+
+GST_DEBUG_CATEGORY_STATIC (gst_player_plugin_loader_debug);
+#define GST_CAT_DEFAULT gst_player_plugin_loader_debug
+
+#define INDEX_GROUP "plugin-loader"
+#define INDEX_VERSION 2
+
+typedef struct
+{
+  gchar *name;
+  GstPlayerPluginRegisterFunc func;
+  gboolean registered;
+} LoaderPlugin;
+
+typedef struct
+{
+  gchar *name;
+  LoaderPlugin *plugin;
+  gchar *klass;
+  gchar *caps_str;
+  GstCaps *caps;                /* parsed on first use */
+  gchar **protocols;
+} LoaderFeature;
+
+static GMutex loader_lock;
+static GQueue plugin_list = G_QUEUE_INIT;
+static GHashTable *plugin_table;        /* name -> LoaderPlugin */
+static GPtrArray *feature_list;         /* LoaderFeature from the index */
+static GHashTable *pending_ranks;       /* feature name -> rank */
+static gboolean lazy;
+static guint registered_count;
+static GstClockTime registration_time;
+
+static void
+loader_feature_free (LoaderFeature * feature)
+{
+  g_free (feature->name);
+  g_free (feature->klass);
+  g_free (feature->caps_str);
+  if (feature->caps)
+    gst_caps_unref (feature->caps);
+  g_strfreev (feature->protocols);
+  g_free (feature);
+}
+
+static void
+apply_pending_ranks_locked (void)
+{
+  GHashTableIter iter;
+  gpointer key, value;
+
+  if (!pending_ranks)
+    return;
+
+  g_hash_table_iter_init (&iter, pending_ranks);
+  while (g_hash_table_iter_next (&iter, &key, &value)) {
+    GstPluginFeature *feature;
+
+    feature = gst_registry_lookup_feature (gst_registry_get (), key);
+    if (feature) {
+      gst_plugin_feature_set_rank (feature, GPOINTER_TO_UINT (value));
+      gst_object_unref (feature);
+      g_hash_table_iter_remove (&iter);
+    }
+  }
+}
+
+static void
+register_plugin_locked (LoaderPlugin * plugin)
+{
+  GstClockTime start;
+
+  if (plugin->registered)
+    return;
+
+  start = gst_util_get_timestamp ();
+  plugin->func ();
+  plugin->registered = TRUE;
+
+  registered_count++;
+  registration_time += gst_util_get_timestamp () - start;
+
+  GST_DEBUG ("Registered plugin '%s' (%u/%u)", plugin->name, registered_count,
+      g_queue_get_length (&plugin_list));
+
+  apply_pending_ranks_locked ();
+}
+
+/**
+ * gst_player_plugin_loader_add:
+ * @name: name of the plugin
+ * @func: static registration function of the plugin
+ *
+ * Makes a statically linked plugin known to the loader without registering
+ * it. See GST_PLAYER_PLUGIN_LOADER_ADD() for the common case.
+ */
+void
+gst_player_plugin_loader_add (const gchar * name,
+    GstPlayerPluginRegisterFunc func)
+{
+  LoaderPlugin *plugin;
+
+  g_return_if_fail (name != NULL);
+  g_return_if_fail (func != NULL);
+
+  g_mutex_lock (&loader_lock);
+  if (!plugin_table) {
+    GST_DEBUG_CATEGORY_INIT (gst_player_plugin_loader_debug,
+        "gst-player-plugin-loader", 0, "GstPlayer plugin loader");
+    plugin_table = g_hash_table_new (g_str_hash, g_str_equal);
+  }
+
+  if (!g_hash_table_contains (plugin_table, name)) {
+    plugin = g_new0 (LoaderPlugin, 1);
+    plugin->name = g_strdup (name);
+    plugin->func = func;
+
+    g_hash_table_insert (plugin_table, plugin->name, plugin);
+    g_queue_push_tail (&plugin_list, plugin);
+  }
+  g_mutex_unlock (&loader_lock);
+}
+
+/* Appends size and modification time of the binary the registration
+ * function of @plugin is linked into, once per binary. Static plugins are
+ * part of the application or framework binary, which changes whenever
+ * plugins are upgraded */
+static void
+append_binary_signature (GString * s, LoaderPlugin * plugin,
+    GHashTable * binaries)
+{
+#ifdef G_OS_UNIX
+  GStatBuf st;
+  Dl_info info;
+
+  if (!dladdr ((gpointer) plugin->func, &info) || !info.dli_fname)
+    return;
+
+  if (g_hash_table_contains (binaries, info.dli_fname))
+    return;
+  g_hash_table_add (binaries, (gpointer) info.dli_fname);
+
+  if (g_stat (info.dli_fname, &st) == 0)
+    g_string_append_printf (s, ";%s:%" G_GINT64_FORMAT ":%" G_GINT64_FORMAT,
+        info.dli_fname, (gint64) st.st_size, (gint64) st.st_mtime);
+#endif
+}
+
+/* Identifies the set of known plugins and the binaries they come from, an
+ * index is only valid for what it was created from */
+static gchar *
+get_signature_locked (void)
+{
+  GString *s = g_string_new (NULL);
+  GHashTable *binaries;
+  gchar *version;
+  GList *l;
+
+  version = gst_version_string ();
+  g_string_append (s, version);
+  g_free (version);
+
+  for (l = plugin_list.head; l; l = l->next) {
+    LoaderPlugin *plugin = l->data;
+
+    g_string_append_c (s, ';');
+    g_string_append (s, plugin->name);
+  }
+
+  binaries = g_hash_table_new (g_str_hash, g_str_equal);
+  for (l = plugin_list.head; l; l = l->next)
+    append_binary_signature (s, l->data, binaries);
+  g_hash_table_destroy (binaries);
+
+  return g_string_free (s, FALSE);
+}
+
+static gchar *
+get_plugin_version (const gchar * name)
+{
+  GstPlugin *plugin;
+  gchar *version;
+
+  plugin = gst_registry_find_plugin (gst_registry_get (), name);
+  if (!plugin)
+    return NULL;
+
+  version = g_strdup (gst_plugin_get_version (plugin));
+  gst_object_unref (plugin);
+
+  return version;
+}
+
+/* Must be called with loader_lock. Compares the versions of the registered
+ * plugins with those in the index, which also catches upgrades that leave
+ * the binaries' size and modification time alone */
+static gboolean
+check_plugin_versions_locked (GKeyFile * key_file)
+{
+  gboolean ret = TRUE;
+  GList *l;
+
+  for (l = plugin_list.head; l && ret; l = l->next) {
+    LoaderPlugin *plugin = l->data;
+    gchar *group, *expected, *version;
+
+    if (!plugin->registered)
+      continue;
+
+    group = g_strdup_printf ("plugin %s", plugin->name);
+    expected = g_key_file_get_string (key_file, group, "version", NULL);
+    version = get_plugin_version (plugin->name);
+    if (g_strcmp0 (expected, version) != 0) {
+      GST_DEBUG ("Plugin '%s' has version %s, index was created for %s",
+          plugin->name, GST_STR_NULL (version), GST_STR_NULL (expected));
+      ret = FALSE;
+    }
+    g_free (version);
+    g_free (expected);
+    g_free (group);
+  }
+
+  return ret;
+}
+
+/**
+ * gst_player_plugin_loader_register:
+ * @name: name of the plugin
+ *
+ * Registers the plugin @name now, if it was not registered yet.
+ */
+void
+gst_player_plugin_loader_register (const gchar * name)
+{
+  LoaderPlugin *plugin;
+
+  g_return_if_fail (name != NULL);
+
+  g_mutex_lock (&loader_lock);
+  plugin = plugin_table ? g_hash_table_lookup (plugin_table, name) : NULL;
+  if (plugin)
+    register_plugin_locked (plugin);
+  g_mutex_unlock (&loader_lock);
+}
+
+/**
+ * gst_player_plugin_loader_register_all:
+ *
+ * Registers all known plugins, i.e. the eager behaviour of
+ * GST_PLUGIN_STATIC_REGISTER(). This also leaves lazy mode.
+ */
+void
+gst_player_plugin_loader_register_all (void)
+{
+  GList *l;
+
+  g_mutex_lock (&loader_lock);
+  for (l = plugin_list.head; l; l = l->next)
+    register_plugin_locked (l->data);
+  lazy = FALSE;
+  g_mutex_unlock (&loader_lock);
+}
+
+/**
+ * gst_player_plugin_loader_load_index:
+ * @filename: index file written by gst_player_plugin_loader_save_index()
+ *
+ * Loads the feature index and switches the loader to lazy mode. Plugins
+ * that provide anything else than element factories (e.g. typefinders)
+ * are registered right away.
+ *
+ * Returns: %TRUE if the index was loaded, %FALSE if it does not exist or
+ * was created for another set of plugins.
+ */
+gboolean
+gst_player_plugin_loader_load_index (const gchar * filename)
+{
+  GKeyFile *key_file;
+  gchar **groups = NULL, **eager = NULL;
+  gchar *signature = NULL, *expected;
+  gboolean ret = FALSE;
+  guint i;
+
+  g_return_val_if_fail (filename != NULL, FALSE);
+
+  key_file = g_key_file_new ();
+  if (!g_key_file_load_from_file (key_file, filename, G_KEY_FILE_NONE, NULL))
+    goto out;
+
+  if (g_key_file_get_integer (key_file, INDEX_GROUP, "version",
+          NULL) != INDEX_VERSION)
+    goto out;
+
+  signature = g_key_file_get_string (key_file, INDEX_GROUP, "signature", NULL);
+
+  g_mutex_lock (&loader_lock);
+  expected = get_signature_locked ();
+  if (!plugin_table || g_strcmp0 (signature, expected) != 0) {
+    GST_DEBUG ("Plugin index %s is outdated", filename);
+    g_free (expected);
+    g_mutex_unlock (&loader_lock);
+    goto out;
+  }
+  g_free (expected);
+
+  if (feature_list)
+    g_ptr_array_free (feature_list, TRUE);
+  feature_list =
+      g_ptr_array_new_with_free_func ((GDestroyNotify) loader_feature_free);
+
+  groups = g_key_file_get_groups (key_file, NULL);
+  for (i = 0; groups[i]; i++) {
+    LoaderFeature *feature;
+    LoaderPlugin *plugin;
+    gchar *plugin_name;
+
+    if (!g_str_has_prefix (groups[i], "feature "))
+      continue;
+
+    plugin_name = g_key_file_get_string (key_file, groups[i], "plugin", NULL);
+    plugin = plugin_name ? g_hash_table_lookup (plugin_table, plugin_name) :
+        NULL;
+    g_free (plugin_name);
+    if (!plugin)
+      continue;
+
+    feature = g_new0 (LoaderFeature, 1);
+    feature->name = g_strdup (groups[i] + strlen ("feature "));
+    feature->plugin = plugin;
+    feature->klass = g_key_file_get_string (key_file, groups[i], "klass", NULL);
+    feature->caps_str =
+        g_key_file_get_string (key_file, groups[i], "caps", NULL);
+    feature->protocols =
+        g_key_file_get_string_list (key_file, groups[i], "protocols", NULL,
+        NULL);
+    g_ptr_array_add (feature_list, feature);
+  }
+
+  eager = g_key_file_get_string_list (key_file, INDEX_GROUP, "eager", NULL,
+      NULL);
+  for (i = 0; eager && eager[i]; i++) {
+    LoaderPlugin *plugin = g_hash_table_lookup (plugin_table, eager[i]);
+
+    if (plugin)
+      register_plugin_locked (plugin);
+  }
+
+  if (!check_plugin_versions_locked (key_file)) {
+    GST_DEBUG ("Plugin index %s is outdated", filename);
+    g_ptr_array_free (feature_list, TRUE);
+    feature_list = NULL;
+    g_mutex_unlock (&loader_lock);
+    goto out;
+  }
+
+  lazy = TRUE;
+  ret = TRUE;
+  GST_DEBUG ("Loaded plugin index %s with %u features", filename,
+      feature_list->len);
+  g_mutex_unlock (&loader_lock);
+
+out:
+  g_strfreev (groups);
+  g_strfreev (eager);
+  g_free (signature);
+  g_key_file_free (key_file);
+
+  return ret;
+}
+
+static gchar *
+get_sink_caps_string (GstElementFactory * factory)
+{
+  const GList *l;
+  GstCaps *caps = NULL;
+  gchar *str;
+
+  for (l = gst_element_factory_get_static_pad_templates (factory); l;
+      l = l->next) {
+    GstStaticPadTemplate *tmpl = l->data;
+
+    if (tmpl->direction != GST_PAD_SINK)
+      continue;
+
+    if (caps)
+      caps = gst_caps_merge (caps, gst_static_caps_get (&tmpl->static_caps));
+    else
+      caps = gst_static_caps_get (&tmpl->static_caps);
+  }
+
+  if (!caps)
+    return NULL;
+
+  str = gst_caps_to_string (caps);
+  gst_caps_unref (caps);
+
+  return str;
+}
+
+/**
+ * gst_player_plugin_loader_save_index:
+ * @filename: file to write the index to
+ * @error: return location for a #GError, or %NULL
+ *
+ * Writes an index of the element factories provided by the currently
+ * registered plugins. All plugins should have been registered before, see
+ * gst_player_plugin_loader_register_all().
+ *
+ * Returns: %TRUE if the index was written.
+ */
+gboolean
+gst_player_plugin_loader_save_index (const gchar * filename, GError ** error)
+{
+  GKeyFile *key_file;
+  GPtrArray *eager;
+  gchar *signature, *data;
+  gsize length;
+  gboolean ret;
+  GList *l;
+
+  g_return_val_if_fail (filename != NULL, FALSE);
+
+  key_file = g_key_file_new ();
+  eager = g_ptr_array_new ();
+
+  g_mutex_lock (&loader_lock);
+  signature = get_signature_locked ();
+  g_key_file_set_integer (key_file, INDEX_GROUP, "version", INDEX_VERSION);
+  g_key_file_set_string (key_file, INDEX_GROUP, "signature", signature);
+  g_free (signature);
+
+  for (l = plugin_list.head; l; l = l->next) {
+    LoaderPlugin *plugin = l->data;
+    GList *features, *f;
+    gboolean only_elements = TRUE;
+    gchar *group, *version;
+
+    if (!plugin->registered)
+      continue;
+
+    version = get_plugin_version (plugin->name);
+    if (version) {
+      group = g_strdup_printf ("plugin %s", plugin->name);
+      g_key_file_set_string (key_file, group, "version", version);
+      g_free (group);
+    }
+    g_free (version);
+
+    features =
+        gst_registry_get_feature_list_by_plugin (gst_registry_get (),
+        plugin->name);
+    if (!features)
+      only_elements = FALSE;
+
+    for (f = features; f; f = f->next) {
+      GstElementFactory *factory;
+      const gchar *klass;
+      const gchar *const *protocols;
+      gchar *group, *caps;
+
+      if (!GST_IS_ELEMENT_FACTORY (f->data)) {
+        only_elements = FALSE;
+        continue;
+      }
+
+      factory = GST_ELEMENT_FACTORY (f->data);
+      group = g_strdup_printf ("feature %s",
+          gst_plugin_feature_get_name (GST_PLUGIN_FEATURE (factory)));
+      g_key_file_set_string (key_file, group, "plugin", plugin->name);
+
+      klass = gst_element_factory_get_metadata (factory,
+          GST_ELEMENT_METADATA_KLASS);
+      if (klass)
+        g_key_file_set_string (key_file, group, "klass", klass);
+
+      caps = get_sink_caps_string (factory);
+      if (caps)
+        g_key_file_set_string (key_file, group, "caps", caps);
+      g_free (caps);
+
+      protocols = gst_element_factory_get_uri_protocols (factory);
+      if (gst_element_factory_get_uri_type (factory) == GST_URI_SRC
+          && protocols)
+        g_key_file_set_string_list (key_file, group, "protocols", protocols,
+            g_strv_length ((gchar **) protocols));
+
+      g_free (group);
+    }
+    gst_plugin_feature_list_free (features);
+
+    if (!only_elements)
+      g_ptr_array_add (eager, plugin->name);
+  }
+
+  g_key_file_set_string_list (key_file, INDEX_GROUP, "eager",
+      (const gchar * const *) eager->pdata, eager->len);
+  g_mutex_unlock (&loader_lock);
+
+  data = g_key_file_to_data (key_file, &length, NULL);
+  ret = g_file_set_contents (filename, data, length, error);
+
+  g_free (data);
+  g_ptr_array_free (eager, TRUE);
+  g_key_file_free (key_file);
+
+  return ret;
+}
+
+/**
+ * gst_player_plugin_loader_ensure_feature:
+ * @name: name of a plugin feature, e.g. "playbin"
+ *
+ * Makes sure the plugin providing @name is registered.
+ *
+ * Returns: %TRUE if @name is available in the registry.
+ */
+gboolean
+gst_player_plugin_loader_ensure_feature (const gchar * name)
+{
+  GstPluginFeature *feature;
+  guint i;
+
+  g_return_val_if_fail (name != NULL, FALSE);
+
+  g_mutex_lock (&loader_lock);
+  if (lazy) {
+    for (i = 0; i < feature_list->len; i++) {
+      LoaderFeature *f = g_ptr_array_index (feature_list, i);
+
+      if (strcmp (f->name, name) == 0) {
+        register_plugin_locked (f->plugin);
+        break;
+      }
+    }
+  }
+  g_mutex_unlock (&loader_lock);
+
+  feature = gst_registry_lookup_feature (gst_registry_get (), name);
+  if (!feature)
+    return FALSE;
+
+  gst_object_unref (feature);
+  return TRUE;
+}
+
+static gboolean
+klass_matches (const gchar * klass, gchar ** tokens)
+{
+  guint i;
+
+  if (!klass)
+    return FALSE;
+
+  for (i = 0; tokens[i]; i++) {
+    if (!strstr (klass, tokens[i]))
+      return FALSE;
+  }
+
+  return TRUE;
+}
+
+/**
+ * gst_player_plugin_loader_ensure_klass:
+ * @klass: element klass, e.g. "Sink/Video"
+ *
+ * Registers all plugins that provide element factories whose klass
+ * contains all '/' separated parts of @klass, the same way autodetect
+ * and visualization lookups match klasses.
+ *
+ * Returns: %TRUE if a plugin was registered.
+ */
+gboolean
+gst_player_plugin_loader_ensure_klass (const gchar * klass)
+{
+  gchar **tokens;
+  gboolean ret = FALSE;
+  guint i;
+
+  g_return_val_if_fail (klass != NULL, FALSE);
+
+  g_mutex_lock (&loader_lock);
+  if (!lazy) {
+    g_mutex_unlock (&loader_lock);
+    return FALSE;
+  }
+
+  tokens = g_strsplit (klass, "/", -1);
+  for (i = 0; i < feature_list->len; i++) {
+    LoaderFeature *f = g_ptr_array_index (feature_list, i);
+
+    if (f->plugin->registered || !klass_matches (f->klass, tokens))
+      continue;
+
+    register_plugin_locked (f->plugin);
+    ret = TRUE;
+  }
+  g_strfreev (tokens);
+  g_mutex_unlock (&loader_lock);
+
+  return ret;
+}
+
+/* Only factories that decodebin would plug for some caps */
+static gboolean
+is_autopluggable (const gchar * klass)
+{
+  if (!klass)
+    return FALSE;
+
+  return strstr (klass, "Demuxer") || strstr (klass, "Decoder")
+      || strstr (klass, "Parser") || strstr (klass, "Depayloader")
+      || strstr (klass, "Decryptor");
+}
+
+/**
+ * gst_player_plugin_loader_ensure_caps:
+ * @caps: caps that need to be handled
+ *
+ * Registers all plugins with demuxers, decoders, parsers or depayloaders
+ * that accept @caps. This is meant to be called from decodebin's
+ * #GstURIDecodeBin::autoplug-continue before the factory lookup happens.
+ *
+ * Returns: %TRUE if a plugin was registered.
+ */
+gboolean
+gst_player_plugin_loader_ensure_caps (const GstCaps * caps)
+{
+  gboolean ret = FALSE;
+  guint i;
+
+  g_return_val_if_fail (GST_IS_CAPS (caps), FALSE);
+
+  g_mutex_lock (&loader_lock);
+  if (!lazy) {
+    g_mutex_unlock (&loader_lock);
+    return FALSE;
+  }
+
+  for (i = 0; i < feature_list->len; i++) {
+    LoaderFeature *f = g_ptr_array_index (feature_list, i);
+
+    if (f->plugin->registered || !f->caps_str || !is_autopluggable (f->klass))
+      continue;
+
+    if (!f->caps) {
+      f->caps = gst_caps_from_string (f->caps_str);
+      if (!f->caps)
+        f->caps = gst_caps_new_empty ();
+    }
+
+    if (gst_caps_is_any (f->caps) || !gst_caps_can_intersect (f->caps, caps))
+      continue;
+
+    GST_DEBUG ("Feature '%s' handles %" GST_PTR_FORMAT, f->name, caps);
+    register_plugin_locked (f->plugin);
+    ret = TRUE;
+  }
+  g_mutex_unlock (&loader_lock);
+
+  return ret;
+}
+
+/**
+ * gst_player_plugin_loader_ensure_protocol:
+ * @protocol: URI protocol, e.g. "rtmp"
+ *
+ * Registers all plugins with source elements for @protocol.
+ *
+ * Returns: %TRUE if a plugin was registered.
+ */
+gboolean
+gst_player_plugin_loader_ensure_protocol (const gchar * protocol)
+{
+  gboolean ret = FALSE;
+  guint i, j;
+
+  g_return_val_if_fail (protocol != NULL, FALSE);
+
+  g_mutex_lock (&loader_lock);
+  if (!lazy) {
+    g_mutex_unlock (&loader_lock);
+    return FALSE;
+  }
+
+  for (i = 0; i < feature_list->len; i++) {
+    LoaderFeature *f = g_ptr_array_index (feature_list, i);
+
+    if (f->plugin->registered || !f->protocols)
+      continue;
+
+    for (j = 0; f->protocols[j]; j++) {
+      if (g_ascii_strcasecmp (f->protocols[j], protocol) == 0) {
+        register_plugin_locked (f->plugin);
+        ret = TRUE;
+        break;
+      }
+    }
+  }
+  g_mutex_unlock (&loader_lock);
+
+  return ret;
+}
+
+/**
+ * gst_player_plugin_loader_ensure_uri:
+ * @uri: a URI
+ *
+ * Same as gst_player_plugin_loader_ensure_protocol() for the protocol
+ * of @uri.
+ *
+ * Returns: %TRUE if a plugin was registered.
+ */
+gboolean
+gst_player_plugin_loader_ensure_uri (const gchar * uri)
+{
+  gchar *protocol;
+  gboolean ret;
+
+  if (!uri)
+    return FALSE;
+
+  protocol = gst_uri_get_protocol (uri);
+  if (!protocol)
+    return FALSE;
+
+  ret = gst_player_plugin_loader_ensure_protocol (protocol);
+  g_free (protocol);
+
+  return ret;
+}
+
+/**
+ * gst_player_plugin_loader_set_rank:
+ * @feature: name of a plugin feature
+ * @rank: new rank
+ *
+ * Sets the rank of @feature. If the providing plugin is not registered yet
+ * the rank is applied as soon as it is, without forcing registration.
+ */
+void
+gst_player_plugin_loader_set_rank (const gchar * feature, guint rank)
+{
+  g_return_if_fail (feature != NULL);
+
+  g_mutex_lock (&loader_lock);
+  if (!pending_ranks)
+    pending_ranks = g_hash_table_new_full (g_str_hash, g_str_equal, g_free,
+        NULL);
+  g_hash_table_insert (pending_ranks, g_strdup (feature),
+      GUINT_TO_POINTER (rank));
+  apply_pending_ranks_locked ();
+  g_mutex_unlock (&loader_lock);
+}
+
+/**
+ * gst_player_plugin_loader_is_lazy:
+ *
+ * Returns: %TRUE if an index is loaded and plugins are registered on
+ * demand.
+ */
+gboolean
+gst_player_plugin_loader_is_lazy (void)
+{
+  gboolean ret;
+
+  g_mutex_lock (&loader_lock);
+  ret = lazy;
+  g_mutex_unlock (&loader_lock);
+
+  return ret;
+}
+
+/**
+ * gst_player_plugin_loader_get_stats:
+ * @n_registered: (out) (allow-none): number of registered plugins
+ * @n_plugins: (out) (allow-none): number of known plugins
+ * @time_spent: (out) (allow-none): total time spent in plugin registration
+ *
+ * Gets statistics about plugin registration, e.g. to compare startup
+ * cost of eager and lazy registration.
+ */
+void
+gst_player_plugin_loader_get_stats (guint * n_registered,
+    guint * n_plugins, GstClockTime * time_spent)
+{
+  g_mutex_lock (&loader_lock);
+  if (n_registered)
+    *n_registered = registered_count;
+  if (n_plugins)
+    *n_plugins = g_queue_get_length (&plugin_list);
+  if (time_spent)
+    *time_spent = registration_time;
+  g_mutex_unlock (&loader_lock);
+}
@@ -0,0 +1,73 @@
+/* GStreamer
+ *
+ * Copyright (C) 2015 Kim DaeHyun <jabiers87@gmail.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __GST_PLAYER_PLUGIN_LOADER_H__
+#define __GST_PLAYER_PLUGIN_LOADER_H__
+
+#include <gst/gst.h>
+
+G_BEGIN_DECLS
+
+/**
+ * GstPlayerPluginRegisterFunc:
+ *
+ * Static plugin registration function, as declared by
+ * GST_PLUGIN_STATIC_DECLARE().
+ */
+typedef void (*GstPlayerPluginRegisterFunc) (void);
+
+/**
+ * GST_PLAYER_PLUGIN_LOADER_ADD:
+ * @name: plugin name, as passed to GST_PLUGIN_STATIC_DECLARE()
+ *
+ * Convenience wrapper around gst_player_plugin_loader_add() for plugins
+ * declared with GST_PLUGIN_STATIC_DECLARE().
+ */
+#define GST_PLAYER_PLUGIN_LOADER_ADD(name) \
+  gst_player_plugin_loader_add (G_STRINGIFY (name), \
+      G_PASTE (gst_plugin_, G_PASTE (name, _register)))
+
+void         gst_player_plugin_loader_add             (const gchar * name,
+                                                       GstPlayerPluginRegisterFunc func);
+
+gboolean     gst_player_plugin_loader_load_index      (const gchar * filename);
+gboolean     gst_player_plugin_loader_save_index      (const gchar * filename,
+                                                       GError ** error);
+
+void         gst_player_plugin_loader_register        (const gchar * name);
+void         gst_player_plugin_loader_register_all    (void);
+
+gboolean     gst_player_plugin_loader_ensure_feature  (const gchar * name);
+gboolean     gst_player_plugin_loader_ensure_klass    (const gchar * klass);
+gboolean     gst_player_plugin_loader_ensure_caps     (const GstCaps * caps);
+gboolean     gst_player_plugin_loader_ensure_protocol (const gchar * protocol);
+gboolean     gst_player_plugin_loader_ensure_uri      (const gchar * uri);
+
+void         gst_player_plugin_loader_set_rank        (const gchar * feature,
+                                                       guint rank);
+
+gboolean     gst_player_plugin_loader_is_lazy         (void);
+void         gst_player_plugin_loader_get_stats       (guint * n_registered,
+                                                       guint * n_plugins,
+                                                       GstClockTime * time_spent);
+
+G_END_DECLS
+
+#endif /* __GST_PLAYER_PLUGIN_LOADER_H__ */
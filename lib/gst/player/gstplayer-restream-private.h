@@ -0,0 +1,53 @@
+/* GStreamer
+ *
+ * Copyright (C) 2015 Kim DaeHyun <jabiers87@gmail.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __GST_PLAYER_RESTREAM_PRIVATE_H__
+#define __GST_PLAYER_RESTREAM_PRIVATE_H__
+
+#include <gst/gst.h>
+
+typedef enum
+{
+  GST_PLAYER_RESTREAM_VIDEO,
+  GST_PLAYER_RESTREAM_AUDIO,
+  GST_PLAYER_RESTREAM_N_TYPES
+} GstPlayerRestreamType;
+
+typedef struct _GstPlayerRestream GstPlayerRestream;
+
+G_GNUC_INTERNAL GstPlayerRestream * gst_player_restream_new (GMainContext *
+    context, guint port, const gchar * path, GError ** error);
+G_GNUC_INTERNAL void gst_player_restream_free (GstPlayerRestream * restream);
+G_GNUC_INTERNAL GstPlayerRestream * gst_player_restream_ref (GstPlayerRestream *
+    restream);
+G_GNUC_INTERNAL void gst_player_restream_unref (GstPlayerRestream * restream);
+G_GNUC_INTERNAL gboolean gst_player_restream_is_configured (GstPlayerRestream *
+    restream, guint port, const gchar * path);
+G_GNUC_INTERNAL gboolean gst_player_restream_get_type_for_caps (const GstCaps *
+    caps, GstPlayerRestreamType * type);
+G_GNUC_INTERNAL void gst_player_restream_set_caps (GstPlayerRestream *
+    restream, GstPlayerRestreamType type, GstPad * pad, GstCaps * caps);
+G_GNUC_INTERNAL void gst_player_restream_push (GstPlayerRestream * restream,
+    GstPlayerRestreamType type, GstPad * pad, GstBuffer * buffer);
+G_GNUC_INTERNAL void gst_player_restream_reset (GstPlayerRestream * restream);
+G_GNUC_INTERNAL void gst_player_restream_get_stats (GstPlayerRestream *
+    restream, guint * n_clients, guint64 * bytes, guint64 * bitrate);
+
+#endif
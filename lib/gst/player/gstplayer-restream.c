@@ -0,0 +1,621 @@
+/* GStreamer
+ *
+ * Copyright (C) 2015 Kim DaeHyun <jabiers87@gmail.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/* Re-streaming of the demuxed, still encoded H.264 and AAC streams over
+ * RTSP.
+ *
+ * The parsed elementary streams are pushed into appsrcs of a single shared
+ * RTSP media, which only payloads them. All clients are served from the
+ * same payloaders by multiudpsink, so the amount of work does not grow with
+ * the number of clients. Only UDP transports are offered: with TCP
+ * interleaving every client would get its own unbounded backlog in the
+ * server.
+ *
+ * The appsrc queues are bounded. Once a queue is full everything is dropped
+ * until the next video keyframe after it drained again, so a stalled
+ * network never delays or corrupts the local playback.
+ */
+
+#include "gstplayer-restream-private.h"
+#include "gstplayer-plugin-loader.h"
+
+#include <gst/app/gstappsrc.h>
+#include <gst/rtsp-server/rtsp-server.h>
+
+#include <string.h>
+
+GST_DEBUG_CATEGORY_STATIC (gst_player_restream_debug);
+#define GST_CAT_DEFAULT gst_player_restream_debug
+
+/* Upper bound of data queued for the payloaders, per stream */
+#define MAX_QUEUED_BYTES (1024 * 1024)
+#define STATS_INTERVAL_MS 1000
+
+static const gchar *src_names[GST_PLAYER_RESTREAM_N_TYPES] =
+    { "videosrc", "audiosrc" };
+
+static GstStaticCaps restream_caps[GST_PLAYER_RESTREAM_N_TYPES] = {
+  GST_STATIC_CAPS ("video/x-h264"),
+  GST_STATIC_CAPS ("audio/mpeg, mpegversion = (int) 4")
+};
+
+struct _GstPlayerRestream
+{
+  volatile gint ref_count;
+  GMutex lock;
+
+  guint port;
+  gchar *path;
+
+  GstRTSPServer *server;
+  GstRTSPMediaFactory *factory;
+  GSource *server_source, *stats_source;
+
+  /* Protected by lock */
+  GstCaps *caps[GST_PLAYER_RESTREAM_N_TYPES];
+  gpointer input[GST_PLAYER_RESTREAM_N_TYPES];  /* Only compared */
+  GstElement *appsrc[GST_PLAYER_RESTREAM_N_TYPES];
+  gboolean full[GST_PLAYER_RESTREAM_N_TYPES];
+  gboolean wait_keyframe;
+  GstClockTimeDiff offset;
+  gboolean offset_valid;
+  GstRTSPMedia *media;
+
+  /* Set from the context, protected by lock */
+  guint64 bytes, bitrate;
+  gint64 bytes_time;
+
+  volatile gint n_clients;
+};
+
+static void
+ensure_debug_category (void)
+{
+  static gsize done = 0;
+
+  if (g_once_init_enter (&done)) {
+    GST_DEBUG_CATEGORY_INIT (gst_player_restream_debug,
+        "gst-player-restream", 0, "GstPlayer RTSP restreaming");
+    g_once_init_leave (&done, 1);
+  }
+}
+
+/* Also works with template caps */
+gboolean
+gst_player_restream_get_type_for_caps (const GstCaps * caps,
+    GstPlayerRestreamType * type)
+{
+  GstCaps *tmp;
+  gboolean found;
+  guint i;
+
+  if (!caps || gst_caps_is_empty (caps) || gst_caps_is_any (caps))
+    return FALSE;
+
+  for (i = 0; i < GST_PLAYER_RESTREAM_N_TYPES; i++) {
+    tmp = gst_static_caps_get (&restream_caps[i]);
+    found = gst_caps_can_intersect (caps, tmp);
+    gst_caps_unref (tmp);
+
+    if (found) {
+      *type = i;
+      return TRUE;
+    }
+  }
+
+  return FALSE;
+}
+
+/* Must be called with lock */
+static void
+update_launch_locked (GstPlayerRestream * self)
+{
+  GString *launch = g_string_new ("( ");
+  guint n_pay = 0;
+
+  if (self->caps[GST_PLAYER_RESTREAM_VIDEO])
+    g_string_append_printf (launch, "appsrc name=%s ! h264parse ! "
+        "rtph264pay name=pay%u pt=96 config-interval=1 ",
+        src_names[GST_PLAYER_RESTREAM_VIDEO], n_pay++);
+  if (self->caps[GST_PLAYER_RESTREAM_AUDIO])
+    g_string_append_printf (launch, "appsrc name=%s ! aacparse ! "
+        "rtpmp4gpay name=pay%u pt=97 ",
+        src_names[GST_PLAYER_RESTREAM_AUDIO], n_pay++);
+  g_string_append (launch, ")");
+
+  GST_DEBUG ("Restream launch line: %s", launch->str);
+  gst_rtsp_media_factory_set_launch (self->factory, launch->str);
+  g_string_free (launch, TRUE);
+}
+
+static void
+need_data_cb (GstElement * appsrc, guint length, gpointer user_data)
+{
+  GstPlayerRestream *self = user_data;
+  guint i;
+
+  g_mutex_lock (&self->lock);
+  for (i = 0; i < GST_PLAYER_RESTREAM_N_TYPES; i++)
+    if (self->appsrc[i] == appsrc)
+      self->full[i] = FALSE;
+  g_mutex_unlock (&self->lock);
+}
+
+static void
+enough_data_cb (GstElement * appsrc, gpointer user_data)
+{
+  GstPlayerRestream *self = user_data;
+  guint i;
+
+  g_mutex_lock (&self->lock);
+  for (i = 0; i < GST_PLAYER_RESTREAM_N_TYPES; i++)
+    if (self->appsrc[i] == appsrc && !self->full[i]) {
+      GST_DEBUG ("Restream queue of %s full, dropping until next keyframe",
+          src_names[i]);
+      self->full[i] = TRUE;
+      self->wait_keyframe = TRUE;
+    }
+  g_mutex_unlock (&self->lock);
+}
+
+/* Must be called with lock */
+static void
+clear_media_locked (GstPlayerRestream * self)
+{
+  guint i;
+
+  for (i = 0; i < GST_PLAYER_RESTREAM_N_TYPES; i++) {
+    if (self->appsrc[i]) {
+      g_signal_handlers_disconnect_by_data (self->appsrc[i], self);
+      gst_object_unref (self->appsrc[i]);
+      self->appsrc[i] = NULL;
+    }
+    self->full[i] = FALSE;
+  }
+
+  if (self->media) {
+    g_signal_handlers_disconnect_by_data (self->media, self);
+    g_object_unref (self->media);
+    self->media = NULL;
+  }
+}
+
+static void
+media_unprepared_cb (GstRTSPMedia * media, gpointer user_data)
+{
+  GstPlayerRestream *self = user_data;
+
+  GST_DEBUG ("Restream media unprepared");
+
+  g_mutex_lock (&self->lock);
+  if (self->media == media)
+    clear_media_locked (self);
+  g_mutex_unlock (&self->lock);
+}
+
+static void
+media_configure_cb (GstRTSPMediaFactory * factory, GstRTSPMedia * media,
+    gpointer user_data)
+{
+  GstPlayerRestream *self = user_data;
+  GstElement *element = gst_rtsp_media_get_element (media);
+  GstElement *appsrc;
+  guint i;
+
+  GST_DEBUG ("Configuring restream media");
+
+  g_mutex_lock (&self->lock);
+  clear_media_locked (self);
+  self->media = g_object_ref (media);
+  g_signal_connect (media, "unprepared", G_CALLBACK (media_unprepared_cb),
+      self);
+
+  for (i = 0; i < GST_PLAYER_RESTREAM_N_TYPES; i++) {
+    if (!self->caps[i])
+      continue;
+
+    appsrc = gst_bin_get_by_name (GST_BIN (element), src_names[i]);
+    if (!appsrc)
+      continue;
+
+    g_object_set (appsrc, "format", GST_FORMAT_TIME, "is-live", TRUE,
+        "do-timestamp", FALSE, "block", FALSE, "max-bytes",
+        (guint64) MAX_QUEUED_BYTES, NULL);
+    gst_app_src_set_caps (GST_APP_SRC (appsrc), self->caps[i]);
+    g_signal_connect (appsrc, "need-data", G_CALLBACK (need_data_cb), self);
+    g_signal_connect (appsrc, "enough-data", G_CALLBACK (enough_data_cb),
+        self);
+    self->appsrc[i] = appsrc;
+  }
+
+  /* New clients can only start decoding at a keyframe, and the media
+   * pipeline has its own clock */
+  self->wait_keyframe = TRUE;
+  self->offset_valid = FALSE;
+  g_mutex_unlock (&self->lock);
+
+  gst_object_unref (element);
+}
+
+static void
+client_closed_cb (GstRTSPClient * client, gpointer user_data)
+{
+  GstPlayerRestream *self = user_data;
+
+  g_signal_handlers_disconnect_by_data (client, self);
+  g_atomic_int_add (&self->n_clients, -1);
+  GST_DEBUG ("Restream client %p closed", client);
+}
+
+static void
+client_connected_cb (GstRTSPServer * server, GstRTSPClient * client,
+    gpointer user_data)
+{
+  GstPlayerRestream *self = user_data;
+
+  g_atomic_int_inc (&self->n_clients);
+  g_signal_connect (client, "closed", G_CALLBACK (client_closed_cb), self);
+  GST_DEBUG ("Restream client %p connected", client);
+}
+
+static GstRTSPFilterResult
+remove_client_filter (GstRTSPServer * server, GstRTSPClient * client,
+    gpointer user_data)
+{
+  g_signal_handlers_disconnect_by_data (client, user_data);
+
+  return GST_RTSP_FILTER_REMOVE;
+}
+
+/* Sums up what the UDP sinks of the shared media sent to all clients */
+static guint64
+get_bytes_served (GstRTSPMedia * media)
+{
+  GstElement *element = gst_rtsp_media_get_element (media);
+  GstObject *pipeline = gst_object_get_parent (GST_OBJECT (element));
+  GstIterator *it;
+  GValue item = G_VALUE_INIT;
+  guint64 total = 0, bytes;
+  gboolean done = FALSE;
+
+  gst_object_unref (element);
+  if (!pipeline || !GST_IS_BIN (pipeline)) {
+    if (pipeline)
+      gst_object_unref (pipeline);
+    return 0;
+  }
+
+  it = gst_bin_iterate_sinks (GST_BIN (pipeline));
+  while (!done) {
+    switch (gst_iterator_next (it, &item)) {
+      case GST_ITERATOR_OK:{
+        GstElement *sink = g_value_get_object (&item);
+
+        if (g_object_class_find_property (G_OBJECT_GET_CLASS (sink),
+                "bytes-served")) {
+          g_object_get (sink, "bytes-served", &bytes, NULL);
+          total += bytes;
+        }
+        g_value_reset (&item);
+        break;
+      }
+      case GST_ITERATOR_RESYNC:
+        total = 0;
+        gst_iterator_resync (it);
+        break;
+      default:
+        done = TRUE;
+        break;
+    }
+  }
+  g_value_unset (&item);
+  gst_iterator_free (it);
+  gst_object_unref (pipeline);
+
+  return total;
+}
+
+static gboolean
+stats_cb (gpointer user_data)
+{
+  GstPlayerRestream *self = user_data;
+  GstRTSPMedia *media = NULL;
+  guint64 bytes = 0;
+  gint64 now = g_get_monotonic_time ();
+
+  g_mutex_lock (&self->lock);
+  if (self->media)
+    media = g_object_ref (self->media);
+  g_mutex_unlock (&self->lock);
+
+  if (media) {
+    bytes = get_bytes_served (media);
+    g_object_unref (media);
+  }
+
+  /* The counters start over with every new media */
+  g_mutex_lock (&self->lock);
+  if (bytes >= self->bytes && now > self->bytes_time)
+    self->bitrate = (bytes - self->bytes) * 8 * G_USEC_PER_SEC /
+        (now - self->bytes_time);
+  else
+    self->bitrate = 0;
+  self->bytes = bytes;
+  self->bytes_time = now;
+  g_mutex_unlock (&self->lock);
+
+  return G_SOURCE_CONTINUE;
+}
+
+/* Elements of the launch line and of the RTSP media, registered up front
+ * if static plugins are registered on demand */
+static const gchar *restream_features[] = {
+  "appsrc", "h264parse", "rtph264pay", "aacparse", "rtpmp4gpay", "rtpbin",
+  "udpsrc", "udpsink", "tee", "queue", "funnel", "appsink", NULL
+};
+
+GstPlayerRestream *
+gst_player_restream_new (GMainContext * context, guint port,
+    const gchar * path, GError ** error)
+{
+  GstPlayerRestream *self = g_new0 (GstPlayerRestream, 1);
+  GstRTSPMountPoints *mounts;
+  gchar *service;
+  guint i;
+
+  ensure_debug_category ();
+
+  if (gst_player_plugin_loader_is_lazy ())
+    for (i = 0; restream_features[i]; i++)
+      gst_player_plugin_loader_ensure_feature (restream_features[i]);
+
+  self->ref_count = 1;
+  g_mutex_init (&self->lock);
+  self->port = port;
+  self->path = g_strdup (path);
+
+  self->server = gst_rtsp_server_new ();
+  service = g_strdup_printf ("%u", port);
+  gst_rtsp_server_set_service (self->server, service);
+  g_free (service);
+
+  self->factory = gst_rtsp_media_factory_new ();
+  gst_rtsp_media_factory_set_shared (self->factory, TRUE);
+  gst_rtsp_media_factory_set_protocols (self->factory,
+      GST_RTSP_LOWER_TRANS_UDP | GST_RTSP_LOWER_TRANS_UDP_MCAST);
+  g_signal_connect (self->factory, "media-configure",
+      G_CALLBACK (media_configure_cb), self);
+  update_launch_locked (self);
+
+  mounts = gst_rtsp_server_get_mount_points (self->server);
+  gst_rtsp_mount_points_add_factory (mounts, self->path,
+      g_object_ref (self->factory));
+  g_object_unref (mounts);
+
+  g_signal_connect (self->server, "client-connected",
+      G_CALLBACK (client_connected_cb), self);
+
+  self->server_source = gst_rtsp_server_create_source (self->server, NULL,
+      error);
+  if (!self->server_source) {
+    gst_player_restream_free (self);
+    return NULL;
+  }
+  g_source_attach (self->server_source, context);
+
+  self->bytes_time = g_get_monotonic_time ();
+  self->stats_source = g_timeout_source_new (STATS_INTERVAL_MS);
+  g_source_set_callback (self->stats_source, stats_cb, self, NULL);
+  g_source_attach (self->stats_source, context);
+
+  GST_INFO ("Restreaming on rtsp://0.0.0.0:%u%s", port, path);
+
+  return self;
+}
+
+/* Streaming threads keep a reference while pushing, so that they don't
+ * have to hold the player lock meanwhile */
+GstPlayerRestream *
+gst_player_restream_ref (GstPlayerRestream * self)
+{
+  g_atomic_int_inc (&self->ref_count);
+
+  return self;
+}
+
+void
+gst_player_restream_unref (GstPlayerRestream * self)
+{
+  if (!g_atomic_int_dec_and_test (&self->ref_count))
+    return;
+
+  g_object_unref (self->factory);
+  g_object_unref (self->server);
+  gst_caps_replace (&self->caps[GST_PLAYER_RESTREAM_VIDEO], NULL);
+  gst_caps_replace (&self->caps[GST_PLAYER_RESTREAM_AUDIO], NULL);
+  g_free (self->path);
+  g_mutex_clear (&self->lock);
+  g_free (self);
+}
+
+/* Must be called from the context the server runs in. Stops serving and
+ * drops the reference, pushing data afterwards does nothing */
+void
+gst_player_restream_free (GstPlayerRestream * self)
+{
+  GstRTSPMountPoints *mounts;
+
+  if (!self)
+    return;
+
+  if (self->stats_source) {
+    g_source_destroy (self->stats_source);
+    g_source_unref (self->stats_source);
+  }
+  if (self->server_source) {
+    g_source_destroy (self->server_source);
+    g_source_unref (self->server_source);
+  }
+
+  g_signal_handlers_disconnect_by_data (self->server, self);
+  g_signal_handlers_disconnect_by_data (self->factory, self);
+  gst_rtsp_server_client_filter (self->server, remove_client_filter, self);
+
+  mounts = gst_rtsp_server_get_mount_points (self->server);
+  gst_rtsp_mount_points_remove_factory (mounts, self->path);
+  g_object_unref (mounts);
+
+  g_mutex_lock (&self->lock);
+  clear_media_locked (self);
+  g_mutex_unlock (&self->lock);
+
+  gst_player_restream_unref (self);
+}
+
+gboolean
+gst_player_restream_is_configured (GstPlayerRestream * self, guint port,
+    const gchar * path)
+{
+  return self->port == port && g_strcmp0 (self->path, path) == 0;
+}
+
+/* The stream of @type is taken from @pad from now on. Media created later
+ * on contain all streams for which caps are known */
+void
+gst_player_restream_set_caps (GstPlayerRestream * self,
+    GstPlayerRestreamType type, GstPad * pad, GstCaps * caps)
+{
+  gboolean changed;
+
+  g_mutex_lock (&self->lock);
+  changed = !self->caps[type];
+  self->input[type] = pad;
+  gst_caps_replace (&self->caps[type], caps);
+  if (self->appsrc[type])
+    gst_app_src_set_caps (GST_APP_SRC (self->appsrc[type]), caps);
+  if (changed)
+    update_launch_locked (self);
+  g_mutex_unlock (&self->lock);
+}
+
+/* Called on discontinuities of the input. The media pipeline keeps running,
+ * so new timestamps are mapped to its running time again */
+void
+gst_player_restream_reset (GstPlayerRestream * self)
+{
+  g_mutex_lock (&self->lock);
+  self->offset_valid = FALSE;
+  self->wait_keyframe = TRUE;
+  g_mutex_unlock (&self->lock);
+}
+
+void
+gst_player_restream_push (GstPlayerRestream * self,
+    GstPlayerRestreamType type, GstPad * pad, GstBuffer * buffer)
+{
+  GstElement *appsrc;
+  GstClock *clock;
+  GstClockTime ts, running_time;
+  GstClockTimeDiff offset;
+  gboolean keyframe;
+
+  ts = GST_BUFFER_DTS_IS_VALID (buffer) ? GST_BUFFER_DTS (buffer) :
+      GST_BUFFER_PTS (buffer);
+  keyframe = type == GST_PLAYER_RESTREAM_VIDEO
+      && !GST_BUFFER_FLAG_IS_SET (buffer, GST_BUFFER_FLAG_DELTA_UNIT);
+
+  /* Restreaming was enabled after the caps were sent */
+  g_mutex_lock (&self->lock);
+  if (!self->input[type]) {
+    GstCaps *caps = gst_pad_get_current_caps (pad);
+
+    g_mutex_unlock (&self->lock);
+    if (caps) {
+      gst_player_restream_set_caps (self, type, pad, caps);
+      gst_caps_unref (caps);
+    }
+    g_mutex_lock (&self->lock);
+  }
+
+  if (self->input[type] != pad || !self->appsrc[type]
+      || !GST_CLOCK_TIME_IS_VALID (ts)) {
+    g_mutex_unlock (&self->lock);
+    return;
+  }
+
+  /* Resume with a video keyframe once all queues drained */
+  if (self->wait_keyframe) {
+    if (self->full[GST_PLAYER_RESTREAM_VIDEO]
+        || self->full[GST_PLAYER_RESTREAM_AUDIO]
+        || (self->appsrc[GST_PLAYER_RESTREAM_VIDEO] && !keyframe)) {
+      g_mutex_unlock (&self->lock);
+      return;
+    }
+    self->wait_keyframe = FALSE;
+  }
+
+  appsrc = gst_object_ref (self->appsrc[type]);
+
+  if (!self->offset_valid) {
+    clock = gst_element_get_clock (appsrc);
+    if (!clock) {
+      /* Not playing yet */
+      self->wait_keyframe = TRUE;
+      g_mutex_unlock (&self->lock);
+      gst_object_unref (appsrc);
+      return;
+    }
+    running_time = gst_clock_get_time (clock) -
+        gst_element_get_base_time (appsrc);
+    gst_object_unref (clock);
+
+    self->offset = GST_CLOCK_DIFF (ts, running_time);
+    self->offset_valid = TRUE;
+  }
+  offset = self->offset;
+  g_mutex_unlock (&self->lock);
+
+  if ((GstClockTimeDiff) ts + offset < 0) {
+    gst_object_unref (appsrc);
+    return;
+  }
+
+  /* Shares the memory, only the metadata is copied */
+  buffer = gst_buffer_copy (buffer);
+  GST_BUFFER_DTS (buffer) = GST_BUFFER_DTS_IS_VALID (buffer) ?
+      GST_BUFFER_DTS (buffer) + offset : GST_CLOCK_TIME_NONE;
+  GST_BUFFER_PTS (buffer) = GST_BUFFER_PTS_IS_VALID (buffer) ?
+      GST_BUFFER_PTS (buffer) + offset : GST_CLOCK_TIME_NONE;
+
+  gst_app_src_push_buffer (GST_APP_SRC (appsrc), buffer);
+  gst_object_unref (appsrc);
+}
+
+void
+gst_player_restream_get_stats (GstPlayerRestream * self, guint * n_clients,
+    guint64 * bytes, guint64 * bitrate)
+{
+  *n_clients = g_atomic_int_get (&self->n_clients);
+
+  g_mutex_lock (&self->lock);
+  *bytes = self->bytes;
+  *bitrate = self->bitrate;
+  g_mutex_unlock (&self->lock);
+}
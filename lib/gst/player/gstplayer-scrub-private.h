@@ -0,0 +1,39 @@
+/* GStreamer
+ *
+ * Copyright (C) 2015 Kim DaeHyun <jabiers87@gmail.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __GST_PLAYER_SCRUB_PRIVATE_H__
+#define __GST_PLAYER_SCRUB_PRIVATE_H__
+
+#include <gst/gst.h>
+
+typedef struct _GstPlayerScrub GstPlayerScrub;
+
+/* Called from a streaming thread */
+typedef void (*GstPlayerScrubFrameFunc) (GstSample * sample,
+    GstClockTime position, gpointer user_data);
+
+G_GNUC_INTERNAL GstPlayerScrub * gst_player_scrub_new (GMainContext *
+    context, const gchar * uri, gint width, gint height,
+    GstPlayerScrubFrameFunc func, gpointer user_data);
+G_GNUC_INTERNAL void gst_player_scrub_free (GstPlayerScrub * scrub);
+G_GNUC_INTERNAL void gst_player_scrub_seek (GstPlayerScrub * scrub,
+    GstClockTime position);
+
+#endif
@@ -0,0 +1,483 @@
+/* GStreamer
+ *
+ * Copyright (C) 2015 Kim DaeHyun <jabiers87@gmail.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/* Preview frames while scrubbing, from a pipeline of their own.
+ *
+ * The pipeline stays in PAUSED. Every requested position becomes a
+ * flushing seek to the nearest keyframe, and the prerolled frame is handed
+ * out. Only keyframes reach the video decoder, single-threaded as there is
+ * only one frame to decode at a time, and each frame is scaled down right
+ * after it, before it is converted. Audio is not decoded at all. While a
+ * seek is in flight, newer positions replace each other, so a fast moving
+ * slider never queues up seeks, and seeks are spaced to the display rate.
+ *
+ * FLV streams use the keyframe index stored for the URI, so seeks over the
+ * network don't have to scan the file.
+ *
+ * All functions must be called from the context passed to
+ * gst_player_scrub_new().
+ */
+
+#include "gstplayer-scrub-private.h"
+#include "gstplayer-keyframe-index-private.h"
+#include "gstplayer-plugin-loader.h"
+
+#include <gst/app/gstappsink.h>
+
+#include <string.h>
+
+GST_DEBUG_CATEGORY_STATIC (gst_player_scrub_debug);
+#define GST_CAT_DEFAULT gst_player_scrub_debug
+
+/* Seeks are not started more often than frames can be shown */
+#define MIN_SEEK_INTERVAL (GST_SECOND / 60)
+
+struct _GstPlayerScrub
+{
+  GMainContext *context;
+  GstPlayerScrubFrameFunc func;
+  gpointer user_data;
+  gint width, height;
+
+  GstElement *pipeline;
+  GstElement *convert_bin;
+  GSource *bus_source;
+  GSource *throttle_source;
+  GstPlayerKeyframeIndex *keyframe_index;
+
+  /* Only used from the context */
+  gboolean prerolled, seeking;
+  GstClockTime pending_position;
+  GstClockTime last_seek_time;
+
+  /* Set once the first seek was started, frames before it show the
+   * beginning of the stream */
+  volatile gint seeked;
+};
+
+static void
+ensure_debug_category (void)
+{
+  static gsize done = 0;
+
+  if (g_once_init_enter (&done)) {
+    GST_DEBUG_CATEGORY_INIT (gst_player_scrub_debug, "gst-player-scrub", 0,
+        "GstPlayer scrub preview");
+    g_once_init_leave (&done, 1);
+  }
+}
+
+static void
+set_decoder_property (GstElement * decoder, const gchar * name, gint value)
+{
+  GParamSpec *pspec;
+
+  pspec = g_object_class_find_property (G_OBJECT_GET_CLASS (decoder), name);
+  if (!pspec || !(pspec->flags & G_PARAM_WRITABLE))
+    return;
+
+  if (G_PARAM_SPEC_VALUE_TYPE (pspec) == G_TYPE_BOOLEAN)
+    g_object_set (decoder, name, value != 0, NULL);
+  else if (G_PARAM_SPEC_VALUE_TYPE (pspec) == G_TYPE_INT
+      || G_PARAM_SPEC_VALUE_TYPE (pspec) == G_TYPE_UINT
+      || G_IS_PARAM_SPEC_ENUM (pspec))
+    g_object_set (decoder, name, value, NULL);
+}
+
+static GstPadProbeReturn
+keyframes_only_probe_cb (GstPad * pad, GstPadProbeInfo * info,
+    gpointer user_data)
+{
+  GstBuffer *buffer = GST_PAD_PROBE_INFO_BUFFER (info);
+
+  if (GST_BUFFER_FLAG_IS_SET (buffer, GST_BUFFER_FLAG_DELTA_UNIT))
+    return GST_PAD_PROBE_DROP;
+
+  return GST_PAD_PROBE_OK;
+}
+
+static void
+decodebin_element_added_cb (GstBin * bin, GstElement * element,
+    gpointer user_data)
+{
+  GstPlayerScrub *self = user_data;
+  GstElementFactory *factory = gst_element_get_factory (element);
+  GstPad *pad;
+
+  if (!factory)
+    return;
+
+  if (strcmp (gst_plugin_feature_get_name (factory), "flvdemux") == 0) {
+    gst_player_keyframe_index_attach (self->keyframe_index, element);
+    return;
+  }
+
+  if (!gst_element_factory_list_is_type (factory,
+          GST_ELEMENT_FACTORY_TYPE_DECODER | GST_ELEMENT_FACTORY_TYPE_MEDIA_VIDEO))
+    return;
+
+  /* Frame threads would hold back the single keyframe until more arrive.
+   * "max-threads" is only read when the decoder opens, which is after
+   * this */
+  set_decoder_property (element, "max-threads", 1);
+
+  pad = gst_element_get_static_pad (element, "sink");
+  if (pad) {
+    gst_pad_add_probe (pad, GST_PAD_PROBE_TYPE_BUFFER,
+        keyframes_only_probe_cb, NULL, NULL);
+    gst_object_unref (pad);
+  }
+}
+
+static void
+uridecodebin_element_added_cb (GstBin * bin, GstElement * element,
+    gpointer user_data)
+{
+  GstElementFactory *factory = gst_element_get_factory (element);
+
+  if (factory
+      && strcmp (gst_plugin_feature_get_name (factory), "decodebin") == 0)
+    g_signal_connect (element, "element-added",
+        G_CALLBACK (decodebin_element_added_cb), user_data);
+}
+
+/* Audio is exposed still encoded and thrown away */
+static gboolean
+autoplug_continue_cb (GstElement * element, GstPad * pad, GstCaps * caps,
+    gpointer user_data)
+{
+  const gchar *name;
+
+  if (gst_caps_get_size (caps) == 0)
+    return TRUE;
+
+  name = gst_structure_get_name (gst_caps_get_structure (caps, 0));
+  if (g_str_has_prefix (name, "audio/"))
+    return FALSE;
+
+  /* Registers the decoders before decodebin looks for them */
+  gst_player_plugin_loader_ensure_caps (caps);
+
+  return TRUE;
+}
+
+static void
+pad_added_cb (GstElement * uridecodebin, GstPad * pad, gpointer user_data)
+{
+  GstPlayerScrub *self = user_data;
+  GstElement *fakesink;
+  GstCaps *caps;
+  GstPad *sinkpad;
+  gboolean video;
+
+  caps = gst_pad_get_current_caps (pad);
+  if (!caps)
+    caps = gst_pad_query_caps (pad, NULL);
+  video = gst_caps_get_size (caps) > 0
+      && g_str_has_prefix (gst_structure_get_name (gst_caps_get_structure (caps,
+              0)), "video/x-raw");
+  gst_caps_unref (caps);
+
+  if (video) {
+    sinkpad = gst_element_get_static_pad (self->convert_bin, "sink");
+    if (!gst_pad_is_linked (sinkpad)) {
+      gst_pad_link (pad, sinkpad);
+      gst_object_unref (sinkpad);
+      return;
+    }
+    gst_object_unref (sinkpad);
+  }
+
+  fakesink = gst_element_factory_make ("fakesink", NULL);
+  g_object_set (fakesink, "sync", FALSE, "async", FALSE, NULL);
+  gst_bin_add (GST_BIN (self->pipeline), fakesink);
+  gst_element_sync_state_with_parent (fakesink);
+  sinkpad = gst_element_get_static_pad (fakesink, "sink");
+  gst_pad_link (pad, sinkpad);
+  gst_object_unref (sinkpad);
+}
+
+static GstFlowReturn
+new_preroll_cb (GstAppSink * appsink, gpointer user_data)
+{
+  GstPlayerScrub *self = user_data;
+  GstSample *sample;
+  GstBuffer *buffer;
+
+  sample = gst_app_sink_pull_preroll (appsink);
+  if (!sample)
+    return GST_FLOW_OK;
+
+  buffer = gst_sample_get_buffer (sample);
+  if (g_atomic_int_get (&self->seeked) && buffer)
+    self->func (sample, GST_BUFFER_PTS (buffer), self->user_data);
+  gst_sample_unref (sample);
+
+  return GST_FLOW_OK;
+}
+
+static GstFlowReturn
+new_sample_cb (GstAppSink * appsink, gpointer user_data)
+{
+  GstSample *sample;
+
+  /* Never reached in PAUSED, only drained */
+  sample = gst_app_sink_pull_sample (appsink);
+  if (sample)
+    gst_sample_unref (sample);
+
+  return GST_FLOW_OK;
+}
+
+static gboolean throttle_cb (gpointer user_data);
+
+static void
+do_seek (GstPlayerScrub * self)
+{
+  GstClockTime now = gst_util_get_timestamp ();
+  GstClockTime position = self->pending_position;
+
+  if (GST_CLOCK_TIME_IS_VALID (self->last_seek_time)
+      && now < self->last_seek_time + MIN_SEEK_INTERVAL) {
+    if (!self->throttle_source) {
+      self->throttle_source =
+          g_timeout_source_new ((self->last_seek_time + MIN_SEEK_INTERVAL -
+              now) / GST_MSECOND + 1);
+      g_source_set_callback (self->throttle_source, throttle_cb, self, NULL);
+      g_source_attach (self->throttle_source, self->context);
+    }
+    return;
+  }
+
+  GST_DEBUG ("Seeking to %" GST_TIME_FORMAT, GST_TIME_ARGS (position));
+  self->pending_position = GST_CLOCK_TIME_NONE;
+  self->last_seek_time = now;
+  g_atomic_int_set (&self->seeked, 1);
+
+  if (gst_element_seek (self->pipeline, 1.0, GST_FORMAT_TIME,
+          GST_SEEK_FLAG_FLUSH | GST_SEEK_FLAG_KEY_UNIT |
+          GST_SEEK_FLAG_SNAP_NEAREST, GST_SEEK_TYPE_SET, position,
+          GST_SEEK_TYPE_NONE, GST_CLOCK_TIME_NONE))
+    self->seeking = TRUE;
+  else
+    GST_WARNING ("Seek to %" GST_TIME_FORMAT " failed",
+        GST_TIME_ARGS (position));
+}
+
+static gboolean
+throttle_cb (gpointer user_data)
+{
+  GstPlayerScrub *self = user_data;
+
+  g_source_unref (self->throttle_source);
+  self->throttle_source = NULL;
+
+  if (!self->seeking && GST_CLOCK_TIME_IS_VALID (self->pending_position))
+    do_seek (self);
+
+  return G_SOURCE_REMOVE;
+}
+
+static gboolean
+bus_cb (GstBus * bus, GstMessage * msg, gpointer user_data)
+{
+  GstPlayerScrub *self = user_data;
+
+  switch (GST_MESSAGE_TYPE (msg)) {
+    case GST_MESSAGE_ASYNC_DONE:
+      self->prerolled = TRUE;
+      self->seeking = FALSE;
+      if (GST_CLOCK_TIME_IS_VALID (self->pending_position))
+        do_seek (self);
+      break;
+    case GST_MESSAGE_ERROR:{
+      GError *err;
+
+      /* Scrubbing just shows no previews then */
+      gst_message_parse_error (msg, &err, NULL);
+      GST_WARNING ("Error from %s: %s", GST_OBJECT_NAME (GST_MESSAGE_SRC (msg)),
+          err->message);
+      g_error_free (err);
+      gst_element_set_state (self->pipeline, GST_STATE_NULL);
+      self->prerolled = FALSE;
+      self->seeking = FALSE;
+      break;
+    }
+    default:
+      break;
+  }
+
+  return G_SOURCE_CONTINUE;
+}
+
+static GstElement *
+create_convert_bin (GstPlayerScrub * self)
+{
+  GstElement *bin, *scale, *convert, *filter, *sink;
+  GstAppSinkCallbacks callbacks = { NULL, };
+  GstCaps *caps;
+  GstPad *pad;
+
+  bin = gst_bin_new ("preview");
+  scale = gst_element_factory_make ("videoscale", NULL);
+  convert = gst_element_factory_make ("videoconvert", NULL);
+  filter = gst_element_factory_make ("capsfilter", NULL);
+  sink = gst_element_factory_make ("appsink", NULL);
+
+  if (!scale || !convert || !filter || !sink) {
+    GST_ERROR ("Missing elements for scrub previews");
+    if (scale)
+      gst_object_unref (scale);
+    if (convert)
+      gst_object_unref (convert);
+    if (filter)
+      gst_object_unref (filter);
+    if (sink)
+      gst_object_unref (sink);
+    gst_object_unref (bin);
+    return NULL;
+  }
+
+  /* Letterboxed to exactly the requested size */
+  g_object_set (scale, "add-borders", TRUE, NULL);
+  caps = gst_caps_new_simple ("video/x-raw", "format", G_TYPE_STRING, "RGBA",
+      "width", G_TYPE_INT, self->width, "height", G_TYPE_INT, self->height,
+      "pixel-aspect-ratio", GST_TYPE_FRACTION, 1, 1, NULL);
+  g_object_set (filter, "caps", caps, NULL);
+  gst_caps_unref (caps);
+
+  g_object_set (sink, "sync", FALSE, "max-buffers", 1, "drop", TRUE,
+      "enable-last-sample", FALSE, NULL);
+  callbacks.new_preroll = new_preroll_cb;
+  callbacks.new_sample = new_sample_cb;
+  gst_app_sink_set_callbacks (GST_APP_SINK (sink), &callbacks, self, NULL);
+
+  gst_bin_add_many (GST_BIN (bin), scale, convert, filter, sink, NULL);
+  gst_element_link_many (scale, convert, filter, sink, NULL);
+
+  pad = gst_element_get_static_pad (scale, "sink");
+  gst_element_add_pad (bin, gst_ghost_pad_new ("sink", pad));
+  gst_object_unref (pad);
+
+  return bin;
+}
+
+/* Elements created by name, registered up front if static plugins are
+ * registered on demand */
+static const gchar *scrub_features[] = {
+  "uridecodebin", "decodebin", "typefind", "queue", "videoscale",
+  "videoconvert", "capsfilter", "appsink", "fakesink", NULL
+};
+
+GstPlayerScrub *
+gst_player_scrub_new (GMainContext * context, const gchar * uri, gint width,
+    gint height, GstPlayerScrubFrameFunc func, gpointer user_data)
+{
+  GstPlayerScrub *self;
+  GstElement *source;
+  GstBus *bus;
+  guint i;
+
+  ensure_debug_category ();
+
+  if (gst_player_plugin_loader_is_lazy ()) {
+    for (i = 0; scrub_features[i]; i++)
+      gst_player_plugin_loader_ensure_feature (scrub_features[i]);
+    gst_player_plugin_loader_ensure_uri (uri);
+  }
+
+  self = g_new0 (GstPlayerScrub, 1);
+  self->context = g_main_context_ref (context);
+  self->func = func;
+  self->user_data = user_data;
+  self->width = width;
+  self->height = height;
+  self->pending_position = GST_CLOCK_TIME_NONE;
+  self->last_seek_time = GST_CLOCK_TIME_NONE;
+
+  source = gst_element_factory_make ("uridecodebin", NULL);
+  self->convert_bin = create_convert_bin (self);
+  if (!source || !self->convert_bin) {
+    if (source)
+      gst_object_unref (source);
+    if (self->convert_bin)
+      gst_object_unref (self->convert_bin);
+    g_main_context_unref (self->context);
+    g_free (self);
+    return NULL;
+  }
+
+  self->keyframe_index = gst_player_keyframe_index_new (uri);
+
+  self->pipeline = gst_pipeline_new ("scrub");
+  gst_object_ref_sink (self->pipeline);
+  gst_bin_add_many (GST_BIN (self->pipeline), source, self->convert_bin, NULL);
+
+  g_object_set (source, "uri", uri, NULL);
+  g_signal_connect (source, "autoplug-continue",
+      G_CALLBACK (autoplug_continue_cb), self);
+  g_signal_connect (source, "element-added",
+      G_CALLBACK (uridecodebin_element_added_cb), self);
+  g_signal_connect (source, "pad-added", G_CALLBACK (pad_added_cb), self);
+
+  bus = gst_element_get_bus (self->pipeline);
+  self->bus_source = gst_bus_create_watch (bus);
+  g_source_set_callback (self->bus_source, (GSourceFunc) bus_cb, self, NULL);
+  g_source_attach (self->bus_source, context);
+  gst_object_unref (bus);
+
+  GST_DEBUG ("Previewing %s at %dx%d", uri, width, height);
+  if (gst_element_set_state (self->pipeline,
+          GST_STATE_PAUSED) == GST_STATE_CHANGE_FAILURE)
+    GST_WARNING ("Failed to start scrub preview of %s", uri);
+
+  return self;
+}
+
+void
+gst_player_scrub_free (GstPlayerScrub * self)
+{
+  if (!self)
+    return;
+
+  gst_element_set_state (self->pipeline, GST_STATE_NULL);
+
+  if (self->throttle_source) {
+    g_source_destroy (self->throttle_source);
+    g_source_unref (self->throttle_source);
+  }
+  g_source_destroy (self->bus_source);
+  g_source_unref (self->bus_source);
+
+  gst_object_unref (self->pipeline);
+  gst_player_keyframe_index_unref (self->keyframe_index);
+  g_main_context_unref (self->context);
+  g_free (self);
+}
+
+void
+gst_player_scrub_seek (GstPlayerScrub * self, GstClockTime position)
+{
+  self->pending_position = position;
+
+  /* Picked up when the current seek or the initial preroll finished */
+  if (self->prerolled && !self->seeking && !self->throttle_source)
+    do_seek (self);
+}
@@ -0,0 +1,57 @@
+/* GStreamer
+ *
+ * Copyright (C) 2015 Kim DaeHyun <jabiers87@gmail.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __GST_PLAYER_SUBTITLE_OVERLAY_PRIVATE_H__
+#define __GST_PLAYER_SUBTITLE_OVERLAY_PRIVATE_H__
+
+#include <gst/gst.h>
+#include <gst/video/video.h>
+
+typedef struct _GstPlayerSubtitleOverlay GstPlayerSubtitleOverlay;
+
+/* Returns the cue rendered for a frame of @width x @height, or NULL */
+typedef GstVideoOverlayRectangle *(*GstPlayerSubtitleOverlayRasterizeFunc)
+    (const gchar * text, gboolean markup, gint width, gint height,
+    gpointer user_data);
+
+G_GNUC_INTERNAL GstPlayerSubtitleOverlay *
+gst_player_subtitle_overlay_new (GstPlayerSubtitleOverlayRasterizeFunc func,
+    gpointer user_data);
+G_GNUC_INTERNAL void gst_player_subtitle_overlay_free (GstPlayerSubtitleOverlay
+    * overlay);
+G_GNUC_INTERNAL void gst_player_subtitle_overlay_set_enabled
+    (GstPlayerSubtitleOverlay * overlay, gboolean enabled);
+G_GNUC_INTERNAL void gst_player_subtitle_overlay_add_cue
+    (GstPlayerSubtitleOverlay * overlay, const gchar * text, gboolean markup,
+    GstClockTime start, GstClockTime stop);
+G_GNUC_INTERNAL void gst_player_subtitle_overlay_flush (GstPlayerSubtitleOverlay
+    * overlay);
+G_GNUC_INTERNAL void gst_player_subtitle_overlay_set_caps
+    (GstPlayerSubtitleOverlay * overlay, GstCaps * caps);
+G_GNUC_INTERNAL void gst_player_subtitle_overlay_set_meta_supported
+    (GstPlayerSubtitleOverlay * overlay, gboolean supported);
+G_GNUC_INTERNAL GstBuffer *
+gst_player_subtitle_overlay_process (GstPlayerSubtitleOverlay * overlay,
+    GstBuffer * buffer, GstClockTime running_time);
+G_GNUC_INTERNAL void gst_player_subtitle_overlay_get_stats
+    (GstPlayerSubtitleOverlay * overlay, guint * n_rasterized,
+    guint * n_cache_hits, GstClockTime * blend_time);
+
+#endif
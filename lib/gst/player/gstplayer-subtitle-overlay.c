@@ -0,0 +1,539 @@
+/* GStreamer
+ *
+ * Copyright (C) 2015 Kim DaeHyun <jabiers87@gmail.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/* Subtitle cues composed onto video frames.
+ *
+ * Each cue is rasterized once, by a function the application provides,
+ * into an ARGB overlay rectangle that is cached by the cue text for as
+ * long as the frame size does not change. Frames showing the same cues
+ * share a single overlay composition. If the video sink accepts overlay
+ * composition metadata the composition is only attached to the frames and
+ * composited by the sink, which is usually done on the GPU. Otherwise the
+ * rectangles are blended into the frames here, with SIMD for the RGB
+ * formats a sink typically takes and with the generic blending of
+ * libgstvideo for all others.
+ */
+
+#include "gstplayer-subtitle-overlay-private.h"
+
+#include <string.h>
+
+#if defined(__ARM_NEON__) || defined(__ARM_NEON)
+#include <arm_neon.h>
+#define HAVE_NEON 1
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define HAVE_SSE2 1
+#endif
+
+/* Rasterized cues kept before the cache is dropped, e.g. on long films */
+#define MAX_CACHED_CUES 64
+
+typedef struct
+{
+  gchar *key;
+  GstClockTime start, stop;
+} Cue;
+
+struct _GstPlayerSubtitleOverlay
+{
+  GMutex lock;
+
+  GstPlayerSubtitleOverlayRasterizeFunc rasterize;
+  gpointer user_data;
+
+  gboolean enabled;
+  gboolean meta_supported;
+  GstVideoInfo info;
+  gboolean info_valid;
+
+  /* Cues by start time */
+  GQueue cues;
+  /* key -> GstVideoOverlayRectangle, NULL if the cue rendered nothing */
+  GHashTable *cache;
+
+  /* Composition of the cues shown last, the rectangles are reffed as the
+   * cache may drop them while they are still shown */
+  GPtrArray *rectangles;
+  GstVideoOverlayComposition *composition;
+
+  guint n_rasterized, n_cache_hits;
+  GstClockTime blend_time;
+};
+
+static void
+cue_free (Cue * cue)
+{
+  g_free (cue->key);
+  g_slice_free (Cue, cue);
+}
+
+static void
+clear_composition_locked (GstPlayerSubtitleOverlay * overlay)
+{
+  g_ptr_array_set_size (overlay->rectangles, 0);
+  if (overlay->composition)
+    gst_video_overlay_composition_unref (overlay->composition);
+  overlay->composition = NULL;
+}
+
+static void
+rectangle_unref (gpointer rectangle)
+{
+  if (rectangle)
+    gst_video_overlay_rectangle_unref (rectangle);
+}
+
+GstPlayerSubtitleOverlay *
+gst_player_subtitle_overlay_new (GstPlayerSubtitleOverlayRasterizeFunc func,
+    gpointer user_data)
+{
+  GstPlayerSubtitleOverlay *overlay = g_new0 (GstPlayerSubtitleOverlay, 1);
+
+  g_mutex_init (&overlay->lock);
+  overlay->rasterize = func;
+  overlay->user_data = user_data;
+  g_queue_init (&overlay->cues);
+  overlay->cache =
+      g_hash_table_new_full (g_str_hash, g_str_equal, g_free, rectangle_unref);
+  overlay->rectangles = g_ptr_array_new_with_free_func (rectangle_unref);
+
+  return overlay;
+}
+
+void
+gst_player_subtitle_overlay_free (GstPlayerSubtitleOverlay * overlay)
+{
+  clear_composition_locked (overlay);
+  g_ptr_array_unref (overlay->rectangles);
+  g_hash_table_unref (overlay->cache);
+  g_queue_foreach (&overlay->cues, (GFunc) cue_free, NULL);
+  g_queue_clear (&overlay->cues);
+  g_mutex_clear (&overlay->lock);
+  g_free (overlay);
+}
+
+/* Frames pass unchanged while disabled. Cached cues are dropped, as the
+ * rasterizer may have changed. */
+void
+gst_player_subtitle_overlay_set_enabled (GstPlayerSubtitleOverlay * overlay,
+    gboolean enabled)
+{
+  g_mutex_lock (&overlay->lock);
+  overlay->enabled = enabled;
+  clear_composition_locked (overlay);
+  g_hash_table_remove_all (overlay->cache);
+  g_mutex_unlock (&overlay->lock);
+}
+
+/* @start and @stop are running times, a cue without @stop is shown until
+ * the next one starts */
+void
+gst_player_subtitle_overlay_add_cue (GstPlayerSubtitleOverlay * overlay,
+    const gchar * text, gboolean markup, GstClockTime start,
+    GstClockTime stop)
+{
+  Cue *cue;
+  GList *l;
+
+  if (!GST_CLOCK_TIME_IS_VALID (start))
+    return;
+
+  cue = g_slice_new (Cue);
+  /* Equal text in markup and plain text renders differently */
+  cue->key = g_strconcat (markup ? "m" : "t", text, NULL);
+  cue->start = start;
+  cue->stop = stop;
+
+  g_mutex_lock (&overlay->lock);
+  for (l = overlay->cues.tail; l; l = l->prev) {
+    if (((Cue *) l->data)->start <= start)
+      break;
+  }
+  if (l)
+    g_queue_insert_after (&overlay->cues, l, cue);
+  else
+    g_queue_push_head (&overlay->cues, cue);
+  g_mutex_unlock (&overlay->lock);
+}
+
+/* Forgets all cues, e.g. after a flush. Rasterized cues stay cached. */
+void
+gst_player_subtitle_overlay_flush (GstPlayerSubtitleOverlay * overlay)
+{
+  g_mutex_lock (&overlay->lock);
+  g_queue_foreach (&overlay->cues, (GFunc) cue_free, NULL);
+  g_queue_clear (&overlay->cues);
+  clear_composition_locked (overlay);
+  g_mutex_unlock (&overlay->lock);
+}
+
+void
+gst_player_subtitle_overlay_set_caps (GstPlayerSubtitleOverlay * overlay,
+    GstCaps * caps)
+{
+  GstVideoInfo info;
+
+  if (!gst_video_info_from_caps (&info, caps))
+    return;
+
+  g_mutex_lock (&overlay->lock);
+  /* Cues are rasterized for the frame size */
+  if (!overlay->info_valid
+      || GST_VIDEO_INFO_WIDTH (&info) != GST_VIDEO_INFO_WIDTH (&overlay->info)
+      || GST_VIDEO_INFO_HEIGHT (&info) !=
+      GST_VIDEO_INFO_HEIGHT (&overlay->info)) {
+    clear_composition_locked (overlay);
+    g_hash_table_remove_all (overlay->cache);
+  }
+  overlay->info = info;
+  overlay->info_valid = TRUE;
+  g_mutex_unlock (&overlay->lock);
+}
+
+/* Whether downstream composites overlay composition metadata itself */
+void
+gst_player_subtitle_overlay_set_meta_supported (GstPlayerSubtitleOverlay *
+    overlay, gboolean supported)
+{
+  g_mutex_lock (&overlay->lock);
+  overlay->meta_supported = supported;
+  g_mutex_unlock (&overlay->lock);
+}
+
+/* Returns a new reference to the rasterized cue, or NULL if it renders
+ * nothing */
+static GstVideoOverlayRectangle *
+get_rectangle_locked (GstPlayerSubtitleOverlay * overlay, Cue * cue)
+{
+  GstVideoOverlayRectangle *rectangle;
+  gpointer cached;
+
+  if (g_hash_table_lookup_extended (overlay->cache, cue->key, NULL, &cached)) {
+    overlay->n_cache_hits++;
+    return cached ? gst_video_overlay_rectangle_ref (cached) : NULL;
+  }
+
+  if (g_hash_table_size (overlay->cache) >= MAX_CACHED_CUES)
+    g_hash_table_remove_all (overlay->cache);
+
+  rectangle = overlay->rasterize (cue->key + 1, cue->key[0] == 'm',
+      GST_VIDEO_INFO_WIDTH (&overlay->info),
+      GST_VIDEO_INFO_HEIGHT (&overlay->info), overlay->user_data);
+  overlay->n_rasterized++;
+  g_hash_table_insert (overlay->cache, g_strdup (cue->key), rectangle);
+
+  return rectangle ? gst_video_overlay_rectangle_ref (rectangle) : NULL;
+}
+
+/* Drops cues that ended before @running_time and returns the composition
+ * of those shown at it, NULL if there are none */
+static GstVideoOverlayComposition *
+update_composition_locked (GstPlayerSubtitleOverlay * overlay,
+    GstClockTime running_time)
+{
+  GstVideoOverlayRectangle *rectangle;
+  GPtrArray *shown;
+  gboolean changed;
+  GList *l, *next;
+  guint i;
+
+  shown = g_ptr_array_new_with_free_func (rectangle_unref);
+  for (l = overlay->cues.head; l; l = next) {
+    Cue *cue = l->data;
+
+    next = l->next;
+    if (cue->start > running_time)
+      break;
+
+    if ((GST_CLOCK_TIME_IS_VALID (cue->stop) && cue->stop <= running_time)
+        || (!GST_CLOCK_TIME_IS_VALID (cue->stop) && next
+            && ((Cue *) next->data)->start <= running_time)) {
+      cue_free (cue);
+      g_queue_delete_link (&overlay->cues, l);
+      continue;
+    }
+
+    rectangle = get_rectangle_locked (overlay, cue);
+    if (rectangle)
+      g_ptr_array_add (shown, rectangle);
+  }
+
+  changed = shown->len != overlay->rectangles->len;
+  for (i = 0; !changed && i < shown->len; i++)
+    changed = shown->pdata[i] != overlay->rectangles->pdata[i];
+
+  if (changed) {
+    clear_composition_locked (overlay);
+    for (i = 0; i < shown->len; i++) {
+      rectangle = shown->pdata[i];
+      g_ptr_array_add (overlay->rectangles,
+          gst_video_overlay_rectangle_ref (rectangle));
+      if (overlay->composition)
+        gst_video_overlay_composition_add_rectangle (overlay->composition,
+            rectangle);
+      else
+        overlay->composition = gst_video_overlay_composition_new (rectangle);
+    }
+  }
+  g_ptr_array_unref (shown);
+
+  return overlay->composition;
+}
+
+static inline guint8
+div255 (guint t)
+{
+  t += 128;
+  return (t + (t >> 8)) >> 8;
+}
+
+/* Blends @n pixels of non-premultiplied BGRA @src over 4 byte pixels of
+ * @dst, in BGRA order or with red and blue swapped if @swap. The alpha
+ * byte of @dst is composited as well, for formats without alpha it is
+ * unused anyway. */
+static void
+blend_row (const guint8 * src, guint8 * dst, gint n, gboolean swap)
+{
+  gint r = swap ? 0 : 2, b = swap ? 2 : 0;
+  gint i = 0;
+  guint a;
+
+#if defined(HAVE_NEON)
+  for (; i + 8 <= n; i += 8) {
+    uint8x8x4_t s = vld4_u8 (src + 4 * i);
+    uint8x8x4_t d;
+    uint8x8_t ia, v[4];
+    gint c;
+
+    /* Mostly transparent around the text */
+    if (vget_lane_u64 (vreinterpret_u64_u8 (s.val[3]), 0) == 0)
+      continue;
+
+    d = vld4_u8 (dst + 4 * i);
+    ia = vmvn_u8 (s.val[3]);
+    v[b] = s.val[0];
+    v[1] = s.val[1];
+    v[r] = s.val[2];
+    v[3] = vdup_n_u8 (255);
+    for (c = 0; c < 4; c++) {
+      uint16x8_t t = vmull_u8 (v[c], s.val[3]);
+
+      t = vmlal_u8 (t, d.val[c], ia);
+      t = vaddq_u16 (t, vdupq_n_u16 (128));
+      d.val[c] = vshrn_n_u16 (vsraq_n_u16 (t, t, 8), 8);
+    }
+    vst4_u8 (dst + 4 * i, d);
+  }
+#elif defined(HAVE_SSE2)
+  const __m128i zero = _mm_setzero_si128 ();
+  const __m128i alpha = _mm_set1_epi32 (0xff000000);
+  const __m128i ff = _mm_set1_epi16 (255);
+  const __m128i round = _mm_set1_epi16 (128);
+
+  for (; i + 4 <= n; i += 4) {
+    __m128i s = _mm_loadu_si128 ((const __m128i *) (src + 4 * i));
+    __m128i d, a32, av, v, lo, hi, alo, ahi;
+
+    a32 = _mm_srli_epi32 (s, 24);
+    if (_mm_movemask_epi8 (_mm_cmpeq_epi32 (a32, zero)) == 0xffff)
+      continue;
+
+    d = _mm_loadu_si128 ((const __m128i *) (dst + 4 * i));
+    av = _mm_or_si128 (_mm_or_si128 (a32, _mm_slli_epi32 (a32, 8)),
+        _mm_or_si128 (_mm_slli_epi32 (a32, 16), _mm_slli_epi32 (a32, 24)));
+    v = _mm_or_si128 (s, alpha);
+    if (swap)
+      v = _mm_or_si128 (_mm_and_si128 (v, _mm_set1_epi32 (0xff00ff00)),
+          _mm_or_si128 (_mm_and_si128 (_mm_srli_epi32 (v, 16),
+                  _mm_set1_epi32 (0xff)), _mm_slli_epi32 (_mm_and_si128 (v,
+                      _mm_set1_epi32 (0xff)), 16)));
+
+    alo = _mm_unpacklo_epi8 (av, zero);
+    ahi = _mm_unpackhi_epi8 (av, zero);
+    lo = _mm_add_epi16 (_mm_add_epi16 (_mm_mullo_epi16 (_mm_unpacklo_epi8 (v,
+                    zero), alo), _mm_mullo_epi16 (_mm_unpacklo_epi8 (d, zero),
+                _mm_sub_epi16 (ff, alo))), round);
+    hi = _mm_add_epi16 (_mm_add_epi16 (_mm_mullo_epi16 (_mm_unpackhi_epi8 (v,
+                    zero), ahi), _mm_mullo_epi16 (_mm_unpackhi_epi8 (d, zero),
+                _mm_sub_epi16 (ff, ahi))), round);
+    lo = _mm_srli_epi16 (_mm_add_epi16 (lo, _mm_srli_epi16 (lo, 8)), 8);
+    hi = _mm_srli_epi16 (_mm_add_epi16 (hi, _mm_srli_epi16 (hi, 8)), 8);
+    _mm_storeu_si128 ((__m128i *) (dst + 4 * i), _mm_packus_epi16 (lo, hi));
+  }
+#endif
+
+  for (src += 4 * i, dst += 4 * i; i < n; i++, src += 4, dst += 4) {
+    a = src[3];
+    if (a == 0)
+      continue;
+    dst[b] = div255 (src[0] * a + dst[b] * (255 - a));
+    dst[1] = div255 (src[1] * a + dst[1] * (255 - a));
+    dst[r] = div255 (src[2] * a + dst[r] * (255 - a));
+    dst[3] = div255 (255 * a + dst[3] * (255 - a));
+  }
+}
+
+/* Returns FALSE if the rectangle has to be blended generically, e.g.
+ * because it is rendered at a different size than rasterized */
+static gboolean
+can_blend_rectangle (GstVideoOverlayRectangle * rectangle)
+{
+  GstVideoMeta *meta;
+  gint x, y;
+  guint w, h;
+
+  meta =
+      gst_buffer_get_video_meta (gst_video_overlay_rectangle_get_pixels_raw
+      (rectangle, GST_VIDEO_OVERLAY_FORMAT_FLAG_NONE));
+  gst_video_overlay_rectangle_get_render_rectangle (rectangle, &x, &y, &w, &h);
+
+  return meta && meta->format == GST_VIDEO_FORMAT_BGRA && meta->width == w
+      && meta->height == h;
+}
+
+/* Only for rectangles can_blend_rectangle() accepted */
+static void
+blend_rectangle (GstVideoOverlayRectangle * rectangle, GstVideoFrame * frame,
+    gboolean swap)
+{
+  GstBuffer *pixels;
+  GstVideoMeta *meta;
+  GstMapInfo map;
+  gint x, y, x0, y0, x1, y1;
+  guint w, h;
+  guint8 *dst;
+  gint stride;
+
+  pixels = gst_video_overlay_rectangle_get_pixels_raw (rectangle,
+      GST_VIDEO_OVERLAY_FORMAT_FLAG_NONE);
+  meta = gst_buffer_get_video_meta (pixels);
+  gst_video_overlay_rectangle_get_render_rectangle (rectangle, &x, &y, &w, &h);
+
+  x0 = MAX (x, 0);
+  y0 = MAX (y, 0);
+  x1 = MIN (x + (gint) w, GST_VIDEO_FRAME_WIDTH (frame));
+  y1 = MIN (y + (gint) h, GST_VIDEO_FRAME_HEIGHT (frame));
+  if (x0 >= x1 || y0 >= y1)
+    return;
+
+  if (!gst_buffer_map (pixels, &map, GST_MAP_READ))
+    return;
+
+  dst = GST_VIDEO_FRAME_PLANE_DATA (frame, 0);
+  stride = GST_VIDEO_FRAME_PLANE_STRIDE (frame, 0);
+  for (; y0 < y1; y0++)
+    blend_row (map.data + meta->offset[0] + (y0 - y) * meta->stride[0] +
+        4 * (x0 - x), dst + y0 * stride + 4 * x0, x1 - x0, swap);
+  gst_buffer_unmap (pixels, &map);
+}
+
+static void
+blend (GstVideoOverlayComposition * composition, GstVideoFrame * frame)
+{
+  gboolean swap;
+  guint i, n;
+
+  switch (GST_VIDEO_FRAME_FORMAT (frame)) {
+    case GST_VIDEO_FORMAT_BGRA:
+    case GST_VIDEO_FORMAT_BGRx:
+      swap = FALSE;
+      break;
+    case GST_VIDEO_FORMAT_RGBA:
+    case GST_VIDEO_FORMAT_RGBx:
+      swap = TRUE;
+      break;
+    default:
+      gst_video_overlay_composition_blend (composition, frame);
+      return;
+  }
+
+  /* All or nothing, so no rectangle is blended twice */
+  n = gst_video_overlay_composition_n_rectangles (composition);
+  for (i = 0; i < n; i++) {
+    if (!can_blend_rectangle (gst_video_overlay_composition_get_rectangle
+            (composition, i))) {
+      gst_video_overlay_composition_blend (composition, frame);
+      return;
+    }
+  }
+
+  for (i = 0; i < n; i++)
+    blend_rectangle (gst_video_overlay_composition_get_rectangle (composition,
+            i), frame, swap);
+}
+
+/* Returns @buffer, or a writable copy with the cues shown at @running_time
+ * attached or blended in. Takes ownership of @buffer. */
+GstBuffer *
+gst_player_subtitle_overlay_process (GstPlayerSubtitleOverlay * overlay,
+    GstBuffer * buffer, GstClockTime running_time)
+{
+  GstVideoOverlayComposition *composition = NULL;
+  GstClockTime start;
+  GstVideoFrame frame;
+  GstVideoInfo info;
+  gboolean attach = FALSE;
+
+  if (!GST_CLOCK_TIME_IS_VALID (running_time))
+    return buffer;
+
+  g_mutex_lock (&overlay->lock);
+  if (overlay->enabled && overlay->info_valid) {
+    composition = update_composition_locked (overlay, running_time);
+    if (composition)
+      gst_video_overlay_composition_ref (composition);
+    attach = overlay->meta_supported;
+    info = overlay->info;
+  }
+  g_mutex_unlock (&overlay->lock);
+
+  if (!composition)
+    return buffer;
+
+  buffer = gst_buffer_make_writable (buffer);
+  if (attach) {
+    gst_buffer_add_video_overlay_composition_meta (buffer, composition);
+  } else {
+    start = gst_util_get_timestamp ();
+    if (gst_video_frame_map (&frame, &info, buffer, GST_MAP_READWRITE)) {
+      blend (composition, &frame);
+      gst_video_frame_unmap (&frame);
+    }
+
+    g_mutex_lock (&overlay->lock);
+    overlay->blend_time += gst_util_get_timestamp () - start;
+    g_mutex_unlock (&overlay->lock);
+  }
+  gst_video_overlay_composition_unref (composition);
+
+  return buffer;
+}
+
+void
+gst_player_subtitle_overlay_get_stats (GstPlayerSubtitleOverlay * overlay,
+    guint * n_rasterized, guint * n_cache_hits, GstClockTime * blend_time)
+{
+  g_mutex_lock (&overlay->lock);
+  *n_rasterized = overlay->n_rasterized;
+  *n_cache_hits = overlay->n_cache_hits;
+  *blend_time = overlay->blend_time;
+  g_mutex_unlock (&overlay->lock);
+}
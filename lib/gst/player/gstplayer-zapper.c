@@ -0,0 +1,1269 @@
+/* GStreamer
+ *
+ * Copyright (C) 2015 Kim DaeHyun <jabiers87@gmail.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/**
+ * SECTION:gstplayer-zapper
+ * @short_description: GStreamer Player fast channel switching
+ *
+ * A #GstPlayerZapper makes switching between live streams on a #GstPlayer
+ * fast. It keeps connections open to the streams the user is most likely
+ * to switch to next, for example the neighbors of the selected stream in
+ * a list, and caches the latest group of pictures of each. When the user
+ * switches to one of them, the player gets the cached data first, so it
+ * doesn't have to wait for the connection to be set up and for the next
+ * keyframe.
+ *
+ * Prefetched streams are not decoded, so their CPU cost is small. The
+ * number of them, the memory for each cache and the bandwidth they use
+ * together are limited. Only FLV streams, as served over RTMP, are cached.
+ * Other streams are played normally.
+ */
+
+#include "gstplayer-zapper.h"
+#include "gstplayer-plugin-loader.h"
+
+#include <gst/app/gstappsrc.h>
+#include <gst/app/gstappsink.h>
+#include <gst/base/gstadapter.h>
+
+#include <string.h>
+
+GST_DEBUG_CATEGORY_STATIC (gst_player_zapper_debug);
+#define GST_CAT_DEFAULT gst_player_zapper_debug
+
+#define DEFAULT_MAX_STREAMS 2
+#define DEFAULT_MAX_BYTES (4 * 1024 * 1024)
+#define DEFAULT_MAX_BITRATE 0
+#define STATS_INTERVAL_MS 1000
+
+/* URI the player gets for a cached stream, its source is fed by us */
+#define HANDOVER_URI "appsrc://"
+
+#define FLV_HEADER_SIZE 9
+#define FLV_TAG_HEADER_SIZE 11
+#define FLV_TAG_AUDIO 8
+#define FLV_TAG_VIDEO 9
+#define FLV_TAG_SCRIPT 18
+#define FLV_CODEC_AVC 7
+#define FLV_SOUND_FORMAT_AAC 10
+
+enum
+{
+  PROP_0,
+  PROP_PLAYER,
+  PROP_MAX_STREAMS,
+  PROP_MAX_BYTES,
+  PROP_MAX_BITRATE,
+  PROP_LAST
+};
+
+typedef struct
+{
+  GstPlayerZapper *zapper;
+  gchar *uri;
+  GstElement *bin;
+
+  /* Only used from the streaming thread */
+  GstAdapter *adapter;
+  gboolean header_parsed;
+  gboolean dropping;            /* Player fell behind, wait for a keyframe */
+
+  /* Protected by the zapper lock */
+  GstBuffer *header, *metadata, *video_config, *audio_config;
+  GQueue gop;                   /* Tags since the last video keyframe */
+  gsize gop_bytes;
+  gboolean have_keyframe;
+  GstElement *pending_appsrc;   /* Started, but the cache is not pushed */
+  GstElement *appsrc;           /* Gets everything received */
+  guint64 bytes, last_bytes, bitrate;
+} ZapStream;
+
+struct _GstPlayerZapper
+{
+  GstObject parent;
+
+  GstPlayer *player;
+
+  GThread *thread;
+  GMutex lock;
+  GCond cond;
+  GMainContext *context;
+  GMainLoop *loop;
+
+  GstElement *pipeline;
+  GSource *stats_source;
+
+  /* Protected by lock */
+  gchar **candidates;
+  GHashTable *failed;           /* URIs not to open again */
+  GList *streams;
+  ZapStream *current;           /* Handed over to the player */
+  gchar *uri;
+  GstElement *setup_appsrc;     /* Player source, not started yet */
+  guint max_streams, allowed_streams;
+  guint max_bytes;
+  guint64 max_bitrate;
+  guint hits, misses, overflows, dropped;
+};
+
+struct _GstPlayerZapperClass
+{
+  GstObjectClass parent_class;
+};
+
+#define parent_class gst_player_zapper_parent_class
+G_DEFINE_TYPE (GstPlayerZapper, gst_player_zapper, GST_TYPE_OBJECT);
+
+static GParamSpec *param_specs[PROP_LAST] = { NULL, };
+
+static void gst_player_zapper_dispose (GObject * object);
+static void gst_player_zapper_finalize (GObject * object);
+static void gst_player_zapper_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec);
+static void gst_player_zapper_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec);
+static void gst_player_zapper_constructed (GObject * object);
+
+static gpointer gst_player_zapper_main (gpointer data);
+static gboolean gst_player_zapper_update_streams (gpointer user_data);
+
+static void
+gst_player_zapper_init (GstPlayerZapper * self)
+{
+  g_mutex_init (&self->lock);
+  g_cond_init (&self->cond);
+
+  self->context = g_main_context_new ();
+  self->loop = g_main_loop_new (self->context, FALSE);
+
+  self->failed = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+  self->max_streams = DEFAULT_MAX_STREAMS;
+  self->allowed_streams = DEFAULT_MAX_STREAMS;
+  self->max_bytes = DEFAULT_MAX_BYTES;
+  self->max_bitrate = DEFAULT_MAX_BITRATE;
+}
+
+static void
+gst_player_zapper_class_init (GstPlayerZapperClass * klass)
+{
+  GObjectClass *gobject_class = (GObjectClass *) klass;
+
+  gobject_class->set_property = gst_player_zapper_set_property;
+  gobject_class->get_property = gst_player_zapper_get_property;
+  gobject_class->dispose = gst_player_zapper_dispose;
+  gobject_class->finalize = gst_player_zapper_finalize;
+  gobject_class->constructed = gst_player_zapper_constructed;
+
+  param_specs[PROP_PLAYER] =
+      g_param_spec_object ("player", "Player",
+      "Player that plays the selected stream", GST_TYPE_PLAYER,
+      G_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY | G_PARAM_STATIC_STRINGS);
+
+  param_specs[PROP_MAX_STREAMS] =
+      g_param_spec_uint ("max-streams", "Max streams",
+      "Number of candidate streams that are prefetched", 0, G_MAXUINT,
+      DEFAULT_MAX_STREAMS, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS);
+
+  param_specs[PROP_MAX_BYTES] =
+      g_param_spec_uint ("max-bytes", "Max bytes",
+      "Size of the cache of every prefetched stream", 0, G_MAXUINT,
+      DEFAULT_MAX_BYTES, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS);
+
+  param_specs[PROP_MAX_BITRATE] =
+      g_param_spec_uint64 ("max-bitrate", "Max bitrate",
+      "Bits per second all prefetched streams may use together, "
+      "0 for unlimited", 0, G_MAXUINT64, DEFAULT_MAX_BITRATE,
+      G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS);
+
+  g_object_class_install_properties (gobject_class, PROP_LAST, param_specs);
+}
+
+static void
+gst_player_zapper_dispose (GObject * object)
+{
+  GstPlayerZapper *self = GST_PLAYER_ZAPPER (object);
+
+  if (self->loop) {
+    g_main_loop_quit (self->loop);
+
+    g_thread_join (self->thread);
+    self->thread = NULL;
+
+    g_main_loop_unref (self->loop);
+    self->loop = NULL;
+
+    g_main_context_unref (self->context);
+    self->context = NULL;
+  }
+
+  if (self->player) {
+    GstElement *playbin = gst_player_get_pipeline (self->player);
+
+    g_signal_handlers_disconnect_by_data (playbin, self);
+    gst_object_unref (playbin);
+    gst_object_unref (self->player);
+    self->player = NULL;
+  }
+
+  G_OBJECT_CLASS (parent_class)->dispose (object);
+}
+
+static void
+stream_clear_cache (ZapStream * stream)
+{
+  g_queue_foreach (&stream->gop, (GFunc) gst_buffer_unref, NULL);
+  g_queue_clear (&stream->gop);
+  stream->gop_bytes = 0;
+  stream->have_keyframe = FALSE;
+}
+
+static void
+stream_free (ZapStream * stream)
+{
+  stream_clear_cache (stream);
+  gst_buffer_replace (&stream->header, NULL);
+  gst_buffer_replace (&stream->metadata, NULL);
+  gst_buffer_replace (&stream->video_config, NULL);
+  gst_buffer_replace (&stream->audio_config, NULL);
+  if (stream->pending_appsrc)
+    gst_object_unref (stream->pending_appsrc);
+  if (stream->appsrc)
+    gst_object_unref (stream->appsrc);
+  g_object_unref (stream->adapter);
+  gst_object_unref (stream->bin);
+  g_free (stream->uri);
+  g_free (stream);
+}
+
+static void
+gst_player_zapper_finalize (GObject * object)
+{
+  GstPlayerZapper *self = GST_PLAYER_ZAPPER (object);
+
+  g_list_free_full (self->streams, (GDestroyNotify) stream_free);
+  if (self->setup_appsrc)
+    gst_object_unref (self->setup_appsrc);
+  if (self->pipeline)
+    gst_object_unref (self->pipeline);
+  g_strfreev (self->candidates);
+  g_hash_table_unref (self->failed);
+  g_free (self->uri);
+  g_mutex_clear (&self->lock);
+  g_cond_clear (&self->cond);
+
+  G_OBJECT_CLASS (parent_class)->finalize (object);
+}
+
+static void
+appsrc_need_data_cb (GstAppSrc * appsrc, guint length, gpointer user_data)
+{
+  GstPlayerZapper *self = GST_PLAYER_ZAPPER (user_data);
+
+  /* Only now the source accepts data. The streaming thread of the stream
+   * pushes the cache, so nothing it receives meanwhile gets reordered */
+  g_mutex_lock (&self->lock);
+  if (self->setup_appsrc == GST_ELEMENT_CAST (appsrc) && self->current) {
+    GST_DEBUG_OBJECT (self, "Handing over '%s'", self->current->uri);
+    gst_object_replace ((GstObject **) & self->current->pending_appsrc,
+        GST_OBJECT_CAST (appsrc));
+    gst_object_replace ((GstObject **) & self->setup_appsrc, NULL);
+  }
+  g_mutex_unlock (&self->lock);
+}
+
+static void
+source_setup_cb (GstElement * playbin, GstElement * source,
+    gpointer user_data)
+{
+  GstPlayerZapper *self = GST_PLAYER_ZAPPER (user_data);
+  GstAppSrcCallbacks callbacks = { .need_data = appsrc_need_data_cb };
+  GstCaps *caps;
+  guint max_bytes;
+
+  if (!GST_IS_APP_SRC (source))
+    return;
+
+  g_mutex_lock (&self->lock);
+  if (!self->current) {
+    g_mutex_unlock (&self->lock);
+    return;
+  }
+  gst_object_replace ((GstObject **) & self->setup_appsrc,
+      GST_OBJECT_CAST (source));
+  max_bytes = self->max_bytes;
+  g_mutex_unlock (&self->lock);
+
+  /* The whole cache fits. Pushing never blocks, so the prefetching
+   * pipeline can always be shut down, data that doesn't fit is dropped */
+  caps = gst_caps_new_empty_simple ("video/x-flv");
+  g_object_set (source, "caps", caps, "is-live", FALSE, "block", FALSE,
+      "max-bytes", (guint64) MAX (2 * (guint64) max_bytes, 1024 * 1024),
+      NULL);
+  gst_caps_unref (caps);
+
+  gst_app_src_set_callbacks (GST_APP_SRC (source), &callbacks,
+      g_object_ref (self), g_object_unref);
+}
+
+static void
+gst_player_zapper_constructed (GObject * object)
+{
+  GstPlayerZapper *self = GST_PLAYER_ZAPPER (object);
+  GstElement *playbin;
+
+  if (gst_player_plugin_loader_is_lazy ()) {
+    gst_player_plugin_loader_ensure_feature ("appsrc");
+    gst_player_plugin_loader_ensure_feature ("appsink");
+  }
+
+  self->pipeline = gst_pipeline_new ("zapper");
+  gst_object_ref_sink (self->pipeline);
+
+  /* Prefetching sources are added while running */
+  gst_element_set_state (self->pipeline, GST_STATE_PLAYING);
+
+  if (self->player) {
+    playbin = gst_player_get_pipeline (self->player);
+    g_signal_connect (playbin, "source-setup", G_CALLBACK (source_setup_cb),
+        self);
+    gst_object_unref (playbin);
+  }
+
+  g_mutex_lock (&self->lock);
+  self->thread = g_thread_new ("GstPlayerZapper", gst_player_zapper_main, self);
+  while (!self->loop || !g_main_loop_is_running (self->loop))
+    g_cond_wait (&self->cond, &self->lock);
+  g_mutex_unlock (&self->lock);
+
+  G_OBJECT_CLASS (parent_class)->constructed (object);
+}
+
+/* Must be called with lock */
+static void
+stream_cache_tag_locked (GstPlayerZapper * self, ZapStream * stream,
+    GstBuffer * tag)
+{
+  GstMapInfo map;
+  guint8 type, info = 0, packet_type = 1;
+  gsize size = gst_buffer_get_size (tag);
+
+  gst_buffer_map (tag, &map, GST_MAP_READ);
+  type = map.data[0] & 0x1f;
+  if (map.size > FLV_TAG_HEADER_SIZE)
+    info = map.data[FLV_TAG_HEADER_SIZE];
+  if (map.size > FLV_TAG_HEADER_SIZE + 1)
+    packet_type = map.data[FLV_TAG_HEADER_SIZE + 1];
+  gst_buffer_unmap (tag, &map);
+
+  switch (type) {
+    case FLV_TAG_SCRIPT:
+      gst_buffer_replace (&stream->metadata, tag);
+      return;
+    case FLV_TAG_VIDEO:
+      if ((info & 0x0f) == FLV_CODEC_AVC && packet_type == 0) {
+        gst_buffer_replace (&stream->video_config, tag);
+        return;
+      }
+      if ((info >> 4) == 1) {
+        stream_clear_cache (stream);
+        stream->have_keyframe = TRUE;
+      }
+      break;
+    case FLV_TAG_AUDIO:
+      if ((info >> 4) == FLV_SOUND_FORMAT_AAC && packet_type == 0) {
+        gst_buffer_replace (&stream->audio_config, tag);
+        return;
+      }
+      break;
+    default:
+      return;
+  }
+
+  if (!stream->have_keyframe)
+    return;
+
+  if (stream->gop_bytes + size > self->max_bytes) {
+    GST_DEBUG_OBJECT (self, "GOP of '%s' exceeds %u bytes", stream->uri,
+        self->max_bytes);
+    stream_clear_cache (stream);
+    self->overflows++;
+    return;
+  }
+
+  g_queue_push_tail (&stream->gop, gst_buffer_ref (tag));
+  stream->gop_bytes += size;
+}
+
+/* Must be called with lock. Everything the player needs to start, in
+ * stream order */
+static GList *
+stream_get_cache_locked (ZapStream * stream)
+{
+  GList *buffers = NULL, *l;
+
+  if (stream->header)
+    buffers = g_list_append (buffers, gst_buffer_ref (stream->header));
+  if (stream->metadata)
+    buffers = g_list_append (buffers, gst_buffer_ref (stream->metadata));
+  if (stream->video_config)
+    buffers = g_list_append (buffers, gst_buffer_ref (stream->video_config));
+  if (stream->audio_config)
+    buffers = g_list_append (buffers, gst_buffer_ref (stream->audio_config));
+  for (l = stream->gop.head; l; l = l->next)
+    buffers = g_list_append (buffers, gst_buffer_ref (l->data));
+
+  return buffers;
+}
+
+static gboolean
+tag_is_keyframe (GstBuffer * tag)
+{
+  guint8 data[FLV_TAG_HEADER_SIZE + 1];
+
+  if (gst_buffer_extract (tag, 0, data, sizeof (data)) < sizeof (data))
+    return FALSE;
+
+  return (data[0] & 0x1f) == FLV_TAG_VIDEO
+      && (data[FLV_TAG_HEADER_SIZE] >> 4) == 1;
+}
+
+static GstFlowReturn
+stream_parse_header (GstPlayerZapper * self, ZapStream * stream)
+{
+  guint8 data[FLV_HEADER_SIZE];
+  guint32 offset;
+
+  if (gst_adapter_available (stream->adapter) < FLV_HEADER_SIZE)
+    return GST_FLOW_OK;
+
+  gst_adapter_copy (stream->adapter, data, 0, FLV_HEADER_SIZE);
+  if (memcmp (data, "FLV", 3) != 0) {
+    GST_DEBUG_OBJECT (self, "'%s' is not FLV, not prefetching", stream->uri);
+    /* Gives its place to the next candidate */
+    g_mutex_lock (&self->lock);
+    g_hash_table_add (self->failed, g_strdup (stream->uri));
+    g_mutex_unlock (&self->lock);
+    g_main_context_invoke_full (self->context, G_PRIORITY_DEFAULT,
+        gst_player_zapper_update_streams, self, NULL);
+    return GST_FLOW_EOS;
+  }
+
+  /* Followed by the size of the non-existing previous tag */
+  offset = GST_READ_UINT32_BE (data + 5);
+  if (gst_adapter_available (stream->adapter) < offset + 4)
+    return GST_FLOW_OK;
+
+  g_mutex_lock (&self->lock);
+  gst_buffer_replace (&stream->header, NULL);
+  stream->header = gst_adapter_take_buffer (stream->adapter, offset + 4);
+  g_mutex_unlock (&self->lock);
+  stream->header_parsed = TRUE;
+
+  return GST_FLOW_OK;
+}
+
+static GstBuffer *
+stream_take_tag (ZapStream * stream)
+{
+  guint8 data[FLV_TAG_HEADER_SIZE];
+  guint32 size;
+
+  if (gst_adapter_available (stream->adapter) < FLV_TAG_HEADER_SIZE)
+    return NULL;
+
+  gst_adapter_copy (stream->adapter, data, 0, FLV_TAG_HEADER_SIZE);
+  size = FLV_TAG_HEADER_SIZE + GST_READ_UINT24_BE (data + 1) + 4;
+  if (gst_adapter_available (stream->adapter) < size)
+    return NULL;
+
+  return gst_adapter_take_buffer (stream->adapter, size);
+}
+
+static void
+stream_push (GstPlayerZapper * self, ZapStream * stream, GstElement * appsrc,
+    GstBuffer * buffer)
+{
+  GstAppSrc *src = GST_APP_SRC (appsrc);
+  GstFlowReturn ret;
+
+  /* The player does not keep up, drop until the next keyframe instead of
+   * blocking this thread */
+  if (stream->dropping && !tag_is_keyframe (buffer)) {
+    gst_buffer_unref (buffer);
+    return;
+  }
+  if (gst_app_src_get_current_level_bytes (src) +
+      gst_buffer_get_size (buffer) > gst_app_src_get_max_bytes (src)) {
+    if (!stream->dropping)
+      GST_DEBUG_OBJECT (self, "Handover queue of '%s' is full, dropping",
+          stream->uri);
+    stream->dropping = TRUE;
+    g_mutex_lock (&self->lock);
+    self->dropped++;
+    g_mutex_unlock (&self->lock);
+    gst_buffer_unref (buffer);
+    return;
+  }
+  stream->dropping = FALSE;
+
+  ret = gst_app_src_push_buffer (src, buffer);
+  if (ret == GST_FLOW_OK)
+    return;
+
+  /* The player moved on */
+  GST_DEBUG_OBJECT (self, "Stopped handing over '%s': %s", stream->uri,
+      gst_flow_get_name (ret));
+  g_mutex_lock (&self->lock);
+  if (stream->appsrc == appsrc)
+    gst_object_replace ((GstObject **) & stream->appsrc, NULL);
+  g_mutex_unlock (&self->lock);
+}
+
+static GstFlowReturn
+stream_new_sample_cb (GstAppSink * appsink, gpointer user_data)
+{
+  ZapStream *stream = user_data;
+  GstPlayerZapper *self = stream->zapper;
+  GstSample *sample;
+  GstBuffer *buffer, *tag;
+  GstElement *appsrc;
+  GList *cache;
+  GstFlowReturn ret;
+
+  sample = gst_app_sink_pull_sample (appsink);
+  if (!sample)
+    return GST_FLOW_EOS;
+
+  buffer = gst_sample_get_buffer (sample);
+  g_mutex_lock (&self->lock);
+  stream->bytes += gst_buffer_get_size (buffer);
+  g_mutex_unlock (&self->lock);
+  gst_adapter_push (stream->adapter, gst_buffer_ref (buffer));
+  gst_sample_unref (sample);
+
+  if (!stream->header_parsed) {
+    ret = stream_parse_header (self, stream);
+    if (ret != GST_FLOW_OK || !stream->header_parsed)
+      return ret;
+  }
+
+  while ((tag = stream_take_tag (stream))) {
+    cache = NULL;
+    appsrc = NULL;
+
+    g_mutex_lock (&self->lock);
+    stream_cache_tag_locked (self, stream, tag);
+    if (stream->pending_appsrc) {
+      /* Includes this tag if it belongs to the current GOP */
+      cache = stream_get_cache_locked (stream);
+      gst_object_replace ((GstObject **) & stream->appsrc,
+          GST_OBJECT_CAST (stream->pending_appsrc));
+      gst_object_replace ((GstObject **) & stream->pending_appsrc, NULL);
+      appsrc = gst_object_ref (stream->appsrc);
+    } else if (stream->appsrc) {
+      appsrc = gst_object_ref (stream->appsrc);
+      cache = g_list_append (NULL, gst_buffer_ref (tag));
+    }
+    g_mutex_unlock (&self->lock);
+
+    while (cache) {
+      stream_push (self, stream, appsrc, cache->data);
+      cache = g_list_delete_link (cache, cache);
+    }
+    if (appsrc)
+      gst_object_unref (appsrc);
+    gst_buffer_unref (tag);
+  }
+
+  return GST_FLOW_OK;
+}
+
+static ZapStream *
+stream_new (GstPlayerZapper * self, const gchar * uri)
+{
+  GstAppSinkCallbacks callbacks = { .new_sample = stream_new_sample_cb };
+  GstElement *src, *sink;
+  ZapStream *stream;
+  GstPad *pad;
+  GError *err = NULL;
+
+  if (gst_player_plugin_loader_is_lazy ())
+    gst_player_plugin_loader_ensure_uri (uri);
+
+  src = gst_element_make_from_uri (GST_URI_SRC, uri, NULL, &err);
+  if (!src) {
+    GST_WARNING_OBJECT (self, "Can't prefetch '%s': %s", uri, err->message);
+    g_error_free (err);
+    return NULL;
+  }
+
+  sink = gst_element_factory_make ("appsink", NULL);
+  if (!sink) {
+    GST_WARNING_OBJECT (self, "Can't prefetch '%s': no appsink", uri);
+    gst_object_unref (src);
+    return NULL;
+  }
+
+  stream = g_new0 (ZapStream, 1);
+  stream->zapper = self;
+  stream->uri = g_strdup (uri);
+  stream->adapter = gst_adapter_new ();
+  g_queue_init (&stream->gop);
+
+  stream->bin = gst_bin_new (NULL);
+  gst_object_ref_sink (stream->bin);
+  g_object_set (sink, "sync", FALSE, "async", FALSE, "max-buffers", 1, NULL);
+  gst_app_sink_set_callbacks (GST_APP_SINK (sink), &callbacks, stream, NULL);
+  gst_bin_add_many (GST_BIN (stream->bin), src, sink, NULL);
+  pad = gst_element_get_static_pad (src, "src");
+  if (!pad || !gst_element_link (src, sink)) {
+    GST_WARNING_OBJECT (self, "Can't prefetch '%s': failed to link", uri);
+    if (pad)
+      gst_object_unref (pad);
+    stream_free (stream);
+    return NULL;
+  }
+  gst_object_unref (pad);
+
+  return stream;
+}
+
+/* Only called from the context */
+static void
+stream_release (GstPlayerZapper * self, ZapStream * stream)
+{
+  GST_DEBUG_OBJECT (self, "Closing '%s'", stream->uri);
+
+  gst_element_set_state (stream->bin, GST_STATE_NULL);
+  gst_bin_remove (GST_BIN (self->pipeline), stream->bin);
+  stream_free (stream);
+}
+
+/* Must be called with lock */
+static ZapStream *
+find_stream_locked (GstPlayerZapper * self, const gchar * uri)
+{
+  GList *l;
+
+  for (l = self->streams; l; l = l->next) {
+    if (strcmp (((ZapStream *) l->data)->uri, uri) == 0)
+      return l->data;
+  }
+
+  return NULL;
+}
+
+/* Must be called with lock. Candidates that should be prefetched now */
+static GPtrArray *
+get_wanted_locked (GstPlayerZapper * self)
+{
+  GPtrArray *wanted = g_ptr_array_new ();
+  guint i, n_wanted;
+
+  n_wanted = MIN (self->max_streams, self->allowed_streams);
+  for (i = 0; self->candidates && self->candidates[i]
+      && wanted->len < n_wanted; i++) {
+    if (g_hash_table_contains (self->failed, self->candidates[i]))
+      continue;
+    if (self->uri && strcmp (self->candidates[i], self->uri) == 0)
+      continue;
+    g_ptr_array_add (wanted, self->candidates[i]);
+  }
+
+  return wanted;
+}
+
+static gboolean
+gst_player_zapper_update_streams (gpointer user_data)
+{
+  GstPlayerZapper *self = GST_PLAYER_ZAPPER (user_data);
+  GList *remove = NULL, *l;
+  GPtrArray *wanted, *add;
+  ZapStream *stream;
+  gboolean keep;
+  guint i;
+
+  g_mutex_lock (&self->lock);
+  wanted = get_wanted_locked (self);
+  add = g_ptr_array_new_with_free_func (g_free);
+
+  for (l = self->streams; l;) {
+    GList *next = l->next;
+
+    stream = l->data;
+    keep = (stream == self->current);
+    for (i = 0; !keep && i < wanted->len; i++)
+      keep = (strcmp (stream->uri, g_ptr_array_index (wanted, i)) == 0);
+    if (!keep) {
+      self->streams = g_list_delete_link (self->streams, l);
+      remove = g_list_prepend (remove, stream);
+    }
+    l = next;
+  }
+
+  for (i = 0; i < wanted->len; i++) {
+    if (!find_stream_locked (self, g_ptr_array_index (wanted, i)))
+      g_ptr_array_add (add, g_strdup (g_ptr_array_index (wanted, i)));
+  }
+  g_ptr_array_unref (wanted);
+  g_mutex_unlock (&self->lock);
+
+  for (l = remove; l; l = l->next)
+    stream_release (self, l->data);
+  g_list_free (remove);
+
+  for (i = 0; i < add->len; i++) {
+    const gchar *uri = g_ptr_array_index (add, i);
+
+    stream = stream_new (self, uri);
+    g_mutex_lock (&self->lock);
+    if (!stream) {
+      g_hash_table_add (self->failed, g_strdup (uri));
+      g_mutex_unlock (&self->lock);
+      continue;
+    }
+    self->streams = g_list_append (self->streams, stream);
+    g_mutex_unlock (&self->lock);
+
+    GST_DEBUG_OBJECT (self, "Prefetching '%s'", uri);
+    gst_bin_add (GST_BIN (self->pipeline), stream->bin);
+    gst_element_sync_state_with_parent (stream->bin);
+  }
+  g_ptr_array_unref (add);
+
+  return G_SOURCE_REMOVE;
+}
+
+static gboolean
+stats_cb (gpointer user_data)
+{
+  GstPlayerZapper *self = GST_PLAYER_ZAPPER (user_data);
+  guint64 total = 0;
+  guint n_streams = 0;
+  gboolean update = FALSE;
+  GList *l;
+
+  g_mutex_lock (&self->lock);
+  for (l = self->streams; l; l = l->next) {
+    ZapStream *stream = l->data;
+
+    stream->bitrate = (stream->bytes - stream->last_bytes) * 8 * 1000 /
+        STATS_INTERVAL_MS;
+    stream->last_bytes = stream->bytes;
+  }
+
+  if (self->max_bitrate == 0) {
+    g_mutex_unlock (&self->lock);
+    return G_SOURCE_CONTINUE;
+  }
+
+  /* The played stream is needed anyway, the others are in the order of
+   * the candidates and the least likely ones give way */
+  for (l = self->streams; l; l = l->next) {
+    ZapStream *stream = l->data;
+
+    if (stream == self->current)
+      continue;
+    if (total + stream->bitrate > self->max_bitrate)
+      break;
+    total += stream->bitrate;
+    n_streams++;
+  }
+
+  if (l && n_streams < self->allowed_streams) {
+    GST_DEBUG_OBJECT (self, "Over the bitrate budget, limiting to %u streams",
+        n_streams);
+    self->allowed_streams = n_streams;
+    update = TRUE;
+  }
+  g_mutex_unlock (&self->lock);
+
+  if (update)
+    gst_player_zapper_update_streams (self);
+
+  return G_SOURCE_CONTINUE;
+}
+
+static void
+error_cb (GstBus * bus, GstMessage * msg, gpointer user_data)
+{
+  GstPlayerZapper *self = GST_PLAYER_ZAPPER (user_data);
+  ZapStream *stream = NULL;
+  GError *err;
+  GList *l;
+
+  gst_message_parse_error (msg, &err, NULL);
+
+  g_mutex_lock (&self->lock);
+  for (l = self->streams; l; l = l->next) {
+    if (gst_object_has_ancestor (GST_MESSAGE_SRC (msg),
+            GST_OBJECT (((ZapStream *) l->data)->bin))) {
+      stream = l->data;
+      break;
+    }
+  }
+  /* The player reports errors of the stream it plays itself */
+  if (stream && stream != self->current) {
+    self->streams = g_list_delete_link (self->streams, l);
+    g_hash_table_add (self->failed, g_strdup (stream->uri));
+  } else {
+    stream = NULL;
+  }
+  g_mutex_unlock (&self->lock);
+
+  if (stream) {
+    GST_WARNING_OBJECT (self, "Prefetching '%s' failed: %s", stream->uri,
+        err->message);
+    stream_release (self, stream);
+  }
+
+  g_error_free (err);
+}
+
+static gboolean
+main_loop_running_cb (gpointer user_data)
+{
+  GstPlayerZapper *self = GST_PLAYER_ZAPPER (user_data);
+
+  g_mutex_lock (&self->lock);
+  g_cond_signal (&self->cond);
+  g_mutex_unlock (&self->lock);
+
+  return G_SOURCE_REMOVE;
+}
+
+static gpointer
+gst_player_zapper_main (gpointer data)
+{
+  GstPlayerZapper *self = GST_PLAYER_ZAPPER (data);
+  GstBus *bus;
+  GSource *source;
+  GSource *bus_source;
+  GList *streams;
+
+  g_main_context_push_thread_default (self->context);
+
+  source = g_idle_source_new ();
+  g_source_set_callback (source, (GSourceFunc) main_loop_running_cb, self,
+      NULL);
+  g_source_attach (source, self->context);
+  g_source_unref (source);
+
+  bus = gst_element_get_bus (self->pipeline);
+  bus_source = gst_bus_create_watch (bus);
+  g_source_set_callback (bus_source, (GSourceFunc) gst_bus_async_signal_func,
+      NULL, NULL);
+  g_source_attach (bus_source, self->context);
+
+  g_signal_connect (G_OBJECT (bus), "message::error", G_CALLBACK (error_cb),
+      self);
+
+  self->stats_source = g_timeout_source_new (STATS_INTERVAL_MS);
+  g_source_set_callback (self->stats_source, stats_cb, self, NULL);
+  g_source_attach (self->stats_source, self->context);
+
+  g_main_loop_run (self->loop);
+
+  g_source_destroy (self->stats_source);
+  g_source_unref (self->stats_source);
+  self->stats_source = NULL;
+
+  g_signal_handlers_disconnect_by_data (bus, self);
+  g_source_destroy (bus_source);
+  g_source_unref (bus_source);
+  gst_object_unref (bus);
+
+  g_main_context_pop_thread_default (self->context);
+
+  g_mutex_lock (&self->lock);
+  streams = self->streams;
+  self->streams = NULL;
+  self->current = NULL;
+  g_mutex_unlock (&self->lock);
+
+  gst_element_set_state (self->pipeline, GST_STATE_NULL);
+  g_list_free_full (streams, (GDestroyNotify) stream_free);
+
+  return NULL;
+}
+
+static void
+gst_player_zapper_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec)
+{
+  GstPlayerZapper *self = GST_PLAYER_ZAPPER (object);
+
+  switch (prop_id) {
+    case PROP_PLAYER:
+      self->player = g_value_dup_object (value);
+      break;
+    case PROP_MAX_STREAMS:
+      g_mutex_lock (&self->lock);
+      self->max_streams = g_value_get_uint (value);
+      self->allowed_streams = self->max_streams;
+      GST_DEBUG_OBJECT (self, "Set max streams=%u", self->max_streams);
+      g_mutex_unlock (&self->lock);
+
+      if (self->context)
+        g_main_context_invoke_full (self->context, G_PRIORITY_DEFAULT,
+            gst_player_zapper_update_streams, self, NULL);
+      break;
+    case PROP_MAX_BYTES:
+      g_mutex_lock (&self->lock);
+      self->max_bytes = g_value_get_uint (value);
+      g_mutex_unlock (&self->lock);
+      break;
+    case PROP_MAX_BITRATE:
+      g_mutex_lock (&self->lock);
+      self->max_bitrate = g_value_get_uint64 (value);
+      self->allowed_streams = self->max_streams;
+      g_mutex_unlock (&self->lock);
+
+      if (self->context)
+        g_main_context_invoke_full (self->context, G_PRIORITY_DEFAULT,
+            gst_player_zapper_update_streams, self, NULL);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+static void
+gst_player_zapper_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec)
+{
+  GstPlayerZapper *self = GST_PLAYER_ZAPPER (object);
+
+  switch (prop_id) {
+    case PROP_PLAYER:
+      g_value_set_object (value, self->player);
+      break;
+    case PROP_MAX_STREAMS:
+      g_mutex_lock (&self->lock);
+      g_value_set_uint (value, self->max_streams);
+      g_mutex_unlock (&self->lock);
+      break;
+    case PROP_MAX_BYTES:
+      g_mutex_lock (&self->lock);
+      g_value_set_uint (value, self->max_bytes);
+      g_mutex_unlock (&self->lock);
+      break;
+    case PROP_MAX_BITRATE:
+      g_mutex_lock (&self->lock);
+      g_value_set_uint64 (value, self->max_bitrate);
+      g_mutex_unlock (&self->lock);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+static gpointer
+gst_player_zapper_init_once (gpointer user_data)
+{
+  gst_init (NULL, NULL);
+
+  GST_DEBUG_CATEGORY_INIT (gst_player_zapper_debug, "gst-player-zapper", 0,
+      "GstPlayer Zapper");
+
+  return NULL;
+}
+
+/**
+ * gst_player_zapper_new:
+ * @player: #GstPlayer to play the selected stream with
+ *
+ * Returns: a new #GstPlayerZapper instance
+ */
+GstPlayerZapper *
+gst_player_zapper_new (GstPlayer * player)
+{
+  static GOnce once = G_ONCE_INIT;
+
+  g_return_val_if_fail (GST_IS_PLAYER (player), NULL);
+
+  g_once (&once, gst_player_zapper_init_once, NULL);
+
+  return g_object_new (GST_TYPE_PLAYER_ZAPPER, "player", player, NULL);
+}
+
+/**
+ * gst_player_zapper_set_candidates:
+ * @zapper: #GstPlayerZapper instance
+ * @uris: (array zero-terminated=1) (allow-none): URIs of the streams the
+ * user might switch to, most likely first
+ *
+ * Sets the streams to prefetch. Only the first ones up to
+ * #GstPlayerZapper:max-streams are opened, the others are closed.
+ */
+void
+gst_player_zapper_set_candidates (GstPlayerZapper * self,
+    const gchar * const *uris)
+{
+  g_return_if_fail (GST_IS_PLAYER_ZAPPER (self));
+
+  g_mutex_lock (&self->lock);
+  g_strfreev (self->candidates);
+  self->candidates = g_strdupv ((gchar **) uris);
+  /* Give failed streams and the bitrate budget another chance */
+  g_hash_table_remove_all (self->failed);
+  self->allowed_streams = self->max_streams;
+  g_mutex_unlock (&self->lock);
+
+  g_main_context_invoke_full (self->context, G_PRIORITY_DEFAULT,
+      gst_player_zapper_update_streams, self, NULL);
+}
+
+/**
+ * gst_player_zapper_switch:
+ * @zapper: #GstPlayerZapper instance
+ * @uri: URI of the stream to play
+ *
+ * Plays @uri with the player. If it is prefetched and a keyframe was
+ * received already, the player starts with the cached data and continues
+ * on the connection that is already open. Otherwise the player opens
+ * @uri itself.
+ */
+void
+gst_player_zapper_switch (GstPlayerZapper * self, const gchar * uri)
+{
+  ZapStream *stream;
+
+  g_return_if_fail (GST_IS_PLAYER_ZAPPER (self));
+  g_return_if_fail (uri != NULL);
+
+  g_mutex_lock (&self->lock);
+  if (self->current) {
+    /* Keeps caching, switching back is fast as well */
+    gst_object_replace ((GstObject **) & self->current->pending_appsrc, NULL);
+    gst_object_replace ((GstObject **) & self->current->appsrc, NULL);
+  }
+  gst_object_replace ((GstObject **) & self->setup_appsrc, NULL);
+
+  g_free (self->uri);
+  self->uri = g_strdup (uri);
+
+  stream = find_stream_locked (self, uri);
+  if (stream && (!stream->header || !stream->have_keyframe))
+    stream = NULL;
+  self->current = stream;
+  if (stream)
+    self->hits++;
+  else
+    self->misses++;
+  g_mutex_unlock (&self->lock);
+
+  GST_DEBUG_OBJECT (self, "Switching to '%s', %s", uri,
+      stream ? "prefetched" : "not prefetched");
+
+  gst_player_set_uri (self->player, stream ? HANDOVER_URI : uri);
+  gst_player_play (self->player);
+
+  g_main_context_invoke_full (self->context, G_PRIORITY_DEFAULT,
+      gst_player_zapper_update_streams, self, NULL);
+}
+
+/**
+ * gst_player_zapper_get_uri:
+ * @zapper: #GstPlayerZapper instance
+ *
+ * Gets the URI of the stream switched to last. The URI of the player is
+ * not meaningful for prefetched streams.
+ *
+ * Returns: (transfer full): a string containing the URI, or %NULL
+ */
+gchar *
+gst_player_zapper_get_uri (GstPlayerZapper * self)
+{
+  gchar *uri;
+
+  g_return_val_if_fail (GST_IS_PLAYER_ZAPPER (self), NULL);
+
+  g_mutex_lock (&self->lock);
+  uri = g_strdup (self->uri);
+  g_mutex_unlock (&self->lock);
+
+  return uri;
+}
+
+/**
+ * gst_player_zapper_set_max_streams:
+ * @zapper: #GstPlayerZapper instance
+ * @n_streams: number of streams
+ *
+ * Sets how many of the candidates are prefetched. Every one of them is a
+ * network connection.
+ */
+void
+gst_player_zapper_set_max_streams (GstPlayerZapper * self, guint n_streams)
+{
+  g_return_if_fail (GST_IS_PLAYER_ZAPPER (self));
+
+  g_object_set (self, "max-streams", n_streams, NULL);
+}
+
+/**
+ * gst_player_zapper_get_max_streams:
+ * @zapper: #GstPlayerZapper instance
+ *
+ * Returns: how many of the candidates are prefetched
+ */
+guint
+gst_player_zapper_get_max_streams (GstPlayerZapper * self)
+{
+  guint val;
+
+  g_return_val_if_fail (GST_IS_PLAYER_ZAPPER (self), DEFAULT_MAX_STREAMS);
+
+  g_object_get (self, "max-streams", &val, NULL);
+
+  return val;
+}
+
+/**
+ * gst_player_zapper_set_max_bytes:
+ * @zapper: #GstPlayerZapper instance
+ * @bytes: size of the cache
+ *
+ * Sets the size of the cache of every prefetched stream. A group of
+ * pictures that doesn't fit is not cached.
+ */
+void
+gst_player_zapper_set_max_bytes (GstPlayerZapper * self, guint bytes)
+{
+  g_return_if_fail (GST_IS_PLAYER_ZAPPER (self));
+
+  g_object_set (self, "max-bytes", bytes, NULL);
+}
+
+/**
+ * gst_player_zapper_get_max_bytes:
+ * @zapper: #GstPlayerZapper instance
+ *
+ * Returns: the size of the cache of every prefetched stream
+ */
+guint
+gst_player_zapper_get_max_bytes (GstPlayerZapper * self)
+{
+  guint val;
+
+  g_return_val_if_fail (GST_IS_PLAYER_ZAPPER (self), DEFAULT_MAX_BYTES);
+
+  g_object_get (self, "max-bytes", &val, NULL);
+
+  return val;
+}
+
+/**
+ * gst_player_zapper_set_max_bitrate:
+ * @zapper: #GstPlayerZapper instance
+ * @bitrate: bits per second, 0 for unlimited
+ *
+ * Sets the bandwidth all prefetched streams may use together. If they use
+ * more, the least likely candidates are closed until
+ * gst_player_zapper_set_candidates() is called again.
+ */
+void
+gst_player_zapper_set_max_bitrate (GstPlayerZapper * self, guint64 bitrate)
+{
+  g_return_if_fail (GST_IS_PLAYER_ZAPPER (self));
+
+  g_object_set (self, "max-bitrate", bitrate, NULL);
+}
+
+/**
+ * gst_player_zapper_get_max_bitrate:
+ * @zapper: #GstPlayerZapper instance
+ *
+ * Returns: the bandwidth all prefetched streams may use together
+ */
+guint64
+gst_player_zapper_get_max_bitrate (GstPlayerZapper * self)
+{
+  guint64 val;
+
+  g_return_val_if_fail (GST_IS_PLAYER_ZAPPER (self), DEFAULT_MAX_BITRATE);
+
+  g_object_get (self, "max-bitrate", &val, NULL);
+
+  return val;
+}
+
+/**
+ * gst_player_zapper_get_stats:
+ * @zapper: #GstPlayerZapper instance
+ *
+ * Gets statistics about prefetching, with these fields:
+ *
+ * "open-streams" (guint), "cached-streams" (guint): number of prefetched
+ * streams, and of those with a complete group of pictures cached.
+ *
+ * "cached-bytes" (guint64), "prefetch-bitrate" (guint64): memory used by
+ * all caches, and the bits per second all prefetched streams received
+ * over the last second, without the one that is played.
+ *
+ * "hits" (guint), "misses" (guint): switches that could use a cache and
+ * those that couldn't.
+ *
+ * "overflows" (guint): groups of pictures that were not cached because
+ * they didn't fit.
+ *
+ * "dropped" (guint): tags of the played stream that were dropped because
+ * the player did not take them fast enough. Playback resumes with the
+ * next keyframe.
+ *
+ * Returns: (transfer full): a #GstStructure, free with gst_structure_free()
+ */
+GstStructure *
+gst_player_zapper_get_stats (GstPlayerZapper * self)
+{
+  guint64 bytes = 0, bitrate = 0;
+  guint n_cached = 0;
+  GstStructure *stats;
+  GList *l;
+
+  g_return_val_if_fail (GST_IS_PLAYER_ZAPPER (self), NULL);
+
+  g_mutex_lock (&self->lock);
+  for (l = self->streams; l; l = l->next) {
+    ZapStream *stream = l->data;
+
+    bytes += stream->gop_bytes;
+    if (stream->have_keyframe)
+      n_cached++;
+    if (stream != self->current)
+      bitrate += stream->bitrate;
+  }
+
+  stats = gst_structure_new ("application/x-gst-player-zapper-stats",
+      "open-streams", G_TYPE_UINT, g_list_length (self->streams),
+      "cached-streams", G_TYPE_UINT, n_cached,
+      "cached-bytes", G_TYPE_UINT64, bytes,
+      "prefetch-bitrate", G_TYPE_UINT64, bitrate,
+      "hits", G_TYPE_UINT, self->hits,
+      "misses", G_TYPE_UINT, self->misses,
+      "overflows", G_TYPE_UINT, self->overflows,
+      "dropped", G_TYPE_UINT, self->dropped, NULL);
+  g_mutex_unlock (&self->lock);
+
+  return stats;
+}
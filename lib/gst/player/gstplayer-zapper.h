@@ -0,0 +1,66 @@
+/* GStreamer
+ *
+ * Copyright (C) 2015 Kim DaeHyun <jabiers87@gmail.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __GST_PLAYER_ZAPPER_H__
+#define __GST_PLAYER_ZAPPER_H__
+
+#include <gst/gst.h>
+#include <gst/player/gstplayer.h>
+
+G_BEGIN_DECLS
+
+typedef struct _GstPlayerZapper GstPlayerZapper;
+typedef struct _GstPlayerZapperClass GstPlayerZapperClass;
+
+#define GST_TYPE_PLAYER_ZAPPER             (gst_player_zapper_get_type ())
+#define GST_IS_PLAYER_ZAPPER(obj)          (G_TYPE_CHECK_INSTANCE_TYPE ((obj), GST_TYPE_PLAYER_ZAPPER))
+#define GST_IS_PLAYER_ZAPPER_CLASS(klass)  (G_TYPE_CHECK_CLASS_TYPE ((klass), GST_TYPE_PLAYER_ZAPPER))
+#define GST_PLAYER_ZAPPER_GET_CLASS(obj)   (G_TYPE_INSTANCE_GET_CLASS ((obj), GST_TYPE_PLAYER_ZAPPER, GstPlayerZapperClass))
+#define GST_PLAYER_ZAPPER(obj)             (G_TYPE_CHECK_INSTANCE_CAST ((obj), GST_TYPE_PLAYER_ZAPPER, GstPlayerZapper))
+#define GST_PLAYER_ZAPPER_CLASS(klass)     (G_TYPE_CHECK_CLASS_CAST ((klass), GST_TYPE_PLAYER_ZAPPER, GstPlayerZapperClass))
+#define GST_PLAYER_ZAPPER_CAST(obj)        ((GstPlayerZapper*)(obj))
+
+GType        gst_player_zapper_get_type                (void);
+
+GstPlayerZapper * gst_player_zapper_new                (GstPlayer * player);
+
+void         gst_player_zapper_set_candidates          (GstPlayerZapper * zapper,
+                                                        const gchar * const * uris);
+void         gst_player_zapper_switch                  (GstPlayerZapper * zapper,
+                                                        const gchar * uri);
+gchar *      gst_player_zapper_get_uri                 (GstPlayerZapper * zapper);
+
+void         gst_player_zapper_set_max_streams         (GstPlayerZapper * zapper,
+                                                        guint n_streams);
+guint        gst_player_zapper_get_max_streams         (GstPlayerZapper * zapper);
+
+void         gst_player_zapper_set_max_bytes           (GstPlayerZapper * zapper,
+                                                        guint bytes);
+guint        gst_player_zapper_get_max_bytes           (GstPlayerZapper * zapper);
+
+void         gst_player_zapper_set_max_bitrate         (GstPlayerZapper * zapper,
+                                                        guint64 bitrate);
+guint64      gst_player_zapper_get_max_bitrate         (GstPlayerZapper * zapper);
+
+GstStructure * gst_player_zapper_get_stats             (GstPlayerZapper * zapper);
+
+G_END_DECLS
+
+#endif /* __GST_PLAYER_ZAPPER_H__ */
@@ -28,18 +28,27 @@
 /* TODO:
  *
  * - Equalizer
- * - Gapless playback
  * - Frame stepping
  * - Subtitle font, connection speed
  * - Deinterlacing
  * - Buffering control (-> progressive downloading)
- * - Playlist/queue object
  * - Custom video sink (e.g. embed in GL scene)
  *
  */
 
 #include "gstplayer.h"
 #include "gstplayer-media-info-private.h"
+#include "gstplayer-plugin-loader.h"
+#include "gstplayer-decoder-probe.h"
+#include "gstplayer-frame-diff-private.h"
+#include "gstplayer-playlist-private.h"
+#include "gstplayer-restream-private.h"
+#include "gstplayer-keyframe-index-private.h"
+#include "gstplayer-scrub-private.h"
+#include "gstplayer-audio-meter-private.h"
+#include "gstplayer-subtitle-overlay-private.h"
+#include "gstplayer-element-stats-private.h"
+#include "gstplayer-flight-recorder-private.h"
 
 #include <gst/gst.h>
 #include <gst/video/video.h>
@@ -59,6 +68,42 @@ GST_DEBUG_CATEGORY_STATIC (gst_player_debug);
 #define DEFAULT_MUTE FALSE
 #define DEFAULT_RATE 1.0
 #define DEFAULT_POSITION_UPDATE_INTERVAL_MS 100
+#define DEFAULT_TAG_UPDATE_INTERVAL_MS 1000
+#define DEFAULT_DEGRADATION_ENABLED FALSE
+#define DEFAULT_SKIP_STATIC_FRAMES FALSE
+#define DEFAULT_RESTREAM_PORT 0
+#define DEFAULT_RESTREAM_PATH "/live"
+#define DEFAULT_OFFLINE FALSE
+#define DEFAULT_DECODE_SELECTED_ONLY FALSE
+#define DEFAULT_ELEMENT_STATS_ENABLED FALSE
+
+/* Non-flushing rate changes are retried with a flushing seek if nothing
+ * reached the sinks for that long, i.e. if the new segment is not just
+ * queued behind buffered data */
+#define RATE_CHANGE_TIMEOUT_MS 3000
+
+/* Limits of the buffering queues after gst_player_trim_memory() */
+#define TRIM_QUEUE_BYTES_LOW (2 * 1024 * 1024)
+#define TRIM_QUEUE_BYTES (512 * 1024)
+
+/* Looking up signal handlers takes the global signal lock, for the frequent
+ * events it is only done this often */
+#define HANDLER_CACHE_INTERVAL_US G_USEC_PER_SEC
+
+/* Video is considered overloaded if the sink reports that upstream is this
+ * much slower than realtime, or that buffers arrive this late */
+#define QOS_OVERLOAD_PROPORTION 1.2
+#define QOS_OVERLOAD_JITTER (40 * GST_MSECOND)
+/* Number of consecutive overloaded QoS messages before degrading, and the
+ * minimum time to stay on a level before degrading further */
+#define QOS_OVERLOAD_COUNT 3
+#define QOS_DEGRADE_INTERVAL GST_SECOND
+/* Time without overload before going back up one level */
+#define QOS_RECOVER_INTERVAL (5 * GST_SECOND)
+
+/* Everything played over RTMP is FLV, and in practice H.264/AAC */
+static GstStaticCaps rtmp_format_hint =
+GST_STATIC_CAPS ("video/x-flv; video/x-h264; audio/mpeg, mpegversion = (int) 4");
 
 GQuark
 gst_player_error_quark (void)
@@ -89,6 +134,17 @@ enum
   PROP_RATE,
   PROP_PIPELINE,
   PROP_POSITION_UPDATE_INTERVAL,
+  PROP_TAG_UPDATE_INTERVAL,
+  PROP_FORMAT_HINT,
+  PROP_DEGRADATION_ENABLED,
+  PROP_SKIP_STATIC_FRAMES,
+  PROP_PLAYLIST,
+  PROP_RESTREAM_PORT,
+  PROP_RESTREAM_PATH,
+  PROP_OFFLINE,
+  PROP_THROUGHPUT,
+  PROP_DECODE_SELECTED_ONLY,
+  PROP_ELEMENT_STATS_ENABLED,
   PROP_LAST
 };
 
@@ -106,6 +162,9 @@ enum
   SIGNAL_VOLUME_CHANGED,
   SIGNAL_MUTE_CHANGED,
   SIGNAL_SEEK_DONE,
+  SIGNAL_DEGRADATION_LEVEL_CHANGED,
+  SIGNAL_PLAYLIST_ITEM_CHANGED,
+  SIGNAL_AUDIO_LEVEL,
   SIGNAL_LAST
 };
 
@@ -117,6 +176,61 @@ enum
   GST_PLAY_FLAG_VIS = (1 << 3)
 };
 
+/* Measurement of the gap between two playlist items at one sink. After a
+ * gapless switch the first buffer after the new stream started is compared
+ * with the end of the last buffer before, both in running time */
+typedef struct
+{
+  GstPlayer *player;
+  GstSegment segment;
+  GstClockTime last_end;
+  guint serial;                 /* Transition last seen */
+  gboolean waiting;             /* For the first buffer of the new stream */
+} TransitionStream;
+
+/* Reference counted, so that dispatches that are still pending keep the
+ * callbacks and their user data alive when they are replaced */
+typedef struct
+{
+  gint ref_count;
+  GstPlayerCallbacks callbacks;
+  gpointer user_data;
+  GDestroyNotify notify;
+} PlayerCallbacks;
+
+/* Reference counted like PlayerCallbacks, frames that are already
+ * dispatched keep it alive after gst_player_scrub_end() */
+typedef struct
+{
+  gint ref_count;
+  GstPlayerScrubFunc func;
+  gpointer user_data;
+  GDestroyNotify notify;
+} ScrubCallback;
+
+/* Reference counted, cues may be rasterized from a streaming thread while
+ * the rasterizer is replaced */
+typedef struct
+{
+  gint ref_count;
+  GstPlayerSubtitleRasterizeFunc func;
+  gpointer user_data;
+  GDestroyNotify notify;
+} SubtitleRasterizer;
+
+/* An audio or video decoder, shared by its probe and the player */
+typedef struct
+{
+  gint ref_count;
+  GstPlayer *player;
+  GstElement *decoder;
+  GstPad *srcpad;
+  gboolean video;
+  gint selected;                /* Atomic */
+  GstClockTime selected_time;   /* Protected by the player's lock */
+  gboolean dropping;            /* Only used from the streaming thread */
+} TrackDecoder;
+
 struct _GstPlayer
 {
   GstObject parent;
@@ -148,13 +262,164 @@ struct _GstPlayer
   GstTagList *global_tags;
   GstPlayerMediaInfo *media_info;
 
+  /* Global tag updates, protected by lock. Unchanged tag lists are ignored
+   * and further updates within the interval after one was applied are
+   * merged into the last one */
+  guint tag_update_interval_ms;
+  GSource *tag_update_source;
+  GstTagList *pending_tags;
+  guint n_tags_suppressed;
+
   GstElement *current_vis_element;
 
   /* Protected by lock */
   gboolean seek_pending;        /* Only set from main context */
   GstClockTime last_seek_time;  /* Only set from main context */
+  GstClockTime seek_latency;    /* Only set from main context */
+
+  /* Rate changes, protected by lock */
+  gboolean rate_change_pending; /* Only the rate changed, not the position */
+  gdouble applied_rate;         /* Rate of the last seek */
+  gdouble rate_change_target;
+  GstClockTime rate_change_start;
+  GstClockTime rate_change_progress;    /* Last buffer at the sinks */
+  gboolean rate_change_flushing, rate_segment_seen;
+  GstClockTime rate_change_time;
+  GSource *rate_fallback_source;
   GSource *seek_source;
   GstClockTime seek_position;
+
+  /* A-B loop, protected by lock */
+  GstClockTime loop_start, loop_stop;   /* loop_stop is NONE if disabled */
+  guint n_loops;
+
+  /* Memory trimming, protected by lock */
+  gint pending_trim_level;      /* -1 if none */
+  guint64 memory_released, memory_released_last;
+  /* Only set from main context, atomic. The times are valid while set and
+   * protected by trim_lock, which is never held while calling out so that
+   * the position and duration getters can be called with and without lock */
+  gint pipeline_trimmed;        /* Decoders shut down while paused */
+  GMutex trim_lock;
+  GstClockTime trimmed_position, trimmed_duration;
+
+  /* Protected by lock */
+  GstCaps *format_hint;         /* Set by the application */
+  GstCaps *active_format_hint;  /* Used for the current URI */
+  GList *hint_factories;        /* Decodable factories for active_format_hint */
+  gboolean format_hint_confirmed;
+  gboolean format_hint_missed;  /* Counted once per URI */
+  guint format_hint_hits, format_hint_misses;
+  GstClockTime autoplug_start, autoplug_time;
+  GstClockTime autoplug_time_unhinted;  /* Average over unhinted opens */
+  guint n_autoplug_unhinted;
+
+  /* Decoder policy, protected by lock */
+  GHashTable *decoder_ranks;    /* factory name -> rank */
+  gchar **decoder_allowlist, **decoder_denylist;
+  GHashTable *decoder_threads;  /* media type, "" for all -> thread count */
+
+  /* QoS degradation, protected by lock */
+  gboolean degradation_enabled;
+  GstPlayerDegradationLevel degradation_level;
+  GstClockTime degradation_since;
+  GstClockTime degradation_time[GST_PLAYER_DEGRADATION_KEYFRAMES_ONLY + 1];
+  GstElement *video_decoder;
+  /* Only used from main context */
+  guint n_overloaded;
+  GstClockTime last_overload;
+  GSource *recover_source;
+  /* Used from streaming threads */
+  gint drop_delta_units, wait_keyframe;
+
+  /* Static frame skipping */
+  gboolean skip_static_frames;  /* Protected by lock */
+  guint64 frames_checked, frames_skipped;       /* Protected by lock */
+  GstClockTime frame_diff_time; /* Protected by lock */
+  GstPlayerFrameDiff *frame_diff;       /* Only used from video streaming thread */
+  GstVideoInfo frame_diff_info; /* Only used from video streaming thread */
+  gboolean frame_diff_supported;        /* Only used from video streaming thread */
+  GArray *dirty_rects;          /* Only used from video streaming thread */
+  gint pass_next_frame;         /* atomic, so that the sink can preroll */
+  gint subtitles_shown;         /* atomic, cached from playbin */
+
+  /* Playlist, protected by lock */
+  GstPlayerPlaylist *playlist;
+  gchar *pending_uri;           /* Set on playbin for the next group */
+  /* Transition gap measurement, protected by lock */
+  guint gap_serial;             /* Incremented for each switch and stop */
+  gboolean gap_transition;      /* If the last increment was a switch */
+  guint gap_measured_serial;
+  GstClockTime transition_gap;
+  guint n_transitions;
+
+  /* RTSP restreaming, protected by lock */
+  guint restream_port;
+  gchar *restream_path;
+  GstPlayerRestream *restream;  /* Only created and freed from main context */
+
+  /* FLV keyframe index of the current URI, protected by lock */
+  GstPlayerKeyframeIndex *keyframe_index;
+
+  /* Typed callbacks, protected by lock */
+  PlayerCallbacks *callbacks;
+  gint callbacks_mask;          /* Atomic, bit per callback that is set */
+
+  /* Signals known to have handlers, only used from main context */
+  guint handler_cache, handler_cache_valid;
+  gint64 handler_cache_time;
+
+  /* As-fast-as-possible processing */
+  gboolean offline;             /* Protected by lock */
+  gdouble throughput;           /* Protected by lock */
+  /* Only used from main context */
+  gboolean offline_applied;
+  GstClockTime offline_start_time, offline_start_position;
+
+  /* Scrub previews */
+  GstPlayerScrub *scrub;        /* Only used from main context */
+  ScrubCallback *scrub_callback;        /* Protected by lock */
+  gint scrub_width, scrub_height;       /* Protected by lock */
+  GstClockTime scrub_position;  /* Protected by lock */
+  gboolean scrub_seek_pending;  /* Protected by lock */
+
+  /* Audio levels, only measured while someone is interested */
+  GstPlayerAudioMeter *audio_meter;
+  gint audio_meter_active;      /* Atomic, set from main context */
+
+  /* Sink-native formats, protected by lock */
+  GstCaps *audio_sink_caps, *video_sink_caps;   /* NULL if anything goes */
+  GstElement *converters[2];    /* playsink's audio and video converters */
+  GstClockTime conversion_time[2];
+  guint64 n_converted[2];
+  /* Video sent to the sink, protected by lock */
+  guint64 sink_bytes, sink_rate_bytes, sink_byte_rate;
+  GstClockTime sink_rate_start;
+
+  /* Scaling to the renderer's target size */
+  GstElement *viewport_scale;   /* Set once before playback */
+  GstElement *viewport_filter;  /* Set once before playback */
+  gint target_width, target_height;     /* Protected by lock */
+  gint stream_width, stream_height;     /* Protected by lock */
+  gint stream_par_n, stream_par_d;      /* Protected by lock */
+
+  /* Subtitles rasterized by the application */
+  GstPlayerSubtitleOverlay *subtitle_overlay;
+  SubtitleRasterizer *subtitle_rasterizer;      /* Protected by lock */
+
+  /* Audio and video decoders, protected by lock. With decode-selected-only
+   * those of unselected tracks get no input. */
+  gboolean decode_selected_only;
+  GPtrArray *track_decoders;
+  guint64 n_unselected_dropped;
+  GstClockTime track_switch_latency;
+
+  /* Per-element CPU time and latency */
+  GstPlayerElementStats *element_stats;
+
+  /* Recent events for error reports */
+  GstPlayerFlightRecorder *flight_recorder;
+  gchar *error_events;          /* Protected by lock */
 };
 
 struct _GstPlayerClass
@@ -165,6 +430,9 @@ struct _GstPlayerClass
 static GstElement
     * gst_player_video_renderer_create_video_sink (GstPlayerVideoRenderer *
     self, GstPlayer * player);
+static gboolean
+gst_player_video_renderer_get_target_size (GstPlayerVideoRenderer * self,
+    gint * width, gint * height);
 
 static void gst_player_signal_dispatcher_dispatch (GstPlayerSignalDispatcher *
     self, GstPlayer * player, void (*emitter) (gpointer data), gpointer data,
@@ -197,6 +465,28 @@ static gboolean gst_player_play_internal (gpointer user_data);
 static gboolean gst_player_set_rate_internal (gpointer user_data);
 static gboolean gst_player_set_position_update_interval_internal (gpointer
     user_data);
+static gboolean gst_player_reset_degradation_internal (gpointer user_data);
+static gboolean gst_player_set_playlist_internal (gpointer user_data);
+static gboolean gst_player_set_restream_internal (gpointer user_data);
+static gboolean gst_player_set_loop_range_internal (gpointer user_data);
+static gboolean gst_player_trim_memory_internal (gpointer user_data);
+static void restore_trimmed_pipeline (GstPlayer * self);
+static void player_callbacks_unref (PlayerCallbacks * callbacks);
+static gboolean gst_player_set_offline_internal (gpointer user_data);
+static void scrub_callback_unref (ScrubCallback * callback);
+static void free_scrub (GstPlayer * self);
+static void target_size_changed_cb (GstPlayerVideoRenderer * renderer,
+    GstPlayer * self);
+static GstCaps *get_viewport_caps_locked (GstPlayer * self);
+static void subtitle_rasterizer_unref (SubtitleRasterizer * rasterizer);
+static GstVideoOverlayRectangle *rasterize_subtitle (const gchar * text,
+    gboolean markup, gint width, gint height, gpointer user_data);
+static void track_decoder_unref (TrackDecoder * decoder);
+static gboolean gst_player_update_track_decoders_internal (gpointer
+    user_data);
+static gboolean gst_player_watch_elements_internal (gpointer user_data);
+static gboolean playlist_skip (GstPlayer * self, gint direction,
+    gboolean automatic);
 static void change_state (GstPlayer * self, GstPlayerState state);
 
 static GstPlayerMediaInfo *gst_player_media_info_create (GstPlayer * self);
@@ -220,6 +510,10 @@ static void gst_player_subtitle_info_update (GstPlayer * self,
     GstPlayerStreamInfo * stream_info);
 
 static void emit_media_info_updated_signal (GstPlayer * self);
+static void remove_tag_update_source (GstPlayer * self);
+static void update_subtitles_shown (GstPlayer * self);
+static void watch_transition_sinks (GstPlayer * self);
+static void emit_audio_level (GstPlayer * self);
 
 static void *get_title (GstTagList * tags);
 static void *get_container_format (GstTagList * tags);
@@ -235,15 +529,53 @@ gst_player_init (GstPlayer * self)
   self = gst_player_get_instance_private (self);
 
   g_mutex_init (&self->lock);
+  g_mutex_init (&self->trim_lock);
   g_cond_init (&self->cond);
 
   self->context = g_main_context_new ();
   self->loop = g_main_loop_new (self->context, FALSE);
 
   self->position_update_interval_ms = DEFAULT_POSITION_UPDATE_INTERVAL_MS;
+  self->tag_update_interval_ms = DEFAULT_TAG_UPDATE_INTERVAL_MS;
   self->seek_pending = FALSE;
   self->seek_position = GST_CLOCK_TIME_NONE;
   self->last_seek_time = GST_CLOCK_TIME_NONE;
+  self->seek_latency = GST_CLOCK_TIME_NONE;
+  self->applied_rate = DEFAULT_RATE;
+  self->rate_change_start = GST_CLOCK_TIME_NONE;
+  self->rate_change_time = GST_CLOCK_TIME_NONE;
+  self->loop_start = GST_CLOCK_TIME_NONE;
+  self->loop_stop = GST_CLOCK_TIME_NONE;
+  self->pending_trim_level = -1;
+  self->autoplug_start = GST_CLOCK_TIME_NONE;
+  self->autoplug_time = GST_CLOCK_TIME_NONE;
+  self->autoplug_time_unhinted = GST_CLOCK_TIME_NONE;
+  self->degradation_enabled = DEFAULT_DEGRADATION_ENABLED;
+  self->skip_static_frames = DEFAULT_SKIP_STATIC_FRAMES;
+  self->frame_diff = gst_player_frame_diff_new ();
+  self->dirty_rects = g_array_new (FALSE, FALSE, sizeof (GstVideoRectangle));
+  self->degradation_since = GST_CLOCK_TIME_NONE;
+  self->last_overload = GST_CLOCK_TIME_NONE;
+  self->decoder_ranks =
+      g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+  self->decoder_threads =
+      g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+  self->transition_gap = GST_CLOCK_TIME_NONE;
+  self->restream_port = DEFAULT_RESTREAM_PORT;
+  self->restream_path = g_strdup (DEFAULT_RESTREAM_PATH);
+  self->offline = DEFAULT_OFFLINE;
+  self->offline_start_time = GST_CLOCK_TIME_NONE;
+  self->scrub_position = GST_CLOCK_TIME_NONE;
+  self->audio_meter = gst_player_audio_meter_new ();
+  self->subtitle_overlay =
+      gst_player_subtitle_overlay_new (rasterize_subtitle, self);
+  self->decode_selected_only = DEFAULT_DECODE_SELECTED_ONLY;
+  self->track_decoders =
+      g_ptr_array_new_with_free_func ((GDestroyNotify) track_decoder_unref);
+  self->track_switch_latency = GST_CLOCK_TIME_NONE;
+  self->element_stats = gst_player_element_stats_new ();
+  self->flight_recorder = gst_player_flight_recorder_new ();
+  self->sink_rate_start = GST_CLOCK_TIME_NONE;
 
   GST_TRACE_OBJECT (self, "Initialized");
 }
@@ -331,6 +663,69 @@ gst_player_class_init (GstPlayerClass * klass)
       0, 10000, DEFAULT_POSITION_UPDATE_INTERVAL_MS,
       G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS);
 
+  param_specs[PROP_TAG_UPDATE_INTERVAL] =
+      g_param_spec_uint ("tag-update-interval", "Tag update interval",
+      "Minimum interval in milliseconds between two media-info-updated "
+      "signals caused by global tags, later tags are merged. "
+      "Pass 0 to apply every changed tag list immediately.",
+      0, 60000, DEFAULT_TAG_UPDATE_INTERVAL_MS,
+      G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS);
+
+  param_specs[PROP_FORMAT_HINT] =
+      g_param_spec_boxed ("format-hint", "Format hint",
+      "Expected container caps followed by the expected stream caps, "
+      "used to skip typefinding and autoplugging for the next URI",
+      GST_TYPE_CAPS, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS);
+
+  param_specs[PROP_DEGRADATION_ENABLED] =
+      g_param_spec_boolean ("degradation-enabled", "Degradation enabled",
+      "Reduce video decoding quality when decoding can't keep up",
+      DEFAULT_DEGRADATION_ENABLED, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS);
+
+  param_specs[PROP_SKIP_STATIC_FRAMES] =
+      g_param_spec_boolean ("skip-static-frames", "Skip static frames",
+      "Skip conversion and rendering of video frames identical to the "
+      "previous one", DEFAULT_SKIP_STATIC_FRAMES,
+      G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS);
+
+  param_specs[PROP_PLAYLIST] =
+      g_param_spec_object ("playlist", "Playlist",
+      "URIs to play one after another", GST_TYPE_PLAYER_PLAYLIST,
+      G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS);
+
+  param_specs[PROP_RESTREAM_PORT] =
+      g_param_spec_uint ("restream-port", "Restream port",
+      "Port of the RTSP server re-streaming the encoded H.264 and AAC "
+      "streams, 0 to disable", 0, G_MAXUINT16, DEFAULT_RESTREAM_PORT,
+      G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS);
+
+  param_specs[PROP_RESTREAM_PATH] =
+      g_param_spec_string ("restream-path", "Restream path",
+      "Mount point of the re-streamed media on the RTSP server",
+      DEFAULT_RESTREAM_PATH, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS);
+
+  param_specs[PROP_OFFLINE] =
+      g_param_spec_boolean ("offline", "Offline",
+      "Process the stream as fast as possible instead of in real time. "
+      "The audio sink is only replaced when the next stream starts",
+      DEFAULT_OFFLINE, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS);
+
+  param_specs[PROP_THROUGHPUT] =
+      g_param_spec_double ("throughput", "Throughput",
+      "Processing speed in offline mode as a multiple of real time",
+      0, G_MAXDOUBLE, 0, G_PARAM_READABLE | G_PARAM_STATIC_STRINGS);
+
+  param_specs[PROP_DECODE_SELECTED_ONLY] =
+      g_param_spec_boolean ("decode-selected-only", "Decode selected only",
+      "Only decode the selected audio and video tracks",
+      DEFAULT_DECODE_SELECTED_ONLY, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS);
+
+  param_specs[PROP_ELEMENT_STATS_ENABLED] =
+      g_param_spec_boolean ("element-stats-enabled", "Element stats enabled",
+      "Measure CPU time and latency of every element",
+      DEFAULT_ELEMENT_STATS_ENABLED,
+      G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS);
+
   g_object_class_install_properties (gobject_class, PROP_LAST, param_specs);
 
   signals[SIGNAL_POSITION_UPDATED] =
@@ -392,6 +787,21 @@ gst_player_class_init (GstPlayerClass * klass)
       g_signal_new ("seek-done", G_TYPE_FROM_CLASS (klass),
       G_SIGNAL_RUN_LAST | G_SIGNAL_NO_RECURSE | G_SIGNAL_NO_HOOKS, 0, NULL,
       NULL, NULL, G_TYPE_NONE, 1, GST_TYPE_CLOCK_TIME);
+
+  signals[SIGNAL_DEGRADATION_LEVEL_CHANGED] =
+      g_signal_new ("degradation-level-changed", G_TYPE_FROM_CLASS (klass),
+      G_SIGNAL_RUN_LAST | G_SIGNAL_NO_RECURSE | G_SIGNAL_NO_HOOKS, 0, NULL,
+      NULL, NULL, G_TYPE_NONE, 1, GST_TYPE_PLAYER_DEGRADATION_LEVEL);
+
+  signals[SIGNAL_PLAYLIST_ITEM_CHANGED] =
+      g_signal_new ("playlist-item-changed", G_TYPE_FROM_CLASS (klass),
+      G_SIGNAL_RUN_LAST | G_SIGNAL_NO_RECURSE | G_SIGNAL_NO_HOOKS, 0, NULL,
+      NULL, NULL, G_TYPE_NONE, 1, G_TYPE_INT);
+
+  signals[SIGNAL_AUDIO_LEVEL] =
+      g_signal_new ("audio-level", G_TYPE_FROM_CLASS (klass),
+      G_SIGNAL_RUN_LAST | G_SIGNAL_NO_RECURSE | G_SIGNAL_NO_HOOKS, 0, NULL,
+      NULL, NULL, G_TYPE_NONE, 1, GST_TYPE_STRUCTURE);
 }
 
 static void
@@ -421,6 +831,7 @@ static void
 gst_player_finalize (GObject * object)
 {
   GstPlayer *self = GST_PLAYER (object);
+  guint i;
 
   GST_TRACE_OBJECT (self, "Finalizing");
 
@@ -429,13 +840,58 @@ gst_player_finalize (GObject * object)
     g_free (self->suburi);
   if (self->global_tags)
     gst_tag_list_unref (self->global_tags);
-  if (self->video_renderer)
+  remove_tag_update_source (self);
+  if (self->video_renderer) {
+    g_signal_handlers_disconnect_by_func (self->video_renderer,
+        target_size_changed_cb, self);
     g_object_unref (self->video_renderer);
+  }
+  if (self->viewport_scale)
+    gst_object_unref (self->viewport_scale);
+  if (self->viewport_filter)
+    gst_object_unref (self->viewport_filter);
   if (self->signal_dispatcher)
     g_object_unref (self->signal_dispatcher);
   if (self->current_vis_element)
     gst_object_unref (self->current_vis_element);
+  if (self->format_hint)
+    gst_caps_unref (self->format_hint);
+  if (self->active_format_hint)
+    gst_caps_unref (self->active_format_hint);
+  gst_plugin_feature_list_free (self->hint_factories);
+  if (self->video_decoder)
+    gst_object_unref (self->video_decoder);
+  gst_player_frame_diff_free (self->frame_diff);
+  g_array_unref (self->dirty_rects);
+  g_hash_table_unref (self->decoder_ranks);
+  g_hash_table_unref (self->decoder_threads);
+  g_strfreev (self->decoder_allowlist);
+  g_strfreev (self->decoder_denylist);
+  if (self->playlist)
+    g_object_unref (self->playlist);
+  g_free (self->pending_uri);
+  g_free (self->restream_path);
+  if (self->callbacks)
+    player_callbacks_unref (self->callbacks);
+  if (self->scrub_callback)
+    scrub_callback_unref (self->scrub_callback);
+  gst_player_audio_meter_free (self->audio_meter);
+  gst_player_subtitle_overlay_free (self->subtitle_overlay);
+  if (self->subtitle_rasterizer)
+    subtitle_rasterizer_unref (self->subtitle_rasterizer);
+  g_ptr_array_unref (self->track_decoders);
+  gst_player_element_stats_free (self->element_stats);
+  gst_player_flight_recorder_free (self->flight_recorder);
+  g_free (self->error_events);
+  if (self->audio_sink_caps)
+    gst_caps_unref (self->audio_sink_caps);
+  if (self->video_sink_caps)
+    gst_caps_unref (self->video_sink_caps);
+  for (i = 0; i < G_N_ELEMENTS (self->converters); i++)
+    if (self->converters[i])
+      gst_object_unref (self->converters[i]);
   g_mutex_clear (&self->lock);
+  g_mutex_clear (&self->trim_lock);
   g_cond_clear (&self->cond);
 
   G_OBJECT_CLASS (parent_class)->finalize (object);
@@ -457,18 +913,58 @@ gst_player_constructed (GObject * object)
   G_OBJECT_CLASS (parent_class)->constructed (object);
 }
 
+/* Must be called with lock */
+static void
+gst_player_update_format_hint_locked (GstPlayer * self, const gchar * uri)
+{
+  gchar *protocol;
+
+  gst_caps_replace (&self->active_format_hint, NULL);
+  gst_plugin_feature_list_free (self->hint_factories);
+  self->hint_factories = NULL;
+  self->format_hint_confirmed = FALSE;
+  self->format_hint_missed = FALSE;
+  self->autoplug_start = GST_CLOCK_TIME_NONE;
+  self->autoplug_time = GST_CLOCK_TIME_NONE;
+
+  if (!uri)
+    return;
+
+  if (self->format_hint) {
+    self->active_format_hint = gst_caps_ref (self->format_hint);
+  } else {
+    protocol = gst_uri_get_protocol (uri);
+    if (protocol && g_str_has_prefix (protocol, "rtmp"))
+      self->active_format_hint = gst_static_caps_get (&rtmp_format_hint);
+    g_free (protocol);
+  }
+
+  if (self->active_format_hint)
+    GST_DEBUG_OBJECT (self, "Using format hint %" GST_PTR_FORMAT,
+        self->active_format_hint);
+}
+
 static gboolean
 gst_player_set_uri_internal (gpointer user_data)
 {
   GstPlayer *self = user_data;
 
   gst_player_stop_internal (self);
+  /* Previews are of the previous URI */
+  free_scrub (self);
 
   g_mutex_lock (&self->lock);
 
   GST_DEBUG_OBJECT (self, "Changing URI to '%s'", GST_STR_NULL (self->uri));
 
+  gst_player_plugin_loader_ensure_uri (self->uri);
   g_object_set (self->playbin, "uri", self->uri, NULL);
+  gst_player_update_format_hint_locked (self, self->uri);
+
+  /* The loop range is for the previous URI */
+  self->loop_start = GST_CLOCK_TIME_NONE;
+  self->loop_stop = GST_CLOCK_TIME_NONE;
+  self->n_loops = 0;
 
   /* if have suburi from previous playback then free it */
   if (self->suburi) {
@@ -499,6 +995,7 @@ gst_player_set_suburi_internal (gpointer user_data)
   GST_DEBUG_OBJECT (self, "Changing SUBURI to '%s'",
       GST_STR_NULL (self->suburi));
 
+  gst_player_plugin_loader_ensure_uri (self->suburi);
   g_object_set (self->playbin, "suburi", self->suburi, NULL);
   g_object_set (self->playbin, "uri", self->uri, NULL);
 
@@ -579,6 +1076,98 @@ gst_player_set_property (GObject * object, guint prop_id,
 
       gst_player_set_position_update_interval_internal (self);
       break;
+    case PROP_TAG_UPDATE_INTERVAL:
+      g_mutex_lock (&self->lock);
+      self->tag_update_interval_ms = g_value_get_uint (value);
+      GST_DEBUG_OBJECT (self, "Set tag update interval=%u ms",
+          g_value_get_uint (value));
+      g_mutex_unlock (&self->lock);
+      break;
+    case PROP_FORMAT_HINT:
+      g_mutex_lock (&self->lock);
+      gst_caps_replace (&self->format_hint, g_value_get_boxed (value));
+      GST_DEBUG_OBJECT (self, "Set format hint=%" GST_PTR_FORMAT,
+          self->format_hint);
+      g_mutex_unlock (&self->lock);
+      break;
+    case PROP_DEGRADATION_ENABLED:
+      g_mutex_lock (&self->lock);
+      self->degradation_enabled = g_value_get_boolean (value);
+      GST_DEBUG_OBJECT (self, "Set degradation enabled=%d",
+          self->degradation_enabled);
+      g_mutex_unlock (&self->lock);
+
+      if (!g_value_get_boolean (value))
+        g_main_context_invoke_full (self->context, G_PRIORITY_DEFAULT,
+            gst_player_reset_degradation_internal, self, NULL);
+      break;
+    case PROP_SKIP_STATIC_FRAMES:
+      g_mutex_lock (&self->lock);
+      self->skip_static_frames = g_value_get_boolean (value);
+      GST_DEBUG_OBJECT (self, "Set skip static frames=%d",
+          self->skip_static_frames);
+      g_mutex_unlock (&self->lock);
+      break;
+    case PROP_PLAYLIST:
+      g_mutex_lock (&self->lock);
+      if (self->playlist)
+        g_object_unref (self->playlist);
+      self->playlist = g_value_dup_object (value);
+      GST_DEBUG_OBJECT (self, "Set playlist=%p", self->playlist);
+      g_mutex_unlock (&self->lock);
+
+      g_main_context_invoke_full (self->context, G_PRIORITY_DEFAULT,
+          gst_player_set_playlist_internal, self, NULL);
+      break;
+    case PROP_RESTREAM_PORT:
+      g_mutex_lock (&self->lock);
+      self->restream_port = g_value_get_uint (value);
+      GST_DEBUG_OBJECT (self, "Set restream port=%u", self->restream_port);
+      g_mutex_unlock (&self->lock);
+
+      g_main_context_invoke_full (self->context, G_PRIORITY_DEFAULT,
+          gst_player_set_restream_internal, self, NULL);
+      break;
+    case PROP_RESTREAM_PATH:
+      g_mutex_lock (&self->lock);
+      g_free (self->restream_path);
+      self->restream_path = g_value_dup_string (value);
+      if (!self->restream_path)
+        self->restream_path = g_strdup (DEFAULT_RESTREAM_PATH);
+      GST_DEBUG_OBJECT (self, "Set restream path=%s", self->restream_path);
+      g_mutex_unlock (&self->lock);
+
+      g_main_context_invoke_full (self->context, G_PRIORITY_DEFAULT,
+          gst_player_set_restream_internal, self, NULL);
+      break;
+    case PROP_OFFLINE:
+      g_mutex_lock (&self->lock);
+      self->offline = g_value_get_boolean (value);
+      GST_DEBUG_OBJECT (self, "Set offline=%d", self->offline);
+      g_mutex_unlock (&self->lock);
+
+      g_main_context_invoke_full (self->context, G_PRIORITY_DEFAULT,
+          gst_player_set_offline_internal, self, NULL);
+      break;
+    case PROP_DECODE_SELECTED_ONLY:
+      g_mutex_lock (&self->lock);
+      self->decode_selected_only = g_value_get_boolean (value);
+      GST_DEBUG_OBJECT (self, "Set decode selected only=%d",
+          self->decode_selected_only);
+      g_mutex_unlock (&self->lock);
+
+      g_main_context_invoke_full (self->context, G_PRIORITY_DEFAULT,
+          gst_player_update_track_decoders_internal, self, NULL);
+      break;
+    case PROP_ELEMENT_STATS_ENABLED:
+      gst_player_element_stats_set_enabled (self->element_stats,
+          g_value_get_boolean (value));
+      GST_DEBUG_OBJECT (self, "Set element stats enabled=%d",
+          g_value_get_boolean (value));
+
+      g_main_context_invoke_full (self->context, G_PRIORITY_DEFAULT,
+          gst_player_watch_elements_internal, self, NULL);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -607,7 +1196,14 @@ gst_player_get_property (GObject * object, guint prop_id,
     case PROP_POSITION:{
       gint64 position = 0;
 
-      gst_element_query_position (self->playbin, GST_FORMAT_TIME, &position);
+      /* Called with and without lock. While trimmed the pipeline is in
+       * READY until playback continues, a pending seek position wins */
+      if (g_atomic_int_get (&self->pipeline_trimmed)) {
+        g_mutex_lock (&self->trim_lock);
+        position = self->trimmed_position;
+        g_mutex_unlock (&self->trim_lock);
+      } else
+        gst_element_query_position (self->playbin, GST_FORMAT_TIME, &position);
       g_value_set_uint64 (value, position);
       GST_TRACE_OBJECT (self, "Returning position=%" GST_TIME_FORMAT,
           GST_TIME_ARGS (g_value_get_uint64 (value)));
@@ -616,7 +1212,12 @@ gst_player_get_property (GObject * object, guint prop_id,
     case PROP_DURATION:{
       gint64 duration = 0;
 
-      gst_element_query_duration (self->playbin, GST_FORMAT_TIME, &duration);
+      if (!gst_element_query_duration (self->playbin, GST_FORMAT_TIME,
+              &duration) && g_atomic_int_get (&self->pipeline_trimmed)) {
+        g_mutex_lock (&self->trim_lock);
+        duration = self->trimmed_duration;
+        g_mutex_unlock (&self->trim_lock);
+      }
       g_value_set_uint64 (value, duration);
       GST_TRACE_OBJECT (self, "Returning duration=%" GST_TIME_FORMAT,
           GST_TIME_ARGS (g_value_get_uint64 (value)));
@@ -671,6 +1272,60 @@ gst_player_get_property (GObject * object, guint prop_id,
       g_value_set_uint (value, gst_player_get_position_update_interval (self));
       g_mutex_unlock (&self->lock);
       break;
+    case PROP_TAG_UPDATE_INTERVAL:
+      g_mutex_lock (&self->lock);
+      g_value_set_uint (value, self->tag_update_interval_ms);
+      g_mutex_unlock (&self->lock);
+      break;
+    case PROP_FORMAT_HINT:
+      g_mutex_lock (&self->lock);
+      g_value_set_boxed (value, self->format_hint);
+      g_mutex_unlock (&self->lock);
+      break;
+    case PROP_DEGRADATION_ENABLED:
+      g_mutex_lock (&self->lock);
+      g_value_set_boolean (value, self->degradation_enabled);
+      g_mutex_unlock (&self->lock);
+      break;
+    case PROP_SKIP_STATIC_FRAMES:
+      g_mutex_lock (&self->lock);
+      g_value_set_boolean (value, self->skip_static_frames);
+      g_mutex_unlock (&self->lock);
+      break;
+    case PROP_PLAYLIST:
+      g_mutex_lock (&self->lock);
+      g_value_set_object (value, self->playlist);
+      g_mutex_unlock (&self->lock);
+      break;
+    case PROP_RESTREAM_PORT:
+      g_mutex_lock (&self->lock);
+      g_value_set_uint (value, self->restream_port);
+      g_mutex_unlock (&self->lock);
+      break;
+    case PROP_RESTREAM_PATH:
+      g_mutex_lock (&self->lock);
+      g_value_set_string (value, self->restream_path);
+      g_mutex_unlock (&self->lock);
+      break;
+    case PROP_OFFLINE:
+      g_mutex_lock (&self->lock);
+      g_value_set_boolean (value, self->offline);
+      g_mutex_unlock (&self->lock);
+      break;
+    case PROP_THROUGHPUT:
+      g_mutex_lock (&self->lock);
+      g_value_set_double (value, self->throughput);
+      g_mutex_unlock (&self->lock);
+      break;
+    case PROP_DECODE_SELECTED_ONLY:
+      g_mutex_lock (&self->lock);
+      g_value_set_boolean (value, self->decode_selected_only);
+      g_mutex_unlock (&self->lock);
+      break;
+    case PROP_ELEMENT_STATS_ENABLED:
+      g_value_set_boolean (value,
+          gst_player_element_stats_get_enabled (self->element_stats));
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -691,9 +1346,82 @@ main_loop_running_cb (gpointer user_data)
   return G_SOURCE_REMOVE;
 }
 
+static PlayerCallbacks *
+player_callbacks_ref (PlayerCallbacks * callbacks)
+{
+  g_atomic_int_inc (&callbacks->ref_count);
+
+  return callbacks;
+}
+
+static void
+player_callbacks_unref (PlayerCallbacks * callbacks)
+{
+  if (!g_atomic_int_dec_and_test (&callbacks->ref_count))
+    return;
+
+  if (callbacks->notify)
+    callbacks->notify (callbacks->user_data);
+  g_free (callbacks);
+}
+
+#define get_callbacks(self, name) \
+    get_callbacks_at_offset (self, G_STRUCT_OFFSET (GstPlayerCallbacks, name))
+
+/* Returns the callbacks if the one at @offset is set. Only takes the lock
+ * if it is */
+static PlayerCallbacks *
+get_callbacks_at_offset (GstPlayer * self, glong offset)
+{
+  PlayerCallbacks *callbacks = NULL;
+
+  if (!(g_atomic_int_get (&self->callbacks_mask) &
+          (1 << (offset / sizeof (gpointer)))))
+    return NULL;
+
+  g_mutex_lock (&self->lock);
+  if (self->callbacks
+      && G_STRUCT_MEMBER (gpointer, &self->callbacks->callbacks, offset))
+    callbacks = player_callbacks_ref (self->callbacks);
+  g_mutex_unlock (&self->lock);
+
+  return callbacks;
+}
+
+#define has_handler(self, signal) \
+    (g_signal_handler_find (self, G_SIGNAL_MATCH_ID, signals[signal], 0, NULL, \
+        NULL, NULL) != 0)
+
+/* Must be called from main context. Like has_handler(), but the result is
+ * reused for HANDLER_CACHE_INTERVAL_US. Handlers connected meanwhile miss
+ * the events until then, so this is only for the per-tick signals,
+ * "position-updated" and "audio-level" */
+static gboolean
+has_handler_cached (GstPlayer * self, guint signal)
+{
+  gint64 now = g_get_monotonic_time ();
+
+  if (now - self->handler_cache_time >= HANDLER_CACHE_INTERVAL_US) {
+    self->handler_cache_valid = 0;
+    self->handler_cache_time = now;
+  }
+
+  if (!(self->handler_cache_valid & (1 << signal))) {
+    if (has_handler (self, signal))
+      self->handler_cache |= 1 << signal;
+    else
+      self->handler_cache &= ~(1 << signal);
+    self->handler_cache_valid |= 1 << signal;
+  }
+
+  return (self->handler_cache & (1 << signal)) != 0;
+}
+
 typedef struct
 {
   GstPlayer *player;
+  PlayerCallbacks *callbacks;
+  gboolean emit;
   GstPlayerState state;
 } StateChangedSignalData;
 
@@ -702,19 +1430,29 @@ state_changed_dispatch (gpointer user_data)
 {
   StateChangedSignalData *data = user_data;
 
-  g_signal_emit (data->player, signals[SIGNAL_STATE_CHANGED], 0, data->state);
+  if (data->callbacks)
+    data->callbacks->callbacks.state_changed (data->player, data->state,
+        data->callbacks->user_data);
+  if (data->emit)
+    g_signal_emit (data->player, signals[SIGNAL_STATE_CHANGED], 0,
+        data->state);
 }
 
 static void
 state_changed_signal_data_free (StateChangedSignalData * data)
 {
   g_object_unref (data->player);
+  if (data->callbacks)
+    player_callbacks_unref (data->callbacks);
   g_free (data);
 }
 
 static void
 change_state (GstPlayer * self, GstPlayerState state)
 {
+  PlayerCallbacks *callbacks;
+  gboolean emit;
+
   if (state == self->app_state)
     return;
 
@@ -722,12 +1460,17 @@ change_state (GstPlayer * self, GstPlayerState state)
       gst_player_state_get_name (self->app_state),
       gst_player_state_get_name (state));
   self->app_state = state;
+  gst_player_flight_recorder_record (self->flight_recorder,
+      FLIGHT_EVENT_PLAYER_STATE, state, 0, GST_CLOCK_TIME_NONE);
 
-  if (g_signal_handler_find (self, G_SIGNAL_MATCH_ID,
-          signals[SIGNAL_STATE_CHANGED], 0, NULL, NULL, NULL) != 0) {
+  callbacks = get_callbacks (self, state_changed);
+  emit = has_handler (self, SIGNAL_STATE_CHANGED);
+  if (callbacks || emit) {
     StateChangedSignalData *data = g_new (StateChangedSignalData, 1);
 
     data->player = g_object_ref (self);
+    data->callbacks = callbacks;
+    data->emit = emit;
     data->state = state;
     gst_player_signal_dispatcher_dispatch (self->signal_dispatcher, self,
         state_changed_dispatch, data,
@@ -738,6 +1481,9 @@ change_state (GstPlayer * self, GstPlayerState state)
 typedef struct
 {
   GstPlayer *player;
+  PlayerCallbacks *callbacks;
+  gboolean emit;
+  gboolean offline;
   GstClockTime position;
 } PositionUpdatedSignalData;
 
@@ -747,17 +1493,46 @@ position_updated_dispatch (gpointer user_data)
   PositionUpdatedSignalData *data = user_data;
 
   if (data->player->target_state >= GST_STATE_PAUSED) {
-    g_signal_emit (data->player, signals[SIGNAL_POSITION_UPDATED], 0,
-        data->position);
-    g_object_notify_by_pspec (G_OBJECT (data->player),
-        param_specs[PROP_POSITION]);
+    if (data->callbacks)
+      data->callbacks->callbacks.position_updated (data->player,
+          data->position, data->callbacks->user_data);
+    if (data->emit) {
+      g_signal_emit (data->player, signals[SIGNAL_POSITION_UPDATED], 0,
+          data->position);
+      g_object_notify_by_pspec (G_OBJECT (data->player),
+          param_specs[PROP_POSITION]);
+      if (data->offline)
+        g_object_notify_by_pspec (G_OBJECT (data->player),
+            param_specs[PROP_THROUGHPUT]);
+    }
+  }
+}
+
+/* Measures how fast the position advances compared to the wall clock.
+ * Restarted whenever the tick source stops or the position goes back */
+static gdouble
+update_throughput (GstPlayer * self, GstClockTime position)
+{
+  GstClockTime now = gst_util_get_timestamp ();
+
+  if (!GST_CLOCK_TIME_IS_VALID (self->offline_start_time)
+      || position < self->offline_start_position
+      || now <= self->offline_start_time) {
+    self->offline_start_time = now;
+    self->offline_start_position = position;
+    return 0.0;
   }
+
+  return (gdouble) (position - self->offline_start_position) /
+      (now - self->offline_start_time);
 }
 
 static void
 position_updated_signal_data_free (PositionUpdatedSignalData * data)
 {
   g_object_unref (data->player);
+  if (data->callbacks)
+    player_callbacks_unref (data->callbacks);
   g_free (data);
 }
 
@@ -770,14 +1545,31 @@ tick_cb (gpointer user_data)
   if (self->target_state >= GST_STATE_PAUSED
       && gst_element_query_position (self->playbin, GST_FORMAT_TIME,
           &position)) {
+    PlayerCallbacks *callbacks;
+    gboolean emit, offline;
+
     GST_LOG_OBJECT (self, "Position %" GST_TIME_FORMAT,
         GST_TIME_ARGS (position));
+    gst_player_flight_recorder_record (self->flight_recorder,
+        FLIGHT_EVENT_POSITION, 0, 0, position);
+
+    g_mutex_lock (&self->lock);
+    offline = self->offline;
+    if (offline && self->tick_source) {
+      self->throughput = update_throughput (self, position);
+      GST_LOG_OBJECT (self, "Throughput %.2fx", self->throughput);
+    }
+    g_mutex_unlock (&self->lock);
 
-    if (g_signal_handler_find (self, G_SIGNAL_MATCH_ID,
-            signals[SIGNAL_POSITION_UPDATED], 0, NULL, NULL, NULL) != 0) {
+    callbacks = get_callbacks (self, position_updated);
+    emit = has_handler_cached (self, SIGNAL_POSITION_UPDATED);
+    if (callbacks || emit) {
       PositionUpdatedSignalData *data = g_new (PositionUpdatedSignalData, 1);
 
       data->player = g_object_ref (self);
+      data->callbacks = callbacks;
+      data->emit = emit;
+      data->offline = offline;
       data->position = position;
       gst_player_signal_dispatcher_dispatch (self->signal_dispatcher, self,
           position_updated_dispatch, data,
@@ -785,9 +1577,80 @@ tick_cb (gpointer user_data)
     }
   }
 
+  emit_audio_level (self);
+
   return G_SOURCE_CONTINUE;
 }
 
+typedef struct
+{
+  GstPlayer *player;
+  PlayerCallbacks *callbacks;
+  gboolean emit;
+  GstStructure *levels;
+} AudioLevelSignalData;
+
+static void
+audio_level_dispatch (gpointer user_data)
+{
+  AudioLevelSignalData *data = user_data;
+
+  if (data->callbacks)
+    data->callbacks->callbacks.audio_level (data->player, data->levels,
+        data->callbacks->user_data);
+  if (data->emit)
+    g_signal_emit (data->player, signals[SIGNAL_AUDIO_LEVEL], 0,
+        data->levels);
+}
+
+static void
+audio_level_signal_data_free (AudioLevelSignalData * data)
+{
+  g_object_unref (data->player);
+  if (data->callbacks)
+    player_callbacks_unref (data->callbacks);
+  gst_structure_free (data->levels);
+  g_free (data);
+}
+
+/* Must be called from main context */
+static void
+emit_audio_level (GstPlayer * self)
+{
+  PlayerCallbacks *callbacks;
+  GstStructure *levels;
+  gboolean emit;
+
+  callbacks = get_callbacks (self, audio_level);
+  emit = has_handler_cached (self, SIGNAL_AUDIO_LEVEL);
+
+  /* Without anyone interested audio buffers are not even looked at */
+  if (!callbacks && !emit) {
+    g_atomic_int_set (&self->audio_meter_active, 0);
+    return;
+  }
+
+  if (!g_atomic_int_get (&self->audio_meter_active)) {
+    gst_player_audio_meter_reset (self->audio_meter);
+    g_atomic_int_set (&self->audio_meter_active, 1);
+  }
+
+  levels = gst_player_audio_meter_take_levels (self->audio_meter);
+  if (levels) {
+    AudioLevelSignalData *data = g_new (AudioLevelSignalData, 1);
+
+    data->player = g_object_ref (self);
+    data->callbacks = callbacks;
+    data->emit = emit;
+    data->levels = levels;
+    gst_player_signal_dispatcher_dispatch (self->signal_dispatcher, self,
+        audio_level_dispatch, data,
+        (GDestroyNotify) audio_level_signal_data_free);
+  } else if (callbacks) {
+    player_callbacks_unref (callbacks);
+  }
+}
+
 static void
 add_tick_source (GstPlayer * self)
 {
@@ -811,6 +1674,7 @@ remove_tick_source (GstPlayer * self)
   g_source_destroy (self->tick_source);
   g_source_unref (self->tick_source);
   self->tick_source = NULL;
+  self->offline_start_time = GST_CLOCK_TIME_NONE;
 }
 
 static gboolean
@@ -854,6 +1718,8 @@ remove_ready_timeout_source (GstPlayer * self)
 typedef struct
 {
   GstPlayer *player;
+  PlayerCallbacks *callbacks;
+  gboolean emit;
   GError *err;
 } ErrorSignalData;
 
@@ -862,13 +1728,19 @@ error_dispatch (gpointer user_data)
 {
   ErrorSignalData *data = user_data;
 
-  g_signal_emit (data->player, signals[SIGNAL_ERROR], 0, data->err);
+  if (data->callbacks)
+    data->callbacks->callbacks.error (data->player, data->err,
+        data->callbacks->user_data);
+  if (data->emit)
+    g_signal_emit (data->player, signals[SIGNAL_ERROR], 0, data->err);
 }
 
 static void
 free_error_signal_data (ErrorSignalData * data)
 {
   g_object_unref (data->player);
+  if (data->callbacks)
+    player_callbacks_unref (data->callbacks);
   g_clear_error (&data->err);
   g_free (data);
 }
@@ -876,14 +1748,33 @@ free_error_signal_data (ErrorSignalData * data)
 static void
 emit_error (GstPlayer * self, GError * err)
 {
+  PlayerCallbacks *callbacks;
+  gboolean emit;
+  gchar *events;
+
   GST_ERROR_OBJECT (self, "Error: %s (%s, %d)", err->message,
       g_quark_to_string (err->domain), err->code);
 
-  if (g_signal_handler_find (self, G_SIGNAL_MATCH_ID,
-          signals[SIGNAL_ERROR], 0, NULL, NULL, NULL) != 0) {
+  gst_player_flight_recorder_record (self->flight_recorder,
+      FLIGHT_EVENT_ERROR, err->domain, err->code, GST_CLOCK_TIME_NONE);
+
+  /* Errors are rare, so always decode the records for the error report
+   * before the callbacks run */
+  events = gst_player_flight_recorder_dump (self->flight_recorder);
+  GST_ERROR_OBJECT (self, "Events before the error:\n%s", events);
+  g_mutex_lock (&self->lock);
+  g_free (self->error_events);
+  self->error_events = events;
+  g_mutex_unlock (&self->lock);
+
+  callbacks = get_callbacks (self, error);
+  emit = has_handler (self, SIGNAL_ERROR);
+  if (callbacks || emit) {
     ErrorSignalData *data = g_new (ErrorSignalData, 1);
 
     data->player = g_object_ref (self);
+    data->callbacks = callbacks;
+    data->emit = emit;
     data->err = g_error_copy (err);
     gst_player_signal_dispatcher_dispatch (self->signal_dispatcher, self,
         error_dispatch, data, (GDestroyNotify) free_error_signal_data);
@@ -912,6 +1803,7 @@ emit_error (GstPlayer * self, GError * err)
     gst_tag_list_unref (self->global_tags);
     self->global_tags = NULL;
   }
+  remove_tag_update_source (self);
 
   self->seek_pending = FALSE;
   if (self->seek_source) {
@@ -924,6 +1816,37 @@ emit_error (GstPlayer * self, GError * err)
   g_mutex_unlock (&self->lock);
 }
 
+/* Like GST_DEBUG_BIN_TO_DOT_FILE_WITH_TS() with the element stats in the
+ * labels of the elements */
+static void
+dump_annotated_dot_file (GstPlayer * self, const gchar * name)
+{
+  const gchar *dir = g_getenv ("GST_DEBUG_DUMP_DOT_DIR");
+  GstClockTime now = gst_util_get_timestamp ();
+  gchar *dot, *annotated, *path;
+  GError *err = NULL;
+
+  if (!dir)
+    return;
+
+  gst_player_element_stats_watch (self->element_stats,
+      GST_BIN (self->playbin));
+  dot = gst_debug_bin_to_dot_data (GST_BIN (self->playbin),
+      GST_DEBUG_GRAPH_SHOW_ALL);
+  annotated = gst_player_element_stats_annotate_dot (self->element_stats, dot);
+  path = g_strdup_printf ("%s" G_DIR_SEPARATOR_S "%u.%02u.%02u.%09u-%s.dot",
+      dir, GST_TIME_ARGS (now), name);
+
+  if (!g_file_set_contents (path, annotated, -1, &err)) {
+    GST_WARNING_OBJECT (self, "Failed to write %s: %s", path, err->message);
+    g_clear_error (&err);
+  }
+
+  g_free (path);
+  g_free (annotated);
+  g_free (dot);
+}
+
 static void
 dump_dot_file (GstPlayer * self, const gchar * name)
 {
@@ -931,8 +1854,11 @@ dump_dot_file (GstPlayer * self, const gchar * name)
 
   full_name = g_strdup_printf ("gst-player.%p.%s", self, name);
 
-  GST_DEBUG_BIN_TO_DOT_FILE_WITH_TS (GST_BIN (self->playbin),
-      GST_DEBUG_GRAPH_SHOW_ALL, full_name);
+  if (gst_player_element_stats_get_enabled (self->element_stats))
+    dump_annotated_dot_file (self, full_name);
+  else
+    GST_DEBUG_BIN_TO_DOT_FILE_WITH_TS (GST_BIN (self->playbin),
+        GST_DEBUG_GRAPH_SHOW_ALL, full_name);
 
   g_free (full_name);
 }
@@ -978,6 +1904,53 @@ emit_warning (GstPlayer * self, GError * err)
   g_error_free (err);
 }
 
+/* Must be called with lock. A miss while autoplugging is usually followed
+ * by the retry below, both only count once */
+static void
+format_hint_miss_locked (GstPlayer * self)
+{
+  if (self->format_hint_missed)
+    return;
+
+  self->format_hint_missed = TRUE;
+  self->format_hint_misses++;
+}
+
+/* If the stream turned out not to match the format hint before autoplugging
+ * finished, drop the hint and start over with full autoplugging */
+static gboolean
+format_hint_retry (GstPlayer * self, GError * err)
+{
+  GstState target_state = self->target_state;
+
+  if (err->domain != GST_STREAM_ERROR)
+    return FALSE;
+
+  g_mutex_lock (&self->lock);
+  if (!self->active_format_hint || self->format_hint_confirmed) {
+    g_mutex_unlock (&self->lock);
+    return FALSE;
+  }
+
+  GST_WARNING_OBJECT (self, "Stream does not match format hint %"
+      GST_PTR_FORMAT ", retrying without: %s", self->active_format_hint,
+      err->message);
+
+  gst_caps_replace (&self->active_format_hint, NULL);
+  gst_plugin_feature_list_free (self->hint_factories);
+  self->hint_factories = NULL;
+  format_hint_miss_locked (self);
+  g_mutex_unlock (&self->lock);
+
+  gst_player_stop_internal (self);
+  if (target_state == GST_STATE_PAUSED)
+    gst_player_pause_internal (self);
+  else if (target_state == GST_STATE_PLAYING)
+    gst_player_play_internal (self);
+
+  return TRUE;
+}
+
 static void
 error_cb (GstBus * bus, GstMessage * msg, gpointer user_data)
 {
@@ -985,10 +1958,16 @@ error_cb (GstBus * bus, GstMessage * msg, gpointer user_data)
   GError *err, *player_err;
   gchar *name, *debug, *message, *full_message;
 
-  dump_dot_file (self, "error");
-
   gst_message_parse_error (msg, &err, &debug);
 
+  if (format_hint_retry (self, err)) {
+    g_clear_error (&err);
+    g_free (debug);
+    return;
+  }
+
+  dump_dot_file (self, "error");
+
   name = gst_object_get_path_string (msg->src);
   message = gst_error_get_message (err->domain, err->code);
 
@@ -1027,6 +2006,8 @@ warning_cb (GstBus * bus, GstMessage * msg, gpointer user_data)
   dump_dot_file (self, "warning");
 
   gst_message_parse_warning (msg, &err, &debug);
+  gst_player_flight_recorder_record (self->flight_recorder,
+      FLIGHT_EVENT_WARNING, err->domain, err->code, GST_CLOCK_TIME_NONE);
 
   name = gst_object_get_path_string (msg->src);
   message = gst_error_get_message (err->domain, err->code);
@@ -1069,6 +2050,14 @@ eos_cb (GstBus * bus, GstMessage * msg, gpointer user_data)
   GstPlayer *self = GST_PLAYER (user_data);
 
   GST_DEBUG_OBJECT (self, "End of stream");
+  gst_player_flight_recorder_record (self->flight_recorder, FLIGHT_EVENT_EOS,
+      0, 0, GST_CLOCK_TIME_NONE);
+
+  /* Normally the next playlist item was already prepared when the current
+   * one was about to finish. If not, e.g. because it was queued only after
+   * that, continue with it now */
+  if (playlist_skip (self, 1, TRUE))
+    return;
 
   tick_cb (self);
   remove_tick_source (self);
@@ -1086,6 +2075,8 @@ eos_cb (GstBus * bus, GstMessage * msg, gpointer user_data)
 typedef struct
 {
   GstPlayer *player;
+  PlayerCallbacks *callbacks;
+  gboolean emit;
   gint percent;
 } BufferingSignalData;
 
@@ -1095,7 +2086,12 @@ buffering_dispatch (gpointer user_data)
   BufferingSignalData *data = user_data;
 
   if (data->player->target_state >= GST_STATE_PAUSED) {
-    g_signal_emit (data->player, signals[SIGNAL_BUFFERING], 0, data->percent);
+    if (data->callbacks)
+      data->callbacks->callbacks.buffering (data->player, data->percent,
+          data->callbacks->user_data);
+    if (data->emit)
+      g_signal_emit (data->player, signals[SIGNAL_BUFFERING], 0,
+          data->percent);
   }
 }
 
@@ -1103,6 +2099,8 @@ static void
 buffering_signal_data_free (BufferingSignalData * data)
 {
   g_object_unref (data->player);
+  if (data->callbacks)
+    player_callbacks_unref (data->callbacks);
   g_free (data);
 }
 
@@ -1119,6 +2117,8 @@ buffering_cb (GstBus * bus, GstMessage * msg, gpointer user_data)
 
   gst_message_parse_buffering (msg, &percent);
   GST_LOG_OBJECT (self, "Buffering %d%%", percent);
+  gst_player_flight_recorder_record (self->flight_recorder,
+      FLIGHT_EVENT_BUFFERING, percent, 0, GST_CLOCK_TIME_NONE);
 
   if (percent < 100 && self->target_state >= GST_STATE_PAUSED) {
     GstStateChangeReturn state_ret;
@@ -1136,11 +2136,15 @@ buffering_cb (GstBus * bus, GstMessage * msg, gpointer user_data)
   }
 
   if (self->buffering != percent) {
-    if (g_signal_handler_find (self, G_SIGNAL_MATCH_ID,
-            signals[SIGNAL_BUFFERING], 0, NULL, NULL, NULL) != 0) {
+    PlayerCallbacks *callbacks = get_callbacks (self, buffering);
+    gboolean emit = has_handler (self, SIGNAL_BUFFERING);
+
+    if (callbacks || emit) {
       BufferingSignalData *data = g_new (BufferingSignalData, 1);
 
       data->player = g_object_ref (self);
+      data->callbacks = callbacks;
+      data->emit = emit;
       data->percent = percent;
       gst_player_signal_dispatcher_dispatch (self->signal_dispatcher, self,
           buffering_dispatch, data,
@@ -1200,6 +2204,8 @@ clock_lost_cb (GstBus * bus, GstMessage * msg, gpointer user_data)
 typedef struct
 {
   GstPlayer *player;
+  PlayerCallbacks *callbacks;
+  gboolean emit;
   gint width, height;
 } VideoDimensionsChangedSignalData;
 
@@ -1209,8 +2215,12 @@ video_dimensions_changed_dispatch (gpointer user_data)
   VideoDimensionsChangedSignalData *data = user_data;
 
   if (data->player->target_state >= GST_STATE_PAUSED) {
-    g_signal_emit (data->player, signals[SIGNAL_VIDEO_DIMENSIONS_CHANGED], 0,
-        data->width, data->height);
+    if (data->callbacks)
+      data->callbacks->callbacks.video_dimensions_changed (data->player,
+          data->width, data->height, data->callbacks->user_data);
+    if (data->emit)
+      g_signal_emit (data->player, signals[SIGNAL_VIDEO_DIMENSIONS_CHANGED], 0,
+          data->width, data->height);
   }
 }
 
@@ -1219,6 +2229,8 @@ video_dimensions_changed_signal_data_free (VideoDimensionsChangedSignalData *
     data)
 {
   g_object_unref (data->player);
+  if (data->callbacks)
+    player_callbacks_unref (data->callbacks);
   g_free (data);
 }
 
@@ -1230,8 +2242,14 @@ check_video_dimensions_changed (GstPlayer * self)
   GstCaps *caps;
   GstVideoInfo info;
   gint width = 0, height = 0;
+  PlayerCallbacks *callbacks;
+  gboolean emit;
 
-  g_object_get (self->playbin, "video-sink", &video_sink, NULL);
+  /* The sink gets the video scaled to the target size, if any */
+  if (self->viewport_scale)
+    video_sink = gst_object_ref (self->viewport_scale);
+  else
+    g_object_get (self->playbin, "video-sink", &video_sink, NULL);
   if (!video_sink)
     goto out;
 
@@ -1259,12 +2277,15 @@ check_video_dimensions_changed (GstPlayer * self)
   gst_object_unref (video_sink);
 
 out:
-  if (g_signal_handler_find (self, G_SIGNAL_MATCH_ID,
-          signals[SIGNAL_VIDEO_DIMENSIONS_CHANGED], 0, NULL, NULL, NULL) != 0) {
+  callbacks = get_callbacks (self, video_dimensions_changed);
+  emit = has_handler (self, SIGNAL_VIDEO_DIMENSIONS_CHANGED);
+  if (callbacks || emit) {
     VideoDimensionsChangedSignalData *data =
         g_new (VideoDimensionsChangedSignalData, 1);
 
     data->player = g_object_ref (self);
+    data->callbacks = callbacks;
+    data->emit = emit;
     data->width = width;
     data->height = height;
     gst_player_signal_dispatcher_dispatch (self->signal_dispatcher, self,
@@ -1328,6 +2349,8 @@ emit_duration_changed (GstPlayer * self, GstClockTime duration)
 typedef struct
 {
   GstPlayer *player;
+  PlayerCallbacks *callbacks;
+  gboolean emit;
   GstClockTime position;
 } SeekDoneSignalData;
 
@@ -1336,2477 +2359,6994 @@ seek_done_dispatch (gpointer user_data)
 {
   SeekDoneSignalData *data = user_data;
 
-  g_signal_emit (data->player, signals[SIGNAL_SEEK_DONE], 0, data->position);
+  if (data->callbacks)
+    data->callbacks->callbacks.seek_done (data->player, data->position,
+        data->callbacks->user_data);
+  if (data->emit)
+    g_signal_emit (data->player, signals[SIGNAL_SEEK_DONE], 0,
+        data->position);
 }
 
 static void
 seek_done_signal_data_free (SeekDoneSignalData * data)
 {
   g_object_unref (data->player);
+  if (data->callbacks)
+    player_callbacks_unref (data->callbacks);
   g_free (data);
 }
 
+/* Called with lock */
 static void
 emit_seek_done (GstPlayer * self)
 {
-  if (g_signal_handler_find (self, G_SIGNAL_MATCH_ID,
-          signals[SIGNAL_SEEK_DONE], 0, NULL, NULL, NULL) != 0) {
+  PlayerCallbacks *callbacks = NULL;
+  gboolean emit;
+
+  if (self->callbacks && self->callbacks->callbacks.seek_done)
+    callbacks = player_callbacks_ref (self->callbacks);
+  emit = has_handler (self, SIGNAL_SEEK_DONE);
+  if (callbacks || emit) {
     SeekDoneSignalData *data = g_new (SeekDoneSignalData, 1);
 
     data->player = g_object_ref (self);
+    data->callbacks = callbacks;
+    data->emit = emit;
     data->position = gst_player_get_position (self);
     gst_player_signal_dispatcher_dispatch (self->signal_dispatcher, self,
         seek_done_dispatch, data, (GDestroyNotify) seek_done_signal_data_free);
   }
 }
 
+typedef struct
+{
+  GstPlayer *player;
+  GstPlayerDegradationLevel level;
+} DegradationLevelChangedSignalData;
+
 static void
-state_changed_cb (GstBus * bus, GstMessage * msg, gpointer user_data)
+degradation_level_changed_dispatch (gpointer user_data)
 {
-  GstPlayer *self = GST_PLAYER (user_data);
-  GstState old_state, new_state, pending_state;
+  DegradationLevelChangedSignalData *data = user_data;
 
-  gst_message_parse_state_changed (msg, &old_state, &new_state, &pending_state);
+  g_signal_emit (data->player, signals[SIGNAL_DEGRADATION_LEVEL_CHANGED], 0,
+      data->level);
+}
 
-  if (GST_MESSAGE_SRC (msg) == GST_OBJECT (self->playbin)) {
-    gchar *transition_name;
+static void
+degradation_level_changed_signal_data_free (DegradationLevelChangedSignalData
+    * data)
+{
+  g_object_unref (data->player);
+  g_free (data);
+}
 
-    GST_DEBUG_OBJECT (self, "Changed state old: %s new: %s pending: %s",
-        gst_element_state_get_name (old_state),
-        gst_element_state_get_name (new_state),
-        gst_element_state_get_name (pending_state));
+static void
+set_decoder_property (GstElement * decoder, const gchar * name, gint value)
+{
+  GParamSpec *pspec;
 
-    transition_name = g_strdup_printf ("%s_%s",
-        gst_element_state_get_name (old_state),
-        gst_element_state_get_name (new_state));
-    dump_dot_file (self, transition_name);
-    g_free (transition_name);
+  pspec = g_object_class_find_property (G_OBJECT_GET_CLASS (decoder), name);
+  if (!pspec || !(pspec->flags & G_PARAM_WRITABLE))
+    return;
 
-    self->current_state = new_state;
+  if (G_PARAM_SPEC_VALUE_TYPE (pspec) == G_TYPE_BOOLEAN)
+    g_object_set (decoder, name, value != 0, NULL);
+  else if (G_PARAM_SPEC_VALUE_TYPE (pspec) == G_TYPE_INT
+      || G_PARAM_SPEC_VALUE_TYPE (pspec) == G_TYPE_UINT
+      || G_IS_PARAM_SPEC_ENUM (pspec))
+    g_object_set (decoder, name, value, NULL);
+}
 
-    if (old_state == GST_STATE_READY && new_state == GST_STATE_PAUSED
-        && pending_state == GST_STATE_VOID_PENDING) {
-      GstElement *video_sink;
-      GstPad *video_sink_pad;
-      gint64 duration = -1;
+static gboolean
+has_decoder_property (GstElement * decoder, const gchar * name)
+{
+  GParamSpec *pspec;
 
-      GST_DEBUG_OBJECT (self, "Initial PAUSED - pre-rolled");
+  pspec = g_object_class_find_property (G_OBJECT_GET_CLASS (decoder), name);
 
-      g_mutex_lock (&self->lock);
-      if (self->media_info)
-        g_object_unref (self->media_info);
-      self->media_info = gst_player_media_info_create (self);
-      g_mutex_unlock (&self->lock);
-      emit_media_info_updated_signal (self);
+  return pspec && (pspec->flags & G_PARAM_WRITABLE);
+}
 
-      g_object_get (self->playbin, "video-sink", &video_sink, NULL);
+/* Called with lock. Whether @level changes anything for the current
+ * decoder. Reduced resolution downscales in the viewport scaler, which
+ * only exists with a renderer that has a target size; libav's "lowres"
+ * is ignored by H.264 and only read when the decoder opens. Keyframes-only
+ * is handled by keyframes_only_probe_cb() and works with every decoder */
+static gboolean
+degradation_level_supported_locked (GstPlayer * self,
+    GstPlayerDegradationLevel level)
+{
+  switch (level) {
+    case GST_PLAYER_DEGRADATION_SKIP_LOOP_FILTER:
+      return self->video_decoder
+          && has_decoder_property (self->video_decoder, "skip-loop-filter");
+    case GST_PLAYER_DEGRADATION_DROP_NON_REFERENCE:
+      return self->video_decoder
+          && has_decoder_property (self->video_decoder, "skip-frame");
+    case GST_PLAYER_DEGRADATION_REDUCED_RESOLUTION:
+      return self->viewport_filter != NULL;
+    default:
+      return TRUE;
+  }
+}
 
-      if (video_sink) {
-        video_sink_pad = gst_element_get_static_pad (video_sink, "sink");
+/* Called with lock. The next level in @direction that has an effect */
+static GstPlayerDegradationLevel
+next_degradation_level_locked (GstPlayer * self,
+    GstPlayerDegradationLevel level, gint direction)
+{
+  do
+    level += direction;
+  while (!degradation_level_supported_locked (self, level));
 
-        if (video_sink_pad) {
-          g_signal_connect (video_sink_pad, "notify::caps",
-              (GCallback) notify_caps_cb, self);
-          gst_object_unref (video_sink_pad);
-        }
-        gst_object_unref (video_sink);
-      }
+  return level;
+}
 
-      check_video_dimensions_changed (self);
-      gst_element_query_duration (self->playbin, GST_FORMAT_TIME, &duration);
-      emit_duration_changed (self, duration);
-    }
+/* Configures @decoder for @level */
+static void
+apply_degradation_level (GstElement * decoder, GstPlayerDegradationLevel level)
+{
+  set_decoder_property (decoder, "skip-loop-filter",
+      level >= GST_PLAYER_DEGRADATION_SKIP_LOOP_FILTER);
+  /* 1 is "Skip B-frames" for the libav decoders */
+  set_decoder_property (decoder, "skip-frame",
+      level >= GST_PLAYER_DEGRADATION_DROP_NON_REFERENCE ? 1 : 0);
+}
 
-    if (new_state == GST_STATE_PAUSED
-        && pending_state == GST_STATE_VOID_PENDING) {
-      remove_tick_source (self);
+static GstPadProbeReturn
+keyframes_only_probe_cb (GstPad * pad, GstPadProbeInfo * info,
+    gpointer user_data)
+{
+  GstPlayer *self = GST_PLAYER (user_data);
+  GstBuffer *buffer = GST_PAD_PROBE_INFO_BUFFER (info);
+  gboolean delta = GST_BUFFER_FLAG_IS_SET (buffer, GST_BUFFER_FLAG_DELTA_UNIT);
 
-      g_mutex_lock (&self->lock);
-      if (self->seek_pending) {
-        self->seek_pending = FALSE;
+  if (g_atomic_int_get (&self->drop_delta_units)) {
+    g_atomic_int_set (&self->wait_keyframe, TRUE);
+    return delta ? GST_PAD_PROBE_DROP : GST_PAD_PROBE_OK;
+  }
 
-        if (!self->media_info->seekable) {
-          GST_DEBUG_OBJECT (self, "Media is not seekable");
-          if (self->seek_source) {
-            g_source_destroy (self->seek_source);
-            g_source_unref (self->seek_source);
-            self->seek_source = NULL;
-          }
-          self->seek_position = GST_CLOCK_TIME_NONE;
-          self->last_seek_time = GST_CLOCK_TIME_NONE;
-        } else if (self->seek_source) {
-          GST_DEBUG_OBJECT (self, "Seek finished but new seek is pending");
-          gst_player_seek_internal_locked (self);
-        } else {
-          GST_DEBUG_OBJECT (self, "Seek finished");
-          emit_seek_done (self);
-        }
-      }
+  /* After dropping, delta units can only be decoded again from the next
+   * keyframe on */
+  if (g_atomic_int_get (&self->wait_keyframe)) {
+    if (delta)
+      return GST_PAD_PROBE_DROP;
+    g_atomic_int_set (&self->wait_keyframe, FALSE);
+  }
 
-      if (self->seek_position != GST_CLOCK_TIME_NONE) {
-        GST_DEBUG_OBJECT (self, "Seeking now that we reached PAUSED state");
-        gst_player_seek_internal_locked (self);
-        g_mutex_unlock (&self->lock);
-      } else if (!self->seek_pending) {
-        g_mutex_unlock (&self->lock);
+  return GST_PAD_PROBE_OK;
+}
 
-        tick_cb (self);
+static gboolean degradation_recover_cb (gpointer user_data);
 
-        if (self->target_state >= GST_STATE_PLAYING && self->buffering == 100) {
-          GstStateChangeReturn state_ret;
+/* Must be called from main context */
+static void
+set_degradation_level (GstPlayer * self, GstPlayerDegradationLevel level)
+{
+  GstClockTime now = gst_util_get_timestamp ();
+  GstElement *decoder = NULL;
+  GstCaps *viewport_caps = NULL;
+  gboolean reduce;
 
-          state_ret = gst_element_set_state (self->playbin, GST_STATE_PLAYING);
-          if (state_ret == GST_STATE_CHANGE_FAILURE)
-            emit_error (self, g_error_new (GST_PLAYER_ERROR,
-                    GST_PLAYER_ERROR_FAILED, "Failed to play"));
-        } else if (self->buffering == 100) {
-          change_state (self, GST_PLAYER_STATE_PAUSED);
-        }
-      } else {
-        g_mutex_unlock (&self->lock);
-      }
-    } else if (new_state == GST_STATE_PLAYING
-        && pending_state == GST_STATE_VOID_PENDING) {
+  g_mutex_lock (&self->lock);
+  if (self->degradation_level == level) {
+    g_mutex_unlock (&self->lock);
+    return;
+  }
 
-      /* If no seek is currently pending, add the tick source. This can happen
-       * if we seeked already but the state-change message was still queued up */
-      if (!self->seek_pending) {
-        add_tick_source (self);
-        change_state (self, GST_PLAYER_STATE_PLAYING);
-      }
-    } else if (new_state == GST_STATE_READY && old_state > GST_STATE_READY) {
-      change_state (self, GST_PLAYER_STATE_STOPPED);
-    } else {
-      /* Otherwise we neither reached PLAYING nor PAUSED, so must
-       * wait for something to happen... i.e. are BUFFERING now */
-      change_state (self, GST_PLAYER_STATE_BUFFERING);
-    }
+  GST_INFO_OBJECT (self, "Degradation level %s -> %s",
+      gst_player_degradation_level_get_name (self->degradation_level),
+      gst_player_degradation_level_get_name (level));
+
+  if (GST_CLOCK_TIME_IS_VALID (self->degradation_since))
+    self->degradation_time[self->degradation_level] +=
+        now - self->degradation_since;
+  reduce = (self->degradation_level >=
+      GST_PLAYER_DEGRADATION_REDUCED_RESOLUTION) !=
+      (level >= GST_PLAYER_DEGRADATION_REDUCED_RESOLUTION);
+  self->degradation_level = level;
+  self->degradation_since = now;
+  if (self->video_decoder)
+    decoder = gst_object_ref (self->video_decoder);
+  if (reduce && self->viewport_filter)
+    viewport_caps = get_viewport_caps_locked (self);
+  g_mutex_unlock (&self->lock);
+
+  g_atomic_int_set (&self->drop_delta_units,
+      level >= GST_PLAYER_DEGRADATION_KEYFRAMES_ONLY);
+  if (decoder) {
+    apply_degradation_level (decoder, level);
+    gst_object_unref (decoder);
+  }
+  /* The capsfilter makes the scaler renegotiate */
+  if (viewport_caps) {
+    g_object_set (self->viewport_filter, "caps", viewport_caps, NULL);
+    gst_caps_unref (viewport_caps);
   }
-}
 
-static void
-duration_changed_cb (GstBus * bus, GstMessage * msg, gpointer user_data)
-{
-  GstPlayer *self = GST_PLAYER (user_data);
-  gint64 duration;
+  if (level > GST_PLAYER_DEGRADATION_NONE && !self->recover_source) {
+    self->recover_source = g_timeout_source_new_seconds (1);
+    g_source_set_callback (self->recover_source,
+        (GSourceFunc) degradation_recover_cb, self, NULL);
+    g_source_attach (self->recover_source, self->context);
+  } else if (level == GST_PLAYER_DEGRADATION_NONE && self->recover_source) {
+    g_source_destroy (self->recover_source);
+    g_source_unref (self->recover_source);
+    self->recover_source = NULL;
+  }
 
-  if (gst_element_query_duration (self->playbin, GST_FORMAT_TIME, &duration)) {
-    emit_duration_changed (self, duration);
+  if (g_signal_handler_find (self, G_SIGNAL_MATCH_ID,
+          signals[SIGNAL_DEGRADATION_LEVEL_CHANGED], 0, NULL, NULL,
+          NULL) != 0) {
+    DegradationLevelChangedSignalData *data =
+        g_new (DegradationLevelChangedSignalData, 1);
+
+    data->player = g_object_ref (self);
+    data->level = level;
+    gst_player_signal_dispatcher_dispatch (self->signal_dispatcher, self,
+        degradation_level_changed_dispatch, data,
+        (GDestroyNotify) degradation_level_changed_signal_data_free);
   }
 }
 
-static void
-latency_cb (GstBus * bus, GstMessage * msg, gpointer user_data)
+static gboolean
+degradation_recover_cb (gpointer user_data)
 {
   GstPlayer *self = GST_PLAYER (user_data);
+  GstClockTime now = gst_util_get_timestamp ();
+  GstPlayerDegradationLevel level;
+  gboolean recover;
 
-  GST_DEBUG_OBJECT (self, "Latency changed");
+  g_mutex_lock (&self->lock);
+  level = self->degradation_level;
+  recover = level > GST_PLAYER_DEGRADATION_NONE
+      && now - self->degradation_since >= QOS_RECOVER_INTERVAL
+      && (!GST_CLOCK_TIME_IS_VALID (self->last_overload)
+      || now - self->last_overload >= QOS_RECOVER_INTERVAL);
+  if (recover)
+    level = next_degradation_level_locked (self, level, -1);
+  g_mutex_unlock (&self->lock);
 
-  gst_bin_recalculate_latency (GST_BIN (self->playbin));
+  /* Step up one level at a time, each has to be stable for a while */
+  if (recover)
+    set_degradation_level (self, level);
+
+  return G_SOURCE_CONTINUE;
 }
 
 static void
-request_state_cb (GstBus * bus, GstMessage * msg, gpointer user_data)
+qos_cb (GstBus * bus, GstMessage * msg, gpointer user_data)
 {
   GstPlayer *self = GST_PLAYER (user_data);
-  GstState state;
-  GstStateChangeReturn state_ret;
+  GstClockTime now = gst_util_get_timestamp ();
+  GstPlayerDegradationLevel level;
+  const gchar *klass;
+  gint64 jitter;
+  gdouble proportion;
+  gint quality;
+  gboolean enabled, degrade;
+
+  if (!GST_IS_ELEMENT (GST_MESSAGE_SRC (msg)))
+    return;
 
-  gst_message_parse_request_state (msg, &state);
+  klass = gst_element_class_get_metadata (GST_ELEMENT_GET_CLASS
+      (GST_MESSAGE_SRC (msg)), GST_ELEMENT_METADATA_KLASS);
+  if (!klass || !strstr (klass, "Video"))
+    return;
 
-  GST_DEBUG_OBJECT (self, "State %s requested",
-      gst_element_state_get_name (state));
+  gst_message_parse_qos_values (msg, &jitter, &proportion, &quality);
 
-  self->target_state = state;
-  state_ret = gst_element_set_state (self->playbin, state);
-  if (state_ret == GST_STATE_CHANGE_FAILURE)
-    emit_error (self, g_error_new (GST_PLAYER_ERROR, GST_PLAYER_ERROR_FAILED,
-            "Failed to change to requested state %s",
-            gst_element_state_get_name (state)));
+  GST_LOG_OBJECT (self, "QoS from %s: jitter %" G_GINT64_FORMAT
+      " proportion %lf", GST_MESSAGE_SRC_NAME (msg), jitter, proportion);
+
+  if (proportion < QOS_OVERLOAD_PROPORTION && jitter < QOS_OVERLOAD_JITTER) {
+    self->n_overloaded = 0;
+    return;
+  }
+
+  self->n_overloaded++;
+
+  g_mutex_lock (&self->lock);
+  self->last_overload = now;
+  enabled = self->degradation_enabled;
+  level = self->degradation_level;
+  degrade = enabled && level < GST_PLAYER_DEGRADATION_KEYFRAMES_ONLY
+      && self->n_overloaded >= QOS_OVERLOAD_COUNT
+      && (!GST_CLOCK_TIME_IS_VALID (self->degradation_since)
+      || level == GST_PLAYER_DEGRADATION_NONE
+      || now - self->degradation_since >= QOS_DEGRADE_INTERVAL);
+  /* Levels without effect would only delay the next useful step */
+  if (degrade)
+    level = next_degradation_level_locked (self, level, 1);
+  g_mutex_unlock (&self->lock);
+
+  if (degrade) {
+    self->n_overloaded = 0;
+    set_degradation_level (self, level);
+  }
 }
 
-static void
-media_info_update (GstPlayer * self, GstPlayerMediaInfo * info)
+static gboolean
+gst_player_reset_degradation_internal (gpointer user_data)
 {
-  if (info->title)
-    g_free (info->title);
-  info->title = get_from_tags (self, info, get_title);
-
-  if (info->container)
-    g_free (info->container);
-  info->container = get_from_tags (self, info, get_container_format);
+  GstPlayer *self = GST_PLAYER (user_data);
 
-  if (info->image_sample)
-    gst_sample_unref (info->image_sample);
-  info->image_sample = get_from_tags (self, info, get_cover_sample);
+  self->n_overloaded = 0;
+  set_degradation_level (self, GST_PLAYER_DEGRADATION_NONE);
+  g_atomic_int_set (&self->wait_keyframe, FALSE);
 
-  GST_DEBUG_OBJECT (self, "title: %s, container: %s "
-      "image_sample: %p", info->title, info->container, info->image_sample);
+  return G_SOURCE_REMOVE;
 }
 
-static void
-tags_cb (GstBus * bus, GstMessage * msg, gpointer user_data)
+static gboolean
+gst_player_set_restream_internal (gpointer user_data)
 {
   GstPlayer *self = GST_PLAYER (user_data);
-  GstTagList *tags = NULL;
+  GstPlayerRestream *old = NULL, *restream = NULL;
+  GError *err = NULL;
+  gchar *path;
+  guint port;
 
-  gst_message_parse_tag (msg, &tags);
+  g_mutex_lock (&self->lock);
+  port = self->restream_port;
+  path = g_strdup (self->restream_path);
+  if (self->restream
+      && gst_player_restream_is_configured (self->restream, port, path)) {
+    g_mutex_unlock (&self->lock);
+    g_free (path);
+    return G_SOURCE_REMOVE;
+  }
+  old = self->restream;
+  self->restream = NULL;
+  g_mutex_unlock (&self->lock);
 
-  /*
-   * NOTE: Inorder to get global tag you must apply the following patches in
-   * your gstreamer build.
-   *
-   * http://cgit.freedesktop.org/gstreamer/gst-plugins-good/commit/?id=9119fbd774093e3ae762c8652acd80d54b2c3b45
-   * http://cgit.freedesktop.org/gstreamer/gstreamer/commit/?id=18b058100940bdcaed86fa412e3582a02871f995
-   */
-  GST_DEBUG_OBJECT (self, "recieved %s tags",
-      gst_tag_list_get_scope (tags) ==
-      GST_TAG_SCOPE_GLOBAL ? "global" : "stream");
+  /* Streaming threads still pushing into it only hold a reference */
+  gst_player_restream_free (old);
 
-  if (gst_tag_list_get_scope (tags) == GST_TAG_SCOPE_GLOBAL) {
-    g_mutex_lock (&self->lock);
-    if (self->media_info) {
-      if (self->media_info->tags)
-        gst_tag_list_unref (self->media_info->tags);
-      self->media_info->tags = gst_tag_list_ref (tags);
-      media_info_update (self, self->media_info);
-      g_mutex_unlock (&self->lock);
-      emit_media_info_updated_signal (self);
-    } else {
-      if (self->global_tags)
-        gst_tag_list_unref (self->global_tags);
-      self->global_tags = gst_tag_list_ref (tags);
-      g_mutex_unlock (&self->lock);
+  if (port != 0) {
+    restream = gst_player_restream_new (self->context, port, path, &err);
+    if (!restream) {
+      emit_warning (self, g_error_new (GST_PLAYER_ERROR,
+              GST_PLAYER_ERROR_FAILED, "Can't restream on port %u: %s", port,
+              err ? err->message : "unknown error"));
+      g_clear_error (&err);
     }
   }
+  g_free (path);
 
-  gst_tag_list_unref (tags);
+  g_mutex_lock (&self->lock);
+  self->restream = restream;
+  g_mutex_unlock (&self->lock);
+
+  return G_SOURCE_REMOVE;
 }
 
 static void
-element_cb (GstBus * bus, GstMessage * msg, gpointer user_data)
+segment_done_cb (GstBus * bus, GstMessage * msg, gpointer user_data)
 {
   GstPlayer *self = GST_PLAYER (user_data);
-  const GstStructure *s;
+  GstSeekFlags flags = GST_SEEK_FLAG_NONE;
+  GstClockTime loop_start, loop_stop;
+  GstEvent *s_event;
+  GstFormat format;
+  gint64 position;
+  gdouble rate;
 
-  s = gst_message_get_structure (msg);
-  if (gst_structure_has_name (s, "redirect")) {
-    const gchar *new_location;
+  gst_message_parse_segment_done (msg, &format, &position);
 
-    new_location = gst_structure_get_string (s, "new-location");
-    if (!new_location) {
-      const GValue *locations_list, *location_val;
-      guint i, size;
+  g_mutex_lock (&self->lock);
+  loop_start = self->loop_start;
+  loop_stop = self->loop_stop;
+  rate = self->applied_rate;
+  if (GST_CLOCK_TIME_IS_VALID (loop_stop))
+    self->n_loops++;
+  g_mutex_unlock (&self->lock);
 
-      locations_list = gst_structure_get_value (s, "locations");
-      size = gst_value_list_get_size (locations_list);
-      for (i = 0; i < size; ++i) {
-        const GstStructure *location_s;
+#if GST_CHECK_VERSION(1,5,0)
+  if (rate != 1.0) {
+    flags |= GST_SEEK_FLAG_TRICKMODE;
+  }
+#endif
 
-        location_val = gst_value_list_get_value (locations_list, i);
-        if (!GST_VALUE_HOLDS_STRUCTURE (location_val))
-          continue;
+  /* Non-flushing, the next iteration is queued right behind the current
+   * one without prerolling again */
+  if (GST_CLOCK_TIME_IS_VALID (loop_stop)) {
+    GST_DEBUG_OBJECT (self, "Looping %" GST_TIME_FORMAT " - %"
+        GST_TIME_FORMAT, GST_TIME_ARGS (loop_start),
+        GST_TIME_ARGS (loop_stop));
+    s_event = gst_event_new_seek (rate, GST_FORMAT_TIME,
+        flags | GST_SEEK_FLAG_SEGMENT, GST_SEEK_TYPE_SET, loop_start,
+        GST_SEEK_TYPE_SET, loop_stop);
+  } else if (format != GST_FORMAT_TIME) {
+    return;
+  } else if (rate >= 0.0) {
+    /* The loop was removed meanwhile */
+    s_event = gst_event_new_seek (rate, GST_FORMAT_TIME, flags,
+        GST_SEEK_TYPE_SET, position, GST_SEEK_TYPE_SET, GST_CLOCK_TIME_NONE);
+  } else {
+    s_event = gst_event_new_seek (rate, GST_FORMAT_TIME, flags,
+        GST_SEEK_TYPE_SET, G_GINT64_CONSTANT (0), GST_SEEK_TYPE_SET, position);
+  }
 
-        location_s = (const GstStructure *) g_value_get_boxed (location_val);
-        if (!gst_structure_has_name (location_s, "redirect"))
-          continue;
+  if (!gst_element_send_event (self->playbin, s_event))
+    GST_WARNING_OBJECT (self, "Failed to continue after segment-done");
+}
 
-        new_location = gst_structure_get_string (location_s, "new-location");
-        if (new_location)
-          break;
-      }
-    }
+/* Caps of the sink playsink would pick if none is set */
+static GstCaps *
+get_default_sink_caps (GstElementFactoryListType type)
+{
+  GstElementFactory *factory;
+  GstCaps *caps = NULL;
+  GList *factories;
+  const GList *l;
 
-    if (new_location) {
-      GstState target_state;
+  factories = gst_element_factory_list_get_elements (type, GST_RANK_MARGINAL);
+  factories = g_list_sort (factories, gst_plugin_feature_rank_compare_func);
+  if (!factories)
+    return NULL;
 
-      GST_DEBUG_OBJECT (self, "Redirect to '%s'", new_location);
+  factory = factories->data;
+  for (l = gst_element_factory_get_static_pad_templates (factory); l;
+      l = l->next) {
+    GstStaticPadTemplate *templ = l->data;
 
-      /* Remember target state and restore after setting the URI */
-      target_state = self->target_state;
+    if (templ->direction == GST_PAD_SINK) {
+      caps = gst_static_pad_template_get_caps (templ);
+      break;
+    }
+  }
+  gst_plugin_feature_list_free (factories);
 
-      g_mutex_lock (&self->lock);
-      if (self->uri)
-        g_free (self->uri);
+  return caps;
+}
 
-      self->uri = g_strdup (new_location);
-      g_mutex_unlock (&self->lock);
+/* Raw caps the sink accepts in its order of preference, or NULL if it
+ * takes anything */
+static GstCaps *
+get_sink_caps (GstPlayer * self, const gchar * property,
+    GstElementFactoryListType type, const gchar * media_type)
+{
+  GstElement *sink;
+  GstCaps *caps = NULL, *raw;
+  GstPad *pad;
+  guint i;
+
+  g_object_get (self->playbin, property, &sink, NULL);
+  if (sink) {
+    pad = gst_element_get_static_pad (sink, "sink");
+    if (pad) {
+      caps = gst_pad_query_caps (pad, NULL);
+      gst_object_unref (pad);
+    }
+    gst_object_unref (sink);
+  } else {
+    caps = get_default_sink_caps (GST_ELEMENT_FACTORY_TYPE_SINK | type);
+  }
 
-      gst_player_set_uri_internal (self);
+  if (!caps)
+    return NULL;
 
-      if (target_state == GST_STATE_PAUSED)
-        gst_player_pause_internal (self);
-      else if (target_state == GST_STATE_PLAYING)
-        gst_player_play_internal (self);
+  raw = gst_caps_new_empty ();
+  if (!gst_caps_is_any (caps)) {
+    for (i = 0; i < gst_caps_get_size (caps); i++) {
+      GstStructure *s = gst_caps_get_structure (caps, i);
+
+      if (gst_structure_has_name (s, media_type))
+        gst_caps_append_structure_full (raw, gst_structure_copy (s),
+            gst_caps_features_copy (gst_caps_get_features (caps, i)));
     }
   }
+  gst_caps_unref (caps);
+
+  if (gst_caps_is_empty (raw)) {
+    gst_caps_unref (raw);
+    return NULL;
+  }
+
+  return raw;
 }
 
+/* Must be called from main context whenever a sink was set */
 static void
-player_set_flag (GstPlayer * self, gint pos)
+update_sink_caps (GstPlayer * self)
 {
-  gint flags;
+  GstCaps *audio_caps, *video_caps;
 
-  g_object_get (self->playbin, "flags", &flags, NULL);
-  flags |= pos;
-  g_object_set (self->playbin, "flags", flags, NULL);
+  audio_caps = get_sink_caps (self, "audio-sink",
+      GST_ELEMENT_FACTORY_TYPE_MEDIA_AUDIO, "audio/x-raw");
+  video_caps = get_sink_caps (self, "video-sink",
+      GST_ELEMENT_FACTORY_TYPE_MEDIA_VIDEO, "video/x-raw");
 
-  GST_DEBUG_OBJECT (self, "setting flags=%#x", flags);
+  GST_DEBUG_OBJECT (self, "Audio sink caps %" GST_PTR_FORMAT, audio_caps);
+  GST_DEBUG_OBJECT (self, "Video sink caps %" GST_PTR_FORMAT, video_caps);
+
+  g_mutex_lock (&self->lock);
+  gst_caps_replace (&self->audio_sink_caps, audio_caps);
+  gst_caps_replace (&self->video_sink_caps, video_caps);
+  g_mutex_unlock (&self->lock);
+
+  if (audio_caps)
+    gst_caps_unref (audio_caps);
+  if (video_caps)
+    gst_caps_unref (video_caps);
 }
 
-static void
-player_clear_flag (GstPlayer * self, gint pos)
+static gboolean
+update_sink_caps_internal (gpointer user_data)
 {
-  gint flags;
-
-  g_object_get (self->playbin, "flags", &flags, NULL);
-  flags &= ~pos;
-  g_object_set (self->playbin, "flags", flags, NULL);
+  update_sink_caps (GST_PLAYER (user_data));
 
-  GST_DEBUG_OBJECT (self, "setting flags=%#x", flags);
+  return G_SOURCE_REMOVE;
 }
 
-typedef struct
+/* Sinks can also be set on the pipeline by the application */
+static void
+sink_notify_cb (GObject * object, GParamSpec * pspec, gpointer user_data)
 {
-  GstPlayer *player;
-  GstPlayerMediaInfo *info;
-} MediaInfoUpdatedSignalData;
+  GstPlayer *self = GST_PLAYER (user_data);
 
-static void
-media_info_updated_dispatch (gpointer user_data)
+  g_main_context_invoke_full (self->context, G_PRIORITY_DEFAULT,
+      update_sink_caps_internal, self, NULL);
+}
+
+/* Puts the formats the sink takes directly first in the answer to the caps
+ * query of a decoder. Decoders pick the first format they can output, so
+ * playsink's converters run in passthrough */
+static GstPadProbeReturn
+native_format_probe_cb (GstPad * pad, GstPadProbeInfo * info,
+    gpointer user_data)
 {
-  MediaInfoUpdatedSignalData *data = user_data;
+  GstPlayer *self = GST_PLAYER (user_data);
+  GstQuery *query = GST_PAD_PROBE_INFO_QUERY (info);
+  GstCaps *result, *sink_caps = NULL, *preferred;
+  const gchar *name;
 
-  if (data->player->target_state >= GST_STATE_PAUSED) {
-    g_signal_emit (data->player, signals[SIGNAL_MEDIA_INFO_UPDATED], 0,
-        data->info);
+  if (GST_QUERY_TYPE (query) != GST_QUERY_CAPS)
+    return GST_PAD_PROBE_OK;
+
+  gst_query_parse_caps_result (query, &result);
+  if (!result || gst_caps_is_any (result) || gst_caps_is_empty (result))
+    return GST_PAD_PROBE_OK;
+
+  name = gst_structure_get_name (gst_caps_get_structure (result, 0));
+  g_mutex_lock (&self->lock);
+  if (g_str_has_prefix (name, "audio/") && self->audio_sink_caps)
+    sink_caps = gst_caps_ref (self->audio_sink_caps);
+  else if (g_str_has_prefix (name, "video/") && self->video_sink_caps)
+    sink_caps = gst_caps_ref (self->video_sink_caps);
+  g_mutex_unlock (&self->lock);
+
+  if (!sink_caps)
+    return GST_PAD_PROBE_OK;
+
+  preferred = gst_caps_intersect_full (sink_caps, result,
+      GST_CAPS_INTERSECT_FIRST);
+  gst_caps_unref (sink_caps);
+
+  if (gst_caps_is_empty (preferred)) {
+    gst_caps_unref (preferred);
+    return GST_PAD_PROBE_OK;
   }
+
+  /* Everything else stays possible, converted as before */
+  preferred = gst_caps_merge (preferred, gst_caps_ref (result));
+  GST_LOG_OBJECT (pad, "Preferring %" GST_PTR_FORMAT, preferred);
+  gst_query_set_caps_result (query, preferred);
+  gst_caps_unref (preferred);
+
+  return GST_PAD_PROBE_OK;
 }
 
 static void
-free_media_info_updated_signal_data (MediaInfoUpdatedSignalData * data)
+add_native_format_probe (GstPlayer * self, GstElement * decoder)
 {
-  g_object_unref (data->player);
-  g_object_unref (data->info);
-  g_free (data);
+  GstPad *pad = gst_element_get_static_pad (decoder, "src");
+
+  if (!pad)
+    return;
+
+  /* The decoder queries its peer through this pad, downstream. Called with
+   * the result of the query */
+  gst_pad_add_probe (pad,
+      GST_PAD_PROBE_TYPE_QUERY_DOWNSTREAM | GST_PAD_PROBE_TYPE_PULL,
+      native_format_probe_cb, self, NULL);
+  gst_object_unref (pad);
 }
 
-/*
- * emit_media_info_updated_signal:
- *
- * create a new copy of self->media_info object and emits the newly created
- * copy to user application. The newly created media_info will be unref'ed
- * as part of signal finalize method.
- */
-static void
-emit_media_info_updated_signal (GstPlayer * self)
+typedef struct
 {
-  MediaInfoUpdatedSignalData *data = g_new (MediaInfoUpdatedSignalData, 1);
-  data->player = g_object_ref (self);
+  GstPlayer *player;
+  guint index;
+  GstClockTime start;           /* Only used from the streaming thread */
+} ConversionProbeData;
+
+static GstPadProbeReturn
+conversion_start_probe_cb (GstPad * pad, GstPadProbeInfo * info,
+    gpointer user_data)
+{
+  ConversionProbeData *data = user_data;
+
+  data->start = gst_util_get_timestamp ();
+
+  return GST_PAD_PROBE_OK;
+}
+
+static GstPadProbeReturn
+conversion_end_probe_cb (GstPad * pad, GstPadProbeInfo * info,
+    gpointer user_data)
+{
+  ConversionProbeData *data = user_data;
+  GstPlayer *self = data->player;
+  GstClockTime now = gst_util_get_timestamp ();
+  gsize size;
+
   g_mutex_lock (&self->lock);
-  data->info = gst_player_media_info_copy (self->media_info);
+  if (GST_CLOCK_TIME_IS_VALID (data->start)) {
+    self->conversion_time[data->index] += now - data->start;
+    self->n_converted[data->index]++;
+    data->start = GST_CLOCK_TIME_NONE;
+  }
+
+  /* What the video sink has to upload */
+  if (data->index == 1) {
+    size = gst_buffer_get_size (GST_PAD_PROBE_INFO_BUFFER (info));
+    self->sink_bytes += size;
+    self->sink_rate_bytes += size;
+    if (!GST_CLOCK_TIME_IS_VALID (self->sink_rate_start)) {
+      self->sink_rate_start = now;
+    } else if (now - self->sink_rate_start >= GST_SECOND) {
+      self->sink_byte_rate = gst_util_uint64_scale (self->sink_rate_bytes,
+          GST_SECOND, now - self->sink_rate_start);
+      self->sink_rate_start = now;
+      self->sink_rate_bytes = 0;
+    }
+  }
   g_mutex_unlock (&self->lock);
 
-  gst_player_signal_dispatcher_dispatch (self->signal_dispatcher, self,
-      media_info_updated_dispatch, data,
-      (GDestroyNotify) free_media_info_updated_signal_data);
+  return GST_PAD_PROBE_OK;
 }
 
-static GstCaps *
-get_caps (GstPlayer * self, gint stream_index, GType type)
+static GstPadProbeReturn
+subtitle_overlay_probe_cb (GstPad * pad, GstPadProbeInfo * info,
+    gpointer user_data)
 {
-  GstPad *pad = NULL;
-  GstCaps *caps = NULL;
+  GstPlayer *self = GST_PLAYER (user_data);
+  GstClockTime running_time = GST_CLOCK_TIME_NONE;
+  const GstSegment *segment;
+  GstBuffer *buffer;
+  GstEvent *event;
+  GstCaps *caps;
 
-  if (type == GST_TYPE_PLAYER_VIDEO_INFO)
-    g_signal_emit_by_name (G_OBJECT (self->playbin),
-        "get-video-pad", stream_index, &pad);
-  else if (type == GST_TYPE_PLAYER_AUDIO_INFO)
-    g_signal_emit_by_name (G_OBJECT (self->playbin),
-        "get-audio-pad", stream_index, &pad);
-  else
-    g_signal_emit_by_name (G_OBJECT (self->playbin),
-        "get-text-pad", stream_index, &pad);
+  if (info->type & GST_PAD_PROBE_TYPE_EVENT_BOTH) {
+    event = GST_PAD_PROBE_INFO_EVENT (info);
+    if (GST_EVENT_TYPE (event) == GST_EVENT_CAPS) {
+      gst_event_parse_caps (event, &caps);
+      gst_player_subtitle_overlay_set_caps (self->subtitle_overlay, caps);
+    }
 
-  if (pad) {
-    caps = gst_pad_get_current_caps (pad);
-    gst_object_unref (pad);
+    return GST_PAD_PROBE_OK;
   }
 
-  return caps;
+  buffer = GST_PAD_PROBE_INFO_BUFFER (info);
+  event = gst_pad_get_sticky_event (pad, GST_EVENT_SEGMENT, 0);
+  if (event) {
+    gst_event_parse_segment (event, &segment);
+    if (segment->format == GST_FORMAT_TIME)
+      running_time = gst_segment_to_running_time (segment, GST_FORMAT_TIME,
+          GST_BUFFER_PTS (buffer));
+    gst_event_unref (event);
+  }
+
+  GST_PAD_PROBE_INFO_DATA (info) =
+      gst_player_subtitle_overlay_process (self->subtitle_overlay, buffer,
+      running_time);
+
+  return GST_PAD_PROBE_OK;
 }
 
-static void
-gst_player_subtitle_info_update (GstPlayer * self,
-    GstPlayerStreamInfo * stream_info)
+/* Called with the result of the query */
+static GstPadProbeReturn
+subtitle_allocation_probe_cb (GstPad * pad, GstPadProbeInfo * info,
+    gpointer user_data)
 {
-  GstPlayerSubtitleInfo *info = (GstPlayerSubtitleInfo *) stream_info;
-
-  if (stream_info->tags) {
+  GstPlayer *self = GST_PLAYER (user_data);
+  GstQuery *query = GST_PAD_PROBE_INFO_QUERY (info);
 
-    /* free the old language info */
-    if (info->language) {
-      g_free (info->language);
-      info->language = NULL;
-    }
+  if (GST_QUERY_TYPE (query) == GST_QUERY_ALLOCATION)
+    gst_player_subtitle_overlay_set_meta_supported (self->subtitle_overlay,
+        gst_query_find_allocation_meta (query,
+            GST_VIDEO_OVERLAY_COMPOSITION_META_API_TYPE, NULL));
 
-    /* First try to get the language full name from tag, if name is not
-     * available then try language code. If we find the language code
-     * then use gstreamer api to translate code to full name.
-     */
-    gst_tag_list_get_string (stream_info->tags, GST_TAG_LANGUAGE_NAME,
-        &info->language);
-    if (!info->language) {
-      gchar *lang_code = NULL;
+  return GST_PAD_PROBE_OK;
+}
 
-      gst_tag_list_get_string (stream_info->tags, GST_TAG_LANGUAGE_CODE,
-          &lang_code);
-      if (lang_code) {
-        info->language = g_strdup (gst_tag_get_language_name (lang_code));
-        g_free (lang_code);
-      }
-    }
+/* Must be called from main context. Measures the converters playsink
+ * inserted in front of the sinks, these are recreated with the sinks */
+static void
+watch_converters (GstPlayer * self)
+{
+  static const gchar *names[] = { "aconv", "vconv" };
+  ConversionProbeData *data;
+  GstElement *converter;
+  GstPad *sinkpad, *srcpad;
+  guint i;
 
-    /* If we are still failed to find language name then check if external
-     * subtitle is loaded and compare the stream index between current sub
-     * stream index with our stream index and if matches then declare it as
-     * external subtitle and use the filename.
-     */
-    if (!info->language) {
-      gint text_index = -1;
-      gchar *suburi = NULL;
+  for (i = 0; i < G_N_ELEMENTS (names); i++) {
+    converter = gst_bin_get_by_name (GST_BIN (self->playbin), names[i]);
 
-      g_object_get (G_OBJECT (self->playbin), "current-suburi", &suburi, NULL);
-      if (suburi) {
-        g_object_get (G_OBJECT (self->playbin), "current-text", &text_index,
-            NULL);
-        if (text_index == gst_player_stream_info_get_index (stream_info))
-          info->language = g_path_get_basename (suburi);
-        g_free (suburi);
-      }
+    g_mutex_lock (&self->lock);
+    if (converter == self->converters[i]) {
+      g_mutex_unlock (&self->lock);
+      if (converter)
+        gst_object_unref (converter);
+      continue;
     }
+    gst_object_replace ((GstObject **) & self->converters[i],
+        (GstObject *) converter);
+    self->conversion_time[i] = 0;
+    self->n_converted[i] = 0;
+    if (i == 1) {
+      self->sink_rate_start = GST_CLOCK_TIME_NONE;
+      self->sink_rate_bytes = 0;
+      self->sink_byte_rate = 0;
+    }
+    g_mutex_unlock (&self->lock);
 
-  } else {
-    if (info->language) {
-      g_free (info->language);
-      info->language = NULL;
+    if (!converter)
+      continue;
+
+    sinkpad = gst_element_get_static_pad (converter, "sink");
+    srcpad = gst_element_get_static_pad (converter, "src");
+    if (sinkpad && srcpad) {
+      data = g_new0 (ConversionProbeData, 1);
+      data->player = self;
+      data->index = i;
+      data->start = GST_CLOCK_TIME_NONE;
+      gst_pad_add_probe (sinkpad, GST_PAD_PROBE_TYPE_BUFFER,
+          conversion_start_probe_cb, data, NULL);
+      gst_pad_add_probe (srcpad, GST_PAD_PROBE_TYPE_BUFFER,
+          conversion_end_probe_cb, data, g_free);
+
+      /* Cues are placed on the frames as the sink gets them */
+      if (i == 1) {
+        gst_pad_add_probe (srcpad,
+            GST_PAD_PROBE_TYPE_BUFFER | GST_PAD_PROBE_TYPE_EVENT_DOWNSTREAM,
+            subtitle_overlay_probe_cb, self, NULL);
+        gst_pad_add_probe (srcpad,
+            GST_PAD_PROBE_TYPE_QUERY_DOWNSTREAM | GST_PAD_PROBE_TYPE_PULL,
+            subtitle_allocation_probe_cb, self, NULL);
+      }
     }
+    if (sinkpad)
+      gst_object_unref (sinkpad);
+    if (srcpad)
+      gst_object_unref (srcpad);
+    gst_object_unref (converter);
   }
-
-  GST_DEBUG_OBJECT (self, "language=%s", info->language);
 }
 
-static void
-gst_player_video_info_update (GstPlayer * self,
-    GstPlayerStreamInfo * stream_info)
+/* Called with lock */
+static gboolean
+conversion_active_locked (GstPlayer * self, guint index)
 {
-  GstPlayerVideoInfo *info = (GstPlayerVideoInfo *) stream_info;
+  GstCaps *in = NULL, *out = NULL;
+  GstPad *sinkpad, *srcpad;
+  gboolean active = FALSE;
 
-  if (stream_info->caps) {
-    GstStructure *s;
+  if (!self->converters[index])
+    return FALSE;
 
-    s = gst_caps_get_structure (stream_info->caps, 0);
-    if (s) {
-      gint width, height;
-      gint fps_n, fps_d;
-      gint par_n, par_d;
+  sinkpad = gst_element_get_static_pad (self->converters[index], "sink");
+  srcpad = gst_element_get_static_pad (self->converters[index], "src");
+  if (sinkpad)
+    in = gst_pad_get_current_caps (sinkpad);
+  if (srcpad)
+    out = gst_pad_get_current_caps (srcpad);
+  if (in && out)
+    active = !gst_caps_is_equal (in, out);
+
+  if (in)
+    gst_caps_unref (in);
+  if (out)
+    gst_caps_unref (out);
+  if (sinkpad)
+    gst_object_unref (sinkpad);
+  if (srcpad)
+    gst_object_unref (srcpad);
+
+  return active;
+}
+
+/* Called with lock. Caps for the scaler in front of the video sink, scaled
+ * down to fit the renderer's target size by the same factor in both
+ * directions so that the pixel aspect ratio stays, and to half of that at
+ * the reduced resolution degradation level */
+static GstCaps *
+get_viewport_caps_locked (GstPlayer * self)
+{
+  GstCaps *caps;
+  gdouble scale = 1.0;
+  gint width, height;
 
-      if (gst_structure_get_int (s, "width", &width))
-        info->width = width;
-      else
-        info->width = -1;
+  if (self->stream_width <= 0 || self->stream_height <= 0)
+    return gst_caps_new_any ();
 
-      if (gst_structure_get_int (s, "height", &height))
-        info->height = height;
-      else
-        info->height = -1;
+  if (self->target_width > 0 && self->target_height > 0)
+    scale = MIN ((gdouble) self->target_width * self->stream_par_d /
+        ((gdouble) self->stream_width * self->stream_par_n),
+        (gdouble) self->target_height / self->stream_height);
+  /* Upscaling is left to the sink */
+  scale = MIN (scale, 1.0);
+  if (self->degradation_level >= GST_PLAYER_DEGRADATION_REDUCED_RESOLUTION)
+    scale /= 2;
+  if (scale >= 1.0)
+    return gst_caps_new_any ();
 
-      if (gst_structure_get_fraction (s, "framerate", &fps_n, &fps_d)) {
-        info->framerate_num = fps_n;
-        info->framerate_denom = fps_d;
-      } else {
-        info->framerate_num = 0;
-        info->framerate_denom = 1;
-      }
+  width = MAX (2, (gint) (self->stream_width * scale + 0.5) & ~1);
+  height = MAX (2, (gint) (self->stream_height * scale + 0.5) & ~1);
 
+  caps = gst_caps_new_simple ("video/x-raw", "width", G_TYPE_INT, width,
+      "height", G_TYPE_INT, height, NULL);
+  gst_caps_set_features (caps, 0, gst_caps_features_new_any ());
 
-      if (gst_structure_get_fraction (s, "pixel-aspect-ratio", &par_n, &par_d)) {
-        info->par_num = par_n;
-        info->par_denom = par_d;
-      } else {
-        info->par_num = 1;
-        info->par_denom = 1;
-      }
-    }
-  } else {
-    info->width = info->height = -1;
-    info->par_num = info->par_denom = 1;
-    info->framerate_num = 0;
-    info->framerate_denom = 1;
-  }
+  return caps;
+}
 
-  if (stream_info->tags) {
-    guint bitrate, max_bitrate;
+static GstPadProbeReturn
+viewport_caps_probe_cb (GstPad * pad, GstPadProbeInfo * info,
+    gpointer user_data)
+{
+  GstPlayer *self = GST_PLAYER (user_data);
+  GstEvent *event = GST_PAD_PROBE_INFO_EVENT (info);
+  GstVideoInfo video_info;
+  GstCaps *caps;
 
-    if (gst_tag_list_get_uint (stream_info->tags, GST_TAG_BITRATE, &bitrate))
-      info->bitrate = bitrate;
-    else
-      info->bitrate = -1;
+  if (GST_EVENT_TYPE (event) != GST_EVENT_CAPS)
+    return GST_PAD_PROBE_OK;
 
-    if (gst_tag_list_get_uint (stream_info->tags, GST_TAG_MAXIMUM_BITRATE,
-            &max_bitrate) || gst_tag_list_get_uint (stream_info->tags,
-            GST_TAG_NOMINAL_BITRATE, &max_bitrate))
-      info->max_bitrate = max_bitrate;
-    else
-      info->max_bitrate = -1;
-  } else {
-    info->bitrate = info->max_bitrate = -1;
-  }
+  gst_event_parse_caps (event, &caps);
+  if (!gst_video_info_from_caps (&video_info, caps))
+    return GST_PAD_PROBE_OK;
 
-  GST_DEBUG_OBJECT (self, "width=%d height=%d fps=%.2f par=%d:%d "
-      "bitrate=%d max_bitrate=%d", info->width, info->height,
-      (gdouble) info->framerate_num / info->framerate_denom,
-      info->par_num, info->par_denom, info->bitrate, info->max_bitrate);
+  /* Set before the scaler sees the new caps, so it negotiates the scaled
+   * size right away */
+  g_mutex_lock (&self->lock);
+  self->stream_width = GST_VIDEO_INFO_WIDTH (&video_info);
+  self->stream_height = GST_VIDEO_INFO_HEIGHT (&video_info);
+  self->stream_par_n = GST_VIDEO_INFO_PAR_N (&video_info);
+  self->stream_par_d = GST_VIDEO_INFO_PAR_D (&video_info);
+  caps = get_viewport_caps_locked (self);
+  g_mutex_unlock (&self->lock);
+
+  g_object_set (self->viewport_filter, "caps", caps, NULL);
+  gst_caps_unref (caps);
+
+  return GST_PAD_PROBE_OK;
 }
 
+/* Called from any thread. The capsfilter makes the scaler renegotiate */
 static void
-gst_player_audio_info_update (GstPlayer * self,
-    GstPlayerStreamInfo * stream_info)
+target_size_changed_cb (GstPlayerVideoRenderer * renderer, GstPlayer * self)
 {
-  GstPlayerAudioInfo *info = (GstPlayerAudioInfo *) stream_info;
-
-  if (stream_info->caps) {
-    GstStructure *s;
-
-    s = gst_caps_get_structure (stream_info->caps, 0);
-    if (s) {
-      gint rate, channels;
+  gint width = 0, height = 0;
+  GstCaps *caps;
 
-      if (gst_structure_get_int (s, "rate", &rate))
-        info->sample_rate = rate;
-      else
-        info->sample_rate = -1;
+  if (!gst_player_video_renderer_get_target_size (renderer, &width, &height))
+    width = height = 0;
 
-      if (gst_structure_get_int (s, "channels", &channels))
-        info->channels = channels;
-      else
-        info->channels = 0;
-    }
-  } else {
-    info->sample_rate = -1;
-    info->channels = 0;
+  g_mutex_lock (&self->lock);
+  if (width == self->target_width && height == self->target_height) {
+    g_mutex_unlock (&self->lock);
+    return;
   }
+  GST_DEBUG_OBJECT (self, "Target size changed to %dx%d", width, height);
+  self->target_width = width;
+  self->target_height = height;
+  caps = get_viewport_caps_locked (self);
+  g_mutex_unlock (&self->lock);
 
-  if (stream_info->tags) {
-    guint bitrate, max_bitrate;
-
-    if (gst_tag_list_get_uint (stream_info->tags, GST_TAG_BITRATE, &bitrate))
-      info->bitrate = bitrate;
-    else
-      info->bitrate = -1;
-
-    if (gst_tag_list_get_uint (stream_info->tags, GST_TAG_MAXIMUM_BITRATE,
-            &max_bitrate) || gst_tag_list_get_uint (stream_info->tags,
-            GST_TAG_NOMINAL_BITRATE, &max_bitrate))
-      info->max_bitrate = max_bitrate;
-    else
-      info->max_bitrate = -1;
-
-    /* if we have old language the free it */
-    if (info->language) {
-      g_free (info->language);
-      info->language = NULL;
-    }
+  g_object_set (self->viewport_filter, "caps", caps, NULL);
+  gst_caps_unref (caps);
+}
 
-    /* First try to get the language full name from tag, if name is not
-     * available then try language code. If we find the language code
-     * then use gstreamer api to translate code to full name.
-     */
-    gst_tag_list_get_string (stream_info->tags, GST_TAG_LANGUAGE_NAME,
-        &info->language);
-    if (!info->language) {
-      gchar *lang_code = NULL;
+/* Scales the decoded video down to the size the renderer shows it at,
+ * before playsink converts it and the sink uploads it */
+static void
+setup_viewport_scale (GstPlayer * self)
+{
+  GstElement *bin, *scale, *filter;
+  GstPad *pad;
+
+  scale = gst_element_factory_make ("videoscale", NULL);
+  filter = gst_element_factory_make ("capsfilter", NULL);
+  if (!scale || !filter) {
+    GST_WARNING_OBJECT (self, "No videoscale, not scaling to target size");
+    if (scale)
+      gst_object_unref (scale);
+    if (filter)
+      gst_object_unref (filter);
+    return;
+  }
 
-      gst_tag_list_get_string (stream_info->tags, GST_TAG_LANGUAGE_CODE,
-          &lang_code);
-      if (lang_code) {
-        info->language = g_strdup (gst_tag_get_language_name (lang_code));
-        g_free (lang_code);
+  bin = gst_bin_new ("viewport-scale");
+  gst_bin_add_many (GST_BIN (bin), scale, filter, NULL);
+  gst_element_link (scale, filter);
+
+  pad = gst_element_get_static_pad (scale, "sink");
+  gst_pad_add_probe (pad, GST_PAD_PROBE_TYPE_EVENT_DOWNSTREAM,
+      viewport_caps_probe_cb, self, NULL);
+  gst_element_add_pad (bin, gst_ghost_pad_new ("sink", pad));
+  gst_object_unref (pad);
+  pad = gst_element_get_static_pad (filter, "src");
+  gst_element_add_pad (bin, gst_ghost_pad_new ("src", pad));
+  gst_object_unref (pad);
+
+  self->viewport_scale = gst_object_ref (bin);
+  self->viewport_filter = gst_object_ref (filter);
+  g_object_set (self->playbin, "video-filter", bin, NULL);
+
+  g_signal_connect (self->video_renderer, "target-size-changed",
+      G_CALLBACK (target_size_changed_cb), self);
+  target_size_changed_cb (self->video_renderer, self);
+}
+
+/* Returns the sinks inside playbin, i.e. inside playsink and the sink bins
+ * it might use. gst_bin_iterate_sinks() does not recurse and only finds
+ * playsink itself. Free with g_list_free_full() and gst_object_unref() */
+static GList *
+get_sinks (GstPlayer * self)
+{
+  GstIterator *it;
+  GValue item = G_VALUE_INIT;
+  GList *sinks = NULL;
+  gboolean done = FALSE;
+
+  it = gst_bin_iterate_recurse (GST_BIN (self->playbin));
+  while (!done) {
+    switch (gst_iterator_next (it, &item)) {
+      case GST_ITERATOR_OK:{
+        GstElement *element = g_value_get_object (&item);
+
+        if (GST_OBJECT_FLAG_IS_SET (element, GST_ELEMENT_FLAG_SINK)
+            && !GST_IS_BIN (element))
+          sinks = g_list_prepend (sinks, gst_object_ref (element));
+        g_value_reset (&item);
+        break;
       }
+      case GST_ITERATOR_RESYNC:
+        g_list_free_full (sinks, gst_object_unref);
+        sinks = NULL;
+        gst_iterator_resync (it);
+        break;
+      case GST_ITERATOR_ERROR:
+      case GST_ITERATOR_DONE:
+        done = TRUE;
+        break;
     }
-  } else {
-    if (info->language) {
-      g_free (info->language);
-      info->language = NULL;
-    }
-    info->max_bitrate = info->bitrate = -1;
   }
+  g_value_unset (&item);
+  gst_iterator_free (it);
 
-  GST_DEBUG_OBJECT (self, "language=%s rate=%d channels=%d bitrate=%d "
-      "max_bitrate=%d", info->language, info->sample_rate, info->channels,
-      info->bitrate, info->bitrate);
+  return sinks;
 }
 
-static GstPlayerStreamInfo *
-gst_player_stream_info_find (GstPlayer * self, GstPlayerMediaInfo * media_info,
-    GType type, gint stream_index)
+/* Without synchronisation the sinks render every buffer as soon as it
+ * arrives, so the pipeline runs as fast as decoding allows */
+static void
+set_sinks_sync (GstPlayer * self, gboolean sync)
 {
-  GList *list, *l;
-  GstPlayerStreamInfo *info = NULL;
+  GList *sinks, *l;
 
-  if (!media_info)
-    return NULL;
+  sinks = get_sinks (self);
+  for (l = sinks; l; l = l->next) {
+    GstElement *element = l->data;
 
-  list = gst_player_media_info_get_stream_list (media_info);
-  for (l = list; l != NULL; l = l->next) {
-    info = (GstPlayerStreamInfo *) l->data;
-    if ((G_OBJECT_TYPE (info) == type) && (info->stream_index == stream_index)) {
-      return info;
+    if (g_object_class_find_property (G_OBJECT_GET_CLASS (element), "sync")) {
+      GST_DEBUG_OBJECT (self, "Setting sync=%d on %s", sync,
+          GST_ELEMENT_NAME (element));
+      g_object_set (element, "sync", sync, NULL);
     }
   }
-
-  return NULL;
+  g_list_free_full (sinks, gst_object_unref);
 }
 
 static gboolean
-is_track_enabled (GstPlayer * self, gint pos)
-{
-  gint flags;
-
-  g_object_get (G_OBJECT (self->playbin), "flags", &flags, NULL);
-
-  if ((flags & pos))
-    return TRUE;
-
-  return FALSE;
-}
-
-static GstPlayerStreamInfo *
-gst_player_stream_info_get_current (GstPlayer * self, const gchar * prop,
-    GType type)
+gst_player_set_offline_internal (gpointer user_data)
 {
-  gint current;
-  GstPlayerStreamInfo *info;
-
-  if (!self->media_info)
-    return NULL;
+  GstPlayer *self = GST_PLAYER (user_data);
+  GstElement *audio_sink = NULL;
+  gboolean offline;
 
-  g_object_get (G_OBJECT (self->playbin), prop, &current, NULL);
   g_mutex_lock (&self->lock);
-  info = gst_player_stream_info_find (self, self->media_info, type, current);
-  if (info)
-    info = gst_player_stream_info_copy (info);
+  offline = self->offline;
+  self->throughput = 0.0;
   g_mutex_unlock (&self->lock);
 
-  return info;
-}
-
-static void
-gst_player_stream_info_update (GstPlayer * self, GstPlayerStreamInfo * s)
-{
-  if (GST_IS_PLAYER_VIDEO_INFO (s))
-    gst_player_video_info_update (self, s);
-  else if (GST_IS_PLAYER_AUDIO_INFO (s))
-    gst_player_audio_info_update (self, s);
-  else
-    gst_player_subtitle_info_update (self, s);
-}
-
-static gchar *
-stream_info_get_codec (GstPlayerStreamInfo * s)
-{
-  const gchar *type;
-  GstTagList *tags;
-  gchar *codec = NULL;
-
-  if (GST_IS_PLAYER_VIDEO_INFO (s))
-    type = GST_TAG_VIDEO_CODEC;
-  else if (GST_IS_PLAYER_AUDIO_INFO (s))
-    type = GST_TAG_AUDIO_CODEC;
-  else
-    type = GST_TAG_SUBTITLE_CODEC;
+  self->offline_start_time = GST_CLOCK_TIME_NONE;
 
-  tags = gst_player_stream_info_get_tags (s);
-  if (tags) {
-    gst_tag_list_get_string (tags, type, &codec);
-    if (!codec)
-      gst_tag_list_get_string (tags, GST_TAG_CODEC, &codec);
+  if (offline == self->offline_applied)
+    return G_SOURCE_REMOVE;
+  self->offline_applied = offline;
+
+  /* Audio sinks block on the device even without synchronisation. Like
+   * all sink changes in playbin this only takes effect from READY */
+  if (offline) {
+    audio_sink = gst_element_factory_make ("fakesink", "offline-audio-sink");
+    if (audio_sink)
+      g_object_set (audio_sink, "sync", FALSE, NULL);
   }
+  g_object_set (self->playbin, "audio-sink", audio_sink, NULL);
+  if (self->current_state > GST_STATE_READY)
+    GST_DEBUG_OBJECT (self, "Audio sink changes with the next stream");
+  update_sink_caps (self);
 
-  if (!codec) {
-    GstCaps *caps;
-    caps = gst_player_stream_info_get_caps (s);
-    if (caps) {
-      codec = gst_pb_utils_get_codec_description (caps);
-    }
-  }
+  set_sinks_sync (self, !offline);
 
-  return codec;
+  return G_SOURCE_REMOVE;
 }
 
 static void
-gst_player_stream_info_update_tags_and_caps (GstPlayer * self,
-    GstPlayerStreamInfo * s)
+state_changed_cb (GstBus * bus, GstMessage * msg, gpointer user_data)
 {
-  GstTagList *tags;
-  gint stream_index;
+  GstPlayer *self = GST_PLAYER (user_data);
+  GstState old_state, new_state, pending_state;
 
-  stream_index = gst_player_stream_info_get_index (s);
+  gst_message_parse_state_changed (msg, &old_state, &new_state, &pending_state);
 
-  if (GST_IS_PLAYER_VIDEO_INFO (s))
-    g_signal_emit_by_name (self->playbin, "get-video-tags",
-        stream_index, &tags);
-  else if (GST_IS_PLAYER_AUDIO_INFO (s))
-    g_signal_emit_by_name (self->playbin, "get-audio-tags",
-        stream_index, &tags);
-  else
-    g_signal_emit_by_name (self->playbin, "get-text-tags", stream_index, &tags);
+  if (GST_MESSAGE_SRC (msg) == GST_OBJECT (self->playbin)) {
+    gchar *transition_name;
 
-  if (s->tags)
-    gst_tag_list_unref (s->tags);
-  s->tags = tags;
+    GST_DEBUG_OBJECT (self, "Changed state old: %s new: %s pending: %s",
+        gst_element_state_get_name (old_state),
+        gst_element_state_get_name (new_state),
+        gst_element_state_get_name (pending_state));
+    gst_player_flight_recorder_record (self->flight_recorder,
+        FLIGHT_EVENT_STATE_CHANGED, old_state, new_state, GST_CLOCK_TIME_NONE);
 
-  if (s->caps)
-    gst_caps_unref (s->caps);
-  s->caps = get_caps (self, stream_index, G_OBJECT_TYPE (s));
+    transition_name = g_strdup_printf ("%s_%s",
+        gst_element_state_get_name (old_state),
+        gst_element_state_get_name (new_state));
+    dump_dot_file (self, transition_name);
+    g_free (transition_name);
 
-  if (s->codec)
-    g_free (s->codec);
-  s->codec = stream_info_get_codec (s);
+    self->current_state = new_state;
 
-  GST_DEBUG_OBJECT (self, "%s index: %d tags: %p caps: %p",
-      gst_player_stream_info_get_stream_type (s), stream_index,
-      s->tags, s->caps);
+    /* playsink creates the sinks only now */
+    if (old_state == GST_STATE_READY && new_state == GST_STATE_PAUSED) {
+      gboolean offline;
 
-  gst_player_stream_info_update (self, s);
-}
+      g_mutex_lock (&self->lock);
+      offline = self->offline;
+      g_mutex_unlock (&self->lock);
+      if (offline)
+        set_sinks_sync (self, FALSE);
+    }
 
-static void
-gst_player_streams_info_create (GstPlayer * self,
-    GstPlayerMediaInfo * media_info, const gchar * prop, GType type)
-{
-  gint i;
-  gint total = -1;
-  GstPlayerStreamInfo *s;
+    if (old_state == GST_STATE_READY && new_state == GST_STATE_PAUSED
+        && pending_state == GST_STATE_VOID_PENDING) {
+      GstElement *video_sink;
+      GstPad *video_sink_pad;
+      gint64 duration = -1;
 
-  if (!media_info)
-    return;
+      GST_DEBUG_OBJECT (self, "Initial PAUSED - pre-rolled");
 
-  g_object_get (G_OBJECT (self->playbin), prop, &total, NULL);
+      g_mutex_lock (&self->lock);
+      if (self->media_info)
+        g_object_unref (self->media_info);
+      self->media_info = gst_player_media_info_create (self);
+      g_mutex_unlock (&self->lock);
+      emit_media_info_updated_signal (self);
 
-  GST_DEBUG_OBJECT (self, "%s: %d", prop, total);
+      g_object_get (self->playbin, "video-sink", &video_sink, NULL);
 
-  for (i = 0; i < total; i++) {
-    /* check if stream already exist in the list */
-    s = gst_player_stream_info_find (self, media_info, type, i);
+      if (video_sink) {
+        video_sink_pad = gst_element_get_static_pad (video_sink, "sink");
 
-    if (!s) {
-      /* create a new stream info instance */
-      s = gst_player_stream_info_new (i, type);
+        if (video_sink_pad) {
+          g_signal_connect (video_sink_pad, "notify::caps",
+              (GCallback) notify_caps_cb, self);
+          gst_object_unref (video_sink_pad);
+        }
+        gst_object_unref (video_sink);
+      }
 
-      /* add the object in stream list */
-      media_info->stream_list = g_list_append (media_info->stream_list, s);
+      check_video_dimensions_changed (self);
+      watch_converters (self);
+      watch_transition_sinks (self);
+      gst_player_element_stats_watch (self->element_stats,
+          GST_BIN (self->playbin));
+      gst_element_query_duration (self->playbin, GST_FORMAT_TIME, &duration);
+      emit_duration_changed (self, duration);
+    }
 
-      /* based on type, add the object in its corresponding stream_ list */
-      if (GST_IS_PLAYER_AUDIO_INFO (s))
-        media_info->audio_stream_list = g_list_append
-            (media_info->audio_stream_list, s);
-      else if (GST_IS_PLAYER_VIDEO_INFO (s))
-        media_info->video_stream_list = g_list_append
-            (media_info->video_stream_list, s);
-      else
-        media_info->subtitle_stream_list = g_list_append
-            (media_info->subtitle_stream_list, s);
+    if (new_state == GST_STATE_PAUSED
+        && pending_state == GST_STATE_VOID_PENDING) {
+      remove_tick_source (self);
 
-      GST_DEBUG_OBJECT (self, "create %s stream stream_index: %d",
-          gst_player_stream_info_get_stream_type (s), i);
-    }
+      g_mutex_lock (&self->lock);
+      if (self->seek_pending) {
+        self->seek_pending = FALSE;
 
-    gst_player_stream_info_update_tags_and_caps (self, s);
+        if (!self->media_info->seekable) {
+          GST_DEBUG_OBJECT (self, "Media is not seekable");
+          if (self->seek_source) {
+            g_source_destroy (self->seek_source);
+            g_source_unref (self->seek_source);
+            self->seek_source = NULL;
+          }
+          self->seek_position = GST_CLOCK_TIME_NONE;
+          self->last_seek_time = GST_CLOCK_TIME_NONE;
+        } else if (self->seek_source) {
+          GST_DEBUG_OBJECT (self, "Seek finished but new seek is pending");
+          gst_player_seek_internal_locked (self);
+        } else {
+          self->seek_latency = gst_util_get_timestamp () - self->last_seek_time;
+          GST_DEBUG_OBJECT (self, "Seek finished after %" GST_TIME_FORMAT,
+              GST_TIME_ARGS (self->seek_latency));
+          gst_player_flight_recorder_record (self->flight_recorder,
+              FLIGHT_EVENT_SEEK_DONE,
+              (gint) (self->seek_latency / GST_MSECOND), 0,
+              GST_CLOCK_TIME_NONE);
+          emit_seek_done (self);
+        }
+      }
+
+      if (self->seek_position != GST_CLOCK_TIME_NONE) {
+        GST_DEBUG_OBJECT (self, "Seeking now that we reached PAUSED state");
+        gst_player_seek_internal_locked (self);
+        g_mutex_unlock (&self->lock);
+      } else if (!self->seek_pending) {
+        g_mutex_unlock (&self->lock);
+
+        tick_cb (self);
+
+        if (self->target_state >= GST_STATE_PLAYING && self->buffering == 100) {
+          GstStateChangeReturn state_ret;
+
+          state_ret = gst_element_set_state (self->playbin, GST_STATE_PLAYING);
+          if (state_ret == GST_STATE_CHANGE_FAILURE)
+            emit_error (self, g_error_new (GST_PLAYER_ERROR,
+                    GST_PLAYER_ERROR_FAILED, "Failed to play"));
+        } else if (self->buffering == 100) {
+          change_state (self, GST_PLAYER_STATE_PAUSED);
+        }
+      } else {
+        g_mutex_unlock (&self->lock);
+      }
+    } else if (new_state == GST_STATE_PLAYING
+        && pending_state == GST_STATE_VOID_PENDING) {
+
+      /* If no seek is currently pending, add the tick source. This can happen
+       * if we seeked already but the state-change message was still queued up */
+      if (!self->seek_pending) {
+        add_tick_source (self);
+        change_state (self, GST_PLAYER_STATE_PLAYING);
+      }
+      gst_player_element_stats_watch (self->element_stats,
+          GST_BIN (self->playbin));
+    } else if (new_state == GST_STATE_READY && old_state > GST_STATE_READY) {
+      change_state (self, GST_PLAYER_STATE_STOPPED);
+    } else {
+      /* Otherwise we neither reached PLAYING nor PAUSED, so must
+       * wait for something to happen... i.e. are BUFFERING now */
+      change_state (self, GST_PLAYER_STATE_BUFFERING);
+    }
   }
 }
 
 static void
-video_changed_cb (GObject * object, gpointer user_data)
+duration_changed_cb (GstBus * bus, GstMessage * msg, gpointer user_data)
 {
   GstPlayer *self = GST_PLAYER (user_data);
+  gint64 duration;
 
-  g_mutex_lock (&self->lock);
-  gst_player_streams_info_create (self, self->media_info,
-      "n-video", GST_TYPE_PLAYER_VIDEO_INFO);
-  g_mutex_unlock (&self->lock);
+  if (gst_element_query_duration (self->playbin, GST_FORMAT_TIME, &duration)) {
+    emit_duration_changed (self, duration);
+  }
 }
 
 static void
-audio_changed_cb (GObject * object, gpointer user_data)
+latency_cb (GstBus * bus, GstMessage * msg, gpointer user_data)
 {
   GstPlayer *self = GST_PLAYER (user_data);
 
-  g_mutex_lock (&self->lock);
-  gst_player_streams_info_create (self, self->media_info,
-      "n-audio", GST_TYPE_PLAYER_AUDIO_INFO);
-  g_mutex_unlock (&self->lock);
+  GST_DEBUG_OBJECT (self, "Latency changed");
+
+  gst_bin_recalculate_latency (GST_BIN (self->playbin));
 }
 
 static void
-subtitle_changed_cb (GObject * object, gpointer user_data)
+request_state_cb (GstBus * bus, GstMessage * msg, gpointer user_data)
 {
   GstPlayer *self = GST_PLAYER (user_data);
+  GstState state;
+  GstStateChangeReturn state_ret;
 
-  g_mutex_lock (&self->lock);
-  gst_player_streams_info_create (self, self->media_info,
-      "n-text", GST_TYPE_PLAYER_SUBTITLE_INFO);
-  g_mutex_unlock (&self->lock);
-}
-
-static void *
-get_title (GstTagList * tags)
-{
-  gchar *title = NULL;
+  gst_message_parse_request_state (msg, &state);
 
-  gst_tag_list_get_string (tags, GST_TAG_TITLE, &title);
-  if (!title)
-    gst_tag_list_get_string (tags, GST_TAG_TITLE_SORTNAME, &title);
+  GST_DEBUG_OBJECT (self, "State %s requested",
+      gst_element_state_get_name (state));
 
-  return title;
+  self->target_state = state;
+  state_ret = gst_element_set_state (self->playbin, state);
+  if (state_ret == GST_STATE_CHANGE_FAILURE)
+    emit_error (self, g_error_new (GST_PLAYER_ERROR, GST_PLAYER_ERROR_FAILED,
+            "Failed to change to requested state %s",
+            gst_element_state_get_name (state)));
 }
 
-static void *
-get_container_format (GstTagList * tags)
+static void
+media_info_update (GstPlayer * self, GstPlayerMediaInfo * info)
 {
-  gchar *container = NULL;
+  if (info->title)
+    g_free (info->title);
+  info->title = get_from_tags (self, info, get_title);
 
-  gst_tag_list_get_string (tags, GST_TAG_CONTAINER_FORMAT, &container);
+  if (info->container)
+    g_free (info->container);
+  info->container = get_from_tags (self, info, get_container_format);
 
-  /* TODO: If container is not available then maybe consider
-   * parsing caps or file extension to guess the container format.
-   */
+  if (info->image_sample)
+    gst_sample_unref (info->image_sample);
+  info->image_sample = get_from_tags (self, info, get_cover_sample);
 
-  return container;
+  GST_DEBUG_OBJECT (self, "title: %s, container: %s "
+      "image_sample: %p", info->title, info->container, info->image_sample);
 }
 
-static void *
-get_from_tags (GstPlayer * self, GstPlayerMediaInfo * media_info,
-    void *(*func) (GstTagList *))
+/* Must be called with lock, takes ownership of tags */
+static void
+apply_global_tags_locked (GstPlayer * self, GstTagList * tags)
 {
-  GList *l;
-  void *ret = NULL;
+  if (self->media_info->tags)
+    gst_tag_list_unref (self->media_info->tags);
+  self->media_info->tags = tags;
+  media_info_update (self, self->media_info);
+}
 
-  if (media_info->tags) {
-    ret = func (media_info->tags);
-    if (ret)
-      return ret;
-  }
+/* Applies the tags received since the last update, if any, and keeps
+ * merging until a whole interval passed without new tags */
+static gboolean
+tag_update_cb (gpointer user_data)
+{
+  GstPlayer *self = GST_PLAYER (user_data);
+  GstTagList *tags;
 
-  /* if global tag does not exit then try video and audio streams */
-  GST_DEBUG_OBJECT (self, "trying video tags");
-  for (l = gst_player_get_video_streams (media_info); l != NULL; l = l->next) {
-    GstTagList *tags;
+  g_mutex_lock (&self->lock);
+  tags = self->pending_tags;
+  self->pending_tags = NULL;
 
-    tags = gst_player_stream_info_get_tags ((GstPlayerStreamInfo *) l->data);
+  if (!tags || !self->media_info) {
     if (tags)
-      ret = func (tags);
-
-    if (ret)
-      return ret;
+      gst_tag_list_unref (tags);
+    g_source_unref (self->tag_update_source);
+    self->tag_update_source = NULL;
+    g_mutex_unlock (&self->lock);
+    return G_SOURCE_REMOVE;
   }
 
-  GST_DEBUG_OBJECT (self, "trying audio tags");
-  for (l = gst_player_get_audio_streams (media_info); l != NULL; l = l->next) {
-    GstTagList *tags;
-
-    tags = gst_player_stream_info_get_tags ((GstPlayerStreamInfo *) l->data);
-    if (tags)
-      ret = func (tags);
+  apply_global_tags_locked (self, tags);
+  g_mutex_unlock (&self->lock);
 
-    if (ret)
-      return ret;
-  }
+  emit_media_info_updated_signal (self);
 
-  GST_DEBUG_OBJECT (self, "failed to get the information from tags");
-  return NULL;
+  return G_SOURCE_CONTINUE;
 }
 
-static void *
-get_cover_sample (GstTagList * tags)
+/* Must be called with lock */
+static void
+remove_tag_update_source (GstPlayer * self)
 {
-  GstSample *cover_sample = NULL;
-
-  gst_tag_list_get_sample (tags, GST_TAG_IMAGE, &cover_sample);
-  if (!cover_sample)
-    gst_tag_list_get_sample (tags, GST_TAG_PREVIEW_IMAGE, &cover_sample);
+  if (self->tag_update_source) {
+    g_source_destroy (self->tag_update_source);
+    g_source_unref (self->tag_update_source);
+    self->tag_update_source = NULL;
+  }
 
-  return cover_sample;
+  if (self->pending_tags) {
+    gst_tag_list_unref (self->pending_tags);
+    self->pending_tags = NULL;
+  }
 }
 
-static GstPlayerMediaInfo *
-gst_player_media_info_create (GstPlayer * self)
+static void
+tags_cb (GstBus * bus, GstMessage * msg, gpointer user_data)
 {
-  GstPlayerMediaInfo *media_info;
-  GstQuery *query;
-
-  GST_DEBUG_OBJECT (self, "begin");
-  media_info = gst_player_media_info_new (self->uri);
-  media_info->duration = gst_player_get_duration (self);
-  media_info->tags = self->global_tags;
-  self->global_tags = NULL;
+  GstPlayer *self = GST_PLAYER (user_data);
+  GstTagList *tags = NULL;
 
-  query = gst_query_new_seeking (GST_FORMAT_TIME);
-  if (gst_element_query (self->playbin, query))
-    gst_query_parse_seeking (query, NULL, &media_info->seekable, NULL, NULL);
-  gst_query_unref (query);
+  gst_message_parse_tag (msg, &tags);
 
-  /* create audio/video/sub streams */
-  gst_player_streams_info_create (self, media_info, "n-video",
-      GST_TYPE_PLAYER_VIDEO_INFO);
-  gst_player_streams_info_create (self, media_info, "n-audio",
-      GST_TYPE_PLAYER_AUDIO_INFO);
-  gst_player_streams_info_create (self, media_info, "n-text",
-      GST_TYPE_PLAYER_SUBTITLE_INFO);
+  /*
+   * NOTE: Inorder to get global tag you must apply the following patches in
+   * your gstreamer build.
+   *
+   * http://cgit.freedesktop.org/gstreamer/gst-plugins-good/commit/?id=9119fbd774093e3ae762c8652acd80d54b2c3b45
+   * http://cgit.freedesktop.org/gstreamer/gstreamer/commit/?id=18b058100940bdcaed86fa412e3582a02871f995
+   */
+  GST_DEBUG_OBJECT (self, "recieved %s tags",
+      gst_tag_list_get_scope (tags) ==
+      GST_TAG_SCOPE_GLOBAL ? "global" : "stream");
 
-  media_info->title = get_from_tags (self, media_info, get_title);
-  media_info->container =
-      get_from_tags (self, media_info, get_container_format);
-  media_info->image_sample = get_from_tags (self, media_info, get_cover_sample);
+  if (gst_tag_list_get_scope (tags) == GST_TAG_SCOPE_GLOBAL) {
+    GstTagList *current;
 
-  GST_DEBUG_OBJECT (self, "uri: %s title: %s duration: %" GST_TIME_FORMAT
-      " seekable: %s container: %s image_sample %p",
-      media_info->uri, media_info->title, GST_TIME_ARGS (media_info->duration),
-      media_info->seekable ? "yes" : "no", media_info->container,
-      media_info->image_sample);
+    g_mutex_lock (&self->lock);
+    if (self->media_info)
+      current = self->pending_tags ? self->pending_tags :
+          self->media_info->tags;
+    else
+      current = self->global_tags;
 
-  GST_DEBUG_OBJECT (self, "end");
-  return media_info;
+    /* Live streams repeat their metadata over and over again */
+    if (current && gst_tag_list_is_equal (current, tags)) {
+      GST_LOG_OBJECT (self, "Ignoring unchanged global tags");
+      self->n_tags_suppressed++;
+      g_mutex_unlock (&self->lock);
+    } else if (!self->media_info) {
+      if (self->global_tags)
+        gst_tag_list_unref (self->global_tags);
+      self->global_tags = gst_tag_list_ref (tags);
+      g_mutex_unlock (&self->lock);
+    } else if (self->tag_update_source) {
+      if (self->pending_tags) {
+        gst_tag_list_unref (self->pending_tags);
+        self->n_tags_suppressed++;
+      }
+      self->pending_tags = gst_tag_list_ref (tags);
+      g_mutex_unlock (&self->lock);
+    } else {
+      apply_global_tags_locked (self, gst_tag_list_ref (tags));
+      if (self->tag_update_interval_ms) {
+        self->tag_update_source =
+            g_timeout_source_new (self->tag_update_interval_ms);
+        g_source_set_callback (self->tag_update_source,
+            (GSourceFunc) tag_update_cb, self, NULL);
+        g_source_attach (self->tag_update_source, self->context);
+      }
+      g_mutex_unlock (&self->lock);
+      emit_media_info_updated_signal (self);
+    }
+  }
+
+  gst_tag_list_unref (tags);
 }
 
 static void
-tags_changed_cb (GstPlayer * self, gint stream_index, GType type)
+element_cb (GstBus * bus, GstMessage * msg, gpointer user_data)
 {
-  GstPlayerStreamInfo *s;
+  GstPlayer *self = GST_PLAYER (user_data);
+  const GstStructure *s;
 
-  if (!self->media_info)
-    return;
+  s = gst_message_get_structure (msg);
+  if (gst_structure_has_name (s, "redirect")) {
+    const gchar *new_location;
 
-  /* update the stream information */
-  g_mutex_lock (&self->lock);
-  s = gst_player_stream_info_find (self, self->media_info, type, stream_index);
-  gst_player_stream_info_update_tags_and_caps (self, s);
-  g_mutex_unlock (&self->lock);
+    new_location = gst_structure_get_string (s, "new-location");
+    if (!new_location) {
+      const GValue *locations_list, *location_val;
+      guint i, size;
 
-  emit_media_info_updated_signal (self);
+      locations_list = gst_structure_get_value (s, "locations");
+      size = gst_value_list_get_size (locations_list);
+      for (i = 0; i < size; ++i) {
+        const GstStructure *location_s;
+
+        location_val = gst_value_list_get_value (locations_list, i);
+        if (!GST_VALUE_HOLDS_STRUCTURE (location_val))
+          continue;
+
+        location_s = (const GstStructure *) g_value_get_boxed (location_val);
+        if (!gst_structure_has_name (location_s, "redirect"))
+          continue;
+
+        new_location = gst_structure_get_string (location_s, "new-location");
+        if (new_location)
+          break;
+      }
+    }
+
+    if (new_location) {
+      GstState target_state;
+
+      GST_DEBUG_OBJECT (self, "Redirect to '%s'", new_location);
+
+      /* Remember target state and restore after setting the URI */
+      target_state = self->target_state;
+
+      g_mutex_lock (&self->lock);
+      if (self->uri)
+        g_free (self->uri);
+
+      self->uri = g_strdup (new_location);
+      g_mutex_unlock (&self->lock);
+
+      gst_player_set_uri_internal (self);
+
+      if (target_state == GST_STATE_PAUSED)
+        gst_player_pause_internal (self);
+      else if (target_state == GST_STATE_PLAYING)
+        gst_player_play_internal (self);
+    }
+  }
 }
 
 static void
-video_tags_changed_cb (GstElement * playbin, gint stream_index,
-    gpointer user_data)
+player_set_flag (GstPlayer * self, gint pos)
 {
-  tags_changed_cb (GST_PLAYER (user_data), stream_index,
-      GST_TYPE_PLAYER_VIDEO_INFO);
+  gint flags;
+
+  g_object_get (self->playbin, "flags", &flags, NULL);
+  flags |= pos;
+  g_object_set (self->playbin, "flags", flags, NULL);
+
+  GST_DEBUG_OBJECT (self, "setting flags=%#x", flags);
 }
 
 static void
-audio_tags_changed_cb (GstElement * playbin, gint stream_index,
-    gpointer user_data)
+player_clear_flag (GstPlayer * self, gint pos)
 {
-  tags_changed_cb (GST_PLAYER (user_data), stream_index,
-      GST_TYPE_PLAYER_AUDIO_INFO);
+  gint flags;
+
+  g_object_get (self->playbin, "flags", &flags, NULL);
+  flags &= ~pos;
+  g_object_set (self->playbin, "flags", flags, NULL);
+
+  GST_DEBUG_OBJECT (self, "setting flags=%#x", flags);
 }
 
-static void
-subtitle_tags_changed_cb (GstElement * playbin, gint stream_index,
-    gpointer user_data)
+typedef struct
 {
-  tags_changed_cb (GST_PLAYER (user_data), stream_index,
-      GST_TYPE_PLAYER_SUBTITLE_INFO);
-}
+  GstPlayer *player;
+  PlayerCallbacks *callbacks;
+  gboolean emit;
+  GstPlayerMediaInfo *info;
+} MediaInfoUpdatedSignalData;
 
 static void
-volume_changed_dispatch (gpointer user_data)
+media_info_updated_dispatch (gpointer user_data)
 {
-  g_signal_emit (user_data, signals[SIGNAL_VOLUME_CHANGED], 0);
-  g_object_notify_by_pspec (G_OBJECT (user_data), param_specs[PROP_VOLUME]);
-}
+  MediaInfoUpdatedSignalData *data = user_data;
 
-static void inline
-volume_notify_cb (GObject * obj, GParamSpec * pspec, GstPlayer * self)
-{
-  if (g_signal_handler_find (self, G_SIGNAL_MATCH_ID,
-          signals[SIGNAL_VOLUME_CHANGED], 0, NULL, NULL, NULL) != 0) {
-    gst_player_signal_dispatcher_dispatch (self->signal_dispatcher, self,
-        volume_changed_dispatch, g_object_ref (self),
-        (GDestroyNotify) g_object_unref);
+  if (data->player->target_state >= GST_STATE_PAUSED) {
+    if (data->callbacks)
+      data->callbacks->callbacks.media_info_updated (data->player, data->info,
+          data->callbacks->user_data);
+    if (data->emit)
+      g_signal_emit (data->player, signals[SIGNAL_MEDIA_INFO_UPDATED], 0,
+          data->info);
   }
 }
 
 static void
-mute_changed_dispatch (gpointer user_data)
+free_media_info_updated_signal_data (MediaInfoUpdatedSignalData * data)
 {
-  g_signal_emit (user_data, signals[SIGNAL_MUTE_CHANGED], 0);
-  g_object_notify_by_pspec (G_OBJECT (user_data), param_specs[PROP_MUTE]);
+  g_object_unref (data->player);
+  if (data->callbacks)
+    player_callbacks_unref (data->callbacks);
+  g_object_unref (data->info);
+  g_free (data);
 }
 
-static void inline
-mute_notify_cb (GObject * obj, GParamSpec * pspec, GstPlayer * self)
+/*
+ * emit_media_info_updated_signal:
+ *
+ * create a new copy of self->media_info object and emits the newly created
+ * copy to user application. The newly created media_info will be unref'ed
+ * as part of signal finalize method.
+ */
+static void
+emit_media_info_updated_signal (GstPlayer * self)
 {
-  if (g_signal_handler_find (self, G_SIGNAL_MATCH_ID,
-          signals[SIGNAL_MUTE_CHANGED], 0, NULL, NULL, NULL) != 0) {
-    gst_player_signal_dispatcher_dispatch (self->signal_dispatcher, self,
-        mute_changed_dispatch, g_object_ref (self),
-        (GDestroyNotify) g_object_unref);
-  }
+  MediaInfoUpdatedSignalData *data = g_new (MediaInfoUpdatedSignalData, 1);
+  data->player = g_object_ref (self);
+  data->callbacks = get_callbacks (self, media_info_updated);
+  data->emit = TRUE;
+  g_mutex_lock (&self->lock);
+  data->info = gst_player_media_info_copy (self->media_info);
+  g_mutex_unlock (&self->lock);
+
+  gst_player_signal_dispatcher_dispatch (self->signal_dispatcher, self,
+      media_info_updated_dispatch, data,
+      (GDestroyNotify) free_media_info_updated_signal_data);
 }
 
-static gpointer
-gst_player_main (gpointer data)
+static GstCaps *
+get_caps (GstPlayer * self, gint stream_index, GType type)
 {
-  GstPlayer *self = GST_PLAYER (data);
-  GstBus *bus;
-  GSource *source;
-  GSource *bus_source;
+  GstPad *pad = NULL;
+  GstCaps *caps = NULL;
 
-  GST_TRACE_OBJECT (self, "Starting main thread");
+  if (type == GST_TYPE_PLAYER_VIDEO_INFO)
+    g_signal_emit_by_name (G_OBJECT (self->playbin),
+        "get-video-pad", stream_index, &pad);
+  else if (type == GST_TYPE_PLAYER_AUDIO_INFO)
+    g_signal_emit_by_name (G_OBJECT (self->playbin),
+        "get-audio-pad", stream_index, &pad);
+  else
+    g_signal_emit_by_name (G_OBJECT (self->playbin),
+        "get-text-pad", stream_index, &pad);
 
-  g_main_context_push_thread_default (self->context);
+  if (pad) {
+    caps = gst_pad_get_current_caps (pad);
+    gst_object_unref (pad);
+  }
 
-  source = g_idle_source_new ();
-  g_source_set_callback (source, (GSourceFunc) main_loop_running_cb, self,
-      NULL);
-  g_source_attach (source, self->context);
-  g_source_unref (source);
+  return caps;
+}
 
-  self->playbin = gst_element_factory_make ("playbin", "playbin");
+static void
+gst_player_subtitle_info_update (GstPlayer * self,
+    GstPlayerStreamInfo * stream_info)
+{
+  GstPlayerSubtitleInfo *info = (GstPlayerSubtitleInfo *) stream_info;
 
-  if (self->video_renderer) {
-    GstElement *video_sink =
-        gst_player_video_renderer_create_video_sink (self->video_renderer,
-        self);
+  if (stream_info->tags) {
 
-    if (video_sink)
-      g_object_set (self->playbin, "video-sink", video_sink, NULL);
-  }
+    /* free the old language info */
+    if (info->language) {
+      g_free (info->language);
+      info->language = NULL;
+    }
 
-  self->bus = bus = gst_element_get_bus (self->playbin);
-  bus_source = gst_bus_create_watch (bus);
-  g_source_set_callback (bus_source, (GSourceFunc) gst_bus_async_signal_func,
-      NULL, NULL);
-  g_source_attach (bus_source, self->context);
+    /* First try to get the language full name from tag, if name is not
+     * available then try language code. If we find the language code
+     * then use gstreamer api to translate code to full name.
+     */
+    gst_tag_list_get_string (stream_info->tags, GST_TAG_LANGUAGE_NAME,
+        &info->language);
+    if (!info->language) {
+      gchar *lang_code = NULL;
 
-  g_signal_connect (G_OBJECT (bus), "message::error", G_CALLBACK (error_cb),
-      self);
+      gst_tag_list_get_string (stream_info->tags, GST_TAG_LANGUAGE_CODE,
+          &lang_code);
+      if (lang_code) {
+        info->language = g_strdup (gst_tag_get_language_name (lang_code));
+        g_free (lang_code);
+      }
+    }
+
+    /* If we are still failed to find language name then check if external
+     * subtitle is loaded and compare the stream index between current sub
+     * stream index with our stream index and if matches then declare it as
+     * external subtitle and use the filename.
+     */
+    if (!info->language) {
+      gint text_index = -1;
+      gchar *suburi = NULL;
+
+      g_object_get (G_OBJECT (self->playbin), "current-suburi", &suburi, NULL);
+      if (suburi) {
+        g_object_get (G_OBJECT (self->playbin), "current-text", &text_index,
+            NULL);
+        if (text_index == gst_player_stream_info_get_index (stream_info))
+          info->language = g_path_get_basename (suburi);
+        g_free (suburi);
+      }
+    }
+
+  } else {
+    if (info->language) {
+      g_free (info->language);
+      info->language = NULL;
+    }
+  }
+
+  GST_DEBUG_OBJECT (self, "language=%s", info->language);
+}
+
+static void
+gst_player_video_info_update (GstPlayer * self,
+    GstPlayerStreamInfo * stream_info)
+{
+  GstPlayerVideoInfo *info = (GstPlayerVideoInfo *) stream_info;
+
+  if (stream_info->caps) {
+    GstStructure *s;
+
+    s = gst_caps_get_structure (stream_info->caps, 0);
+    if (s) {
+      gint width, height;
+      gint fps_n, fps_d;
+      gint par_n, par_d;
+
+      if (gst_structure_get_int (s, "width", &width))
+        info->width = width;
+      else
+        info->width = -1;
+
+      if (gst_structure_get_int (s, "height", &height))
+        info->height = height;
+      else
+        info->height = -1;
+
+      if (gst_structure_get_fraction (s, "framerate", &fps_n, &fps_d)) {
+        info->framerate_num = fps_n;
+        info->framerate_denom = fps_d;
+      } else {
+        info->framerate_num = 0;
+        info->framerate_denom = 1;
+      }
+
+
+      if (gst_structure_get_fraction (s, "pixel-aspect-ratio", &par_n, &par_d)) {
+        info->par_num = par_n;
+        info->par_denom = par_d;
+      } else {
+        info->par_num = 1;
+        info->par_denom = 1;
+      }
+    }
+  } else {
+    info->width = info->height = -1;
+    info->par_num = info->par_denom = 1;
+    info->framerate_num = 0;
+    info->framerate_denom = 1;
+  }
+
+  if (stream_info->tags) {
+    guint bitrate, max_bitrate;
+
+    if (gst_tag_list_get_uint (stream_info->tags, GST_TAG_BITRATE, &bitrate))
+      info->bitrate = bitrate;
+    else
+      info->bitrate = -1;
+
+    if (gst_tag_list_get_uint (stream_info->tags, GST_TAG_MAXIMUM_BITRATE,
+            &max_bitrate) || gst_tag_list_get_uint (stream_info->tags,
+            GST_TAG_NOMINAL_BITRATE, &max_bitrate))
+      info->max_bitrate = max_bitrate;
+    else
+      info->max_bitrate = -1;
+  } else {
+    info->bitrate = info->max_bitrate = -1;
+  }
+
+  GST_DEBUG_OBJECT (self, "width=%d height=%d fps=%.2f par=%d:%d "
+      "bitrate=%d max_bitrate=%d", info->width, info->height,
+      (gdouble) info->framerate_num / info->framerate_denom,
+      info->par_num, info->par_denom, info->bitrate, info->max_bitrate);
+}
+
+static void
+gst_player_audio_info_update (GstPlayer * self,
+    GstPlayerStreamInfo * stream_info)
+{
+  GstPlayerAudioInfo *info = (GstPlayerAudioInfo *) stream_info;
+
+  if (stream_info->caps) {
+    GstStructure *s;
+
+    s = gst_caps_get_structure (stream_info->caps, 0);
+    if (s) {
+      gint rate, channels;
+
+      if (gst_structure_get_int (s, "rate", &rate))
+        info->sample_rate = rate;
+      else
+        info->sample_rate = -1;
+
+      if (gst_structure_get_int (s, "channels", &channels))
+        info->channels = channels;
+      else
+        info->channels = 0;
+    }
+  } else {
+    info->sample_rate = -1;
+    info->channels = 0;
+  }
+
+  if (stream_info->tags) {
+    guint bitrate, max_bitrate;
+
+    if (gst_tag_list_get_uint (stream_info->tags, GST_TAG_BITRATE, &bitrate))
+      info->bitrate = bitrate;
+    else
+      info->bitrate = -1;
+
+    if (gst_tag_list_get_uint (stream_info->tags, GST_TAG_MAXIMUM_BITRATE,
+            &max_bitrate) || gst_tag_list_get_uint (stream_info->tags,
+            GST_TAG_NOMINAL_BITRATE, &max_bitrate))
+      info->max_bitrate = max_bitrate;
+    else
+      info->max_bitrate = -1;
+
+    /* if we have old language the free it */
+    if (info->language) {
+      g_free (info->language);
+      info->language = NULL;
+    }
+
+    /* First try to get the language full name from tag, if name is not
+     * available then try language code. If we find the language code
+     * then use gstreamer api to translate code to full name.
+     */
+    gst_tag_list_get_string (stream_info->tags, GST_TAG_LANGUAGE_NAME,
+        &info->language);
+    if (!info->language) {
+      gchar *lang_code = NULL;
+
+      gst_tag_list_get_string (stream_info->tags, GST_TAG_LANGUAGE_CODE,
+          &lang_code);
+      if (lang_code) {
+        info->language = g_strdup (gst_tag_get_language_name (lang_code));
+        g_free (lang_code);
+      }
+    }
+  } else {
+    if (info->language) {
+      g_free (info->language);
+      info->language = NULL;
+    }
+    info->max_bitrate = info->bitrate = -1;
+  }
+
+  GST_DEBUG_OBJECT (self, "language=%s rate=%d channels=%d bitrate=%d "
+      "max_bitrate=%d", info->language, info->sample_rate, info->channels,
+      info->bitrate, info->bitrate);
+}
+
+static GstPlayerStreamInfo *
+gst_player_stream_info_find (GstPlayer * self, GstPlayerMediaInfo * media_info,
+    GType type, gint stream_index)
+{
+  GList *list, *l;
+  GstPlayerStreamInfo *info = NULL;
+
+  if (!media_info)
+    return NULL;
+
+  list = gst_player_media_info_get_stream_list (media_info);
+  for (l = list; l != NULL; l = l->next) {
+    info = (GstPlayerStreamInfo *) l->data;
+    if ((G_OBJECT_TYPE (info) == type) && (info->stream_index == stream_index)) {
+      return info;
+    }
+  }
+
+  return NULL;
+}
+
+static gboolean
+is_track_enabled (GstPlayer * self, gint pos)
+{
+  gint flags;
+
+  g_object_get (G_OBJECT (self->playbin), "flags", &flags, NULL);
+
+  if ((flags & pos))
+    return TRUE;
+
+  return FALSE;
+}
+
+static GstPlayerStreamInfo *
+gst_player_stream_info_get_current (GstPlayer * self, const gchar * prop,
+    GType type)
+{
+  gint current;
+  GstPlayerStreamInfo *info;
+
+  if (!self->media_info)
+    return NULL;
+
+  g_object_get (G_OBJECT (self->playbin), prop, &current, NULL);
+  g_mutex_lock (&self->lock);
+  info = gst_player_stream_info_find (self, self->media_info, type, current);
+  if (info)
+    info = gst_player_stream_info_copy (info);
+  g_mutex_unlock (&self->lock);
+
+  return info;
+}
+
+static void
+gst_player_stream_info_update (GstPlayer * self, GstPlayerStreamInfo * s)
+{
+  if (GST_IS_PLAYER_VIDEO_INFO (s))
+    gst_player_video_info_update (self, s);
+  else if (GST_IS_PLAYER_AUDIO_INFO (s))
+    gst_player_audio_info_update (self, s);
+  else
+    gst_player_subtitle_info_update (self, s);
+}
+
+static gchar *
+stream_info_get_codec (GstPlayerStreamInfo * s)
+{
+  const gchar *type;
+  GstTagList *tags;
+  gchar *codec = NULL;
+
+  if (GST_IS_PLAYER_VIDEO_INFO (s))
+    type = GST_TAG_VIDEO_CODEC;
+  else if (GST_IS_PLAYER_AUDIO_INFO (s))
+    type = GST_TAG_AUDIO_CODEC;
+  else
+    type = GST_TAG_SUBTITLE_CODEC;
+
+  tags = gst_player_stream_info_get_tags (s);
+  if (tags) {
+    gst_tag_list_get_string (tags, type, &codec);
+    if (!codec)
+      gst_tag_list_get_string (tags, GST_TAG_CODEC, &codec);
+  }
+
+  if (!codec) {
+    GstCaps *caps;
+    caps = gst_player_stream_info_get_caps (s);
+    if (caps) {
+      codec = gst_pb_utils_get_codec_description (caps);
+    }
+  }
+
+  return codec;
+}
+
+static void
+gst_player_stream_info_update_tags_and_caps (GstPlayer * self,
+    GstPlayerStreamInfo * s)
+{
+  GstTagList *tags;
+  gint stream_index;
+
+  stream_index = gst_player_stream_info_get_index (s);
+
+  if (GST_IS_PLAYER_VIDEO_INFO (s))
+    g_signal_emit_by_name (self->playbin, "get-video-tags",
+        stream_index, &tags);
+  else if (GST_IS_PLAYER_AUDIO_INFO (s))
+    g_signal_emit_by_name (self->playbin, "get-audio-tags",
+        stream_index, &tags);
+  else
+    g_signal_emit_by_name (self->playbin, "get-text-tags", stream_index, &tags);
+
+  if (s->tags)
+    gst_tag_list_unref (s->tags);
+  s->tags = tags;
+
+  if (s->caps)
+    gst_caps_unref (s->caps);
+  s->caps = get_caps (self, stream_index, G_OBJECT_TYPE (s));
+
+  if (s->codec)
+    g_free (s->codec);
+  s->codec = stream_info_get_codec (s);
+
+  GST_DEBUG_OBJECT (self, "%s index: %d tags: %p caps: %p",
+      gst_player_stream_info_get_stream_type (s), stream_index,
+      s->tags, s->caps);
+
+  gst_player_stream_info_update (self, s);
+}
+
+static void
+gst_player_streams_info_create (GstPlayer * self,
+    GstPlayerMediaInfo * media_info, const gchar * prop, GType type)
+{
+  gint i;
+  gint total = -1;
+  GstPlayerStreamInfo *s;
+
+  if (!media_info)
+    return;
+
+  g_object_get (G_OBJECT (self->playbin), prop, &total, NULL);
+
+  GST_DEBUG_OBJECT (self, "%s: %d", prop, total);
+
+  for (i = 0; i < total; i++) {
+    /* check if stream already exist in the list */
+    s = gst_player_stream_info_find (self, media_info, type, i);
+
+    if (!s) {
+      /* create a new stream info instance */
+      s = gst_player_stream_info_new (i, type);
+
+      /* add the object in stream list */
+      media_info->stream_list = g_list_append (media_info->stream_list, s);
+
+      /* based on type, add the object in its corresponding stream_ list */
+      if (GST_IS_PLAYER_AUDIO_INFO (s))
+        media_info->audio_stream_list = g_list_append
+            (media_info->audio_stream_list, s);
+      else if (GST_IS_PLAYER_VIDEO_INFO (s))
+        media_info->video_stream_list = g_list_append
+            (media_info->video_stream_list, s);
+      else
+        media_info->subtitle_stream_list = g_list_append
+            (media_info->subtitle_stream_list, s);
+
+      GST_DEBUG_OBJECT (self, "create %s stream stream_index: %d",
+          gst_player_stream_info_get_stream_type (s), i);
+    }
+
+    gst_player_stream_info_update_tags_and_caps (self, s);
+  }
+}
+
+static void
+video_changed_cb (GObject * object, gpointer user_data)
+{
+  GstPlayer *self = GST_PLAYER (user_data);
+
+  g_mutex_lock (&self->lock);
+  gst_player_streams_info_create (self, self->media_info,
+      "n-video", GST_TYPE_PLAYER_VIDEO_INFO);
+  g_mutex_unlock (&self->lock);
+
+  g_main_context_invoke_full (self->context, G_PRIORITY_DEFAULT,
+      gst_player_update_track_decoders_internal, self, NULL);
+}
+
+static void
+audio_changed_cb (GObject * object, gpointer user_data)
+{
+  GstPlayer *self = GST_PLAYER (user_data);
+
+  g_mutex_lock (&self->lock);
+  gst_player_streams_info_create (self, self->media_info,
+      "n-audio", GST_TYPE_PLAYER_AUDIO_INFO);
+  g_mutex_unlock (&self->lock);
+
+  g_main_context_invoke_full (self->context, G_PRIORITY_DEFAULT,
+      gst_player_update_track_decoders_internal, self, NULL);
+}
+
+static void
+subtitle_changed_cb (GObject * object, gpointer user_data)
+{
+  GstPlayer *self = GST_PLAYER (user_data);
+
+  update_subtitles_shown (self);
+
+  g_mutex_lock (&self->lock);
+  gst_player_streams_info_create (self, self->media_info,
+      "n-text", GST_TYPE_PLAYER_SUBTITLE_INFO);
+  g_mutex_unlock (&self->lock);
+}
+
+static void *
+get_title (GstTagList * tags)
+{
+  gchar *title = NULL;
+
+  gst_tag_list_get_string (tags, GST_TAG_TITLE, &title);
+  if (!title)
+    gst_tag_list_get_string (tags, GST_TAG_TITLE_SORTNAME, &title);
+
+  return title;
+}
+
+static void *
+get_container_format (GstTagList * tags)
+{
+  gchar *container = NULL;
+
+  gst_tag_list_get_string (tags, GST_TAG_CONTAINER_FORMAT, &container);
+
+  /* TODO: If container is not available then maybe consider
+   * parsing caps or file extension to guess the container format.
+   */
+
+  return container;
+}
+
+static void *
+get_from_tags (GstPlayer * self, GstPlayerMediaInfo * media_info,
+    void *(*func) (GstTagList *))
+{
+  GList *l;
+  void *ret = NULL;
+
+  if (media_info->tags) {
+    ret = func (media_info->tags);
+    if (ret)
+      return ret;
+  }
+
+  /* if global tag does not exit then try video and audio streams */
+  GST_DEBUG_OBJECT (self, "trying video tags");
+  for (l = gst_player_get_video_streams (media_info); l != NULL; l = l->next) {
+    GstTagList *tags;
+
+    tags = gst_player_stream_info_get_tags ((GstPlayerStreamInfo *) l->data);
+    if (tags)
+      ret = func (tags);
+
+    if (ret)
+      return ret;
+  }
+
+  GST_DEBUG_OBJECT (self, "trying audio tags");
+  for (l = gst_player_get_audio_streams (media_info); l != NULL; l = l->next) {
+    GstTagList *tags;
+
+    tags = gst_player_stream_info_get_tags ((GstPlayerStreamInfo *) l->data);
+    if (tags)
+      ret = func (tags);
+
+    if (ret)
+      return ret;
+  }
+
+  GST_DEBUG_OBJECT (self, "failed to get the information from tags");
+  return NULL;
+}
+
+static void *
+get_cover_sample (GstTagList * tags)
+{
+  GstSample *cover_sample = NULL;
+
+  gst_tag_list_get_sample (tags, GST_TAG_IMAGE, &cover_sample);
+  if (!cover_sample)
+    gst_tag_list_get_sample (tags, GST_TAG_PREVIEW_IMAGE, &cover_sample);
+
+  return cover_sample;
+}
+
+static GstPlayerMediaInfo *
+gst_player_media_info_create (GstPlayer * self)
+{
+  GstPlayerMediaInfo *media_info;
+  GstQuery *query;
+
+  GST_DEBUG_OBJECT (self, "begin");
+  media_info = gst_player_media_info_new (self->uri);
+  media_info->duration = gst_player_get_duration (self);
+  media_info->tags = self->global_tags;
+  self->global_tags = NULL;
+
+  query = gst_query_new_seeking (GST_FORMAT_TIME);
+  if (gst_element_query (self->playbin, query))
+    gst_query_parse_seeking (query, NULL, &media_info->seekable, NULL, NULL);
+  gst_query_unref (query);
+
+  /* create audio/video/sub streams */
+  gst_player_streams_info_create (self, media_info, "n-video",
+      GST_TYPE_PLAYER_VIDEO_INFO);
+  gst_player_streams_info_create (self, media_info, "n-audio",
+      GST_TYPE_PLAYER_AUDIO_INFO);
+  gst_player_streams_info_create (self, media_info, "n-text",
+      GST_TYPE_PLAYER_SUBTITLE_INFO);
+
+  media_info->title = get_from_tags (self, media_info, get_title);
+  media_info->container =
+      get_from_tags (self, media_info, get_container_format);
+  media_info->image_sample = get_from_tags (self, media_info, get_cover_sample);
+
+  GST_DEBUG_OBJECT (self, "uri: %s title: %s duration: %" GST_TIME_FORMAT
+      " seekable: %s container: %s image_sample %p",
+      media_info->uri, media_info->title, GST_TIME_ARGS (media_info->duration),
+      media_info->seekable ? "yes" : "no", media_info->container,
+      media_info->image_sample);
+
+  GST_DEBUG_OBJECT (self, "end");
+  return media_info;
+}
+
+static void
+tags_changed_cb (GstPlayer * self, gint stream_index, GType type)
+{
+  GstPlayerStreamInfo *s;
+
+  if (!self->media_info)
+    return;
+
+  /* update the stream information */
+  g_mutex_lock (&self->lock);
+  s = gst_player_stream_info_find (self, self->media_info, type, stream_index);
+  gst_player_stream_info_update_tags_and_caps (self, s);
+  g_mutex_unlock (&self->lock);
+
+  emit_media_info_updated_signal (self);
+}
+
+static void
+video_tags_changed_cb (GstElement * playbin, gint stream_index,
+    gpointer user_data)
+{
+  tags_changed_cb (GST_PLAYER (user_data), stream_index,
+      GST_TYPE_PLAYER_VIDEO_INFO);
+}
+
+static void
+audio_tags_changed_cb (GstElement * playbin, gint stream_index,
+    gpointer user_data)
+{
+  tags_changed_cb (GST_PLAYER (user_data), stream_index,
+      GST_TYPE_PLAYER_AUDIO_INFO);
+}
+
+static void
+subtitle_tags_changed_cb (GstElement * playbin, gint stream_index,
+    gpointer user_data)
+{
+  tags_changed_cb (GST_PLAYER (user_data), stream_index,
+      GST_TYPE_PLAYER_SUBTITLE_INFO);
+}
+
+static void
+volume_changed_dispatch (gpointer user_data)
+{
+  g_signal_emit (user_data, signals[SIGNAL_VOLUME_CHANGED], 0);
+  g_object_notify_by_pspec (G_OBJECT (user_data), param_specs[PROP_VOLUME]);
+}
+
+static void inline
+volume_notify_cb (GObject * obj, GParamSpec * pspec, GstPlayer * self)
+{
+  if (g_signal_handler_find (self, G_SIGNAL_MATCH_ID,
+          signals[SIGNAL_VOLUME_CHANGED], 0, NULL, NULL, NULL) != 0) {
+    gst_player_signal_dispatcher_dispatch (self->signal_dispatcher, self,
+        volume_changed_dispatch, g_object_ref (self),
+        (GDestroyNotify) g_object_unref);
+  }
+}
+
+static void
+mute_changed_dispatch (gpointer user_data)
+{
+  g_signal_emit (user_data, signals[SIGNAL_MUTE_CHANGED], 0);
+  g_object_notify_by_pspec (G_OBJECT (user_data), param_specs[PROP_MUTE]);
+}
+
+static void inline
+mute_notify_cb (GObject * obj, GParamSpec * pspec, GstPlayer * self)
+{
+  if (g_signal_handler_find (self, G_SIGNAL_MATCH_ID,
+          signals[SIGNAL_MUTE_CHANGED], 0, NULL, NULL, NULL) != 0) {
+    gst_player_signal_dispatcher_dispatch (self->signal_dispatcher, self,
+        mute_changed_dispatch, g_object_ref (self),
+        (GDestroyNotify) g_object_unref);
+  }
+}
+
+static gboolean
+autoplug_continue_cb (GstElement * uridecodebin, GstPad * pad, GstCaps * caps,
+    gpointer user_data)
+{
+  /* Make sure the plugins that could handle these caps are registered
+   * before decodebin looks for factories */
+  gst_player_plugin_loader_ensure_caps (caps);
+
+  return TRUE;
+}
+
+static GMutex decodable_lock;
+static GList *decodable_factories;
+static guint32 decodable_cookie;
+
+/* Same list uridecodebin uses by default, kept up to date with the registry */
+static GList *
+filter_decodable_factories (const GstCaps * caps, gboolean subsetonly)
+{
+  GList *factories;
+
+  g_mutex_lock (&decodable_lock);
+  if (!decodable_factories
+      || gst_registry_get_feature_list_cookie (gst_registry_get ()) !=
+      decodable_cookie) {
+    gst_plugin_feature_list_free (decodable_factories);
+    decodable_factories =
+        gst_element_factory_list_get_elements
+        (GST_ELEMENT_FACTORY_TYPE_DECODABLE, GST_RANK_MARGINAL);
+    decodable_factories =
+        g_list_sort (decodable_factories,
+        gst_plugin_feature_rank_compare_func);
+    decodable_cookie =
+        gst_registry_get_feature_list_cookie (gst_registry_get ());
+  }
+  factories =
+      gst_element_factory_list_filter (decodable_factories, caps, GST_PAD_SINK,
+      subsetonly);
+  g_mutex_unlock (&decodable_lock);
+
+  return factories;
+}
+
+/* Must be called with lock */
+static void
+gst_player_build_hint_factories_locked (GstPlayer * self)
+{
+  GstCaps *caps;
+  GList *factories, *l;
+  guint i;
+
+  for (i = 0; i < gst_caps_get_size (self->active_format_hint); i++) {
+    caps = gst_caps_copy_nth (self->active_format_hint, i);
+    gst_player_plugin_loader_ensure_caps (caps);
+    factories = filter_decodable_factories (caps, FALSE);
+    gst_caps_unref (caps);
+
+    for (l = factories; l; l = l->next) {
+      if (!g_list_find (self->hint_factories, l->data))
+        self->hint_factories =
+            g_list_prepend (self->hint_factories, gst_object_ref (l->data));
+    }
+    gst_plugin_feature_list_free (factories);
+  }
+
+  self->hint_factories =
+      g_list_sort (self->hint_factories, gst_plugin_feature_rank_compare_func);
+}
+
+typedef struct
+{
+  GstPlayer *player;
+  const gchar *preferred;
+} DecoderRankData;
+
+/* Must be called with lock */
+static guint
+gst_player_get_decoder_rank_locked (GstPlayer * self,
+    GstPluginFeature * feature, const gchar * preferred)
+{
+  const gchar *name = gst_plugin_feature_get_name (feature);
+  guint rank = gst_plugin_feature_get_rank (feature);
+  gpointer value;
+
+  if (g_hash_table_lookup_extended (self->decoder_ranks, name, NULL, &value))
+    return GPOINTER_TO_UINT (value);
+
+  if (preferred && strcmp (preferred, name) == 0)
+    return MAX (rank, GST_RANK_PRIMARY + 1);
+
+  return rank;
+}
+
+static gint
+compare_decoder_rank (gconstpointer a, gconstpointer b, gpointer user_data)
+{
+  DecoderRankData *data = user_data;
+  guint rank_a, rank_b;
+
+  rank_a = gst_player_get_decoder_rank_locked (data->player,
+      GST_PLUGIN_FEATURE (a), data->preferred);
+  rank_b = gst_player_get_decoder_rank_locked (data->player,
+      GST_PLUGIN_FEATURE (b), data->preferred);
+
+  if (rank_a != rank_b)
+    return rank_b > rank_a ? 1 : -1;
+
+  return strcmp (GST_OBJECT_NAME (a), GST_OBJECT_NAME (b));
+}
+
+/* Removes decoders excluded by the allow and deny lists and sorts the rest
+ * by the ranks set by the application, preferring the probed decoder for
+ * the caps otherwise */
+static GList *
+gst_player_apply_decoder_policy (GstPlayer * self, GstCaps * caps,
+    GList * factories)
+{
+  GstStructure *s = gst_caps_get_structure (caps, 0);
+  DecoderRankData data;
+  gchar *preferred;
+  gint width = 0, height = 0;
+  GList *l, *next;
+
+  gst_structure_get_int (s, "width", &width);
+  gst_structure_get_int (s, "height", &height);
+  preferred =
+      gst_player_decoder_probe_get_preferred (gst_structure_get_name (s),
+      width, height);
+
+  g_mutex_lock (&self->lock);
+  for (l = factories; l; l = next) {
+    const gchar *name = gst_plugin_feature_get_name (l->data);
+
+    next = l->next;
+    if (!gst_element_factory_list_is_type (l->data,
+            GST_ELEMENT_FACTORY_TYPE_DECODER))
+      continue;
+
+    if ((self->decoder_denylist
+            && g_strv_contains ((const gchar * const *) self->decoder_denylist,
+                name)) || (self->decoder_allowlist
+            && !g_strv_contains ((const gchar * const *)
+                self->decoder_allowlist, name))) {
+      GST_DEBUG_OBJECT (self, "Decoder %s not allowed by policy", name);
+      gst_object_unref (l->data);
+      factories = g_list_delete_link (factories, l);
+    }
+  }
+
+  data.player = self;
+  data.preferred = preferred;
+  factories = g_list_sort_with_data (factories, compare_decoder_rank, &data);
+  g_mutex_unlock (&self->lock);
+
+  g_free (preferred);
+
+  return factories;
+}
+
+G_GNUC_BEGIN_IGNORE_DEPRECATIONS
+
+static GValueArray *
+autoplug_factories_cb (GstElement * uridecodebin, GstPad * pad,
+    GstCaps * caps, gpointer user_data)
+{
+  GstPlayer *self = GST_PLAYER (user_data);
+  GList *factories = NULL, *l;
+  GValueArray *result;
+  GValue val = G_VALUE_INIT;
+
+  /* Only look at the factories that can handle the hinted formats, which
+   * are far fewer than all decodable factories */
+  g_mutex_lock (&self->lock);
+  if (self->active_format_hint) {
+    if (!self->hint_factories)
+      gst_player_build_hint_factories_locked (self);
+
+    factories =
+        gst_element_factory_list_filter (self->hint_factories, caps,
+        GST_PAD_SINK, gst_caps_is_fixed (caps));
+    if (factories)
+      self->format_hint_hits++;
+    else
+      format_hint_miss_locked (self);
+  }
+  g_mutex_unlock (&self->lock);
+
+  if (!factories)
+    factories = filter_decodable_factories (caps, gst_caps_is_fixed (caps));
+
+  factories = gst_player_apply_decoder_policy (self, caps, factories);
+
+  result = g_value_array_new (g_list_length (factories));
+  g_value_init (&val, G_TYPE_OBJECT);
+  for (l = factories; l; l = l->next) {
+    g_value_set_object (&val, l->data);
+    g_value_array_append (result, &val);
+  }
+  g_value_unset (&val);
+  gst_plugin_feature_list_free (factories);
+
+  return result;
+}
+
+G_GNUC_END_IGNORE_DEPRECATIONS
+
+typedef struct
+{
+  GstPlayer *player;
+  GstPlayerRestreamType type;
+} RestreamProbeData;
+
+static GstPadProbeReturn
+restream_probe_cb (GstPad * pad, GstPadProbeInfo * info, gpointer user_data)
+{
+  RestreamProbeData *data = user_data;
+  GstPlayer *self = data->player;
+  GstPlayerRestream *restream;
+  GstEvent *event;
+  GstCaps *caps;
+
+  g_mutex_lock (&self->lock);
+  restream = self->restream ? gst_player_restream_ref (self->restream) : NULL;
+  g_mutex_unlock (&self->lock);
+
+  if (!restream)
+    return GST_PAD_PROBE_OK;
+
+  if (GST_PAD_PROBE_INFO_TYPE (info) & GST_PAD_PROBE_TYPE_BUFFER) {
+    gst_player_restream_push (restream, data->type, pad,
+        GST_PAD_PROBE_INFO_BUFFER (info));
+  } else {
+    event = GST_PAD_PROBE_INFO_EVENT (info);
+    switch (GST_EVENT_TYPE (event)) {
+      case GST_EVENT_CAPS:
+        gst_event_parse_caps (event, &caps);
+        gst_player_restream_set_caps (restream, data->type, pad, caps);
+        break;
+      case GST_EVENT_STREAM_START:
+      case GST_EVENT_SEGMENT:
+      case GST_EVENT_FLUSH_STOP:
+        gst_player_restream_reset (restream);
+        break;
+      default:
+        break;
+    }
+  }
+  gst_player_restream_unref (restream);
+
+  return GST_PAD_PROBE_OK;
+}
+
+/* Taps the still encoded output of H.264 and AAC parsers for restreaming */
+static void
+add_restream_probe (GstPlayer * self, GstElementFactory * factory,
+    GstElement * element)
+{
+  RestreamProbeData *data;
+  GstPlayerRestreamType type;
+  const GList *l;
+  GstCaps *caps;
+  GstPad *pad;
+  gboolean found = FALSE;
+
+  for (l = gst_element_factory_get_static_pad_templates (factory); l;
+      l = l->next) {
+    GstStaticPadTemplate *templ = l->data;
+
+    if (templ->direction != GST_PAD_SRC)
+      continue;
+
+    caps = gst_static_caps_get (&templ->static_caps);
+    found = gst_player_restream_get_type_for_caps (caps, &type);
+    gst_caps_unref (caps);
+    break;
+  }
+
+  if (!found)
+    return;
+
+  pad = gst_element_get_static_pad (element, "src");
+  if (!pad)
+    return;
+
+  data = g_new (RestreamProbeData, 1);
+  data->player = self;
+  data->type = type;
+  gst_pad_add_probe (pad,
+      GST_PAD_PROBE_TYPE_BUFFER | GST_PAD_PROBE_TYPE_EVENT_DOWNSTREAM,
+      restream_probe_cb, data, g_free);
+  gst_object_unref (pad);
+}
+
+/* Must be called from main context */
+static void
+save_keyframe_index (GstPlayer * self)
+{
+  GstPlayerKeyframeIndex *index;
+
+  g_mutex_lock (&self->lock);
+  index = self->keyframe_index;
+  self->keyframe_index = NULL;
+  g_mutex_unlock (&self->lock);
+
+  if (!index)
+    return;
+
+  /* Live streams can't be seeked in */
+  if (!self->is_live)
+    gst_player_keyframe_index_save (index);
+  gst_player_keyframe_index_unref (index);
+}
+
+static void
+add_keyframe_index (GstPlayer * self, GstBin * decodebin, GstElement * flvdemux)
+{
+  GstPlayerKeyframeIndex *index, *old;
+  GstObject *uridecodebin;
+  gchar *uri = NULL;
+
+  uridecodebin = gst_object_get_parent (GST_OBJECT (decodebin));
+  if (uridecodebin) {
+    if (g_object_class_find_property (G_OBJECT_GET_CLASS (uridecodebin),
+            "uri"))
+      g_object_get (uridecodebin, "uri", &uri, NULL);
+    gst_object_unref (uridecodebin);
+  }
+  /* Fed by the application, for example GstPlayerZapper */
+  if (!uri || g_str_has_prefix (uri, "appsrc:")) {
+    g_free (uri);
+    return;
+  }
+
+  index = gst_player_keyframe_index_new (uri);
+  gst_player_keyframe_index_attach (index, flvdemux);
+  g_free (uri);
+
+  /* The index of the previous playlist item is complete */
+  g_mutex_lock (&self->lock);
+  old = self->keyframe_index;
+  self->keyframe_index = index;
+  g_mutex_unlock (&self->lock);
+
+  if (old) {
+    gst_player_keyframe_index_save (old);
+    gst_player_keyframe_index_unref (old);
+  }
+}
+
+static TrackDecoder *
+track_decoder_ref (TrackDecoder * decoder)
+{
+  g_atomic_int_inc (&decoder->ref_count);
+
+  return decoder;
+}
+
+static void
+track_decoder_unref (TrackDecoder * decoder)
+{
+  if (!g_atomic_int_dec_and_test (&decoder->ref_count))
+    return;
+
+  gst_object_unref (decoder->decoder);
+  gst_object_unref (decoder->srcpad);
+  g_free (decoder);
+}
+
+static GstPadProbeReturn
+track_decoder_probe_cb (GstPad * pad, GstPadProbeInfo * info,
+    gpointer user_data)
+{
+  TrackDecoder *decoder = user_data;
+  GstPlayer *self = decoder->player;
+  GstBuffer *buffer = GST_PAD_PROBE_INFO_BUFFER (info);
+
+  /* Until the decoder has output caps the track's details are unknown */
+  if (!g_atomic_int_get (&decoder->selected)
+      && gst_pad_has_current_caps (decoder->srcpad)) {
+    decoder->dropping = TRUE;
+    goto drop;
+  }
+
+  if (!decoder->dropping)
+    return GST_PAD_PROBE_OK;
+
+  /* Video can only be decoded again from a keyframe */
+  if (decoder->video
+      && GST_BUFFER_FLAG_IS_SET (buffer, GST_BUFFER_FLAG_DELTA_UNIT))
+    goto drop;
+
+  decoder->dropping = FALSE;
+  buffer = gst_buffer_make_writable (buffer);
+  GST_BUFFER_FLAG_SET (buffer, GST_BUFFER_FLAG_DISCONT);
+  GST_PAD_PROBE_INFO_DATA (info) = buffer;
+
+  g_mutex_lock (&self->lock);
+  if (GST_CLOCK_TIME_IS_VALID (decoder->selected_time)) {
+    self->track_switch_latency =
+        gst_util_get_timestamp () - decoder->selected_time;
+    decoder->selected_time = GST_CLOCK_TIME_NONE;
+    GST_DEBUG_OBJECT (self, "%s resumed after %" GST_TIME_FORMAT,
+        GST_ELEMENT_NAME (decoder->decoder),
+        GST_TIME_ARGS (self->track_switch_latency));
+  }
+  g_mutex_unlock (&self->lock);
+
+  return GST_PAD_PROBE_OK;
+
+drop:
+  g_mutex_lock (&self->lock);
+  self->n_unselected_dropped++;
+  g_mutex_unlock (&self->lock);
+
+  return GST_PAD_PROBE_DROP;
+}
+
+static void
+add_track_decoder (GstPlayer * self, GstElementFactory * factory,
+    GstElement * element)
+{
+  TrackDecoder *decoder;
+  GstPad *sinkpad, *srcpad;
+  gboolean video;
+
+  video = gst_element_factory_list_is_type (factory,
+      GST_ELEMENT_FACTORY_TYPE_MEDIA_VIDEO);
+  if (!video && !gst_element_factory_list_is_type (factory,
+          GST_ELEMENT_FACTORY_TYPE_MEDIA_AUDIO))
+    return;
+
+  sinkpad = gst_element_get_static_pad (element, "sink");
+  srcpad = gst_element_get_static_pad (element, "src");
+  if (!sinkpad || !srcpad)
+    goto done;
+
+  /* Decodes until the selection is known */
+  decoder = g_new0 (TrackDecoder, 1);
+  decoder->ref_count = 1;
+  decoder->player = self;
+  decoder->decoder = gst_object_ref (element);
+  decoder->srcpad = gst_object_ref (srcpad);
+  decoder->video = video;
+  decoder->selected = TRUE;
+  decoder->selected_time = GST_CLOCK_TIME_NONE;
+
+  g_mutex_lock (&self->lock);
+  g_ptr_array_add (self->track_decoders, track_decoder_ref (decoder));
+  g_mutex_unlock (&self->lock);
+
+  gst_pad_add_probe (sinkpad, GST_PAD_PROBE_TYPE_BUFFER,
+      track_decoder_probe_cb, decoder,
+      (GDestroyNotify) track_decoder_unref);
+
+done:
+  if (sinkpad)
+    gst_object_unref (sinkpad);
+  if (srcpad)
+    gst_object_unref (srcpad);
+}
+
+/* Returns the decoder feeding @pad, following ghost pads and the
+ * capsfilters decodebin puts after decoders upstream */
+static GstElement *
+find_upstream_decoder (GstPad * pad)
+{
+  GstElementFactory *factory;
+  GstElement *element;
+  GstPad *target, *sinkpad;
+  guint i;
+
+  pad = gst_pad_get_peer (pad);
+  for (i = 0; pad && i < 16; i++) {
+    if (GST_IS_GHOST_PAD (pad)) {
+      target = gst_ghost_pad_get_target (GST_GHOST_PAD (pad));
+      gst_object_unref (pad);
+      pad = target;
+      continue;
+    }
+
+    element = gst_pad_get_parent_element (pad);
+    gst_object_unref (pad);
+    pad = NULL;
+    if (!element)
+      break;
+
+    factory = gst_element_get_factory (element);
+    if (factory && gst_element_factory_list_is_type (factory,
+            GST_ELEMENT_FACTORY_TYPE_DECODER))
+      return element;
+
+    sinkpad = gst_element_get_static_pad (element, "sink");
+    if (sinkpad) {
+      pad = gst_pad_get_peer (sinkpad);
+      gst_object_unref (sinkpad);
+    }
+    gst_object_unref (element);
+  }
+
+  if (pad)
+    gst_object_unref (pad);
+
+  return NULL;
+}
+
+/* Selects the decoders that feed the current audio and video track */
+static gboolean
+gst_player_update_track_decoders_internal (gpointer user_data)
+{
+  static const gchar *current[] = { "current-audio", "current-video" };
+  static const gchar *get_pad[] = { "get-audio-pad", "get-video-pad" };
+  GstPlayer *self = GST_PLAYER (user_data);
+  GstElement *selected[2] = { NULL, NULL };
+  TrackDecoder *decoder;
+  GstObject *parent;
+  GstClockTime now;
+  gboolean enabled, select;
+  GstPad *pad;
+  gint index;
+  guint i;
+
+  g_mutex_lock (&self->lock);
+  enabled = self->decode_selected_only;
+  g_mutex_unlock (&self->lock);
+
+  for (i = 0; enabled && i < G_N_ELEMENTS (selected); i++) {
+    pad = NULL;
+    g_object_get (self->playbin, current[i], &index, NULL);
+    if (index >= 0)
+      g_signal_emit_by_name (self->playbin, get_pad[i], index, &pad);
+    if (pad) {
+      selected[i] = find_upstream_decoder (pad);
+      gst_object_unref (pad);
+    }
+  }
+
+  now = gst_util_get_timestamp ();
+  g_mutex_lock (&self->lock);
+  for (i = self->track_decoders->len; i > 0; i--) {
+    decoder = g_ptr_array_index (self->track_decoders, i - 1);
+
+    /* Removed with the previous stream */
+    parent = gst_object_get_parent (GST_OBJECT (decoder->decoder));
+    if (!parent) {
+      g_ptr_array_remove_index_fast (self->track_decoders, i - 1);
+      continue;
+    }
+    gst_object_unref (parent);
+
+    /* Everything is decoded if the selected track is not found */
+    select = !selected[decoder->video]
+        || selected[decoder->video] == decoder->decoder;
+    if (select && !g_atomic_int_get (&decoder->selected))
+      decoder->selected_time = now;
+    else if (!select)
+      decoder->selected_time = GST_CLOCK_TIME_NONE;
+    g_atomic_int_set (&decoder->selected, select);
+  }
+  g_mutex_unlock (&self->lock);
+
+  for (i = 0; i < G_N_ELEMENTS (selected); i++)
+    if (selected[i])
+      gst_object_unref (selected[i]);
+
+  return G_SOURCE_REMOVE;
+}
+
+static void
+decodebin_element_added_cb (GstBin * bin, GstElement * element,
+    gpointer user_data)
+{
+  GstPlayer *self = GST_PLAYER (user_data);
+  GstElementFactory *factory = gst_element_get_factory (element);
+  const GList *l;
+  const gchar *media_type = NULL;
+  GParamSpec *pspec;
+  gpointer value;
+  gboolean found;
+  guint n_threads;
+
+  /* Demuxers, parsers and decoders are measured from their first buffer */
+  gst_player_element_stats_watch (self->element_stats, bin);
+
+  if (factory
+      && strcmp (gst_plugin_feature_get_name (factory), "flvdemux") == 0) {
+    add_keyframe_index (self, bin, element);
+    return;
+  }
+
+  if (factory
+      && gst_element_factory_list_is_type (factory,
+          GST_ELEMENT_FACTORY_TYPE_PARSER)) {
+    add_restream_probe (self, factory, element);
+    return;
+  }
+
+  if (!factory
+      || !gst_element_factory_list_is_type (factory,
+          GST_ELEMENT_FACTORY_TYPE_DECODER))
+    return;
+
+  add_native_format_probe (self, element);
+  add_track_decoder (self, factory, element);
+
+  if (gst_element_factory_list_is_type (factory,
+          GST_ELEMENT_FACTORY_TYPE_MEDIA_VIDEO)) {
+    GstPad *pad = gst_element_get_static_pad (element, "sink");
+    GstPlayerDegradationLevel level;
+
+    if (pad) {
+      gst_pad_add_probe (pad, GST_PAD_PROBE_TYPE_BUFFER,
+          keyframes_only_probe_cb, self, NULL);
+      gst_object_unref (pad);
+    }
+
+    g_mutex_lock (&self->lock);
+    gst_object_replace ((GstObject **) & self->video_decoder,
+        GST_OBJECT (element));
+    level = self->degradation_level;
+    g_mutex_unlock (&self->lock);
+
+    if (level != GST_PLAYER_DEGRADATION_NONE)
+      apply_degradation_level (element, level);
+  }
+
+  for (l = gst_element_factory_get_static_pad_templates (factory); l;
+      l = l->next) {
+    GstStaticPadTemplate *templ = l->data;
+    GstCaps *caps;
+
+    if (templ->direction != GST_PAD_SINK)
+      continue;
+
+    caps = gst_static_caps_get (&templ->static_caps);
+    if (!gst_caps_is_any (caps) && !gst_caps_is_empty (caps))
+      media_type = gst_structure_get_name (gst_caps_get_structure (caps, 0));
+    gst_caps_unref (caps);
+    break;
+  }
+
+  g_mutex_lock (&self->lock);
+  found = media_type
+      && g_hash_table_lookup_extended (self->decoder_threads, media_type, NULL,
+      &value);
+  if (!found)
+    found = g_hash_table_lookup_extended (self->decoder_threads, "", NULL,
+        &value);
+  g_mutex_unlock (&self->lock);
+
+  if (!found)
+    return;
+
+  /* libav calls it max-threads, vpx just threads */
+  n_threads = GPOINTER_TO_UINT (value);
+  pspec = g_object_class_find_property (G_OBJECT_GET_CLASS (element),
+      "max-threads");
+  if (!pspec)
+    pspec = g_object_class_find_property (G_OBJECT_GET_CLASS (element),
+        "threads");
+  if (!pspec || !(pspec->flags & G_PARAM_WRITABLE)) {
+    GST_DEBUG_OBJECT (self, "Decoder %s has no thread setting",
+        GST_ELEMENT_NAME (element));
+    return;
+  }
+
+  GST_DEBUG_OBJECT (self, "Setting %s on %s to %u", pspec->name,
+      GST_ELEMENT_NAME (element), n_threads);
+
+  if (G_PARAM_SPEC_VALUE_TYPE (pspec) == G_TYPE_INT)
+    g_object_set (element, pspec->name, (gint) n_threads, NULL);
+  else if (G_PARAM_SPEC_VALUE_TYPE (pspec) == G_TYPE_UINT)
+    g_object_set (element, pspec->name, n_threads, NULL);
+}
+
+static void
+uridecodebin_element_added_cb (GstBin * bin, GstElement * element,
+    gpointer user_data)
+{
+  GstPlayer *self = GST_PLAYER (user_data);
+  GstElementFactory *factory = gst_element_get_factory (element);
+  GstElement *typefind = NULL;
+  GstCaps *caps;
+
+  if (!factory)
+    return;
+
+  /* Skip typefinding if the container format is known. uridecodebin
+   * typefinds itself for streams, decodebin always does */
+  if (strcmp (gst_plugin_feature_get_name (factory), "typefind") == 0)
+    typefind = gst_object_ref (element);
+  else if (strcmp (gst_plugin_feature_get_name (factory), "decodebin") == 0) {
+    g_signal_connect (element, "element-added",
+        G_CALLBACK (decodebin_element_added_cb), self);
+    typefind = gst_bin_get_by_name (GST_BIN (element), "typefind");
+  }
+
+  if (!typefind)
+    return;
+
+  g_mutex_lock (&self->lock);
+  if (self->active_format_hint) {
+    caps = gst_caps_copy_nth (self->active_format_hint, 0);
+    GST_DEBUG_OBJECT (self, "Forcing caps %" GST_PTR_FORMAT " on %s", caps,
+        GST_ELEMENT_NAME (typefind));
+    g_object_set (typefind, "force-caps", caps, NULL);
+    gst_caps_unref (caps);
+  }
+  g_mutex_unlock (&self->lock);
+
+  gst_object_unref (typefind);
+}
+
+static void
+no_more_pads_cb (GstElement * uridecodebin, gpointer user_data)
+{
+  GstPlayer *self = GST_PLAYER (user_data);
+  GstClockTime now = gst_util_get_timestamp ();
+
+  g_mutex_lock (&self->lock);
+  self->format_hint_confirmed = TRUE;
+  if (GST_CLOCK_TIME_IS_VALID (self->autoplug_start)) {
+    self->autoplug_time = GST_CLOCK_DIFF (self->autoplug_start, now);
+    self->autoplug_start = GST_CLOCK_TIME_NONE;
+
+    if (!self->active_format_hint) {
+      if (self->n_autoplug_unhinted == 0)
+        self->autoplug_time_unhinted = self->autoplug_time;
+      else
+        self->autoplug_time_unhinted =
+            (self->autoplug_time_unhinted * self->n_autoplug_unhinted +
+            self->autoplug_time) / (self->n_autoplug_unhinted + 1);
+      self->n_autoplug_unhinted++;
+    }
+
+    GST_DEBUG_OBJECT (self, "Autoplugging took %" GST_TIME_FORMAT,
+        GST_TIME_ARGS (self->autoplug_time));
+  }
+  g_mutex_unlock (&self->lock);
+}
+
+static GstPadProbeReturn
+source_first_buffer_cb (GstPad * pad, GstPadProbeInfo * info,
+    gpointer user_data)
+{
+  GstPlayer *self = GST_PLAYER (user_data);
+
+  g_mutex_lock (&self->lock);
+  self->autoplug_start = gst_util_get_timestamp ();
+  g_mutex_unlock (&self->lock);
+
+  return GST_PAD_PROBE_REMOVE;
+}
+
+static void
+source_setup_cb (GstElement * playbin, GstElement * source, gpointer user_data)
+{
+  GstPad *pad;
+
+  /* Autoplugging is timed from the first buffer the source produces, so
+   * that connection setup is not included */
+  pad = gst_element_get_static_pad (source, "src");
+  if (pad) {
+    gst_pad_add_probe (pad, GST_PAD_PROBE_TYPE_BUFFER,
+        source_first_buffer_cb, user_data, NULL);
+    gst_object_unref (pad);
+  }
+}
+
+static void
+element_added_cb (GstBin * bin, GstElement * element, gpointer user_data)
+{
+  GstElementFactory *factory = gst_element_get_factory (element);
+
+  if (factory && strcmp (gst_plugin_feature_get_name (factory),
+          "uridecodebin") == 0) {
+    g_signal_connect (element, "autoplug-continue",
+        G_CALLBACK (autoplug_continue_cb), user_data);
+    g_signal_connect (element, "autoplug-factories",
+        G_CALLBACK (autoplug_factories_cb), user_data);
+    g_signal_connect (element, "element-added",
+        G_CALLBACK (uridecodebin_element_added_cb), user_data);
+    g_signal_connect (element, "no-more-pads",
+        G_CALLBACK (no_more_pads_cb), user_data);
+  }
+}
+
+/* Called when flags or the current text stream change, which is rare
+ * compared to the number of frames that need to know about it */
+static void
+update_subtitles_shown (GstPlayer * self)
+{
+  gint flags, current_text;
+
+  g_object_get (self->playbin, "flags", &flags, "current-text", &current_text,
+      NULL);
+
+  g_atomic_int_set (&self->subtitles_shown,
+      (flags & GST_PLAY_FLAG_SUBTITLE) && current_text >= 0);
+}
+
+static void
+subtitles_shown_notify_cb (GObject * object, GParamSpec * pspec,
+    gpointer user_data)
+{
+  update_subtitles_shown (GST_PLAYER (user_data));
+}
+
+static GstPadProbeReturn
+static_frame_probe_cb (GstPad * pad, GstPadProbeInfo * info,
+    gpointer user_data)
+{
+  GstPlayer *self = GST_PLAYER (user_data);
+  GstBuffer *buffer;
+  GstClockTime start;
+  gboolean enabled, changed, pass;
+  guint i;
+
+  if (info->type & GST_PAD_PROBE_TYPE_EVENT_BOTH) {
+    GstEvent *event = GST_PAD_PROBE_INFO_EVENT (info);
+
+    switch (GST_EVENT_TYPE (event)) {
+      case GST_EVENT_CAPS:{
+        GstCaps *caps;
+        GstCapsFeatures *features;
+
+        gst_event_parse_caps (event, &caps);
+        features = gst_caps_get_features (caps, 0);
+        self->frame_diff_supported = (!features
+            || gst_caps_features_is_equal (features,
+                GST_CAPS_FEATURES_MEMORY_SYSTEM_MEMORY))
+            && gst_video_info_from_caps (&self->frame_diff_info, caps)
+            && gst_player_frame_diff_supports (&self->frame_diff_info);
+        gst_player_frame_diff_reset (self->frame_diff);
+        break;
+      }
+      case GST_EVENT_STREAM_START:
+      case GST_EVENT_FLUSH_STOP:
+      case GST_EVENT_SEGMENT:
+        gst_player_frame_diff_reset (self->frame_diff);
+        g_atomic_int_set (&self->pass_next_frame, TRUE);
+        break;
+      default:
+        break;
+    }
+
+    return GST_PAD_PROBE_OK;
+  }
+
+  /* The first frame after a flush or a state change is always let through,
+   * the sink might need it to preroll */
+  pass = g_atomic_int_compare_and_exchange (&self->pass_next_frame, TRUE,
+      FALSE);
+
+  g_mutex_lock (&self->lock);
+  enabled = self->skip_static_frames;
+  g_mutex_unlock (&self->lock);
+
+  if (!enabled || !self->frame_diff_supported)
+    return GST_PAD_PROBE_OK;
+
+  buffer = GST_PAD_PROBE_INFO_BUFFER (info);
+  if (GST_BUFFER_FLAG_IS_SET (buffer, GST_BUFFER_FLAG_DISCONT))
+    gst_player_frame_diff_reset (self->frame_diff);
+
+  start = gst_util_get_timestamp ();
+  changed = gst_player_frame_diff_process (self->frame_diff,
+      &self->frame_diff_info, buffer, self->dirty_rects);
+
+  /* Subtitles are rendered after this point and may change on their own */
+  if (!changed && (pass || g_atomic_int_get (&self->subtitles_shown)))
+    changed = TRUE;
+
+  g_mutex_lock (&self->lock);
+  self->frames_checked++;
+  if (!changed)
+    self->frames_skipped++;
+  self->frame_diff_time += gst_util_get_timestamp () - start;
+  g_mutex_unlock (&self->lock);
+
+  /* Downstream still learns that the stream goes on, which also lets the
+   * sink preroll on a static picture */
+  if (!changed) {
+    if (GST_BUFFER_PTS_IS_VALID (buffer))
+      gst_pad_send_event (pad, gst_event_new_gap (GST_BUFFER_PTS (buffer),
+              GST_BUFFER_DURATION (buffer)));
+    return GST_PAD_PROBE_DROP;
+  }
+
+  /* Tell downstream which parts changed unless it's the whole frame */
+  if (self->dirty_rects->len > 0) {
+    GstVideoRectangle *rect = &g_array_index (self->dirty_rects,
+        GstVideoRectangle, 0);
+
+    if (self->dirty_rects->len > 1 || rect->w < self->frame_diff_info.width
+        || rect->h < self->frame_diff_info.height) {
+      buffer = gst_buffer_make_writable (buffer);
+      for (i = 0; i < self->dirty_rects->len; i++) {
+        rect = &g_array_index (self->dirty_rects, GstVideoRectangle, i);
+        gst_buffer_add_video_region_of_interest_meta (buffer,
+            GST_PLAYER_FRAME_DIFF_DIRTY_ROI, rect->x, rect->y, rect->w,
+            rect->h);
+      }
+      GST_PAD_PROBE_INFO_DATA (info) = buffer;
+    }
+  }
+
+  return GST_PAD_PROBE_OK;
+}
+
+typedef struct
+{
+  GstPlayer *player;
+  gint index;
+} PlaylistItemChangedSignalData;
+
+static void
+playlist_item_changed_dispatch (gpointer user_data)
+{
+  PlaylistItemChangedSignalData *data = user_data;
+
+  g_signal_emit (data->player, signals[SIGNAL_PLAYLIST_ITEM_CHANGED], 0,
+      data->index);
+}
+
+static void
+playlist_item_changed_signal_data_free (PlaylistItemChangedSignalData * data)
+{
+  g_object_unref (data->player);
+  g_free (data);
+}
+
+static void
+emit_playlist_item_changed (GstPlayer * self, gint index)
+{
+  GST_DEBUG_OBJECT (self, "Playlist item changed to %d", index);
+
+  if (g_signal_handler_find (self, G_SIGNAL_MATCH_ID,
+          signals[SIGNAL_PLAYLIST_ITEM_CHANGED], 0, NULL, NULL, NULL) != 0) {
+    PlaylistItemChangedSignalData *data =
+        g_new (PlaylistItemChangedSignalData, 1);
+
+    data->player = g_object_ref (self);
+    data->index = index;
+    gst_player_signal_dispatcher_dispatch (self->signal_dispatcher, self,
+        playlist_item_changed_dispatch, data,
+        (GDestroyNotify) playlist_item_changed_signal_data_free);
+  }
+}
+
+/* Switches to playlist item @index by restarting the pipeline, and keeps
+ * the state the player was in. Takes ownership of @uri. */
+static void
+gst_player_load_playlist_item (GstPlayer * self, gint index, gchar * uri)
+{
+  GstState target_state = self->target_state;
+
+  g_mutex_lock (&self->lock);
+  GST_DEBUG_OBJECT (self, "Loading playlist item %d '%s'", index, uri);
+  g_free (self->uri);
+  self->uri = uri;
+  if (self->playlist)
+    gst_player_playlist_set_current_index (self->playlist, index);
+  g_mutex_unlock (&self->lock);
+
+  gst_player_set_uri_internal (self);
+
+  if (target_state == GST_STATE_PAUSED)
+    gst_player_pause_internal (self);
+  else if (target_state == GST_STATE_PLAYING)
+    gst_player_play_internal (self);
+
+  emit_playlist_item_changed (self, index);
+}
+
+/* Must be called from the main context */
+static gboolean
+playlist_skip (GstPlayer * self, gint direction, gboolean automatic)
+{
+  gchar *uri = NULL;
+  gint index = -1;
+
+  g_mutex_lock (&self->lock);
+  if (self->playlist)
+    uri = gst_player_playlist_get_adjacent (self->playlist, direction,
+        automatic, &index);
+  g_mutex_unlock (&self->lock);
+
+  if (!uri)
+    return FALSE;
+
+  gst_player_load_playlist_item (self, index, uri);
+
+  return TRUE;
+}
+
+static gboolean
+gst_player_set_playlist_internal (gpointer user_data)
+{
+  GstPlayer *self = GST_PLAYER (user_data);
+  gchar *uri = NULL;
+  gint index = 0;
+
+  g_mutex_lock (&self->lock);
+  if (self->playlist) {
+    index = MAX (gst_player_playlist_get_current_index (self->playlist), 0);
+    uri = gst_player_playlist_get_uri (self->playlist, index);
+  }
+  g_mutex_unlock (&self->lock);
+
+  if (uri)
+    gst_player_load_playlist_item (self, index, uri);
+
+  return G_SOURCE_REMOVE;
+}
+
+static gboolean
+gst_player_next_internal (gpointer user_data)
+{
+  playlist_skip (GST_PLAYER (user_data), 1, FALSE);
+
+  return G_SOURCE_REMOVE;
+}
+
+static gboolean
+gst_player_previous_internal (gpointer user_data)
+{
+  playlist_skip (GST_PLAYER (user_data), -1, FALSE);
+
+  return G_SOURCE_REMOVE;
+}
+
+/* Called from a streaming thread once all data of the current item was
+ * read. The URI set on playbin here is prerolled in the background and
+ * played right after the current item without going through READY. */
+static void
+about_to_finish_cb (GstElement * playbin, gpointer user_data)
+{
+  GstPlayer *self = GST_PLAYER (user_data);
+  gchar *uri = NULL;
+  gint index = -1;
+
+  g_mutex_lock (&self->lock);
+  if (self->playlist)
+    uri = gst_player_playlist_get_adjacent (self->playlist, 1, TRUE, &index);
+  if (!uri) {
+    g_mutex_unlock (&self->lock);
+    return;
+  }
+
+  GST_DEBUG_OBJECT (self, "Preparing playlist item %d '%s'", index, uri);
+
+  gst_player_plugin_loader_ensure_uri (uri);
+  g_object_set (playbin, "uri", uri, NULL);
+  if (self->suburi)
+    g_object_set (playbin, "suburi", NULL, NULL);
+  gst_player_update_format_hint_locked (self, uri);
+
+  g_free (self->pending_uri);
+  self->pending_uri = uri;
+  /* The playlist keeps track of the item if it's edited meanwhile */
+  gst_player_playlist_set_pending_index (self->playlist, index);
+  self->gap_serial++;
+  self->gap_transition = TRUE;
+  g_mutex_unlock (&self->lock);
+}
+
+/* playbin posts this when all sinks started on a new item, for the
+ * prepared playlist item this is where it actually becomes current */
+static void
+stream_start_cb (GstBus * bus, GstMessage * msg, gpointer user_data)
+{
+  GstPlayer *self = GST_PLAYER (user_data);
+  gint64 duration = -1;
+  gint index;
+
+  g_mutex_lock (&self->lock);
+  if (!self->pending_uri) {
+    g_mutex_unlock (&self->lock);
+    return;
+  }
+
+  g_free (self->uri);
+  self->uri = self->pending_uri;
+  self->pending_uri = NULL;
+  index = self->playlist ?
+      gst_player_playlist_make_pending_current (self->playlist) : -1;
+
+  GST_DEBUG_OBJECT (self, "Playlist item %d '%s' started", index, self->uri);
+  if (self->suburi) {
+    g_free (self->suburi);
+    self->suburi = NULL;
+  }
+
+  if (self->media_info)
+    g_object_unref (self->media_info);
+  self->media_info = gst_player_media_info_create (self);
+  g_mutex_unlock (&self->lock);
+
+  emit_media_info_updated_signal (self);
+  check_video_dimensions_changed (self);
+  gst_element_query_duration (self->playbin, GST_FORMAT_TIME, &duration);
+  emit_duration_changed (self, duration);
+  emit_playlist_item_changed (self, index);
+}
+
+static GstPadProbeReturn
+transition_probe_cb (GstPad * pad, GstPadProbeInfo * info, gpointer user_data)
+{
+  TransitionStream *stream = user_data;
+  GstPlayer *self = stream->player;
+  GstBuffer *buffer;
+  GstClockTime start, gap;
+
+  if (info->type & GST_PAD_PROBE_TYPE_EVENT_BOTH) {
+    GstEvent *event = GST_PAD_PROBE_INFO_EVENT (info);
+
+    switch (GST_EVENT_TYPE (event)) {
+      case GST_EVENT_SEGMENT:
+        gst_event_copy_segment (event, &stream->segment);
+        break;
+      case GST_EVENT_FLUSH_STOP:
+        stream->last_end = GST_CLOCK_TIME_NONE;
+        break;
+      case GST_EVENT_STREAM_START:
+        g_mutex_lock (&self->lock);
+        if (stream->serial != self->gap_serial) {
+          stream->serial = self->gap_serial;
+          stream->waiting = self->gap_transition;
+          /* Started anew after stopping */
+          if (!self->gap_transition)
+            stream->last_end = GST_CLOCK_TIME_NONE;
+        }
+        g_mutex_unlock (&self->lock);
+        break;
+      default:
+        break;
+    }
+
+    return GST_PAD_PROBE_OK;
+  }
+
+  buffer = GST_PAD_PROBE_INFO_BUFFER (info);
+  if (stream->segment.format != GST_FORMAT_TIME
+      || !GST_BUFFER_PTS_IS_VALID (buffer))
+    return GST_PAD_PROBE_OK;
+
+  start = gst_segment_to_running_time (&stream->segment, GST_FORMAT_TIME,
+      GST_BUFFER_PTS (buffer));
+  if (!GST_CLOCK_TIME_IS_VALID (start))
+    return GST_PAD_PROBE_OK;
+
+  if (stream->waiting && GST_CLOCK_TIME_IS_VALID (stream->last_end)) {
+    gap = start > stream->last_end ? start - stream->last_end : 0;
+
+    /* Each stream reports once, the largest gap of them counts */
+    g_mutex_lock (&self->lock);
+    if (stream->serial != self->gap_measured_serial) {
+      self->gap_measured_serial = stream->serial;
+      self->transition_gap = gap;
+      self->n_transitions++;
+    } else {
+      self->transition_gap = MAX (self->transition_gap, gap);
+    }
+    g_mutex_unlock (&self->lock);
+
+    GST_INFO_OBJECT (self, "Playlist transition gap at %s:%s %"
+        G_GUINT64_FORMAT " ms", GST_DEBUG_PAD_NAME (pad), gap / GST_MSECOND);
+  }
+  stream->waiting = FALSE;
+
+  stream->last_end = start;
+  if (GST_BUFFER_DURATION_IS_VALID (buffer))
+    stream->last_end += GST_BUFFER_DURATION (buffer);
+
+  return GST_PAD_PROBE_OK;
+}
+
+/* Running time only continues across items after playsink synchronised
+ * the streams, so the gap is measured at the sinks. Called whenever the
+ * sinks might have changed, each sink is only watched once */
+static void
+watch_transition_sinks (GstPlayer * self)
+{
+  GList *sinks, *l;
+
+  sinks = get_sinks (self);
+  for (l = sinks; l; l = l->next) {
+    GstPad *pad = gst_element_get_static_pad (l->data, "sink");
+    TransitionStream *stream;
+
+    if (!pad)
+      continue;
+
+    if (!g_object_get_data (G_OBJECT (pad), "gst-player-transition")) {
+      stream = g_new0 (TransitionStream, 1);
+      stream->player = self;
+      stream->last_end = GST_CLOCK_TIME_NONE;
+      g_mutex_lock (&self->lock);
+      stream->serial = self->gap_serial;
+      g_mutex_unlock (&self->lock);
+      gst_segment_init (&stream->segment, GST_FORMAT_UNDEFINED);
+
+      g_object_set_data (G_OBJECT (pad), "gst-player-transition", stream);
+      gst_pad_add_probe (pad,
+          GST_PAD_PROBE_TYPE_BUFFER | GST_PAD_PROBE_TYPE_EVENT_DOWNSTREAM |
+          GST_PAD_PROBE_TYPE_EVENT_FLUSH, transition_probe_cb, stream,
+          g_free);
+    }
+    gst_object_unref (pad);
+  }
+  g_list_free_full (sinks, gst_object_unref);
+}
+
+/* Measures how long it takes until data with a new rate reaches the
+ * sinks */
+static GstPadProbeReturn
+rate_probe_cb (GstPad * pad, GstPadProbeInfo * info, gpointer user_data)
+{
+  GstPlayer *self = GST_PLAYER (user_data);
+  const GstSegment *segment;
+  GstEvent *event;
+
+  g_mutex_lock (&self->lock);
+  if (!GST_CLOCK_TIME_IS_VALID (self->rate_change_start)) {
+    g_mutex_unlock (&self->lock);
+    return GST_PAD_PROBE_OK;
+  }
+
+  if (GST_PAD_PROBE_INFO_TYPE (info) & GST_PAD_PROBE_TYPE_BUFFER) {
+    /* Data queued before the new segment still drains */
+    self->rate_change_progress = gst_util_get_timestamp ();
+    if (self->rate_segment_seen) {
+      self->rate_change_time =
+          gst_util_get_timestamp () - self->rate_change_start;
+      self->rate_change_start = GST_CLOCK_TIME_NONE;
+      self->rate_segment_seen = FALSE;
+      GST_DEBUG_OBJECT (self, "Rate %.2lf applied after %" GST_TIME_FORMAT
+          " (%s)", self->rate_change_target,
+          GST_TIME_ARGS (self->rate_change_time),
+          self->rate_change_flushing ? "flushing" : "non-flushing");
+    }
+  } else {
+    event = GST_PAD_PROBE_INFO_EVENT (info);
+    if (GST_EVENT_TYPE (event) == GST_EVENT_SEGMENT) {
+      gst_event_parse_segment (event, &segment);
+      if (segment->rate * segment->applied_rate == self->rate_change_target)
+        self->rate_segment_seen = TRUE;
+    }
+  }
+  g_mutex_unlock (&self->lock);
+
+  return GST_PAD_PROBE_OK;
+}
+
+static GstPadProbeReturn
+audio_meter_probe_cb (GstPad * pad, GstPadProbeInfo * info,
+    gpointer user_data)
+{
+  GstPlayer *self = GST_PLAYER (user_data);
+
+  if (info->type & GST_PAD_PROBE_TYPE_EVENT_BOTH) {
+    GstEvent *event = GST_PAD_PROBE_INFO_EVENT (info);
+
+    switch (GST_EVENT_TYPE (event)) {
+      case GST_EVENT_CAPS:{
+        GstAudioInfo audio_info;
+        GstCaps *caps;
+
+        /* Unknown formats make the meter ignore buffers */
+        gst_event_parse_caps (event, &caps);
+        if (!gst_audio_info_from_caps (&audio_info, caps))
+          gst_audio_info_init (&audio_info);
+        gst_player_audio_meter_set_format (self->audio_meter, &audio_info);
+        break;
+      }
+      case GST_EVENT_STREAM_START:
+      case GST_EVENT_FLUSH_STOP:
+        gst_player_audio_meter_reset (self->audio_meter);
+        break;
+      default:
+        break;
+    }
+
+    return GST_PAD_PROBE_OK;
+  }
+
+  if (g_atomic_int_get (&self->audio_meter_active))
+    gst_player_audio_meter_process (self->audio_meter,
+        GST_PAD_PROBE_INFO_BUFFER (info));
+
+  return GST_PAD_PROBE_OK;
+}
+
+static void
+playsink_pad_added_cb (GstElement * playsink, GstPad * pad, gpointer user_data)
+{
+  /* Frames are checked before playsink converts and renders them */
+  if (g_str_has_prefix (GST_PAD_NAME (pad), "video"))
+    gst_pad_add_probe (pad,
+        GST_PAD_PROBE_TYPE_BUFFER | GST_PAD_PROBE_TYPE_EVENT_DOWNSTREAM |
+        GST_PAD_PROBE_TYPE_EVENT_FLUSH, static_frame_probe_cb, user_data, NULL);
+
+  if (g_str_has_prefix (GST_PAD_NAME (pad), "video")
+      || g_str_has_prefix (GST_PAD_NAME (pad), "audio")) {
+    gst_pad_add_probe (pad,
+        GST_PAD_PROBE_TYPE_BUFFER | GST_PAD_PROBE_TYPE_EVENT_DOWNSTREAM,
+        rate_probe_cb, user_data, NULL);
+  }
+}
+
+/* Levels are measured on the decoded audio in playbin's audio filter slot,
+ * which playsink links before its volume and converters. The filter is an
+ * identity element, the meter only looks at the buffers from its probe */
+static void
+setup_audio_meter (GstPlayer * self)
+{
+  GstElement *identity;
+  GstPad *pad;
+
+  identity = gst_element_factory_make ("identity", "audio-meter");
+  if (!identity) {
+    GST_WARNING_OBJECT (self, "No identity, not measuring audio levels");
+    return;
+  }
+  g_object_set (identity, "silent", TRUE, NULL);
+
+  pad = gst_element_get_static_pad (identity, "sink");
+  gst_pad_add_probe (pad,
+      GST_PAD_PROBE_TYPE_BUFFER | GST_PAD_PROBE_TYPE_EVENT_DOWNSTREAM |
+      GST_PAD_PROBE_TYPE_EVENT_FLUSH, audio_meter_probe_cb, self, NULL);
+  gst_object_unref (pad);
+
+  g_object_set (self->playbin, "audio-filter", identity, NULL);
+}
+
+/* Elements playbin creates by name, these have to be available up front if
+ * static plugins are registered on demand */
+static const gchar *playback_features[] = {
+  "playbin", "uridecodebin", "decodebin", "playsink", "typefind", "queue",
+  "queue2", "autovideosink", "autoaudiosink", "videoconvert", "videoscale",
+  "audioconvert", "audioresample", "volume", "subtitleoverlay", "textoverlay",
+  "identity", NULL
+};
+
+static void
+ensure_playback_plugins (void)
+{
+  guint i;
+
+  if (!gst_player_plugin_loader_is_lazy ())
+    return;
+
+  for (i = 0; playback_features[i]; i++)
+    gst_player_plugin_loader_ensure_feature (playback_features[i]);
+
+  /* autovideosink and autoaudiosink look for sinks by klass */
+  gst_player_plugin_loader_ensure_klass ("Sink/Video");
+  gst_player_plugin_loader_ensure_klass ("Sink/Audio");
+
+  /* subtitleoverlay looks for renderers by klass too, subtitle parsers and
+   * decoders are found by caps like all other decoders */
+  gst_player_plugin_loader_ensure_klass ("Overlay/Subtitle");
+  gst_player_plugin_loader_ensure_klass ("Overlay/SubPicture");
+}
+
+static gpointer
+gst_player_main (gpointer data)
+{
+  GstPlayer *self = GST_PLAYER (data);
+  GstBus *bus;
+  GSource *source;
+  GSource *bus_source;
+  GstElement *playsink;
+  GstPlayerRestream *restream;
+
+  GST_TRACE_OBJECT (self, "Starting main thread");
+
+  g_main_context_push_thread_default (self->context);
+
+  source = g_idle_source_new ();
+  g_source_set_callback (source, (GSourceFunc) main_loop_running_cb, self,
+      NULL);
+  g_source_attach (source, self->context);
+  g_source_unref (source);
+
+  ensure_playback_plugins ();
+  self->playbin = gst_element_factory_make ("playbin", "playbin");
+  g_signal_connect (self->playbin, "element-added",
+      G_CALLBACK (element_added_cb), self);
+  g_signal_connect (self->playbin, "source-setup",
+      G_CALLBACK (source_setup_cb), self);
+  g_signal_connect (self->playbin, "about-to-finish",
+      G_CALLBACK (about_to_finish_cb), self);
+
+  playsink = gst_bin_get_by_name (GST_BIN (self->playbin), "playsink");
+  if (playsink) {
+    g_signal_connect (playsink, "pad-added",
+        G_CALLBACK (playsink_pad_added_cb), self);
+    gst_object_unref (playsink);
+  }
+  setup_audio_meter (self);
+
+  if (self->video_renderer) {
+    GstElement *video_sink =
+        gst_player_video_renderer_create_video_sink (self->video_renderer,
+        self);
+
+    if (video_sink)
+      g_object_set (self->playbin, "video-sink", video_sink, NULL);
+
+    if (GST_PLAYER_VIDEO_RENDERER_GET_INTERFACE
+        (self->video_renderer)->get_target_size)
+      setup_viewport_scale (self);
+  }
+  update_sink_caps (self);
+
+  self->bus = bus = gst_element_get_bus (self->playbin);
+  bus_source = gst_bus_create_watch (bus);
+  g_source_set_callback (bus_source, (GSourceFunc) gst_bus_async_signal_func,
+      NULL, NULL);
+  g_source_attach (bus_source, self->context);
+
+  g_signal_connect (G_OBJECT (bus), "message::error", G_CALLBACK (error_cb),
+      self);
   g_signal_connect (G_OBJECT (bus), "message::warning", G_CALLBACK (warning_cb),
       self);
-  g_signal_connect (G_OBJECT (bus), "message::eos", G_CALLBACK (eos_cb), self);
-  g_signal_connect (G_OBJECT (bus), "message::state-changed",
-      G_CALLBACK (state_changed_cb), self);
-  g_signal_connect (G_OBJECT (bus), "message::buffering",
-      G_CALLBACK (buffering_cb), self);
-  g_signal_connect (G_OBJECT (bus), "message::clock-lost",
-      G_CALLBACK (clock_lost_cb), self);
-  g_signal_connect (G_OBJECT (bus), "message::duration-changed",
-      G_CALLBACK (duration_changed_cb), self);
-  g_signal_connect (G_OBJECT (bus), "message::latency",
-      G_CALLBACK (latency_cb), self);
-  g_signal_connect (G_OBJECT (bus), "message::request-state",
-      G_CALLBACK (request_state_cb), self);
-  g_signal_connect (G_OBJECT (bus), "message::element",
-      G_CALLBACK (element_cb), self);
-  g_signal_connect (G_OBJECT (bus), "message::tag", G_CALLBACK (tags_cb), self);
+  g_signal_connect (G_OBJECT (bus), "message::eos", G_CALLBACK (eos_cb), self);
+  g_signal_connect (G_OBJECT (bus), "message::state-changed",
+      G_CALLBACK (state_changed_cb), self);
+  g_signal_connect (G_OBJECT (bus), "message::buffering",
+      G_CALLBACK (buffering_cb), self);
+  g_signal_connect (G_OBJECT (bus), "message::clock-lost",
+      G_CALLBACK (clock_lost_cb), self);
+  g_signal_connect (G_OBJECT (bus), "message::duration-changed",
+      G_CALLBACK (duration_changed_cb), self);
+  g_signal_connect (G_OBJECT (bus), "message::latency",
+      G_CALLBACK (latency_cb), self);
+  g_signal_connect (G_OBJECT (bus), "message::request-state",
+      G_CALLBACK (request_state_cb), self);
+  g_signal_connect (G_OBJECT (bus), "message::element",
+      G_CALLBACK (element_cb), self);
+  g_signal_connect (G_OBJECT (bus), "message::tag", G_CALLBACK (tags_cb), self);
+  g_signal_connect (G_OBJECT (bus), "message::qos", G_CALLBACK (qos_cb), self);
+  g_signal_connect (G_OBJECT (bus), "message::stream-start",
+      G_CALLBACK (stream_start_cb), self);
+  g_signal_connect (G_OBJECT (bus), "message::segment-done",
+      G_CALLBACK (segment_done_cb), self);
+
+  g_signal_connect (self->playbin, "video-changed",
+      G_CALLBACK (video_changed_cb), self);
+  g_signal_connect (self->playbin, "audio-changed",
+      G_CALLBACK (audio_changed_cb), self);
+  g_signal_connect (self->playbin, "text-changed",
+      G_CALLBACK (subtitle_changed_cb), self);
+  g_signal_connect (self->playbin, "notify::flags",
+      G_CALLBACK (subtitles_shown_notify_cb), self);
+  g_signal_connect (self->playbin, "notify::video-sink",
+      G_CALLBACK (sink_notify_cb), self);
+  g_signal_connect (self->playbin, "notify::audio-sink",
+      G_CALLBACK (sink_notify_cb), self);
+  g_signal_connect (self->playbin, "notify::current-text",
+      G_CALLBACK (subtitles_shown_notify_cb), self);
+
+  g_signal_connect (self->playbin, "video-tags-changed",
+      G_CALLBACK (video_tags_changed_cb), self);
+  g_signal_connect (self->playbin, "audio-tags-changed",
+      G_CALLBACK (audio_tags_changed_cb), self);
+  g_signal_connect (self->playbin, "text-tags-changed",
+      G_CALLBACK (subtitle_tags_changed_cb), self);
+  g_signal_connect (self->playbin, "notify::volume",
+      G_CALLBACK (volume_notify_cb), self);
+  g_signal_connect (self->playbin, "notify::mute",
+      G_CALLBACK (mute_notify_cb), self);
+
+  self->target_state = GST_STATE_NULL;
+  self->current_state = GST_STATE_NULL;
+  change_state (self, GST_PLAYER_STATE_STOPPED);
+  self->buffering = 100;
+  self->is_eos = FALSE;
+  self->is_live = FALSE;
+
+  GST_TRACE_OBJECT (self, "Starting main loop");
+  g_main_loop_run (self->loop);
+  GST_TRACE_OBJECT (self, "Stopped main loop");
+
+  g_source_destroy (bus_source);
+  g_source_unref (bus_source);
+  gst_object_unref (bus);
+
+  remove_tick_source (self);
+  remove_ready_timeout_source (self);
+  if (self->recover_source) {
+    g_source_destroy (self->recover_source);
+    g_source_unref (self->recover_source);
+    self->recover_source = NULL;
+  }
+
+  g_mutex_lock (&self->lock);
+  if (self->rate_fallback_source) {
+    g_source_destroy (self->rate_fallback_source);
+    g_source_unref (self->rate_fallback_source);
+    self->rate_fallback_source = NULL;
+  }
+  if (self->media_info) {
+    g_object_unref (self->media_info);
+    self->media_info = NULL;
+  }
+
+  if (self->seek_source)
+    g_source_unref (self->seek_source);
+  self->seek_source = NULL;
+
+  restream = self->restream;
+  self->restream = NULL;
+  g_mutex_unlock (&self->lock);
+
+  gst_player_restream_free (restream);
+  free_scrub (self);
+  save_keyframe_index (self);
+
+  g_main_context_pop_thread_default (self->context);
+
+  self->target_state = GST_STATE_NULL;
+  self->current_state = GST_STATE_NULL;
+  if (self->playbin) {
+    gst_element_set_state (self->playbin, GST_STATE_NULL);
+    gst_object_unref (self->playbin);
+    self->playbin = NULL;
+  }
+
+  GST_TRACE_OBJECT (self, "Stopped main thread");
+
+  return NULL;
+}
+
+static gpointer
+gst_player_init_once (gpointer user_data)
+{
+  gst_init (NULL, NULL);
+
+  GST_DEBUG_CATEGORY_INIT (gst_player_debug, "gst-player", 0, "GstPlayer");
+  gst_player_error_quark ();
+
+  return NULL;
+}
+
+/**
+ * gst_player_new:
+ *
+ * Returns: a new #GstPlayer instance
+ */
+GstPlayer *
+gst_player_new (void)
+{
+  return gst_player_new_full (NULL, NULL);
+}
+
+/**
+ * gst_player_new_full:
+ * @video_renderer: (transfer full) (allow-none): GstPlayerVideoRenderer to use
+ * @signal_dispatcher: (transfer full) (allow-none): GstPlayerSignalDispatcher to use
+ *
+ * Creates a new #GstPlayer instance that uses @signal_dispatcher to dispatch
+ * signals to some event loop system, or emits signals directly if NULL is
+ * passed. See gst_player_g_main_context_signal_dispatcher_new().
+ *
+ * Video is going to be rendered by @video_renderer, or if %NULL is provided
+ * no special video set up will be done and some default handling will be
+ * performed.
+ *
+ * Returns: a new #GstPlayer instance
+ */
+GstPlayer *
+gst_player_new_full (GstPlayerVideoRenderer * video_renderer,
+    GstPlayerSignalDispatcher * signal_dispatcher)
+{
+  static GOnce once = G_ONCE_INIT;
+  GstPlayer *self;
+
+  g_once (&once, gst_player_init_once, NULL);
+
+  self =
+      g_object_new (GST_TYPE_PLAYER, "video-renderer", video_renderer,
+      "signal-dispatcher", signal_dispatcher, NULL);
+
+  if (video_renderer)
+    g_object_unref (video_renderer);
+  if (signal_dispatcher)
+    g_object_unref (signal_dispatcher);
+
+  return self;
+}
+
+static gboolean
+gst_player_play_internal (gpointer user_data)
+{
+  GstPlayer *self = GST_PLAYER (user_data);
+  GstStateChangeReturn state_ret;
+
+  GST_DEBUG_OBJECT (self, "Play");
+
+  g_mutex_lock (&self->lock);
+  if (!self->uri) {
+    g_mutex_unlock (&self->lock);
+    return G_SOURCE_REMOVE;
+  }
+  g_mutex_unlock (&self->lock);
+
+  remove_ready_timeout_source (self);
+  restore_trimmed_pipeline (self);
+  self->target_state = GST_STATE_PLAYING;
+
+  if (self->current_state < GST_STATE_PAUSED)
+    change_state (self, GST_PLAYER_STATE_BUFFERING);
+
+  if (self->current_state >= GST_STATE_PAUSED && !self->is_eos) {
+    state_ret = gst_element_set_state (self->playbin, GST_STATE_PLAYING);
+  } else {
+    state_ret = gst_element_set_state (self->playbin, GST_STATE_PAUSED);
+  }
+
+  if (state_ret == GST_STATE_CHANGE_NO_PREROLL) {
+    self->is_live = TRUE;
+    GST_DEBUG_OBJECT (self, "Pipeline is live");
+  }
+
+  if (state_ret == GST_STATE_CHANGE_FAILURE) {
+    emit_error (self, g_error_new (GST_PLAYER_ERROR, GST_PLAYER_ERROR_FAILED,
+            "Failed to play"));
+    return G_SOURCE_REMOVE;
+  } else if (state_ret == GST_STATE_CHANGE_NO_PREROLL) {
+    self->is_live = TRUE;
+    GST_DEBUG_OBJECT (self, "Pipeline is live");
+  }
+
+  if (self->is_eos) {
+    gboolean ret;
+
+    GST_DEBUG_OBJECT (self, "Was EOS, seeking to beginning");
+    self->is_eos = FALSE;
+    ret =
+        gst_element_seek_simple (self->playbin, GST_FORMAT_TIME,
+        GST_SEEK_FLAG_FLUSH, 0);
+    if (!ret) {
+      GST_ERROR_OBJECT (self, "Seek to beginning failed");
+      gst_player_stop_internal (self);
+      gst_player_play_internal (self);
+    }
+  }
+
+  return G_SOURCE_REMOVE;
+}
+
+/**
+ * gst_player_play:
+ * @player: #GstPlayer instance
+ *
+ * Request to play the loaded stream.
+ */
+void
+gst_player_play (GstPlayer * self)
+{
+  g_return_if_fail (GST_IS_PLAYER (self));
+
+  g_main_context_invoke_full (self->context, G_PRIORITY_DEFAULT,
+      gst_player_play_internal, self, NULL);
+}
+
+static gboolean
+gst_player_pause_internal (gpointer user_data)
+{
+  GstPlayer *self = GST_PLAYER (user_data);
+  GstStateChangeReturn state_ret;
+
+  GST_DEBUG_OBJECT (self, "Pause");
+
+  g_mutex_lock (&self->lock);
+  if (!self->uri) {
+    g_mutex_unlock (&self->lock);
+    return G_SOURCE_REMOVE;
+  }
+  g_mutex_unlock (&self->lock);
+
+  tick_cb (self);
+  remove_tick_source (self);
+  remove_ready_timeout_source (self);
+  restore_trimmed_pipeline (self);
+
+  self->target_state = GST_STATE_PAUSED;
+
+  if (self->current_state < GST_STATE_PAUSED)
+    change_state (self, GST_PLAYER_STATE_BUFFERING);
+
+  /* Going from PLAYING to PAUSED the sink prerolls again */
+  g_atomic_int_set (&self->pass_next_frame, TRUE);
+
+  state_ret = gst_element_set_state (self->playbin, GST_STATE_PAUSED);
+  if (state_ret == GST_STATE_CHANGE_FAILURE) {
+    emit_error (self, g_error_new (GST_PLAYER_ERROR, GST_PLAYER_ERROR_FAILED,
+            "Failed to pause"));
+    return G_SOURCE_REMOVE;
+  } else if (state_ret == GST_STATE_CHANGE_NO_PREROLL) {
+    self->is_live = TRUE;
+    GST_DEBUG_OBJECT (self, "Pipeline is live");
+  }
+
+  if (self->is_eos) {
+    gboolean ret;
+
+    GST_DEBUG_OBJECT (self, "Was EOS, seeking to beginning");
+    self->is_eos = FALSE;
+    ret =
+        gst_element_seek_simple (self->playbin, GST_FORMAT_TIME,
+        GST_SEEK_FLAG_FLUSH, 0);
+    if (!ret) {
+      GST_ERROR_OBJECT (self, "Seek to beginning failed");
+      gst_player_stop_internal (self);
+      gst_player_pause_internal (self);
+    }
+  }
+
+  return G_SOURCE_REMOVE;
+}
+
+/**
+ * gst_player_pause:
+ * @player: #GstPlayer instance
+ *
+ * Pauses the current stream.
+ */
+void
+gst_player_pause (GstPlayer * self)
+{
+  g_return_if_fail (GST_IS_PLAYER (self));
+
+  g_main_context_invoke_full (self->context, G_PRIORITY_DEFAULT,
+      gst_player_pause_internal, self, NULL);
+}
+
+static gboolean
+gst_player_stop_internal (gpointer user_data)
+{
+  GstPlayer *self = GST_PLAYER (user_data);
+
+  GST_DEBUG_OBJECT (self, "Stop");
+
+  tick_cb (self);
+  remove_tick_source (self);
+
+  save_keyframe_index (self);
+
+  add_ready_timeout_source (self);
+
+  self->target_state = GST_STATE_NULL;
+  self->current_state = GST_STATE_READY;
+  self->is_live = FALSE;
+  self->is_eos = FALSE;
+  gst_bus_set_flushing (self->bus, TRUE);
+  gst_element_set_state (self->playbin, GST_STATE_READY);
+  gst_bus_set_flushing (self->bus, FALSE);
+  change_state (self, GST_PLAYER_STATE_STOPPED);
+  self->buffering = 100;
+  g_mutex_lock (&self->lock);
+  if (self->media_info) {
+    g_object_unref (self->media_info);
+    self->media_info = NULL;
+  }
+  if (self->global_tags) {
+    gst_tag_list_unref (self->global_tags);
+    self->global_tags = NULL;
+  }
+  remove_tag_update_source (self);
+  self->seek_pending = FALSE;
+  if (self->seek_source) {
+    g_source_destroy (self->seek_source);
+    g_source_unref (self->seek_source);
+    self->seek_source = NULL;
+  }
+  self->seek_position = GST_CLOCK_TIME_NONE;
+  self->last_seek_time = GST_CLOCK_TIME_NONE;
+  self->rate = 1.0;
+  self->applied_rate = 1.0;
+  self->rate_change_pending = FALSE;
+  self->rate_change_start = GST_CLOCK_TIME_NONE;
+  if (self->rate_fallback_source) {
+    g_source_destroy (self->rate_fallback_source);
+    g_source_unref (self->rate_fallback_source);
+    self->rate_fallback_source = NULL;
+  }
+  if (self->video_decoder) {
+    gst_object_unref (self->video_decoder);
+    self->video_decoder = NULL;
+  }
+  g_atomic_int_set (&self->pipeline_trimmed, FALSE);
+  if (self->pending_uri) {
+    /* playbin would start with the prepared playlist item next time */
+    g_object_set (self->playbin, "uri", self->uri, NULL);
+    g_free (self->pending_uri);
+    self->pending_uri = NULL;
+    if (self->playlist)
+      gst_player_playlist_set_pending_index (self->playlist, -1);
+  }
+  self->gap_serial++;
+  self->gap_transition = FALSE;
+  g_mutex_unlock (&self->lock);
+
+  gst_player_reset_degradation_internal (self);
+
+  return G_SOURCE_REMOVE;
+}
+
+/**
+ * gst_player_stop:
+ * @player: #GstPlayer instance
+ *
+ * Stops playing the current stream and resets to the first position
+ * in the stream.
+ */
+void
+gst_player_stop (GstPlayer * self)
+{
+  g_return_if_fail (GST_IS_PLAYER (self));
+
+  g_main_context_invoke_full (self->context, G_PRIORITY_DEFAULT,
+      gst_player_stop_internal, self, NULL);
+}
+
+static gboolean rate_fallback_cb (gpointer user_data);
+
+/* Must be called with lock */
+static void
+add_rate_fallback_source_locked (GstPlayer * self, guint timeout_ms)
+{
+  if (self->rate_fallback_source) {
+    g_source_destroy (self->rate_fallback_source);
+    g_source_unref (self->rate_fallback_source);
+  }
+  self->rate_fallback_source = g_timeout_source_new (timeout_ms);
+  g_source_set_callback (self->rate_fallback_source, rate_fallback_cb, self,
+      NULL);
+  g_source_attach (self->rate_fallback_source, self->context);
+}
+
+static gboolean
+rate_fallback_cb (gpointer user_data)
+{
+  GstPlayer *self = GST_PLAYER (user_data);
+  GstClockTime idle;
+
+  g_mutex_lock (&self->lock);
+  g_source_unref (self->rate_fallback_source);
+  self->rate_fallback_source = NULL;
+
+  if (GST_CLOCK_TIME_IS_VALID (self->rate_change_start)
+      && !self->rate_change_flushing && !self->rate_segment_seen
+      && !self->seek_source && !self->seek_pending) {
+    /* Wait as long as buffered data with the old rate is still played */
+    idle = gst_util_get_timestamp () - self->rate_change_progress;
+    if (idle < RATE_CHANGE_TIMEOUT_MS * GST_MSECOND) {
+      add_rate_fallback_source_locked (self,
+          RATE_CHANGE_TIMEOUT_MS - idle / GST_MSECOND);
+      g_mutex_unlock (&self->lock);
+      return G_SOURCE_REMOVE;
+    }
+
+    GST_DEBUG_OBJECT (self, "Rate change not applied yet, flushing");
+    self->rate_change_flushing = TRUE;
+    self->seek_position = gst_player_get_position (self);
+    gst_player_seek_internal_locked (self);
+  }
+  g_mutex_unlock (&self->lock);
+
+  return G_SOURCE_REMOVE;
+}
+
+/* Must be called with lock from main context. Sends a seek that only
+ * changes the rate, without flushing. The new segment is queued behind the
+ * data that is already buffered, so playback continues without prerolling
+ * again and the new rate takes effect once that data is played.
+ * Releases the lock temporarily! */
+static gboolean
+change_rate_non_flushing_locked (GstPlayer * self)
+{
+  GstSeekFlags flags = GST_SEEK_FLAG_NONE;
+  GstEvent *s_event;
+  gdouble rate = self->rate;
+  gboolean ret;
+
+  self->rate_change_pending = FALSE;
+  self->rate_change_start = gst_util_get_timestamp ();
+  self->rate_change_progress = self->rate_change_start;
+  self->rate_change_target = rate;
+  self->rate_change_flushing = TRUE;
+  self->rate_segment_seen = FALSE;
+
+  /* Changing direction always needs a flush and a new start position */
+  if (self->current_state < GST_STATE_PAUSED || self->is_eos
+      || self->seek_pending || (rate > 0.0) != (self->applied_rate > 0.0))
+    return FALSE;
+
+#if GST_CHECK_VERSION(1,5,0)
+  if (rate != 1.0) {
+    flags |= GST_SEEK_FLAG_TRICKMODE;
+  }
+#endif
+
+  /* Stay in segment mode while looping */
+  if (GST_CLOCK_TIME_IS_VALID (self->loop_stop))
+    flags |= GST_SEEK_FLAG_SEGMENT;
+
+  s_event = gst_event_new_seek (rate, GST_FORMAT_TIME, flags,
+      GST_SEEK_TYPE_NONE, GST_CLOCK_TIME_NONE, GST_SEEK_TYPE_NONE,
+      GST_CLOCK_TIME_NONE);
+
+  GST_DEBUG_OBJECT (self, "Changing rate to %.2lf without flushing", rate);
+
+  g_mutex_unlock (&self->lock);
+  ret = gst_element_send_event (self->playbin, s_event);
+  g_mutex_lock (&self->lock);
+
+  if (!ret) {
+    GST_DEBUG_OBJECT (self, "Non-flushing rate change not supported");
+    return FALSE;
+  }
+
+  self->rate_change_flushing = FALSE;
+  self->seek_position = GST_CLOCK_TIME_NONE;
+  self->applied_rate = rate;
+
+  add_rate_fallback_source_locked (self, RATE_CHANGE_TIMEOUT_MS);
+
+  return TRUE;
+}
+
+/* Must be called with lock from main context, releases lock! */
+static void
+gst_player_seek_internal_locked (GstPlayer * self)
+{
+  gboolean ret;
+  GstClockTime position;
+  gdouble rate;
+  GstStateChangeReturn state_ret;
+  GstEvent *s_event;
+  GstSeekFlags flags = 0;
+  GstClockTime loop_start, loop_stop;
+
+  if (self->seek_source) {
+    g_source_destroy (self->seek_source);
+    g_source_unref (self->seek_source);
+    self->seek_source = NULL;
+  }
+
+  if (self->rate_change_pending && change_rate_non_flushing_locked (self))
+    return;
+
+  /* Only seek in PAUSED */
+  if (self->current_state < GST_STATE_PAUSED) {
+    return;
+  } else if (self->current_state != GST_STATE_PAUSED) {
+    g_mutex_unlock (&self->lock);
+    state_ret = gst_element_set_state (self->playbin, GST_STATE_PAUSED);
+    if (state_ret == GST_STATE_CHANGE_FAILURE) {
+      emit_error (self, g_error_new (GST_PLAYER_ERROR, GST_PLAYER_ERROR_FAILED,
+              "Failed to seek"));
+      g_mutex_lock (&self->lock);
+      return;
+    }
+    g_mutex_lock (&self->lock);
+    return;
+  }
+
+  self->last_seek_time = gst_util_get_timestamp ();
+  position = self->seek_position;
+  self->seek_position = GST_CLOCK_TIME_NONE;
+  self->seek_pending = TRUE;
+  rate = self->rate;
+  self->applied_rate = rate;
+  loop_start = self->loop_start;
+  loop_stop = self->loop_stop;
+  g_mutex_unlock (&self->lock);
+
+  remove_tick_source (self);
+  self->is_eos = FALSE;
+
+  flags |= GST_SEEK_FLAG_FLUSH;
+
+#if GST_CHECK_VERSION(1,5,0)
+  if (rate != 1.0) {
+    flags |= GST_SEEK_FLAG_TRICKMODE;
+  }
+#endif
+
+  if (GST_CLOCK_TIME_IS_VALID (loop_stop)) {
+    /* Play the loop range as a segment, segment-done restarts it */
+    flags |= GST_SEEK_FLAG_SEGMENT;
+    if (rate >= 0.0) {
+      if (position < loop_start || position >= loop_stop)
+        position = loop_start;
+      s_event = gst_event_new_seek (rate, GST_FORMAT_TIME, flags,
+          GST_SEEK_TYPE_SET, position, GST_SEEK_TYPE_SET, loop_stop);
+    } else {
+      if (position <= loop_start || position > loop_stop)
+        position = loop_stop;
+      s_event = gst_event_new_seek (rate, GST_FORMAT_TIME, flags,
+          GST_SEEK_TYPE_SET, loop_start, GST_SEEK_TYPE_SET, position);
+    }
+  } else if (rate >= 0.0) {
+    s_event = gst_event_new_seek (rate, GST_FORMAT_TIME, flags,
+        GST_SEEK_TYPE_SET, position, GST_SEEK_TYPE_NONE, GST_CLOCK_TIME_NONE);
+  } else {
+    s_event = gst_event_new_seek (rate, GST_FORMAT_TIME, flags,
+        GST_SEEK_TYPE_SET, G_GINT64_CONSTANT (0), GST_SEEK_TYPE_SET, position);
+  }
+
+  GST_DEBUG_OBJECT (self, "Seek with rate %.2lf to %" GST_TIME_FORMAT,
+      rate, GST_TIME_ARGS (position));
+  gst_player_flight_recorder_record (self->flight_recorder, FLIGHT_EVENT_SEEK,
+      (gint) (rate * 100), 0, position);
+
+  ret = gst_element_send_event (self->playbin, s_event);
+  if (!ret)
+    emit_error (self, g_error_new (GST_PLAYER_ERROR, GST_PLAYER_ERROR_FAILED,
+            "Failed to seek to %" GST_TIME_FORMAT, GST_TIME_ARGS (position)));
+
+  g_mutex_lock (&self->lock);
+}
+
+static gboolean
+gst_player_seek_internal (gpointer user_data)
+{
+  GstPlayer *self = GST_PLAYER (user_data);
+
+  g_mutex_lock (&self->lock);
+  gst_player_seek_internal_locked (self);
+  g_mutex_unlock (&self->lock);
+
+  return G_SOURCE_REMOVE;
+}
+
+static gboolean
+gst_player_set_loop_range_internal (gpointer user_data)
+{
+  GstPlayer *self = GST_PLAYER (user_data);
+  GstSeekFlags flags = GST_SEEK_FLAG_NONE;
+  GstEvent *s_event;
+  gdouble rate;
+
+  g_mutex_lock (&self->lock);
+  if (GST_CLOCK_TIME_IS_VALID (self->loop_stop)) {
+    /* Enter the range with one flushing segment seek, from there on it is
+     * repeated without flushing */
+    self->seek_position = gst_player_get_position (self);
+    self->rate_change_pending = FALSE;
+    if (!self->seek_source && !self->seek_pending) {
+      self->seek_source = g_idle_source_new ();
+      g_source_set_callback (self->seek_source,
+          (GSourceFunc) gst_player_seek_internal, self, NULL);
+      g_source_attach (self->seek_source, self->context);
+    }
+    g_mutex_unlock (&self->lock);
+    return G_SOURCE_REMOVE;
+  }
+  rate = self->applied_rate;
+  g_mutex_unlock (&self->lock);
+
+  if (self->current_state < GST_STATE_PAUSED)
+    return G_SOURCE_REMOVE;
+
+  /* Leave segment mode without flushing and play on to the end */
+#if GST_CHECK_VERSION(1,5,0)
+  if (rate != 1.0) {
+    flags |= GST_SEEK_FLAG_TRICKMODE;
+  }
+#endif
+
+  if (rate >= 0.0)
+    s_event = gst_event_new_seek (rate, GST_FORMAT_TIME, flags,
+        GST_SEEK_TYPE_NONE, GST_CLOCK_TIME_NONE, GST_SEEK_TYPE_SET,
+        GST_CLOCK_TIME_NONE);
+  else
+    s_event = gst_event_new_seek (rate, GST_FORMAT_TIME, flags,
+        GST_SEEK_TYPE_SET, G_GINT64_CONSTANT (0), GST_SEEK_TYPE_NONE,
+        GST_CLOCK_TIME_NONE);
+
+  GST_DEBUG_OBJECT (self, "Leaving loop range");
+  gst_element_send_event (self->playbin, s_event);
+
+  return G_SOURCE_REMOVE;
+}
+
+static gboolean
+gst_player_set_rate_internal (gpointer user_data)
+{
+  GstPlayer *self = user_data;
+
+  g_mutex_lock (&self->lock);
+
+  self->seek_position = gst_player_get_position (self);
+  self->rate_change_pending = TRUE;
+
+  /* If there is no seek being dispatch to the main context currently do that,
+   * otherwise we just updated the rate so that it will be taken by
+   * the seek handler from the main context instead of the old one.
+   */
+  if (!self->seek_source) {
+    /* If no seek is pending then create new seek source */
+    if (!self->seek_pending) {
+      self->seek_source = g_idle_source_new ();
+      g_source_set_callback (self->seek_source,
+          (GSourceFunc) gst_player_seek_internal, self, NULL);
+      g_source_attach (self->seek_source, self->context);
+    }
+  }
+
+  g_mutex_unlock (&self->lock);
+
+  return G_SOURCE_REMOVE;
+}
+
+/**
+ * gst_player_set_rate:
+ * @player: #GstPlayer instance
+ * @rate: playback rate
+ *
+ * Playback at specified rate. As long as the playback direction stays the
+ * same, the rate is changed without flushing the pipeline if possible, so
+ * that buffered data is kept and playback does not stall.
+ */
+void
+gst_player_set_rate (GstPlayer * self, gdouble rate)
+{
+  g_return_if_fail (GST_IS_PLAYER (self));
+  g_return_if_fail (rate != 0.0);
+
+  g_mutex_lock (&self->lock);
+  self->rate = rate;
+  g_mutex_unlock (&self->lock);
+
+  gst_player_set_rate_internal (self);
+}
+
+/**
+ * gst_player_get_rate:
+ * @player: #GstPlayer instance
+ *
+ * Returns: current playback rate
+ */
+gdouble
+gst_player_get_rate (GstPlayer * self)
+{
+  g_return_val_if_fail (GST_IS_PLAYER (self), DEFAULT_RATE);
+
+  return self->rate;
+}
+
+static gboolean
+gst_player_set_position_update_interval_internal (gpointer user_data)
+{
+  GstPlayer *self = user_data;
+
+  g_mutex_lock (&self->lock);
+
+  if (self->tick_source) {
+    remove_tick_source (self);
+    add_tick_source (self);
+  }
+
+  g_mutex_unlock (&self->lock);
+
+  return G_SOURCE_REMOVE;
+}
+
+/**
+ * gst_player_set_position_update_interval:
+ * @player: #GstPlayer instance
+ * @interval: interval in ms
+ *
+ * Set interval in milliseconds between two position-updated signals.
+ * Pass 0 to stop updating the position.
+ */
+void
+gst_player_set_position_update_interval (GstPlayer * self, guint interval)
+{
+  g_return_if_fail (GST_IS_PLAYER (self));
+  g_return_if_fail (interval <= 10000);
+
+  g_mutex_lock (&self->lock);
+  self->position_update_interval_ms = interval;
+  g_mutex_unlock (&self->lock);
+
+  gst_player_set_position_update_interval_internal (self);
+}
+
+/**
+ * gst_player_get_position_update_interval:
+ * @player: #GstPlayer instance
+ *
+ * Returns: current position update interval in milliseconds
+ */
+guint
+gst_player_get_position_update_interval (GstPlayer * self)
+{
+  g_return_val_if_fail (GST_IS_PLAYER (self),
+      DEFAULT_POSITION_UPDATE_INTERVAL_MS);
+
+  return self->position_update_interval_ms;
+}
+
+/**
+ * gst_player_set_tag_update_interval:
+ * @player: #GstPlayer instance
+ * @interval: interval in ms
+ *
+ * Set the minimum interval in milliseconds between two
+ * #GstPlayer::media-info-updated signals caused by global tags. Tags
+ * received in between are merged and only the last ones are applied at
+ * the end of the interval. Tags that are equal to the current ones are
+ * always ignored. Pass 0 to apply every change immediately.
+ */
+void
+gst_player_set_tag_update_interval (GstPlayer * self, guint interval)
+{
+  g_return_if_fail (GST_IS_PLAYER (self));
+  g_return_if_fail (interval <= 60000);
+
+  g_object_set (self, "tag-update-interval", interval, NULL);
+}
+
+/**
+ * gst_player_get_tag_update_interval:
+ * @player: #GstPlayer instance
+ *
+ * Returns: current tag update interval in milliseconds
+ */
+guint
+gst_player_get_tag_update_interval (GstPlayer * self)
+{
+  guint val;
+
+  g_return_val_if_fail (GST_IS_PLAYER (self), DEFAULT_TAG_UPDATE_INTERVAL_MS);
+
+  g_object_get (self, "tag-update-interval", &val, NULL);
+
+  return val;
+}
+
+/**
+ * gst_player_seek:
+ * @player: #GstPlayer instance
+ * @position: position to seek in nanoseconds
+ *
+ * Seeks the currently-playing stream to the absolute @position time
+ * in nanoseconds.
+ */
+void
+gst_player_seek (GstPlayer * self, GstClockTime position)
+{
+  g_return_if_fail (GST_IS_PLAYER (self));
+  g_return_if_fail (GST_CLOCK_TIME_IS_VALID (position));
+
+  g_mutex_lock (&self->lock);
+  if (self->media_info && !self->media_info->seekable) {
+    GST_DEBUG_OBJECT (self, "Media is not seekable");
+    g_mutex_unlock (&self->lock);
+    return;
+  }
+
+  self->seek_position = position;
+  self->rate_change_pending = FALSE;
+
+  /* Reported as position until the trimmed pipeline is restored */
+  if (g_atomic_int_get (&self->pipeline_trimmed)) {
+    g_mutex_lock (&self->trim_lock);
+    self->trimmed_position = position;
+    g_mutex_unlock (&self->trim_lock);
+  }
+
+  /* If there is no seek being dispatch to the main context currently do that,
+   * otherwise we just updated the seek position so that it will be taken by
+   * the seek handler from the main context instead of the old one.
+   */
+  if (!self->seek_source) {
+    GstClockTime now = gst_util_get_timestamp ();
+
+    /* If no seek is pending or it was started more than 250 mseconds ago seek
+     * immediately, otherwise wait until the 250 mseconds have passed */
+    if (!self->seek_pending || (now - self->last_seek_time > 250 * GST_MSECOND)) {
+      self->seek_source = g_idle_source_new ();
+      g_source_set_callback (self->seek_source,
+          (GSourceFunc) gst_player_seek_internal, self, NULL);
+      GST_TRACE_OBJECT (self, "Dispatching seek to position %" GST_TIME_FORMAT,
+          GST_TIME_ARGS (position));
+      g_source_attach (self->seek_source, self->context);
+    } else {
+      guint delay = 250000 - (now - self->last_seek_time) / 1000;
+
+      /* Note that last_seek_time must be set to something at this point and
+       * it must be smaller than 250 mseconds */
+      self->seek_source = g_timeout_source_new (delay);
+      g_source_set_callback (self->seek_source,
+          (GSourceFunc) gst_player_seek_internal, self, NULL);
+
+      GST_TRACE_OBJECT (self,
+          "Delaying seek to position %" GST_TIME_FORMAT " by %u us",
+          GST_TIME_ARGS (position), delay);
+      g_source_attach (self->seek_source, self->context);
+    }
+  }
+  g_mutex_unlock (&self->lock);
+}
+
+static ScrubCallback *
+scrub_callback_ref (ScrubCallback * callback)
+{
+  g_atomic_int_inc (&callback->ref_count);
+
+  return callback;
+}
+
+static void
+scrub_callback_unref (ScrubCallback * callback)
+{
+  if (!g_atomic_int_dec_and_test (&callback->ref_count))
+    return;
+
+  if (callback->notify)
+    callback->notify (callback->user_data);
+  g_free (callback);
+}
+
+typedef struct
+{
+  GstPlayer *player;
+  ScrubCallback *callback;
+  GstSample *sample;
+  GstClockTime position;
+} ScrubFrameData;
+
+static void
+scrub_frame_dispatch (gpointer user_data)
+{
+  ScrubFrameData *data = user_data;
+
+  data->callback->func (data->player, data->sample, data->position,
+      data->callback->user_data);
+}
+
+static void
+scrub_frame_data_free (ScrubFrameData * data)
+{
+  g_object_unref (data->player);
+  scrub_callback_unref (data->callback);
+  gst_sample_unref (data->sample);
+  g_free (data);
+}
+
+/* Called from the streaming thread of the preview pipeline */
+static void
+scrub_frame_cb (GstSample * sample, GstClockTime position, gpointer user_data)
+{
+  GstPlayer *self = user_data;
+  ScrubCallback *callback = NULL;
+  ScrubFrameData *data;
+
+  g_mutex_lock (&self->lock);
+  if (self->scrub_callback)
+    callback = scrub_callback_ref (self->scrub_callback);
+  g_mutex_unlock (&self->lock);
+
+  if (!callback)
+    return;
+
+  data = g_new (ScrubFrameData, 1);
+  data->player = g_object_ref (self);
+  data->callback = callback;
+  data->sample = gst_sample_ref (sample);
+  data->position = position;
+  gst_player_signal_dispatcher_dispatch (self->signal_dispatcher, self,
+      scrub_frame_dispatch, data, (GDestroyNotify) scrub_frame_data_free);
+}
+
+/* Must be called from main context */
+static void
+free_scrub (GstPlayer * self)
+{
+  if (!self->scrub)
+    return;
+
+  gst_player_scrub_free (self->scrub);
+  self->scrub = NULL;
+}
+
+static gboolean
+gst_player_scrub_begin_internal (gpointer user_data)
+{
+  GstPlayer *self = user_data;
+  GstPlayerKeyframeIndex *index = NULL;
+  gchar *uri = NULL;
+  gint width = 0, height = 0;
+
+  free_scrub (self);
+
+  g_mutex_lock (&self->lock);
+  /* Already ended again */
+  if (self->scrub_callback && self->uri) {
+    uri = g_strdup (self->uri);
+    width = self->scrub_width;
+    height = self->scrub_height;
+    if (self->keyframe_index)
+      index = gst_player_keyframe_index_ref (self->keyframe_index);
+  }
+  g_mutex_unlock (&self->lock);
+
+  if (!uri)
+    return G_SOURCE_REMOVE;
+
+  /* The preview pipeline loads the keyframes seen so far instead of
+   * searching them again */
+  if (index) {
+    if (!self->is_live)
+      gst_player_keyframe_index_save (index);
+    gst_player_keyframe_index_unref (index);
+  }
+
+  GST_DEBUG_OBJECT (self, "Starting scrub previews of %dx%d", width, height);
+  self->scrub =
+      gst_player_scrub_new (self->context, uri, width, height, scrub_frame_cb,
+      self);
+  g_free (uri);
+
+  return G_SOURCE_REMOVE;
+}
+
+static gboolean
+gst_player_scrub_internal (gpointer user_data)
+{
+  GstPlayer *self = user_data;
+  GstClockTime position;
+
+  g_mutex_lock (&self->lock);
+  self->scrub_seek_pending = FALSE;
+  position = self->scrub_position;
+  g_mutex_unlock (&self->lock);
+
+  if (self->scrub && GST_CLOCK_TIME_IS_VALID (position))
+    gst_player_scrub_seek (self->scrub, position);
+
+  return G_SOURCE_REMOVE;
+}
+
+static gboolean
+gst_player_scrub_end_internal (gpointer user_data)
+{
+  GstPlayer *self = user_data;
+  gboolean active;
+
+  g_mutex_lock (&self->lock);
+  active = self->scrub_callback != NULL;
+  g_mutex_unlock (&self->lock);
+
+  /* Unless scrubbing was started again in the meantime */
+  if (!active)
+    free_scrub (self);
+
+  return G_SOURCE_REMOVE;
+}
+
+/**
+ * gst_player_scrub_begin:
+ * @player: #GstPlayer instance
+ * @width: width of the preview frames
+ * @height: height of the preview frames
+ * @func: called with every preview frame
+ * @user_data: (closure): user data passed to @func
+ * @notify: (allow-none): called when @user_data is no longer needed
+ *
+ * Starts showing preview frames while the user drags a seek slider. The
+ * frames come from a second pipeline that only decodes keyframes, scaled
+ * down to the preview size right after the decoder, and no audio, so
+ * moving the slider never waits for a full seek of the playing media.
+ * Pass every slider position to gst_player_scrub() and call
+ * gst_player_scrub_end() when the slider is released.
+ *
+ * @func is called from the #GstPlayerSignalDispatcher, or from a streaming
+ * thread if there is none, with RGBA frames of exactly @width x @height,
+ * letterboxed if needed. The playing media is not changed, pause it
+ * first if it should not go on.
+ */
+void
+gst_player_scrub_begin (GstPlayer * self, gint width, gint height,
+    GstPlayerScrubFunc func, gpointer user_data, GDestroyNotify notify)
+{
+  ScrubCallback *callback, *old_callback;
+
+  g_return_if_fail (GST_IS_PLAYER (self));
+  g_return_if_fail (width > 0 && height > 0);
+  g_return_if_fail (func != NULL);
+
+  callback = g_new0 (ScrubCallback, 1);
+  callback->ref_count = 1;
+  callback->func = func;
+  callback->user_data = user_data;
+  callback->notify = notify;
+
+  g_mutex_lock (&self->lock);
+  old_callback = self->scrub_callback;
+  self->scrub_callback = callback;
+  self->scrub_width = width;
+  self->scrub_height = height;
+  self->scrub_position = GST_CLOCK_TIME_NONE;
+  g_mutex_unlock (&self->lock);
+
+  if (old_callback)
+    scrub_callback_unref (old_callback);
+
+  g_main_context_invoke_full (self->context, G_PRIORITY_DEFAULT,
+      gst_player_scrub_begin_internal, self, NULL);
+}
+
+/**
+ * gst_player_scrub:
+ * @player: #GstPlayer instance
+ * @position: position to show a preview of
+ *
+ * Requests a preview frame of the keyframe nearest to @position. Positions
+ * requested while the previous preview is still being decoded replace
+ * each other, only the latest one is shown. Does nothing unless
+ * gst_player_scrub_begin() was called.
+ */
+void
+gst_player_scrub (GstPlayer * self, GstClockTime position)
+{
+  gboolean dispatch;
+
+  g_return_if_fail (GST_IS_PLAYER (self));
+  g_return_if_fail (GST_CLOCK_TIME_IS_VALID (position));
+
+  g_mutex_lock (&self->lock);
+  if (!self->scrub_callback) {
+    g_mutex_unlock (&self->lock);
+    return;
+  }
+  self->scrub_position = position;
+  dispatch = !self->scrub_seek_pending;
+  self->scrub_seek_pending = TRUE;
+  g_mutex_unlock (&self->lock);
+
+  if (dispatch)
+    g_main_context_invoke_full (self->context, G_PRIORITY_DEFAULT,
+        gst_player_scrub_internal, self, NULL);
+}
+
+/**
+ * gst_player_scrub_end:
+ * @player: #GstPlayer instance
+ * @seek: whether to seek to the last scrub position
+ *
+ * Stops showing preview frames and shuts down the preview pipeline. If
+ * @seek is %TRUE, the playing media is seeked to the last position passed
+ * to gst_player_scrub().
+ */
+void
+gst_player_scrub_end (GstPlayer * self, gboolean seek)
+{
+  ScrubCallback *callback;
+  GstClockTime position;
+
+  g_return_if_fail (GST_IS_PLAYER (self));
+
+  g_mutex_lock (&self->lock);
+  callback = self->scrub_callback;
+  self->scrub_callback = NULL;
+  position = self->scrub_position;
+  self->scrub_position = GST_CLOCK_TIME_NONE;
+  g_mutex_unlock (&self->lock);
+
+  if (!callback)
+    return;
+
+  scrub_callback_unref (callback);
+
+  g_main_context_invoke_full (self->context, G_PRIORITY_DEFAULT,
+      gst_player_scrub_end_internal, self, NULL);
+
+  if (seek && GST_CLOCK_TIME_IS_VALID (position))
+    gst_player_seek (self, position);
+}
+
+/**
+ * gst_player_get_uri:
+ * @player: #GstPlayer instance
+ *
+ * Gets the URI of the currently-playing stream.
+ *
+ * Returns: (transfer full): a string containing the URI of the
+ * currently-playing stream. g_free() after usage.
+ */
+gchar *
+gst_player_get_uri (GstPlayer * self)
+{
+  gchar *val;
+
+  g_return_val_if_fail (GST_IS_PLAYER (self), DEFAULT_URI);
+
+  g_object_get (self, "uri", &val, NULL);
+
+  return val;
+}
+
+/**
+ * gst_player_set_uri:
+ * @player: #GstPlayer instance
+ * @uri: next URI to play.
+ *
+ * Sets the next URI to play.
+ */
+void
+gst_player_set_uri (GstPlayer * self, const gchar * val)
+{
+  g_return_if_fail (GST_IS_PLAYER (self));
+
+  g_object_set (self, "uri", val, NULL);
+}
+
+/**
+ * gst_player_get_position:
+ * @player: #GstPlayer instance
+ *
+ * Returns: the absolute position time, in nanoseconds, of the
+ * currently-playing stream.
+ */
+GstClockTime
+gst_player_get_position (GstPlayer * self)
+{
+  GstClockTime val;
+
+  g_return_val_if_fail (GST_IS_PLAYER (self), DEFAULT_POSITION);
+
+  g_object_get (self, "position", &val, NULL);
+
+  return val;
+}
+
+/**
+ * gst_player_get_duration:
+ * @player: #GstPlayer instance
+ *
+ * Retrieves the duration of the media stream that self represents.
+ *
+ * Returns: the duration of the currently-playing media stream, in
+ * nanoseconds.
+ */
+GstClockTime
+gst_player_get_duration (GstPlayer * self)
+{
+  GstClockTime val;
+
+  g_return_val_if_fail (GST_IS_PLAYER (self), DEFAULT_DURATION);
+
+  g_object_get (self, "duration", &val, NULL);
+
+  return val;
+}
+
+/**
+ * gst_player_get_volume:
+ * @player: #GstPlayer instance
+ *
+ * Returns the current volume level, as a percentage between 0 and 1.
+ *
+ * Returns: the volume as percentage between 0 and 1.
+ */
+gdouble
+gst_player_get_volume (GstPlayer * self)
+{
+  gdouble val;
+
+  g_return_val_if_fail (GST_IS_PLAYER (self), DEFAULT_VOLUME);
 
-  g_signal_connect (self->playbin, "video-changed",
-      G_CALLBACK (video_changed_cb), self);
-  g_signal_connect (self->playbin, "audio-changed",
-      G_CALLBACK (audio_changed_cb), self);
-  g_signal_connect (self->playbin, "text-changed",
-      G_CALLBACK (subtitle_changed_cb), self);
+  g_object_get (self, "volume", &val, NULL);
 
-  g_signal_connect (self->playbin, "video-tags-changed",
-      G_CALLBACK (video_tags_changed_cb), self);
-  g_signal_connect (self->playbin, "audio-tags-changed",
-      G_CALLBACK (audio_tags_changed_cb), self);
-  g_signal_connect (self->playbin, "text-tags-changed",
-      G_CALLBACK (subtitle_tags_changed_cb), self);
-  g_signal_connect (self->playbin, "notify::volume",
-      G_CALLBACK (volume_notify_cb), self);
-  g_signal_connect (self->playbin, "notify::mute",
-      G_CALLBACK (mute_notify_cb), self);
+  return val;
+}
 
-  self->target_state = GST_STATE_NULL;
-  self->current_state = GST_STATE_NULL;
-  change_state (self, GST_PLAYER_STATE_STOPPED);
-  self->buffering = 100;
-  self->is_eos = FALSE;
-  self->is_live = FALSE;
+/**
+ * gst_player_set_volume:
+ * @player: #GstPlayer instance
+ * @val: the new volume level, as a percentage between 0 and 1
+ *
+ * Sets the volume level of the stream as a percentage between 0 and 1.
+ */
+void
+gst_player_set_volume (GstPlayer * self, gdouble val)
+{
+  g_return_if_fail (GST_IS_PLAYER (self));
 
-  GST_TRACE_OBJECT (self, "Starting main loop");
-  g_main_loop_run (self->loop);
-  GST_TRACE_OBJECT (self, "Stopped main loop");
+  g_object_set (self, "volume", val, NULL);
+}
+
+/**
+ * gst_player_get_mute:
+ * @player: #GstPlayer instance
+ *
+ * Returns: %TRUE if the currently-playing stream is muted.
+ */
+gboolean
+gst_player_get_mute (GstPlayer * self)
+{
+  gboolean val;
+
+  g_return_val_if_fail (GST_IS_PLAYER (self), DEFAULT_MUTE);
+
+  g_object_get (self, "mute", &val, NULL);
+
+  return val;
+}
+
+/**
+ * gst_player_set_mute:
+ * @player: #GstPlayer instance
+ * @val: Mute state the should be set
+ *
+ * %TRUE if the currently-playing stream should be muted.
+ */
+void
+gst_player_set_mute (GstPlayer * self, gboolean val)
+{
+  g_return_if_fail (GST_IS_PLAYER (self));
+
+  g_object_set (self, "mute", val, NULL);
+}
+
+/**
+ * gst_player_get_pipeline:
+ * @player: #GstPlayer instance
+ *
+ * Returns: (transfer full): The internal playbin instance
+ */
+GstElement *
+gst_player_get_pipeline (GstPlayer * self)
+{
+  GstElement *val;
+
+  g_return_val_if_fail (GST_IS_PLAYER (self), NULL);
+
+  g_object_get (self, "pipeline", &val, NULL);
+
+  return val;
+}
+
+/**
+ * gst_player_get_media_info:
+ * @player: #GstPlayer instance
+ *
+ * A Function to get the current media info #GstPlayerMediaInfo instance.
+ *
+ * Returns: (transfer full): media info instance.
+ *
+ * The caller should free it with g_object_unref()
+ */
+GstPlayerMediaInfo *
+gst_player_get_media_info (GstPlayer * self)
+{
+  GstPlayerMediaInfo *info;
+
+  g_return_val_if_fail (GST_IS_PLAYER (self), NULL);
+
+  if (!self->media_info)
+    return NULL;
+
+  g_mutex_lock (&self->lock);
+  info = gst_player_media_info_copy (self->media_info);
+  g_mutex_unlock (&self->lock);
+
+  return info;
+}
+
+/**
+ * gst_player_get_current_audio_track:
+ * @player: #GstPlayer instance
+ *
+ * A Function to get current audio #GstPlayerAudioInfo instance.
+ *
+ * Returns: (transfer full): current audio track.
+ *
+ * The caller should free it with g_object_unref()
+ */
+GstPlayerAudioInfo *
+gst_player_get_current_audio_track (GstPlayer * self)
+{
+  GstPlayerAudioInfo *info;
+
+  g_return_val_if_fail (GST_IS_PLAYER (self), NULL);
+
+  if (!is_track_enabled (self, GST_PLAY_FLAG_AUDIO))
+    return NULL;
+
+  info = (GstPlayerAudioInfo *) gst_player_stream_info_get_current (self,
+      "current-audio", GST_TYPE_PLAYER_AUDIO_INFO);
+  return info;
+}
+
+/**
+ * gst_player_get_current_video_track:
+ * @player: #GstPlayer instance
+ *
+ * A Function to get current video #GstPlayerVideoInfo instance.
+ *
+ * Returns: (transfer full): current video track.
+ *
+ * The caller should free it with g_object_unref()
+ */
+GstPlayerVideoInfo *
+gst_player_get_current_video_track (GstPlayer * self)
+{
+  GstPlayerVideoInfo *info;
+
+  g_return_val_if_fail (GST_IS_PLAYER (self), NULL);
+
+  if (!is_track_enabled (self, GST_PLAY_FLAG_VIDEO))
+    return NULL;
+
+  info = (GstPlayerVideoInfo *) gst_player_stream_info_get_current (self,
+      "current-video", GST_TYPE_PLAYER_VIDEO_INFO);
+  return info;
+}
+
+/**
+ * gst_player_get_current_subtitle_track:
+ * @player: #GstPlayer instance
+ *
+ * A Function to get current subtitle #GstPlayerSubtitleInfo instance.
+ *
+ * Returns: (transfer none): current subtitle track.
+ *
+ * The caller should free it with g_object_unref()
+ */
+GstPlayerSubtitleInfo *
+gst_player_get_current_subtitle_track (GstPlayer * self)
+{
+  GstPlayerSubtitleInfo *info;
+
+  g_return_val_if_fail (GST_IS_PLAYER (self), NULL);
+
+  if (!is_track_enabled (self, GST_PLAY_FLAG_SUBTITLE))
+    return NULL;
+
+  info = (GstPlayerSubtitleInfo *) gst_player_stream_info_get_current (self,
+      "current-text", GST_TYPE_PLAYER_SUBTITLE_INFO);
+  return info;
+}
+
+/**
+ * gst_player_set_audio_track:
+ * @player: #GstPlayer instance
+ * @stream_index: stream index
+ *
+ * Returns: %TRUE or %FALSE
+ *
+ * Sets the audio track @stream_idex.
+ */
+gboolean
+gst_player_set_audio_track (GstPlayer * self, gint stream_index)
+{
+  GstPlayerStreamInfo *info;
+
+  g_return_val_if_fail (GST_IS_PLAYER (self), 0);
+
+  g_mutex_lock (&self->lock);
+  info = gst_player_stream_info_find (self, self->media_info,
+      GST_TYPE_PLAYER_AUDIO_INFO, stream_index);
+  g_mutex_unlock (&self->lock);
+  if (!info) {
+    GST_ERROR_OBJECT (self, "invalid audio stream index %d", stream_index);
+    return FALSE;
+  }
+
+  g_object_set (G_OBJECT (self->playbin), "current-audio", stream_index, NULL);
+  g_main_context_invoke_full (self->context, G_PRIORITY_DEFAULT,
+      gst_player_update_track_decoders_internal, self, NULL);
+  GST_DEBUG_OBJECT (self, "set stream index '%d'", stream_index);
+  return TRUE;
+}
+
+/**
+ * gst_player_set_video_track:
+ * @player: #GstPlayer instance
+ * @stream_index: stream index
+ *
+ * Returns: %TRUE or %FALSE
+ *
+ * Sets the video track @stream_index.
+ */
+gboolean
+gst_player_set_video_track (GstPlayer * self, gint stream_index)
+{
+  GstPlayerStreamInfo *info;
+
+  g_return_val_if_fail (GST_IS_PLAYER (self), 0);
+
+  /* check if stream_index exist in our internal media_info list */
+  g_mutex_lock (&self->lock);
+  info = gst_player_stream_info_find (self, self->media_info,
+      GST_TYPE_PLAYER_VIDEO_INFO, stream_index);
+  g_mutex_unlock (&self->lock);
+  if (!info) {
+    GST_ERROR_OBJECT (self, "invalid video stream index %d", stream_index);
+    return FALSE;
+  }
+
+  g_object_set (G_OBJECT (self->playbin), "current-video", stream_index, NULL);
+  g_main_context_invoke_full (self->context, G_PRIORITY_DEFAULT,
+      gst_player_update_track_decoders_internal, self, NULL);
+  GST_DEBUG_OBJECT (self, "set stream index '%d'", stream_index);
+  return TRUE;
+}
 
-  g_source_destroy (bus_source);
-  g_source_unref (bus_source);
-  gst_object_unref (bus);
+/**
+ * gst_player_set_subtitle_track:
+ * @player: #GstPlayer instance
+ * @stream_index: stream index
+ *
+ * Returns: %TRUE or %FALSE
+ *
+ * Sets the subtitle strack @stream_index.
+ */
+gboolean
+gst_player_set_subtitle_track (GstPlayer * self, gint stream_index)
+{
+  GstPlayerStreamInfo *info;
 
-  remove_tick_source (self);
-  remove_ready_timeout_source (self);
+  g_return_val_if_fail (GST_IS_PLAYER (self), 0);
 
   g_mutex_lock (&self->lock);
-  if (self->media_info) {
-    g_object_unref (self->media_info);
-    self->media_info = NULL;
-  }
-
-  if (self->seek_source)
-    g_source_unref (self->seek_source);
-  self->seek_source = NULL;
+  info = gst_player_stream_info_find (self, self->media_info,
+      GST_TYPE_PLAYER_SUBTITLE_INFO, stream_index);
   g_mutex_unlock (&self->lock);
-
-  g_main_context_pop_thread_default (self->context);
-
-  self->target_state = GST_STATE_NULL;
-  self->current_state = GST_STATE_NULL;
-  if (self->playbin) {
-    gst_element_set_state (self->playbin, GST_STATE_NULL);
-    gst_object_unref (self->playbin);
-    self->playbin = NULL;
+  if (!info) {
+    GST_ERROR_OBJECT (self, "invalid subtitle stream index %d", stream_index);
+    return FALSE;
   }
 
-  GST_TRACE_OBJECT (self, "Stopped main thread");
-
-  return NULL;
+  g_object_set (G_OBJECT (self->playbin), "current-text", stream_index, NULL);
+  GST_DEBUG_OBJECT (self, "set stream index '%d'", stream_index);
+  return TRUE;
 }
 
-static gpointer
-gst_player_init_once (gpointer user_data)
+/**
+ * gst_player_set_audio_track_enabled:
+ * @player: #GstPlayer instance
+ * @enabled: TRUE or FALSE
+ *
+ * Enable or disable the current audio track.
+ */
+void
+gst_player_set_audio_track_enabled (GstPlayer * self, gboolean enabled)
 {
-  gst_init (NULL, NULL);
+  g_return_if_fail (GST_IS_PLAYER (self));
 
-  GST_DEBUG_CATEGORY_INIT (gst_player_debug, "gst-player", 0, "GstPlayer");
-  gst_player_error_quark ();
+  if (enabled)
+    player_set_flag (self, GST_PLAY_FLAG_AUDIO);
+  else
+    player_clear_flag (self, GST_PLAY_FLAG_AUDIO);
 
-  return NULL;
+  GST_DEBUG_OBJECT (self, "track is '%s'", enabled ? "Enabled" : "Disabled");
 }
 
 /**
- * gst_player_new:
+ * gst_player_set_video_track_enabled:
+ * @player: #GstPlayer instance
+ * @enabled: TRUE or FALSE
  *
- * Returns: a new #GstPlayer instance
+ * Enable or disable the current video track.
  */
-GstPlayer *
-gst_player_new (void)
+void
+gst_player_set_video_track_enabled (GstPlayer * self, gboolean enabled)
 {
-  return gst_player_new_full (NULL, NULL);
+  g_return_if_fail (GST_IS_PLAYER (self));
+
+  if (enabled)
+    player_set_flag (self, GST_PLAY_FLAG_VIDEO);
+  else
+    player_clear_flag (self, GST_PLAY_FLAG_VIDEO);
+
+  GST_DEBUG_OBJECT (self, "track is '%s'", enabled ? "Enabled" : "Disabled");
 }
 
 /**
- * gst_player_new_full:
- * @video_renderer: (transfer full) (allow-none): GstPlayerVideoRenderer to use
- * @signal_dispatcher: (transfer full) (allow-none): GstPlayerSignalDispatcher to use
- *
- * Creates a new #GstPlayer instance that uses @signal_dispatcher to dispatch
- * signals to some event loop system, or emits signals directly if NULL is
- * passed. See gst_player_g_main_context_signal_dispatcher_new().
- *
- * Video is going to be rendered by @video_renderer, or if %NULL is provided
- * no special video set up will be done and some default handling will be
- * performed.
+ * gst_player_set_subtitle_track_enabled:
+ * @player: #GstPlayer instance
+ * @enabled: TRUE or FALSE
  *
- * Returns: a new #GstPlayer instance
+ * Enable or disable the current subtitle track.
  */
-GstPlayer *
-gst_player_new_full (GstPlayerVideoRenderer * video_renderer,
-    GstPlayerSignalDispatcher * signal_dispatcher)
+void
+gst_player_set_subtitle_track_enabled (GstPlayer * self, gboolean enabled)
 {
-  static GOnce once = G_ONCE_INIT;
-  GstPlayer *self;
-
-  g_once (&once, gst_player_init_once, NULL);
-
-  self =
-      g_object_new (GST_TYPE_PLAYER, "video-renderer", video_renderer,
-      "signal-dispatcher", signal_dispatcher, NULL);
+  g_return_if_fail (GST_IS_PLAYER (self));
 
-  if (video_renderer)
-    g_object_unref (video_renderer);
-  if (signal_dispatcher)
-    g_object_unref (signal_dispatcher);
+  if (enabled)
+    player_set_flag (self, GST_PLAY_FLAG_SUBTITLE);
+  else
+    player_clear_flag (self, GST_PLAY_FLAG_SUBTITLE);
 
-  return self;
+  GST_DEBUG_OBJECT (self, "track is '%s'", enabled ? "Enabled" : "Disabled");
 }
 
-static gboolean
-gst_player_play_internal (gpointer user_data)
+/**
+ * gst_player_set_subtitle_uri:
+ * @player: #GstPlayer instance
+ * @uri: subtitle URI
+ *
+ * Returns: %TRUE or %FALSE
+ *
+ * Sets the external subtitle URI.
+ */
+gboolean
+gst_player_set_subtitle_uri (GstPlayer * self, const gchar * suburi)
 {
-  GstPlayer *self = GST_PLAYER (user_data);
-  GstStateChangeReturn state_ret;
-
-  GST_DEBUG_OBJECT (self, "Play");
+  g_return_val_if_fail (GST_IS_PLAYER (self), FALSE);
 
   g_mutex_lock (&self->lock);
-  if (!self->uri) {
-    g_mutex_unlock (&self->lock);
-    return G_SOURCE_REMOVE;
-  }
+  if (self->suburi)
+    g_free (self->suburi);
+  self->suburi = g_strdup (suburi);
   g_mutex_unlock (&self->lock);
 
-  remove_ready_timeout_source (self);
-  self->target_state = GST_STATE_PLAYING;
+  gst_player_set_suburi_internal (self);
 
-  if (self->current_state < GST_STATE_PAUSED)
-    change_state (self, GST_PLAYER_STATE_BUFFERING);
+  return TRUE;
+}
 
-  if (self->current_state >= GST_STATE_PAUSED && !self->is_eos) {
-    state_ret = gst_element_set_state (self->playbin, GST_STATE_PLAYING);
-  } else {
-    state_ret = gst_element_set_state (self->playbin, GST_STATE_PAUSED);
-  }
+/**
+ * gst_player_get_subtitle_uri:
+ * @player: #GstPlayer instance
+ *
+ * current subtitle URI
+ *
+ * Returns: (transfer full): URI of the current external subtitle.
+ *   g_free() after usage.
+ */
+gchar *
+gst_player_get_subtitle_uri (GstPlayer * self)
+{
+  gchar *val = NULL;
 
-  if (state_ret == GST_STATE_CHANGE_NO_PREROLL) {
-    self->is_live = TRUE;
-    GST_DEBUG_OBJECT (self, "Pipeline is live");
-  }
+  g_return_val_if_fail (GST_IS_PLAYER (self), NULL);
 
-  if (state_ret == GST_STATE_CHANGE_FAILURE) {
-    emit_error (self, g_error_new (GST_PLAYER_ERROR, GST_PLAYER_ERROR_FAILED,
-            "Failed to play"));
-    return G_SOURCE_REMOVE;
-  } else if (state_ret == GST_STATE_CHANGE_NO_PREROLL) {
-    self->is_live = TRUE;
-    GST_DEBUG_OBJECT (self, "Pipeline is live");
-  }
+  g_object_get (self, "suburi", &val, NULL);
 
-  if (self->is_eos) {
-    gboolean ret;
+  return val;
+}
 
-    GST_DEBUG_OBJECT (self, "Was EOS, seeking to beginning");
-    self->is_eos = FALSE;
-    ret =
-        gst_element_seek_simple (self->playbin, GST_FORMAT_TIME,
-        GST_SEEK_FLAG_FLUSH, 0);
-    if (!ret) {
-      GST_ERROR_OBJECT (self, "Seek to beginning failed");
-      gst_player_stop_internal (self);
-      gst_player_play_internal (self);
-    }
-  }
+static SubtitleRasterizer *
+subtitle_rasterizer_ref (SubtitleRasterizer * rasterizer)
+{
+  g_atomic_int_inc (&rasterizer->ref_count);
 
-  return G_SOURCE_REMOVE;
+  return rasterizer;
 }
 
-/**
- * gst_player_play:
- * @player: #GstPlayer instance
- *
- * Request to play the loaded stream.
- */
-void
-gst_player_play (GstPlayer * self)
+static void
+subtitle_rasterizer_unref (SubtitleRasterizer * rasterizer)
 {
-  g_return_if_fail (GST_IS_PLAYER (self));
+  if (!g_atomic_int_dec_and_test (&rasterizer->ref_count))
+    return;
 
-  g_main_context_invoke_full (self->context, G_PRIORITY_DEFAULT,
-      gst_player_play_internal, self, NULL);
+  if (rasterizer->notify)
+    rasterizer->notify (rasterizer->user_data);
+  g_free (rasterizer);
 }
 
-static gboolean
-gst_player_pause_internal (gpointer user_data)
+/* Called from the video streaming thread for cues not cached yet */
+static GstVideoOverlayRectangle *
+rasterize_subtitle (const gchar * text, gboolean markup, gint width,
+    gint height, gpointer user_data)
 {
   GstPlayer *self = GST_PLAYER (user_data);
-  GstStateChangeReturn state_ret;
-
-  GST_DEBUG_OBJECT (self, "Pause");
+  SubtitleRasterizer *rasterizer = NULL;
+  GstVideoOverlayRectangle *rectangle;
 
   g_mutex_lock (&self->lock);
-  if (!self->uri) {
-    g_mutex_unlock (&self->lock);
-    return G_SOURCE_REMOVE;
-  }
+  if (self->subtitle_rasterizer)
+    rasterizer = subtitle_rasterizer_ref (self->subtitle_rasterizer);
   g_mutex_unlock (&self->lock);
 
-  tick_cb (self);
-  remove_tick_source (self);
-  remove_ready_timeout_source (self);
+  if (!rasterizer)
+    return NULL;
 
-  self->target_state = GST_STATE_PAUSED;
+  rectangle = rasterizer->func (self, text, markup, width, height,
+      rasterizer->user_data);
+  subtitle_rasterizer_unref (rasterizer);
 
-  if (self->current_state < GST_STATE_PAUSED)
-    change_state (self, GST_PLAYER_STATE_BUFFERING);
+  return rectangle;
+}
 
-  state_ret = gst_element_set_state (self->playbin, GST_STATE_PAUSED);
-  if (state_ret == GST_STATE_CHANGE_FAILURE) {
-    emit_error (self, g_error_new (GST_PLAYER_ERROR, GST_PLAYER_ERROR_FAILED,
-            "Failed to pause"));
-    return G_SOURCE_REMOVE;
-  } else if (state_ret == GST_STATE_CHANGE_NO_PREROLL) {
-    self->is_live = TRUE;
-    GST_DEBUG_OBJECT (self, "Pipeline is live");
+/* Collects the cues that playsink would otherwise render with textoverlay */
+static GstPadProbeReturn
+subtitle_sink_probe_cb (GstPad * pad, GstPadProbeInfo * info,
+    gpointer user_data)
+{
+  GstPlayer *self = GST_PLAYER (user_data);
+  GstClockTime start, stop = GST_CLOCK_TIME_NONE;
+  const GstSegment *segment;
+  GstStructure *s;
+  GstBuffer *buffer;
+  GstEvent *event;
+  GstCaps *caps;
+  GstMapInfo map;
+  gboolean markup = FALSE;
+  gchar *text;
+
+  if (info->type & GST_PAD_PROBE_TYPE_EVENT_BOTH) {
+    event = GST_PAD_PROBE_INFO_EVENT (info);
+    if (GST_EVENT_TYPE (event) == GST_EVENT_FLUSH_STOP)
+      gst_player_subtitle_overlay_flush (self->subtitle_overlay);
+
+    return GST_PAD_PROBE_OK;
+  }
+
+  buffer = GST_PAD_PROBE_INFO_BUFFER (info);
+  if (!GST_BUFFER_PTS_IS_VALID (buffer))
+    return GST_PAD_PROBE_OK;
+
+  event = gst_pad_get_sticky_event (pad, GST_EVENT_SEGMENT, 0);
+  if (!event)
+    return GST_PAD_PROBE_OK;
+  gst_event_parse_segment (event, &segment);
+  if (segment->format != GST_FORMAT_TIME) {
+    gst_event_unref (event);
+    return GST_PAD_PROBE_OK;
+  }
+  start = gst_segment_to_running_time (segment, GST_FORMAT_TIME,
+      GST_BUFFER_PTS (buffer));
+  if (GST_BUFFER_DURATION_IS_VALID (buffer))
+    stop = gst_segment_to_running_time (segment, GST_FORMAT_TIME,
+        GST_BUFFER_PTS (buffer) + GST_BUFFER_DURATION (buffer));
+  gst_event_unref (event);
+
+  caps = gst_pad_get_current_caps (pad);
+  if (caps) {
+    s = gst_caps_get_structure (caps, 0);
+    markup = g_strcmp0 (gst_structure_get_string (s, "format"),
+        "pango-markup") == 0;
+    gst_caps_unref (caps);
   }
 
-  if (self->is_eos) {
-    gboolean ret;
+  if (gst_buffer_map (buffer, &map, GST_MAP_READ)) {
+    text = g_strndup ((const gchar *) map.data, map.size);
+    if (*text)
+      gst_player_subtitle_overlay_add_cue (self->subtitle_overlay, text,
+          markup, start, stop);
+    g_free (text);
+    gst_buffer_unmap (buffer, &map);
+  }
 
-    GST_DEBUG_OBJECT (self, "Was EOS, seeking to beginning");
-    self->is_eos = FALSE;
-    ret =
-        gst_element_seek_simple (self->playbin, GST_FORMAT_TIME,
-        GST_SEEK_FLAG_FLUSH, 0);
-    if (!ret) {
-      GST_ERROR_OBJECT (self, "Seek to beginning failed");
-      gst_player_stop_internal (self);
-      gst_player_pause_internal (self);
+  return GST_PAD_PROBE_OK;
+}
+
+static gboolean
+gst_player_set_subtitle_rasterizer_internal (gpointer user_data)
+{
+  GstPlayer *self = GST_PLAYER (user_data);
+  GstElement *text_sink = NULL;
+  gboolean enabled;
+  GstPad *pad;
+
+  g_mutex_lock (&self->lock);
+  enabled = self->subtitle_rasterizer != NULL;
+  g_mutex_unlock (&self->lock);
+
+  /* A text sink of our own keeps playsink from adding a textoverlay. Like
+   * all sink changes in playbin this only takes effect from READY. */
+  if (enabled) {
+    text_sink = gst_element_factory_make ("fakesink", "subtitle-sink");
+    if (!text_sink) {
+      GST_WARNING_OBJECT (self, "No fakesink, can't rasterize subtitles");
+      return G_SOURCE_REMOVE;
     }
+    /* Cues are queued until their frames come */
+    g_object_set (text_sink, "sync", FALSE, "async", FALSE, NULL);
+    pad = gst_element_get_static_pad (text_sink, "sink");
+    gst_pad_add_probe (pad,
+        GST_PAD_PROBE_TYPE_BUFFER | GST_PAD_PROBE_TYPE_EVENT_DOWNSTREAM |
+        GST_PAD_PROBE_TYPE_EVENT_FLUSH, subtitle_sink_probe_cb, self, NULL);
+    gst_object_unref (pad);
   }
+  g_object_set (self->playbin, "text-sink", text_sink, NULL);
+  if (self->current_state > GST_STATE_READY)
+    GST_DEBUG_OBJECT (self, "Text sink changes with the next stream");
+
+  gst_player_subtitle_overlay_flush (self->subtitle_overlay);
+  gst_player_subtitle_overlay_set_enabled (self->subtitle_overlay, enabled);
 
   return G_SOURCE_REMOVE;
 }
 
 /**
- * gst_player_pause:
+ * gst_player_set_subtitle_rasterizer:
  * @player: #GstPlayer instance
+ * @func: (allow-none): function rendering subtitle cues, or %NULL
+ * @user_data: user data passed to @func
+ * @notify: called when @user_data is no longer needed
  *
- * Pauses the current stream.
+ * Lets the application render subtitles instead of the textoverlay
+ * element, e.g. with the text engine of the platform. @func is called
+ * once for every cue and frame size, and the rectangle it returns is
+ * reused for every frame the cue is shown on. Video sinks that composite
+ * #GstVideoOverlayCompositionMeta get the rectangles as metadata, so the
+ * frames are never touched, otherwise they are blended into the frames.
+ *
+ * Set this before playback starts, the subtitles are only rendered like
+ * this from the next stream on. Pass %NULL to go back to textoverlay.
  */
 void
-gst_player_pause (GstPlayer * self)
+gst_player_set_subtitle_rasterizer (GstPlayer * self,
+    GstPlayerSubtitleRasterizeFunc func, gpointer user_data,
+    GDestroyNotify notify)
 {
+  SubtitleRasterizer *rasterizer = NULL, *old_rasterizer;
+
   g_return_if_fail (GST_IS_PLAYER (self));
 
+  if (func) {
+    rasterizer = g_new0 (SubtitleRasterizer, 1);
+    rasterizer->ref_count = 1;
+    rasterizer->func = func;
+    rasterizer->user_data = user_data;
+    rasterizer->notify = notify;
+  }
+
+  g_mutex_lock (&self->lock);
+  old_rasterizer = self->subtitle_rasterizer;
+  self->subtitle_rasterizer = rasterizer;
+  g_mutex_unlock (&self->lock);
+
+  if (old_rasterizer)
+    subtitle_rasterizer_unref (old_rasterizer);
+
   g_main_context_invoke_full (self->context, G_PRIORITY_DEFAULT,
-      gst_player_pause_internal, self, NULL);
+      gst_player_set_subtitle_rasterizer_internal, self, NULL);
 }
 
-static gboolean
-gst_player_stop_internal (gpointer user_data)
+G_DEFINE_BOXED_TYPE (GstPlayerVisualization, gst_player_visualization,
+    (GBoxedCopyFunc) gst_player_visualization_copy,
+    (GBoxedFreeFunc) gst_player_visualization_free);
+
+/**
+ * gst_player_visualization_free:
+ * @vis: #GstPlayerVisualization instance
+ *
+ * Frees #GstPlayerVisualization allocated using g_new() or
+ * gst_player_visualization_copy().
+ */
+void
+gst_player_visualization_free (GstPlayerVisualization * vis)
 {
-  GstPlayer *self = GST_PLAYER (user_data);
+  g_return_if_fail (vis != NULL);
 
-  GST_DEBUG_OBJECT (self, "Stop");
+  g_free (vis->name);
+  g_free (vis->description);
+  g_free (vis);
+}
 
-  tick_cb (self);
-  remove_tick_source (self);
+/**
+ * gst_player_visualization_copy:
+ * @vis: #GstPlayerVisualization instance
+ *
+ * Makes a copy of the #GstPlayerVisualization. The result must be
+ * freed using gst_player_visualization_free().
+ *
+ * Returns: (transfer full): an allocated copy of @vis.
+ */
+GstPlayerVisualization *
+gst_player_visualization_copy (const GstPlayerVisualization * vis)
+{
+  GstPlayerVisualization *ret;
 
-  add_ready_timeout_source (self);
+  g_return_val_if_fail (vis != NULL, NULL);
 
-  self->target_state = GST_STATE_NULL;
-  self->current_state = GST_STATE_READY;
-  self->is_live = FALSE;
-  self->is_eos = FALSE;
-  gst_bus_set_flushing (self->bus, TRUE);
-  gst_element_set_state (self->playbin, GST_STATE_READY);
-  gst_bus_set_flushing (self->bus, FALSE);
-  change_state (self, GST_PLAYER_STATE_STOPPED);
-  self->buffering = 100;
-  g_mutex_lock (&self->lock);
-  if (self->media_info) {
-    g_object_unref (self->media_info);
-    self->media_info = NULL;
-  }
-  if (self->global_tags) {
-    gst_tag_list_unref (self->global_tags);
-    self->global_tags = NULL;
-  }
-  self->seek_pending = FALSE;
-  if (self->seek_source) {
-    g_source_destroy (self->seek_source);
-    g_source_unref (self->seek_source);
-    self->seek_source = NULL;
-  }
-  self->seek_position = GST_CLOCK_TIME_NONE;
-  self->last_seek_time = GST_CLOCK_TIME_NONE;
-  self->rate = 1.0;
-  g_mutex_unlock (&self->lock);
+  ret = g_new0 (GstPlayerVisualization, 1);
+  ret->name = vis->name ? g_strdup (vis->name) : NULL;
+  ret->description = vis->description ? g_strdup (vis->description) : NULL;
 
-  return G_SOURCE_REMOVE;
+  return ret;
 }
 
 /**
- * gst_player_stop:
- * @player: #GstPlayer instance
+ * gst_player_visualizations_free:
+ * @viss: a %NULL terminated array of #GstPlayerVisualization to free
  *
- * Stops playing the current stream and resets to the first position
- * in the stream.
+ * Frees a %NULL terminated array of #GstPlayerVisualization.
  */
 void
-gst_player_stop (GstPlayer * self)
+gst_player_visualizations_free (GstPlayerVisualization ** viss)
 {
-  g_return_if_fail (GST_IS_PLAYER (self));
+  GstPlayerVisualization **p;
 
-  g_main_context_invoke_full (self->context, G_PRIORITY_DEFAULT,
-      gst_player_stop_internal, self, NULL);
+  g_return_if_fail (viss != NULL);
+
+  p = viss;
+  while (*p) {
+    g_free ((*p)->name);
+    g_free ((*p)->description);
+    g_free (*p);
+    p++;
+  }
+  g_free (viss);
 }
 
-/* Must be called with lock from main context, releases lock! */
 static void
-gst_player_seek_internal_locked (GstPlayer * self)
+gst_player_update_visualization_list (void)
 {
-  gboolean ret;
-  GstClockTime position;
-  gdouble rate;
-  GstStateChangeReturn state_ret;
-  GstEvent *s_event;
-  GstSeekFlags flags = 0;
+  GList *features;
+  GList *l;
+  guint32 cookie;
+  GstPlayerVisualization *vis;
 
-  if (self->seek_source) {
-    g_source_destroy (self->seek_source);
-    g_source_unref (self->seek_source);
-    self->seek_source = NULL;
-  }
+  gst_player_plugin_loader_ensure_klass ("Visualization");
 
-  /* Only seek in PAUSED */
-  if (self->current_state < GST_STATE_PAUSED) {
-    return;
-  } else if (self->current_state != GST_STATE_PAUSED) {
-    g_mutex_unlock (&self->lock);
-    state_ret = gst_element_set_state (self->playbin, GST_STATE_PAUSED);
-    if (state_ret == GST_STATE_CHANGE_FAILURE) {
-      emit_error (self, g_error_new (GST_PLAYER_ERROR, GST_PLAYER_ERROR_FAILED,
-              "Failed to seek"));
-      g_mutex_lock (&self->lock);
-      return;
-    }
-    g_mutex_lock (&self->lock);
+  g_mutex_lock (&vis_lock);
+
+  /* check if we need to update the list */
+  cookie = gst_registry_get_feature_list_cookie (gst_registry_get ());
+  if (vis_cookie == cookie) {
+    g_mutex_unlock (&vis_lock);
     return;
   }
 
-  self->last_seek_time = gst_util_get_timestamp ();
-  position = self->seek_position;
-  self->seek_position = GST_CLOCK_TIME_NONE;
-  self->seek_pending = TRUE;
-  rate = self->rate;
-  g_mutex_unlock (&self->lock);
+  /* if update is needed then first free the existing list */
+  while ((vis = g_queue_pop_head (&vis_list)))
+    gst_player_visualization_free (vis);
 
-  remove_tick_source (self);
-  self->is_eos = FALSE;
+  features = gst_registry_get_feature_list (gst_registry_get (),
+      GST_TYPE_ELEMENT_FACTORY);
 
-  flags |= GST_SEEK_FLAG_FLUSH;
+  for (l = features; l; l = l->next) {
+    GstPluginFeature *feature = l->data;
+    const gchar *klass;
 
-#if GST_CHECK_VERSION(1,5,0)
-  if (rate != 1.0) {
-    flags |= GST_SEEK_FLAG_TRICKMODE;
-  }
-#endif
+    klass = gst_element_factory_get_metadata (GST_ELEMENT_FACTORY (feature),
+        GST_ELEMENT_METADATA_KLASS);
 
-  if (rate >= 0.0) {
-    s_event = gst_event_new_seek (rate, GST_FORMAT_TIME, flags,
-        GST_SEEK_TYPE_SET, position, GST_SEEK_TYPE_NONE, GST_CLOCK_TIME_NONE);
-  } else {
-    s_event = gst_event_new_seek (rate, GST_FORMAT_TIME, flags,
-        GST_SEEK_TYPE_SET, G_GINT64_CONSTANT (0), GST_SEEK_TYPE_SET, position);
+    if (strstr (klass, "Visualization")) {
+      vis = g_new0 (GstPlayerVisualization, 1);
+
+      vis->name = g_strdup (gst_plugin_feature_get_name (feature));
+      vis->description =
+          g_strdup (gst_element_factory_get_metadata (GST_ELEMENT_FACTORY
+              (feature), GST_ELEMENT_METADATA_DESCRIPTION));
+      g_queue_push_tail (&vis_list, vis);
+    }
   }
+  gst_plugin_feature_list_free (features);
 
-  GST_DEBUG_OBJECT (self, "Seek with rate %.2lf to %" GST_TIME_FORMAT,
-      rate, GST_TIME_ARGS (position));
+  vis_cookie = cookie;
 
-  ret = gst_element_send_event (self->playbin, s_event);
-  if (!ret)
-    emit_error (self, g_error_new (GST_PLAYER_ERROR, GST_PLAYER_ERROR_FAILED,
-            "Failed to seek to %" GST_TIME_FORMAT, GST_TIME_ARGS (position)));
+  g_mutex_unlock (&vis_lock);
+}
 
-  g_mutex_lock (&self->lock);
+/**
+ * gst_player_visualizations_get:
+ *
+ * Returns: (transfer full) (array zero-terminated=1) (element-type GstPlayerVisualization):
+ *  a %NULL terminated array containing all available
+ *  visualizations. Use gst_player_visualizations_free() after
+ *  usage.
+ */
+GstPlayerVisualization **
+gst_player_visualizations_get (void)
+{
+  gint i = 0;
+  GList *l;
+  GstPlayerVisualization **ret;
+
+  gst_player_update_visualization_list ();
+
+  g_mutex_lock (&vis_lock);
+  ret = g_new0 (GstPlayerVisualization *, g_queue_get_length (&vis_list) + 1);
+  for (l = vis_list.head; l; l = l->next)
+    ret[i++] = gst_player_visualization_copy (l->data);
+  g_mutex_unlock (&vis_lock);
+
+  return ret;
 }
 
-static gboolean
-gst_player_seek_internal (gpointer user_data)
+/**
+ * gst_player_set_visualization:
+ * @player: #GstPlayer instance
+ * @name: visualization element obtained from
+ * #gst_player_visualizations_get()
+ *
+ * Returns: %TRUE if the visualizations was set correctly. Otherwise,
+ * %FALSE.
+ */
+gboolean
+gst_player_set_visualization (GstPlayer * self, const gchar * name)
 {
-  GstPlayer *self = GST_PLAYER (user_data);
+  g_return_val_if_fail (GST_IS_PLAYER (self), FALSE);
 
   g_mutex_lock (&self->lock);
-  gst_player_seek_internal_locked (self);
+  if (self->current_vis_element) {
+    gst_object_unref (self->current_vis_element);
+    self->current_vis_element = NULL;
+  }
+
+  if (name) {
+    gst_player_plugin_loader_ensure_feature (name);
+    self->current_vis_element = gst_element_factory_make (name, NULL);
+    if (!self->current_vis_element)
+      goto error_no_element;
+    gst_object_ref_sink (self->current_vis_element);
+  }
+  g_object_set (self->playbin, "vis-plugin", self->current_vis_element, NULL);
+
   g_mutex_unlock (&self->lock);
+  GST_DEBUG_OBJECT (self, "set vis-plugin to '%s'", name);
 
-  return G_SOURCE_REMOVE;
+  return TRUE;
+
+error_no_element:
+  g_mutex_unlock (&self->lock);
+  GST_WARNING_OBJECT (self, "could not find visualization '%s'", name);
+  return FALSE;
 }
 
-static gboolean
-gst_player_set_rate_internal (gpointer user_data)
+/**
+ * gst_player_get_current_visualization:
+ * @player: #GstPlayer instance
+ *
+ * Returns: (transfer full): Name of the currently enabled visualization.
+ *   g_free() after usage.
+ */
+gchar *
+gst_player_get_current_visualization (GstPlayer * self)
 {
-  GstPlayer *self = user_data;
+  gchar *name = NULL;
+  GstElement *vis_plugin = NULL;
 
-  g_mutex_lock (&self->lock);
+  g_return_val_if_fail (GST_IS_PLAYER (self), NULL);
 
-  self->seek_position = gst_player_get_position (self);
+  if (!is_track_enabled (self, GST_PLAY_FLAG_VIS))
+    return NULL;
 
-  /* If there is no seek being dispatch to the main context currently do that,
-   * otherwise we just updated the rate so that it will be taken by
-   * the seek handler from the main context instead of the old one.
-   */
-  if (!self->seek_source) {
-    /* If no seek is pending then create new seek source */
-    if (!self->seek_pending) {
-      self->seek_source = g_idle_source_new ();
-      g_source_set_callback (self->seek_source,
-          (GSourceFunc) gst_player_seek_internal, self, NULL);
-      g_source_attach (self->seek_source, self->context);
-    }
+  g_object_get (self->playbin, "vis-plugin", &vis_plugin, NULL);
+
+  if (vis_plugin) {
+    GstElementFactory *factory = gst_element_get_factory (vis_plugin);
+    if (factory)
+      name = g_strdup (gst_plugin_feature_get_name (factory));
+    gst_object_unref (vis_plugin);
   }
 
-  g_mutex_unlock (&self->lock);
+  GST_DEBUG_OBJECT (self, "vis-plugin '%s' %p", name, vis_plugin);
 
-  return G_SOURCE_REMOVE;
+  return name;
 }
 
 /**
- * gst_player_set_rate:
+ * gst_player_set_visualization_enabled:
  * @player: #GstPlayer instance
- * @rate: playback rate
+ * @enabled: TRUE or FALSE
  *
- * Playback at specified rate
+ * Enable or disable the visualization.
  */
 void
-gst_player_set_rate (GstPlayer * self, gdouble rate)
+gst_player_set_visualization_enabled (GstPlayer * self, gboolean enabled)
 {
   g_return_if_fail (GST_IS_PLAYER (self));
-  g_return_if_fail (rate != 0.0);
 
-  g_mutex_lock (&self->lock);
-  self->rate = rate;
-  g_mutex_unlock (&self->lock);
+  if (enabled)
+    player_set_flag (self, GST_PLAY_FLAG_VIS);
+  else
+    player_clear_flag (self, GST_PLAY_FLAG_VIS);
 
-  gst_player_set_rate_internal (self);
+  GST_DEBUG_OBJECT (self, "visualization is '%s'",
+      enabled ? "Enabled" : "Disabled");
 }
 
-/**
- * gst_player_get_rate:
- * @player: #GstPlayer instance
- *
- * Returns: current playback rate
- */
-gdouble
-gst_player_get_rate (GstPlayer * self)
+struct CBChannelMap
 {
-  g_return_val_if_fail (GST_IS_PLAYER (self), DEFAULT_RATE);
+  const gchar *label;           /* channel label name */
+  const gchar *name;            /* get_name () */
+};
 
-  return self->rate;
-}
+static const struct CBChannelMap cb_channel_map[] = {
+  /* GST_PLAYER_COLOR_BALANCE_BRIGHTNESS */ {"BRIGHTNESS", "brightness"},
+  /* GST_PLAYER_COLOR_BALANCE_CONTRAST   */ {"CONTRAST", "contrast"},
+  /* GST_PLAYER_COLOR_BALANCE_SATURATION */ {"SATURATION", "saturation"},
+  /* GST_PLAYER_COLOR_BALANCE_HUE        */ {"HUE", "hue"},
+};
 
-static gboolean
-gst_player_set_position_update_interval_internal (gpointer user_data)
+static GstColorBalanceChannel *
+gst_player_color_balance_find_channel (GstPlayer * self,
+    GstPlayerColorBalanceType type)
 {
-  GstPlayer *self = user_data;
+  GstColorBalanceChannel *channel;
+  const GList *l, *channels;
 
-  g_mutex_lock (&self->lock);
+  if (type < GST_PLAYER_COLOR_BALANCE_BRIGHTNESS ||
+      type > GST_PLAYER_COLOR_BALANCE_HUE)
+    return NULL;
 
-  if (self->tick_source) {
-    remove_tick_source (self);
-    add_tick_source (self);
+  channels =
+      gst_color_balance_list_channels (GST_COLOR_BALANCE (self->playbin));
+  for (l = channels; l; l = l->next) {
+    channel = l->data;
+    if (g_strrstr (channel->label, cb_channel_map[type].label))
+      return channel;
   }
 
-  g_mutex_unlock (&self->lock);
-
-  return G_SOURCE_REMOVE;
+  return NULL;
 }
 
 /**
- * gst_player_set_position_update_interval:
- * @player: #GstPlayer instance
- * @interval: interval in ms
+ * gst_player_has_color_balance:
+ * @player:#GstPlayer instance
  *
- * Set interval in milliseconds between two position-updated signals.
- * Pass 0 to stop updating the position.
+ * Checks whether the @player has color balance support available.
+ *
+ * Returns: %TRUE if @player has color balance support. Otherwise,
+ *   %FALSE.
  */
-void
-gst_player_set_position_update_interval (GstPlayer * self, guint interval)
+gboolean
+gst_player_has_color_balance (GstPlayer * self)
 {
-  g_return_if_fail (GST_IS_PLAYER (self));
-  g_return_if_fail (interval <= 10000);
+  const GList *channels;
 
-  g_mutex_lock (&self->lock);
-  self->position_update_interval_ms = interval;
-  g_mutex_unlock (&self->lock);
+  g_return_val_if_fail (GST_IS_PLAYER (self), FALSE);
 
-  gst_player_set_position_update_interval_internal (self);
+  if (!GST_IS_COLOR_BALANCE (self->playbin))
+    return FALSE;
+
+  channels =
+      gst_color_balance_list_channels (GST_COLOR_BALANCE (self->playbin));
+  return (channels != NULL);
 }
 
 /**
- * gst_player_get_position_update_interval:
+ * gst_player_set_color_balance:
  * @player: #GstPlayer instance
+ * @type: #GstPlayerColorBalanceType
+ * @value: The new value for the @type, ranged [0,1]
  *
- * Returns: current position update interval in milliseconds
+ * Sets the current value of the indicated channel @type to the passed
+ * value.
  */
-guint
-gst_player_get_position_update_interval (GstPlayer * self)
+void
+gst_player_set_color_balance (GstPlayer * self, GstPlayerColorBalanceType type,
+    gdouble value)
 {
-  g_return_val_if_fail (GST_IS_PLAYER (self),
-      DEFAULT_POSITION_UPDATE_INTERVAL_MS);
+  GstColorBalanceChannel *channel;
+  gdouble new_val;
 
-  return self->position_update_interval_ms;
+  g_return_if_fail (GST_IS_PLAYER (self));
+  g_return_if_fail (value >= 0.0 && value <= 1.0);
+
+  if (!GST_IS_COLOR_BALANCE (self->playbin))
+    return;
+
+  channel = gst_player_color_balance_find_channel (self, type);
+  if (!channel)
+    return;
+
+  value = CLAMP (value, 0.0, 1.0);
+
+  /* Convert to channel range */
+  new_val = channel->min_value + value * ((gdouble) channel->max_value -
+      (gdouble) channel->min_value);
+
+  gst_color_balance_set_value (GST_COLOR_BALANCE (self->playbin), channel,
+      new_val);
 }
 
 /**
- * gst_player_seek:
+ * gst_player_get_color_balance:
  * @player: #GstPlayer instance
- * @position: position to seek in nanoseconds
+ * @type: #GstPlayerColorBalanceType
  *
- * Seeks the currently-playing stream to the absolute @position time
- * in nanoseconds.
+ * Retrieve the current value of the indicated @type.
+ *
+ * Returns: The current value of @type, between [0,1]. In case of
+ *   error -1 is returned.
  */
-void
-gst_player_seek (GstPlayer * self, GstClockTime position)
+gdouble
+gst_player_get_color_balance (GstPlayer * self, GstPlayerColorBalanceType type)
 {
-  g_return_if_fail (GST_IS_PLAYER (self));
-  g_return_if_fail (GST_CLOCK_TIME_IS_VALID (position));
+  GstColorBalanceChannel *channel;
+  gint value;
 
-  g_mutex_lock (&self->lock);
-  if (self->media_info && !self->media_info->seekable) {
-    GST_DEBUG_OBJECT (self, "Media is not seekable");
-    g_mutex_unlock (&self->lock);
-    return;
-  }
+  g_return_val_if_fail (GST_IS_PLAYER (self), -1);
 
-  self->seek_position = position;
+  if (!GST_IS_COLOR_BALANCE (self->playbin))
+    return -1;
 
-  /* If there is no seek being dispatch to the main context currently do that,
-   * otherwise we just updated the seek position so that it will be taken by
-   * the seek handler from the main context instead of the old one.
-   */
-  if (!self->seek_source) {
-    GstClockTime now = gst_util_get_timestamp ();
+  channel = gst_player_color_balance_find_channel (self, type);
+  if (!channel)
+    return -1;
 
-    /* If no seek is pending or it was started more than 250 mseconds ago seek
-     * immediately, otherwise wait until the 250 mseconds have passed */
-    if (!self->seek_pending || (now - self->last_seek_time > 250 * GST_MSECOND)) {
-      self->seek_source = g_idle_source_new ();
-      g_source_set_callback (self->seek_source,
-          (GSourceFunc) gst_player_seek_internal, self, NULL);
-      GST_TRACE_OBJECT (self, "Dispatching seek to position %" GST_TIME_FORMAT,
-          GST_TIME_ARGS (position));
-      g_source_attach (self->seek_source, self->context);
-    } else {
-      guint delay = 250000 - (now - self->last_seek_time) / 1000;
+  value = gst_color_balance_get_value (GST_COLOR_BALANCE (self->playbin),
+      channel);
 
-      /* Note that last_seek_time must be set to something at this point and
-       * it must be smaller than 250 mseconds */
-      self->seek_source = g_timeout_source_new (delay);
-      g_source_set_callback (self->seek_source,
-          (GSourceFunc) gst_player_seek_internal, self, NULL);
+  return ((gdouble) value -
+      (gdouble) channel->min_value) / ((gdouble) channel->max_value -
+      (gdouble) channel->min_value);
+}
+
+/**
+ * gst_player_set_degradation_enabled:
+ * @player: #GstPlayer instance
+ * @enabled: TRUE to enable
+ *
+ * Enables or disables reducing video decoding quality when the video sink
+ * reports that decoding can't keep up. Quality is reduced step by step,
+ * see #GstPlayerDegradationLevel, and restored once decoding keeps up
+ * again for a while. Disabled by default.
+ */
+void
+gst_player_set_degradation_enabled (GstPlayer * self, gboolean enabled)
+{
+  g_return_if_fail (GST_IS_PLAYER (self));
 
-      GST_TRACE_OBJECT (self,
-          "Delaying seek to position %" GST_TIME_FORMAT " by %u us",
-          GST_TIME_ARGS (position), delay);
-      g_source_attach (self->seek_source, self->context);
-    }
-  }
-  g_mutex_unlock (&self->lock);
+  g_object_set (self, "degradation-enabled", enabled, NULL);
 }
 
 /**
- * gst_player_get_uri:
+ * gst_player_get_degradation_enabled:
  * @player: #GstPlayer instance
  *
- * Gets the URI of the currently-playing stream.
+ * Returns: %TRUE if video quality is reduced under overload
+ */
+gboolean
+gst_player_get_degradation_enabled (GstPlayer * self)
+{
+  gboolean enabled;
+
+  g_return_val_if_fail (GST_IS_PLAYER (self), DEFAULT_DEGRADATION_ENABLED);
+
+  g_object_get (self, "degradation-enabled", &enabled, NULL);
+
+  return enabled;
+}
+
+/**
+ * gst_player_get_degradation_level:
+ * @player: #GstPlayer instance
  *
- * Returns: (transfer full): a string containing the URI of the
- * currently-playing stream. g_free() after usage.
+ * Returns: the current #GstPlayerDegradationLevel
  */
-gchar *
-gst_player_get_uri (GstPlayer * self)
+GstPlayerDegradationLevel
+gst_player_get_degradation_level (GstPlayer * self)
 {
-  gchar *val;
+  GstPlayerDegradationLevel level;
 
-  g_return_val_if_fail (GST_IS_PLAYER (self), DEFAULT_URI);
+  g_return_val_if_fail (GST_IS_PLAYER (self), GST_PLAYER_DEGRADATION_NONE);
 
-  g_object_get (self, "uri", &val, NULL);
+  g_mutex_lock (&self->lock);
+  level = self->degradation_level;
+  g_mutex_unlock (&self->lock);
 
-  return val;
+  return level;
 }
 
 /**
- * gst_player_set_uri:
+ * gst_player_set_skip_static_frames:
  * @player: #GstPlayer instance
- * @uri: next URI to play.
+ * @enabled: TRUE to enable
  *
- * Sets the next URI to play.
+ * Enables skipping of video frames that are identical to the previous
+ * one, e.g. for screencasts. Skipped frames are neither converted nor
+ * rendered, the previous frame simply stays on screen. Frames that did
+ * change carry #GstVideoRegionOfInterestMeta of type "dirty" for each
+ * changed rectangle, unless the whole frame changed.
  */
 void
-gst_player_set_uri (GstPlayer * self, const gchar * val)
+gst_player_set_skip_static_frames (GstPlayer * self, gboolean enabled)
 {
   g_return_if_fail (GST_IS_PLAYER (self));
 
-  g_object_set (self, "uri", val, NULL);
+  g_object_set (self, "skip-static-frames", enabled, NULL);
 }
 
 /**
- * gst_player_get_position:
+ * gst_player_get_skip_static_frames:
  * @player: #GstPlayer instance
  *
- * Returns: the absolute position time, in nanoseconds, of the
- * currently-playing stream.
+ * Returns: %TRUE if identical video frames are skipped
  */
-GstClockTime
-gst_player_get_position (GstPlayer * self)
+gboolean
+gst_player_get_skip_static_frames (GstPlayer * self)
 {
-  GstClockTime val;
+  gboolean enabled;
 
-  g_return_val_if_fail (GST_IS_PLAYER (self), DEFAULT_POSITION);
+  g_return_val_if_fail (GST_IS_PLAYER (self), DEFAULT_SKIP_STATIC_FRAMES);
 
-  g_object_get (self, "position", &val, NULL);
+  g_object_get (self, "skip-static-frames", &enabled, NULL);
 
-  return val;
+  return enabled;
 }
 
 /**
- * gst_player_get_duration:
+ * gst_player_set_offline:
  * @player: #GstPlayer instance
+ * @offline: TRUE to process as fast as possible
  *
- * Retrieves the duration of the media stream that self represents.
+ * Enables offline processing, e.g. for analysing recorded streams. The
+ * sinks no longer synchronise to the clock, so the stream is decoded as
+ * fast as possible, and audio goes to a fakesink. Together with a
+ * #GstPlayerVideoRenderer that creates an appsink every frame can be
+ * handed to analysis code. gst_player_set_decoder_threads() controls how
+ * many threads the decoders use.
  *
- * Returns: the duration of the currently-playing media stream, in
- * nanoseconds.
+ * The #GstPlayer:throughput property, notified before every
+ * #GstPlayer::position-updated signal, tells how many times faster than
+ * real time the stream is processed.
+ *
+ * Set this before playback starts. While a stream plays, only the clock
+ * synchronisation of the sinks is switched off right away. The audio sink
+ * is only replaced by a fakesink when the next stream starts, until then
+ * the audio device keeps processing at real time.
  */
-GstClockTime
-gst_player_get_duration (GstPlayer * self)
+void
+gst_player_set_offline (GstPlayer * self, gboolean offline)
 {
-  GstClockTime val;
+  g_return_if_fail (GST_IS_PLAYER (self));
 
-  g_return_val_if_fail (GST_IS_PLAYER (self), DEFAULT_DURATION);
+  g_object_set (self, "offline", offline, NULL);
+}
 
-  g_object_get (self, "duration", &val, NULL);
+/**
+ * gst_player_get_offline:
+ * @player: #GstPlayer instance
+ *
+ * Returns: %TRUE if the stream is processed as fast as possible
+ */
+gboolean
+gst_player_get_offline (GstPlayer * self)
+{
+  gboolean offline;
 
-  return val;
+  g_return_val_if_fail (GST_IS_PLAYER (self), DEFAULT_OFFLINE);
+
+  g_object_get (self, "offline", &offline, NULL);
+
+  return offline;
 }
 
 /**
- * gst_player_get_volume:
+ * gst_player_get_throughput:
  * @player: #GstPlayer instance
  *
- * Returns the current volume level, as a percentage between 0 and 1.
- *
- * Returns: the volume as percentage between 0 and 1.
+ * Returns: the processing speed in offline mode as a multiple of real
+ *   time, 0.0 if not known yet
  */
 gdouble
-gst_player_get_volume (GstPlayer * self)
+gst_player_get_throughput (GstPlayer * self)
 {
-  gdouble val;
+  gdouble throughput;
 
-  g_return_val_if_fail (GST_IS_PLAYER (self), DEFAULT_VOLUME);
+  g_return_val_if_fail (GST_IS_PLAYER (self), 0.0);
 
-  g_object_get (self, "volume", &val, NULL);
+  g_object_get (self, "throughput", &throughput, NULL);
 
-  return val;
+  return throughput;
 }
 
 /**
- * gst_player_set_volume:
+ * gst_player_set_decode_selected_only:
  * @player: #GstPlayer instance
- * @val: the new volume level, as a percentage between 0 and 1
+ * @enabled: TRUE to only decode the selected tracks
  *
- * Sets the volume level of the stream as a percentage between 0 and 1.
+ * Normally every audio and video track of the media is decoded and the
+ * selected one is picked afterwards, so e.g. a film with several
+ * languages decodes all of them. With this enabled the decoders of the
+ * other tracks get no data. A newly selected track is decoded again from
+ * its next packet, or for video from the next keyframe, without a flush.
+ *
+ * The "track-switch-latency" field of gst_player_get_stats() tells how
+ * long that took for the last track switch.
  */
 void
-gst_player_set_volume (GstPlayer * self, gdouble val)
+gst_player_set_decode_selected_only (GstPlayer * self, gboolean enabled)
 {
   g_return_if_fail (GST_IS_PLAYER (self));
 
-  g_object_set (self, "volume", val, NULL);
+  g_object_set (self, "decode-selected-only", enabled, NULL);
 }
 
 /**
- * gst_player_get_mute:
+ * gst_player_get_decode_selected_only:
  * @player: #GstPlayer instance
  *
- * Returns: %TRUE if the currently-playing stream is muted.
+ * Returns: %TRUE if only the selected tracks are decoded
  */
 gboolean
-gst_player_get_mute (GstPlayer * self)
+gst_player_get_decode_selected_only (GstPlayer * self)
 {
-  gboolean val;
+  gboolean enabled;
 
-  g_return_val_if_fail (GST_IS_PLAYER (self), DEFAULT_MUTE);
+  g_return_val_if_fail (GST_IS_PLAYER (self), DEFAULT_DECODE_SELECTED_ONLY);
 
-  g_object_get (self, "mute", &val, NULL);
+  g_object_get (self, "decode-selected-only", &enabled, NULL);
 
-  return val;
+  return enabled;
+}
+
+static gboolean
+gst_player_watch_elements_internal (gpointer user_data)
+{
+  GstPlayer *self = GST_PLAYER (user_data);
+
+  gst_player_element_stats_watch (self->element_stats,
+      GST_BIN (self->playbin));
+
+  return G_SOURCE_REMOVE;
 }
 
 /**
- * gst_player_set_mute:
+ * gst_player_set_element_stats_enabled:
  * @player: #GstPlayer instance
- * @val: Mute state the should be set
+ * @enabled: TRUE to measure every element
  *
- * %TRUE if the currently-playing stream should be muted.
+ * Measures how much CPU time every element of the pipeline uses, how long
+ * buffers take to pass it and how much CPU time every streaming thread
+ * uses, to find out which element can't keep up when playback stutters.
+ * Results are retrieved with gst_player_get_element_stats(). The DOT
+ * files written on errors, warnings and state changes if
+ * GST_DEBUG_DUMP_DOT_DIR is set also show the CPU load and latency of
+ * every element.
+ *
+ * This costs a little time for every buffer of every element, so it is
+ * meant for debugging. Enabling it starts a new measurement.
  */
 void
-gst_player_set_mute (GstPlayer * self, gboolean val)
+gst_player_set_element_stats_enabled (GstPlayer * self, gboolean enabled)
 {
   g_return_if_fail (GST_IS_PLAYER (self));
 
-  g_object_set (self, "mute", val, NULL);
+  g_object_set (self, "element-stats-enabled", enabled, NULL);
 }
 
 /**
- * gst_player_get_pipeline:
+ * gst_player_get_element_stats_enabled:
  * @player: #GstPlayer instance
  *
- * Returns: (transfer full): The internal playbin instance
+ * Returns: %TRUE if elements are measured
  */
-GstElement *
-gst_player_get_pipeline (GstPlayer * self)
+gboolean
+gst_player_get_element_stats_enabled (GstPlayer * self)
 {
-  GstElement *val;
+  gboolean enabled;
 
-  g_return_val_if_fail (GST_IS_PLAYER (self), NULL);
+  g_return_val_if_fail (GST_IS_PLAYER (self), DEFAULT_ELEMENT_STATS_ENABLED);
 
-  g_object_get (self, "pipeline", &val, NULL);
+  g_object_get (self, "element-stats-enabled", &enabled, NULL);
 
-  return val;
+  return enabled;
 }
 
 /**
- * gst_player_get_media_info:
+ * gst_player_get_element_stats:
  * @player: #GstPlayer instance
  *
- * A Function to get the current media info #GstPlayerMediaInfo instance.
+ * Returns the measurements since gst_player_set_element_stats_enabled() in
+ * a structure with these fields:
  *
- * Returns: (transfer full): media info instance.
+ * "time" (guint64): time since the measurement started.
  *
- * The caller should free it with g_object_unref()
+ * "elements" (#GstValueArray of #GstStructure): one structure for every
+ * element, the one using the most CPU time first, with "name" and
+ * "factory" (gchararray), "cpu-time" (guint64) and "cpu-load" (gdouble,
+ * percent of one core), "buffers" (guint64) pushed, "latency" and
+ * "max-latency" (guint64) from a buffer arriving until it or its result
+ * leaves the element, and "removed" (gboolean) for elements of earlier
+ * streams. An element is charged the CPU time from a buffer arriving until
+ * it pushes a buffer in the same thread. What it does after pushing and
+ * the work of sources and sinks is only part of the thread's CPU time.
+ *
+ * "threads" (#GstValueArray of #GstStructure): one structure for every
+ * streaming thread with "name" (gchararray), the pad it first pushed
+ * buffers on, "cpu-time" (guint64) and "cpu-load" (gdouble).
+ *
+ * Returns: (transfer full): a #GstStructure, free with gst_structure_free()
  */
-GstPlayerMediaInfo *
-gst_player_get_media_info (GstPlayer * self)
+GstStructure *
+gst_player_get_element_stats (GstPlayer * self)
 {
-  GstPlayerMediaInfo *info;
-
   g_return_val_if_fail (GST_IS_PLAYER (self), NULL);
 
-  if (!self->media_info)
-    return NULL;
-
-  g_mutex_lock (&self->lock);
-  info = gst_player_media_info_copy (self->media_info);
-  g_mutex_unlock (&self->lock);
+  gst_player_element_stats_watch (self->element_stats,
+      GST_BIN (self->playbin));
 
-  return info;
+  return gst_player_element_stats_get (self->element_stats);
 }
 
 /**
- * gst_player_get_current_audio_track:
+ * gst_player_dump_flight_recorder:
  * @player: #GstPlayer instance
  *
- * A Function to get current audio #GstPlayerAudioInfo instance.
- *
- * Returns: (transfer full): current audio track.
+ * The player always records its last few thousand events, like state
+ * changes, buffering, position updates, seeks, warnings and errors, in a
+ * ring buffer that costs next to nothing. This returns them decoded, e.g.
+ * to attach them to an error report from a #GstPlayer::error handler.
+ * They are also written to the debug log when an error occurs, see
+ * gst_player_get_error_events() for the ones leading up to the last error.
  *
- * The caller should free it with g_object_unref()
+ * Returns: (transfer full): the events, one per line and oldest first,
+ * g_free() after usage
  */
-GstPlayerAudioInfo *
-gst_player_get_current_audio_track (GstPlayer * self)
+gchar *
+gst_player_dump_flight_recorder (GstPlayer * self)
 {
-  GstPlayerAudioInfo *info;
-
   g_return_val_if_fail (GST_IS_PLAYER (self), NULL);
 
-  if (!is_track_enabled (self, GST_PLAY_FLAG_AUDIO))
-    return NULL;
-
-  info = (GstPlayerAudioInfo *) gst_player_stream_info_get_current (self,
-      "current-audio", GST_TYPE_PLAYER_AUDIO_INFO);
-  return info;
+  return gst_player_flight_recorder_dump (self->flight_recorder);
 }
 
 /**
- * gst_player_get_current_video_track:
+ * gst_player_get_error_events:
  * @player: #GstPlayer instance
  *
- * A Function to get current video #GstPlayerVideoInfo instance.
- *
- * Returns: (transfer full): current video track.
+ * Returns the flight recorder events decoded when the last error occurred,
+ * before the #GstPlayer::error signal and error callback were dispatched.
+ * Call this from those to attach the events to an error report; unlike
+ * gst_player_dump_flight_recorder() it does not include anything recorded
+ * after the error.
  *
- * The caller should free it with g_object_unref()
+ * Returns: (transfer full) (nullable): the events, one per line and oldest
+ * first, or %NULL if no error occurred yet. g_free() after usage
  */
-GstPlayerVideoInfo *
-gst_player_get_current_video_track (GstPlayer * self)
+gchar *
+gst_player_get_error_events (GstPlayer * self)
 {
-  GstPlayerVideoInfo *info;
+  gchar *events;
 
   g_return_val_if_fail (GST_IS_PLAYER (self), NULL);
 
-  if (!is_track_enabled (self, GST_PLAY_FLAG_VIDEO))
-    return NULL;
+  g_mutex_lock (&self->lock);
+  events = g_strdup (self->error_events);
+  g_mutex_unlock (&self->lock);
 
-  info = (GstPlayerVideoInfo *) gst_player_stream_info_get_current (self,
-      "current-video", GST_TYPE_PLAYER_VIDEO_INFO);
-  return info;
+  return events;
 }
 
 /**
- * gst_player_get_current_subtitle_track:
+ * gst_player_set_format_hint:
  * @player: #GstPlayer instance
+ * @hint: (allow-none): caps of the expected container format, followed by
+ *   the caps of the expected streams, or %NULL
  *
- * A Function to get current subtitle #GstPlayerSubtitleInfo instance.
+ * Sets the format the next URI is expected to have. If set, typefinding is
+ * skipped and only elements handling the hinted formats are considered
+ * when autoplugging. If the stream turns out not to match, playback falls
+ * back to full autoplugging.
  *
- * Returns: (transfer none): current subtitle track.
+ * Without a hint, RTMP URIs are assumed to carry FLV with H.264 and AAC.
+ */
+void
+gst_player_set_format_hint (GstPlayer * self, const GstCaps * hint)
+{
+  g_return_if_fail (GST_IS_PLAYER (self));
+
+  g_object_set (self, "format-hint", hint, NULL);
+}
+
+/**
+ * gst_player_get_format_hint:
+ * @player: #GstPlayer instance
  *
- * The caller should free it with g_object_unref()
+ * Returns: (transfer full): the format hint set with
+ *   gst_player_set_format_hint(), or %NULL
  */
-GstPlayerSubtitleInfo *
-gst_player_get_current_subtitle_track (GstPlayer * self)
+GstCaps *
+gst_player_get_format_hint (GstPlayer * self)
 {
-  GstPlayerSubtitleInfo *info;
+  GstCaps *hint;
 
   g_return_val_if_fail (GST_IS_PLAYER (self), NULL);
 
-  if (!is_track_enabled (self, GST_PLAY_FLAG_SUBTITLE))
-    return NULL;
+  g_object_get (self, "format-hint", &hint, NULL);
 
-  info = (GstPlayerSubtitleInfo *) gst_player_stream_info_get_current (self,
-      "current-text", GST_TYPE_PLAYER_SUBTITLE_INFO);
-  return info;
+  return hint;
 }
 
 /**
- * gst_player_set_audio_track:
+ * gst_player_set_decoder_rank:
  * @player: #GstPlayer instance
- * @stream_index: stream index
- *
- * Returns: %TRUE or %FALSE
+ * @name: name of a decoder element factory
+ * @rank: rank to use for @name
  *
- * Sets the audio track @stream_idex.
+ * Overrides the rank of a decoder when this player autoplugs. Other
+ * pipelines are not affected. This takes precedence over decoders found
+ * to be fastest by gst_player_decoder_probe_run().
  */
-gboolean
-gst_player_set_audio_track (GstPlayer * self, gint stream_index)
+void
+gst_player_set_decoder_rank (GstPlayer * self, const gchar * name, guint rank)
 {
-  GstPlayerStreamInfo *info;
-
-  g_return_val_if_fail (GST_IS_PLAYER (self), 0);
+  g_return_if_fail (GST_IS_PLAYER (self));
+  g_return_if_fail (name != NULL);
 
   g_mutex_lock (&self->lock);
-  info = gst_player_stream_info_find (self, self->media_info,
-      GST_TYPE_PLAYER_AUDIO_INFO, stream_index);
+  g_hash_table_insert (self->decoder_ranks, g_strdup (name),
+      GUINT_TO_POINTER (rank));
   g_mutex_unlock (&self->lock);
-  if (!info) {
-    GST_ERROR_OBJECT (self, "invalid audio stream index %d", stream_index);
-    return FALSE;
-  }
-
-  g_object_set (G_OBJECT (self->playbin), "current-audio", stream_index, NULL);
-  GST_DEBUG_OBJECT (self, "set stream index '%d'", stream_index);
-  return TRUE;
 }
 
 /**
- * gst_player_set_video_track:
+ * gst_player_set_decoder_allowlist:
  * @player: #GstPlayer instance
- * @stream_index: stream index
- *
- * Returns: %TRUE or %FALSE
+ * @names: (allow-none) (array zero-terminated=1): decoder factory names
  *
- * Sets the video track @stream_index.
+ * Restricts autoplugging to the decoders in @names. Elements that are not
+ * decoders, like demuxers and parsers, are not affected. Pass %NULL to
+ * allow all decoders again.
  */
-gboolean
-gst_player_set_video_track (GstPlayer * self, gint stream_index)
+void
+gst_player_set_decoder_allowlist (GstPlayer * self, const gchar * const *names)
 {
-  GstPlayerStreamInfo *info;
-
-  g_return_val_if_fail (GST_IS_PLAYER (self), 0);
+  g_return_if_fail (GST_IS_PLAYER (self));
 
-  /* check if stream_index exist in our internal media_info list */
   g_mutex_lock (&self->lock);
-  info = gst_player_stream_info_find (self, self->media_info,
-      GST_TYPE_PLAYER_VIDEO_INFO, stream_index);
+  g_strfreev (self->decoder_allowlist);
+  self->decoder_allowlist = g_strdupv ((gchar **) names);
   g_mutex_unlock (&self->lock);
-  if (!info) {
-    GST_ERROR_OBJECT (self, "invalid video stream index %d", stream_index);
-    return FALSE;
-  }
-
-  g_object_set (G_OBJECT (self->playbin), "current-video", stream_index, NULL);
-  GST_DEBUG_OBJECT (self, "set stream index '%d'", stream_index);
-  return TRUE;
 }
 
 /**
- * gst_player_set_subtitle_track:
+ * gst_player_set_decoder_denylist:
  * @player: #GstPlayer instance
- * @stream_index: stream index
+ * @names: (allow-none) (array zero-terminated=1): decoder factory names
  *
- * Returns: %TRUE or %FALSE
- *
- * Sets the subtitle strack @stream_index.
+ * Never autoplug the decoders in @names. Pass %NULL to clear the list.
  */
-gboolean
-gst_player_set_subtitle_track (GstPlayer * self, gint stream_index)
+void
+gst_player_set_decoder_denylist (GstPlayer * self, const gchar * const *names)
 {
-  GstPlayerStreamInfo *info;
-
-  g_return_val_if_fail (GST_IS_PLAYER (self), 0);
+  g_return_if_fail (GST_IS_PLAYER (self));
 
   g_mutex_lock (&self->lock);
-  info = gst_player_stream_info_find (self, self->media_info,
-      GST_TYPE_PLAYER_SUBTITLE_INFO, stream_index);
+  g_strfreev (self->decoder_denylist);
+  self->decoder_denylist = g_strdupv ((gchar **) names);
   g_mutex_unlock (&self->lock);
-  if (!info) {
-    GST_ERROR_OBJECT (self, "invalid subtitle stream index %d", stream_index);
-    return FALSE;
-  }
-
-  g_object_set (G_OBJECT (self->playbin), "current-text", stream_index, NULL);
-  GST_DEBUG_OBJECT (self, "set stream index '%d'", stream_index);
-  return TRUE;
 }
 
 /**
- * gst_player_set_audio_track_enabled:
+ * gst_player_set_decoder_threads:
  * @player: #GstPlayer instance
- * @enabled: TRUE or FALSE
+ * @media_type: (allow-none): media type of the encoded stream, e.g.
+ *   "video/x-h264", or %NULL for all decoders
+ * @n_threads: number of threads, 0 lets the decoder decide
  *
- * Enable or disable the current audio track.
+ * Sets the number of threads decoders for @media_type should use. This
+ * works for decoders with a "max-threads" or "threads" property, like
+ * the libav and vpx decoders. A setting for a specific media type takes
+ * precedence over the one for all decoders.
  */
 void
-gst_player_set_audio_track_enabled (GstPlayer * self, gboolean enabled)
+gst_player_set_decoder_threads (GstPlayer * self, const gchar * media_type,
+    guint n_threads)
 {
   g_return_if_fail (GST_IS_PLAYER (self));
 
-  if (enabled)
-    player_set_flag (self, GST_PLAY_FLAG_AUDIO);
-  else
-    player_clear_flag (self, GST_PLAY_FLAG_AUDIO);
-
-  GST_DEBUG_OBJECT (self, "track is '%s'", enabled ? "Enabled" : "Disabled");
+  g_mutex_lock (&self->lock);
+  g_hash_table_insert (self->decoder_threads,
+      g_strdup (media_type ? media_type : ""), GUINT_TO_POINTER (n_threads));
+  g_mutex_unlock (&self->lock);
 }
 
 /**
- * gst_player_set_video_track_enabled:
+ * gst_player_clear_decoder_policy:
  * @player: #GstPlayer instance
- * @enabled: TRUE or FALSE
  *
- * Enable or disable the current video track.
+ * Removes all decoder ranks, allow and deny lists and thread settings.
  */
 void
-gst_player_set_video_track_enabled (GstPlayer * self, gboolean enabled)
+gst_player_clear_decoder_policy (GstPlayer * self)
 {
   g_return_if_fail (GST_IS_PLAYER (self));
 
-  if (enabled)
-    player_set_flag (self, GST_PLAY_FLAG_VIDEO);
-  else
-    player_clear_flag (self, GST_PLAY_FLAG_VIDEO);
-
-  GST_DEBUG_OBJECT (self, "track is '%s'", enabled ? "Enabled" : "Disabled");
+  g_mutex_lock (&self->lock);
+  g_hash_table_remove_all (self->decoder_ranks);
+  g_hash_table_remove_all (self->decoder_threads);
+  g_strfreev (self->decoder_allowlist);
+  self->decoder_allowlist = NULL;
+  g_strfreev (self->decoder_denylist);
+  self->decoder_denylist = NULL;
+  g_mutex_unlock (&self->lock);
 }
 
 /**
- * gst_player_set_subtitle_track_enabled:
+ * gst_player_set_playlist:
  * @player: #GstPlayer instance
- * @enabled: TRUE or FALSE
+ * @playlist: (allow-none): a #GstPlayerPlaylist
  *
- * Enable or disable the current subtitle track.
+ * Plays the items of @playlist one after another, starting with its
+ * current item or the first one. The next item is prepared while the
+ * current one is still playing so that there is no gap between them. The
+ * #GstPlayer::playlist-item-changed signal is emitted whenever another
+ * item becomes current.
  */
 void
-gst_player_set_subtitle_track_enabled (GstPlayer * self, gboolean enabled)
+gst_player_set_playlist (GstPlayer * self, GstPlayerPlaylist * playlist)
 {
   g_return_if_fail (GST_IS_PLAYER (self));
+  g_return_if_fail (playlist == NULL || GST_IS_PLAYER_PLAYLIST (playlist));
 
-  if (enabled)
-    player_set_flag (self, GST_PLAY_FLAG_SUBTITLE);
-  else
-    player_clear_flag (self, GST_PLAY_FLAG_SUBTITLE);
-
-  GST_DEBUG_OBJECT (self, "track is '%s'", enabled ? "Enabled" : "Disabled");
+  g_object_set (self, "playlist", playlist, NULL);
 }
 
 /**
- * gst_player_set_subtitle_uri:
+ * gst_player_get_playlist:
  * @player: #GstPlayer instance
- * @uri: subtitle URI
  *
- * Returns: %TRUE or %FALSE
- *
- * Sets the external subtitle URI.
+ * Returns: (transfer full): the current #GstPlayerPlaylist or %NULL.
+ *   g_object_unref() after usage.
  */
-gboolean
-gst_player_set_subtitle_uri (GstPlayer * self, const gchar * suburi)
+GstPlayerPlaylist *
+gst_player_get_playlist (GstPlayer * self)
 {
-  g_return_val_if_fail (GST_IS_PLAYER (self), FALSE);
+  GstPlayerPlaylist *playlist;
 
-  g_mutex_lock (&self->lock);
-  if (self->suburi)
-    g_free (self->suburi);
-  self->suburi = g_strdup (suburi);
-  g_mutex_unlock (&self->lock);
+  g_return_val_if_fail (GST_IS_PLAYER (self), NULL);
 
-  gst_player_set_suburi_internal (self);
+  g_object_get (self, "playlist", &playlist, NULL);
 
-  return TRUE;
+  return playlist;
 }
 
 /**
- * gst_player_get_subtitle_uri:
+ * gst_player_next:
  * @player: #GstPlayer instance
  *
- * current subtitle URI
- *
- * Returns: (transfer full): URI of the current external subtitle.
- *   g_free() after usage.
+ * Skips to the next item of the playlist.
  */
-gchar *
-gst_player_get_subtitle_uri (GstPlayer * self)
+void
+gst_player_next (GstPlayer * self)
 {
-  gchar *val = NULL;
+  g_return_if_fail (GST_IS_PLAYER (self));
 
-  g_return_val_if_fail (GST_IS_PLAYER (self), NULL);
+  g_main_context_invoke_full (self->context, G_PRIORITY_DEFAULT,
+      gst_player_next_internal, self, NULL);
+}
 
-  g_object_get (self, "suburi", &val, NULL);
+/**
+ * gst_player_previous:
+ * @player: #GstPlayer instance
+ *
+ * Skips to the previous item of the playlist.
+ */
+void
+gst_player_previous (GstPlayer * self)
+{
+  g_return_if_fail (GST_IS_PLAYER (self));
 
-  return val;
+  g_main_context_invoke_full (self->context, G_PRIORITY_DEFAULT,
+      gst_player_previous_internal, self, NULL);
 }
 
-G_DEFINE_BOXED_TYPE (GstPlayerVisualization, gst_player_visualization,
-    (GBoxedCopyFunc) gst_player_visualization_copy,
-    (GBoxedFreeFunc) gst_player_visualization_free);
-
 /**
- * gst_player_visualization_free:
- * @vis: #GstPlayerVisualization instance
+ * gst_player_set_restream:
+ * @player: #GstPlayer instance
+ * @port: TCP port of the RTSP server, 0 to disable restreaming
+ * @path: (allow-none): mount point of the media, %NULL for "/live"
  *
- * Frees #GstPlayerVisualization allocated using g_new() or
- * gst_player_visualization_copy().
+ * Serves the H.264 video and AAC audio of the playing media to RTSP
+ * clients on the local network, without decoding or encoding it again.
+ * All clients share the same stream, and the data queued for them is
+ * bounded: if the network can't keep up, data is dropped until the next
+ * video keyframe instead of delaying playback. Other codecs are not
+ * re-streamed.
  */
 void
-gst_player_visualization_free (GstPlayerVisualization * vis)
+gst_player_set_restream (GstPlayer * self, guint port, const gchar * path)
 {
-  g_return_if_fail (vis != NULL);
+  g_return_if_fail (GST_IS_PLAYER (self));
+  g_return_if_fail (port <= G_MAXUINT16);
 
-  g_free (vis->name);
-  g_free (vis->description);
-  g_free (vis);
+  g_object_set (self, "restream-path", path, "restream-port", port, NULL);
 }
 
 /**
- * gst_player_visualization_copy:
- * @vis: #GstPlayerVisualization instance
- *
- * Makes a copy of the #GstPlayerVisualization. The result must be
- * freed using gst_player_visualization_free().
+ * gst_player_set_loop_range:
+ * @player: #GstPlayer instance
+ * @start: start of the range
+ * @stop: end of the range, %GST_CLOCK_TIME_NONE to stop looping
  *
- * Returns: (transfer full): an allocated copy of @vis.
+ * Plays the range from @start to @stop over and over again. Only entering
+ * the range needs a seek that flushes the pipeline, every further
+ * iteration is queued seamlessly behind the previous one. Seeks inside the
+ * range keep looping, seeks outside of it jump to @start. The range is
+ * cleared when another URI is set.
  */
-GstPlayerVisualization *
-gst_player_visualization_copy (const GstPlayerVisualization * vis)
+void
+gst_player_set_loop_range (GstPlayer * self, GstClockTime start,
+    GstClockTime stop)
 {
-  GstPlayerVisualization *ret;
-
-  g_return_val_if_fail (vis != NULL, NULL);
+  g_return_if_fail (GST_IS_PLAYER (self));
+  g_return_if_fail (!GST_CLOCK_TIME_IS_VALID (stop)
+      || (GST_CLOCK_TIME_IS_VALID (start) && start < stop));
 
-  ret = g_new0 (GstPlayerVisualization, 1);
-  ret->name = vis->name ? g_strdup (vis->name) : NULL;
-  ret->description = vis->description ? g_strdup (vis->description) : NULL;
+  g_mutex_lock (&self->lock);
+  if (!GST_CLOCK_TIME_IS_VALID (stop)
+      && !GST_CLOCK_TIME_IS_VALID (self->loop_stop)) {
+    g_mutex_unlock (&self->lock);
+    return;
+  }
+  self->loop_start =
+      GST_CLOCK_TIME_IS_VALID (stop) ? start : GST_CLOCK_TIME_NONE;
+  self->loop_stop = stop;
+  self->n_loops = 0;
+  GST_DEBUG_OBJECT (self, "Set loop range %" GST_TIME_FORMAT " - %"
+      GST_TIME_FORMAT, GST_TIME_ARGS (self->loop_start),
+      GST_TIME_ARGS (self->loop_stop));
+  g_mutex_unlock (&self->lock);
 
-  return ret;
+  g_main_context_invoke_full (self->context, G_PRIORITY_DEFAULT,
+      gst_player_set_loop_range_internal, self, NULL);
 }
 
 /**
- * gst_player_visualizations_free:
- * @viss: a %NULL terminated array of #GstPlayerVisualization to free
+ * gst_player_get_loop_range:
+ * @player: #GstPlayer instance
+ * @start: (out) (allow-none): start of the range
+ * @stop: (out) (allow-none): end of the range
  *
- * Frees a %NULL terminated array of #GstPlayerVisualization.
+ * Returns: %TRUE if a loop range is set.
  */
-void
-gst_player_visualizations_free (GstPlayerVisualization ** viss)
+gboolean
+gst_player_get_loop_range (GstPlayer * self, GstClockTime * start,
+    GstClockTime * stop)
 {
-  GstPlayerVisualization **p;
+  gboolean ret;
 
-  g_return_if_fail (viss != NULL);
+  g_return_val_if_fail (GST_IS_PLAYER (self), FALSE);
 
-  p = viss;
-  while (*p) {
-    g_free ((*p)->name);
-    g_free ((*p)->description);
-    g_free (*p);
-    p++;
-  }
-  g_free (viss);
+  g_mutex_lock (&self->lock);
+  if (start)
+    *start = self->loop_start;
+  if (stop)
+    *stop = self->loop_stop;
+  ret = GST_CLOCK_TIME_IS_VALID (self->loop_stop);
+  g_mutex_unlock (&self->lock);
+
+  return ret;
 }
 
-static void
-gst_player_update_visualization_list (void)
+static guint64
+sample_get_size (GstSample * sample)
 {
-  GList *features;
-  GList *l;
-  guint32 cookie;
-  GstPlayerVisualization *vis;
+  GstBuffer *buffer = gst_sample_get_buffer (sample);
 
-  g_mutex_lock (&vis_lock);
+  return buffer ? gst_buffer_get_size (buffer) : 0;
+}
 
-  /* check if we need to update the list */
-  cookie = gst_registry_get_feature_list_cookie (gst_registry_get ());
-  if (vis_cookie == cookie) {
-    g_mutex_unlock (&vis_lock);
-    return;
-  }
+/* Size of the memory only referenced by @tags, images dominate it */
+static guint64
+tag_list_get_size (const GstTagList * tags)
+{
+  guint64 size = 0;
+  gint i, n_tags;
+  guint j, n_values;
 
-  /* if update is needed then first free the existing list */
-  while ((vis = g_queue_pop_head (&vis_list)))
-    gst_player_visualization_free (vis);
+  if (GST_MINI_OBJECT_REFCOUNT_VALUE (tags) > 1)
+    return 0;
 
-  features = gst_registry_get_feature_list (gst_registry_get (),
-      GST_TYPE_ELEMENT_FACTORY);
+  n_tags = gst_tag_list_n_tags (tags);
+  for (i = 0; i < n_tags; i++) {
+    const gchar *tag = gst_tag_list_nth_tag_name (tags, i);
 
-  for (l = features; l; l = l->next) {
-    GstPluginFeature *feature = l->data;
-    const gchar *klass;
+    n_values = gst_tag_list_get_tag_size (tags, tag);
+    for (j = 0; j < n_values; j++) {
+      const GValue *value = gst_tag_list_get_value_index (tags, tag, j);
 
-    klass = gst_element_factory_get_metadata (GST_ELEMENT_FACTORY (feature),
-        GST_ELEMENT_METADATA_KLASS);
+      if (GST_VALUE_HOLDS_SAMPLE (value))
+        size += sample_get_size (gst_value_get_sample (value));
+      else if (GST_VALUE_HOLDS_BUFFER (value))
+        size += gst_buffer_get_size (gst_value_get_buffer (value));
+      else if (G_VALUE_HOLDS_STRING (value) && g_value_get_string (value))
+        size += strlen (g_value_get_string (value));
+    }
+  }
 
-    if (strstr (klass, "Visualization")) {
-      vis = g_new0 (GstPlayerVisualization, 1);
+  return size;
+}
 
-      vis->name = g_strdup (gst_plugin_feature_get_name (feature));
-      vis->description =
-          g_strdup (gst_element_factory_get_metadata (GST_ELEMENT_FACTORY
-              (feature), GST_ELEMENT_METADATA_DESCRIPTION));
-      g_queue_push_tail (&vis_list, vis);
+/* Lowers the limits of the buffering queues to @max_bytes. Nothing is
+ * freed right away, the queues just don't refill above it once they
+ * drained */
+static void
+shrink_queues (GstPlayer * self, guint max_bytes)
+{
+  GstIterator *it;
+  GValue item = G_VALUE_INIT;
+  gboolean done = FALSE;
+
+  it = gst_bin_iterate_recurse (GST_BIN (self->playbin));
+  while (!done) {
+    switch (gst_iterator_next (it, &item)) {
+      case GST_ITERATOR_OK:{
+        GstElement *element = g_value_get_object (&item);
+        GstElementFactory *factory = gst_element_get_factory (element);
+        const gchar *name;
+        guint limit;
+
+        if (factory) {
+          name = gst_plugin_feature_get_name (factory);
+          if (strcmp (name, "queue2") == 0
+              || strcmp (name, "multiqueue") == 0) {
+            g_object_get (element, "max-size-bytes", &limit, NULL);
+            if (limit == 0 || limit > max_bytes) {
+              GST_DEBUG_OBJECT (self, "Limiting %s to %u bytes",
+                  GST_ELEMENT_NAME (element), max_bytes);
+              g_object_set (element, "max-size-bytes", max_bytes, NULL);
+            }
+          }
+        }
+        g_value_reset (&item);
+        break;
+      }
+      case GST_ITERATOR_RESYNC:
+        gst_iterator_resync (it);
+        break;
+      case GST_ITERATOR_ERROR:
+      case GST_ITERATOR_DONE:
+        done = TRUE;
+        break;
     }
   }
-  gst_plugin_feature_list_free (features);
-
-  vis_cookie = cookie;
+  g_value_unset (&item);
+  gst_iterator_free (it);
+}
+
+/* Bytes currently queued in the queue2 instances. multiqueue does not
+ * expose its level, so data queued in front of the decoders is missing */
+static guint64
+get_queued_bytes (GstPlayer * self)
+{
+  GstIterator *it;
+  GValue item = G_VALUE_INIT;
+  guint64 queued = 0;
+  gboolean done = FALSE;
+
+  it = gst_bin_iterate_recurse (GST_BIN (self->playbin));
+  while (!done) {
+    switch (gst_iterator_next (it, &item)) {
+      case GST_ITERATOR_OK:{
+        GstElement *element = g_value_get_object (&item);
+        GstElementFactory *factory = gst_element_get_factory (element);
+        guint level;
+
+        if (factory
+            && strcmp (gst_plugin_feature_get_name (factory), "queue2") == 0) {
+          g_object_get (element, "current-level-bytes", &level, NULL);
+          queued += level;
+        }
+        g_value_reset (&item);
+        break;
+      }
+      case GST_ITERATOR_RESYNC:
+        queued = 0;
+        gst_iterator_resync (it);
+        break;
+      case GST_ITERATOR_ERROR:
+      case GST_ITERATOR_DONE:
+        done = TRUE;
+        break;
+    }
+  }
+  g_value_unset (&item);
+  gst_iterator_free (it);
 
-  g_mutex_unlock (&vis_lock);
+  return queued;
 }
 
-/**
- * gst_player_visualizations_get:
- *
- * Returns: (transfer full) (array zero-terminated=1) (element-type GstPlayerVisualization):
- *  a %NULL terminated array containing all available
- *  visualizations. Use gst_player_visualizations_free() after
- *  usage.
- */
-GstPlayerVisualization **
-gst_player_visualizations_get (void)
+/* Drops the frame the sinks keep for snapshots, it comes back with the next
+ * rendered buffer */
+static guint64
+release_last_samples (GstPlayer * self)
 {
-  gint i = 0;
-  GList *l;
-  GstPlayerVisualization **ret;
+  GList *sinks, *l;
+  guint64 released = 0;
 
-  gst_player_update_visualization_list ();
+  sinks = get_sinks (self);
+  for (l = sinks; l; l = l->next) {
+    GstElement *element = l->data;
+    GstSample *sample = NULL;
 
-  g_mutex_lock (&vis_lock);
-  ret = g_new0 (GstPlayerVisualization *, g_queue_get_length (&vis_list) + 1);
-  for (l = vis_list.head; l; l = l->next)
-    ret[i++] = gst_player_visualization_copy (l->data);
-  g_mutex_unlock (&vis_lock);
+    if (!g_object_class_find_property (G_OBJECT_GET_CLASS (element),
+            "enable-last-sample"))
+      continue;
 
-  return ret;
+    g_object_get (element, "last-sample", &sample, NULL);
+    if (sample) {
+      released += sample_get_size (sample);
+      gst_sample_unref (sample);
+      g_object_set (element, "enable-last-sample", FALSE, NULL);
+      g_object_set (element, "enable-last-sample", TRUE, NULL);
+    }
+  }
+  g_list_free_full (sinks, gst_object_unref);
+
+  return released;
 }
 
-/**
- * gst_player_set_visualization:
- * @player: #GstPlayer instance
- * @name: visualization element obtained from
- * #gst_player_visualizations_get()
- *
- * Returns: %TRUE if the visualizations was set correctly. Otherwise,
- * %FALSE.
- */
-gboolean
-gst_player_set_visualization (GstPlayer * self, const gchar * name)
+/* Must be called with lock */
+static guint64
+drop_cached_tags_locked (GstPlayer * self)
 {
-  g_return_val_if_fail (GST_IS_PLAYER (self), FALSE);
+  guint64 released = 0;
+  GList *l;
 
-  g_mutex_lock (&self->lock);
-  if (self->current_vis_element) {
-    gst_object_unref (self->current_vis_element);
-    self->current_vis_element = NULL;
+  if (self->global_tags) {
+    released += tag_list_get_size (self->global_tags);
+    gst_tag_list_unref (self->global_tags);
+    self->global_tags = NULL;
   }
 
-  if (name) {
-    self->current_vis_element = gst_element_factory_make (name, NULL);
-    if (!self->current_vis_element)
-      goto error_no_element;
-    gst_object_ref_sink (self->current_vis_element);
+  if (!self->media_info)
+    return released;
+
+  /* Media info copies given to the application keep their own references */
+  if (self->media_info->image_sample) {
+    if (GST_MINI_OBJECT_REFCOUNT_VALUE (self->media_info->image_sample) == 1)
+      released += sample_get_size (self->media_info->image_sample);
+    gst_sample_unref (self->media_info->image_sample);
+    self->media_info->image_sample = NULL;
   }
-  g_object_set (self->playbin, "vis-plugin", self->current_vis_element, NULL);
-
-  g_mutex_unlock (&self->lock);
-  GST_DEBUG_OBJECT (self, "set vis-plugin to '%s'", name);
+  if (self->media_info->tags) {
+    released += tag_list_get_size (self->media_info->tags);
+    gst_tag_list_unref (self->media_info->tags);
+    self->media_info->tags = NULL;
+  }
+  for (l = self->media_info->stream_list; l; l = l->next) {
+    GstPlayerStreamInfo *info = l->data;
 
-  return TRUE;
+    if (info->tags) {
+      released += tag_list_get_size (info->tags);
+      gst_tag_list_unref (info->tags);
+      info->tags = NULL;
+    }
+  }
 
-error_no_element:
-  g_mutex_unlock (&self->lock);
-  GST_WARNING_OBJECT (self, "could not find visualization '%s'", name);
-  return FALSE;
+  return released;
 }
 
-/**
- * gst_player_get_current_visualization:
- * @player: #GstPlayer instance
- *
- * Returns: (transfer full): Name of the currently enabled visualization.
- *   g_free() after usage.
- */
-gchar *
-gst_player_get_current_visualization (GstPlayer * self)
+/* Shuts down the decoders and everything they allocated by going back to
+ * READY. Playback continues from the same position with the next play or
+ * pause. Returns the bytes that were queued */
+static guint64
+trim_pipeline (GstPlayer * self)
 {
-  gchar *name = NULL;
-  GstElement *vis_plugin = NULL;
+  GstClockTime position, duration;
+  guint64 released;
+  gboolean busy;
+
+  g_mutex_lock (&self->lock);
+  busy = self->seek_pending;
+  g_mutex_unlock (&self->lock);
+
+  if (busy || self->pipeline_trimmed || self->is_live
+      || self->target_state != GST_STATE_PAUSED
+      || self->current_state != GST_STATE_PAUSED)
+    return 0;
+
+  /* Queued data is freed when going to READY */
+  released = get_queued_bytes (self);
+  released += release_last_samples (self);
+
+  position = gst_player_get_position (self);
+  duration = gst_player_get_duration (self);
 
-  g_return_val_if_fail (GST_IS_PLAYER (self), NULL);
+  g_mutex_lock (&self->trim_lock);
+  self->trimmed_position = position;
+  self->trimmed_duration = duration;
+  g_mutex_unlock (&self->trim_lock);
+  g_atomic_int_set (&self->pipeline_trimmed, TRUE);
 
-  if (!is_track_enabled (self, GST_PLAY_FLAG_VIS))
-    return NULL;
+  GST_DEBUG_OBJECT (self, "Shutting down decoders at %" GST_TIME_FORMAT,
+      GST_TIME_ARGS (position));
 
-  g_object_get (self->playbin, "vis-plugin", &vis_plugin, NULL);
+  gst_bus_set_flushing (self->bus, TRUE);
+  gst_element_set_state (self->playbin, GST_STATE_READY);
+  gst_bus_set_flushing (self->bus, FALSE);
+  self->current_state = GST_STATE_READY;
 
-  if (vis_plugin) {
-    GstElementFactory *factory = gst_element_get_factory (vis_plugin);
-    if (factory)
-      name = g_strdup (gst_plugin_feature_get_name (factory));
-    gst_object_unref (vis_plugin);
+  g_mutex_lock (&self->lock);
+  if (self->video_decoder) {
+    gst_object_unref (self->video_decoder);
+    self->video_decoder = NULL;
   }
+  g_mutex_unlock (&self->lock);
 
-  GST_DEBUG_OBJECT (self, "vis-plugin '%s' %p", name, vis_plugin);
-
-  return name;
+  return released;
 }
 
-/**
- * gst_player_set_visualization_enabled:
- * @player: #GstPlayer instance
- * @enabled: TRUE or FALSE
- *
- * Enable or disable the visualization.
- */
-void
-gst_player_set_visualization_enabled (GstPlayer * self, gboolean enabled)
+static void
+restore_trimmed_pipeline (GstPlayer * self)
 {
-  g_return_if_fail (GST_IS_PLAYER (self));
+  if (!self->pipeline_trimmed)
+    return;
 
-  if (enabled)
-    player_set_flag (self, GST_PLAY_FLAG_VIS);
-  else
-    player_clear_flag (self, GST_PLAY_FLAG_VIS);
+  g_mutex_lock (&self->lock);
+  /* A seek done meanwhile wins */
+  if (!GST_CLOCK_TIME_IS_VALID (self->seek_position)) {
+    g_mutex_lock (&self->trim_lock);
+    self->seek_position = self->trimmed_position;
+    g_mutex_unlock (&self->trim_lock);
+  }
+  GST_DEBUG_OBJECT (self, "Restoring decoders at %" GST_TIME_FORMAT,
+      GST_TIME_ARGS (self->seek_position));
+  g_mutex_unlock (&self->lock);
 
-  GST_DEBUG_OBJECT (self, "visualization is '%s'",
-      enabled ? "Enabled" : "Disabled");
+  g_atomic_int_set (&self->pipeline_trimmed, FALSE);
 }
 
-struct CBChannelMap
+static gboolean
+gst_player_trim_memory_internal (gpointer user_data)
 {
-  const gchar *label;           /* channel label name */
-  const gchar *name;            /* get_name () */
-};
+  GstPlayer *self = GST_PLAYER (user_data);
+  GstPlayerMemoryTrimLevel level;
+  guint64 released = 0;
 
-static const struct CBChannelMap cb_channel_map[] = {
-  /* GST_PLAYER_COLOR_BALANCE_BRIGHTNESS */ {"BRIGHTNESS", "brightness"},
-  /* GST_PLAYER_COLOR_BALANCE_CONTRAST   */ {"CONTRAST", "contrast"},
-  /* GST_PLAYER_COLOR_BALANCE_SATURATION */ {"SATURATION", "saturation"},
-  /* GST_PLAYER_COLOR_BALANCE_HUE        */ {"HUE", "hue"},
-};
+  g_mutex_lock (&self->lock);
+  level = self->pending_trim_level;
+  self->pending_trim_level = -1;
+  g_mutex_unlock (&self->lock);
 
-static GstColorBalanceChannel *
-gst_player_color_balance_find_channel (GstPlayer * self,
-    GstPlayerColorBalanceType type)
-{
-  GstColorBalanceChannel *channel;
-  const GList *l, *channels;
+  if ((gint) level < 0)
+    return G_SOURCE_REMOVE;
 
-  if (type < GST_PLAYER_COLOR_BALANCE_BRIGHTNESS ||
-      type > GST_PLAYER_COLOR_BALANCE_HUE)
-    return NULL;
+  shrink_queues (self, level == GST_PLAYER_MEMORY_TRIM_LOW ?
+      TRIM_QUEUE_BYTES_LOW : TRIM_QUEUE_BYTES);
 
-  channels =
-      gst_color_balance_list_channels (GST_COLOR_BALANCE (self->playbin));
-  for (l = channels; l; l = l->next) {
-    channel = l->data;
-    if (g_strrstr (channel->label, cb_channel_map[type].label))
-      return channel;
+  if (level >= GST_PLAYER_MEMORY_TRIM_MODERATE) {
+    released += release_last_samples (self);
+    g_mutex_lock (&self->lock);
+    released += drop_cached_tags_locked (self);
+    g_mutex_unlock (&self->lock);
   }
 
-  return NULL;
+  if (level >= GST_PLAYER_MEMORY_TRIM_CRITICAL)
+    released += trim_pipeline (self);
+
+  GST_DEBUG_OBJECT (self, "Trimmed memory at level %d, released %"
+      G_GUINT64_FORMAT " bytes", level, released);
+
+  g_mutex_lock (&self->lock);
+  self->memory_released += released;
+  self->memory_released_last = released;
+  g_mutex_unlock (&self->lock);
+
+  return G_SOURCE_REMOVE;
 }
 
 /**
- * gst_player_has_color_balance:
- * @player:#GstPlayer instance
- *
- * Checks whether the @player has color balance support available.
+ * gst_player_trim_memory:
+ * @player: #GstPlayer instance
+ * @level: how much to give up
  *
- * Returns: %TRUE if @player has color balance support. Otherwise,
- *   %FALSE.
+ * Releases memory the player can do without, for example when the
+ * application is told that the system runs low on memory. Higher levels
+ * include everything the lower levels do. Data that was dropped is fetched
+ * again when it's needed, at the cost of more network traffic or a short
+ * stall. The amount of memory released is reported by
+ * gst_player_get_stats().
  */
-gboolean
-gst_player_has_color_balance (GstPlayer * self)
+void
+gst_player_trim_memory (GstPlayer * self, GstPlayerMemoryTrimLevel level)
 {
-  const GList *channels;
-
-  g_return_val_if_fail (GST_IS_PLAYER (self), FALSE);
+  g_return_if_fail (GST_IS_PLAYER (self));
+  g_return_if_fail (level <= GST_PLAYER_MEMORY_TRIM_CRITICAL);
 
-  if (!GST_IS_COLOR_BALANCE (self->playbin))
-    return FALSE;
+  g_mutex_lock (&self->lock);
+  self->pending_trim_level = MAX (self->pending_trim_level, (gint) level);
+  g_mutex_unlock (&self->lock);
 
-  channels =
-      gst_color_balance_list_channels (GST_COLOR_BALANCE (self->playbin));
-  return (channels != NULL);
+  g_main_context_invoke_full (self->context, G_PRIORITY_DEFAULT,
+      gst_player_trim_memory_internal, self, NULL);
 }
 
 /**
- * gst_player_set_color_balance:
+ * gst_player_set_callbacks:
  * @player: #GstPlayer instance
- * @type: #GstPlayerColorBalanceType
- * @value: The new value for the @type, ranged [0,1]
+ * @callbacks: (allow-none): the callbacks
+ * @user_data: (closure): user data passed to the callbacks
+ * @notify: (allow-none): called when @user_data is no longer needed
  *
- * Sets the current value of the indicated channel @type to the passed
- * value.
+ * Sets callbacks that are called for the same events as the corresponding
+ * signals, from the same #GstPlayerSignalDispatcher. Unlike signals they
+ * need no handler lookup and no marshalling of the arguments, which makes
+ * them cheaper for frequent events like position updates. Callbacks that
+ * are %NULL are not called, signals are emitted in any case. Handlers for
+ * the position-updated and audio-level signals are only looked up once per
+ * second, so handlers connected during playback might miss the events of
+ * up to one second.
+ *
+ * The new callbacks replace the ones that were set before. Events that are
+ * already dispatched still go to the old callbacks, @notify of those is
+ * called once they are done.
  */
 void
-gst_player_set_color_balance (GstPlayer * self, GstPlayerColorBalanceType type,
-    gdouble value)
+gst_player_set_callbacks (GstPlayer * self,
+    const GstPlayerCallbacks * callbacks, gpointer user_data,
+    GDestroyNotify notify)
 {
-  GstColorBalanceChannel *channel;
-  gdouble new_val;
+  PlayerCallbacks *new_callbacks = NULL, *old_callbacks;
+  gint mask = 0;
+  guint i;
 
   g_return_if_fail (GST_IS_PLAYER (self));
-  g_return_if_fail (value >= 0.0 && value <= 1.0);
 
-  if (!GST_IS_COLOR_BALANCE (self->playbin))
-    return;
-
-  channel = gst_player_color_balance_find_channel (self, type);
-  if (!channel)
-    return;
-
-  value = CLAMP (value, 0.0, 1.0);
+  if (callbacks) {
+    new_callbacks = g_new0 (PlayerCallbacks, 1);
+    new_callbacks->ref_count = 1;
+    new_callbacks->callbacks = *callbacks;
+    new_callbacks->user_data = user_data;
+    new_callbacks->notify = notify;
+
+    for (i = 0; i < G_STRUCT_OFFSET (GstPlayerCallbacks, _gst_reserved) /
+        sizeof (gpointer); i++)
+      if (G_STRUCT_MEMBER (gpointer, callbacks, i * sizeof (gpointer)))
+        mask |= 1 << i;
+  } else if (notify) {
+    notify (user_data);
+  }
 
-  /* Convert to channel range */
-  new_val = channel->min_value + value * ((gdouble) channel->max_value -
-      (gdouble) channel->min_value);
+  g_mutex_lock (&self->lock);
+  old_callbacks = self->callbacks;
+  self->callbacks = new_callbacks;
+  g_atomic_int_set (&self->callbacks_mask, mask);
+  g_mutex_unlock (&self->lock);
 
-  gst_color_balance_set_value (GST_COLOR_BALANCE (self->playbin), channel,
-      new_val);
+  if (old_callbacks)
+    player_callbacks_unref (old_callbacks);
 }
 
 /**
- * gst_player_get_color_balance:
+ * gst_player_get_stats:
  * @player: #GstPlayer instance
- * @type: #GstPlayerColorBalanceType
  *
- * Retrieve the current value of the indicated @type.
+ * Retrieve statistics about the current playback. The structure contains
+ * the following fields:
  *
- * Returns: The current value of @type, between [0,1]. In case of
- *   error -1 is returned.
+ * "autoplug-time" (guint64): time from the first buffer of the source
+ * until all streams were exposed, for the current URI.
+ *
+ * "autoplug-time-unhinted" (guint64): average autoplug time of URIs played
+ * without a format hint, #GST_CLOCK_TIME_NONE if there were none.
+ *
+ * "format-hint-hits", "format-hint-misses" (guint): number of autoplug
+ * steps resolved from the format hint, and number of steps that needed a
+ * lookup of all decodable elements.
+ *
+ * "plugins-registered" (guint), "plugin-registration-time" (guint64):
+ * number of registered static plugins and time spent registering them.
+ *
+ * "degradation-level" (#GstPlayerDegradationLevel): current degradation
+ * level.
+ *
+ * "degradation-time-none", "degradation-time-skip-loop-filter", ...
+ * (guint64): total time spent on each degradation level.
+ *
+ * "frames-checked", "frames-skipped" (guint64), "frames-skipped-percent"
+ * (gdouble), "frame-diff-time" (guint64): number of video frames checked
+ * for changes while #GstPlayer:skip-static-frames is enabled, how many of
+ * them were unchanged and not converted nor rendered, and the time spent
+ * checking.
+ *
+ * "playlist-transitions" (guint), "playlist-transition-gap" (guint): number
+ * of gapless switches between playlist items, and the gap of the last one
+ * in milliseconds. The gap is measured per stream at the sinks, from the
+ * running time where the last buffer of the previous item ended to the
+ * running time of the first buffer of the next one. The largest gap of all
+ * streams is reported.
+ *
+ * "restream-clients" (guint), "restream-bitrate" (guint64),
+ * "restream-bytes" (guint64): number of clients connected to the RTSP
+ * server enabled with gst_player_set_restream(), the bitrate in bits per
+ * second sent to all of them together over the last second, and the bytes
+ * sent since the shared media was created.
+ *
+ * "seek-latency" (guint64): time the last seek took until the pipeline
+ * prerolled again.
+ *
+ * "loop-iterations" (guint): number of times the loop range set with
+ * gst_player_set_loop_range() was started over since it was last set.
+ *
+ * "memory-released" (guint64), "memory-released-last" (guint64): bytes
+ * released by all gst_player_trim_memory() calls and by the last one. This
+ * only counts memory the player measured before freeing it: cover images,
+ * tags, the last rendered frame and, when the decoders are shut down, the
+ * data queued in queue2. Lowered queue limits only take effect while the
+ * queues drain and are not counted, neither are the buffer pools of the
+ * decoders.
+ *
+ * "rate-change-time" (guint64), "rate-change-flushing" (gboolean): time
+ * from the last gst_player_set_rate() until data with the new rate reached
+ * the sinks, and whether the pipeline had to be flushed for it. Without a
+ * flush playback continues at the old rate in the meantime, with a flush
+ * it stalls.
+ *
+ * "keyframe-index-entries" (guint), "keyframe-index-loaded" (gboolean):
+ * number of keyframes in the index built for FLV files without a seek
+ * table, and whether it was loaded from a previous playback of the same
+ * URI. Such an index makes seeks in these files a lookup instead of a scan
+ * of the file.
+ *
+ * "throughput" (gdouble): processing speed with gst_player_set_offline()
+ * as a multiple of real time.
+ *
+ * "audio-meter-time" (guint64): time spent measuring audio levels for the
+ * #GstPlayer::audio-level signal.
+ *
+ * "audio-conversion", "video-conversion" (gboolean),
+ * "audio-conversion-time", "video-conversion-time" (guint64): whether the
+ * decoded audio or video is converted before it reaches the sink, and the
+ * average conversion time per buffer. Decoders are asked for formats the
+ * sinks take directly, so this only happens if a decoder can't output
+ * any of them.
+ *
+ * "video-sink-bytes", "video-sink-byte-rate" (guint64): bytes of video
+ * passed to the video sink, in total and per second over the last second.
+ * Lower if the video is scaled down to the target size of the
+ * #GstPlayerVideoRenderer.
+ *
+ * "subtitle-cues-rasterized", "subtitle-cache-hits" (guint),
+ * "subtitle-blend-time" (guint64): with gst_player_set_subtitle_rasterizer()
+ * the number of cues rasterized, how often a rasterized cue was reused
+ * for a frame instead, and the time spent blending cues into frames for
+ * video sinks that can't composite them.
+ *
+ * "unselected-buffers-dropped", "track-switch-latency" (guint64): with
+ * gst_player_set_decode_selected_only() the number of buffers of
+ * unselected tracks that were not decoded, and the time from the last
+ * track switch until the new track was decoded again, #GST_CLOCK_TIME_NONE
+ * if there was none.
+ *
+ * "tag-updates-suppressed" (guint): the number of global tag lists that
+ * were ignored because they didn't change anything, or that were merged
+ * into a later one within the gst_player_set_tag_update_interval().
+ *
+ * Returns: (transfer full): a #GstStructure, free with gst_structure_free()
  */
-gdouble
-gst_player_get_color_balance (GstPlayer * self, GstPlayerColorBalanceType type)
-{
-  GstColorBalanceChannel *channel;
-  gint value;
+GstStructure *
+gst_player_get_stats (GstPlayer * self)
+{
+  GstStructure *stats;
+  GstClockTime registration_time, now, time;
+  guint n_registered, i, n_clients = 0;
+  guint64 restream_bytes = 0, restream_bitrate = 0;
+  guint n_keyframes = 0;
+  gboolean index_loaded = FALSE;
+  guint n_rasterized, n_cache_hits;
+  GstClockTime blend_time;
+  gchar *field;
 
-  g_return_val_if_fail (GST_IS_PLAYER (self), -1);
+  g_return_val_if_fail (GST_IS_PLAYER (self), NULL);
 
-  if (!GST_IS_COLOR_BALANCE (self->playbin))
-    return -1;
+  gst_player_plugin_loader_get_stats (&n_registered, NULL,
+      &registration_time);
 
-  channel = gst_player_color_balance_find_channel (self, type);
-  if (!channel)
-    return -1;
+  g_mutex_lock (&self->lock);
+  stats = gst_structure_new ("application/x-gst-player-stats",
+      "autoplug-time", G_TYPE_UINT64, self->autoplug_time,
+      "autoplug-time-unhinted", G_TYPE_UINT64, self->autoplug_time_unhinted,
+      "format-hint-hits", G_TYPE_UINT, self->format_hint_hits,
+      "format-hint-misses", G_TYPE_UINT, self->format_hint_misses,
+      "plugins-registered", G_TYPE_UINT, n_registered,
+      "plugin-registration-time", G_TYPE_UINT64, registration_time,
+      "degradation-level", GST_TYPE_PLAYER_DEGRADATION_LEVEL,
+      self->degradation_level,
+      "frames-checked", G_TYPE_UINT64, self->frames_checked,
+      "frames-skipped", G_TYPE_UINT64, self->frames_skipped,
+      "frames-skipped-percent", G_TYPE_DOUBLE,
+      self->frames_checked ? 100.0 * self->frames_skipped /
+      self->frames_checked : 0.0,
+      "frame-diff-time", G_TYPE_UINT64, self->frame_diff_time,
+      "playlist-transitions", G_TYPE_UINT, self->n_transitions,
+      "playlist-transition-gap", G_TYPE_UINT,
+      GST_CLOCK_TIME_IS_VALID (self->transition_gap) ?
+      (guint) (self->transition_gap / GST_MSECOND) : 0, NULL);
+
+  if (self->restream)
+    gst_player_restream_get_stats (self->restream, &n_clients,
+        &restream_bytes, &restream_bitrate);
+  gst_structure_set (stats, "restream-clients", G_TYPE_UINT, n_clients,
+      "restream-bitrate", G_TYPE_UINT64, restream_bitrate,
+      "restream-bytes", G_TYPE_UINT64, restream_bytes, NULL);
+
+  if (self->keyframe_index)
+    gst_player_keyframe_index_get_stats (self->keyframe_index, &n_keyframes,
+        &index_loaded);
+  gst_structure_set (stats, "seek-latency", G_TYPE_UINT64, self->seek_latency,
+      "rate-change-time", G_TYPE_UINT64, self->rate_change_time,
+      "rate-change-flushing", G_TYPE_BOOLEAN, self->rate_change_flushing,
+      "loop-iterations", G_TYPE_UINT, self->n_loops,
+      "memory-released", G_TYPE_UINT64, self->memory_released,
+      "memory-released-last", G_TYPE_UINT64, self->memory_released_last,
+      "keyframe-index-entries", G_TYPE_UINT, n_keyframes,
+      "keyframe-index-loaded", G_TYPE_BOOLEAN, index_loaded,
+      "throughput", G_TYPE_DOUBLE, self->throughput,
+      "audio-meter-time", G_TYPE_UINT64,
+      gst_player_audio_meter_get_time (self->audio_meter),
+      "audio-conversion", G_TYPE_BOOLEAN, conversion_active_locked (self, 0),
+      "audio-conversion-time", G_TYPE_UINT64, self->n_converted[0] ?
+      self->conversion_time[0] / self->n_converted[0] : 0,
+      "video-conversion", G_TYPE_BOOLEAN, conversion_active_locked (self, 1),
+      "video-conversion-time", G_TYPE_UINT64, self->n_converted[1] ?
+      self->conversion_time[1] / self->n_converted[1] : 0,
+      "video-sink-bytes", G_TYPE_UINT64, self->sink_bytes,
+      "video-sink-byte-rate", G_TYPE_UINT64, self->sink_byte_rate, NULL);
+
+  gst_player_subtitle_overlay_get_stats (self->subtitle_overlay,
+      &n_rasterized, &n_cache_hits, &blend_time);
+  gst_structure_set (stats,
+      "subtitle-cues-rasterized", G_TYPE_UINT, n_rasterized,
+      "subtitle-cache-hits", G_TYPE_UINT, n_cache_hits,
+      "subtitle-blend-time", G_TYPE_UINT64, blend_time, NULL);
+
+  gst_structure_set (stats,
+      "unselected-buffers-dropped", G_TYPE_UINT64, self->n_unselected_dropped,
+      "track-switch-latency", G_TYPE_UINT64, self->track_switch_latency,
+      NULL);
 
-  value = gst_color_balance_get_value (GST_COLOR_BALANCE (self->playbin),
-      channel);
+  gst_structure_set (stats, "tag-updates-suppressed", G_TYPE_UINT,
+      self->n_tags_suppressed, NULL);
 
-  return ((gdouble) value -
-      (gdouble) channel->min_value) / ((gdouble) channel->max_value -
-      (gdouble) channel->min_value);
+  now = gst_util_get_timestamp ();
+  for (i = 0; i < G_N_ELEMENTS (self->degradation_time); i++) {
+    time = self->degradation_time[i];
+    if (i == self->degradation_level
+        && GST_CLOCK_TIME_IS_VALID (self->degradation_since))
+      time += now - self->degradation_since;
+
+    field = g_strdup_printf ("degradation-time-%s",
+        gst_player_degradation_level_get_name (i));
+    gst_structure_set (stats, field, G_TYPE_UINT64, time, NULL);
+    g_free (field);
+  }
+  g_mutex_unlock (&self->lock);
+
+  return stats;
 }
 
 #define C_ENUM(v) ((gint) v)
@@ -3854,6 +9394,81 @@ gst_player_color_balance_type_get_name (GstPlayerColorBalanceType type)
   return cb_channel_map[type].name;
 }
 
+GType
+gst_player_degradation_level_get_type (void)
+{
+  static gsize id = 0;
+  static const GEnumValue values[] = {
+    {C_ENUM (GST_PLAYER_DEGRADATION_NONE), "GST_PLAYER_DEGRADATION_NONE",
+        "none"},
+    {C_ENUM (GST_PLAYER_DEGRADATION_SKIP_LOOP_FILTER),
+        "GST_PLAYER_DEGRADATION_SKIP_LOOP_FILTER", "skip-loop-filter"},
+    {C_ENUM (GST_PLAYER_DEGRADATION_DROP_NON_REFERENCE),
+        "GST_PLAYER_DEGRADATION_DROP_NON_REFERENCE", "drop-non-reference"},
+    {C_ENUM (GST_PLAYER_DEGRADATION_REDUCED_RESOLUTION),
+        "GST_PLAYER_DEGRADATION_REDUCED_RESOLUTION", "reduced-resolution"},
+    {C_ENUM (GST_PLAYER_DEGRADATION_KEYFRAMES_ONLY),
+        "GST_PLAYER_DEGRADATION_KEYFRAMES_ONLY", "keyframes-only"},
+    {0, NULL, NULL}
+  };
+
+  if (g_once_init_enter (&id)) {
+    GType tmp = g_enum_register_static ("GstPlayerDegradationLevel", values);
+    g_once_init_leave (&id, tmp);
+  }
+
+  return (GType) id;
+}
+
+/**
+ * gst_player_degradation_level_get_name:
+ * @level: a #GstPlayerDegradationLevel
+ *
+ * Gets a string representing the given degradation level.
+ *
+ * Returns: (transfer none): a string with the name of the level.
+ */
+const gchar *
+gst_player_degradation_level_get_name (GstPlayerDegradationLevel level)
+{
+  switch (level) {
+    case GST_PLAYER_DEGRADATION_NONE:
+      return "none";
+    case GST_PLAYER_DEGRADATION_SKIP_LOOP_FILTER:
+      return "skip-loop-filter";
+    case GST_PLAYER_DEGRADATION_DROP_NON_REFERENCE:
+      return "drop-non-reference";
+    case GST_PLAYER_DEGRADATION_REDUCED_RESOLUTION:
+      return "reduced-resolution";
+    case GST_PLAYER_DEGRADATION_KEYFRAMES_ONLY:
+      return "keyframes-only";
+  }
+
+  g_assert_not_reached ();
+  return NULL;
+}
+
+GType
+gst_player_memory_trim_level_get_type (void)
+{
+  static gsize id = 0;
+  static const GEnumValue values[] = {
+    {C_ENUM (GST_PLAYER_MEMORY_TRIM_LOW), "GST_PLAYER_MEMORY_TRIM_LOW", "low"},
+    {C_ENUM (GST_PLAYER_MEMORY_TRIM_MODERATE),
+        "GST_PLAYER_MEMORY_TRIM_MODERATE", "moderate"},
+    {C_ENUM (GST_PLAYER_MEMORY_TRIM_CRITICAL),
+        "GST_PLAYER_MEMORY_TRIM_CRITICAL", "critical"},
+    {0, NULL, NULL}
+  };
+
+  if (g_once_init_enter (&id)) {
+    GType tmp = g_enum_register_static ("GstPlayerMemoryTrimLevel", values);
+    g_once_init_leave (&id, tmp);
+  }
+
+  return (GType) id;
+}
+
 GType
 gst_player_state_get_type (void)
 {
@@ -4150,10 +9765,15 @@ gst_player_g_main_context_signal_dispatcher_new (GMainContext *
 G_DEFINE_INTERFACE (GstPlayerVideoRenderer, gst_player_video_renderer,
     G_TYPE_OBJECT);
 
+static guint video_renderer_target_size_changed_signal;
+
 static void
 gst_player_video_renderer_default_init (GstPlayerVideoRendererInterface * iface)
 {
-
+  video_renderer_target_size_changed_signal =
+      g_signal_new ("target-size-changed", G_TYPE_FROM_INTERFACE (iface),
+      G_SIGNAL_RUN_LAST | G_SIGNAL_NO_RECURSE | G_SIGNAL_NO_HOOKS, 0, NULL,
+      NULL, NULL, G_TYPE_NONE, 0);
 }
 
 static GstElement *
@@ -4169,12 +9789,43 @@ gst_player_video_renderer_create_video_sink (GstPlayerVideoRenderer * self,
   return iface->create_video_sink (self, player);
 }
 
+static gboolean
+gst_player_video_renderer_get_target_size (GstPlayerVideoRenderer * self,
+    gint * width, gint * height)
+{
+  GstPlayerVideoRendererInterface *iface;
+
+  iface = GST_PLAYER_VIDEO_RENDERER_GET_INTERFACE (self);
+  if (!iface->get_target_size)
+    return FALSE;
+
+  return iface->get_target_size (self, width, height);
+}
+
+/**
+ * gst_player_video_renderer_target_size_changed:
+ * @self: #GstPlayerVideoRenderer instance
+ *
+ * Tells the player that the size returned by the get_target_size function
+ * of the renderer changed, for example because the view was resized. The
+ * player then scales the video to the new size before it reaches the
+ * sink. Can be called from any thread.
+ */
+void
+gst_player_video_renderer_target_size_changed (GstPlayerVideoRenderer * self)
+{
+  g_return_if_fail (GST_IS_PLAYER_VIDEO_RENDERER (self));
+
+  g_signal_emit (self, video_renderer_target_size_changed_signal, 0);
+}
+
 struct _GstPlayerVideoOverlayVideoRenderer
 {
   GObject parent;
 
   GstVideoOverlay *video_overlay;
   gpointer window_handle;
+  gint target_width, target_height;     /* Atomic */
 };
 
 struct _GstPlayerVideoOverlayVideoRendererClass
@@ -4302,12 +9953,27 @@ static GstElement *gst_player_video_overlay_video_renderer_create_video_sink
   return NULL;
 }
 
+static gboolean
+    gst_player_video_overlay_video_renderer_get_target_size
+    (GstPlayerVideoRenderer * iface, gint * width, gint * height)
+{
+  GstPlayerVideoOverlayVideoRenderer *self =
+      GST_PLAYER_VIDEO_OVERLAY_VIDEO_RENDERER (iface);
+
+  *width = g_atomic_int_get (&self->target_width);
+  *height = g_atomic_int_get (&self->target_height);
+
+  return *width > 0 && *height > 0;
+}
+
 static void
     gst_player_video_overlay_video_renderer_interface_init
     (GstPlayerVideoRendererInterface * iface)
 {
   iface->create_video_sink =
       gst_player_video_overlay_video_renderer_create_video_sink;
+  iface->get_target_size =
+      gst_player_video_overlay_video_renderer_get_target_size;
 }
 
 /**
@@ -4358,3 +10024,28 @@ gpointer
 
   return window_handle;
 }
+
+/**
+ * gst_player_video_overlay_video_renderer_set_target_size:
+ * @self: #GstPlayerVideoRenderer instance
+ * @width: width of the area the video is shown in, in pixels
+ * @height: height of the area the video is shown in, in pixels
+ *
+ * Sets the size the video is shown at, 0 if unknown. Larger video is
+ * scaled down to it before it is passed to the window, instead of
+ * uploading every frame at full size. Call it again whenever the window
+ * is resized.
+ */
+void
+    gst_player_video_overlay_video_renderer_set_target_size
+    (GstPlayerVideoOverlayVideoRenderer * self, gint width, gint height)
+{
+  g_return_if_fail (GST_IS_PLAYER_VIDEO_OVERLAY_VIDEO_RENDERER (self));
+  g_return_if_fail (width >= 0 && height >= 0);
+
+  g_atomic_int_set (&self->target_width, width);
+  g_atomic_int_set (&self->target_height, height);
+
+  gst_player_video_renderer_target_size_changed (GST_PLAYER_VIDEO_RENDERER
+      (self));
+}
@@ -23,6 +23,8 @@
 
 #include <gst/gst.h>
 #include <gst/player/gstplayer-media-info.h>
+#include <gst/player/gstplayer-playlist.h>
+#include <gst/video/video-overlay-composition.h>
 
 G_BEGIN_DECLS
 
@@ -103,22 +105,131 @@ struct _GstPlayerVideoRendererInterface {
   GTypeInterface parent_iface;
 
   GstElement * (*create_video_sink) (GstPlayerVideoRenderer * self, GstPlayer * player);
+  gboolean     (*get_target_size)   (GstPlayerVideoRenderer * self, gint * width, gint * height);
 };
 
+void         gst_player_video_renderer_target_size_changed (GstPlayerVideoRenderer * self);
+
 GType        gst_player_get_type                      (void);
 
+/**
+ * GstPlayerCallbacks:
+ * @position_updated: the position changed, see #GstPlayer::position-updated.
+ * @state_changed: the state changed, see #GstPlayer::state-changed.
+ * @buffering: buffering progress in percent, see #GstPlayer::buffering.
+ * @error: a fatal error occurred, see #GstPlayer::error.
+ * @video_dimensions_changed: the video size changed, see
+ * #GstPlayer::video-dimensions-changed.
+ * @media_info_updated: the media info changed, see
+ * #GstPlayer::media-info-updated.
+ * @seek_done: a seek finished, see #GstPlayer::seek-done.
+ * @audio_level: audio levels, see #GstPlayer::audio-level. Called at the
+ * position update interval while playing. The structure contains the
+ * arrays "rms", "peak" and "decay" with one level per channel in dBFS,
+ * where "decay" is a peak that holds and then falls off slowly, and the
+ * EBU R128 short-term "loudness" in LUFS. Silence is reported as -120.
+ *
+ * Typed callbacks for the most frequent events, an alternative to
+ * connecting to the signals. Set with gst_player_set_callbacks().
+ */
+typedef struct
+{
+  void (*position_updated)         (GstPlayer * player,
+                                    GstClockTime position,
+                                    gpointer user_data);
+  void (*state_changed)            (GstPlayer * player,
+                                    GstPlayerState state,
+                                    gpointer user_data);
+  void (*buffering)                (GstPlayer * player,
+                                    gint percent,
+                                    gpointer user_data);
+  void (*error)                    (GstPlayer * player,
+                                    const GError * error,
+                                    gpointer user_data);
+  void (*video_dimensions_changed) (GstPlayer * player,
+                                    gint width,
+                                    gint height,
+                                    gpointer user_data);
+  void (*media_info_updated)       (GstPlayer * player,
+                                    GstPlayerMediaInfo * info,
+                                    gpointer user_data);
+  void (*seek_done)                (GstPlayer * player,
+                                    GstClockTime position,
+                                    gpointer user_data);
+  void (*audio_level)              (GstPlayer * player,
+                                    const GstStructure * levels,
+                                    gpointer user_data);
+
+  /*< private >*/
+  gpointer _gst_reserved[GST_PADDING - 1];
+} GstPlayerCallbacks;
+
+/**
+ * GstPlayerScrubFunc:
+ * @player: #GstPlayer instance
+ * @sample: the preview frame, RGBA of the size passed to
+ * gst_player_scrub_begin()
+ * @position: position of the frame
+ * @user_data: user data passed to gst_player_scrub_begin()
+ *
+ * Receives preview frames while scrubbing.
+ */
+typedef void (*GstPlayerScrubFunc)                    (GstPlayer    * player,
+                                                       GstSample    * sample,
+                                                       GstClockTime   position,
+                                                       gpointer       user_data);
+
+/**
+ * GstPlayerSubtitleRasterizeFunc:
+ * @player: #GstPlayer instance
+ * @text: the text of the cue
+ * @markup: whether @text is Pango markup
+ * @width: width of the video frames
+ * @height: height of the video frames
+ * @user_data: user data passed to gst_player_set_subtitle_rasterizer()
+ *
+ * Renders a subtitle cue for video frames of @width x @height. Called from
+ * a streaming thread.
+ *
+ * Returns: (transfer full) (nullable): the rendered cue, positioned on the
+ * frame, or %NULL if there is nothing to show
+ */
+typedef GstVideoOverlayRectangle * (*GstPlayerSubtitleRasterizeFunc)
+                                                      (GstPlayer    * player,
+                                                       const gchar  * text,
+                                                       gboolean       markup,
+                                                       gint           width,
+                                                       gint           height,
+                                                       gpointer       user_data);
+
 GType        gst_player_video_renderer_get_type       (void);
 GType        gst_player_signal_dispatcher_get_type    (void);
 
 GstPlayer *  gst_player_new                           (void);
 GstPlayer *  gst_player_new_full                      (GstPlayerVideoRenderer * video_renderer, GstPlayerSignalDispatcher * signal_dispatcher);
 
+void         gst_player_set_callbacks                 (GstPlayer    * player,
+                                                       const GstPlayerCallbacks * callbacks,
+                                                       gpointer       user_data,
+                                                       GDestroyNotify notify);
+
 void         gst_player_play                          (GstPlayer    * player);
 void         gst_player_pause                         (GstPlayer    * player);
 void         gst_player_stop                          (GstPlayer    * player);
 
 void         gst_player_seek                          (GstPlayer    * player,
                                                        GstClockTime   position);
+void         gst_player_scrub_begin                   (GstPlayer    * player,
+                                                       gint           width,
+                                                       gint           height,
+                                                       GstPlayerScrubFunc func,
+                                                       gpointer       user_data,
+                                                       GDestroyNotify notify);
+void         gst_player_scrub                         (GstPlayer    * player,
+                                                       GstClockTime   position);
+void         gst_player_scrub_end                     (GstPlayer    * player,
+                                                       gboolean       seek);
+
 void         gst_player_set_rate                      (GstPlayer    * player,
                                                        gdouble        rate);
 gdouble      gst_player_get_rate                      (GstPlayer    * player);
@@ -127,6 +238,10 @@ void         gst_player_set_position_update_interval  (GstPlayer    * player,
                                                        guint          interval);
 guint        gst_player_get_position_update_interval  (GstPlayer    * player);
 
+void         gst_player_set_tag_update_interval       (GstPlayer    * player,
+                                                       guint          interval);
+guint        gst_player_get_tag_update_interval       (GstPlayer    * player);
+
 gchar *      gst_player_get_uri                       (GstPlayer    * player);
 void         gst_player_set_uri                       (GstPlayer    * player,
                                                        const gchar  * uri);
@@ -177,6 +292,11 @@ gboolean     gst_player_set_subtitle_uri              (GstPlayer    * player,
                                                        const gchar *uri);
 gchar *      gst_player_get_subtitle_uri              (GstPlayer    * player);
 
+void         gst_player_set_subtitle_rasterizer       (GstPlayer    * player,
+                                                       GstPlayerSubtitleRasterizeFunc func,
+                                                       gpointer       user_data,
+                                                       GDestroyNotify notify);
+
 gboolean     gst_player_set_visualization             (GstPlayer    * player,
                                                        const gchar *name);
 
@@ -235,6 +355,122 @@ void     gst_player_set_color_balance (GstPlayer * player,
 gdouble  gst_player_get_color_balance (GstPlayer * player,
                                        GstPlayerColorBalanceType type);
 
+#define GST_TYPE_PLAYER_DEGRADATION_LEVEL   (gst_player_degradation_level_get_type ())
+GType gst_player_degradation_level_get_type (void);
+
+/**
+ * GstPlayerDegradationLevel:
+ * @GST_PLAYER_DEGRADATION_NONE: full quality decoding.
+ * @GST_PLAYER_DEGRADATION_SKIP_LOOP_FILTER: skip the in-loop deblocking
+ * filter.
+ * @GST_PLAYER_DEGRADATION_DROP_NON_REFERENCE: additionally drop
+ * non-reference frames in the decoder.
+ * @GST_PLAYER_DEGRADATION_REDUCED_RESOLUTION: additionally pass the
+ * decoded video on at half the resolution, which makes conversion and
+ * rendering cheaper but not decoding. Needs a #GstPlayerVideoRenderer
+ * with a target size.
+ * @GST_PLAYER_DEGRADATION_KEYFRAMES_ONLY: only decode keyframes.
+ *
+ * Steps the player takes, in this order, when video decoding can't keep
+ * up. Steps the current decoder or renderer does not support are skipped.
+ */
+typedef enum
+{
+  GST_PLAYER_DEGRADATION_NONE,
+  GST_PLAYER_DEGRADATION_SKIP_LOOP_FILTER,
+  GST_PLAYER_DEGRADATION_DROP_NON_REFERENCE,
+  GST_PLAYER_DEGRADATION_REDUCED_RESOLUTION,
+  GST_PLAYER_DEGRADATION_KEYFRAMES_ONLY
+} GstPlayerDegradationLevel;
+
+const gchar *gst_player_degradation_level_get_name (GstPlayerDegradationLevel level);
+
+void         gst_player_set_degradation_enabled       (GstPlayer    * player,
+                                                       gboolean       enabled);
+gboolean     gst_player_get_degradation_enabled       (GstPlayer    * player);
+GstPlayerDegradationLevel gst_player_get_degradation_level
+                                                      (GstPlayer    * player);
+
+void         gst_player_set_skip_static_frames        (GstPlayer    * player,
+                                                       gboolean       enabled);
+gboolean     gst_player_get_skip_static_frames        (GstPlayer    * player);
+
+void         gst_player_set_offline                   (GstPlayer    * player,
+                                                       gboolean       offline);
+gboolean     gst_player_get_offline                   (GstPlayer    * player);
+gdouble      gst_player_get_throughput                (GstPlayer    * player);
+
+void         gst_player_set_decode_selected_only      (GstPlayer    * player,
+                                                       gboolean       enabled);
+gboolean     gst_player_get_decode_selected_only      (GstPlayer    * player);
+
+void         gst_player_set_element_stats_enabled     (GstPlayer    * player,
+                                                       gboolean       enabled);
+gboolean     gst_player_get_element_stats_enabled     (GstPlayer    * player);
+GstStructure * gst_player_get_element_stats           (GstPlayer    * player);
+
+gchar *      gst_player_dump_flight_recorder          (GstPlayer    * player);
+
+gchar *      gst_player_get_error_events              (GstPlayer    * player);
+
+void         gst_player_set_format_hint               (GstPlayer    * player,
+                                                       const GstCaps * hint);
+GstCaps *    gst_player_get_format_hint               (GstPlayer    * player);
+
+void         gst_player_set_decoder_rank              (GstPlayer    * player,
+                                                       const gchar  * name,
+                                                       guint          rank);
+void         gst_player_set_decoder_allowlist         (GstPlayer    * player,
+                                                       const gchar * const * names);
+void         gst_player_set_decoder_denylist          (GstPlayer    * player,
+                                                       const gchar * const * names);
+void         gst_player_set_decoder_threads           (GstPlayer    * player,
+                                                       const gchar  * media_type,
+                                                       guint          n_threads);
+void         gst_player_clear_decoder_policy          (GstPlayer    * player);
+
+void         gst_player_set_playlist                  (GstPlayer    * player,
+                                                       GstPlayerPlaylist * playlist);
+GstPlayerPlaylist * gst_player_get_playlist           (GstPlayer    * player);
+void         gst_player_next                          (GstPlayer    * player);
+void         gst_player_previous                      (GstPlayer    * player);
+
+void         gst_player_set_loop_range                (GstPlayer    * player,
+                                                       GstClockTime   start,
+                                                       GstClockTime   stop);
+gboolean     gst_player_get_loop_range                (GstPlayer    * player,
+                                                       GstClockTime * start,
+                                                       GstClockTime * stop);
+
+#define GST_TYPE_PLAYER_MEMORY_TRIM_LEVEL   (gst_player_memory_trim_level_get_type ())
+GType gst_player_memory_trim_level_get_type (void);
+
+/**
+ * GstPlayerMemoryTrimLevel:
+ * @GST_PLAYER_MEMORY_TRIM_LOW: lower the limits of the buffering queues.
+ * @GST_PLAYER_MEMORY_TRIM_MODERATE: additionally limit the queues further
+ * and drop the cover image, the cached tags and the frame the sinks keep
+ * for snapshots.
+ * @GST_PLAYER_MEMORY_TRIM_CRITICAL: additionally shut down the decoders
+ * and their buffer pools if the player is paused. They are created again
+ * on the next play or pause.
+ */
+typedef enum
+{
+  GST_PLAYER_MEMORY_TRIM_LOW,
+  GST_PLAYER_MEMORY_TRIM_MODERATE,
+  GST_PLAYER_MEMORY_TRIM_CRITICAL
+} GstPlayerMemoryTrimLevel;
+
+void         gst_player_trim_memory                   (GstPlayer    * player,
+                                                       GstPlayerMemoryTrimLevel level);
+
+void         gst_player_set_restream                  (GstPlayer    * player,
+                                                       guint          port,
+                                                       const gchar  * path);
+
+GstStructure * gst_player_get_stats                   (GstPlayer    * player);
+
 typedef struct _GstPlayerGMainContextSignalDispatcher
     GstPlayerGMainContextSignalDispatcher;
 typedef struct _GstPlayerGMainContextSignalDispatcherClass
@@ -269,6 +505,7 @@ GType gst_player_video_overlay_video_renderer_get_type (void);
 GstPlayerVideoRenderer * gst_player_video_overlay_video_renderer_new (gpointer window_handle);
 void gst_player_video_overlay_video_renderer_set_window_handle (GstPlayerVideoOverlayVideoRenderer * self, gpointer window_handle);
 gpointer gst_player_video_overlay_video_renderer_get_window_handle (GstPlayerVideoOverlayVideoRenderer * self);
+void gst_player_video_overlay_video_renderer_set_target_size (GstPlayerVideoOverlayVideoRenderer * self, gint width, gint height);
 
 G_END_DECLS
 
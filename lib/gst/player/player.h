@@ -23,5 +23,11 @@
 
 #include <gst/player/gstplayer.h>
 #include <gst/player/gstplayer-media-info.h>
+#include <gst/player/gstplayer-playlist.h>
+#include <gst/player/gstplayer-mosaic.h>
+#include <gst/player/gstplayer-zapper.h>
+#include <gst/player/gstplayer-clip-export.h>
+#include <gst/player/gstplayer-plugin-loader.h>
+#include <gst/player/gstplayer-decoder-probe.h>
 
 #endif /* __PLAYER_H__ */